@@ -0,0 +1,130 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "AssetLoadTest.h"
+#include "FBSceneObjectFactory/AssetLoadGraph.h"
+#include "FBSceneObjectFactory/SceneObjectFactory.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/RendererOptions.h"
+#include "FBRenderer/CompiledMaterial.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBFileSystem/DirectoryIterator.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+class AssetLoadTest::Impl {
+public:
+	// .dae paths of the compiled meshes.
+	StringVector mMeshes;
+	StringVector mMaterials;
+
+	Impl() {
+		CollectFiles("data");
+		if (mMeshes.empty()) {
+			Logger::Log(FB_ERROR_LOG_ARG, "No compiled mesh files.");
+			return;
+		}
+
+		// The first run compiles the material cache and warms up the file cache.
+		LoadSequentially();
+		auto sequentialTime = LoadSequentially();
+
+		auto graph = AssetLoadGraph::Create();
+		for (auto& mesh : mMeshes) {
+			graph->AddMesh(mesh.c_str());
+		}
+		for (auto& material : mMaterials) {
+			graph->AddMaterial(material.c_str());
+		}
+		graph->Start();
+		graph->Finish();
+
+		unsigned numCreated = 0;
+		for (auto& mesh : mMeshes) {
+			if (graph->GetMeshObject(mesh.c_str()))
+				++numCreated;
+		}
+		auto stats = graph->GetStats();
+		bool passed = graph->IsFinished() && numCreated == mMeshes.size() && stats.mNumFailed == 0;
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"Asset loading %s: %u meshes, %u materials, %u textures, %u shaders(%u failed). "
+			"Single thread without creating resources %lld us. Graph %lld us(worker %lld us, main thread %lld us)",
+			passed ? "passed" : "failed", stats.mNumMeshes, stats.mNumMaterials, stats.mNumTextures,
+			stats.mNumShaders, stats.mNumFailed, sequentialTime, stats.mElapsedTime,
+			stats.mWorkerTime, stats.mMainThreadTime).c_str());
+	}
+
+	void CollectFiles(const char* directory) {
+		auto it = FileSystem::GetDirectoryIterator(directory, true);
+		if (!it)
+			return;
+		while (it->HasNext()) {
+			bool isDirectory = false;
+			const char* filepath = it->GetNextFilePath(&isDirectory);
+			if (isDirectory)
+				continue;
+			if (FileSystem::HasExtension(filepath, ".fbmesh"))
+				mMeshes.push_back(FileSystem::ReplaceExtension(filepath, "dae"));
+			else if (FileSystem::HasExtension(filepath, ".material"))
+				mMaterials.push_back(filepath);
+		}
+	}
+
+	/// Reads and parses the same data as the graph on this thread.
+	INT64 LoadSequentially() {
+		auto& factory = SceneObjectFactory::GetInstance();
+		bool useCache = Renderer::GetInstance().GetRendererOptions()->r_MaterialCache != 0;
+		StringVector materials(mMaterials);
+		ProfilerSimple p("LoadSequentially");
+		for (auto& mesh : mMeshes) {
+			factory.LoadCompiledMeshData(mesh.c_str(), MeshImportDesc(), &materials);
+		}
+		// Materials shared by the meshes are loaded once as the graph does.
+		for (auto& material : materials) {
+			ToLowerCase(material);
+		}
+		std::sort(materials.begin(), materials.end());
+		materials.erase(std::unique(materials.begin(), materials.end()), materials.end());
+		for (auto& material : materials) {
+			CompiledMaterial compiled;
+			CompiledMaterial::Load(material.c_str(), useCache, compiled);
+		}
+		return p.GetDTMicro();
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(AssetLoadTest);
+
+AssetLoadTest::AssetLoadTest()
+	: mImpl(new Impl)
+{
+}
+
+AssetLoadTest::~AssetLoadTest() {
+}
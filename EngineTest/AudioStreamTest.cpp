@@ -0,0 +1,104 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "AudioStreamTest.h"
+#include "FBAudioPlayer/AudioManager.h"
+using namespace fb;
+
+static const unsigned NumStreams = 4;
+static const char* StreamAudioPath = "data/audio/big_laser_fire_loop.ogg";
+
+class AudioStreamTest::Impl{
+public:
+	std::vector<AudioId> mPlaying;
+	float mReportTime;
+	size_t mMaxMemoryUsage;
+
+	Impl()
+		: mReportTime(0)
+		, mMaxMemoryUsage(0)
+	{
+		AudioManager::GetInstance().GetCommandStats(true);
+		Restart();
+	}
+
+	~Impl(){
+		auto& am = AudioManager::GetInstance();
+		for (auto id : mPlaying){
+			am.StopAudio(id);
+		}
+	}
+
+	void Restart(){
+		auto& am = AudioManager::GetInstance();
+		for (auto id : mPlaying){
+			am.StopAudio(id);
+		}
+		mPlaying.clear();
+		for (unsigned i = 0; i < NumStreams; ++i){
+			auto id = am.PlayAudio(StreamAudioPath, AudioSourceType::Music);
+			if (id != INVALID_AUDIO_ID){
+				am.SetLoop(id, true);
+				mPlaying.push_back(id);
+			}
+		}
+	}
+
+	void Update(float dt){
+		auto& am = AudioManager::GetInstance();
+		auto streamStats = am.GetStreamStats();
+		mMaxMemoryUsage = std::max(mMaxMemoryUsage, streamStats.mMemoryUsage);
+		mReportTime += dt;
+		if (mReportTime >= 1.f){
+			auto stats = am.GetCommandStats(true);
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) AudioStreamTest: %u streams, max memory %u KB. "
+				"started %u, start latency avg %.3fms, max %.3fms",
+				(unsigned)streamStats.mNumStreams, (unsigned)(mMaxMemoryUsage / 1024),
+				stats.mNumStarted, stats.mAverageStartLatencyMs, stats.mMaxStartLatencyMs).c_str());
+			mReportTime = 0;
+			mMaxMemoryUsage = 0;
+			Restart();
+		}
+	}
+};
+
+FB_IMPLEMENT_STATIC_CREATE(AudioStreamTest);
+AudioStreamTest::AudioStreamTest()
+	: mImpl(new Impl)
+{
+
+}
+
+AudioStreamTest::~AudioStreamTest(){
+
+}
+
+void AudioStreamTest::Update(float dt){
+	mImpl->Update(dt);
+}
@@ -0,0 +1,44 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb{
+	FB_DECLARE_SMART_PTR(AudioStreamTest);
+	/// Restarts a few streamed music tracks every second and logs the start
+	/// latency and the streaming memory. Runs on openal-soft's null backend
+	/// with ALSOFT_DRIVERS=null.
+	class AudioStreamTest{
+		FB_DECLARE_PIMPL_NON_COPYABLE(AudioStreamTest);
+		AudioStreamTest();
+		~AudioStreamTest();
+
+	public:
+		static AudioStreamTestPtr Create();
+		void Update(float dt);
+	};
+}
@@ -0,0 +1,117 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "stdafx.h"
+#include "AudioStressTest.h"
+#include "FBAudioPlayer/AudioManager.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+static const unsigned RequestsPerSec = 10000;
+static const char* StressAudioPath = "data/audio/button_mouse_click.wav";
+
+class AudioStressTest::Impl{
+public:
+	std::vector<AudioId> mPlaying;
+	float mRequestAccumulator;
+	float mReportTime;
+	unsigned mNumPlayRequests;
+	unsigned mNumStopRequests;
+	INT64 mIssueMicro;
+
+	Impl()
+		: mRequestAccumulator(0)
+		, mReportTime(0)
+		, mNumPlayRequests(0)
+		, mNumStopRequests(0)
+		, mIssueMicro(0)
+	{
+		// load the buffer before measuring.
+		AudioManager::GetInstance().GetAudioLength(StressAudioPath);
+		AudioManager::GetInstance().GetCommandStats(true);
+	}
+
+	~Impl(){
+		auto& am = AudioManager::GetInstance();
+		for (auto id : mPlaying){
+			am.StopAudio(id);
+		}
+	}
+
+	void Update(float dt){
+		auto& am = AudioManager::GetInstance();
+		// stop what the previous frame started, then start new ones.
+		// Half of the requests are plays and half are stops.
+		ProfilerSimple profiler("AudioStressTest");
+		for (auto id : mPlaying){
+			am.StopAudio(id);
+			++mNumStopRequests;
+		}
+		mPlaying.clear();
+
+		mRequestAccumulator += dt * RequestsPerSec * .5f;
+		unsigned numPlay = (unsigned)mRequestAccumulator;
+		mRequestAccumulator -= numPlay;
+		for (unsigned i = 0; i < numPlay; ++i){
+			auto id = am.PlayAudio(StressAudioPath, Vec3Tuple(
+				(float)(i % 32), (float)(i / 32 % 32), 0.f));
+			if (id != INVALID_AUDIO_ID)
+				mPlaying.push_back(id);
+			++mNumPlayRequests;
+		}
+		mIssueMicro += (INT64)profiler.GetDTMicro();
+
+		mReportTime += dt;
+		if (mReportTime >= 1.f){
+			auto stats = am.GetCommandStats(true);
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) AudioStressTest: %u play / %u stop requests in %.2fs, issue cost %.3fms. "
+				"started %u, dropped %u, start latency avg %.3fms, max %.3fms",
+				mNumPlayRequests, mNumStopRequests, mReportTime, mIssueMicro / 1000.0,
+				stats.mNumStarted, stats.mNumDropped,
+				stats.mAverageStartLatencyMs, stats.mMaxStartLatencyMs).c_str());
+			mReportTime = 0;
+			mNumPlayRequests = 0;
+			mNumStopRequests = 0;
+			mIssueMicro = 0;
+		}
+	}
+};
+
+FB_IMPLEMENT_STATIC_CREATE(AudioStressTest);
+AudioStressTest::AudioStressTest()
+	: mImpl(new Impl)
+{
+
+}
+
+AudioStressTest::~AudioStressTest(){
+
+}
+
+void AudioStressTest::Update(float dt){
+	mImpl->Update(dt);
+}
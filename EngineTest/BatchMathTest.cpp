@@ -0,0 +1,245 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "BatchMathTest.h"
+#include "FBMathLib/BatchMath.h"
+using namespace fb;
+
+static const unsigned Counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 13, 17, 31 };
+static const unsigned NumPlanes = 6;
+static const Real Tolerance = 1e-4f;
+
+// Objects start one float after a 32 byte boundary so neither the SSE nor
+// the AVX2 loads can depend on the alignment.
+template <class T>
+class UnalignedArray {
+	std::vector<char> mBuffer;
+	T* mData;
+
+	UnalignedArray(const UnalignedArray&) = delete;
+	UnalignedArray& operator=(const UnalignedArray&) = delete;
+
+public:
+	explicit UnalignedArray(unsigned num)
+		: mBuffer(num * sizeof(T) + 64)
+	{
+		auto address = ((uintptr_t)&mBuffer[0] + 31) & ~(uintptr_t)31;
+		mData = (T*)(address + sizeof(float));
+		for (unsigned i = 0; i < num; ++i)
+			new (mData + i) T;
+	}
+
+	T* Get() { return mData; }
+	T& operator[](unsigned i) { return mData[i]; }
+};
+
+static bool IsNear(Real a, Real b) {
+	return std::abs(a - b) <= Tolerance * std::max((Real)1.f, std::abs(a));
+}
+
+static bool IsNear(const Vec3& a, const Vec3& b) {
+	return IsNear(a.x, b.x) && IsNear(a.y, b.y) && IsNear(a.z, b.z);
+}
+
+class BatchMathTest::Impl {
+public:
+	unsigned mNumFailed;
+
+	Impl()
+		: mNumFailed(0)
+	{
+		auto original = BatchMath::GetBackend();
+		std::srand(0x5eed);
+		for (int b = BatchMath::Scalar + 1; b < BatchMath::NumBackends; ++b) {
+			auto backend = (BatchMath::Backend)b;
+			if (!BatchMath::IsSupported(backend)) {
+				Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("BatchMathTest: %s is not supported. Skipped.",
+					BatchMath::GetBackendName(backend)).c_str());
+				continue;
+			}
+			for (auto num : Counts) {
+				TestMultiplyMatrices(backend, num);
+				TestTransformPoints(backend, num);
+				TestTransformAABBs(backend, num);
+				TestSlerpQuats(backend, num);
+				TestCullSpheres(backend, num);
+			}
+		}
+		BatchMath::SetBackend(original);
+		if (mNumFailed == 0)
+			Logger::Log(FB_DEFAULT_LOG_ARG, "BatchMathTest passed.");
+		else
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("BatchMathTest: %u checks failed.", mNumFailed).c_str());
+	}
+
+	void Check(bool condition, const char* what, BatchMath::Backend backend, unsigned num, unsigned index) {
+		if (!condition) {
+			++mNumFailed;
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("BatchMathTest: %s(%s, num = %u) differs at %u.",
+				what, BatchMath::GetBackendName(backend), num, index).c_str());
+		}
+	}
+
+	Mat44 RandomMatrix() {
+		auto m = Mat44::FromAxisAngle(RandomDirection(), Random(-PI, PI));
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c)
+				m.m[r][c] *= Random(0.5f, 2.f);
+			m.m[r][3] = Random(-100.f, 100.f);
+		}
+		return m;
+	}
+
+	void TestMultiplyMatrices(BatchMath::Backend backend, unsigned num) {
+		UnalignedArray<Mat44> a(num), b(num), expected(num), actual(num);
+		for (unsigned i = 0; i < num; ++i) {
+			a[i] = RandomMatrix();
+			b[i] = RandomMatrix();
+		}
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::MultiplyMatrices(a.Get(), b.Get(), expected.Get(), num);
+		BatchMath::SetBackend(backend);
+		BatchMath::MultiplyMatrices(a.Get(), b.Get(), actual.Get(), num);
+		for (unsigned i = 0; i < num; ++i) {
+			bool same = true;
+			for (int r = 0; r < 4; ++r) {
+				for (int c = 0; c < 4; ++c)
+					same = same && IsNear(expected[i].m[r][c], actual[i].m[r][c]);
+			}
+			Check(same, "MultiplyMatrices", backend, num, i);
+		}
+	}
+
+	void TestTransformPoints(BatchMath::Backend backend, unsigned num) {
+		auto m = RandomMatrix();
+		UnalignedArray<Vec3> points(num), expected(num), actual(num), inPlace(num);
+		for (unsigned i = 0; i < num; ++i) {
+			points[i] = Random(Vec3(-100.f), Vec3(100.f));
+			inPlace[i] = points[i];
+		}
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::TransformPoints(m, points.Get(), expected.Get(), num);
+		BatchMath::SetBackend(backend);
+		BatchMath::TransformPoints(m, points.Get(), actual.Get(), num);
+		BatchMath::TransformPoints(m, inPlace.Get(), inPlace.Get(), num);
+		for (unsigned i = 0; i < num; ++i) {
+			Check(IsNear(expected[i], actual[i]), "TransformPoints", backend, num, i);
+			Check(IsNear(expected[i], inPlace[i]), "TransformPoints in place", backend, num, i);
+		}
+
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::TransformDirections(m, points.Get(), expected.Get(), num);
+		BatchMath::SetBackend(backend);
+		BatchMath::TransformDirections(m, points.Get(), actual.Get(), num);
+		for (unsigned i = 0; i < num; ++i)
+			Check(IsNear(expected[i], actual[i]), "TransformDirections", backend, num, i);
+	}
+
+	void TestTransformAABBs(BatchMath::Backend backend, unsigned num) {
+		auto m = RandomMatrix();
+		UnalignedArray<AABB> aabbs(num), expected(num), actual(num);
+		for (unsigned i = 0; i < num; ++i) {
+			// Every fifth box stays invalid.
+			if (i % 5 == 4)
+				continue;
+			auto center = Random(Vec3(-100.f), Vec3(100.f));
+			auto extent = Random(Vec3(0.f), Vec3(10.f));
+			aabbs[i] = AABB(center - extent, center + extent);
+		}
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::TransformAABBs(m, aabbs.Get(), expected.Get(), num);
+		BatchMath::SetBackend(backend);
+		BatchMath::TransformAABBs(m, aabbs.Get(), actual.Get(), num);
+		for (unsigned i = 0; i < num; ++i) {
+			bool same = expected[i].IsValid() == actual[i].IsValid();
+			if (same && expected[i].IsValid()) {
+				same = IsNear(expected[i].GetMin(), actual[i].GetMin()) &&
+					IsNear(expected[i].GetMax(), actual[i].GetMax());
+			}
+			Check(same, "TransformAABBs", backend, num, i);
+		}
+	}
+
+	void TestSlerpQuats(BatchMath::Backend backend, unsigned num) {
+		UnalignedArray<Quat> a(num), b(num), expected(num), actual(num);
+		UnalignedArray<Real> t(num);
+		for (unsigned i = 0; i < num; ++i) {
+			a[i] = Quat(Random(-PI, PI), RandomDirection());
+			b[i] = Quat(Random(-PI, PI), RandomDirection());
+			t[i] = Random(0.f, 1.f);
+		}
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::SlerpQuats(a.Get(), b.Get(), t.Get(), expected.Get(), num);
+		BatchMath::SetBackend(backend);
+		BatchMath::SlerpQuats(a.Get(), b.Get(), t.Get(), actual.Get(), num);
+		for (unsigned i = 0; i < num; ++i) {
+			auto& e = expected[i];
+			auto& r = actual[i];
+			Check(IsNear(e.w, r.w) && IsNear(e.x, r.x) && IsNear(e.y, r.y) && IsNear(e.z, r.z),
+				"SlerpQuats", backend, num, i);
+		}
+	}
+
+	void TestCullSpheres(BatchMath::Backend backend, unsigned num) {
+		Plane planes[NumPlanes];
+		for (auto& plane : planes)
+			plane = Plane(RandomDirection(), Random(-50.f, 50.f));
+		UnalignedArray<Real> x(num), y(num), z(num), radius(num);
+		UnalignedArray<unsigned char> expected(num), actual(num);
+		for (unsigned i = 0; i < num; ++i) {
+			x[i] = Random(-100.f, 100.f);
+			y[i] = Random(-100.f, 100.f);
+			z[i] = Random(-100.f, 100.f);
+			radius[i] = Random(0.f, 30.f);
+		}
+		BatchMath::SetBackend(BatchMath::Scalar);
+		BatchMath::CullSpheres(planes, NumPlanes, x.Get(), y.Get(), z.Get(), radius.Get(), num, expected.Get());
+		BatchMath::SetBackend(backend);
+		BatchMath::CullSpheres(planes, NumPlanes, x.Get(), y.Get(), z.Get(), radius.Get(), num, actual.Get());
+		for (unsigned i = 0; i < num; ++i) {
+			// FMA rounds differently; spheres touching a plane may go either way.
+			bool touching = false;
+			for (auto& plane : planes) {
+				auto dist = plane.mNormal.Dot(Vec3(x[i], y[i], z[i])) - plane.mConstant;
+				touching = touching || std::abs(dist + radius[i]) < 1e-3f;
+			}
+			Check(touching || expected[i] == actual[i], "CullSpheres", backend, num, i);
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(BatchMathTest);
+
+BatchMathTest::BatchMathTest()
+	: mImpl(new Impl)
+{
+}
+
+BatchMathTest::~BatchMathTest() {
+}
@@ -0,0 +1,436 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "DownloadTest.h"
+#include "FBNetwork/Network.h"
+#include "FBNetwork/DownloadManager.h"
+#include "FBThread/threads.h"
+#include "FBFileSystem/FileSystem.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using namespace fb;
+
+static const unsigned NumConcurrentDownloads = 32;
+static const unsigned SmallFileSize = 64 * 1024;
+static const unsigned LargeFileSize = 300 * 1024;
+
+static BYTE GetTestByte(size_t i){
+	return (BYTE)(i * 7 + (i >> 8));
+}
+
+static bool IsTestData(const BYTE* data, size_t size, size_t offset){
+	for (size_t i = 0; i < size; ++i){
+		if (data[i] != GetTestByte(offset + i))
+			return false;
+	}
+	return true;
+}
+
+namespace fb{
+	/// Minimal keep-alive HTTP/1.1 server for GET requests.
+	/// /data/<size> returns test bytes and supports "Range: bytes=<from>-".
+	/// /drop/<size> sends half of the body and closes the connection.
+	class LoopbackHttpServer : public Thread{
+		struct Client{
+			SOCKET mSocket;
+			std::string mReceived;
+		};
+		SOCKET mListen;
+		std::vector<Client> mClients;
+		unsigned short mPort;
+
+	public:
+		std::atomic<unsigned> mNumAccepted;
+
+		LoopbackHttpServer()
+			: mListen(INVALID_SOCKET)
+			, mPort(0)
+			, mNumAccepted(0)
+		{
+		}
+
+		~LoopbackHttpServer(){
+			Stop();
+		}
+
+		bool Start(){
+			WSADATA wsaData;
+			if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0){
+				Logger::Log(FB_ERROR_LOG_ARG, "WSAStartup failed.");
+				return false;
+			}
+			mListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = 0;
+			int addrLen = sizeof(addr);
+			if (mListen == INVALID_SOCKET ||
+				bind(mListen, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+				listen(mListen, SOMAXCONN) != 0 ||
+				getsockname(mListen, (sockaddr*)&addr, &addrLen) != 0)
+			{
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot open the loopback server(%d).", WSAGetLastError()).c_str());
+				return false;
+			}
+			mPort = ntohs(addr.sin_port);
+			CreateThread(1024, "LoopbackHttpServer");
+			return true;
+		}
+
+		void Stop(){
+			if (IsJoinable()){
+				ForceExit(true);
+				Join();
+			}
+			for (auto& client : mClients){
+				closesocket(client.mSocket);
+			}
+			mClients.clear();
+			if (mListen != INVALID_SOCKET){
+				closesocket(mListen);
+				mListen = INVALID_SOCKET;
+				WSACleanup();
+			}
+		}
+
+		std::string GetUrl(const char* path) const{
+			return FormatString("http://127.0.0.1:%u%s", (unsigned)mPort, path);
+		}
+
+		bool Run(){
+			fd_set readSet;
+			FD_ZERO(&readSet);
+			FD_SET(mListen, &readSet);
+			for (auto& client : mClients){
+				FD_SET(client.mSocket, &readSet);
+			}
+			timeval timeout = { 0, 50 * 1000 };
+			if (select(0, &readSet, 0, 0, &timeout) <= 0)
+				return true;
+			if (FD_ISSET(mListen, &readSet)){
+				auto s = accept(mListen, 0, 0);
+				if (s != INVALID_SOCKET){
+					Client client = { s };
+					mClients.push_back(client);
+					++mNumAccepted;
+				}
+			}
+			for (auto it = mClients.begin(); it != mClients.end(); /**/){
+				bool keep = true;
+				if (FD_ISSET(it->mSocket, &readSet)){
+					char buffer[4096];
+					int n = recv(it->mSocket, buffer, sizeof(buffer), 0);
+					if (n <= 0){
+						keep = false;
+					}
+					else{
+						it->mReceived.append(buffer, n);
+						size_t end;
+						while (keep && (end = it->mReceived.find("\r\n\r\n")) != std::string::npos){
+							auto request = it->mReceived.substr(0, end);
+							it->mReceived.erase(0, end + 4);
+							keep = Respond(it->mSocket, request);
+						}
+					}
+				}
+				if (keep){
+					++it;
+				}
+				else{
+					closesocket(it->mSocket);
+					it = mClients.erase(it);
+				}
+			}
+			return true;
+		}
+
+		// Returns false when the connection has to be closed.
+		bool Respond(SOCKET s, const std::string& request){
+			unsigned size = 0;
+			bool drop = false;
+			if (sscanf_s(request.c_str(), "GET /data/%u", &size) != 1){
+				if (sscanf_s(request.c_str(), "GET /drop/%u", &size) != 1){
+					SendAll(s, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+					return true;
+				}
+				drop = true;
+			}
+			unsigned from = 0;
+			auto range = request.find("Range: bytes=");
+			if (range != std::string::npos){
+				from = (unsigned)atoi(request.c_str() + range + strlen("Range: bytes="));
+				if (from >= size){
+					SendAll(s, FormatString("HTTP/1.1 416 Range Not Satisfiable\r\n"
+						"Content-Range: bytes */%u\r\nContent-Length: 0\r\n\r\n", size));
+					return true;
+				}
+			}
+			std::string header;
+			if (range != std::string::npos){
+				header = FormatString("HTTP/1.1 206 Partial Content\r\nContent-Type: application/octet-stream\r\n"
+					"Content-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\n\r\n", from, size - 1, size, size - from);
+			}
+			else{
+				header = FormatString("HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+					"Content-Length: %u\r\n\r\n", size);
+			}
+			std::string body(size - from, 0);
+			for (unsigned i = from; i < size; ++i){
+				body[i - from] = (char)GetTestByte(i);
+			}
+			if (drop)
+				body.resize(body.size() / 2);
+			SendAll(s, header + body);
+			return !drop;
+		}
+
+		void SendAll(SOCKET s, const std::string& data){
+			size_t sent = 0;
+			while (sent < data.size()){
+				int n = send(s, data.c_str() + sent, (int)(data.size() - sent), 0);
+				if (n <= 0)
+					return;
+				sent += n;
+			}
+		}
+	};
+}
+
+class DownloadTest::Impl{
+public:
+	enum Phase{
+		Concurrent,
+		ResumePart,
+		Dropped,
+		ResumeDropped,
+		CompletePart,
+		StalePart,
+		Done,
+	};
+	// Shared with the callbacks which can outlive the test.
+	struct Results{
+		std::atomic<unsigned> mNumFinished;
+		std::atomic<unsigned> mNumVerified;
+		std::atomic<UINT64> mBytesReceived;
+
+		Results()
+			: mNumFinished(0), mNumVerified(0), mBytesReceived(0)
+		{
+		}
+	};
+	typedef std::shared_ptr<Results> ResultsPtr;
+	LoopbackHttpServer mServer;
+	DownloadManagerPtr mDownloadManager;
+	Phase mPhase;
+	ResultsPtr mResults;
+	std::string mFilePath;
+	INT64 mPhaseStartTick;
+
+	Impl()
+		: mPhase(Done)
+		, mPhaseStartTick(0)
+	{
+		Network::Initialize();
+		if (!mServer.Start())
+			return;
+		mDownloadManager = DownloadManager::Create(8);
+		mFilePath = FileSystem::GetTempDir() + "download_test.bin";
+		StartPhase(Concurrent);
+	}
+
+	~Impl(){
+		if (mDownloadManager){
+			mDownloadManager->CancelAll();
+			mDownloadManager->WaitAll();
+			mDownloadManager = 0;
+		}
+		mServer.Stop();
+		Network::Uninitialize();
+	}
+
+	INT64 GetTickMs() const{
+		using namespace std::chrono;
+		return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	void StartPhase(Phase phase){
+		mPhase = phase;
+		mResults = std::make_shared<Results>();
+		auto results = mResults;
+		mPhaseStartTick = GetTickMs();
+		mServer.mNumAccepted = 0;
+		mDownloadManager->GetStats(true);
+		switch (phase){
+		case Concurrent:{
+			auto url = mServer.GetUrl(FormatString("/data/%u", SmallFileSize).c_str());
+			for (unsigned i = 0; i < NumConcurrentDownloads; ++i){
+				DownloadRequest request;
+				request.mUrl = url;
+				request.mOnFinished = [results](const DownloadResult& result){
+					if (result.mSuccess && result.mBuffer.size() == SmallFileSize &&
+						IsTestData(result.mBuffer.data(), result.mBuffer.size(), 0))
+					{
+						++results->mNumVerified;
+					}
+					++results->mNumFinished;
+				};
+				mDownloadManager->Download(request);
+			}
+			break;
+		}
+		case ResumePart:{
+			// The first third is already on disk.
+			FileSystem::Remove(mFilePath.c_str());
+			ByteArray part(LargeFileSize / 3);
+			for (size_t i = 0; i < part.size(); ++i){
+				part[i] = GetTestByte(i);
+			}
+			FileSystem::WriteBinaryFile((mFilePath + ".part").c_str(), part);
+			DownloadLargeFile("/data/%u");
+			break;
+		}
+		case Dropped:{
+			FileSystem::Remove(mFilePath.c_str());
+			FileSystem::Remove((mFilePath + ".part").c_str());
+			DownloadLargeFile("/drop/%u");
+			break;
+		}
+		case ResumeDropped:{
+			DownloadLargeFile("/data/%u");
+			break;
+		}
+		case CompletePart:
+		case StalePart:{
+			// The server replies 416 to both. A .part larger than the file on
+			// the server is from an other version and has to be downloaded
+			// again.
+			FileSystem::Remove(mFilePath.c_str());
+			ByteArray part(phase == CompletePart ? LargeFileSize : LargeFileSize + 1000);
+			for (size_t i = 0; i < part.size(); ++i){
+				part[i] = phase == CompletePart ? GetTestByte(i) : 0xff;
+			}
+			FileSystem::WriteBinaryFile((mFilePath + ".part").c_str(), part);
+			DownloadLargeFile("/data/%u");
+			break;
+		}
+		}
+	}
+
+	void DownloadLargeFile(const char* pathFormat){
+		DownloadRequest request;
+		request.mUrl = mServer.GetUrl(FormatString(pathFormat, LargeFileSize).c_str());
+		request.mFilePath = mFilePath;
+		request.mResume = true;
+		auto results = mResults;
+		request.mOnFinished = [results](const DownloadResult& result){
+			results->mBytesReceived = result.mBytesReceived;
+			if (result.mSuccess){
+				auto data = FileSystem::ReadBinaryFile(result.mFilePath.c_str());
+				if (data.size() == LargeFileSize && IsTestData(data.data(), data.size(), 0))
+					++results->mNumVerified;
+			}
+			++results->mNumFinished;
+		};
+		mDownloadManager->Download(request);
+	}
+
+	void Update(float dt){
+		if (mPhase == Done)
+			return;
+		unsigned numExpected = mPhase == Concurrent ? NumConcurrentDownloads : 1;
+		if (mResults->mNumFinished < numExpected)
+			return;
+		unsigned numVerified = mResults->mNumVerified;
+		unsigned bytesReceived = (unsigned)mResults->mBytesReceived;
+		auto elapsedMs = GetTickMs() - mPhaseStartTick;
+		auto stats = mDownloadManager->GetStats(true);
+		switch (mPhase){
+		case Concurrent:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: %u/%u concurrent downloads verified in %dms. "
+				"%u connections opened, %u accepted by the server.",
+				numVerified, NumConcurrentDownloads, (int)elapsedMs,
+				stats.mNumNewConnections, (unsigned)mServer.mNumAccepted).c_str());
+			StartPhase(ResumePart);
+			break;
+		case ResumePart:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: resuming a .part file %s. received %u of %u bytes.",
+				numVerified == 1 ? "succeeded" : "FAILED",
+				bytesReceived, LargeFileSize).c_str());
+			StartPhase(Dropped);
+			break;
+		case Dropped:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: dropped connection %s. received %u bytes.",
+				numVerified == 0 && stats.mNumFailed == 1 ? "reported" : "NOT REPORTED",
+				bytesReceived).c_str());
+			StartPhase(ResumeDropped);
+			break;
+		case ResumeDropped:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: resuming after the drop %s. received %u of %u bytes.",
+				numVerified == 1 ? "succeeded" : "FAILED",
+				bytesReceived, LargeFileSize).c_str());
+			StartPhase(CompletePart);
+			break;
+		case CompletePart:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: a complete .part file %s. received %u bytes.",
+				numVerified == 1 && bytesReceived == 0 ? "is kept" : "is NOT KEPT",
+				bytesReceived).c_str());
+			StartPhase(StalePart);
+			break;
+		case StalePart:
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"(info) DownloadTest: a stale .part file %s. received %u of %u bytes.",
+				numVerified == 1 ? "is downloaded again" : "is NOT DOWNLOADED AGAIN",
+				bytesReceived, LargeFileSize).c_str());
+			FileSystem::Remove(mFilePath.c_str());
+			mPhase = Done;
+			break;
+		}
+	}
+};
+
+FB_IMPLEMENT_STATIC_CREATE(DownloadTest);
+DownloadTest::DownloadTest()
+	: mImpl(new Impl)
+{
+
+}
+
+DownloadTest::~DownloadTest(){
+
+}
+
+void DownloadTest::Update(float dt){
+	mImpl->Update(dt);
+}
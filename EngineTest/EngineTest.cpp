@@ -41,6 +41,21 @@
 #include "GenerateNoise.h"
 #include "ComputeShaderTest.h"
 #include "TaskTest.h"
+#include "PhysicsTest.h"
+#include "PointLightTest.h"
+#include "VoxelizerTest.h"
+#include "RandomTest.h"
+#include "AudioStressTest.h"
+#include "AudioStreamTest.h"
+#include "DownloadTest.h"
+#include "InstancingTest.h"
+#include "RayCastTest.h"
+#include "MaterialLoadTest.h"
+#include "ShaderCacheTest.h"
+#include "TextureStreamingTest.h"
+#include "AssetLoadTest.h"
+#include "GlyphAtlasTest.h"
+#include "BatchMathTest.h"
 #include "Permutation.h"
 
 #include "FBCommonHeaders/Helpers.h"
@@ -67,6 +82,21 @@ FractalTestPtr gFractalTest;
 GenerateNoisePtr gGenerateNoise;
 ComputeShaderTestPtr gComputeShaderTest;
 TaskTestPtr gTaskTest;
+PhysicsTestPtr gPhysicsTest;
+PointLightTestPtr gPointLightTest;
+VoxelizerTestPtr gVoxelizerTest;
+RandomTestPtr gRandomTest;
+AudioStressTestPtr gAudioStressTest;
+AudioStreamTestPtr gAudioStreamTest;
+DownloadTestPtr gDownloadTest;
+InstancingTestPtr gInstancingTest;
+RayCastTestPtr gRayCastTest;
+MaterialLoadTestPtr gMaterialLoadTest;
+ShaderCacheTestPtr gShaderCacheTest;
+TextureStreamingTestPtr gTextureStreamingTest;
+AssetLoadTestPtr gAssetLoadTest;
+GlyphAtlasTestPtr gGlyphAtlasTest;
+BatchMathTestPtr gBatchMathTest;
 
 int _FBPrint(lua_State* L);
 
@@ -86,6 +116,14 @@ void UpdateFrame(){
 		gTextTest->Update();
 	if (gAudioTest)
 		gAudioTest->Update(dt);
+	if (gAudioStressTest)
+		gAudioStressTest->Update(dt);
+	if (gAudioStreamTest)
+		gAudioStreamTest->Update(dt);
+	if (gDownloadTest)
+		gDownloadTest->Update(dt);
+	if (gInstancingTest)
+		gInstancingTest->Update(dt);
 
 	gEngine->Render();
 	gEngine->EndInput();
@@ -129,10 +167,40 @@ void StartTest(){
 	//gEngine->AddRendererObserver(IRendererObserver::DefaultRenderEvent, gFractalTest);
 	//gComputeShaderTest = ComputeShaderTest::Create();
 	//gTaskTest = TaskTest::Create();
+	//gPhysicsTest = PhysicsTest::Create();
+	//gPointLightTest = PointLightTest::Create();
+	//gVoxelizerTest = VoxelizerTest::Create();
+	//gRandomTest = RandomTest::Create();
+	//gAudioStressTest = AudioStressTest::Create();
+	//gAudioStreamTest = AudioStreamTest::Create();
+	//gDownloadTest = DownloadTest::Create();
+	//gInstancingTest = InstancingTest::Create();
+	//gRayCastTest = RayCastTest::Create();
+	//gMaterialLoadTest = MaterialLoadTest::Create();
+	//gShaderCacheTest = ShaderCacheTest::Create();
+	//gTextureStreamingTest = TextureStreamingTest::Create();
+	//gAssetLoadTest = AssetLoadTest::Create();
+	//gGlyphAtlasTest = GlyphAtlasTest::Create();
+	//gBatchMathTest = BatchMathTest::Create();
 }
 
 void EndTest(){
 	gEngine->PrepareQuit();
+	gAudioStressTest = 0;
+	gAudioStreamTest = 0;
+	gDownloadTest = 0;
+	gInstancingTest = 0;
+	gRayCastTest = 0;
+	gMaterialLoadTest = 0;
+	gShaderCacheTest = 0;
+	gTextureStreamingTest = 0;
+	gAssetLoadTest = 0;
+	gGlyphAtlasTest = 0;
+	gBatchMathTest = 0;
+	gPhysicsTest = 0;
+	gPointLightTest = 0;
+	gVoxelizerTest = 0;
+	gRandomTest = 0;
 	gTaskTest = 0;
 	gFractalTest = 0;
 	gTextTest = 0;
@@ -30,12 +30,64 @@
 #include "FBRenderer/Renderer.h"
 #include "FBRenderer/Shader.h"
 #include "FBRenderer/Texture.h"
+#include "FBMathLib/NoiseGen.h"
+#include "FBThread/ParallelFor.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
 using namespace fb;
 
+static const unsigned GridSize = 512;
+
 class GenerateNoise::Impl {
 public:
-	Impl() {		
-		
+	std::vector<Real> mNoise;
+
+	Impl() {
+		NoiseGen gen(1);
+		const unsigned num = GridSize * GridSize;
+		mNoise.resize(num);
+
+		// Same sampling as GetGrid2D(), one Get() per texel and octave.
+		std::vector<Real> scalar(num);
+		INT64 scalarTime = 0;
+		{
+			ProfilerSimple p("NoiseGen::Get");
+			const Real step = 8.f / GridSize;
+			for (unsigned y = 0; y < GridSize; ++y) {
+				for (unsigned x = 0; x < GridSize; ++x) {
+					scalar[y * GridSize + x] = gen.Get(x * step, y * step, 0.f);
+				}
+			}
+			scalarTime = p.GetDTMicro();
+		}
+
+		NoiseParams params;
+		params.mFrequency = 8.f;
+		INT64 batchTime = 0;
+		{
+			ProfilerSimple p("NoiseGen::GetGrid2D");
+			gen.GetGrid2D(&mNoise[0], GridSize, GridSize, params);
+			batchTime = p.GetDTMicro();
+		}
+		Real maxDiff = 0.f;
+		for (unsigned i = 0; i < num; ++i) {
+			maxDiff = std::max(maxDiff, std::abs(mNoise[i] - scalar[i]));
+		}
+
+		// Tileable six octave fBm on the task system.
+		params.mType = NoiseParams::FBm;
+		params.mOctaves = 6;
+		params.mPeriod = 8;
+		INT64 parallelTime = 0;
+		{
+			ProfilerSimple p("NoiseGen::GetGrid2D parallel");
+			gen.GetGrid2D(&mNoise[0], GridSize, GridSize, params, GetTaskParallelFor(16));
+			parallelTime = p.GetDTMicro();
+		}
+
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%ux%u noise: Get %lld us, GetGrid2D %lld us (max diff %g), 6 octave fBm in parallel %lld us (%.1f M samples/s)",
+			GridSize, GridSize, scalarTime, batchTime, maxDiff, parallelTime,
+			num * params.mOctaves / (double)std::max(parallelTime, (INT64)1)).c_str());
 	}
 };
 
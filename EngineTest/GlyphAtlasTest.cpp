@@ -0,0 +1,197 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "GlyphAtlasTest.h"
+#include "FBRenderer/GlyphAtlas.h"
+#include "FBRenderer/NullPlatformRenderer.h"
+#include "FBRenderer/IPlatformTexture.h"
+using namespace fb;
+
+static const int PageSize = 128;
+static const int PixelHeight = 20;
+static const char* FontPath = "test.ttf";
+
+class GlyphAtlasTest::Impl {
+public:
+	NullPlatformRendererPtr mPlatformRenderer;
+	unsigned mNumFailed;
+
+	Impl()
+		: mPlatformRenderer(NullPlatformRenderer::Create())
+		, mNumFailed(0)
+	{
+		TestStrikes();
+		TestRasterizing();
+		TestSinglePage();
+		TestEviction();
+		TestGlyphsInUse();
+		if (mNumFailed == 0)
+			Logger::Log(FB_DEFAULT_LOG_ARG, "GlyphAtlasTest passed.");
+		else
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("GlyphAtlasTest: %u checks failed.", mNumFailed).c_str());
+	}
+
+	void Check(bool condition, const char* what) {
+		if (!condition) {
+			++mNumFailed;
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("GlyphAtlasTest: %s failed.", what).c_str());
+		}
+	}
+
+	// a frame which waits for the rasterizing.
+	void Update(GlyphAtlasPtr atlas) {
+		atlas->Update(*mPlatformRenderer);
+		atlas->Sync();
+		atlas->Update(*mPlatformRenderer);
+	}
+
+	// Returns the number of resident glyphs.
+	unsigned GetGlyphs(GlyphAtlasPtr atlas, int strike, unsigned first, unsigned num,
+		std::vector<GlyphAtlas::Glyph>* outGlyphs = 0)
+	{
+		unsigned numResident = 0;
+		for (unsigned cp = first; cp < first + num; ++cp) {
+			GlyphAtlas::Glyph glyph;
+			if (atlas->GetGlyph(strike, cp, glyph)) {
+				++numResident;
+				if (outGlyphs)
+					outGlyphs->push_back(glyph);
+			}
+		}
+		return numResident;
+	}
+
+	void TestStrikes() {
+		auto atlas = GlyphAtlas::Create(PageSize, 2);
+		auto strike = atlas->GetStrike(FontPath, PixelHeight);
+		Check(strike != -1 && atlas->GetStrike(FontPath, PixelHeight) == strike, "Reusing the strike");
+		auto bigger = atlas->GetStrike(FontPath, PixelHeight * 2);
+		auto third = atlas->GetStrike("other.ttf", PixelHeight);
+		Check(bigger != strike && third != strike && third != bigger, "A strike per font and height");
+		Check(atlas->GetStrikePage(strike) == 0 && atlas->GetStrikePage(bigger) == 1 &&
+			atlas->GetStrikePage(third) == 0, "Sharing pages over the limit");
+		Check(atlas->GetStrike("", PixelHeight) == -1 && atlas->GetStrike(FontPath, 0) == -1,
+			"Rejecting invalid strikes");
+	}
+
+	void TestRasterizing() {
+		auto atlas = GlyphAtlas::Create(PageSize, 1);
+		auto strike = atlas->GetStrike(FontPath, PixelHeight);
+		GlyphAtlas::Glyph glyph;
+		Check(!atlas->GetGlyph(strike, 'A', glyph) && glyph.mPage == 0, "Requesting a glyph");
+		Check(!atlas->GetGlyph(strike, ' ', glyph), "Requesting a blank glyph");
+		Check(atlas->GetStats().mNumPending == 2, "Pending glyphs");
+		Update(atlas);
+		GlyphFontMetrics metrics;
+		mPlatformRenderer->GetGlyphFontMetrics(FontPath, PixelHeight, metrics);
+		Check(atlas->GetGlyph(strike, 'A', glyph) && glyph.mWidth == PixelHeight / 2 &&
+			glyph.mHeight == metrics.mBase && glyph.mX >= GlyphAtlas::Padding &&
+			glyph.mY >= GlyphAtlas::Padding, "Packing a glyph");
+		Check(atlas->GetPageTexture(glyph.mPage) != 0, "Uploading the page");
+		Check(atlas->GetGlyph(strike, ' ', glyph) && glyph.mWidth == 0 && glyph.mXAdvance > 0,
+			"Blank glyph with the advance");
+		auto stats = atlas->GetStats();
+		Check(stats.mNumPending == 0 && stats.mNumGlyphs == 2 && stats.mNumUploads == 1, "Stats after rasterizing");
+	}
+
+	void TestSinglePage() {
+		auto atlas = GlyphAtlas::Create(PageSize, 4);
+		auto strike = atlas->GetStrike(FontPath, PixelHeight);
+		atlas->GetStrike(FontPath, PixelHeight + 1);
+		atlas->GetStrike(FontPath, PixelHeight + 2);
+		const unsigned numGlyphs = 40;
+		GetGlyphs(atlas, strike, 'A', numGlyphs);
+		Update(atlas);
+		std::vector<GlyphAtlas::Glyph> glyphs;
+		Check(GetGlyphs(atlas, strike, 'A', numGlyphs, &glyphs) == numGlyphs, "Resident glyphs");
+		bool samePage = true;
+		bool overlapped = false;
+		for (size_t i = 0; i < glyphs.size(); ++i) {
+			auto& a = glyphs[i];
+			samePage = samePage && a.mPage == atlas->GetStrikePage(strike);
+			for (size_t j = i + 1; j < glyphs.size(); ++j) {
+				auto& b = glyphs[j];
+				overlapped = overlapped || (a.mX < b.mX + b.mWidth && b.mX < a.mX + a.mWidth &&
+					a.mY < b.mY + b.mHeight && b.mY < a.mY + a.mHeight);
+			}
+		}
+		Check(samePage, "A text run in a single page");
+		Check(!overlapped, "Glyphs not overlapping");
+	}
+
+	// Glyphs not used anymore give their shelves to new ones.
+	void TestEviction() {
+		auto atlas = GlyphAtlas::Create(PageSize, 1);
+		auto strike = atlas->GetStrike(FontPath, PixelHeight);
+		const unsigned numGlyphs = 30;
+		for (int frame = 0; frame < 3; ++frame) {
+			GetGlyphs(atlas, strike, 'A', numGlyphs);
+			Update(atlas);
+		}
+		Check(GetGlyphs(atlas, strike, 'A', numGlyphs) == numGlyphs, "Resident before eviction");
+		const unsigned second = 0xac00;
+		for (int frame = 0; frame < 3; ++frame) {
+			GetGlyphs(atlas, strike, second, numGlyphs);
+			Update(atlas);
+		}
+		Check(GetGlyphs(atlas, strike, second, numGlyphs) == numGlyphs, "Resident after eviction");
+		auto stats = atlas->GetStats();
+		Check(stats.mNumEvicted > 0 && stats.mNumPages == 1, "Evicting unused glyphs");
+	}
+
+	// More glyphs than a page holds are used in every frame.
+	void TestGlyphsInUse() {
+		auto atlas = GlyphAtlas::Create(PageSize, 1);
+		auto strike = atlas->GetStrike(FontPath, PixelHeight);
+		const unsigned numGlyphs = 100;
+		std::vector<GlyphAtlas::Glyph> prev;
+		bool kept = true;
+		for (int frame = 0; frame < 5; ++frame) {
+			std::vector<GlyphAtlas::Glyph> glyphs;
+			auto numResident = GetGlyphs(atlas, strike, 'A', numGlyphs, &glyphs);
+			kept = kept && numResident >= prev.size();
+			prev.swap(glyphs);
+			atlas->Update(*mPlatformRenderer);
+			atlas->Sync();
+		}
+		Check(kept, "Keeping the glyphs in use");
+		Check(!prev.empty() && prev.size() < numGlyphs && atlas->GetStats().mNumPending > 0,
+			"Waiting for space");
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(GlyphAtlasTest);
+
+GlyphAtlasTest::GlyphAtlasTest()
+	: mImpl(new Impl)
+{
+}
+
+GlyphAtlasTest::~GlyphAtlasTest() {
+}
@@ -0,0 +1,180 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "InstancingTest.h"
+#include "FBEngineFacade/MeshFacade.h"
+#include "FBEngineFacade/EngineFacade.h"
+#include "FBSceneObjectFactory/MeshInstancer.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/Material.h"
+#include "FBRenderer/Camera.h"
+#include "FBRenderer/NullPlatformRenderer.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+static const unsigned NumQueued = 10000;
+static const unsigned NumGeometries = 32;
+static const unsigned NumMaterials = 4;
+static const unsigned GridSize = 8;
+
+class InstancingTest::Impl {
+public:
+	enum Step {
+		WarmUp,
+		StartCounting,
+		WithoutInstancing,
+		WithInstancing,
+		Done,
+	};
+	std::vector<MeshFacadePtr> mMeshes;
+	NullPlatformRendererPtr mNullRenderer;
+	NullPlatformRenderer::CallCounts mCountsWithout;
+	Step mStep;
+
+	Impl()
+		: mStep(WarmUp)
+	{
+		MeasureGrouping();
+
+		auto& engine = EngineFacade::GetInstance();
+		auto source = MeshFacade::Create()->LoadMeshObject("data/cruiser_prototype2.dae");
+		if (!source) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Cannot load the test mesh.");
+			mStep = Done;
+			return;
+		}
+		auto center = engine.GetMainCameraPos() + engine.GetMainCameraDirection() * 60.f;
+		for (unsigned y = 0; y < GridSize; ++y) {
+			for (unsigned x = 0; x < GridSize; ++x) {
+				auto mesh = source->Clone();
+				mesh->SetPosition(center + Vec3((x - GridSize * .5f) * 6.f, 0, (y - GridSize * .5f) * 6.f));
+				mesh->AttachToScene();
+				mMeshes.push_back(mesh);
+			}
+		}
+		MeshInstancer::Reserve(mMeshes.size());
+		mNullRenderer = NullPlatformRenderer::Create();
+	}
+
+	~Impl() {
+		Renderer::GetInstance().SetPlatformRendererOverride(0);
+		MeshInstancer::SetEnabled(true);
+	}
+
+	void MeasureGrouping() {
+		auto& renderer = Renderer::GetInstance();
+		auto camera = renderer.GetMainCamera();
+		auto base = renderer.CreateMaterial("EssentialEngineData/materials/defaultPBR.material");
+		if (!camera || !base)
+			return;
+		// clones with different constants don't share the data.
+		std::vector<MaterialPtr> materials;
+		for (unsigned i = 0; i < NumMaterials; ++i) {
+			auto material = base->Clone();
+			material->SetDiffuseColor(Vec4(1.f, 1.f, 1.f, 1.f - i * 0.1f));
+			materials.push_back(material);
+		}
+		// only the addresses are used.
+		std::vector<int> geometries(NumGeometries);
+		std::vector<int> owners(NumQueued);
+		Mat44 world = Mat44::IDENTITY;
+
+		MeshInstancer::Clear();
+		INT64 time = 0;
+		unsigned numGroups = 0;
+		{
+			ProfilerSimple p("Grouping");
+			for (unsigned i = 0; i < NumQueued; ++i) {
+				world[0][3] = (Real)i;
+				MeshInstancer::Queue(camera.get(), &geometries[i % NumGeometries],
+					materials[(i / NumGeometries) % NumMaterials].get(), world, &owners[i]);
+			}
+			numGroups = MeshInstancer::GetNumInstancedGroups(camera.get());
+			time = p.GetDTMicro();
+		}
+		MeshInstancer::Clear();
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"Grouping %u instances into %u groups(expected %u): %lld us, %.3f us per instance",
+			NumQueued, numGroups, NumGeometries * NumMaterials, time, time / (double)NumQueued).c_str());
+	}
+
+	void Update(TIME_PRECISION dt) {
+		auto& renderer = Renderer::GetInstance();
+		switch (mStep) {
+		case WarmUp:
+			// this frame creates the instanced materials with the real renderer.
+			mStep = StartCounting;
+			break;
+		case StartCounting:
+			// the next frame is rendered without instancing.
+			renderer.SetPlatformRendererOverride(mNullRenderer);
+			MeshInstancer::SetEnabled(false);
+			mNullRenderer->ResetCallCounts();
+			mStep = WithoutInstancing;
+			break;
+		case WithoutInstancing:
+			mCountsWithout = mNullRenderer->GetCallCounts();
+			MeshInstancer::SetEnabled(true);
+			mNullRenderer->ResetCallCounts();
+			mStep = WithInstancing;
+			break;
+		case WithInstancing:
+		{
+			renderer.SetPlatformRendererOverride(0);
+			auto& counts = mNullRenderer->GetCallCounts();
+			// every instanced draw replaces numInstances indexed draws.
+			bool passed = counts.mDrawIndexedInstanced > 0 &&
+				mCountsWithout.mDrawIndexed - counts.mDrawIndexed ==
+				counts.mNumInstances - counts.mDrawIndexedInstanced;
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"Instancing %s: %u indexed draws without instancing. %u indexed draws and %u instanced draws(%u instances) with instancing.",
+				passed ? "passed" : "failed", mCountsWithout.mDrawIndexed, counts.mDrawIndexed,
+				counts.mDrawIndexedInstanced, counts.mNumInstances).c_str());
+			mStep = Done;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(InstancingTest);
+
+InstancingTest::InstancingTest()
+	: mImpl(new Impl)
+{
+}
+
+InstancingTest::~InstancingTest() {
+}
+
+void InstancingTest::Update(TIME_PRECISION dt) {
+	mImpl->Update(dt);
+}
@@ -0,0 +1,134 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "MaterialLoadTest.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/RendererOptions.h"
+#include "FBRenderer/Material.h"
+#include "FBRenderer/CompiledMaterial.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBFileSystem/DirectoryIterator.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+// A level references the same materials from many objects.
+static const unsigned NumLoadsPerFile = 20;
+
+class MaterialLoadTest::Impl {
+public:
+	StringVector mFiles;
+
+	Impl() {
+		CollectFiles("EssentialEngineData/materials");
+		CollectFiles("data");
+		if (mFiles.empty()) {
+			Logger::Log(FB_ERROR_LOG_ARG, "No material files.");
+			return;
+		}
+		auto options = Renderer::GetInstance().GetRendererOptions();
+		auto prevOption = options->r_MaterialCache;
+
+		// Create the renderer resources first so the timings only contain loading the materials.
+		options->r_MaterialCache = 0;
+		LoadAll(1);
+		auto xmlTime = LoadAll(NumLoadsPerFile);
+
+		INT64 compileTime = 0;
+		{
+			ProfilerSimple p("Compile");
+			for (auto& file : mFiles) {
+				CompiledMaterial::CompileToCache(file.c_str());
+			}
+			compileTime = p.GetDTMicro();
+		}
+		options->r_MaterialCache = 1;
+		auto cacheTime = LoadAll(NumLoadsPerFile);
+		options->r_MaterialCache = prevOption;
+
+		// Count the files resolved to the same data. They share the data blocks.
+		std::vector<MaterialPtr> unique;
+		for (auto& file : mFiles) {
+			auto material = Material::Create();
+			if (!material->LoadFromFile(file.c_str()))
+				continue;
+			bool found = false;
+			for (auto& it : unique) {
+				if (&it->GetMaterialConstants() == &material->GetMaterialConstants() &&
+					it->GetRenderStates() == material->GetRenderStates()) {
+					found = true;
+					break;
+				}
+			}
+			if (!found)
+				unique.push_back(material);
+		}
+
+		unsigned numLoads = mFiles.size() * NumLoadsPerFile;
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%u material files(%u distinct data), %u loads: xml %lld us(%.2f us per load), cache %lld us(%.2f us per load), compiling the cache %lld us",
+			(unsigned)mFiles.size(), (unsigned)unique.size(), numLoads,
+			xmlTime, xmlTime / (double)numLoads, cacheTime, cacheTime / (double)numLoads, compileTime).c_str());
+	}
+
+	void CollectFiles(const char* directory) {
+		auto it = FileSystem::GetDirectoryIterator(directory, true);
+		if (!it)
+			return;
+		while (it->HasNext()) {
+			bool isDirectory = false;
+			const char* filepath = it->GetNextFilePath(&isDirectory);
+			if (!isDirectory && FileSystem::HasExtension(filepath, ".material"))
+				mFiles.push_back(filepath);
+		}
+	}
+
+	INT64 LoadAll(unsigned numLoadsPerFile) {
+		std::vector<MaterialPtr> materials;
+		materials.reserve(mFiles.size() * numLoadsPerFile);
+		ProfilerSimple p("LoadAll");
+		for (unsigned i = 0; i < numLoadsPerFile; ++i) {
+			for (auto& file : mFiles) {
+				auto material = Material::Create();
+				material->LoadFromFile(file.c_str());
+				materials.push_back(material);
+			}
+		}
+		return p.GetDTMicro();
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(MaterialLoadTest);
+
+MaterialLoadTest::MaterialLoadTest()
+	: mImpl(new Impl)
+{
+}
+
+MaterialLoadTest::~MaterialLoadTest() {
+}
@@ -0,0 +1,253 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "PhysicsTest.h"
+#include "FBPhysics/IPhysics.h"
+#include "FBPhysics/IPhysicsInterface.h"
+#include "FBPhysics/RigidBody.h"
+#include "FBPhysics/ColShapes.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+static const unsigned NumBodies = 5000;
+static const unsigned NumRays = 10000;
+static const float WorldSize = 1000.f;
+
+static const unsigned NumReplayBodies = 64;
+static const unsigned NumReplaySteps = 600;
+
+class TestBody : public IPhysicsInterface {
+public:
+	Vec3 mPos;
+	Quat mRot;
+	float mMass;
+	CollisionShapePtr mShape;
+	RigidBodyPtr mRigidBody;
+
+	TestBody(const Vec3& pos, const Vec3& extent, float mass)
+		: mPos(pos)
+		, mMass(mass)
+	{
+		mShape = CollisionShapeFactory::CreateBoxShape(Vec3::ZERO, Quat::IDENTITY, Vec3::ONE, extent);
+	}
+
+	void* GetUserPtr() const OVERRIDE { return (void*)this; }
+	unsigned GetNumColShapes() const OVERRIDE { return 1; }
+	CollisionShapePtr GetShape(unsigned i) OVERRIDE { return mShape; }
+	unsigned GetShapes(CollisionShapePtr shapes[], unsigned maxNum) const OVERRIDE {
+		if (maxNum == 0)
+			return 0;
+		shapes[0] = mShape;
+		return 1;
+	}
+	float GetMass() const OVERRIDE { return mMass; }
+	int GetCollisionGroup() const OVERRIDE { return 1; }
+	int GetCollisionMask() const OVERRIDE { return -1; }
+	float GetLinearDamping() const OVERRIDE { return 0.f; }
+	float GetAngularDamping() const OVERRIDE { return 0.f; }
+	const Vec3& GetPos() OVERRIDE { return mPos; }
+	const Quat& GetRot() OVERRIDE { return mRot; }
+	void SetPosRot(const Vec3& pos, const Quat& rot) OVERRIDE { mPos = pos; mRot = rot; }
+	bool OnCollision(const CollisionContactInfo& contactInfo) OVERRIDE { return false; }
+};
+typedef std::shared_ptr<TestBody> TestBodyPtr;
+
+struct ReplayInput {
+	unsigned step;
+	unsigned body;
+	Vec3 impulse;
+};
+
+// Runs the input log on a fresh world stepped headless.
+static void Replay(const std::vector<ReplayInput>& inputs, std::vector<Vec3>& outPositions) {
+	auto physics = IPhysics::Create();
+	std::vector<TestBodyPtr> bodies;
+	for (unsigned i = 0; i < NumReplayBodies; ++i) {
+		auto body = std::make_shared<TestBody>(Vec3((i % 8) * 3.f, (i / 8) * 3.f, 0.f), Vec3(1.f), 1.f);
+		body->mRigidBody = physics->CreateRigidBody(body.get());
+		body->mRigidBody->RegisterToWorld();
+		bodies.push_back(body);
+	}
+	auto it = inputs.begin();
+	for (unsigned step = 0; step < NumReplaySteps; ++step) {
+		for (; it != inputs.end() && it->step == step; ++it) {
+			bodies[it->body]->mRigidBody->ApplyCentralImpulse(it->impulse);
+		}
+		physics->StepSimulationFixed(1, 1.f / 60.f);
+	}
+	outPositions.clear();
+	for (auto& body : bodies) {
+		outPositions.push_back(body->mPos);
+		body->mRigidBody->UnregisterFromWorld();
+	}
+}
+
+class PhysicsTest::Impl {
+public:
+	IPhysicsPtr mPhysics;
+	std::vector<TestBodyPtr> mBoxes;
+
+	Impl() {
+		TestReplay();
+		TestSimulationThread();
+
+		mPhysics = IPhysics::Create();
+		mBoxes.reserve(NumBodies);
+		for (unsigned i = 0; i < NumBodies; ++i) {
+			auto box = std::make_shared<TestBody>(
+				Random(Vec3(-WorldSize), Vec3(WorldSize)), Random(Vec3(1.f), Vec3(10.f)), 0.f);
+			box->mRigidBody = mPhysics->CreateRigidBody(box.get());
+			Transformation t;
+			t.SetTranslation(box->mPos);
+			box->mRigidBody->SetTransform(t);
+			box->mRigidBody->RegisterToWorld();
+			mBoxes.push_back(box);
+		}
+		mPhysics->Update(1.f / 60.f);
+
+		std::vector<RayQuery> queries(NumRays);
+		for (auto& q : queries) {
+			q.mFromWorld = Random(Vec3(-WorldSize), Vec3(WorldSize));
+			q.mToWorld = Random(Vec3(-WorldSize), Vec3(WorldSize));
+			q.mMask = 1;
+		}
+		std::vector<RayResultClosest> results(NumRays);
+
+		unsigned numHitsSingle = 0;
+		INT64 singleTime = 0;
+		{
+			ProfilerSimple p("RayTestClosest");
+			for (unsigned i = 0; i < NumRays; ++i) {
+				if (mPhysics->RayTestClosest(queries[i].mFromWorld, queries[i].mToWorld, 
+					queries[i].mAdditionalGroupFlag, queries[i].mMask, results[i]))
+					++numHitsSingle;
+			}
+			singleTime = p.GetDTMicro();
+		}
+
+		unsigned numHitsBatch = 0;
+		INT64 batchTime = 0;
+		{
+			ProfilerSimple p("RayTestClosestBatch");
+			numHitsBatch = mPhysics->RayTestClosestBatch(&queries[0], NumRays, &results[0]);
+			batchTime = p.GetDTMicro();
+		}
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%u rays against %u bodies: RayTestClosest %lld us(%u hits), RayTestClosestBatch %lld us(%u hits)",
+			NumRays, NumBodies, singleTime, numHitsSingle, batchTime, numHitsBatch).c_str());
+
+		std::vector<AABBQuery> aabbQueries(NumRays);
+		for (auto& q : aabbQueries) {
+			auto center = Random(Vec3(-WorldSize), Vec3(WorldSize));
+			q.mAABB = AABB(center - Vec3(20.f), center + Vec3(20.f));
+		}
+		const unsigned limit = 16;
+		std::vector<RigidBody*> ret(NumRays * limit);
+		std::vector<unsigned> index(NumRays * limit);
+		std::vector<unsigned> counts(NumRays);
+		{
+			ProfilerSimple p("GetAABBOverlapsBatch");
+			auto num = mPhysics->GetAABBOverlapsBatch(&aabbQueries[0], NumRays, &ret[0], &index[0], limit, &counts[0]);
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"%u aabb queries: GetAABBOverlapsBatch %lld us(%u overlaps)",
+				NumRays, p.GetDTMicro(), num).c_str());
+		}
+	}
+
+	void TestReplay() {
+		std::vector<ReplayInput> inputs;
+		for (unsigned step = 0; step < NumReplaySteps; step += 10) {
+			inputs.push_back({ step, (unsigned)Random(0, (int)NumReplayBodies - 1), Random(Vec3(-5.f), Vec3(5.f)) });
+		}
+		std::vector<Vec3> first, second;
+		Replay(inputs, first);
+		Replay(inputs, second);
+		bool same = memcmp(&first[0], &second[0], sizeof(Vec3) * first.size()) == 0;
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Physics replay of %u steps is %s.", 
+			NumReplaySteps, same ? "deterministic" : "NOT deterministic").c_str());
+	}
+
+	// Steps on the simulation thread while the main thread queues impulses and
+	// reads the bodies back.
+	void TestSimulationThread() {
+		auto physics = IPhysics::Create();
+		std::vector<TestBodyPtr> bodies;
+		for (unsigned i = 0; i < NumReplayBodies; ++i) {
+			auto body = std::make_shared<TestBody>(Vec3((i % 8) * 3.f, (i / 8) * 3.f, 0.f), Vec3(1.f), 1.f);
+			body->mRigidBody = physics->CreateRigidBody(body.get());
+			body->mRigidBody->RegisterToWorld();
+			bodies.push_back(body);
+		}
+		physics->StartSimulationThread(1.f / 120.f);
+		unsigned numMoved = 0;
+		bool valid = true;
+		for (unsigned frame = 0; frame < 60; ++frame) {
+			for (auto& body : bodies) {
+				body->mRigidBody->ApplyCentralImpulse(Vec3(0.f, 0.f, 1.f));
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			physics->Update(1.f / 60.f);
+			for (auto& body : bodies) {
+				auto vel = body->mRigidBody->GetVelocity();
+				auto pos = body->mRigidBody->GetPos();
+				auto aabb = body->mRigidBody->GetAABB();
+				if (!aabb.Contain(pos) || vel.z < 0.f)
+					valid = false;
+			}
+		}
+		physics->StopSimulationThread();
+		for (auto& body : bodies) {
+			if ((body->mRigidBody->GetPos() - body->mPos).Length() > 0.01f)
+				valid = false;
+			if (body->mPos.z > 0.f)
+				++numMoved;
+			body->mRigidBody->UnregisterFromWorld();
+		}
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Physics simulation thread: %u/%u bodies moved, state is %s.",
+			numMoved, NumReplayBodies, valid ? "consistent" : "NOT consistent").c_str());
+	}
+
+	~Impl() {
+		for (auto& box : mBoxes) {
+			box->mRigidBody->UnregisterFromWorld();
+		}
+		mBoxes.clear();
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(PhysicsTest);
+PhysicsTest::PhysicsTest()
+	: mImpl(new Impl)
+{
+
+}
+
+PhysicsTest::~PhysicsTest() {
+
+}
@@ -0,0 +1,147 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "PointLightTest.h"
+#include "FBSceneManager/Scene.h"
+#include "FBSceneManager/PointLight.h"
+#include "FBSceneManager/PointLightManager.h"
+#include "FBMathLib/BoundingVolume.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+#include "EssentialEngineData/shaders/Constants.h"
+using namespace fb;
+
+static const unsigned NumObjects = 1000;
+static const unsigned NumLights = PointLightManager::MaxPointLights;
+static const unsigned NumFrames = 20;
+static const float WorldSize = 200.f;
+
+struct TestObject {
+	BoundingVolumePtr mBoundingVolume;
+	Transformation mTransform;
+};
+
+class PointLightTest::Impl {
+public:
+	ScenePtr mScene;
+	std::vector<PointLightPtr> mLights;
+	std::vector<TestObject> mObjects;
+
+	Impl() {
+		mScene = Scene::Create("PointLightTest");
+		auto lightMan = mScene->GetPointLightMan();
+		for (unsigned i = 0; i < NumLights; ++i) {
+			auto light = lightMan->CreatePointLight(Random(Vec3(-WorldSize), Vec3(WorldSize)), Random(5.f, 20.f),
+				Random(Vec3(0.2f), Vec3(1.f)), Random(0.5f, 2.f), -1.f, true);
+			if (light)
+				mLights.push_back(light);
+		}
+		mObjects.resize(NumObjects);
+		for (auto& object : mObjects) {
+			object.mBoundingVolume = BoundingVolume::Create(BoundingVolume::BV_SPHERE);
+			object.mBoundingVolume->SetCenter(Vec3::ZERO);
+			object.mBoundingVolume->SetRadius(Random(0.5f, 4.f));
+			object.mTransform.SetTranslation(Random(Vec3(-WorldSize), Vec3(WorldSize)));
+		}
+
+		std::vector<POINT_LIGHT_CONSTANTS> results(NumObjects);
+		INT64 gatherTime = 0;
+		{
+			ProfilerSimple p("GatherPointLightData");
+			for (unsigned f = 0; f < NumFrames; ++f) {
+				lightMan->BinPointLights();
+				for (unsigned i = 0; i < NumObjects; ++i) {
+					lightMan->GatherPointLightData(mObjects[i].mBoundingVolume.get(), mObjects[i].mTransform, &results[i]);
+				}
+			}
+			gatherTime = p.GetDTMicro();
+		}
+
+		std::vector<POINT_LIGHT_CONSTANTS> references(NumObjects);
+		INT64 bruteForceTime = 0;
+		{
+			ProfilerSimple p("BruteForce");
+			for (unsigned f = 0; f < NumFrames; ++f) {
+				for (unsigned i = 0; i < NumObjects; ++i) {
+					GatherBruteForce(mObjects[i], &references[i]);
+				}
+			}
+			bruteForceTime = p.GetDTMicro();
+		}
+
+		unsigned numMismatches = 0;
+		unsigned numGathered = 0;
+		for (unsigned i = 0; i < NumObjects; ++i) {
+			auto count = (unsigned)references[i].gPointLightColor[0].w;
+			bool same = results[i].gPointLightColor[0].w == references[i].gPointLightColor[0].w;
+			for (unsigned l = 0; same && l < count; ++l) {
+				same = memcmp(&results[i].gPointLightPos[l], &references[i].gPointLightPos[l], sizeof(results[i].gPointLightPos[l])) == 0;
+			}
+			if (!same)
+				++numMismatches;
+			numGathered += count;
+		}
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%u objects against %u point lights, %u frames: GatherPointLightData %lld us, brute force %lld us, %.2f lights per object, %u mismatches",
+			NumObjects, (unsigned)mLights.size(), NumFrames, gatherTime, bruteForceTime, 
+			numGathered / (float)NumObjects, numMismatches).c_str());
+	}
+
+	// Tests every light against the world bounding sphere of the object.
+	void GatherBruteForce(const TestObject& object, POINT_LIGHT_CONSTANTS* plConst) {
+		auto center = object.mTransform.ApplyForward(object.mBoundingVolume->GetCenter());
+		auto radius = object.mBoundingVolume->GetRadius() * object.mTransform.GetNorm();
+		std::vector<std::pair<float, PointLight*>> inRange;
+		for (auto& light : mLights) {
+			auto dist = std::max(0.f, (light->GetPosition() - center).Length() - radius);
+			if (dist < light->GetRange())
+				inRange.push_back(std::make_pair(light->GetIntensityScoreAtRange(dist), light.get()));
+		}
+		std::stable_sort(inRange.begin(), inRange.end(), 
+			[](const std::pair<float, PointLight*>& a, const std::pair<float, PointLight*>& b) {
+			return a.first > b.first;
+		});
+		plConst->gPointLightColor[0].w = 0;
+		auto count = std::min((unsigned)MAX_POINT_LIGHT, (unsigned)inRange.size());
+		for (unsigned i = 0; i < count; ++i) {
+			auto light = inRange[i].second;
+			plConst->gPointLightPos[i] = Vec4(light->GetPosition(), light->GetRange());
+			plConst->gPointLightColor[i] = Vec4(light->GetColorPowered(), (Real)count);
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(PointLightTest);
+
+PointLightTest::PointLightTest()
+	: mImpl(new Impl)
+{
+}
+
+PointLightTest::~PointLightTest() {
+}
@@ -0,0 +1,142 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "RandomTest.h"
+#include "FBMathLib/Random.h"
+#include "FBMathLib/RandomGenerator.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+static const unsigned NumParticles = 1000000;
+static const unsigned ValuesPerParticle = 15; // about what ParticleEmitter draws for a sphere emitter
+
+struct SpawnData {
+	Vec3 mPos;
+	Vec3 mVelDir;
+	float mVelocity;
+	float mLifeTime;
+	Vec2 mSize;
+	Vec2 mScaleSpeed;
+	float mRot;
+	float mRotSpeed;
+	float mIntensity;
+};
+
+class RandomTest::Impl {
+public:
+	std::vector<SpawnData> mData;
+
+	Impl() {
+		mData.resize(NumParticles);
+		INT64 legacyTime = 0;
+		{
+			ProfilerSimple p("Random");
+			for (auto& d : mData) {
+				float r = Random(0.5f, 2.f);
+				d.mPos = SphericalToCartesian(r, Random(0.f, PI), Random(0.f, TWO_PI));
+				d.mVelDir = Random(Vec3(-1.f), Vec3(1.f));
+				d.mVelocity = Random(1.f, 2.f);
+				d.mLifeTime = Random(1.f, 3.f);
+				d.mSize = Random(Vec2(1.f, 1.f), Vec2(2.f, 2.f));
+				d.mScaleSpeed = Random(Vec2(0.f, 0.f), Vec2(1.f, 1.f));
+				d.mRot = Random(0.f, TWO_PI);
+				d.mRotSpeed = Random(-1.f, 1.f);
+				d.mIntensity = Random(1.f, 2.f);
+			}
+			legacyTime = p.GetDTMicro();
+		}
+
+		RandomGenerator generator(1);
+		INT64 generatorTime = 0;
+		{
+			ProfilerSimple p("RandomGenerator");
+			for (auto& d : mData) {
+				float r = generator.Next(0.5f, 2.f);
+				float theta = generator.Next(0.f, PI);
+				d.mPos = SphericalToCartesian(r, theta, generator.Next(0.f, TWO_PI));
+				d.mVelDir = generator.Next(Vec3(-1.f), Vec3(1.f));
+				d.mVelocity = generator.Next(1.f, 2.f);
+				d.mLifeTime = generator.Next(1.f, 3.f);
+				d.mSize = generator.Next(Vec2(1.f, 1.f), Vec2(2.f, 2.f));
+				d.mScaleSpeed = generator.Next(Vec2(0.f, 0.f), Vec2(1.f, 1.f));
+				d.mRot = generator.Next(0.f, TWO_PI);
+				d.mRotSpeed = generator.Next(-1.f, 1.f);
+				d.mIntensity = generator.Next(1.f, 2.f);
+			}
+			generatorTime = p.GetDTMicro();
+		}
+
+		INT64 fillTime = 0;
+		{
+			ProfilerSimple p("RandomGenerator::Fill");
+			std::vector<float> v[ValuesPerParticle];
+			const float ranges[ValuesPerParticle][2] = {
+				{ 0.5f, 2.f }, { 0.f, PI }, { 0.f, TWO_PI }, // position
+				{ -1.f, 1.f }, { -1.f, 1.f }, { -1.f, 1.f }, // velocity direction
+				{ 1.f, 2.f }, { 1.f, 3.f }, // velocity, life time
+				{ 1.f, 2.f }, { 1.f, 2.f }, { 0.f, 1.f }, { 0.f, 1.f }, // size, scale speed
+				{ 0.f, TWO_PI }, { -1.f, 1.f }, { 1.f, 2.f }, // rotation, rotation speed, intensity
+			};
+			for (unsigned k = 0; k < ValuesPerParticle; ++k) {
+				v[k].resize(NumParticles);
+				generator.Fill(&v[k][0], NumParticles, ranges[k][0], ranges[k][1]);
+			}
+			for (unsigned i = 0; i < NumParticles; ++i) {
+				auto& d = mData[i];
+				d.mPos = SphericalToCartesian(v[0][i], v[1][i], v[2][i]);
+				d.mVelDir = Vec3(v[3][i], v[4][i], v[5][i]);
+				d.mVelocity = v[6][i];
+				d.mLifeTime = v[7][i];
+				d.mSize = Vec2(v[8][i], v[9][i]);
+				d.mScaleSpeed = Vec2(v[10][i], v[11][i]);
+				d.mRot = v[12][i];
+				d.mRotSpeed = v[13][i];
+				d.mIntensity = v[14][i];
+			}
+			fillTime = p.GetDTMicro();
+		}
+
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%u particles, %u values each: Random %lld us (%.1f M/s), RandomGenerator %lld us (%.1f M/s), Fill %lld us (%.1f M/s)",
+			NumParticles, ValuesPerParticle,
+			legacyTime, NumParticles / (double)std::max(legacyTime, (INT64)1),
+			generatorTime, NumParticles / (double)std::max(generatorTime, (INT64)1),
+			fillTime, NumParticles / (double)std::max(fillTime, (INT64)1)).c_str());
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(RandomTest);
+
+RandomTest::RandomTest()
+	: mImpl(new Impl)
+{
+}
+
+RandomTest::~RandomTest() {
+}
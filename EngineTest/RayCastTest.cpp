@@ -0,0 +1,199 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "RayCastTest.h"
+#include "FBMathLib/TriangleBVH.h"
+#include "FBMathLib/GeomUtils.h"
+#include "FBMathLib/RandomGenerator.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+// 320 * 160 * 2 = 102400 triangles
+static const unsigned NumSegments = 320;
+static const float SphereRadius = 10.f;
+static const unsigned NumRays = 100000;
+// Brute force is too slow for every ray.
+static const unsigned NumBruteForceRays = 500;
+static const Real MaxDistance = 100000.f;
+
+class RayCastTest::Impl {
+public:
+	std::vector<Vec3> mPositions;
+	std::vector<ModelTriangle> mTriangles;
+	std::vector<Ray> mRays;
+
+	Impl() {
+		BuildMesh();
+		auto bvh = TriangleBVH::Create();
+		INT64 buildTime = 0;
+		{
+			ProfilerSimple p("Build");
+			bvh->Build(&mPositions[0], &mTriangles[0], mTriangles.size());
+			buildTime = p.GetDTMicro();
+		}
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"%u triangles: built in %lld us, %u nodes, depth %u, %u KB",
+			(unsigned)mTriangles.size(), buildTime, bvh->GetNumNodes(), bvh->GetDepth(),
+			(unsigned)(bvh->GetMemoryUsage() / 1024)).c_str());
+
+		// Incoherent rays from the surrounding box towards the mesh.
+		RandomGenerator random(1);
+		mRays.reserve(NumRays);
+		for (unsigned i = 0; i < NumRays; ++i) {
+			auto origin = random.Next(Vec3(-50, -50, -50), Vec3(50, 50, 50));
+			auto target = random.Next(Vec3(-SphereRadius), Vec3(SphereRadius));
+			mRays.push_back(Ray(origin, (target - origin).NormalizeCopy()));
+		}
+
+		std::vector<int> bruteHits(NumBruteForceRays);
+		std::vector<Real> bruteT(NumBruteForceRays);
+		INT64 bruteTime = 0;
+		{
+			ProfilerSimple p("BruteForce");
+			for (unsigned i = 0; i < NumBruteForceRays; ++i) {
+				bruteHits[i] = BruteForce(mRays[i], bruteT[i]);
+			}
+			bruteTime = p.GetDTMicro();
+		}
+
+		std::vector<int> hits(NumRays);
+		std::vector<Real> t(NumRays);
+		INT64 singleTime = 0;
+		{
+			ProfilerSimple p("Single");
+			for (unsigned i = 0; i < NumRays; ++i) {
+				hits[i] = bvh->RayCast(&mTriangles[0], mRays[i], MaxDistance, t[i]);
+			}
+			singleTime = p.GetDTMicro();
+		}
+		unsigned mismatches = 0;
+		for (unsigned i = 0; i < NumBruteForceRays; ++i) {
+			if ((bruteHits[i] == -1) != (hits[i] == -1) ||
+				(hits[i] != -1 && abs(bruteT[i] - t[i]) > 0.001f))
+				++mismatches;
+		}
+
+		std::vector<int> packetHits(NumRays);
+		std::vector<Real> packetT(NumRays);
+		INT64 packetTime = 0;
+		{
+			ProfilerSimple p("Packet");
+			bvh->RayCast(&mTriangles[0], &mRays[0], NumRays, MaxDistance, &packetHits[0], &packetT[0]);
+			packetTime = p.GetDTMicro();
+		}
+		for (unsigned i = 0; i < NumRays; ++i) {
+			if (packetHits[i] != hits[i])
+				++mismatches;
+		}
+
+		// Coherent rays as picking many points from one camera.
+		for (auto& ray : mRays) {
+			auto target = random.Next(Vec3(-SphereRadius), Vec3(SphereRadius));
+			ray = Ray(Vec3(0, -40, 0), (target - Vec3(0, -40, 0)).NormalizeCopy());
+		}
+		INT64 coherentSingleTime = 0, coherentPacketTime = 0;
+		{
+			ProfilerSimple p("CoherentSingle");
+			for (unsigned i = 0; i < NumRays; ++i) {
+				hits[i] = bvh->RayCast(&mTriangles[0], mRays[i], MaxDistance, t[i]);
+			}
+			coherentSingleTime = p.GetDTMicro();
+		}
+		{
+			ProfilerSimple p("CoherentPacket");
+			bvh->RayCast(&mTriangles[0], &mRays[0], NumRays, MaxDistance, &packetHits[0], &packetT[0]);
+			coherentPacketTime = p.GetDTMicro();
+		}
+		for (unsigned i = 0; i < NumRays; ++i) {
+			if (packetHits[i] != hits[i])
+				++mismatches;
+		}
+
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"Brute force %.2f us/ray, BVH %.3f us/ray, packet %.3f us/ray, coherent BVH %.3f us/ray, coherent packet %.3f us/ray",
+			bruteTime / (double)NumBruteForceRays, singleTime / (double)NumRays, packetTime / (double)NumRays,
+			coherentSingleTime / (double)NumRays, coherentPacketTime / (double)NumRays).c_str());
+		if (mismatches)
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("%u ray cast results do not match.", mismatches).c_str());
+		else
+			Logger::Log(FB_DEFAULT_LOG_ARG, "Ray cast results match.");
+	}
+
+	int BruteForce(const Ray& ray, Real& outT) {
+		int hit = -1;
+		Real best = MaxDistance;
+		for (unsigned i = 0; i < mTriangles.size(); ++i) {
+			Real t;
+			if (GeomUtils::IntersectRayTriangle(ray.GetOrigin(), ray.GetDir(), mTriangles[i], best, t)) {
+				best = t;
+				hit = i;
+			}
+		}
+		outT = best;
+		return hit;
+	}
+
+	/// Bumpy sphere so the triangles have different sizes and orientations.
+	void BuildMesh() {
+		const unsigned numRings = NumSegments / 2;
+		for (unsigned r = 0; r <= numRings; ++r) {
+			float theta = PI * r / numRings;
+			for (unsigned s = 0; s <= NumSegments; ++s) {
+				float phi = TWO_PI * s / NumSegments;
+				float bump = 1.f + 0.05f * sin(7.f * phi) * sin(5.f * theta);
+				mPositions.push_back(Vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)) * SphereRadius * bump);
+			}
+		}
+		for (unsigned r = 0; r < numRings; ++r) {
+			for (unsigned s = 0; s < NumSegments; ++s) {
+				unsigned a = r * (NumSegments + 1) + s;
+				unsigned b = a + NumSegments + 1;
+				unsigned tris[2][3] = { { a, b, a + 1 }, { a + 1, b, b + 1 } };
+				for (auto& tri : tris) {
+					ModelTriangle m;
+					m.v[0] = tri[0];
+					m.v[1] = tri[1];
+					m.v[2] = tri[2];
+					GeomUtils::ComputeModelTriangle(&mPositions[0], m);
+					mTriangles.push_back(m);
+				}
+			}
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(RayCastTest);
+
+RayCastTest::RayCastTest()
+	: mImpl(new Impl)
+{
+}
+
+RayCastTest::~RayCastTest() {
+}
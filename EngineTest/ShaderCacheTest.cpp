@@ -0,0 +1,250 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "ShaderCacheTest.h"
+#include "FBRenderer/ShaderCache.h"
+#include "FBRenderer/NullShaderCompiler.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+#include <thread>
+#include <atomic>
+using namespace fb;
+
+static const unsigned NumBackgroundPermutations = 8;
+static const unsigned CompileDelayMs = 20;
+static const unsigned NumQueueingThreads = 8;
+static const unsigned NumQueuedPermutations = 64;
+
+class ShaderCacheTest::Impl {
+public:
+	std::string mDirectory;
+	std::string mShaderFile;
+	std::string mIncludeFile;
+	std::string mCacheFile;
+	unsigned mNumFailed;
+
+	Impl()
+		: mNumFailed(0)
+	{
+		mDirectory = FileSystem::GetTempDir() + "ShaderCacheTest/";
+		FileSystem::RemoveAll(mDirectory.c_str());
+		mShaderFile = mDirectory + "ShaderCacheTest.hlsl";
+		mIncludeFile = mDirectory + "ShaderCacheTestInclude.h";
+		mCacheFile = mDirectory + "test.shadercache";
+		FileSystem::CreateDirectory(mCacheFile.c_str());
+		WriteText(mIncludeFile, "#pragma once\nfloat4 gColor;\n");
+		WriteText(mShaderFile,
+			"#include \"ShaderCacheTestInclude.h\"\n"
+			"#include \"ShaderCacheTestInclude.h\"\n"
+			"float4 ShaderCacheTest_VertexShader(float4 pos : POSITION) : SV_Position { return pos; }\n"
+			"float4 ShaderCacheTest_PixelShader() : SV_Target { return gColor; }\n");
+
+		TestColdAndPacked();
+		TestBackground();
+		TestWarmUp();
+		TestInvalidation();
+		TestQueueingFromThreads();
+		TestLoadingFromThreads();
+		FileSystem::RemoveAll(mDirectory.c_str());
+		if (mNumFailed == 0)
+			Logger::Log(FB_DEFAULT_LOG_ARG, "ShaderCacheTest passed.");
+		else
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("ShaderCacheTest: %u checks failed.", mNumFailed).c_str());
+	}
+
+	void WriteText(const std::string& path, const char* text) {
+		FileSystem::WriteTextFile(path.c_str(), text, strlen(text));
+	}
+
+	void Check(bool condition, const char* what) {
+		if (!condition) {
+			++mNumFailed;
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("ShaderCacheTest: %s failed.", what).c_str());
+		}
+	}
+
+	SHADER_DEFINES Defines(unsigned i) {
+		SHADER_DEFINES defines;
+		defines.push_back(ShaderDefine("_PERMUTATION", FormatString("%u", i).c_str()));
+		return defines;
+	}
+
+	void TestColdAndPacked() {
+		ByteArray vs, ps;
+		{
+			auto compiler = NullShaderCompiler::Create();
+			auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+			StringVector relatedFiles;
+			vs = cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(0), &relatedFiles);
+			ps = cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(0), 0);
+			Check(!vs.empty() && !ps.empty() && vs != ps, "Cold compile");
+			Check(relatedFiles.size() == 2 && relatedFiles[0] == mShaderFile, "Related files");
+			cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(0), 0);
+			Check(compiler->GetNumCompiled() == 2, "Compiling once per permutation");
+			Check(cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_GS, Defines(0), 0).empty(),
+				"Missing entry point");
+			Check(cache->Save(false), "Save");
+		}
+		auto compiler = NullShaderCompiler::Create();
+		auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+		Check(cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(0), 0) == vs &&
+			cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(0), 0) == ps,
+			"Reading the packed file");
+		Check(compiler->GetNumCompiled() == 0 && cache->GetStats().mHits == 2, "Packed hits");
+	}
+
+	void TestBackground() {
+		auto compiler = NullShaderCompiler::Create();
+		compiler->SetDelay(CompileDelayMs);
+		auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+		ProfilerSimple p("Background compiling");
+		for (unsigned i = 1; i <= NumBackgroundPermutations; ++i) {
+			cache->CompileInBackground(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(i));
+		}
+		// already packed
+		cache->CompileInBackground(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(0));
+		auto queueTime = p.GetDTMicro();
+		for (unsigned i = 1; i <= NumBackgroundPermutations; ++i) {
+			cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(i), 0);
+		}
+		auto totalTime = p.GetDTMicro();
+		Check(compiler->GetNumCompiled() == NumBackgroundPermutations, "Background compiling");
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+			"ShaderCacheTest: %u permutations(%u ms each) queued in %lld us, done in %lld us",
+			NumBackgroundPermutations, CompileDelayMs, queueTime, totalTime).c_str());
+		Check(cache->Save(false), "Save");
+	}
+
+	void TestWarmUp() {
+		// the pack is lost but the manifest remains.
+		FileSystem::Remove(mCacheFile.c_str());
+		auto compiler = NullShaderCompiler::Create();
+		auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+		auto numQueued = cache->WarmUp();
+		cache->WaitBackgroundCompiling();
+		Check(numQueued == NumBackgroundPermutations + 2, "Warming up from the manifest");
+		cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(0), 0);
+		cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(NumBackgroundPermutations), 0);
+		Check(cache->GetStats().mMisses == 0, "Hits after warming up");
+		Check(cache->Save(true), "Save pruning unused");
+	}
+
+	void TestInvalidation() {
+		auto compiler = NullShaderCompiler::Create();
+		auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+		Check(cache->GetStats().mNumPacked == 2, "Pruning unused");
+		// kept by the pruning
+		auto before = cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(NumBackgroundPermutations), 0);
+		WriteText(mIncludeFile, "#pragma once\nfloat4 gColor2;\n#define gColor gColor2\n");
+		cache->InvalidateSource(mIncludeFile.c_str());
+		auto after = cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(NumBackgroundPermutations), 0);
+		Check(compiler->GetNumCompiled() == 1 && before != after, "Invalidating by the include file");
+
+		auto compiler2 = NullShaderCompiler::Create();
+		compiler2->SetVersion("null_2");
+		auto cache2 = ShaderCache::Create(mCacheFile.c_str(), compiler2);
+		cache2->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(0), 0);
+		Check(compiler2->GetNumCompiled() == 1, "Invalidating by the compiler version");
+	}
+
+	void TestQueueingFromThreads() {
+		auto compiler = NullShaderCompiler::Create();
+		compiler->SetDelay(CompileDelayMs);
+		auto cache = ShaderCache::Create(mCacheFile.c_str(), compiler);
+		// Reads the source here so the threads only find the same permutations.
+		cache->CompileInBackground(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(1));
+		std::atomic<unsigned> numReady(0);
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < NumQueueingThreads; ++t) {
+			threads.push_back(std::thread([&]() {
+				++numReady;
+				while (numReady < NumQueueingThreads)
+					std::this_thread::yield();
+				for (unsigned i = 1; i <= NumQueuedPermutations; ++i) {
+					cache->CompileInBackground(mShaderFile.c_str(), SHADER_TYPE_VS, Defines(i));
+				}
+			}));
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		cache->WaitBackgroundCompiling();
+		Check(compiler->GetNumCompiled() == NumQueuedPermutations, "Queueing from several threads");
+	}
+
+	/// Like the asset loading workers: reading the source, queueing, waiting
+	/// for queued permutations and recording them all run on several threads.
+	void TestLoadingFromThreads() {
+		auto cacheFile = mDirectory + "threads.shadercache";
+		{
+			auto compiler = NullShaderCompiler::Create();
+			compiler->SetDelay(CompileDelayMs);
+			auto cache = ShaderCache::Create(cacheFile.c_str(), compiler);
+			std::atomic<unsigned> numReady(0);
+			std::atomic<unsigned> numEmpty(0);
+			std::vector<std::thread> threads;
+			for (unsigned t = 0; t < NumQueueingThreads; ++t) {
+				threads.push_back(std::thread([&, t]() {
+					++numReady;
+					while (numReady < NumQueueingThreads)
+						std::this_thread::yield();
+					for (unsigned i = 1; i <= NumQueuedPermutations; ++i) {
+						if ((i + t) % 2 == 0)
+							cache->CompileInBackground(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(i));
+						else if (cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(i), 0).empty())
+							++numEmpty;
+					}
+				}));
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			cache->WaitBackgroundCompiling();
+			Check(numEmpty == 0 && compiler->GetNumCompiled() == NumQueuedPermutations,
+				"Loading from several threads");
+			Check(cache->Save(true), "Save");
+		}
+		auto compiler = NullShaderCompiler::Create();
+		auto cache = ShaderCache::Create(cacheFile.c_str(), compiler);
+		for (unsigned i = 1; i <= NumQueuedPermutations; ++i) {
+			cache->GetByteCode(mShaderFile.c_str(), SHADER_TYPE_PS, Defines(i), 0);
+		}
+		Check(compiler->GetNumCompiled() == 0, "Recording from several threads");
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(ShaderCacheTest);
+
+ShaderCacheTest::ShaderCacheTest()
+	: mImpl(new Impl)
+{
+}
+
+ShaderCacheTest::~ShaderCacheTest() {
+}
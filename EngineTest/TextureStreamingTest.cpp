@@ -0,0 +1,227 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "TextureStreamingTest.h"
+#include "FBRenderer/TextureStreamer.h"
+#include "FBRenderer/NullPlatformRenderer.h"
+#include "FBRenderer/IPlatformTexture.h"
+using namespace fb;
+
+static const int TextureSize = 1024;
+static const int NumTextures = 4;
+
+class TextureStreamingTest::Impl {
+public:
+	NullPlatformRendererPtr mPlatformRenderer;
+	TextureStreamerPtr mStreamer;
+	// stands for the Texture objects of the Renderer.
+	std::unordered_map<std::string, IPlatformTexturePtr> mTextures;
+	TextureMipChain mMipChain;
+	unsigned mNumReplaced;
+	unsigned mNumFailed;
+
+	Impl()
+		: mPlatformRenderer(NullPlatformRenderer::Create())
+		, mNumReplaced(0)
+		, mNumFailed(0)
+	{
+		// RGBA8 mips down to 1x1
+		mMipChain.mWidth = TextureSize;
+		mMipChain.mHeight = TextureSize;
+		for (int size = TextureSize; size > 0; size >>= 1) {
+			mMipChain.mMipSizes.push_back(size * size * 4);
+		}
+		for (int i = 0; i < NumTextures * 2; ++i) {
+			mPlatformRenderer->AddTextureMipChain(GetPath(i).c_str(), mMipChain);
+		}
+		TextureMipChain smallChain;
+		smallChain.mWidth = smallChain.mHeight = 32;
+		for (int size = 32; size > 0; size >>= 1) {
+			smallChain.mMipSizes.push_back(size * size * 4);
+		}
+		mPlatformRenderer->AddTextureMipChain("small.dds", smallChain);
+
+		auto pimpl = this;
+		mStreamer = TextureStreamer::Create(GetCoarseSize() * NumTextures,
+			[pimpl](const char* path, IPlatformTexturePtr prev, IPlatformTexturePtr cur) {
+				auto& texture = pimpl->mTextures[path];
+				pimpl->Check(texture == prev, "Replacing the resident texture");
+				texture = cur;
+				++pimpl->mNumReplaced;
+			});
+
+		TestCoarseMipsFirst();
+		TestPriority();
+		TestEviction();
+		TestReportTimeout();
+		TestMaxLoadings();
+		TestRelease();
+		if (mNumFailed == 0)
+			Logger::Log(FB_DEFAULT_LOG_ARG, "TextureStreamingTest passed.");
+		else
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("TextureStreamingTest: %u checks failed.", mNumFailed).c_str());
+	}
+
+	void Check(bool condition, const char* what) {
+		if (!condition) {
+			++mNumFailed;
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("TextureStreamingTest: %s failed.", what).c_str());
+		}
+	}
+
+	std::string GetPath(int i) {
+		return FormatString("texture%d.dds", i);
+	}
+
+	int GetMinResidentMip() {
+		int mip = 0;
+		while ((TextureSize >> mip) > TextureStreamer::MinResidentSize)
+			++mip;
+		return mip;
+	}
+
+	size_t GetSize(int firstMip) {
+		size_t size = 0;
+		for (size_t i = firstMip; i < mMipChain.mMipSizes.size(); ++i) {
+			size += mMipChain.mMipSizes[i];
+		}
+		return size;
+	}
+
+	size_t GetCoarseSize() {
+		return GetSize(GetMinResidentMip());
+	}
+
+	// loads are ready at once with the null renderer. The second update swaps them.
+	void Update() {
+		mStreamer->Update(*mPlatformRenderer);
+		mStreamer->Update(*mPlatformRenderer);
+	}
+
+	void TestCoarseMipsFirst() {
+		TextureCreationOption options;
+		for (int i = 0; i < NumTextures; ++i) {
+			auto path = GetPath(i);
+			mTextures[path] = mStreamer->CreateTexture(*mPlatformRenderer, path.c_str(), options);
+			Check(mTextures[path] && mStreamer->GetResidentMip(path.c_str()) == GetMinResidentMip(),
+				"Creating the coarse mips");
+		}
+		int coarseSize = TextureStreamer::MinResidentSize;
+		Check(mTextures[GetPath(0)]->GetSize() == Vec2ITuple(coarseSize, coarseSize), "Size of the coarse mips");
+		Check(!mStreamer->CreateTexture(*mPlatformRenderer, "small.dds", options), "Not streaming small textures");
+		Check(!mStreamer->CreateTexture(*mPlatformRenderer, "unknown.dds", options), "Not streaming unknown files");
+		auto stats = mStreamer->GetStats();
+		Check(stats.mNumTextures == NumTextures && stats.mResidentBytes == GetCoarseSize() * NumTextures,
+			"Resident bytes of the coarse mips");
+	}
+
+	void ReportScreenSizes() {
+		mStreamer->ReportScreenSize(GetPath(0).c_str(), (Real)TextureSize);
+		mStreamer->ReportScreenSize(GetPath(1).c_str(), 200.f);
+		// the largest report is used.
+		mStreamer->ReportScreenSize(GetPath(1).c_str(), 100.f);
+		for (int i = 2; i < NumTextures; ++i) {
+			mStreamer->ReportScreenSize(GetPath(i).c_str(), 10.f);
+		}
+	}
+
+	void TestPriority() {
+		// enough for the full chain of texture0 and 256x256 of texture1.
+		auto coarseSize = GetCoarseSize();
+		mStreamer->SetBudget(coarseSize * NumTextures + GetSize(0) - coarseSize + GetSize(2) - coarseSize);
+		ReportScreenSizes();
+		Update();
+		Check(mStreamer->GetResidentMip(GetPath(0).c_str()) == 0, "Full mips for the largest texture");
+		Check(mStreamer->GetResidentMip(GetPath(1).c_str()) == 2, "Mips covering the screen size");
+		Check(mStreamer->GetResidentMip(GetPath(2).c_str()) == GetMinResidentMip(), "Coarse mips for small ones");
+		Check(mNumReplaced == 2, "Replace callback");
+		auto stats = mStreamer->GetStats();
+		Check(stats.mResidentBytes <= stats.mBudget && stats.mNumLoaded == 2, "Resident bytes within the budget");
+
+		auto numCreated = mPlatformRenderer->GetCallCounts().mCreateTexture;
+		ReportScreenSizes();
+		Update();
+		Check(mPlatformRenderer->GetCallCounts().mCreateTexture == numCreated, "No loads when settled");
+	}
+
+	void TestEviction() {
+		// texture0 does not fit anymore. texture1 loses the budget.
+		auto coarseSize = GetCoarseSize();
+		mStreamer->SetBudget(coarseSize * NumTextures + GetSize(1) - coarseSize);
+		ReportScreenSizes();
+		Update();
+		Check(mStreamer->GetResidentMip(GetPath(0).c_str()) == 1, "Dropping the finest mip");
+		Check(mStreamer->GetResidentMip(GetPath(1).c_str()) == GetMinResidentMip(), "Evicting lower priority");
+		auto stats = mStreamer->GetStats();
+		Check(stats.mResidentBytes <= stats.mBudget && stats.mNumEvicted == 2, "Resident bytes after eviction");
+	}
+
+	void TestReportTimeout() {
+		mStreamer->SetBudget(GetSize(0) * NumTextures * 2);
+		TextureCreationOption options;
+		auto path = GetPath(NumTextures);
+		mTextures[path] = mStreamer->CreateTexture(*mPlatformRenderer, path.c_str(), options);
+		for (unsigned i = 0; i <= TextureStreamer::ReportTimeout; ++i) {
+			mStreamer->Update(*mPlatformRenderer);
+		}
+		Update();
+		Check(mStreamer->GetResidentMip(GetPath(0).c_str()) == GetMinResidentMip(), "Coarse mips when not visible");
+		Check(mStreamer->GetResidentMip(path.c_str()) == 0, "Full mips for textures never reported");
+	}
+
+	void TestMaxLoadings() {
+		TextureCreationOption options;
+		for (int i = NumTextures + 1; i < NumTextures * 2; ++i) {
+			auto path = GetPath(i);
+			mTextures[path] = mStreamer->CreateTexture(*mPlatformRenderer, path.c_str(), options);
+		}
+		for (int i = 0; i < NumTextures * 2; ++i) {
+			mStreamer->ReportScreenSize(GetPath(i).c_str(), (Real)TextureSize);
+		}
+		mStreamer->Update(*mPlatformRenderer);
+		Check(mStreamer->GetStats().mNumLoading == TextureStreamer::MaxLoadings, "Limiting the loads in flight");
+	}
+
+	void TestRelease() {
+		auto numTextures = mStreamer->GetStats().mNumTextures;
+		mTextures.erase(GetPath(0));
+		Update();
+		Check(mStreamer->GetStats().mNumTextures == numTextures - 1, "Forgetting released textures");
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(TextureStreamingTest);
+
+TextureStreamingTest::TextureStreamingTest()
+	: mImpl(new Impl)
+{
+}
+
+TextureStreamingTest::~TextureStreamingTest() {
+}
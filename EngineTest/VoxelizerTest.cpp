@@ -0,0 +1,95 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "VoxelizerTest.h"
+#include "FBEngineFacade/Voxelizer.h"
+#include "FBMathLib/VoxelVolume.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+using namespace fb;
+
+static const unsigned NumSegments = 256;
+static const float SphereRadius = 10.f;
+
+class VoxelizerTest::Impl {
+public:
+	std::vector<Vec3> mPositions;
+	std::vector<unsigned> mIndices;
+
+	Impl() {
+		BuildSphere();
+		const unsigned numTriangles = mIndices.size() / 3;
+		const unsigned gridSizes[] = { 64, 256, 1024 };
+		for (auto numVoxels : gridSizes) {
+			auto voxelizer = Voxelizer::Create();
+			INT64 time = 0;
+			{
+				ProfilerSimple p("Voxelize");
+				voxelizer->RunVoxelizer(&mPositions[0], mPositions.size(), &mIndices[0], mIndices.size(), numVoxels);
+				time = p.GetDTMicro();
+			}
+			auto volume = voxelizer->GetVolume();
+			double seconds = std::max(time, (INT64)1) / 1000000.0;
+			double numCells = (double)numVoxels * numVoxels * numVoxels;
+			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
+				"%u^3 grid, %u triangles: %lld us, %.1f M voxels/s, %.1f K triangles/s, %u stored bricks, %u KB, %u hull voxels",
+				numVoxels, numTriangles, time, numCells / seconds / 1000000.0, numTriangles / seconds / 1000.0,
+				volume->GetNumStoredBricks(), (unsigned)(volume->GetMemoryUsage() / 1024),
+				(unsigned)voxelizer->GetHulls().size()).c_str());
+		}
+	}
+
+	void BuildSphere() {
+		const unsigned numRings = NumSegments / 2;
+		for (unsigned r = 0; r <= numRings; ++r) {
+			float theta = PI * r / numRings;
+			for (unsigned s = 0; s <= NumSegments; ++s) {
+				float phi = TWO_PI * s / NumSegments;
+				mPositions.push_back(Vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)) * SphereRadius);
+			}
+		}
+		for (unsigned r = 0; r < numRings; ++r) {
+			for (unsigned s = 0; s < NumSegments; ++s) {
+				unsigned a = r * (NumSegments + 1) + s;
+				unsigned b = a + NumSegments + 1;
+				unsigned tri[] = { a, b, a + 1, a + 1, b, b + 1 };
+				mIndices.insert(mIndices.end(), tri, tri + 6);
+			}
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(VoxelizerTest);
+
+VoxelizerTest::VoxelizerTest()
+	: mImpl(new Impl)
+{
+}
+
+VoxelizerTest::~VoxelizerTest() {
+}
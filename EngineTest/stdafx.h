@@ -50,6 +50,7 @@
 // TODO: reference additional headers your program requires here
 #define FB_DLL_TIMER __declspec(dllimport)
 #define FB_DLL_SCENEMANAGER __declspec(dllimport)
+#define FB_DLL_SCENEOBJECTFACTORY __declspec(dllimport)
 #define FB_DLL_ENGINEFACADE __declspec(dllimport)
 #define FB_DLL_AUDIOPLAYER __declspec(dllimport)
 #define FB_DLL_VIDEOPLAYER __declspec(dllimport)
@@ -57,6 +58,8 @@
 #define FB_DLL_LUA __declspec(dllimport)
 #define FB_DLL_RENDERER __declspec(dllimport)
 #define FB_DLL_THREAD __declspec(dllimport)
+#define FB_DLL_PHYSICS __declspec(dllimport)
+#define FB_DLL_NETWORK __declspec(dllimport)
 #include "FBTimer/Timer.h"
 #include "FBMathLib/Math.h"
 #include "FBStringLib/StringLib.h"
@@ -57,6 +57,13 @@ struct a2v
 	float3 Normal : NORMAL;
 	float2 UV		: TEXCOORD;
 	float3 Tangent : TANGENT;
+#ifdef _INSTANCED
+	// rows of the world matrix. per instance data.
+	float4 World0 : WORLD0;
+	float4 World1 : WORLD1;
+	float4 World2 : WORLD2;
+	float4 World3 : WORLD3;
+#endif
 };
 
 struct v2p 
@@ -73,15 +80,24 @@ struct v2p
 v2p MeshPBR_VertexShader( in a2v INPUT )
 {
     v2p OUTPUT;
+#ifdef _INSTANCED
+	float4x4 world = float4x4(INPUT.World0, INPUT.World1, INPUT.World2, INPUT.World3);
+	float4x4 worldView = mul(gView, world);
+	float4x4 worldViewProj = mul(gViewProj, world);
+#else
+	float4x4 world = gWorld;
+	float4x4 worldView = gWorldView;
+	float4x4 worldViewProj = gWorldViewProj;
+#endif
 
-	OUTPUT.Position = mul( gWorldViewProj, INPUT.Position );
-	OUTPUT.Normal = normalize(mul((float3x3)gWorld, INPUT.Normal));
+	OUTPUT.Position = mul( worldViewProj, INPUT.Position );
+	OUTPUT.Normal = normalize(mul((float3x3)world, INPUT.Normal));
 	OUTPUT.UV = INPUT.UV;
-	OUTPUT.Tangent = normalize(mul((float3x3)gWorld, INPUT.Tangent));
+	OUTPUT.Tangent = normalize(mul((float3x3)world, INPUT.Tangent));
 	OUTPUT.Binormal= normalize(cross(OUTPUT.Tangent, OUTPUT.Normal));
-	float3 worldPos = mul(gWorld, INPUT.Position).xyz;
+	float3 worldPos = mul(world, INPUT.Position).xyz;
 	OUTPUT.WorldPos.xyz = worldPos;
-	OUTPUT.WorldPos.w = mul(gWorldView, INPUT.Position).y;
+	OUTPUT.WorldPos.w = mul(worldView, INPUT.Position).y;
 	OUTPUT.TexShadow = mul(gLightView, float4(worldPos, 1.0));
 
 	return OUTPUT;
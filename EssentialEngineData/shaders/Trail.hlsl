@@ -41,12 +41,16 @@ Texture2D  gDiffuseTexture : register(t0);
 //----------------------------------------------------------------------------
 struct a2v
 {
-	float4 pos		: POSITION; // pos.w : is alpha (length)
+	float4 pos		: POSITION; // pos.w : time when the point was added
+	float3 width_invLife_inner : TEXCOORD0;
+	float4 color	: COLOR0;
 };
 
 struct v2g
 {
-	float4 pos : TEXTURE0; // pos.w : is u (length)
+	float4 pos : TEXTURE0; // pos.w : alpha
+	float2 width_inner : TEXTURE1;
+	float4 color : COLOR0;
 };
 
 //----------------------------------------------------------------------------
@@ -54,13 +58,17 @@ struct g2p
 {
 	float4 pos		: SV_Position;
 	float3 uv		: TEXCOORD; // z is alpha
+	float4 color	: COLOR0;
 };
 
 //----------------------------------------------------------------------------
 v2g Trail_VertexShader( in a2v IN )
 {
     v2g OUT;
-	OUT.pos = IN.pos;
+	float age = gTime - IN.pos.w;
+	OUT.pos = float4(IN.pos.xyz, saturate(1.0 - age * IN.width_invLife_inner.y));
+	OUT.width_inner = IN.width_invLife_inner.xz;
+	OUT.color = IN.color;
 
 	return OUT;
 }
@@ -71,35 +79,38 @@ v2g Trail_VertexShader( in a2v IN )
 [maxvertexcount(4)]
 void Trail_GeometryShader(lineadj v2g In[4], inout TriangleStream<g2p> streamObj)
 {
+	// Every trail is in one strip. The first and the last point of a trail
+	// only give the direction, so segments touching them are skipped.
+	if (In[1].width_inner.y * In[2].width_inner.y == 0)
+		return;
+
 	float3 camPos = {gCamTransform[0][3], gCamTransform[1][3], gCamTransform[2][3]};
 	float3 toCam = normalize(camPos - In[1].pos.xyz);
 	float3 lineDirPrev = normalize(In[1].pos.xyz - In[0].pos.xyz);
-	float3 up0 = normalize(cross(toCam, lineDirPrev));
+	float3 up0 = normalize(cross(toCam, lineDirPrev)) * In[1].width_inner.x;
 	
 	float3 lineDirCur = normalize(In[3].pos.xyz - In[2].pos.xyz);
-	float3 up1 = normalize(cross(toCam, lineDirCur))	;
+	float3 up1 = normalize(cross(toCam, lineDirCur)) * In[2].width_inner.x;
 	
 	// 1    3
 	//
 	// 0    2
-	float width = gShaderParams[0].x;
-	
 	g2p OUTPUT;
-	OUTPUT.pos = mul(gViewProj, float4(In[1].pos.xyz - up0 * width, 1));
-	float u = In[1].pos.w;
+	OUTPUT.color = In[1].color;
+	OUTPUT.pos = mul(gViewProj, float4(In[1].pos.xyz - up0, 1));
 	OUTPUT.uv = float3(0, 1, In[1].pos.w);
 	streamObj.Append(OUTPUT);
 	
-	OUTPUT.pos = mul(gViewProj, float4(In[1].pos.xyz + up0 * width, 1));
+	OUTPUT.pos = mul(gViewProj, float4(In[1].pos.xyz + up0, 1));
 	OUTPUT.uv = float3(0, 0, In[1].pos.w);
 	streamObj.Append(OUTPUT);
 	
-	OUTPUT.pos = mul(gViewProj, float4(In[2].pos.xyz - up1 * width, 1));
-	u = In[2].pos.w;
+	OUTPUT.color = In[2].color;
+	OUTPUT.pos = mul(gViewProj, float4(In[2].pos.xyz - up1, 1));
 	OUTPUT.uv = float3(0, 1, In[2].pos.w);
 	streamObj.Append(OUTPUT);
 	
-	OUTPUT.pos = mul(gViewProj, float4(In[2].pos.xyz + up1 * width, 1));
+	OUTPUT.pos = mul(gViewProj, float4(In[2].pos.xyz + up1, 1));
 	OUTPUT.uv = float3(0, 0, In[2].pos.w);
 	streamObj.Append(OUTPUT);
 	
@@ -118,8 +129,8 @@ struct PS_OUT
 
 PS_OUT Trail_PixelShader(in g2p IN) : SV_Target
 {
-	float4 outColor = gDiffuseColor;
-	outColor.a = IN.uv.z;
+	float4 outColor = gDiffuseColor * IN.color;
+	outColor.a = IN.uv.z * IN.color.a;
 #ifdef DIFFUSE_TEXTURE
 	outColor *= gDiffuseTexture.Sample(gLinearSampler, IN.uv.xy);
 #endif
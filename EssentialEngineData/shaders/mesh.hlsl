@@ -46,6 +46,13 @@ struct a2v
 #ifdef DIFFUSE_TEXTURE
 	float2 UV		: TEXCOORD;
 #endif
+#ifdef _INSTANCED
+	// rows of the world matrix. per instance data.
+	float4 World0 : WORLD0;
+	float4 World1 : WORLD1;
+	float4 World2 : WORLD2;
+	float4 World3 : WORLD3;
+#endif
 };
 
 struct v2p 
@@ -61,9 +68,16 @@ v2p Mesh_VertexShader( in a2v INPUT )
 {
     v2p OUTPUT;
 
-	//float4 worldPos = mul( gWorld, INPUT.Position);
-	OUTPUT.Position = mul( gWorldViewProj, INPUT.Position );
-	OUTPUT.Normal = mul((float3x3)gWorld, INPUT.Normal);
+#ifdef _INSTANCED
+	float4x4 world = float4x4(INPUT.World0, INPUT.World1, INPUT.World2, INPUT.World3);
+	float4x4 worldViewProj = mul(gViewProj, world);
+#else
+	float4x4 world = gWorld;
+	float4x4 worldViewProj = gWorldViewProj;
+#endif
+	//float4 worldPos = mul( world, INPUT.Position);
+	OUTPUT.Position = mul( worldViewProj, INPUT.Position );
+	OUTPUT.Normal = mul((float3x3)world, INPUT.Normal);
 #ifdef DIFFUSE_TEXTURE
   #ifdef FLIP_Y_TEXTURE
   OUTPUT.UV = float2(INPUT.UV.x, 1.f-INPUT.UV.y);
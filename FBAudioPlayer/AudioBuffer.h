@@ -27,13 +27,15 @@
 
 #pragma once
 #include "FBCommonHeaders/Types.h"
+#include <atomic>
 namespace fb{
 	FB_DECLARE_SMART_PTR_STRUCT(AudioBuffer);
 	struct AudioBuffer{
 		std::string mFilepath;
-		INT64 mLastAccessed;
+		// touched by the game thread and the audio thread.
+		std::atomic<INT64> mLastAccessed;
 		unsigned mBuffer; // ALuint
-		unsigned mReferences;
+		std::atomic<unsigned> mReferences;
 		TIME_PRECISION mLength;
 
 		AudioBuffer();
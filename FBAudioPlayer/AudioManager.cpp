@@ -33,17 +33,30 @@
 #include "AudioSourceStatus.h"
 #include "AudioBuffer.h"
 #include "AudioSource.h"
+#include "AudioStream.h"
+#include "AudioStreamer.h"
+#include "VoiceHeap.h"
 #include "FBCommonHeaders/SpinLock.h"
-#include "FBCommonHeaders/RecursiveSpinLock.h"
+#include "FBCommonHeaders/LockFreeRing.h"
 #include "FBCommonHeaders/VectorMap.h"
 #include "FBCommonHeaders/Helpers.h"
 #include "FBCommonHeaders/ProfilerSimple.h"
+#include "FBStringLib/StringId.h"
 
 using namespace fb;
 
 std::atomic<AudioId> NextAudioId = 1;
 AudioManager* sAudioManagerRaw = 0;
 std::atomic<bool> sDeinitialized = false;
+// Voices quieter than this are always virtual.
+static const float InaudibleGain = 0.001f;
+// A virtual voice takes the source of a real one only when it is
+// this much louder, so voices near the boundary do not flip every update.
+static const float StealRatio = 1.25f;
+static const TIME_PRECISION ResumeFadeInSec = 0.5f;
+// Music and Ogg files at least this big are streamed instead of being
+// decoded into one buffer.
+static const long StreamingMinFileSize = 512 * 1024;
 
 namespace fb{
 	static void eos_callback(void *userData, ALuint source);
@@ -77,45 +90,72 @@ class AudioManager::Impl{
 public:
 	static const int MaximumAudioSources = 24;
 	static const int NumReservedAudioSources = 8;
-	static const unsigned NumSortPerFrame = 10;
+	static const unsigned CommandRingSize = 8192;
+	static const unsigned InvalidatedIdsSize = 8192;
+	// The audio thread drains the command ring at this interval
+	// between its regular updates.
+	static const int CommandPollMs = 5;
 	ALCdevice* mDevice;
 	ALCcontext* mContext;
 	static LPALGETSOURCEDVSOFT alGetSourcedvSOFT;
-	std::unordered_map<std::string, AudioBufferPtr> mAudioBuffers;	
+	typedef std::unordered_map<StringId, AudioBufferPtr> AudioBuffers;
+	typedef std::shared_ptr<const AudioBuffers> AudioBuffersPtr;
+	// case insensitive path id - buffer. Copy on write, so readers only load the
+	// current snapshot. Writers serialize with mAudioBuffersWriteLock.
+	AudioBuffersPtr mAudioBuffers;
+	CriticalSection mAudioBuffersWriteLock;
+	struct StreamInfo{
+		bool mStream;
+		// Negative until a stream is opened for the file.
+		TIME_PRECISION mLength;
+	};
+	// case insensitive path id - stream decision. Filled once per file so
+	// playing a sound doesn't reopen it.
+	std::unordered_map<StringId, StreamInfo> mStreamInfos;
+	CriticalSection mStreamInfosLock;
 	// source plyaing audio id
 	std::stack<ALuint> mALSources;	
 	// audioId - source index
 	AudioSources mAudioSources;
-	std::multimap<float, AudioId> mAudioSourcesSorted;
+	// Real voices hold an OpenAL source; the quietest is on top.
+	VoiceHeap mRealVoices;
+	// Virtual voices only track the playback position; the loudest is on top.
+	VoiceHeap mVirtualVoices;
 	// Source, Buffer	
 	typedef std::unordered_map<AudioId, std::vector<IAudioManipulatorPtr> > AudioManipulators;
 	AudioManipulators mAudioManipulators;
-	AudioManipulators mAudioManipulatorsQueue;
 	std::vector<AudioExPtr> mAudioExs;	
 	std::vector<AudioExPtr> mAudioExsQueue;
+	AudioStreamerPtr mStreamer;
 
 	typedef std::unordered_map<FunctionId, CallbackFunction> CallbackMap;
 	typedef std::unordered_map<AudioId, std::vector<FunctionId> > CallbackIdMap;
 	CallbackMap mEndCallbacks;
 	CallbackIdMap mEndCallbackIds;
 	Vec3Tuple mListenerPos;	
-	Vec3Tuple mListenerPosMainThread;
 	int mNumPlaying;
 	int mNumGeneratedSources;
 	bool mSorted;
 	bool mEnabled;
 	bool mGainOptionChanged = false;
 
-	struct PlayData{
-		AudioSourcePtr mSource;
-		std::string mFilePath;		
-	};
-	typedef std::unordered_map<AudioId, PlayData> PlayDataVector;
-	PlayDataVector mAudioPlayQueue;
-	mutable RecursiveSpinLock<true, true> mAudioPlayLock;
+	// Guards mAudioSources writes, end callbacks and the AudioEx queue.
+	// Requests to the audio thread do not take it.
 	mutable CriticalSection mAudioMutex;
 	AudioThread mAudioThread;
-	struct SettingData{
+
+	// Game thread -> audio thread request.
+	// Slots are reused, so the path string keeps its capacity.
+	struct AudioCommand{
+		enum Type{
+			Play,
+			Stop,
+			Setting,
+			Manipulator,
+			Listener,
+			StreamEnd,
+		};
+		Type mType;
 		AudioId mAudioId;
 		int mPropertyType;
 		union{
@@ -124,17 +164,35 @@ public:
 			} mVec3;
 			int mInt;
 		};
-	};
-	typedef std::vector<SettingData> SettingDataVector;
-	SettingDataVector mSettingDataQueue;
-	std::unordered_set<AudioId> mInvalidatedAudioIds;
-
-	struct StopData{
-		AudioId mAudioId;
 		TIME_PRECISION mSec;
+		INT64 mIssuedMicro;
+		AudioSourcePtr mSource;
+		IAudioManipulatorPtr mManipulator;
+		std::string mFilePath;
+
+		AudioCommand()
+			: mType(Play)
+			, mAudioId(INVALID_AUDIO_ID)
+			, mPropertyType(0)
+			, mSec(0)
+			, mIssuedMicro(0)
+		{
+			mVec3 = { 0.f, 0.f, 0.f };
+			mFilePath.reserve(128);
+		}
 	};
-	typedef std::vector<StopData> StopQueue;
-	StopQueue mStopQueue;
+	LockFreeRing<AudioCommand, CommandRingSize> mCommands;
+
+	// Finished audio ids, indexed by id. A slot is overwritten when the id
+	// InvalidatedIdsSize newer also finishes; requests for such an old id
+	// are then ignored by the audio thread instead of rejected here.
+	std::atomic<AudioId> mInvalidatedAudioIds[InvalidatedIdsSize];
+
+	// play start latency
+	std::atomic<unsigned> mNumStarted;
+	std::atomic<unsigned> mNumDroppedCommands;
+	std::atomic<INT64> mStartLatencySumMicro;
+	std::atomic<INT64> mStartLatencyMaxMicro;
 
 	//---------------------------------------------------------------------------
 	Impl()
@@ -144,9 +202,18 @@ public:
 		, mNumGeneratedSources(0)
 		, mSorted(false)		
 		, mEnabled(true)
+		, mRealVoices(false)
+		, mVirtualVoices(true)
+		, mAudioBuffers(std::make_shared<AudioBuffers>())
+		, mNumStarted(0)
+		, mNumDroppedCommands(0)
+		, mStartLatencySumMicro(0)
+		, mStartLatencyMaxMicro(0)
 	{
 		mListenerPos = std::make_tuple(0.f, 0.f, 0.f);
-		mListenerPosMainThread = mListenerPos;
+		for (auto& id : mInvalidatedAudioIds){
+			id = INVALID_AUDIO_ID;
+		}
 	}
 
 	~Impl(){
@@ -157,7 +224,9 @@ public:
 			mALSources.pop();
 			alDeleteSources(1, &src);
 		}
-		mAudioBuffers.clear();
+		mStreamer.reset();
+		mAudioSources.clear();
+		mAudioBuffers.reset();
 		
 		alcMakeContextCurrent(NULL);
 		alcDestroyContext(mContext);
@@ -171,6 +240,302 @@ public:
 		return std::this_thread::get_id() == mAudioThread.mThreadDesc->mThreadID;
 	}
 
+	static INT64 GetTickMicro(){
+		using namespace std::chrono;
+		return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	void InvalidateAudioId(AudioId id){
+		mInvalidatedAudioIds[id & (InvalidatedIdsSize - 1)].store(id, std::memory_order_release);
+	}
+
+	bool IsInvalidatedAudioId(AudioId id) const{
+		if (id == INVALID_AUDIO_ID || id == 0 || id >= NextAudioId.load(std::memory_order_acquire))
+			return true;
+		return mInvalidatedAudioIds[id & (InvalidatedIdsSize - 1)].load(std::memory_order_acquire) == id;
+	}
+
+	// Any thread. 'fill' writes the payload into the preallocated command.
+	template<class Func>
+	bool PushCommand(AudioCommand::Type type, AudioId id, Func fill){
+		auto write = [&](AudioCommand& cmd){
+			cmd.mType = type;
+			cmd.mAudioId = id;
+			fill(cmd);
+		};
+		if (mCommands.Enq(write))
+			return true;
+
+		if (!IsAudioThread()){
+			// Full. The audio thread drains the ring every CommandPollMs.
+			for (int i = 0; i < 20; ++i){
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				if (mCommands.Enq(write))
+					return true;
+			}
+		}
+		++mNumDroppedCommands;
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Audio command queue is full. Command(%d) for audio(%u) is dropped.",
+			type, id).c_str());
+		return false;
+	}
+
+	bool PushSetting(AudioId id, int propertyType, float x, float y = 0.f, float z = 0.f){
+		return PushCommand(AudioCommand::Setting, id, [&](AudioCommand& cmd){
+			cmd.mPropertyType = propertyType;
+			cmd.mVec3 = { x, y, z };
+		});
+	}
+
+	bool PushSetting(AudioId id, int propertyType, int value){
+		return PushCommand(AudioCommand::Setting, id, [&](AudioCommand& cmd){
+			cmd.mPropertyType = propertyType;
+			cmd.mInt = value;
+		});
+	}
+
+	// AudioThread
+	void ProcessCommands(){
+		// bounded so producers cannot keep the audio thread here.
+		for (unsigned i = 0; i < CommandRingSize; ++i){
+			bool processed = mCommands.Deq([this](AudioCommand& cmd){
+				ExecuteCommand(cmd);
+				cmd.mSource.reset();
+				cmd.mManipulator.reset();
+			});
+			if (!processed)
+				break;
+		}
+	}
+
+	// AudioThread
+	void ExecuteCommand(const AudioCommand& cmd){
+		switch (cmd.mType){
+		case AudioCommand::Play:
+		{
+			ExecutePlay(cmd);
+			break;
+		}
+		case AudioCommand::Stop:
+		{
+			ExecuteStop(cmd.mAudioId, cmd.mSec);
+			break;
+		}
+		case AudioCommand::Setting:
+		{
+			ExecuteSetting(cmd);
+			break;
+		}
+		case AudioCommand::Manipulator:
+		{
+			mAudioManipulators[cmd.mAudioId].push_back(cmd.mManipulator);
+			break;
+		}
+		case AudioCommand::Listener:
+		{
+			mListenerPos = std::make_tuple(cmd.mVec3.x, cmd.mVec3.y, cmd.mVec3.z);
+			alListener3f(AL_POSITION, cmd.mVec3.x, cmd.mVec3.y, cmd.mVec3.z);
+			break;
+		}
+		case AudioCommand::StreamEnd:
+		{
+			auto it = mAudioSources.find(cmd.mAudioId);
+			if (it != mAudioSources.end() && it->second->GetALAudioSource() != -1)
+				FinishStream(it);
+			break;
+		}
+		default:
+			assert(0);
+		}
+	}
+
+	// AudioThread
+	void ExecutePlay(const AudioCommand& cmd){
+		AudioBufferPtr audioBuffer;
+		if (ShouldStream(cmd.mFilePath.c_str(), cmd.mSource->GetAudioSourceType())){
+			audioBuffer = CreateStreamBuffer(cmd.mFilePath, cmd.mSource);
+		}
+		if (!audioBuffer){
+			audioBuffer = GetAudioBuffer(cmd.mFilePath);
+		}
+		if (!audioBuffer) {
+			InvalidateAudioId(cmd.mAudioId);
+			return;
+		}
+		CheckSimultaneous(cmd.mFilePath, cmd.mSource);
+		if (PlayAudioBuffer(audioBuffer, cmd.mSource)){
+			auto latency = GetTickMicro() - cmd.mIssuedMicro;
+			++mNumStarted;
+			mStartLatencySumMicro += latency;
+			auto prevMax = mStartLatencyMaxMicro.load();
+			while (latency > prevMax && !mStartLatencyMaxMicro.compare_exchange_weak(prevMax, latency)){}
+		}
+		else if (mAudioSources.find(cmd.mAudioId) == mAudioSources.end()){
+			InvalidateAudioId(cmd.mAudioId);
+		}
+	}
+
+	// AudioThread
+	void ExecuteSetting(const AudioCommand& cmd){
+		auto itSource = mAudioSources.find(cmd.mAudioId);
+		if (itSource == mAudioSources.end()){
+			//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting property(%d) for invalid audio(%u)", cmd.mPropertyType, cmd.mAudioId).c_str());
+			return;
+		}
+		switch (cmd.mPropertyType){
+		case AL_POSITION:
+		{
+			itSource->second->SetPosition(cmd.mVec3.x, cmd.mVec3.y, cmd.mVec3.z);
+			break;
+		}
+		case AL_ROLLOFF_FACTOR:
+		{
+			itSource->second->SetRollOffFactor(cmd.mVec3.x);
+			break;
+		}
+		case AL_REFERENCE_DISTANCE:
+		{
+			itSource->second->SetReferenceDistance(cmd.mVec3.x);
+			break;
+		}
+		case AL_SOURCE_RELATIVE:
+		{
+			itSource->second->SetRelative(cmd.mInt != 0);
+			break;
+		}
+		case AL_SEC_OFFSET:
+		{
+			itSource->second->SetOffsetInSec(cmd.mVec3.x);
+			break;
+		}
+		case AL_GAIN:
+		{
+			float gain = cmd.mVec3.x;
+			bool smooth = cmd.mVec3.z != 0.0f;
+			if (smooth){
+				float inSec = cmd.mVec3.y;
+				SetGainSmoothAudioThread(cmd.mAudioId, gain, inSec);
+			}
+			else{
+				bool checkManipulator = cmd.mVec3.y != 0.f;
+				SetGainAudioThread(cmd.mAudioId, gain, checkManipulator);
+			}
+			break;
+		}
+		case AL_LOOPING:
+		{
+			itSource->second->SetLoop(cmd.mInt != 0);
+			break;
+		}
+		case AL_MAX_GAIN:
+		{
+			itSource->second->SetMaxGain(cmd.mVec3.x);
+			break;
+		}
+		default:
+		{
+			Logger::Log(FB_ERROR_LOG_ARG, "Property is not processed.");
+			assert(0);
+		}
+		}
+	}
+
+	// AudioThread
+	void ExecuteStop(AudioId id, TIME_PRECISION sec){
+		auto itSource = mAudioSources.find(id);
+		if (itSource == mAudioSources.end()){
+			//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Stop invalid audio(%u)", id).c_str());
+			return;
+		}
+		if (itSource->second->GetALAudioSource() != -1){
+			if (sec > 0.f){
+				auto leftTime = itSource->second->GetLeftTime();
+				leftTime = std::min(std::max(leftTime, 0.f), sec);
+				auto fadeOutE = GetManipulator(id, AudioManipulatorType::SmoothGain);
+				if (fadeOutE){
+					fadeOutE->OnGainModified(0.f);
+					fadeOutE->SetDuration(leftTime);
+				}
+				else{
+					float curGain = itSource->second->GetGain();
+					auto fadeOut = SmoothGain::Create(id, curGain / std::min(leftTime, sec),
+						curGain, 0.f);
+					mAudioManipulators[id].push_back(fadeOut);
+				}
+			}
+			else{
+				StopRealVoice(itSource);
+			}
+		}
+		else{
+			OnPlayFinishedInternal(id);
+			EraseAudioSource(itSource);
+		}
+	}
+
+	// AudioThread
+	// alure ends buffer voices through eos_callback. Streams are not
+	// played by alure, so they finish here.
+	void StopRealVoice(AudioSources::iterator it){
+		if (it->second->GetAudioStream()){
+			FinishStream(it);
+			return;
+		}
+		alureStopSource(it->second->GetALAudioSource(), AL_TRUE);
+		CheckALError();
+	}
+
+	// AudioThread
+	void FinishStream(AudioSources::iterator it){
+		auto id = it->first;
+		mStreamer->Remove(id);
+		if (it->second->GetALAudioSource() == -1){
+			OnPlayFinishedInternal(id);
+			EraseAudioSource(it);
+			return;
+		}
+		it->second->GetAudioStream()->Stop();
+		OnPlayFinished((void*)id, it->second->GetALAudioSource());
+	}
+
+	// AudioThread
+	AudioSources::iterator EraseAudioSource(AudioSources::iterator it){
+		InvalidateAudioId(it->first);
+		mRealVoices.Remove(it->first);
+		mVirtualVoices.Remove(it->first);
+		ENTER_CRITICAL_SECTION l(mAudioMutex);
+		return mAudioSources.erase(it);
+	}
+
+	AudioManager::CommandStats GetCommandStats(bool reset){
+		AudioManager::CommandStats stats;
+		unsigned numStarted;
+		INT64 sum, max;
+		if (reset){
+			numStarted = mNumStarted.exchange(0);
+			stats.mNumDropped = mNumDroppedCommands.exchange(0);
+			sum = mStartLatencySumMicro.exchange(0);
+			max = mStartLatencyMaxMicro.exchange(0);
+		}
+		else{
+			numStarted = mNumStarted;
+			stats.mNumDropped = mNumDroppedCommands;
+			sum = mStartLatencySumMicro;
+			max = mStartLatencyMaxMicro;
+		}
+		stats.mNumStarted = numStarted;
+		stats.mAverageStartLatencyMs = numStarted ? (float)(sum / (double)numStarted / 1000.0) : 0.f;
+		stats.mMaxStartLatencyMs = (float)(max / 1000.0);
+		return stats;
+	}
+
+	AudioManager::StreamStats GetStreamStats() const{
+		AudioManager::StreamStats stats;
+		stats.mNumStreams = mStreamer ? mStreamer->GetNumStreams() : 0;
+		stats.mMemoryUsage = mStreamer ? mStreamer->GetMemoryUsage() : 0;
+		return stats;
+	}
+
 	bool Init(){
 		mDevice = alcOpenDevice(NULL);
 		if (!mDevice){
@@ -213,6 +578,9 @@ public:
 			}
 		}
 		Logger::Log(FB_DEFAULT_LOG_ARG, "OpenAL initialized!");
+		mStreamer = AudioStreamer::Create([this](AudioId id){
+			PushCommand(AudioCommand::StreamEnd, id, [](AudioCommand& cmd){});
+		});
 		mAudioThread.CreateThread(1024, "AudioThread");
 		return true;
 	}
@@ -243,93 +611,150 @@ public:
 
 	float GetLengthSQ(const Vec3Tuple& a){
 		float x = std::get<0>(a);
-		float y = std::get<0>(a);
-		float z = std::get<0>(a);
+		float y = std::get<1>(a);
+		float z = std::get<2>(a);
 		return x * x + y * y + z * z;
 	}
 
-	// AudioThreadFunc
-	void DropAudio(){		
-		int desiredDrop = mNumPlaying - MaximumAudioSources;
-		if (desiredDrop <= 0)
-			return;
-		auto it = mAudioSourcesSorted.begin();
-		std::advance(it, MaximumAudioSources-1);
-		for (; it != mAudioSourcesSorted.end();++it){
-			auto audioIt = mAudioSources.find(it->second);
-			if (audioIt == mAudioSources.end()){
-				++it;
-				continue;
-			}
-
-			auto& audio = audioIt->second;
-			if (audio->GetStatus() == AudioSourceStatus::Playing){
-				audio->SetStatus(AudioSourceStatus::Dropping);
-				StopWithFadeOut(it->second, 0.1f);											
-			}			
-		}		
+	// AudioThread
+	// The gain the listener would hear under OpenAL's inverse distance
+	// clamped model. Music and streams always stay real.
+	float ComputePriority(const AudioSourcePtr& audioSource){
+		auto distSQ = audioSource->GetRelative() ?
+			GetLengthSQ(audioSource->GetPosition()) :
+			GetDistanceSQ(mListenerPos, audioSource->GetPosition());
+		float refDist = std::max(audioSource->GetReferenceDistance(), 0.0001f);
+		audioSource->SetDistPerRef(distSQ / refDist);
+		if (audioSource->GetAudioSourceType() == AudioSourceType::Music || audioSource->GetAudioStream())
+			return FLT_MAX;
+		float dist = std::max(std::sqrt(distSQ), refDist);
+		float attenuation = refDist / (refDist + audioSource->GetRollOffFactor() * (dist - refDist));
+		return audioSource->GetGain() * attenuation;
 	}
 
 	// AudioThread
-	bool PlayWaitingAudio(AudioSourcePtr audioSource, ALuint src, TIME_PRECISION fadeInTime){
-		assert(audioSource->GetLeftTime() > 0.f);
+	// Plays the source on a free OpenAL source. A resumed virtual voice
+	// continues from its tracked position and fades in.
+	bool StartVoice(const AudioSourcePtr& audioSource, bool resume){
+		assert(!mALSources.empty());
 		assert(audioSource->GetStatus() == AudioSourceStatus::Waiting);
-		assert(src != -1);
-		alSourcei(src, AL_BUFFER, audioSource->GetAudioBuffer()->mBuffer);
-		CheckALError();
-		
+		auto alsource = mALSources.top();
+		auto audioId = audioSource->GetAudioId();
+		auto stream = audioSource->GetAudioStream();
 		bool error = false;
-		if (mEnabled){
-			error = alurePlaySource(src, eos_callback, (void*)audioSource->GetAudioId()) == AL_FALSE;
+		if (stream){
+			if (mEnabled){
+				stream->SetLoop(audioSource->GetLoop());
+				error = !stream->Start(alsource, resume ? audioSource->GetPlayingTime() : 0.f);
+				if (!error)
+					mStreamer->Add(audioId, stream);
+			}
+		}
+		else{
+			alSourcei(alsource, AL_BUFFER, audioSource->GetAudioBuffer()->mBuffer);
+			CheckALError();
+			if (mEnabled){
+				error = alurePlaySource(alsource, eos_callback, (void*)audioId) == AL_FALSE;
+			}
 		}
 		if (error){
 			CheckALError();
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot play AudioSource(%u, %s)",
-				audioSource->GetAudioId(), audioSource->GetAudioBuffer()->mFilepath.c_str()).c_str());
-			audioSource->SetStatus(AudioSourceStatus::Waiting);
+				audioId, audioSource->GetAudioBuffer()->mFilepath.c_str()).c_str());
 			return false;
 		}
-		else{
-			CheckALError();
-			audioSource->SetALAudioSource(src);
-			audioSource->SetStatus(AudioSourceStatus::Playing);
-			++mNumPlaying;
-			audioSource->ApplyProp();
+		CheckALError();
+		mALSources.pop();
+		audioSource->SetALAudioSource(alsource);
+		audioSource->SetStatus(AudioSourceStatus::Playing);
+		++mNumPlaying;
+		audioSource->ApplyProp();
+		if (resume){
 			audioSource->ApplyRemainedTime();
-			auto audioId = audioSource->GetAudioId();
 			auto fadeIn = SmoothGain::Create(audioId,
-				1.0f / std::min(fadeInTime, audioSource->GetLeftTime()*.2f), 0.f,
+				1.0f / std::min(ResumeFadeInSec, audioSource->GetLeftTime()*.2f), 0.f,
 				audioSource->GetGain());
 			mAudioManipulators[audioId].push_back(fadeIn);
-			return true;
 		}
-		
+		return true;
 	}
 
 	// AudioThread
-	void CheckReserved(){		
-		if (mALSources.empty() || mNumPlaying >= MaximumAudioSources)
-			return;
-		if (mAudioSources.size() < MaximumAudioSources)
+	// Releases the OpenAL source without the end callback. The playback
+	// position keeps advancing in AudioSource::Update().
+	void Virtualize(const AudioSourcePtr& audioSource){
+		auto alsource = audioSource->GetALAudioSource();
+		if (alsource != -1){
+			audioSource->SyncPlayingTime();
+			auto stream = audioSource->GetAudioStream();
+			if (stream){
+				mStreamer->Remove(audioSource->GetAudioId());
+				stream->Stop();
+			}
+			else{
+				alureStopSource(alsource, AL_FALSE);
+				alSourcei(alsource, AL_BUFFER, 0);
+				CheckALError();
+			}
+			mALSources.push(alsource);
+			audioSource->SetALAudioSource(-1);
+			--mNumPlaying;
+		}
+		audioSource->SetStatus(AudioSourceStatus::Waiting);
+	}
+
+	// AudioThread
+	void DemoteWorstRealVoice(){
+		auto worst = mRealVoices.Top();
+		mRealVoices.Pop();
+		auto it = mAudioSources.find(worst.mAudioId);
+		if (it == mAudioSources.end())
 			return;
-		VectorMap<float, AudioId> sorted;
+		Virtualize(it->second);
+		mVirtualVoices.Set(worst.mAudioId, worst.mPriority);
+	}
+
+	// AudioThread
+	bool PromoteBestVirtualVoice(){
+		auto best = mVirtualVoices.Top();
+		auto it = mAudioSources.find(best.mAudioId);
+		if (it == mAudioSources.end()){
+			mVirtualVoices.Pop();
+			return true;
+		}
+		if (!StartVoice(it->second, true))
+			return false;
+		mVirtualVoices.Pop();
+		mRealVoices.Set(best.mAudioId, best.mPriority);
+		return true;
+	}
+
+	// AudioThread
+	// Refreshes every priority in place, then swaps voices while the best
+	// virtual one is clearly louder than the worst real one.
+	void UpdateVoices(){
 		for (auto& it : mAudioSources){
-			if (it.second->GetStatus() == AudioSourceStatus::Waiting){
-				auto dist = it.second->GetRelative() ?
-					GetLengthSQ(it.second->GetPosition()) :
-					GetDistanceSQ(mListenerPos, it.second->GetPosition());
-				sorted[dist / it.second->GetReferenceDistance()] = it.second->GetAudioId();
-			}
+			auto priority = ComputePriority(it.second);
+			if (it.second->GetStatus() == AudioSourceStatus::Waiting)
+				mVirtualVoices.Set(it.first, priority);
+			else
+				mRealVoices.Set(it.first, priority);
 		}
-		for (auto& itSorted : sorted){
-			auto itSource = mAudioSources.find(itSorted.second);
-			if (itSource != mAudioSources.end()){
-				auto alsrc = mALSources.top();
-				if (PlayWaitingAudio(itSource->second, alsrc, 0.5f)){
-					mALSources.pop();
-				}
+
+		while (!mRealVoices.Empty() && mRealVoices.Top().mPriority < InaudibleGain){
+			DemoteWorstRealVoice();
+		}
+
+		while (!mVirtualVoices.Empty()){
+			auto bestPriority = mVirtualVoices.Top().mPriority;
+			if (bestPriority < InaudibleGain)
+				break;
+			if (mALSources.empty()){
+				if (mRealVoices.Empty() || bestPriority <= mRealVoices.Top().mPriority * StealRatio)
+					break;
+				DemoteWorstRealVoice();
 			}
-			if (mALSources.empty())
+			if (!PromoteBestVirtualVoice())
 				break;
 		}
 	}
@@ -338,94 +763,107 @@ public:
 	}
 	
 	// AudioThreadFunc
+	// Starts real when an OpenAL source is free or a clearly quieter real
+	// voice can be stolen. Otherwise the source starts virtual.
 	bool PlayAudioBuffer(AudioBufferPtr buffer, AudioSourcePtr audioSource){		
 		if (!buffer || buffer->mBuffer == -1){
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg");
 			return false;
 		}		
-		if (mNumPlaying >= 256){
-			return false;
-		}
 		auto audioId = audioSource->GetAudioId();
 		assert(audioId != INVALID_AUDIO_ID);
 		audioSource->SetAudioBuffer(buffer);
+		audioSource->SetStatus(AudioSourceStatus::Waiting);
 		{
 			ENTER_CRITICAL_SECTION l(mAudioMutex);
 			mAudioSources[audioId] = audioSource;
 		}
-		
-		ALuint alsource = -1;
-		if (!mALSources.empty()){
-			alsource = mALSources.top();
-			mALSources.pop();
-		}
-		else{			
-			float audioDistance = audioSource->GetRelative() ?
-				GetLengthSQ(audioSource->GetPosition()) : GetDistanceSQ(mListenerPos, audioSource->GetPosition());
-			audioDistance /= audioSource->GetReferenceDistance();				
-			mAudioSourcesSorted.insert(std::make_pair(audioDistance, audioId));
-			auto it = mAudioSourcesSorted.begin();
-			std::advance(it, MaximumAudioSources-1);			
-			if (audioDistance >= it->first) {
-				audioSource->SetStatus(AudioSourceStatus::Waiting);
-				return false;
-			}			
-			DropAudio();
-			
-			alGenSources(1, &alsource);
-			if (alGetError() != AL_NO_ERROR){
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot create audio source. Current playing: %d", mNumPlaying).c_str());
-				alsource = -1;
-			}
-			else{
-				++mNumGeneratedSources;
-			}
-		}
-		if (alsource != -1){
-			alSourcei(alsource, AL_BUFFER, buffer->mBuffer);
-			CheckALError();
-			bool error = false;
-			if (mEnabled){
-				error = alurePlaySource(alsource, eos_callback, (void*)audioId) == AL_FALSE;
-			}
-			if (error){
-				CheckALError();
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot play AudioSource(%u, %s)", 
-					audioId, buffer->mFilepath.c_str()).c_str());
-				audioSource->SetStatus(AudioSourceStatus::Waiting);
-				audioSource->SetALAudioSource(-1);
-				mALSources.push(alsource);
-				return false;
+
+		auto priority = ComputePriority(audioSource);
+		if (priority >= InaudibleGain){
+			if (mALSources.empty() && !mRealVoices.Empty() && 
+				priority > mRealVoices.Top().mPriority * StealRatio)
+			{
+				DemoteWorstRealVoice();
 			}
-			else{
-				CheckALError();
-				audioSource->SetStatus(AudioSourceStatus::Playing);
-				++mNumPlaying;
-				audioSource->SetALAudioSource(alsource);				
-				audioSource->ApplyProp();
+			if (!mALSources.empty() && StartVoice(audioSource, false)){
+				mRealVoices.Set(audioId, priority);
 				return true;
 			}
 		}
+		mVirtualVoices.Set(audioId, priority);
 		return false;
 	}
 	
-	AudioBufferPtr GetAudioBuffer(std::string path, std::string loweredPath){
-		if (path.size() != loweredPath.size()){
-			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
-			return 0;
+
+	bool ShouldStream(const char* path, AudioSourceType::Enum type){
+		if (_stricmp(FileSystem::GetExtension(path), ".ogg") != 0)
+			return false;
+		if (type == AudioSourceType::Music)
+			return true;
+		auto pathId = GetStringIdNoCase(path);
+		{
+			ENTER_CRITICAL_SECTION l(mStreamInfosLock);
+			auto it = mStreamInfos.find(pathId);
+			if (it != mStreamInfos.end())
+				return it->second.mStream;
 		}
+		bool stream;
+		{
+			FileSystem::Open file(path, "rb", FileSystem::SkipErrorMsg);
+			if (!file.IsOpen())
+				return false;
+			fb::fseek(file, 0, SEEK_END);
+			stream = fb::ftell(file) >= StreamingMinFileSize;
+		}
+		InternStringNoCase(path);
+		ENTER_CRITICAL_SECTION l(mStreamInfosLock);
+		mStreamInfos.insert(std::make_pair(pathId, StreamInfo{ stream, -1.f }));
+		return stream;
+	}
+
+	void SetStreamLength(const std::string& path, TIME_PRECISION length){
+		ENTER_CRITICAL_SECTION l(mStreamInfosLock);
+		auto it = mStreamInfos.find(GetStringIdNoCase(path));
+		if (it != mStreamInfos.end())
+			it->second.mLength = length;
+	}
+
+	// Returns a negative value when the length is not known yet.
+	TIME_PRECISION GetStreamLength(const std::string& path){
+		ENTER_CRITICAL_SECTION l(mStreamInfosLock);
+		auto it = mStreamInfos.find(GetStringIdNoCase(path));
+		if (it != mStreamInfos.end())
+			return it->second.mLength;
+		return -1.f;
+	}
+
+	// AudioThread
+	// Streamed sources get their own AudioBuffer which only carries the
+	// path and the length. It is not cached.
+	AudioBufferPtr CreateStreamBuffer(const std::string& path, const AudioSourcePtr& audioSource){
+		auto stream = AudioStream::Create(path.c_str());
+		if (!stream)
+			return 0;
+		AudioBufferPtr audioBuffer(new AudioBuffer);
+		audioBuffer->mFilepath = path;
+		audioBuffer->mLength = stream->GetLength();
+		SetStreamLength(path, audioBuffer->mLength);
+		audioSource->SetAudioStream(stream);
+		return audioBuffer;
+	}
+
+	AudioBufferPtr GetAudioBuffer(const std::string& path){
+		auto pathId = GetStringIdNoCase(path);
 		using namespace std::chrono;
 		auto curTick = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();		
-		std::pair<AudioId, ALuint> audioIdSrcId;
-		mAudioMutex.Lock();
-		auto it = mAudioBuffers.find(loweredPath);
-		if (it != mAudioBuffers.end()){
+		auto buffers = std::atomic_load(&mAudioBuffers);
+		auto it = buffers->find(pathId);
+		if (it != buffers->end()){
 			it->second->mLastAccessed = curTick;
-			mAudioMutex.Unlock();
 			return it->second;
 		}
 		else{
-			mAudioMutex.Unlock();
 			ALuint buffer = 0;
 			try {
 				FileSystem::Open file(path.c_str(), "rb");
@@ -454,9 +892,17 @@ public:
 			alGetBufferi(buffer, AL_CHANNELS, &channels);
 			alGetBufferi(buffer, AL_BITS, &bit);
 			audioBuffer->mLength = GetDuration(bufferSize, frequency, channels, bit);
-			mAudioMutex.Lock();
-			mAudioBuffers[loweredPath] = audioBuffer;
-			mAudioMutex.Unlock();
+			InternStringNoCase(path.c_str());
+			ENTER_CRITICAL_SECTION l(mAudioBuffersWriteLock);
+			auto current = std::atomic_load(&mAudioBuffers);
+			auto itLoaded = current->find(pathId);
+			if (itLoaded != current->end()){
+				// loaded by the other thread meanwhile.
+				return itLoaded->second;
+			}
+			auto newBuffers = std::make_shared<AudioBuffers>(*current);
+			(*newBuffers)[pathId] = audioBuffer;
+			std::atomic_store(&mAudioBuffers, AudioBuffersPtr(newBuffers));
 			return audioBuffer;
 		}
 	}
@@ -619,8 +1065,9 @@ public:
 		auto id = PlayAudio(path, prop);
 		if (id != INVALID_AUDIO_ID) {
 			auto fadeIn = SmoothGain::Create(id, 1.0f / inSec, 0.f, prop.mGain);
-			ENTER_CRITICAL_SECTION l(mAudioMutex);
-			mAudioManipulatorsQueue[id].push_back(fadeIn);
+			PushCommand(AudioCommand::Manipulator, id, [&](AudioCommand& cmd){
+				cmd.mManipulator = fadeIn;
+			});
 		}
 		return id;
 	}
@@ -640,73 +1087,75 @@ public:
 			return INVALID_AUDIO_ID;
 		}		
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		AudioId audioId = NextAudioId++;
 		auto audioSource = AudioSource::Create(audioId, type);
 		audioSource->SetProperty(property);		
-		mAudioPlayQueue.insert(std::make_pair(audioId, PlayData{ audioSource, path }));
+		auto issued = GetTickMicro();
+		bool pushed = PushCommand(AudioCommand::Play, audioId, [&](AudioCommand& cmd){
+			cmd.mSource = audioSource;
+			cmd.mFilePath.assign(path);
+			cmd.mIssuedMicro = issued;
+		});
+		if (!pushed){
+			InvalidateAudioId(audioId);
+			return INVALID_AUDIO_ID;
+		}
 		return audioId;
 	}	
 
 	bool StopAudioInAudioThread(AudioId id){
 		assert(IsAudioThread());
 		auto itSource = mAudioSources.find(id);
-		alureStopSource(itSource->second->GetALAudioSource(), AL_TRUE);
-		CheckALError();
+		if (itSource == mAudioSources.end())
+			return false;
+		if (itSource->second->GetALAudioSource() == -1){
+			// virtual
+			OnPlayFinishedInternal(id);
+			EraseAudioSource(itSource);
+			return true;
+		}
+		StopRealVoice(itSource);
 		return true;
 	}
 
 	bool StopAudio(AudioId id){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		if (mInvalidatedAudioIds.find(id) != mInvalidatedAudioIds.end()){
+		if (IsInvalidatedAudioId(id)){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Stop invalid audio(%u)", id).c_str());
 			return false;
 		}
 
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		mStopQueue.push_back(StopData{ id, -1.0f });
-		return true;
+		return PushCommand(AudioCommand::Stop, id, [](AudioCommand& cmd){
+			cmd.mSec = -1.0f;
+		});
 	}
 
 	bool StopWithFadeOut(AudioId id, TIME_PRECISION sec){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		if (mInvalidatedAudioIds.find(id) != mInvalidatedAudioIds.end()){
+		if (IsInvalidatedAudioId(id)){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Stop invalid audio(%u)", id).c_str());
 			return false;
 		}
 
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		mStopQueue.push_back(StopData{ id, sec });
-		return true;		
+		return PushCommand(AudioCommand::Stop, id, [&](AudioCommand& cmd){
+			cmd.mSec = sec;
+		});
 	}
 
+	// Returns 0 while the play request is still queued.
 	TIME_PRECISION GetAudioLeftTime(AudioId id){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		if (mInvalidatedAudioIds.find(id) != mInvalidatedAudioIds.end()){
+		if (IsInvalidatedAudioId(id)){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot get left time for invalid audio(%u)", id).c_str());
 			return 0.f;
 		}
 
 		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto itQueue = mAudioPlayQueue.find(id);
-		if (itQueue != mAudioPlayQueue.end()){
-			return GetAudioLength(itQueue->second.mFilePath.c_str());
-		}
-		else{			
-			auto it = mAudioSources.find(id);
-			if (it != mAudioSources.end()){
-				return it->second->GetLeftTime();
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot get left time for invalid audio(%u)", id).c_str());
-				return 0;
-			}
+		auto it = mAudioSources.find(id);
+		if (it != mAudioSources.end()){
+			return it->second->GetLeftTime();
 		}
+		return 0.f;
 	}
 
 	TIME_PRECISION GetAudioLength(const char* path) {
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		std::string audioPath;
 		if (_stricmp(FileSystem::GetExtension(path), ".fbaudio") == 0){
 			audioPath = ParseFBAudioForAudio(path);
@@ -714,41 +1163,40 @@ public:
 		else{
 			audioPath = path;
 		}
-		std::string lowered(audioPath);
-		ToLowerCase(lowered);
-
-		auto buffer = GetAudioBuffer(audioPath, lowered);
+		if (ShouldStream(audioPath.c_str(), AudioSourceType::Sound)){
+			auto length = GetStreamLength(audioPath);
+			if (length >= 0.f)
+				return length;
+			// only the headers and the last page are read.
+			auto stream = AudioStream::Create(audioPath.c_str());
+			if (stream){
+				length = stream->GetLength();
+				SetStreamLength(audioPath, length);
+				return length;
+			}
+		}
+		auto buffer = GetAudioBuffer(audioPath);
 		if (!buffer){
 			return 0.f;
 		}
 		return buffer->mLength;
 	}
 
+	// Returns 0 while the play request is still queued.
 	TIME_PRECISION GetAudioLength(AudioId id) {	
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		if (mInvalidatedAudioIds.find(id) != mInvalidatedAudioIds.end()){
+		if (IsInvalidatedAudioId(id)){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Canno get a length for invalid audio(%u)", id).c_str());
 			return 0.f;
 		}
 		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto itQueue = mAudioPlayQueue.find(id);
-		if (itQueue != mAudioPlayQueue.end()){
-			return GetAudioLength(itQueue->second.mFilePath.c_str());
-		}
-		else{			
-			auto it = mAudioSources.find(id);
-			if (it != mAudioSources.end()){
-				return it->second->GetLength();
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Canno get a length for invalid audio(%u)", id).c_str());
-				return 0;
-			}
+		auto it = mAudioSources.find(id);
+		if (it != mAudioSources.end()){
+			return it->second->GetLength();
 		}
+		return 0.f;
 	}
 
 	FunctionId RegisterEndCallback(AudioId id, std::function< void(AudioId) > callback){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		mEndCallbacks[NextCallbackId] = callback;
 		if (!ValueExistsInVector(mEndCallbackIds[id], NextCallbackId))
@@ -758,7 +1206,6 @@ public:
 	}
 
 	void UnregisterEndCallbackForAudio(AudioId id){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		auto idIt = mEndCallbackIds.find(id);
 		if (idIt != mEndCallbackIds.end()){
@@ -773,7 +1220,6 @@ public:
 	}
 
 	void UnregisterEndCallbackFunc(FunctionId functionId){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		// functionId, function
 		auto funcIt = mEndCallbacks.find(functionId);
@@ -840,23 +1286,9 @@ public:
 
 	void GetAudioList(std::vector<AudioDebugData>& list) const{
 		AudioSources sources;
-		SettingDataVector positionData;
 		{
 			ENTER_CRITICAL_SECTION l(mAudioMutex);
 			sources = mAudioSources;
-			for (auto& settingData : mSettingDataQueue){
-				if (settingData.mPropertyType == AL_POSITION){
-					auto itFound = std::find_if(positionData.begin(), positionData.end(), [&](const SettingData& a){
-						return a.mAudioId == settingData.mAudioId && a.mPropertyType == settingData.mPropertyType;
-					});
-					if (itFound != positionData.end()){
-						itFound->mVec3 = settingData.mVec3;
-					}
-					else{
-						positionData.push_back(settingData);
-					}
-				}
-			}
 		}
 		for (auto& it : sources){
 			if (it.second){
@@ -867,26 +1299,14 @@ public:
 				data.mFilePath = it.second->GetAudioBuffer()->mFilepath;
 				data.mGain = it.second->GetGain();
 				data.mPosition = it.second->GetPosition();
-				auto audioId = it.second->GetAudioId();
-				for (auto& itPos : positionData){
-					if (itPos.mAudioId == audioId){
-						data.mPosition = std::make_tuple( itPos.mVec3.x, itPos.mVec3.y, itPos.mVec3.z );
-						break;
-					}
-				}
 				data.mStatus = it.second->GetStatus();
 			}
 		}
 	}
 
+	// Queued play requests are valid too.
 	bool IsValidSource(AudioId id) const{
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end())
-			return true;		
-		auto sourceIt = mAudioSources.find(id);
-		return sourceIt != mAudioSources.end();
+		return !IsInvalidatedAudioId(id);
 	}
 
 	void CheckSimultaneous(const std::string& path, const AudioSourcePtr& audioSource) {
@@ -933,112 +1353,14 @@ public:
 	}
 
 	bool AudioThreadFunc(float dt){
-		PlayDataVector playQueue;		
-		SettingDataVector setttingDataQueue;
-		setttingDataQueue.reserve(100);
-		AudioManipulators manipulators;		
-		StopQueue stopQueue;		
+		ProcessCommands();
 		std::vector<AudioExPtr> audioExQueue;
 		{
 			ENTER_CRITICAL_SECTION l(mAudioMutex);
-			{
-				playQueue.swap(mAudioPlayQueue);
-			}
-			mListenerPos = mListenerPosMainThread;
-			setttingDataQueue.swap(mSettingDataQueue);			
-			manipulators.swap(mAudioManipulatorsQueue);
-			stopQueue.swap(mStopQueue);
 			audioExQueue.swap(mAudioExsQueue);
 		}
 		mAudioExs.insert(mAudioExs.end(), audioExQueue.begin(), audioExQueue.end());
 
-		alListener3f(AL_POSITION, std::get<0>(mListenerPos), 
-			std::get<1>(mListenerPos), std::get<2>(mListenerPos));
-
-		// execute play
-		{
-			for (auto& it : playQueue) {
-				std::string pathKey(it.second.mFilePath);
-				ToLowerCase(pathKey);
-				auto audioBuffer = GetAudioBuffer(it.second.mFilePath, pathKey);
-				if (!audioBuffer) {
-					continue;
-				}
-				CheckSimultaneous(it.second.mFilePath, it.second.mSource);
-				PlayAudioBuffer(audioBuffer, it.second.mSource);
-			}
-		}
-
-		
-		// execute settings
-		for (auto& it : setttingDataQueue){
-			auto itSource = mAudioSources.find(it.mAudioId);
-			if (itSource != mAudioSources.end()){
-				switch (it.mPropertyType){
-				case AL_POSITION:
-				{
-					itSource->second->SetPosition(it.mVec3.x, it.mVec3.y, it.mVec3.z);
-					break;
-				}
-				case AL_ROLLOFF_FACTOR:
-				{
-					itSource->second->SetRollOffFactor(it.mVec3.x);
-					break;
-				}
-				case AL_REFERENCE_DISTANCE:
-				{
-					itSource->second->SetReferenceDistance(it.mVec3.x);
-					break;
-				}
-				case AL_SOURCE_RELATIVE:
-				{
-					itSource->second->SetRelative(it.mInt!=0);
-					break;
-				}
-				case AL_SEC_OFFSET:
-				{
-					itSource->second->SetOffsetInSec(it.mVec3.x);
-					break;
-				}
-				case AL_GAIN:
-				{
-					float gain = it.mVec3.x;
-					bool smooth = it.mVec3.z != 0.0f;					
-					if (smooth){
-						float inSec = it.mVec3.y;
-						SetGainSmoothAudioThread(it.mAudioId, gain, inSec);
-					}
-					else{
-						bool checkManipulator = it.mVec3.y != 0.f;						
-						SetGainAudioThread(it.mAudioId, gain, checkManipulator);						
-					}
-					break;
-				}
-
-				case AL_LOOPING:
-				{
-					itSource->second->SetLoop(it.mInt!=0);
-					break;
-				}
-
-				case AL_MAX_GAIN:
-				{
-					itSource->second->SetMaxGain(it.mVec3.x);
-					break;
-				}
-
-				default:
-				{
-					Logger::Log(FB_ERROR_LOG_ARG, "Property is not processed.");
-					assert(0);
-				}
-				}
-			}
-			else{
-				//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting property(%d) for invalid audio(%u)", it.mPropertyType, it.mAudioId).c_str());
-			}
-		}
-
 		if (mGainOptionChanged) {
 			mGainOptionChanged = false;
 			ENTER_CRITICAL_SECTION l(mAudioMutex);
@@ -1047,47 +1369,6 @@ public:
 			}
 		}
 
-		for (auto& it : manipulators){
-			mAudioManipulators[it.first].insert(mAudioManipulators[it.first].end(),
-				it.second.begin(), it.second.end());
-		}
-
-		for (auto& it : stopQueue){
-			auto itSource = mAudioSources.find(it.mAudioId);
-			if (itSource != mAudioSources.end()){
-				if (itSource->second->GetALAudioSource() != -1){
-					if (it.mSec > 0.f){
-						auto leftTime = itSource->second->GetLeftTime();
-						leftTime = std::min(std::max(leftTime, 0.f), it.mSec);
-						auto fadeOutE = GetManipulator(it.mAudioId, AudioManipulatorType::SmoothGain);
-						if (fadeOutE){
-							fadeOutE->OnGainModified(0.f);
-							fadeOutE->SetDuration(leftTime);
-						}
-						else{							
-							float curGain = itSource->second->GetGain();
-							auto fadeOut = SmoothGain::Create(it.mAudioId, curGain / std::min(leftTime, it.mSec),
-								curGain, 0.f);
-							ENTER_CRITICAL_SECTION l(mAudioMutex);
-							mAudioManipulators[it.mAudioId].push_back(fadeOut);
-						}
-					}
-					else{
-						alureStopSource(itSource->second->GetALAudioSource(), AL_TRUE);
-						CheckALError();
-					}
-				}
-				else{
-					OnPlayFinishedInternal(it.mAudioId);
-					ENTER_CRITICAL_SECTION l(mAudioMutex);
-					mAudioSources.erase(itSource);					
-				}
-			}
-			else{
-				//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Stop invalid audio(%u)", it.mAudioId).c_str());
-			}
-		}
-
 		// Update
 		for (auto itMan = mAudioManipulators.begin(); itMan != mAudioManipulators.end(); /**/){
 			for (auto it = itMan->second.begin(); it != itMan->second.end(); /**/)
@@ -1125,14 +1406,12 @@ public:
 		for (auto it = mAudioSources.begin(); it != mAudioSources.end(); /**/){
 			if (it->second->Update(dt)){
 				OnPlayFinishedInternal(it->second->GetAudioId());
-				ENTER_CRITICAL_SECTION l(mAudioMutex);
-				it = mAudioSources.erase(it);
+				it = EraseAudioSource(it);
 			}
 			else{
 				++it;
 			}
 		}
-		mAudioSourcesSorted.clear();
 		if (mAudioSources.empty())
 			return true;
 
@@ -1142,17 +1421,7 @@ public:
 			accumulator -= 0.125f;
 			alureUpdate();
 			CheckALError();
-			CheckReserved();
-		}
-
-
-		for (auto& it : mAudioSources){
-			auto dist = it.second->GetRelative() ?
-				GetLengthSQ(it.second->GetPosition()) :
-				GetDistanceSQ(mListenerPos, it.second->GetPosition());
-			dist /= it.second->GetReferenceDistance();
-			mAudioSourcesSorted.insert(std::make_pair(dist, it.second->GetAudioId()));
-			it.second->SetDistPerRef(dist);
+			UpdateVoices();
 		}
 
 		static TIME_PRECISION accumulatorForBuffer = 0;
@@ -1161,12 +1430,15 @@ public:
 			accumulatorForBuffer -= 60.f;
 			using namespace std::chrono;
 			auto curTick = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
-			for (auto it = mAudioBuffers.begin(); it != mAudioBuffers.end(); /**/){
+			ENTER_CRITICAL_SECTION l(mAudioBuffersWriteLock);
+			auto newBuffers = std::make_shared<AudioBuffers>(*std::atomic_load(&mAudioBuffers));
+			for (auto it = newBuffers->begin(); it != newBuffers->end(); /**/){
 				auto curIt = it++;
 				if (curIt->second->mReferences == 0 && curTick - curIt->second->mLastAccessed > 60000){
-					mAudioBuffers.erase(curIt);
+					newBuffers->erase(curIt);
 				}
 			}
+			std::atomic_store(&mAudioBuffers, AudioBuffersPtr(newBuffers));
 		}
 
 		if (sDeinitialized)
@@ -1186,34 +1458,11 @@ public:
 			return false;
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);			
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetPosition(x, y, z);			
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){
-				for (auto& itHas : mSettingDataQueue){
-					if (itHas.mAudioId == id && itHas.mPropertyType == AL_POSITION){
-						itHas.mVec3 = { x, y, z };
-						return true;
-					}
-				}
-
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_POSITION;
-				data.mVec3 = { x, y, z };
-				return true;
-			}
-			else{
-				//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting position for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			//Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting position for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_POSITION, x, y, z);
 	}
 
 	bool SetRelative(AudioId id, bool relative){
@@ -1227,32 +1476,17 @@ public:
 			return false;
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetRelative(relative);
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){				
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_SOURCE_RELATIVE;
-				data.mInt = relative ? 1 : 0;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting the relative flag for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting the relative flag for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_SOURCE_RELATIVE, relative ? 1 : 0);
 	}
 
 	void SetListenerPosition(const Vec3Tuple& pos){		
-		ENTER_CRITICAL_SECTION l(mAudioMutex);
-		mListenerPosMainThread = pos;
+		PushCommand(AudioCommand::Listener, INVALID_AUDIO_ID, [&](AudioCommand& cmd){
+			cmd.mVec3 = { std::get<0>(pos), std::get<1>(pos), std::get<2>(pos) };
+		});
 	}
 
 	bool SetReferenceDistance(AudioId id, float distance){
@@ -1266,27 +1500,11 @@ public:
 			return false;
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetReferenceDistance(distance);
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){				
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_REFERENCE_DISTANCE;
-				data.mVec3.x = distance;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting reference distance for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting reference distance for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_REFERENCE_DISTANCE, distance);
 	}
 
 	bool SetRolloffFactor(AudioId id, float factor){
@@ -1300,27 +1518,11 @@ public:
 			return false;
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetRollOffFactor(factor);
-			return true;
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting roll off factor for invalid audio(%u)", id).c_str());
+			return false;
 		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){				
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_ROLLOFF_FACTOR;
-				data.mVec3.x = factor;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting roll off factor for invalid audio(%u)", id).c_str());
-				return false;
-			}
-		}		
+		return PushSetting(id, AL_ROLLOFF_FACTOR, factor);
 	}
 
 	bool SetOffsetInSec(AudioId id, float sec){
@@ -1334,27 +1536,11 @@ public:
 			return false;
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetOffsetInSec(sec);
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){				
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_SEC_OFFSET;
-				data.mVec3.x = sec;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting offset for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting offset for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_SEC_OFFSET, sec);
 	}
 
 	bool SetGainAudioThread(AudioId id, float gain, bool checkManipulator){		
@@ -1420,55 +1606,28 @@ public:
 			return SetGainAudioThread(id, gain, checkManipulator);
 		}
 
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetGain(gain);
-			return true;
-		}
-
-		if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){			
-			mSettingDataQueue.push_back(SettingData());
-			auto& data = mSettingDataQueue.back();
-			data.mAudioId = id;
-			data.mPropertyType = AL_GAIN;
-			data.mVec3.x = gain;
-			data.mVec3.y = checkManipulator ? 1.0f : 0.0f;
-			data.mVec3.z = 0.f; // no smooth: 0.f
-			return true;
-		}
-		else{
+		if (IsInvalidatedAudioId(id)){
 			if (checkManipulator)
 				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting gain for invalid audio(%u)", id).c_str());
 			return false;
 		}
+		// y: check manipulator, z: no smooth(0.f)
+		return PushSetting(id, AL_GAIN, gain, checkManipulator ? 1.0f : 0.0f, 0.f);
 	}
 
 	bool SetGainSmooth(AudioId id, float gain, float inSec){
 		if (IsAudioThread()){
 			return SetGainSmoothAudioThread(id, gain, inSec);
 		}
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){
-			ENTER_CRITICAL_SECTION l(mAudioMutex);
-			mSettingDataQueue.push_back(SettingData());
-			auto& data = mSettingDataQueue.back();
-			data.mAudioId = id;
-			data.mPropertyType = AL_GAIN;
-			data.mVec3.x = gain;
-			data.mVec3.y = inSec;
-			data.mVec3.z = 1.0f; // smooth: 1.f
-			return true;
-		}
-		else{
+		if (IsInvalidatedAudioId(id)){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting gain smooth for invalid audio(%u)", id).c_str());
 			return false;
 		}
+		// y: duration, z: smooth(1.f)
+		return PushSetting(id, AL_GAIN, gain, inSec, 1.0f);
 	}
 
 	float GetGain(AudioId id) const{
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		auto it = mAudioSources.find(id);
 		if (it != mAudioSources.end()){
@@ -1485,31 +1644,14 @@ public:
 	}
 
 	bool SetLoop(AudioId id, bool loop){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetLoop(loop);
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){				
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_LOOPING;
-				data.mInt = loop ? 1 : 0;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting loop for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting loop for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_LOOPING, loop ? 1 : 0);
 	}
 
 	bool GetLoop(AudioId id) const{
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		auto it = mAudioSources.find(id);
 		if (it != mAudioSources.end()){
@@ -1522,31 +1664,14 @@ public:
 	}
 
 	bool SetMaxGain(AudioId id, float maxGain){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		ENTER_CRITICAL_SECTION l(mAudioMutex);		
-		auto it = mAudioPlayQueue.find(id);
-		if (it != mAudioPlayQueue.end()){
-			it->second.mSource->SetMaxGain(maxGain);
-			return true;
-		}
-		else{
-			if (mInvalidatedAudioIds.find(id) == mInvalidatedAudioIds.end()){
-				mSettingDataQueue.push_back(SettingData());
-				auto& data = mSettingDataQueue.back();
-				data.mAudioId = id;
-				data.mPropertyType = AL_MAX_GAIN;
-				data.mVec3.x = maxGain;
-				return true;
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting loop for invalid audio(%u)", id).c_str());
-				return false;
-			}
+		if (IsInvalidatedAudioId(id)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Setting loop for invalid audio(%u)", id).c_str());
+			return false;
 		}
+		return PushSetting(id, AL_MAX_GAIN, maxGain);
 	}
 
 	float GetMaxGain(AudioId id){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		auto it = mAudioSources.find(id);
 		if (it != mAudioSources.end()){
@@ -1559,7 +1684,6 @@ public:
 	}
 
 	void RegisterAudioEx(AudioExPtr audioex){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
 		if (!ValueExistsInVector(mAudioExsQueue, audioex)){
 			mAudioExsQueue.push_back(audioex);
@@ -1567,13 +1691,8 @@ public:
 	}
 
 	bool IsRegisteredAudioEx(AudioExPtr audioex){
-		EnterSpinLock<RecursiveSpinLock<true, true>> lock(mAudioPlayLock);
-		bool exist = ValueExistsInVector(mAudioExsQueue, audioex);
-		if (exist)
-			return true;
-
 		ENTER_CRITICAL_SECTION l(mAudioMutex);
-		return ValueExistsInVector(mAudioExs, audioex);
+		return ValueExistsInVector(mAudioExsQueue, audioex) || ValueExistsInVector(mAudioExs, audioex);
 	}
 
 	void OnPlayFinishedInternal(AudioId id){
@@ -1601,18 +1720,14 @@ public:
 	void OnPlayFinished(void* userdata, ALuint source){
 		assert(IsAudioThread());		
 		AudioId id = (AudioId)userdata;
-		{
-			ENTER_CRITICAL_SECTION l(mAudioMutex);
-			mInvalidatedAudioIds.insert(id);
-		}
+		InvalidateAudioId(id);
 		OnPlayFinishedInternal(id);
 		--mNumPlaying;
 		auto it = mAudioSources.find(id);
 		if (it != mAudioSources.end()){
 			assert(it->second->GetALAudioSource() != -1);
 			mALSources.push(it->second->GetALAudioSource());			
-			ENTER_CRITICAL_SECTION l(mAudioMutex);
-			mAudioSources.erase(it);			
+			EraseAudioSource(it);
 		}
 		else{
 			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Audio(%u) is not found.", id).c_str());
@@ -1855,6 +1970,14 @@ bool AudioManager::IsValidSource(AudioId id) const{
 	return mImpl->IsValidSource(id);
 }
 
+AudioManager::CommandStats AudioManager::GetCommandStats(bool reset){
+	return mImpl->GetCommandStats(reset);
+}
+
+AudioManager::StreamStats AudioManager::GetStreamStats() const{
+	return mImpl->GetStreamStats();
+}
+
 bool AudioManager::AudioThreadFunc(){
 	using namespace std::chrono;
 	static auto tick = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
@@ -1865,7 +1988,10 @@ bool AudioManager::AudioThreadFunc(){
 		return mImpl->AudioThreadFunc(deltaTick / (TIME_PRECISION)std::milli::den);
 	}
 	else{
-		std::this_thread::sleep_for(milliseconds(300 - deltaTick));
+		// play and stop requests do not wait for the next update.
+		if (sAudioManagerRaw)
+			mImpl->ProcessCommands();
+		std::this_thread::sleep_for(milliseconds(std::min(300 - deltaTick, (decltype(deltaTick))Impl::CommandPollMs)));
 		return sAudioManagerRaw != 0;
 	}
 }
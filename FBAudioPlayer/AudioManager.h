@@ -122,6 +122,24 @@ namespace fb{
 		unsigned GetNumGenerated() const;
 		bool IsValidSource(AudioId id) const;
 
+		/// Requests to the audio thread. Latency is measured from PlayAudio()
+		/// to the moment the audio thread starts the source.
+		struct CommandStats{
+			unsigned mNumStarted;
+			unsigned mNumDropped;
+			float mAverageStartLatencyMs;
+			float mMaxStartLatencyMs;
+		};
+		/// \a reset clears the counters after reading them.
+		CommandStats GetCommandStats(bool reset);
+
+		/// Music and big Ogg files play from an AudioStream.
+		struct StreamStats{
+			size_t mNumStreams;
+			size_t mMemoryUsage;
+		};
+		StreamStats GetStreamStats() const;
+
 		/// Internal only.
 		bool AudioThreadFunc();
 
@@ -28,7 +28,9 @@
 #include "stdafx.h"
 #include "AudioSource.h"
 #include "AudioBuffer.h"
+#include "AudioStream.h"
 #include "AudioProperty.h"
+#include <cmath>
 using namespace fb;
 namespace fb{
 	void CheckALError();
@@ -41,6 +43,7 @@ class AudioSource::Impl{
 public:
 	AudioId mAudioId;
 	AudioBufferPtr mAudioBuffer;
+	AudioStreamPtr mAudioStream;
 	ALuint mALSource;
 	AudioProperty mProperty;
 	float mPlayingTime;
@@ -108,14 +111,18 @@ public:
 			alSourcef(mALSource, AL_ROLLOFF_FACTOR, mProperty.mRolloffFactor);
 			alSourcef(mALSource, AL_GAIN, mProperty.mGain * sMasterGain * 
 				(mType == AudioSourceType::Music ? sMusicGain : sSoundGain));
-			alSourcei(mALSource, AL_LOOPING, mProperty.mLoop ? AL_TRUE : AL_FALSE);
+			if (mAudioStream)
+				mAudioStream->SetLoop(mProperty.mLoop);
+			else
+				alSourcei(mALSource, AL_LOOPING, mProperty.mLoop ? AL_TRUE : AL_FALSE);
 			alSourcef(mALSource, AL_MAX_GAIN, mProperty.mMaxGain);
 			CheckALError();
 		}
 	}
 
 	void ApplyRemainedTime(){
-		if (mALSource != -1){
+		// streams start at the offset.
+		if (mALSource != -1 && !mAudioStream){
 			alSourcef(mALSource, AL_SEC_OFFSET, mPlayingTime);
 			CheckALError();
 		}
@@ -127,12 +134,33 @@ public:
 
 	bool Update(float dt){
 		mPlayingTime += dt;
-		if (mStatus == AudioSourceStatus::Waiting && mPlayingTime >= mAudioBuffer->mLength)
-			return true; // delete me
+		if (mStatus == AudioSourceStatus::Waiting && mPlayingTime >= mAudioBuffer->mLength){
+			if (!mProperty.mLoop || mAudioBuffer->mLength <= 0.f)
+				return true; // delete me
+			mPlayingTime = std::fmod(mPlayingTime, mAudioBuffer->mLength);
+		}
 
 		return false; // dont delete me.
 	}
 
+	void SyncPlayingTime(){
+		if (mALSource == -1)
+			return;
+		if (mAudioStream){
+			mPlayingTime = mAudioStream->GetPlayingTime();
+		}
+		else{
+			ALfloat offset = 0.f;
+			alGetSourcef(mALSource, AL_SEC_OFFSET, &offset);
+			CheckALError();
+			mPlayingTime = offset;
+		}
+	}
+
+	AudioSourceType::Enum GetAudioSourceType() const{
+		return mType;
+	}
+
 	void SetPosition(float x, float y, float z){
 		mProperty.mPosition = std::make_tuple(x, y, z);
 		if (mALSource != -1){
@@ -178,7 +206,10 @@ public:
 
 	void SetOffsetInSec(float sec){
 		mPlayingTime = sec;
-		if (mALSource != -1){
+		if (mAudioStream){
+			mAudioStream->Seek(sec);
+		}
+		else if (mALSource != -1){
 			alSourcef(mALSource, AL_SEC_OFFSET, mPlayingTime);
 			CheckALError();
 		}
@@ -215,7 +246,10 @@ public:
 
 	void SetLoop(bool loop){
 		mProperty.mLoop = loop;
-		if (mALSource != -1){
+		if (mAudioStream){
+			mAudioStream->SetLoop(loop);
+		}
+		else if (mALSource != -1){
 			alSourcei(mALSource, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
 			CheckALError();
 		}
@@ -255,6 +289,14 @@ AudioBufferPtr AudioSource::GetAudioBuffer() const {
 	return mImpl->GetAudioBuffer();
 }
 
+void AudioSource::SetAudioStream(AudioStreamPtr stream){
+	mImpl->mAudioStream = stream;
+}
+
+AudioStreamPtr AudioSource::GetAudioStream() const{
+	return mImpl->mAudioStream;
+}
+
 void AudioSource::SetALAudioSource(unsigned src) {
 	mImpl->SetALAudioSource(src);
 }
@@ -291,6 +333,14 @@ bool AudioSource::Update(float dt) {
 	return mImpl->Update(dt);
 }
 
+void AudioSource::SyncPlayingTime() {
+	mImpl->SyncPlayingTime();
+}
+
+AudioSourceType::Enum AudioSource::GetAudioSourceType() const {
+	return mImpl->GetAudioSourceType();
+}
+
 void AudioSource::SetPosition(float x, float y, float z) {
 	mImpl->SetPosition(x, y, z);
 }
@@ -319,6 +369,10 @@ void AudioSource::SetRollOffFactor(float factor) {
 	mImpl->SetRollOffFactor(factor);
 }
 
+float AudioSource::GetRollOffFactor() const {
+	return mImpl->mProperty.mRolloffFactor;
+}
+
 void AudioSource::SetOffsetInSec(float sec) {
 	mImpl->SetOffsetInSec(sec);
 }
@@ -339,6 +393,10 @@ float AudioSource::GetLeftTime() const {
 	return mImpl->GetLeftTime();
 }
 
+float AudioSource::GetPlayingTime() const {
+	return mImpl->mPlayingTime;
+}
+
 float AudioSource::GetLength() const {
 	return mImpl->GetLength();
 }
@@ -32,6 +32,7 @@
 namespace fb{
 	struct AudioProperty;
 	FB_DECLARE_SMART_PTR_STRUCT(AudioBuffer);
+	FB_DECLARE_SMART_PTR(AudioStream);
 	FB_DECLARE_SMART_PTR_STRUCT(AudioSource);
 	struct FB_DLL_AUDIOPLAYER AudioSource{
 	private:
@@ -48,6 +49,10 @@ namespace fb{
 		const AudioId& GetAudioId() const;
 		void SetAudioBuffer(AudioBufferPtr buffer);
 		AudioBufferPtr GetAudioBuffer() const;
+		/// Streamed sources keep an AudioBuffer without OpenAL data for
+		/// the path and the length.
+		void SetAudioStream(AudioStreamPtr stream);
+		AudioStreamPtr GetAudioStream() const;
 		void SetALAudioSource(unsigned src);
 		unsigned GetALAudioSource() const;
 		void SetStatus(AudioSourceStatus::Enum status);
@@ -56,7 +61,12 @@ namespace fb{
 		void ApplyProp();
 		void ApplyRemainedTime();
 		bool IsPlaying() const;
+		/// Advances the playback position. Virtual(Waiting) loops wrap around.
+		/// Returns true when a virtual one-shot reached its end.
 		bool Update(float dt);
+		/// Reads the playback position back from the OpenAL source.
+		void SyncPlayingTime();
+		AudioSourceType::Enum GetAudioSourceType() const;
 		void SetPosition(float x, float y, float z);
 		Vec3Tuple GetPosition() const;
 		void SetRelative(bool relative);
@@ -64,11 +74,13 @@ namespace fb{
 		void SetReferenceDistance(float distance);
 		float GetReferenceDistance();
 		void SetRollOffFactor(float factor);
+		float GetRollOffFactor() const;
 		void SetOffsetInSec(float sec);
 		void SetGain(float gain);
 		float GetGain() const;
 		void OnGainOptionChanged();
 		float GetLeftTime() const;
+		float GetPlayingTime() const;
 		float GetLength() const;
 		void SetDistPerRef(float distPerRef);
 		float GetDistPerRef() const;
@@ -30,6 +30,8 @@ namespace fb{
 	namespace AudioSourceStatus{
 		enum Enum{
 			Playing,
+			/// Virtual. The playback position is tracked but no OpenAL
+			/// source is held.
 			Waiting,
 			Dropping,
 		};
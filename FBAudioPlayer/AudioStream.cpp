@@ -0,0 +1,496 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "AudioStream.h"
+#include "FBCommonHeaders/Helpers.h"
+using namespace fb;
+namespace fb{
+	void CheckALError();
+}
+
+class AudioStream::Impl{
+public:
+	static const int ReadChunkSize = 16 * 1024;
+	// Ogg pages are at most 64KB, so the last granule position is in here.
+	static const int LastPageScanSize = 64 * 1024;
+	// Queued synchronously in Start(); the streamer fills the rest.
+	static const int NumStartBuffers = 2;
+
+	std::string mFilePath;
+	FileSystem::Open mFile;
+	ogg_sync_state mSyncState;
+	ogg_stream_state mStreamState;
+	vorbis_info mVorbisInfo;
+	vorbis_comment mVorbisComment;
+	vorbis_dsp_state mVorbisDspState;
+	vorbis_block mVorbisBlock;
+	bool mSyncInit;
+	bool mStreamInit;
+	bool mDspInit;
+	bool mEndOfFile;
+	bool mDrained;
+	bool mLoop;
+	INT64 mSkipFrames;
+	TIME_PRECISION mLength;
+	ALenum mFormat;
+	int mChannels;
+	int mFrequency;
+	int mFramesPerBuffer;
+	std::vector<short> mPcm;
+
+	ALuint mBuffers[NumBuffers];
+	int mBufferFrames[NumBuffers];
+	std::vector<ALuint> mFreeBuffers;
+	ALuint mALSource;
+	int mNumQueued;
+	// frames of the unqueued buffers since the last Start or Seek.
+	INT64 mPlayedFrames;
+	TIME_PRECISION mStartSec;
+	// Start/Stop come from the audio thread, Fill from the streamer.
+	mutable CriticalSection mLock;
+
+	//---------------------------------------------------------------------------
+	Impl()
+		: mSyncInit(false)
+		, mStreamInit(false)
+		, mDspInit(false)
+		, mEndOfFile(false)
+		, mDrained(false)
+		, mLoop(false)
+		, mSkipFrames(0)
+		, mLength(0)
+		, mFormat(0)
+		, mChannels(0)
+		, mFrequency(0)
+		, mFramesPerBuffer(0)
+		, mALSource(-1)
+		, mNumQueued(0)
+		, mPlayedFrames(0)
+		, mStartSec(0)
+	{
+		for (int i = 0; i < NumBuffers; ++i){
+			mBuffers[i] = 0;
+			mBufferFrames[i] = 0;
+		}
+	}
+
+	~Impl(){
+		Stop();
+		if (mBuffers[0]){
+			alDeleteBuffers(NumBuffers, mBuffers);
+			CheckALError();
+		}
+		if (mDspInit){
+			vorbis_block_clear(&mVorbisBlock);
+			vorbis_dsp_clear(&mVorbisDspState);
+		}
+		if (mStreamInit){
+			ogg_stream_clear(&mStreamState);
+			vorbis_comment_clear(&mVorbisComment);
+			vorbis_info_clear(&mVorbisInfo);
+		}
+		if (mSyncInit){
+			ogg_sync_clear(&mSyncState);
+		}
+	}
+
+	bool Open(const char* path){
+		mFilePath = path;
+		mFile.Reset(path, "rb");
+		if (!mFile.IsOpen()){
+			return false;
+		}
+		ogg_sync_init(&mSyncState);
+		mSyncInit = true;
+		if (!ReadHeaders()){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("(%s) is not an Ogg/Vorbis file.", path).c_str());
+			return false;
+		}
+		mChannels = mVorbisInfo.channels;
+		mFrequency = (int)mVorbisInfo.rate;
+		if (mChannels == 1){
+			mFormat = AL_FORMAT_MONO16;
+		}
+		else if (mChannels == 2){
+			mFormat = AL_FORMAT_STEREO16;
+		}
+		else{
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Streaming %d channels is not supported(%s).", mChannels, path).c_str());
+			return false;
+		}
+		// 250ms per buffer.
+		mFramesPerBuffer = std::max(mFrequency / 4, 1);
+		mPcm.resize(mFramesPerBuffer * mChannels);
+		mLength = ReadLength();
+		alGenBuffers(NumBuffers, mBuffers);
+		if (alGetError() != AL_NO_ERROR){
+			mBuffers[0] = 0;
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot create stream buffers for(%s)", path).c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool NextPage(ogg_page& page){
+		while (ogg_sync_pageout(&mSyncState, &page) != 1){
+			auto buffer = ogg_sync_buffer(&mSyncState, ReadChunkSize);
+			auto bytes = fb::fread(buffer, 1, ReadChunkSize, mFile);
+			if (bytes == 0)
+				return false;
+			ogg_sync_wrote(&mSyncState, (long)bytes);
+		}
+		return true;
+	}
+
+	bool ReadHeaders(){
+		ogg_page page;
+		if (!NextPage(page))
+			return false;
+		ogg_stream_init(&mStreamState, ogg_page_serialno(&page));
+		vorbis_info_init(&mVorbisInfo);
+		vorbis_comment_init(&mVorbisComment);
+		mStreamInit = true;
+		ogg_stream_pagein(&mStreamState, &page);
+		int numHeaders = 0;
+		while (numHeaders < 3){
+			ogg_packet packet;
+			auto result = ogg_stream_packetout(&mStreamState, &packet);
+			if (result == 0){
+				if (!NextPage(page))
+					return false;
+				ogg_stream_pagein(&mStreamState, &page);
+				continue;
+			}
+			if (result < 0 || vorbis_synthesis_headerin(&mVorbisInfo, &mVorbisComment, &packet) < 0)
+				return false;
+			++numHeaders;
+		}
+		if (vorbis_synthesis_init(&mVorbisDspState, &mVorbisInfo) != 0)
+			return false;
+		vorbis_block_init(&mVorbisDspState, &mVorbisBlock);
+		mDspInit = true;
+		return true;
+	}
+
+	// The granule position of the last page is the number of frames.
+	TIME_PRECISION ReadLength(){
+		auto restore = fb::ftell(mFile);
+		fb::fseek(mFile, 0, SEEK_END);
+		long size = fb::ftell(mFile);
+		long start = std::max(size - (long)LastPageScanSize, 0l);
+		fb::fseek(mFile, start, SEEK_SET);
+		std::vector<unsigned char> tail(size - start);
+		auto read = tail.empty() ? 0 : fb::fread(&tail[0], 1, tail.size(), mFile);
+		fb::fseek(mFile, restore, SEEK_SET);
+		INT64 granule = -1;
+		for (long i = (long)read - 27; i >= 0; --i){
+			if (tail[i] == 'O' && tail[i + 1] == 'g' && tail[i + 2] == 'g' && tail[i + 3] == 'S'){
+				granule = 0;
+				for (int b = 7; b >= 0; --b){
+					granule = (granule << 8) | tail[i + 6 + b];
+				}
+				break;
+			}
+		}
+		if (granule <= 0 || mFrequency <= 0)
+			return 0;
+		return (TIME_PRECISION)(granule / (double)mFrequency);
+	}
+
+	void Rewind(TIME_PRECISION offsetSec){
+		fb::fseek(mFile, 0, SEEK_SET);
+		ogg_sync_reset(&mSyncState);
+		ogg_stream_reset(&mStreamState);
+		vorbis_synthesis_restart(&mVorbisDspState);
+		mEndOfFile = false;
+		mDrained = false;
+		mSkipFrames = (INT64)(std::max(offsetSec, 0.f) * mFrequency);
+	}
+
+	// Decodes up to 'maxFrames' interleaved frames. Header packets after a
+	// rewind are rejected by vorbis_synthesis() and skipped.
+	int Decode(short* out, int maxFrames){
+		int frames = 0;
+		while (frames < maxFrames){
+			float** pcm;
+			int available = vorbis_synthesis_pcmout(&mVorbisDspState, &pcm);
+			if (available > 0){
+				if (mSkipFrames > 0){
+					int skip = (int)std::min((INT64)available, mSkipFrames);
+					mSkipFrames -= skip;
+					vorbis_synthesis_read(&mVorbisDspState, skip);
+					continue;
+				}
+				int num = std::min(available, maxFrames - frames);
+				for (int c = 0; c < mChannels; ++c){
+					short* dest = out + frames * mChannels + c;
+					const float* src = pcm[c];
+					for (int i = 0; i < num; ++i){
+						int value = (int)std::floor(src[i] * 32767.f + .5f);
+						*dest = (short)std::min(std::max(value, -32768), 32767);
+						dest += mChannels;
+					}
+				}
+				vorbis_synthesis_read(&mVorbisDspState, num);
+				frames += num;
+				continue;
+			}
+			ogg_packet packet;
+			auto result = ogg_stream_packetout(&mStreamState, &packet);
+			if (result > 0){
+				if (vorbis_synthesis(&mVorbisBlock, &packet) == 0)
+					vorbis_synthesis_blockin(&mVorbisDspState, &mVorbisBlock);
+				continue;
+			}
+			if (result < 0) // hole in the data
+				continue;
+			ogg_page page;
+			if (!NextPage(page)){
+				mEndOfFile = true;
+				break;
+			}
+			ogg_stream_pagein(&mStreamState, &page);
+		}
+		return frames;
+	}
+
+	// Returns false when nothing is left to queue.
+	bool FillBuffer(int index){
+		int frames = 0;
+		bool rewound = false;
+		while (frames < mFramesPerBuffer){
+			int decoded = Decode(&mPcm[frames * mChannels], mFramesPerBuffer - frames);
+			frames += decoded;
+			if (!mEndOfFile)
+				continue;
+			if (!mLoop || (rewound && decoded == 0)){
+				mDrained = true;
+				break;
+			}
+			Rewind(0);
+			rewound = true;
+		}
+		if (frames == 0)
+			return false;
+		alBufferData(mBuffers[index], mFormat, &mPcm[0], frames * mChannels * sizeof(short), mFrequency);
+		CheckALError();
+		mBufferFrames[index] = frames;
+		return true;
+	}
+
+	int FindBuffer(ALuint buffer) const{
+		for (int i = 0; i < NumBuffers; ++i){
+			if (mBuffers[i] == buffer)
+				return i;
+		}
+		return -1;
+	}
+
+	bool QueueFreeBuffers(){
+		while (!mFreeBuffers.empty() && !mDrained){
+			auto buffer = mFreeBuffers.back();
+			if (!FillBuffer(FindBuffer(buffer)))
+				break;
+			alSourceQueueBuffers(mALSource, 1, &buffer);
+			CheckALError();
+			mFreeBuffers.pop_back();
+			++mNumQueued;
+		}
+		return mNumQueued > 0;
+	}
+
+	bool Start(ALuint alsource, TIME_PRECISION offsetSec){
+		ENTER_CRITICAL_SECTION l(mLock);
+		if (mALSource != -1)
+			StopInternal();
+		if (mLength > 0.f){
+			offsetSec = mLoop ? std::fmod(offsetSec, mLength) : std::min(offsetSec, mLength);
+		}
+		Rewind(offsetSec);
+		mALSource = alsource;
+		mStartSec = offsetSec;
+		mPlayedFrames = 0;
+		mNumQueued = 0;
+		alSourcei(alsource, AL_BUFFER, 0);
+		alSourcei(alsource, AL_LOOPING, AL_FALSE);
+		mFreeBuffers.assign(mBuffers + NumStartBuffers, mBuffers + NumBuffers);
+		for (int i = NumStartBuffers - 1; i >= 0; --i){
+			mFreeBuffers.push_back(mBuffers[i]);
+		}
+		// Only the first chunks are decoded here so the start is fast.
+		while (mFreeBuffers.size() > NumBuffers - NumStartBuffers && !mDrained){
+			auto buffer = mFreeBuffers.back();
+			if (!FillBuffer(FindBuffer(buffer)))
+				break;
+			alSourceQueueBuffers(mALSource, 1, &buffer);
+			mFreeBuffers.pop_back();
+			++mNumQueued;
+		}
+		if (mNumQueued == 0){
+			mALSource = -1;
+			return false;
+		}
+		alSourcePlay(alsource);
+		CheckALError();
+		return true;
+	}
+
+	void StopInternal(){
+		alSourceStop(mALSource);
+		alSourcei(mALSource, AL_BUFFER, 0);
+		CheckALError();
+		mALSource = -1;
+		mNumQueued = 0;
+		mFreeBuffers.clear();
+	}
+
+	void Stop(){
+		ENTER_CRITICAL_SECTION l(mLock);
+		if (mALSource != -1)
+			StopInternal();
+	}
+
+	bool Seek(TIME_PRECISION offsetSec){
+		ALuint alsource;
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			alsource = mALSource;
+		}
+		if (alsource == -1)
+			return false;
+		return Start(alsource, offsetSec);
+	}
+
+	void SetLoop(bool loop){
+		ENTER_CRITICAL_SECTION l(mLock);
+		mLoop = loop;
+	}
+
+	TIME_PRECISION GetPlayingTime() const{
+		ENTER_CRITICAL_SECTION l(mLock);
+		if (mALSource == -1 || mFrequency == 0)
+			return mStartSec;
+		ALint offset = 0;
+		alGetSourcei(mALSource, AL_SAMPLE_OFFSET, &offset);
+		auto time = mStartSec + (TIME_PRECISION)((mPlayedFrames + offset) / (double)mFrequency);
+		if (mLength > 0.f)
+			time = mLoop ? std::fmod(time, mLength) : std::min(time, mLength);
+		return time;
+	}
+
+	bool Fill(){
+		ENTER_CRITICAL_SECTION l(mLock);
+		if (mALSource == -1)
+			return false;
+		ALint processed = 0;
+		alGetSourcei(mALSource, AL_BUFFERS_PROCESSED, &processed);
+		while (processed--){
+			ALuint buffer;
+			alSourceUnqueueBuffers(mALSource, 1, &buffer);
+			auto index = FindBuffer(buffer);
+			if (index != -1)
+				mPlayedFrames += mBufferFrames[index];
+			mFreeBuffers.push_back(buffer);
+			--mNumQueued;
+		}
+		CheckALError();
+		bool queued = QueueFreeBuffers();
+		ALint state = AL_PLAYING;
+		alGetSourcei(mALSource, AL_SOURCE_STATE, &state);
+		if (state == AL_STOPPED){
+			if (queued){
+				// underrun
+				alSourcePlay(mALSource);
+				CheckALError();
+			}
+			else if (mDrained){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t GetMemoryUsage() const{
+		// vorbis keeps about two blocks of pcm per channel for the overlap.
+		size_t decoder = ReadChunkSize + LastPageScanSize / 4 +
+			(size_t)mChannels * 2 * 4096 * sizeof(float);
+		return decoder + mPcm.size() * sizeof(short) * (NumBuffers + 1);
+	}
+};
+
+//---------------------------------------------------------------------------
+AudioStreamPtr AudioStream::Create(const char* path){
+	AudioStreamPtr p(new AudioStream, [](AudioStream* obj){ delete obj; });
+	if (!p->mImpl->Open(path))
+		return 0;
+	return p;
+}
+
+AudioStream::AudioStream()
+	: mImpl(new Impl)
+{
+}
+
+AudioStream::~AudioStream(){
+}
+
+const std::string& AudioStream::GetFilePath() const{
+	return mImpl->mFilePath;
+}
+
+TIME_PRECISION AudioStream::GetLength() const{
+	return mImpl->mLength;
+}
+
+size_t AudioStream::GetMemoryUsage() const{
+	return mImpl->GetMemoryUsage();
+}
+
+bool AudioStream::Start(unsigned alsource, TIME_PRECISION offsetSec){
+	return mImpl->Start(alsource, offsetSec);
+}
+
+void AudioStream::Stop(){
+	mImpl->Stop();
+}
+
+bool AudioStream::Seek(TIME_PRECISION offsetSec){
+	return mImpl->Seek(offsetSec);
+}
+
+void AudioStream::SetLoop(bool loop){
+	mImpl->SetLoop(loop);
+}
+
+TIME_PRECISION AudioStream::GetPlayingTime() const{
+	return mImpl->GetPlayingTime();
+}
+
+bool AudioStream::Fill(){
+	return mImpl->Fill();
+}
@@ -0,0 +1,62 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb{
+	FB_DECLARE_SMART_PTR(AudioStream);
+	/// Decodes an Ogg/Vorbis file in chunks into a small ring of OpenAL
+	/// buffers. The file is read through FileSystem::Open, so files in .fba
+	/// packs work as well. Only the headers are decoded on Create().
+	class FB_DLL_AUDIOPLAYER AudioStream{
+		FB_DECLARE_PIMPL_NON_COPYABLE(AudioStream);
+		AudioStream();
+
+	public:
+		static const int NumBuffers = 4;
+		static AudioStreamPtr Create(const char* path);
+		~AudioStream();
+
+		const std::string& GetFilePath() const;
+		TIME_PRECISION GetLength() const;
+		/// Approximate heap usage of the decoder and the queued buffers.
+		size_t GetMemoryUsage() const;
+
+		/// Audio thread. Queues the first chunks on 'alsource' and plays
+		/// from 'offsetSec'.
+		bool Start(unsigned alsource, TIME_PRECISION offsetSec);
+		/// Audio thread. Stops and detaches the OpenAL source.
+		void Stop();
+		bool Seek(TIME_PRECISION offsetSec);
+		void SetLoop(bool loop);
+		TIME_PRECISION GetPlayingTime() const;
+		/// Streamer thread. Refills processed buffers and restarts the
+		/// source after an underrun. Returns true once the stream has
+		/// played to the end.
+		bool Fill();
+	};
+}
@@ -0,0 +1,163 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "AudioStreamer.h"
+#include "AudioStream.h"
+using namespace fb;
+
+namespace fb{
+	class AudioStreamThread : public Thread{
+	public:
+		AudioStreamer* mStreamer;
+
+		AudioStreamThread()
+			: mStreamer(0)
+		{
+		}
+
+		// Returns 'repeat?' flag.
+		bool Run(){
+			return mStreamer->Update();
+		}
+	};
+}
+
+class AudioStreamer::Impl{
+public:
+	// A buffer holds 250ms, so this leaves plenty of headroom.
+	static const int UpdateIntervalMs = 20;
+	std::function<void(AudioId)> mOnFinished;
+	typedef std::vector<std::pair<AudioId, AudioStreamPtr> > Streams;
+	Streams mStreams;
+	mutable CriticalSection mStreamsLock;
+	AudioStreamThread mThread;
+
+	//---------------------------------------------------------------------------
+	Impl(std::function<void(AudioId)> onFinished)
+		: mOnFinished(onFinished)
+	{
+	}
+
+	void StartThread(AudioStreamer* self){
+		mThread.mStreamer = self;
+		mThread.CreateThread(1024, "AudioStreamThread");
+	}
+
+	void StopThread(){
+		mThread.ForceExit(true);
+		mThread.Join();
+	}
+
+	void Add(AudioId id, AudioStreamPtr stream){
+		ENTER_CRITICAL_SECTION l(mStreamsLock);
+		for (auto& it : mStreams){
+			if (it.first == id){
+				it.second = stream;
+				return;
+			}
+		}
+		mStreams.push_back(std::make_pair(id, stream));
+	}
+
+	void Remove(AudioId id){
+		ENTER_CRITICAL_SECTION l(mStreamsLock);
+		for (auto it = mStreams.begin(); it != mStreams.end(); ++it){
+			if (it->first == id){
+				mStreams.erase(it);
+				return;
+			}
+		}
+	}
+
+	size_t GetNumStreams() const{
+		ENTER_CRITICAL_SECTION l(mStreamsLock);
+		return mStreams.size();
+	}
+
+	size_t GetMemoryUsage() const{
+		ENTER_CRITICAL_SECTION l(mStreamsLock);
+		size_t usage = 0;
+		for (auto& it : mStreams){
+			usage += it.second->GetMemoryUsage();
+		}
+		return usage;
+	}
+
+	bool Update(){
+		Streams streams;
+		{
+			ENTER_CRITICAL_SECTION l(mStreamsLock);
+			streams = mStreams;
+		}
+		// Decoding happens outside of the list lock; a stream stopped
+		// meanwhile ignores Fill().
+		for (auto& it : streams){
+			if (it.second->Fill()){
+				Remove(it.first);
+				mOnFinished(it.first);
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(UpdateIntervalMs));
+		return true;
+	}
+};
+
+//---------------------------------------------------------------------------
+AudioStreamerPtr AudioStreamer::Create(std::function<void(AudioId)> onFinished){
+	return AudioStreamerPtr(new AudioStreamer(onFinished), [](AudioStreamer* obj){ delete obj; });
+}
+
+AudioStreamer::AudioStreamer(std::function<void(AudioId)> onFinished)
+	: mImpl(new Impl(onFinished))
+{
+	mImpl->StartThread(this);
+}
+
+AudioStreamer::~AudioStreamer(){
+	mImpl->StopThread();
+}
+
+void AudioStreamer::Add(AudioId id, AudioStreamPtr stream){
+	mImpl->Add(id, stream);
+}
+
+void AudioStreamer::Remove(AudioId id){
+	mImpl->Remove(id);
+}
+
+size_t AudioStreamer::GetNumStreams() const{
+	return mImpl->GetNumStreams();
+}
+
+size_t AudioStreamer::GetMemoryUsage() const{
+	return mImpl->GetMemoryUsage();
+}
+
+bool AudioStreamer::Update(){
+	return mImpl->Update();
+}
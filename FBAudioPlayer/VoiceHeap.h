@@ -0,0 +1,150 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include <unordered_map>
+#include <vector>
+namespace fb{
+	/// Indexed binary heap of audio voices keyed by priority.
+	/// Priorities can be changed in place, so a voice moves only as far as
+	/// its new priority requires. Equal priorities are ordered by AudioId,
+	/// which makes voice stealing deterministic.
+	class VoiceHeap{
+	public:
+		struct Entry{
+			float mPriority;
+			AudioId mAudioId;
+		};
+
+		/// \a highestOnTop true: Top() is the voice with the highest priority
+		/// and the oldest id on ties. false: Top() is the lowest priority and
+		/// the newest id on ties.
+		explicit VoiceHeap(bool highestOnTop)
+			: mHighestOnTop(highestOnTop)
+		{
+		}
+
+		bool Empty() const { return mEntries.empty(); }
+		size_t Size() const { return mEntries.size(); }
+		bool Contains(AudioId id) const { return mIndices.find(id) != mIndices.end(); }
+		const Entry& Top() const { return mEntries.front(); }
+
+		void Clear(){
+			mEntries.clear();
+			mIndices.clear();
+		}
+
+		/// Inserts or updates.
+		void Set(AudioId id, float priority){
+			auto it = mIndices.find(id);
+			if (it == mIndices.end()){
+				mEntries.push_back(Entry{ priority, id });
+				size_t index = mEntries.size() - 1;
+				mIndices[id] = index;
+				SiftUp(index);
+				return;
+			}
+			size_t index = it->second;
+			if (mEntries[index].mPriority == priority)
+				return;
+			mEntries[index].mPriority = priority;
+			SiftDown(SiftUp(index));
+		}
+
+		bool Remove(AudioId id){
+			auto it = mIndices.find(id);
+			if (it == mIndices.end())
+				return false;
+			size_t index = it->second;
+			mIndices.erase(it);
+			size_t last = mEntries.size() - 1;
+			if (index != last){
+				mEntries[index] = mEntries[last];
+				mIndices[mEntries[index].mAudioId] = index;
+				mEntries.pop_back();
+				SiftDown(SiftUp(index));
+			}
+			else{
+				mEntries.pop_back();
+			}
+			return true;
+		}
+
+		AudioId Pop(){
+			AudioId id = mEntries.front().mAudioId;
+			Remove(id);
+			return id;
+		}
+
+	private:
+		bool Before(const Entry& a, const Entry& b) const{
+			if (a.mPriority != b.mPriority)
+				return mHighestOnTop ? a.mPriority > b.mPriority : a.mPriority < b.mPriority;
+			return mHighestOnTop ? a.mAudioId < b.mAudioId : a.mAudioId > b.mAudioId;
+		}
+
+		void Swap(size_t a, size_t b){
+			std::swap(mEntries[a], mEntries[b]);
+			mIndices[mEntries[a].mAudioId] = a;
+			mIndices[mEntries[b].mAudioId] = b;
+		}
+
+		size_t SiftUp(size_t index){
+			while (index > 0){
+				size_t parent = (index - 1) / 2;
+				if (!Before(mEntries[index], mEntries[parent]))
+					break;
+				Swap(index, parent);
+				index = parent;
+			}
+			return index;
+		}
+
+		size_t SiftDown(size_t index){
+			size_t size = mEntries.size();
+			while (true){
+				size_t left = index * 2 + 1;
+				if (left >= size)
+					break;
+				size_t best = left;
+				size_t right = left + 1;
+				if (right < size && Before(mEntries[right], mEntries[left]))
+					best = right;
+				if (!Before(mEntries[best], mEntries[index]))
+					break;
+				Swap(index, best);
+				index = best;
+			}
+			return index;
+		}
+
+		std::vector<Entry> mEntries;
+		std::unordered_map<AudioId, size_t> mIndices;
+		bool mHighestOnTop;
+	};
+}
@@ -28,6 +28,7 @@
 #pragma once
 #include "Types.h"
 #include <algorithm>
+#include <cmath>
 #undef min
 #undef max
 /**
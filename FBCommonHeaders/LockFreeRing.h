@@ -0,0 +1,120 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <atomic>
+#include <memory>
+namespace fb
+{
+	//---------------------------------------------------------------------------
+	// Bounded multi producer, single consumer ring.
+	// Slots are constructed once and reused. A producer writes its value
+	// in place, so nothing is allocated per push unless 'type' allocates
+	// on assignment. Unlike LockFreeQueue, 'type' can hold smart pointers.
+	// Capacity must be a power of two.
+	template<class type, unsigned Capacity>
+	class LockFreeRing
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+			"Capacity must be a power of two.");
+
+		struct Slot
+		{
+			std::atomic<unsigned> mSequence;
+			type mValue;
+		};
+		std::unique_ptr<Slot[]> mSlots;
+		// producers and the consumer touch different cache lines.
+		alignas(64) std::atomic<unsigned> mTail;
+		alignas(64) unsigned mHead;
+
+	public:
+		LockFreeRing()
+			: mSlots(new Slot[Capacity])
+			, mTail(0)
+			, mHead(0)
+		{
+			for (unsigned i = 0; i < Capacity; ++i){
+				mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// 'fill' receives the slot value and writes the new element into it.
+		// Returns false when the ring is full.
+		template<class Func>
+		bool Enq(Func fill)
+		{
+			unsigned pos = mTail.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Slot& slot = mSlots[pos & (Capacity - 1)];
+				unsigned seq = slot.mSequence.load(std::memory_order_acquire);
+				int diff = (int)(seq - pos);
+				if (diff == 0)
+				{
+					if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						fill(slot.mValue);
+						slot.mSequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false; // full
+				}
+				else
+				{
+					pos = mTail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// Single consumer only.
+		// 'consume' receives the slot value. Release what it holds
+		// (e.g. smart pointers) so the slot does not keep them alive.
+		// Returns false when the ring is empty or the next element is still
+		// being written.
+		template<class Func>
+		bool Deq(Func consume)
+		{
+			Slot& slot = mSlots[mHead & (Capacity - 1)];
+			unsigned seq = slot.mSequence.load(std::memory_order_acquire);
+			if (seq != mHead + 1)
+				return false;
+
+			consume(slot.mValue);
+			slot.mSequence.store(mHead + Capacity, std::memory_order_release);
+			++mHead;
+			return true;
+		}
+
+		unsigned GetCapacity() const {
+			return Capacity;
+		}
+	};
+}
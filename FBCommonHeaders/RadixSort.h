@@ -0,0 +1,87 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstring>
+namespace fb{
+	struct SortKeyIndex{
+		unsigned mKey;
+		unsigned mIndex;
+	};
+
+	/// Maps a float to an unsigned key which keeps the order of the floats.
+	inline unsigned FloatToSortKey(float f){
+		unsigned u;
+		memcpy(&u, &f, sizeof(u));
+		return (u & 0x80000000) ? ~u : (u | 0x80000000);
+	}
+
+	/// Stable LSD radix sort on mKey, 11 bits per pass. 
+	/// A pass is skipped when every key has the same digit.
+	inline void RadixSort(std::vector<SortKeyIndex>& data, std::vector<SortKeyIndex>& temp){
+		static const unsigned Bits = 11;
+		static const unsigned Buckets = 1 << Bits;
+		static const unsigned Mask = Buckets - 1;
+		static const unsigned NumPasses = 3;
+		auto num = data.size();
+		if (num < 64){
+			std::stable_sort(data.begin(), data.end(), [](const SortKeyIndex& a, const SortKeyIndex& b){
+				return a.mKey < b.mKey;
+			});
+			return;
+		}
+		unsigned counts[NumPasses][Buckets] = {};
+		for (auto& d : data){
+			for (unsigned p = 0; p < NumPasses; ++p){
+				++counts[p][(d.mKey >> (p * Bits)) & Mask];
+			}
+		}
+		temp.resize(num);
+		auto src = &data;
+		auto dest = &temp;
+		for (unsigned p = 0; p < NumPasses; ++p){
+			auto& count = counts[p];
+			auto shift = p * Bits;
+			if (count[((*src)[0].mKey >> shift) & Mask] == num)
+				continue;
+			unsigned offset = 0;
+			for (unsigned b = 0; b < Buckets; ++b){
+				auto c = count[b];
+				count[b] = offset;
+				offset += c;
+			}
+			for (auto& d : *src){
+				(*dest)[count[(d.mKey >> shift) & Mask]++] = d;
+			}
+			std::swap(src, dest);
+		}
+		if (src != &data)
+			data.swap(temp);
+	}
+}
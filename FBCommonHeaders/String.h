@@ -30,9 +30,29 @@
 #include <vector>
 #include <string>
 #include <cstdarg>
+#include <cstring>
+#include <cerrno>
+#if !defined(_PLATFORM_WINDOWS_)
+#include <strings.h>
+#endif
 
 typedef wchar_t WCHAR;    // wc,   16-bit UNICODE character
 
+#if !defined(_PLATFORM_WINDOWS_)
+inline int _stricmp(const char* a, const char* b){
+	return strcasecmp(a, b);
+}
+
+template<size_t N>
+inline int strcpy_s(char(&dest)[N], const char* src){
+	dest[0] = 0;
+	if (strlen(src) >= N)
+		return ERANGE;
+	strcpy(dest, src);
+	return 0;
+}
+#endif
+
 #if defined(_PLATFORM_MAC_)
 static inline int sprintf(TCHAR* str, size_t size, LPCTSTR format, ...){
 	int ret = -1;
@@ -48,7 +68,8 @@ inline int FB_WCSNCPY(WCHAR* dest, unsigned bufSize, const wchar_t* src, unsigne
 #if defined(_PLATFORM_WINDOWS_)
 	return wcsncpy_s(dest, bufSize, src, maxCount);
 #else
-	return wcsncpy(dest, src, maxCount);
+	wcsncpy(dest, src, maxCount);
+	return 0;
 #endif
 }
 
@@ -56,7 +77,8 @@ inline int FB_WCSCAT(WCHAR* dest, unsigned size, const wchar_t* src){
 #if defined(_PLATFORM_WINDOWS_)
 	return wcscat_s(dest, size, src);
 #else
-	return wcscat(dest, src);	
+	wcscat(dest, src);
+	return 0;
 #endif
 }
 
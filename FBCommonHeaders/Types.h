@@ -43,8 +43,13 @@ typedef unsigned char UINT8;
 typedef unsigned short USHORT;
 typedef unsigned int UINT;
 typedef unsigned long DWORD;
+#if defined(_MSC_VER)
 typedef unsigned __int64 UINT64;
 typedef __int64 INT64;
+#else
+typedef unsigned long long UINT64;
+typedef long long INT64;
+#endif
 #define FB_INVALID_REAL -FLT_MAX
 namespace fb{
 	typedef intptr_t ModuleHandle;
@@ -57,7 +62,7 @@ namespace fb{
 	typedef std::vector<unsigned char> ByteArray;
 	typedef std::shared_ptr<ByteArray> ByteArrayPtr;
 
-	typedef __int64 HWindowId;
+	typedef INT64 HWindowId;
 	static const HWindowId INVALID_HWND_ID = (HWindowId)-1;
 	typedef std::vector<std::string> StringVector;
 	typedef std::vector<std::wstring> WStringVector;	
@@ -47,6 +47,8 @@ A group containing header files only.
 	#else
 	#   error "Unknown Apple platform"
 	#endif
+#elif defined(__linux__)
+	#define _PLATFORM_LINUX_
 #else
 	#error "Platform is not supported"
 #endif
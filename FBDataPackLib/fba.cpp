@@ -513,8 +513,8 @@ namespace fb {
 			}
 		}
 		auto parent_folder = FileSystem::GetParentPath(fba_file_path.c_str());
-		std::string patch_filename = FormatString("%s/%s_patch_%u%s", parent_folder.c_str(),
-			FileSystem::GetName(fba_file_path.c_str()).c_str(), file_header.resource_version + 1, FB_FBAP_EXT);
+		std::string patch_filename = FormatString("%s/%s", parent_folder.c_str(),
+			get_patch_file_name(fba_file_path, file_header.resource_version).c_str());
 		FileSystem::BackupFile(patch_filename.c_str(), 5, "patch_backup");
 		BOOST_SCOPE_EXIT(void) {
 			FileSystem::RemoveAll("patch_backup");
@@ -738,6 +738,46 @@ namespace fb {
 		return true;
 	}
 
+	std::string get_patch_file_name(const std::string& fba_path, unsigned resource_version)
+	{
+		return FormatString("%s_patch_%u%s", FileSystem::GetName(fba_path.c_str()).c_str(), 
+			resource_version + 1, FB_FBAP_EXT);
+	}
+
+	bool get_required_patches(const std::string& target_folder, const std::string& password,
+		StringVector& out_patch_names)
+	{
+		auto dir_it = FileSystem::GetDirectoryIterator(target_folder.c_str(), false);
+		if (!dir_it) {
+			std::cerr << "Cannot open directory " << target_folder << std::endl;
+			return false;
+		}
+		while (dir_it->HasNext()) {
+			bool is_dir;
+			const char* path = dir_it->GetNextFilePath(&is_dir);
+			if (is_dir || !FileSystem::HasExtension(path, "fba"))
+				continue;
+			fba_file_header file_header;
+			{
+				std::ifstream stream(path, std::ios::binary);
+				if (!stream) {
+					std::cerr << "Cannot open " << path << std::endl;
+					return false;
+				}
+				boost::archive::binary_iarchive ar(stream);
+				ar & file_header;
+			}
+			if (!file_header.is_valid_fba_type())
+				continue;
+			if (!file_header.is_valid_password(password)) {
+				std::cerr << "Invalid password!\n";
+				return false;
+			}
+			out_patch_names.push_back(get_patch_file_name(path, file_header.resource_version));
+		}
+		return true;
+	}
+
 	bool apply_patch(const std::string& target_folder, const std::string& source_folder, const std::string& password, bool validation)
 	{
 		auto dir_it = FileSystem::GetDirectoryIterator(target_folder.c_str(), false);
@@ -773,7 +813,7 @@ namespace fb {
 				}
 				numFbas++;
 				auto patch_path = FileSystem::ConcatPath(source_folder.c_str(),
-					FormatString("%s_patch_%u%s", FileSystem::GetName(path).c_str(), file_header.resource_version + 1, FB_FBAP_EXT).c_str());
+					get_patch_file_name(path, file_header.resource_version).c_str());
 				{
 					std::ifstream stream(patch_path, std::ios::binary);
 					if (!stream) {
@@ -98,6 +98,13 @@ namespace fb {
 	bool create_patch_for_fba(const std::string& fba_name_only, const std::string& source_folder, const std::string& password,
 		const std::string& ignore_file, bool date_only, bool perform_validation);
 
+	/// The name of the patch which upgrades 'fba_path' from 'resource_version'.
+	/// ex) actors_patch_3.fbap
+	std::string get_patch_file_name(const std::string& fba_path, unsigned resource_version);
+	/// Collects the names of the patches apply_patch() needs for the packs in 'target_folder'.
+	/// Download them into the source folder of apply_patch(), e.g. with DownloadManager.
+	bool get_required_patches(const std::string& target_folder, const std::string& password,
+		StringVector& out_patch_names);
 	bool apply_patch(const std::string& target_folder, const std::string& source_folder, 
 		const std::string& password, bool validation);
 	bool apply_patch_individual(const std::string& dest_file, const std::string& source_file, 
@@ -103,7 +103,7 @@ void BillboardQuadFacade::DetachFromScenes(){
 }
 
 void BillboardQuadFacade::SetAlwaysPassCullingTest(bool passAlways){
-	mImpl->mBillboardQuad->GetBoundingVolumeWorld()->SetAlwaysPass(passAlways);
+	mImpl->mBillboardQuad->SetAlwaysPassCulling(passAlways);
 }
 
 void BillboardQuadFacade::SetBillobardData(const Vec3& pos, const Vec2& size, const Vec2& offset, const Color& color){
@@ -570,12 +570,18 @@ public:
 			mMeshGroup->SetScale(scale);
 	}
 
+	// Returns a copy of the local bounds.
 	const BoundingVolumePtr GetBoundingVolume() const{
+		const BoundingVolume* src = 0;
 		if (mMeshObject)
-			return mMeshObject->GetBoundingVolume();
+			src = &mMeshObject->GetBoundingVolume();
 		else if (mMeshGroup)
-			return mMeshGroup->GetBoundingVolume();
-		return 0;
+			src = &mMeshGroup->GetBoundingVolume();
+		if (!src)
+			return 0;
+		auto bv = BoundingVolume::Create(src->GetBVType());
+		*bv = *src;
+		return bv;
 	}
 
 	const BoundingVolumePtr GetBoundingVolumeWorld() const{
@@ -114,6 +114,7 @@ namespace fb{
 		void SetRotation(const Quat& rot);
 		const Quat& GetRotation() const;
 		void SetScale(const Vec3& scale);
+		/// Returns a copy of the local bounds.
 		const BoundingVolumePtr GetBoundingVolume() const;
 		const BoundingVolumePtr GetBoundingVolumeWorld() const;
 		bool RayCast(const Ray& ray, Vec3& pos, const ModelTriangle** tri);
@@ -132,10 +132,7 @@ MaterialPtr TrailFacade::GetMaterial(){
 }
 
 void TrailFacade::SetDiffuseColor(const Color& color){
-	auto mat = GetMaterial();
-	if (mat){
-		mat->SetDiffuseColor(color.GetVec4());
-	}
+	mImpl->mTrail->SetColor(color);
 }
 
 void TrailFacade::Update(TIME_PRECISION dt){
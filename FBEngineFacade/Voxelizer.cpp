@@ -36,7 +36,10 @@
 #include "FBRenderer/Material.h"
 #include "FBRenderer/Texture.h"
 #include "FBRenderer/RenderStrategyMinimum.h"
+#include "FBMathLib/VoxelVolume.h"
+#include "FBThread/ParallelFor.h"
 using namespace fb;
+
 class Voxelizer::Impl{
 public:
 	std::string mFilepath;
@@ -46,6 +49,16 @@ public:
 	std::vector<Vec3I> mHulls;
 	UINT mNumVoxels; // in one axis.
 	MeshObjectPtr mMeshObject;
+	VoxelVolumePtr mVolume;
+	bool mUseGPU;
+
+	//---------------------------------------------------------------------------
+	Impl()
+		: mVoxelSize(0)
+		, mNumVoxels(0)
+		, mUseGPU(false)
+	{
+	}
 
 	//---------------------------------------------------------------------------
 	bool RunVoxelizer(const char* filename, UINT numVoxels, bool swapYZ, bool oppositCull)
@@ -56,18 +69,88 @@ public:
 		importDesc.generateTangent = false;		
 		importDesc.oppositeCull = oppositCull;		
 		importDesc.yzSwap = swapYZ;
+		if (!mUseGPU){
+			importDesc.keepMeshData = true;
+			importDesc.useIndexBuffer = false;
+		}
+		mFilepath = filename;
 		mMeshObject = SceneObjectFactory::GetInstance().CreateMeshObject(filename, importDesc);
 		if (!mMeshObject){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to import(%s)", filename).c_str());
 		}
 
-		mNumVoxels = numVoxels;
-		// Draw depth maps
-		CalcDistanceMap();
+		if (mUseGPU){
+			mVolume = 0;
+			mNumVoxels = numVoxels;
+			// Draw depth maps
+			CalcDistanceMap();
+			return true;
+		}
 
+		if (!mMeshObject)
+			return false;
+		// Read only. Keeps the positions shared with the other clones.
+		// The groups are triangle lists since the index buffer is not used.
+		const MeshObject& mesh = *mMeshObject;
+		std::vector<Vec3> merged;
+		const Vec3* positions = 0;
+		size_t numPositions = 0;
+		unsigned numGroups = mesh.GetNumMaterialGroups();
+		for (unsigned i = 0; i < numGroups; ++i){
+			size_t num = 0;
+			auto groupPositions = mesh.GetPositions(i, num);
+			if (!groupPositions || num == 0)
+				continue;
+			if (!positions){
+				positions = groupPositions;
+				numPositions = num;
+				continue;
+			}
+			if (merged.empty())
+				merged.assign(positions, positions + numPositions);
+			merged.insert(merged.end(), groupPositions, groupPositions + num);
+			positions = &merged[0];
+			numPositions = merged.size();
+		}
+		if (!positions || numPositions == 0){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Mesh data of %s is not kept.", filename).c_str());
+			return false;
+		}
+		float radius = mMeshObject->GetBoundingVolume().GetRadius() * 1.05f;
+		Voxelize(positions, numPositions, 0, 0, numVoxels, radius);
 		return true;
 	}
 
+	bool RunVoxelizer(const Vec3* positions, unsigned numPositions,
+		const unsigned* indices, unsigned numIndices, UINT numVoxels)
+	{
+		if (!positions || numPositions == 0 || numVoxels == 0){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return false;
+		}
+		Real radiusSQ = 0;
+		for (unsigned i = 0; i < numPositions; ++i){
+			radiusSQ = std::max(radiusSQ, positions[i].LengthSQ());
+		}
+		Voxelize(positions, numPositions, indices, numIndices, numVoxels, std::sqrt(radiusSQ) * 1.05f);
+		return true;
+	}
+
+	void Voxelize(const Vec3* positions, unsigned numPositions,
+		const unsigned* indices, unsigned numIndices, UINT numVoxels, Real radius)
+	{
+		if (radius <= 0)
+			radius = 1.f;
+		// VoxelVolume works in whole 8x8x8 bricks.
+		mNumVoxels = (numVoxels + 7) & ~7;
+		mVoxelSize = radius * 2.f / mNumVoxels;
+		mVolume = std::make_shared<VoxelVolume>(mNumVoxels, Vec3(-radius), mVoxelSize);
+		mVolume->Voxelize(positions, numPositions, indices, numIndices, true, GetTaskParallelFor());
+		mVolume->GetSurfaceVoxels(mHulls, GetTaskParallelFor());
+		mDistanceMap.clear();
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Total hull = %u", mHulls.size()).c_str());
+	}
+
 	MeshObjectPtr GetMeshObject() const
 	{
 		return mMeshObject;
@@ -93,7 +176,7 @@ public:
 			return;
 		}
 
-		float radius = mMeshObject->GetBoundingVolume()->GetRadius() * 1.05f;
+		float radius = mMeshObject->GetBoundingVolume().GetRadius() * 1.05f;
 		// draw depth maps;
 		// x axis
 		RenderTargetParamEx param;
@@ -397,6 +480,20 @@ bool Voxelizer::RunVoxelizer(const char* filename, UINT numVoxels, bool swapYZ,
 	return mImpl->RunVoxelizer(filename, numVoxels, swapYZ, oppositCull);
 }
 
+bool Voxelizer::RunVoxelizer(const Vec3* positions, unsigned numPositions,
+	const unsigned* indices, unsigned numIndices, UINT numVoxels)
+{
+	return mImpl->RunVoxelizer(positions, numPositions, indices, numIndices, numVoxels);
+}
+
+void Voxelizer::SetUseGPU(bool use) {
+	mImpl->mUseGPU = use;
+}
+
+VoxelVolumeConstPtr Voxelizer::GetVolume() const {
+	return mImpl->mVolume;
+}
+
 MeshObjectPtr Voxelizer::GetMeshObject() const {
 	return mImpl->GetMeshObject();
 }
@@ -29,7 +29,9 @@
 #include "FBCommonHeaders/Types.h"
 namespace fb{
 	class Vec3I;
+	class Vec3;
 	FB_DECLARE_SMART_PTR(MeshObject);
+	FB_DECLARE_SMART_PTR(VoxelVolume);
 	FB_DECLARE_SMART_PTR(Voxelizer);
 	class FB_DLL_ENGINEFACADE Voxelizer{
 		FB_DECLARE_PIMPL_NON_COPYABLE(Voxelizer);
@@ -40,7 +42,16 @@ namespace fb{
 		static VoxelizerPtr Create();
 		typedef std::vector<fb::Vec3I> HULLS;
 
+		/// The volume is built on the CPU unless SetUseGPU(true) is called.
 		bool RunVoxelizer(const char* filename, UINT numVoxels, bool swapYZ, bool oppositCull);
+		/// Does not touch the renderer. 'indices' can be null for a triangle list.
+		/// The volume is centered at the origin.
+		bool RunVoxelizer(const Vec3* positions, unsigned numPositions,
+			const unsigned* indices, unsigned numIndices, UINT numVoxels);
+		/// Renders depth maps into a render target instead. Default is false.
+		void SetUseGPU(bool use);
+		/// Null when the GPU path was used.
+		VoxelVolumeConstPtr GetVolume() const;
 		MeshObjectPtr GetMeshObject() const;		
 		const HULLS& GetHulls() const;
 	};
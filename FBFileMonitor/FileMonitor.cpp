@@ -27,6 +27,15 @@
 
 #include "stdafx.h"
 #include "FileMonitor.h"
+#include "FBStringLib/StringId.h"
+#if defined(_PLATFORM_LINUX_)
+#include <sys/inotify.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
 using namespace fb;
 FileMonitor* sMonitorRaw = 0;
 FileMonitorWeakPtr sMonitor;
@@ -34,20 +43,83 @@ std::set<std::string> mIgnoreDirectories;
 namespace fb {
 	//FB_CRITICAL_SECTION gFileMonitorMutex;
 	static const unsigned FILE_CHANGE_BUFFER_SIZE = 8000;
+	// A file is reported once it had no event for this long.
+	static const INT64 DebounceMs = 150;
+	static const INT64 CheckIntervalMs = 100;
+
+	static INT64 GetTickMs(){
+		using namespace std::chrono;
+		return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	static bool IsIgnoredDirectory(const std::string& unifiedPath){
+		for (auto& dir : mIgnoreDirectories) {
+			if (StartsWith(unifiedPath, dir)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct ChangedFile{
+		std::string mWatchDir;
+		std::string mFilePath;
+		INT64 mLastEventTick;
+	};
+
+	// Change events collected by a monitor thread. Repeated events for a
+	// file only move its timestamp, so a save writing several times is
+	// reported once.
+	class ChangedFileSet{
+		CriticalSection mGuard;
+		// (watch dir, file) - last event tick
+		std::map<std::pair<std::string, std::string>, INT64> mFiles;
+		std::atomic<bool> mHasChangedFiles;
+
+	public:
+		ChangedFileSet()
+			: mHasChangedFiles(false)
+		{
+		}
+
+		void Add(const std::string& watchDir, const std::string& filepath){
+			ENTER_CRITICAL_SECTION lock(mGuard);
+			mFiles[std::make_pair(watchDir, filepath)] = GetTickMs();
+			mHasChangedFiles = true;
+		}
+
+		bool HasChangedFiles() const { return mHasChangedFiles; }
+
+		/// Moves the files which had no event for DebounceMs to \a files.
+		void TakeSettled(std::vector<ChangedFile>& files, INT64 curTick){
+			ENTER_CRITICAL_SECTION lock(mGuard);
+			for (auto it = mFiles.begin(); it != mFiles.end(); /**/){
+				if (curTick - it->second >= DebounceMs){
+					ChangedFile file = { it->first.first, it->first.second, it->second };
+					files.push_back(file);
+					it = mFiles.erase(it);
+				}
+				else{
+					++it;
+				}
+			}
+			mHasChangedFiles = !mFiles.empty();
+		}
+	};
+
+#if defined(_PLATFORM_WINDOWS_)
+	// One thread per watched directory.
 	class FileChangeMonitorThread : public Thread{		
 		HANDLE mExitFileChangeThread;
 		std::vector<BYTE> mFileChangeBuffer;
 		OVERLAPPED	mOverlapped; // platform dependent.
 		HANDLE mMonitoringDirectory;
 		std::string mWatchDir;
-		CriticalSection mChangedFilesGuard;
-		std::set<std::string> mChangedFiles;
-		bool mHasChangedFiles;
+		ChangedFileSet mChangedFiles;
 		std::atomic<bool> mExiting;
 	public:
 		FileChangeMonitorThread()
 			: mExiting(false)			
-			, mHasChangedFiles(false)
 			, mMonitoringDirectory(INVALID_HANDLE_VALUE)
 		{
 			mExitFileChangeThread = CreateEvent(0, FALSE, FALSE, 0);
@@ -133,18 +205,8 @@ namespace fb {
 						fileName, _ARRAYSIZE(fileName) - 1, 0, 0);
 					fileName[count] = 0;
 					auto unifiedPath = FileSystem::UnifyFilepath(fileName);
-					bool ignore = false;
-					for (auto& dir : mIgnoreDirectories) {
-						if (StartsWith(unifiedPath, dir)) {
-							ignore = true;
-							break;
-						}
-					}
-					if (!ignore) {
-						ENTER_CRITICAL_SECTION lock(mChangedFilesGuard);
-						mChangedFiles.insert(unifiedPath);
-						mHasChangedFiles = true;
-
+					if (!IsIgnoredDirectory(unifiedPath)) {
+						mChangedFiles.Add(mWatchDir, unifiedPath);
 						if (sMonitorRaw) {
 							sMonitorRaw->OnChangeDetected();
 						}
@@ -196,30 +258,186 @@ namespace fb {
 			return true;
 		}
 
-		bool HasChangedFiles() const { return mHasChangedFiles; }
-		void GetChangedFiles(std::vector<std::pair<std::string, std::string> >& files){
-			ENTER_CRITICAL_SECTION lock(mChangedFilesGuard);
-			for (auto& str : mChangedFiles){
-				auto v = std::make_pair(mWatchDir, str);
-				if (!ValueExistsInVector(files, v))
-					files.push_back(v);
+		ChangedFileSet& GetChangedFiles() { return mChangedFiles; }
+	};
+
+#elif defined(_PLATFORM_LINUX_)
+	// One thread waits on a single inotify descriptor for every watched
+	// tree. inotify is not recursive, so each directory gets its own
+	// watch and new directories are added when they appear.
+	class InotifyMonitorThread : public Thread{
+		struct Watch{
+			std::string mWatchDir;
+			// relative to mWatchDir, ends with '/' unless empty.
+			std::string mSubDir;
+		};
+		int mInotify;
+		int mEpoll;
+		int mWakeUp;
+		CriticalSection mWatchesGuard;
+		std::unordered_map<int, Watch> mWatches;
+		std::vector<char> mEventBuffer;
+		ChangedFileSet mChangedFiles;
+		std::atomic<bool> mExiting;
+
+	public:
+		InotifyMonitorThread()
+			: mEventBuffer(FILE_CHANGE_BUFFER_SIZE)
+			, mExiting(false)
+		{
+			mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			mEpoll = epoll_create1(EPOLL_CLOEXEC);
+			mWakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (mInotify < 0 || mEpoll < 0 || mWakeUp < 0){
+				Logger::Log(FB_ERROR_LOG_ARG, "Cannot initialize inotify.");
+				return;
+			}
+			epoll_event ev = {};
+			ev.events = EPOLLIN;
+			ev.data.fd = mInotify;
+			epoll_ctl(mEpoll, EPOLL_CTL_ADD, mInotify, &ev);
+			ev.data.fd = mWakeUp;
+			epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeUp, &ev);
+		}
+
+		~InotifyMonitorThread(){
+			if (mInotify >= 0)
+				close(mInotify);
+			if (mEpoll >= 0)
+				close(mEpoll);
+			if (mWakeUp >= 0)
+				close(mWakeUp);
+		}
+
+		void AddTree(const char* dirPath){
+			std::string watchDir(ValidCString(dirPath) ? dirPath : "");
+			if (watchDir.empty())
+				watchDir = "./";
+			else
+				watchDir = FileSystem::AddEndingSlashIfNot(watchDir.c_str());
+			AddDirectory(watchDir, std::string());
+		}
+
+		void AddDirectory(const std::string& watchDir, const std::string& subDir){
+			if (mInotify < 0 || IsIgnoredDirectory(subDir))
+				return;
+			auto path = watchDir + subDir;
+			int wd = inotify_add_watch(mInotify, path.c_str(),
+				IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+			if (wd < 0){
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot watch the directory(%s)!", path.c_str()).c_str());
+				return;
+			}
+			{
+				ENTER_CRITICAL_SECTION lock(mWatchesGuard);
+				Watch watch = { watchDir, subDir };
+				mWatches[wd] = watch;
+			}
+			auto dir = opendir(path.c_str());
+			if (!dir)
+				return;
+			while (auto entry = readdir(dir)){
+				if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+					continue;
+				bool isDir = entry->d_type == DT_DIR;
+				if (entry->d_type == DT_UNKNOWN){
+					struct stat st;
+					isDir = stat((path + entry->d_name).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+				}
+				if (isDir)
+					AddDirectory(watchDir, subDir + entry->d_name + "/");
 			}
-			mChangedFiles.clear();
-			mHasChangedFiles = false;
+			closedir(dir);
 		}
+
+		void Stop(){
+			mExiting = true;
+			ForceExit(false);
+			if (mWakeUp >= 0){
+				UINT64 one = 1;
+				auto written = write(mWakeUp, &one, sizeof(one));
+				(void)written;
+			}
+		}
+
+		bool Run() {
+			if (mEpoll < 0)
+				return false;
+			epoll_event events[2];
+			int num = epoll_wait(mEpoll, events, 2, -1);
+			if (mExiting)
+				return false;
+			for (int i = 0; i < num; ++i){
+				if (events[i].data.fd == mInotify)
+					ProcessEvents();
+			}
+			return !mExiting;
+		}
+
+		void ProcessEvents(){
+			bool detected = false;
+			for (;;){
+				auto len = read(mInotify, &mEventBuffer[0], mEventBuffer.size());
+				if (len <= 0)
+					break;
+				for (char* p = &mEventBuffer[0]; p < &mEventBuffer[0] + len; /**/){
+					auto event = (const inotify_event*)p;
+					p += sizeof(inotify_event) + event->len;
+					Watch watch;
+					{
+						ENTER_CRITICAL_SECTION lock(mWatchesGuard);
+						auto it = mWatches.find(event->wd);
+						if (it == mWatches.end())
+							continue;
+						if (event->mask & IN_IGNORED){
+							mWatches.erase(it);
+							continue;
+						}
+						watch = it->second;
+					}
+					if (event->len == 0)
+						continue;
+					auto filepath = watch.mSubDir + event->name;
+					if (event->mask & IN_ISDIR){
+						if (event->mask & (IN_CREATE | IN_MOVED_TO))
+							AddDirectory(watch.mWatchDir, filepath + "/");
+						continue;
+					}
+					// IN_CREATE alone is followed by IN_CLOSE_WRITE.
+					if (!(event->mask & (IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO)))
+						continue;
+					if (IsIgnoredDirectory(filepath))
+						continue;
+					mChangedFiles.Add(watch.mWatchDir, filepath);
+					detected = true;
+				}
+			}
+			if (detected && sMonitorRaw) {
+				sMonitorRaw->OnChangeDetected();
+			}
+		}
+
+		ChangedFileSet& GetChangedFiles() { return mChangedFiles; }
 	};
+#endif
 }
 
 static const int NumMaximumMonitor = 10;
 class FileMonitor::Impl{
 public:
 	FileMonitor* mSelf;
+#if defined(_PLATFORM_WINDOWS_)
 	FileChangeMonitorThread mFileMonitorThread[NumMaximumMonitor];
+#elif defined(_PLATFORM_LINUX_)
+	InotifyMonitorThread mInotifyThread;
+#endif
 	std::ofstream mErrorStream;
 	std::streambuf* mStdErrorStream;
-	std::vector<std::pair<std::string, std::string> > mChangedFiles;
+	std::vector<ChangedFile> mChangedFiles;
 	std::set<std::string> mIgnoreFileChanges;
 	std::vector<std::pair<std::string, float>> mIgnoreFileChangesForSec;
+	// case insensitive path id - tick. Changes before it are dropped.
+	std::unordered_map<StringId, INT64> mResumedFiles;
 	INT64 mLastCheckedTime;
 
 	Impl(FileMonitor* self)
@@ -232,10 +450,15 @@ public:
 		
 	}
 	void TerminatesAllThreads(){
+#if defined(_PLATFORM_WINDOWS_)
 		for (auto& it : mFileMonitorThread){
 			it.Stop();
 			it.Join();
 		}
+#elif defined(_PLATFORM_LINUX_)
+		mInotifyThread.Stop();
+		mInotifyThread.Join();
+#endif
 	}
 
 	void StartMonitor(const char* dirPath){		
@@ -243,6 +466,12 @@ public:
 		{
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
 		}
+#if defined(_PLATFORM_LINUX_)
+		mInotifyThread.AddTree(dirPath);
+		if (!mInotifyThread.IsJoinable()){
+			mInotifyThread.CreateThread(1024, "FileMonitorThread");
+		}
+#else
 		int idx = 0;
 		for (idx = 0; idx < NumMaximumMonitor; ++idx){
 			if (!mFileMonitorThread[idx].IsJoinable()){
@@ -256,6 +485,39 @@ public:
 		auto& thread = mFileMonitorThread[idx];				
 		thread.SetWatchDir(dirPath);
 		thread.CreateThread(1024, FormatString("FileMonitorThread%d", idx).c_str());
+#endif
+	}
+
+	void CollectChangedFiles(INT64 curTick){
+#if defined(_PLATFORM_WINDOWS_)
+		for (auto& it : mFileMonitorThread){
+			auto& changed = it.GetChangedFiles();
+			if (changed.HasChangedFiles()){
+				changed.TakeSettled(mChangedFiles, curTick);
+			}
+		}
+#elif defined(_PLATFORM_LINUX_)
+		auto& changed = mInotifyThread.GetChangedFiles();
+		if (changed.HasChangedFiles()){
+			changed.TakeSettled(mChangedFiles, curTick);
+		}
+#endif
+	}
+
+	template<class Func>
+	void ForEachObserver(Func func){
+		for (int i = 0; i < 2; ++i){
+			auto& observers = mSelf->mObservers_[i]; //FileChange_Engine and FileChange_Game
+			for (auto oit = observers.begin(); oit != observers.end(); /**/){
+				auto observer = oit->lock();
+				if (!observer){
+					oit = observers.erase(oit);
+					continue;
+				}
+				++oit;
+				func(observer);
+			}
+		}
 	}
 	void OnChangeDetected(){
 		for (int i = 0; i < 2; ++i){
@@ -267,15 +529,16 @@ public:
 		}
 	}
 	bool Check(){
-		using namespace std::chrono;		
-		auto curTick = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+		auto curTick = GetTickMs();
 		bool recheck = true;
-		if (curTick - mLastCheckedTime > 500)
+		if (curTick - mLastCheckedTime > CheckIntervalMs)
 		{
+			float elapsedSec = mLastCheckedTime == 0 ? 
+				CheckIntervalMs / 1000.f : (curTick - mLastCheckedTime) / 1000.f;
 			for (auto it = mIgnoreFileChangesForSec.begin();
 				it != mIgnoreFileChangesForSec.end();
 				/**/){
-				it->second -= 0.5f;
+				it->second -= elapsedSec;
 				if (it->second <= 0){
 					it = mIgnoreFileChangesForSec.erase(it);
 				}
@@ -285,21 +548,25 @@ public:
 			}
 			recheck = false;
 			mLastCheckedTime = curTick;
-			for (auto& it : mFileMonitorThread){
-				if (it.HasChangedFiles()){
-					std::vector<std::pair<std::string, std::string> > files;
-					it.GetChangedFiles(files);					
-					mChangedFiles.insert(mChangedFiles.end(), files.begin(), files.end());
-				}				
-			}
-			
+			CollectChangedFiles(curTick);
+
+			struct ReadyFile{
+				std::string mWatchDir;
+				std::string mFilePath;
+				std::string mFileFullPath;
+				std::string mLoweredExtension;
+			};
+			std::vector<ReadyFile> readyFiles;
+			// The working directory and the resource folders can be watched
+			// at the same time. Report a file once even if both saw it.
+			std::unordered_set<StringId> readyIds;
 			for (auto it = mChangedFiles.begin(); it != mChangedFiles.end();)
 			{
-				std::string filepath = it->second;				
-				std::string filefullpath = it->first + it->second;
-				auto resourceFolder = FileSystem::IsResourceFolderByVal(it->first.c_str());
+				std::string filepath = it->mFilePath;
+				std::string filefullpath = it->mWatchDir + it->mFilePath;
+				auto resourceFolder = FileSystem::IsResourceFolderByVal(it->mWatchDir.c_str());
 				if (resourceFolder) {
-					auto watchDir = FileSystem::UnifyFilepath(it->first.c_str());
+					auto watchDir = FileSystem::UnifyFilepath(it->mWatchDir.c_str());
 					if (watchDir.back() != '/') {
 						watchDir.push_back('/');
 					}					
@@ -326,17 +593,22 @@ public:
 				if (ignoreIt != mIgnoreFileChanges.end()){					
 					throwAway = true;
 				}
-				std::string fileKey(filepath);
+				auto fileId = GetStringIdNoCase(filepath);
 				for (auto& it : mIgnoreFileChangesForSec){
-					if (it.first == fileKey){
+					if (GetStringIdNoCase(it.first) == fileId){
 						throwAway = true;
 					}
 				}
-				if (!hasExtension || sdfFile || throwAway)
+				auto resumedIt = mResumedFiles.find(fileId);
+				if (resumedIt != mResumedFiles.end() && it->mLastEventTick <= resumedIt->second){
+					throwAway = true;
+				}
+				if (!hasExtension || sdfFile || throwAway || readyIds.find(fileId) != readyIds.end())
 				{
 					it = mChangedFiles.erase(it);
 					continue;
 				}
+#if defined(_PLATFORM_WINDOWS_)
 				{
 					FileSystem::Open file(filefullpath.c_str(), "a+", FileSystem::ReadAllow, FileSystem::SkipErrorMsg);
 					auto err = file.Error();
@@ -344,9 +616,47 @@ public:
 						canOpen = false;
 					}
 				}
+#elif defined(_PLATFORM_LINUX_)
+				// Opening the file for writing would be reported as another
+				// change. inotify reports the writer closing the file, so
+				// only files which are gone, e.g. temporary files of an
+				// editor, are dropped.
+				if (access(filefullpath.c_str(), F_OK) != 0){
+					it = mChangedFiles.erase(it);
+					continue;
+				}
+#endif
 
 				if (canOpen)
 				{
+					ReadyFile ready = { it->mWatchDir, filepath, filefullpath, extension };
+					ToLowerCase(ready.mLoweredExtension);
+					readyFiles.push_back(ready);
+					readyIds.insert(fileId);
+					it = mChangedFiles.erase(it);
+				}
+				else
+				{
+					recheck = true;
+					++it;
+				}
+			}
+			// Every event from before a resume has settled and was dropped
+			// above by now.
+			for (auto it = mResumedFiles.begin(); it != mResumedFiles.end(); /**/){
+				if (curTick - it->second >= DebounceMs){
+					it = mResumedFiles.erase(it);
+				}
+				else{
+					++it;
+				}
+			}
+
+			if (!readyFiles.empty()){
+				ForEachObserver([&readyFiles](const FileMonitor::ObserverPtr& observer){
+					observer->OnFileChangeBatchBegin(readyFiles.size());
+				});
+				for (auto& file : readyFiles){
 					/*int startEnum = shader || material || texture || particle || xml ?
 						IFileChangeObserver::FileChange_Engine : IFileChangeObserver::FileChange_Game;*/
 					for (int i = 0; i < 2; ++i){
@@ -358,23 +668,16 @@ public:
 								continue;
 							}
 							++oit;
-							std::string loweredStr(FileSystem::GetExtension(filepath.c_str()));
-							ToLowerCase(loweredStr);							
-							
-							bool processed = observer->OnFileChanged(it->first.c_str(), filepath.c_str(), filefullpath.c_str(), loweredStr.c_str());
+							bool processed = observer->OnFileChanged(file.mWatchDir.c_str(), file.mFilePath.c_str(), 
+								file.mFileFullPath.c_str(), file.mLoweredExtension.c_str());
 							if (processed)
 								break;
 						}
 					}
-
-					it = mChangedFiles.erase(it);
-					
-				}
-				else
-				{
-					recheck = true;
-					++it;
 				}
+				ForEachObserver([](const FileMonitor::ObserverPtr& observer){
+					observer->OnFileChangeBatchEnd();
+				});
 			}
 		}
 		return !mChangedFiles.empty() || recheck;
@@ -399,8 +702,12 @@ public:
 
 	void ResumeMonitoringOnFile(const char* filepath){
 		auto it = mIgnoreFileChanges.find(filepath);
-		if (it != mIgnoreFileChanges.end())
+		if (it != mIgnoreFileChanges.end()){
 			mIgnoreFileChanges.erase(it);
+			// Events caused by the write which was ignored can still be
+			// in the debounce window.
+			mResumedFiles[GetStringIdNoCase(filepath)] = GetTickMs();
+		}
 	}
 };
 
@@ -44,6 +44,11 @@ namespace fb
 		/// extension contains "." ex).xml
 		/// returns 'processed'
 		virtual bool OnFileChanged(const char* watchDir, const char* filepath, const char* combinedPath, const char* loweredExtension) = 0;
+		/// Changes are delivered in batches. A file appears once per batch
+		/// however many times it was written. Override these to defer work
+		/// which depends on several files, e.g. shader reloading.
+		virtual void OnFileChangeBatchBegin(size_t numFiles) {}
+		virtual void OnFileChangeBatchEnd() {}
 		
 	};
 }
\ No newline at end of file
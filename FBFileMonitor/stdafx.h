@@ -33,10 +33,18 @@
 #define FB_DLL_FILESYSTEM __declspec(dllimport)
 #define FB_DLL_THREAD __declspec(dllimport)
 #else
+#define FB_DLL_FILEMONITOR
+#define FB_DLL_FILESYSTEM
+#define FB_DLL_THREAD
 #endif
 
 #include <fstream>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <chrono>
 #include <algorithm>
 
 #include "FBCommonHeaders/Types.h"
@@ -41,6 +41,12 @@ Handling file operations. Implemented on the top of boost::filesystem
 #include "TinyXmlLib/tinyxml2.h"
 #undef CreateDirectory
 #undef CopyFile
+#if !defined(_PLATFORM_WINDOWS_)
+typedef int errno_t;
+#endif
+#if !defined(_NOEXCEPT)
+#define _NOEXCEPT noexcept
+#endif
 namespace fb{
 	class DirectoryIterator;
 	typedef std::shared_ptr<DirectoryIterator> DirectoryIteratorPtr;
@@ -0,0 +1,501 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "BatchMath.h"
+#include "Mat44.h"
+#include "Vec3.h"
+#include "Quat.h"
+#include "AABB.h"
+#include "Plane.h"
+#include "Math.h"
+#include "FBCommonHeaders/Helpers.h"
+#if !defined(FB_DOUBLE_PRECISION) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define FB_BATCHMATH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FB_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define FB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+using namespace fb;
+
+static_assert(sizeof(Vec3) == sizeof(Real) * 3, "Vec3 must be tightly packed.");
+static_assert(sizeof(Mat44) == sizeof(Real) * 16, "Mat44 must be tightly packed.");
+
+struct BatchMathFunctions{
+	void(*mMultiplyMatrices)(const Mat44* a, const Mat44* b, Mat44* out, unsigned num);
+	void(*mTransformPoints)(const Mat44& m, const Vec3* points, Vec3* out, unsigned num, bool translate);
+	void(*mTransformAABBs)(const Mat44& m, const AABB* aabbs, AABB* out, unsigned num);
+	void(*mSlerpQuats)(const Quat* a, const Quat* b, const Real* t, Quat* out, unsigned num);
+	void(*mCullSpheres)(const Plane* planes, unsigned numPlanes,
+		const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num,
+		unsigned char* culled);
+};
+
+//---------------------------------------------------------------------------
+// Scalar
+//---------------------------------------------------------------------------
+static void MultiplyMatricesScalar(const Mat44* a, const Mat44* b, Mat44* out, unsigned num){
+	for (unsigned i = 0; i < num; ++i){
+		out[i] = a[i] * b[i];
+	}
+}
+
+static void TransformPointsScalar(const Mat44& m, const Vec3* points, Vec3* out, unsigned num, bool translate){
+	Real tx = translate ? m.m[0][3] : 0.f;
+	Real ty = translate ? m.m[1][3] : 0.f;
+	Real tz = translate ? m.m[2][3] : 0.f;
+	for (unsigned i = 0; i < num; ++i){
+		auto p = points[i];
+		out[i].x = m.m[0][0] * p.x + m.m[0][1] * p.y + m.m[0][2] * p.z + tx;
+		out[i].y = m.m[1][0] * p.x + m.m[1][1] * p.y + m.m[1][2] * p.z + ty;
+		out[i].z = m.m[2][0] * p.x + m.m[2][1] * p.y + m.m[2][2] * p.z + tz;
+	}
+}
+
+static void TransformAABBsScalar(const Mat44& m, const AABB* aabbs, AABB* out, unsigned num){
+	for (unsigned i = 0; i < num; ++i){
+		if (!aabbs[i].IsValid()){
+			out[i] = aabbs[i];
+			continue;
+		}
+		auto center = (aabbs[i].GetMin() + aabbs[i].GetMax()) * .5f;
+		auto extent = (aabbs[i].GetMax() - aabbs[i].GetMin()) * .5f;
+		Vec3 newCenter, newExtent;
+		for (int r = 0; r < 3; ++r){
+			newCenter[r] = m.m[r][0] * center.x + m.m[r][1] * center.y + m.m[r][2] * center.z + m.m[r][3];
+			newExtent[r] = std::abs(m.m[r][0]) * extent.x + std::abs(m.m[r][1]) * extent.y + std::abs(m.m[r][2]) * extent.z;
+		}
+		out[i] = AABB(newCenter - newExtent, newCenter + newExtent);
+	}
+}
+
+// Weights of Slerp(Quat, Quat, Real) in Math.cpp. 'dot' must be positive.
+static void GetSlerpWeights(Real dot, Real t, Real& wa, Real& wb){
+	if (dot >= 1.f){
+		wa = 1.f;
+		wb = 0.f;
+		return;
+	}
+	Real halfTheta = acos(dot);
+	Real sinHalfTheta = sqrt(1.0f - dot * dot);
+	if (fabs(sinHalfTheta) < 0.001f){
+		wa = wb = 0.5f;
+		return;
+	}
+	wa = sin((1.0f - t) * halfTheta) / sinHalfTheta;
+	wb = sin(t * halfTheta) / sinHalfTheta;
+}
+
+static void SlerpQuatsScalar(const Quat* a, const Quat* b, const Real* t, Quat* out, unsigned num){
+	for (unsigned i = 0; i < num; ++i){
+		out[i] = Slerp(a[i], b[i], t[i]);
+	}
+}
+
+static void CullSpheresScalar(const Plane* planes, unsigned numPlanes,
+	const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num,
+	unsigned char* culled)
+{
+	for (unsigned i = 0; i < num; ++i){
+		culled[i] = 0;
+		for (unsigned p = 0; p < numPlanes; ++p){
+			auto& n = planes[p].mNormal;
+			if (n.x * x[i] + n.y * y[i] + n.z * z[i] - planes[p].mConstant <= -radius[i]){
+				culled[i] = 1;
+				break;
+			}
+		}
+	}
+}
+
+static const BatchMathFunctions ScalarFunctions = {
+	MultiplyMatricesScalar,
+	TransformPointsScalar,
+	TransformAABBsScalar,
+	SlerpQuatsScalar,
+	CullSpheresScalar,
+};
+
+#if FB_BATCHMATH_X86
+//---------------------------------------------------------------------------
+// SSE
+//---------------------------------------------------------------------------
+static void MultiplyMatricesSSE(const Mat44* a, const Mat44* b, Mat44* out, unsigned num){
+	for (unsigned i = 0; i < num; ++i){
+		auto& bm = b[i].m;
+		auto b0 = _mm_loadu_ps(bm[0]);
+		auto b1 = _mm_loadu_ps(bm[1]);
+		auto b2 = _mm_loadu_ps(bm[2]);
+		auto b3 = _mm_loadu_ps(bm[3]);
+		__m128 rows[4];
+		for (int r = 0; r < 4; ++r){
+			auto& am = a[i].m[r];
+			rows[r] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(am[0]), b0), _mm_mul_ps(_mm_set1_ps(am[1]), b1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(am[2]), b2), _mm_mul_ps(_mm_set1_ps(am[3]), b3)));
+		}
+		// 'out' can be 'a' or 'b'.
+		for (int r = 0; r < 4; ++r){
+			_mm_storeu_ps(out[i].m[r], rows[r]);
+		}
+	}
+}
+
+static void TransformPointsSSE(const Mat44& m, const Vec3* points, Vec3* out, unsigned num, bool translate){
+	__m128 rows[3][4];
+	for (int r = 0; r < 3; ++r){
+		for (int c = 0; c < 4; ++c){
+			rows[r][c] = _mm_set1_ps(c == 3 && !translate ? 0.f : m.m[r][c]);
+		}
+	}
+	unsigned i = 0;
+	for (; i + 4 <= num; i += 4){
+		float x[4], y[4], z[4];
+		for (int k = 0; k < 4; ++k){
+			x[k] = points[i + k].x; y[k] = points[i + k].y; z[k] = points[i + k].z;
+		}
+		auto vx = _mm_loadu_ps(x);
+		auto vy = _mm_loadu_ps(y);
+		auto vz = _mm_loadu_ps(z);
+		float result[3][4];
+		for (int r = 0; r < 3; ++r){
+			_mm_storeu_ps(result[r], _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(rows[r][0], vx), _mm_mul_ps(rows[r][1], vy)),
+				_mm_add_ps(_mm_mul_ps(rows[r][2], vz), rows[r][3])));
+		}
+		for (int k = 0; k < 4; ++k){
+			out[i + k].x = result[0][k]; out[i + k].y = result[1][k]; out[i + k].z = result[2][k];
+		}
+	}
+	TransformPointsScalar(m, points + i, out + i, num - i, translate);
+}
+
+static void TransformAABBsSSE(const Mat44& m, const AABB* aabbs, AABB* out, unsigned num){
+	auto col0 = _mm_setr_ps(m.m[0][0], m.m[1][0], m.m[2][0], 0.f);
+	auto col1 = _mm_setr_ps(m.m[0][1], m.m[1][1], m.m[2][1], 0.f);
+	auto col2 = _mm_setr_ps(m.m[0][2], m.m[1][2], m.m[2][2], 0.f);
+	auto col3 = _mm_setr_ps(m.m[0][3], m.m[1][3], m.m[2][3], 0.f);
+	auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	auto abs0 = _mm_and_ps(col0, absMask);
+	auto abs1 = _mm_and_ps(col1, absMask);
+	auto abs2 = _mm_and_ps(col2, absMask);
+	auto half = _mm_set1_ps(.5f);
+	for (unsigned i = 0; i < num; ++i){
+		if (!aabbs[i].IsValid()){
+			out[i] = aabbs[i];
+			continue;
+		}
+		auto& min = aabbs[i].GetMin();
+		auto& max = aabbs[i].GetMax();
+		auto vmin = _mm_setr_ps(min.x, min.y, min.z, 0.f);
+		auto vmax = _mm_setr_ps(max.x, max.y, max.z, 0.f);
+		auto c = _mm_mul_ps(_mm_add_ps(vmin, vmax), half);
+		auto e = _mm_mul_ps(_mm_sub_ps(vmax, vmin), half);
+		auto newC = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(col0, _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0))), 
+				_mm_mul_ps(col1, _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1)))),
+			_mm_add_ps(_mm_mul_ps(col2, _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2))), col3));
+		auto newE = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(abs0, _mm_shuffle_ps(e, e, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm_mul_ps(abs1, _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 1, 1, 1)))),
+			_mm_mul_ps(abs2, _mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 2, 2, 2))));
+		float newMin[4], newMax[4];
+		_mm_storeu_ps(newMin, _mm_sub_ps(newC, newE));
+		_mm_storeu_ps(newMax, _mm_add_ps(newC, newE));
+		out[i] = AABB(Vec3(newMin[0], newMin[1], newMin[2]), Vec3(newMax[0], newMax[1], newMax[2]));
+	}
+}
+
+static void SlerpQuatsSSE(const Quat* a, const Quat* b, const Real* t, Quat* out, unsigned num){
+	unsigned i = 0;
+	for (; i + 4 <= num; i += 4){
+		float aw[4], ax[4], ay[4], az[4], bw[4], bx[4], by[4], bz[4];
+		for (int k = 0; k < 4; ++k){
+			aw[k] = a[i + k].w; ax[k] = a[i + k].x; ay[k] = a[i + k].y; az[k] = a[i + k].z;
+			bw[k] = b[i + k].w; bx[k] = b[i + k].x; by[k] = b[i + k].y; bz[k] = b[i + k].z;
+		}
+		auto vaw = _mm_loadu_ps(aw), vax = _mm_loadu_ps(ax), vay = _mm_loadu_ps(ay), vaz = _mm_loadu_ps(az);
+		auto vbw = _mm_loadu_ps(bw), vbx = _mm_loadu_ps(bx), vby = _mm_loadu_ps(by), vbz = _mm_loadu_ps(bz);
+		auto dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vaw, vbw), _mm_mul_ps(vax, vbx)),
+			_mm_add_ps(_mm_mul_ps(vay, vby), _mm_mul_ps(vaz, vbz)));
+		// Takes the shorter path.
+		auto sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.f));
+		dot = _mm_xor_ps(dot, sign);
+		float dots[4], wa[4], wb[4];
+		_mm_storeu_ps(dots, dot);
+		for (int k = 0; k < 4; ++k){
+			GetSlerpWeights(dots[k], t[i + k], wa[k], wb[k]);
+		}
+		auto vwa = _mm_loadu_ps(wa);
+		auto vwb = _mm_xor_ps(_mm_loadu_ps(wb), sign);
+		_mm_storeu_ps(aw, _mm_add_ps(_mm_mul_ps(vaw, vwa), _mm_mul_ps(vbw, vwb)));
+		_mm_storeu_ps(ax, _mm_add_ps(_mm_mul_ps(vax, vwa), _mm_mul_ps(vbx, vwb)));
+		_mm_storeu_ps(ay, _mm_add_ps(_mm_mul_ps(vay, vwa), _mm_mul_ps(vby, vwb)));
+		_mm_storeu_ps(az, _mm_add_ps(_mm_mul_ps(vaz, vwa), _mm_mul_ps(vbz, vwb)));
+		for (int k = 0; k < 4; ++k){
+			out[i + k].w = aw[k]; out[i + k].x = ax[k]; out[i + k].y = ay[k]; out[i + k].z = az[k];
+		}
+	}
+	SlerpQuatsScalar(a + i, b + i, t + i, out + i, num - i);
+}
+
+static void CullSpheresSSE(const Plane* planes, unsigned numPlanes,
+	const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num,
+	unsigned char* culled)
+{
+	unsigned i = 0;
+	for (; i + 4 <= num; i += 4){
+		auto vx = _mm_loadu_ps(x + i);
+		auto vy = _mm_loadu_ps(y + i);
+		auto vz = _mm_loadu_ps(z + i);
+		auto negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+		auto out = _mm_setzero_ps();
+		for (unsigned p = 0; p < numPlanes; ++p){
+			auto& n = planes[p].mNormal;
+			auto dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(n.x)), _mm_mul_ps(vy, _mm_set1_ps(n.y))),
+				_mm_sub_ps(_mm_mul_ps(vz, _mm_set1_ps(n.z)), _mm_set1_ps(planes[p].mConstant)));
+			out = _mm_or_ps(out, _mm_cmple_ps(dist, negRadius));
+		}
+		auto mask = _mm_movemask_ps(out);
+		for (int k = 0; k < 4; ++k){
+			culled[i + k] = (mask >> k) & 1;
+		}
+	}
+	CullSpheresScalar(planes, numPlanes, x + i, y + i, z + i, radius + i, num - i, culled + i);
+}
+
+static const BatchMathFunctions SSEFunctions = {
+	MultiplyMatricesSSE,
+	TransformPointsSSE,
+	TransformAABBsSSE,
+	SlerpQuatsSSE,
+	CullSpheresSSE,
+};
+
+//---------------------------------------------------------------------------
+// AVX2: eight points or spheres at once.
+//---------------------------------------------------------------------------
+FB_TARGET_AVX2
+static void TransformPointsAVX2(const Mat44& m, const Vec3* points, Vec3* out, unsigned num, bool translate){
+	__m256 rows[3][4];
+	for (int r = 0; r < 3; ++r){
+		for (int c = 0; c < 4; ++c){
+			rows[r][c] = _mm256_set1_ps(c == 3 && !translate ? 0.f : m.m[r][c]);
+		}
+	}
+	auto index = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	unsigned i = 0;
+	for (; i + 8 <= num; i += 8){
+		auto base = &points[i].x;
+		auto vx = _mm256_i32gather_ps(base, index, 4);
+		auto vy = _mm256_i32gather_ps(base + 1, index, 4);
+		auto vz = _mm256_i32gather_ps(base + 2, index, 4);
+		float result[3][8];
+		for (int r = 0; r < 3; ++r){
+			_mm256_storeu_ps(result[r], _mm256_fmadd_ps(rows[r][0], vx,
+				_mm256_fmadd_ps(rows[r][1], vy, _mm256_fmadd_ps(rows[r][2], vz, rows[r][3]))));
+		}
+		for (int k = 0; k < 8; ++k){
+			out[i + k].x = result[0][k]; out[i + k].y = result[1][k]; out[i + k].z = result[2][k];
+		}
+	}
+	TransformPointsSSE(m, points + i, out + i, num - i, translate);
+}
+
+FB_TARGET_AVX2
+static void CullSpheresAVX2(const Plane* planes, unsigned numPlanes,
+	const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num,
+	unsigned char* culled)
+{
+	unsigned i = 0;
+	for (; i + 8 <= num; i += 8){
+		auto vx = _mm256_loadu_ps(x + i);
+		auto vy = _mm256_loadu_ps(y + i);
+		auto vz = _mm256_loadu_ps(z + i);
+		auto negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+		auto out = _mm256_setzero_ps();
+		for (unsigned p = 0; p < numPlanes; ++p){
+			auto& n = planes[p].mNormal;
+			auto dist = _mm256_fmadd_ps(vx, _mm256_set1_ps(n.x),
+				_mm256_fmadd_ps(vy, _mm256_set1_ps(n.y),
+				_mm256_fmsub_ps(vz, _mm256_set1_ps(n.z), _mm256_set1_ps(planes[p].mConstant))));
+			out = _mm256_or_ps(out, _mm256_cmp_ps(dist, negRadius, _CMP_LE_OQ));
+		}
+		auto mask = _mm256_movemask_ps(out);
+		for (int k = 0; k < 8; ++k){
+			culled[i + k] = (mask >> k) & 1;
+		}
+	}
+	CullSpheresSSE(planes, numPlanes, x + i, y + i, z + i, radius + i, num - i, culled + i);
+}
+
+static const BatchMathFunctions AVX2Functions = {
+	MultiplyMatricesSSE,
+	TransformPointsAVX2,
+	TransformAABBsSSE,
+	SlerpQuatsSSE,
+	CullSpheresAVX2,
+};
+
+static bool CpuHasAVX2(){
+	int info[4] = {};
+#if defined(_MSC_VER)
+	__cpuid(info, 1);
+#else
+	__cpuid(1, info[0], info[1], info[2], info[3]);
+#endif
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	if (!osxsave || !avx || !fma)
+		return false;
+	// The OS must save the ymm registers.
+#if defined(_MSC_VER)
+	auto xcr0 = _xgetbv(0);
+#else
+	unsigned eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	auto xcr0 = ((UINT64)edx << 32) | eax;
+#endif
+	if ((xcr0 & 6) != 6)
+		return false;
+#if defined(_MSC_VER)
+	__cpuidex(info, 7, 0);
+#else
+	__cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+	return (info[1] & (1 << 5)) != 0;
+}
+#endif
+
+static const BatchMathFunctions* GetFunctions(BatchMath::Backend backend){
+	switch (backend){
+#if FB_BATCHMATH_X86
+	case BatchMath::SSE:
+		return &SSEFunctions;
+	case BatchMath::AVX2:
+		return &AVX2Functions;
+#endif
+	default:
+		return &ScalarFunctions;
+	}
+}
+
+static BatchMath::Backend GetBestBackend(){
+#if FB_BATCHMATH_X86
+	return CpuHasAVX2() ? BatchMath::AVX2 : BatchMath::SSE;
+#else
+	return BatchMath::Scalar;
+#endif
+}
+
+// Function local so the static initializers of the other files can use it.
+struct BatchMathDispatch{
+	BatchMath::Backend mBackend;
+	const BatchMathFunctions* mFunctions;
+
+	BatchMathDispatch()
+		: mBackend(GetBestBackend())
+		, mFunctions(GetFunctions(mBackend))
+	{
+	}
+
+	static BatchMathDispatch& Get(){
+		static BatchMathDispatch sDispatch;
+		return sDispatch;
+	}
+};
+
+//---------------------------------------------------------------------------
+BatchMath::Backend BatchMath::GetBackend(){
+	return BatchMathDispatch::Get().mBackend;
+}
+
+bool BatchMath::SetBackend(Backend backend){
+	if (!IsSupported(backend))
+		return false;
+	auto& dispatch = BatchMathDispatch::Get();
+	dispatch.mBackend = backend;
+	dispatch.mFunctions = GetFunctions(backend);
+	return true;
+}
+
+bool BatchMath::IsSupported(Backend backend){
+	switch (backend){
+	case Scalar:
+		return true;
+#if FB_BATCHMATH_X86
+	case SSE:
+		return true;
+	case AVX2:
+		return CpuHasAVX2();
+#endif
+	default:
+		return false;
+	}
+}
+
+const char* BatchMath::GetBackendName(Backend backend){
+	static const char* names[] = { "Scalar", "SSE", "AVX2" };
+	static_assert(ARRAYCOUNT(names) == NumBackends, "Count mismatch");
+	if (backend < 0 || backend >= NumBackends)
+		return "Invalid";
+	return names[backend];
+}
+
+void BatchMath::MultiplyMatrices(const Mat44* a, const Mat44* b, Mat44* out, unsigned num){
+	BatchMathDispatch::Get().mFunctions->mMultiplyMatrices(a, b, out, num);
+}
+
+void BatchMath::TransformPoints(const Mat44& m, const Vec3* points, Vec3* out, unsigned num){
+	BatchMathDispatch::Get().mFunctions->mTransformPoints(m, points, out, num, true);
+}
+
+void BatchMath::TransformDirections(const Mat44& m, const Vec3* dirs, Vec3* out, unsigned num){
+	BatchMathDispatch::Get().mFunctions->mTransformPoints(m, dirs, out, num, false);
+}
+
+void BatchMath::TransformAABBs(const Mat44& m, const AABB* aabbs, AABB* out, unsigned num){
+	BatchMathDispatch::Get().mFunctions->mTransformAABBs(m, aabbs, out, num);
+}
+
+void BatchMath::SlerpQuats(const Quat* a, const Quat* b, const Real* t, Quat* out, unsigned num){
+	BatchMathDispatch::Get().mFunctions->mSlerpQuats(a, b, t, out, num);
+}
+
+void BatchMath::CullSpheres(const Plane* planes, unsigned numPlanes,
+	const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num,
+	unsigned char* culled)
+{
+	BatchMathDispatch::Get().mFunctions->mCullSpheres(planes, numPlanes, x, y, z, radius, num, culled);
+}
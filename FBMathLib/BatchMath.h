@@ -0,0 +1,67 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb{
+	class Mat44;
+	class Vec3;
+	class Quat;
+	class AABB;
+	class Plane;
+	/// Math over arrays. The implementation is chosen at the first call from
+	/// the CPU features; the scalar one is the reference for the tests.
+	class BatchMath{
+	public:
+		enum Backend{
+			Scalar,
+			SSE,
+			AVX2,
+			NumBackends,
+		};
+		static Backend GetBackend();
+		/// Returns false when the CPU cannot run the backend.
+		static bool SetBackend(Backend backend);
+		static bool IsSupported(Backend backend);
+		static const char* GetBackendName(Backend backend);
+
+		/// out[i] = a[i] * b[i]
+		static void MultiplyMatrices(const Mat44* a, const Mat44* b, Mat44* out, unsigned num);
+		/// Affine transform; the last row of 'm' is ignored. 'out' can be 'points'.
+		static void TransformPoints(const Mat44& m, const Vec3* points, Vec3* out, unsigned num);
+		/// Rotation and scale only. Pass the inverse transpose for normals.
+		static void TransformDirections(const Mat44& m, const Vec3* dirs, Vec3* out, unsigned num);
+		/// Bounds of the transformed boxes. Invalid boxes are copied.
+		static void TransformAABBs(const Mat44& m, const AABB* aabbs, AABB* out, unsigned num);
+		/// out[i] = Slerp(a[i], b[i], t[i])
+		static void SlerpQuats(const Quat* a, const Quat* b, const Real* t, Quat* out, unsigned num);
+		/// culled[i] becomes 1 when the sphere is entirely behind one of the planes.
+		static void CullSpheres(const Plane* planes, unsigned numPlanes, 
+			const Real* x, const Real* y, const Real* z, const Real* radius, unsigned num, 
+			unsigned char* culled);
+	};
+}
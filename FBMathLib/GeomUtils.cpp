@@ -103,4 +103,92 @@ namespace fb
 		index.push_back(startIndex2);
 		assert(index.back() == pos.size()-1);
 	}
+	void GeomUtils::ComputeModelTriangle(const Vec3* positions, ModelTriangle& tri)
+	{
+		const Vec3& p0 = positions[tri.v[0]];
+		const Vec3& p1 = positions[tri.v[1]];
+		const Vec3& p2 = positions[tri.v[2]];
+		tri.faceNormal = (p1 - p0).Cross(p2 - p0);
+		tri.faceNormal.SafeNormalize();
+		tri.d = tri.faceNormal.Dot(p0);
+		Vec3 n(abs(tri.faceNormal.x), abs(tri.faceNormal.y), abs(tri.faceNormal.z));
+		// The axis dropped for the 2D projection.
+		if (n.x > n.y && n.x > n.z){
+			tri.dominantAxis = 0;
+			tri.v0Proj = Vec2(p0.y, p0.z);
+			tri.v1Proj = Vec2(p1.y, p1.z);
+			tri.v2Proj = Vec2(p2.y, p2.z);
+		}
+		else if (n.y > n.z){
+			tri.dominantAxis = 1;
+			tri.v0Proj = Vec2(p0.x, p0.z);
+			tri.v1Proj = Vec2(p1.x, p1.z);
+			tri.v2Proj = Vec2(p2.x, p2.z);
+		}
+		else{
+			tri.dominantAxis = 2;
+			tri.v0Proj = Vec2(p0.x, p0.y);
+			tri.v1Proj = Vec2(p1.x, p1.y);
+			tri.v2Proj = Vec2(p2.x, p2.y);
+		}
+	}
+
+	bool GeomUtils::IntersectRayTriangle(const Vec3& origin, const Vec3& dir, const ModelTriangle& tri,
+		Real tMax, Real& outT)
+	{
+		const Real epsilon = 0.001f;
+		Real NdotD = tri.faceNormal.Dot(dir);
+		if (abs(NdotD) < epsilon)
+		{
+			// ray is parallel or nearly parallel to polygon plane
+			return false;
+		}
+		Real t = (tri.d - tri.faceNormal.Dot(origin)) / NdotD;
+		if (t <= 0 || t >= tMax)
+			return false;
+
+		// find the interpolation parameters alpha and beta using 2D projections
+		Vec3 intersectionPoint = origin + dir * t;
+		Vec2 P;
+		switch (tri.dominantAxis)
+		{
+		case 0:
+			P.x = intersectionPoint.y;
+			P.y = intersectionPoint.z;
+			break;
+		case 1:
+			P.x = intersectionPoint.x;
+			P.y = intersectionPoint.z;
+			break;
+		case 2:
+		default:
+			P.x = intersectionPoint.x;
+			P.y = intersectionPoint.y;
+		}
+		Real u0 = P.x - tri.v0Proj.x;
+		Real v0 = P.y - tri.v0Proj.y;
+		Real u1 = tri.v1Proj.x - tri.v0Proj.x;
+		Real u2 = tri.v2Proj.x - tri.v0Proj.x;
+		Real v1 = tri.v1Proj.y - tri.v0Proj.y;
+		Real v2 = tri.v2Proj.y - tri.v0Proj.y;
+		Real alpha, beta;
+		if (abs(u1) < epsilon)
+		{
+			beta = u0 / u2;
+			if (beta < 0 || beta > 1)
+				return false;
+			alpha = (v0 - beta * v2) / v1;
+		}
+		else
+		{
+			beta = (v0*u1 - u0*v1) / (v2*u1 - u2*v1);
+			if (beta < 0 || beta > 1)
+				return false;
+			alpha = (u0 - beta * u2) / u1;
+		}
+		if (alpha < 0 || alpha + beta > 1)
+			return false;
+		outT = t;
+		return true;
+	}
 }
\ No newline at end of file
@@ -58,5 +58,11 @@ namespace fb
 		/// \param index for triangle strip
 		static void CreateSphere(Real radius, int nRings, int nSegments,
 			Vec3::Array& pos, std::vector<unsigned short>& index);
+		/// Fills the cached intersection data of 'tri' from tri.v
+		static void ComputeModelTriangle(const Vec3* positions, ModelTriangle& tri);
+		/// Returns true when the ray hits 'tri' at 0 < outT < tMax.
+		/// outT is in units of 'dir'.
+		static bool IntersectRayTriangle(const Vec3& origin, const Vec3& dir, const ModelTriangle& tri,
+			Real tMax, Real& outT);
 	};
 }
\ No newline at end of file
@@ -28,8 +28,23 @@
 #include "stdafx.h"
 #include "NoiseGen.h"
 #include "Math.h"
+#if !defined(FB_DOUBLE_PRECISION) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define FB_NOISE_SSE2 1
+#include <emmintrin.h>
+#endif
 using namespace fb;
 
+NoiseParams::NoiseParams()
+	: mType(Perlin)
+	, mOctaves(1)
+	, mFrequency(1.f)
+	, mLacunarity(2.f)
+	, mGain(.5f)
+	, mOffset(0, 0, 0)
+	, mPeriod(0)
+{
+}
+
 NoiseGen::NoiseGen() {
 	mP = {
 		151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,
@@ -130,4 +145,261 @@ Real NoiseGen::Get(Real x, Real y, Real z) {
 		Lerp(Grad(mP[AB], x, y - 1, z), Grad(mP[BB], x - 1, y - 1, z), u), v),
 		Lerp(Lerp(Grad(mP[AA + 1], x, y, z - 1), Grad(mP[BA + 1], x - 1, y, z - 1), u), Lerp(Grad(mP[AB + 1], x, y - 1, z - 1), Grad(mP[BB + 1], x - 1, y - 1, z - 1), u), v), w);
 	return (res + 1.0f) / 2.0f;
-}
\ No newline at end of file
+}
+
+//---------------------------------------------------------------------------
+// Batch evaluation
+//---------------------------------------------------------------------------
+// The lattice of a sample. Without a period the indices are the same as
+// Get(x, y, z) uses, so the results match it bit for bit.
+static void LatticeIndices(int i, unsigned period, int& i0, int& i1) {
+	if (period) {
+		int p = (int)period;
+		i0 = i % p;
+		if (i0 < 0)
+			i0 += p;
+		i1 = i0 + 1 == p ? 0 : i0 + 1;
+		i0 &= 255;
+		i1 &= 255;
+	}
+	else {
+		i0 = i & 255;
+		i1 = i0 + 1;
+	}
+}
+
+static Real PerlinScalar(const UINT8* p, Real x, Real y, Real z, unsigned period) {
+	Real fx = floor(x);
+	Real fy = floor(y);
+	Real fz = floor(z);
+	int X0, X1, Y0, Y1, Z0, Z1;
+	LatticeIndices((int)fx, period, X0, X1);
+	LatticeIndices((int)fy, period, Y0, Y1);
+	LatticeIndices((int)fz, period, Z0, Z1);
+	x -= fx;
+	y -= fy;
+	z -= fz;
+	Real u = Fade(x);
+	Real v = Fade(y);
+	Real w = Fade(z);
+	int A0 = p[X0] + Y0, A1 = p[X0] + Y1;
+	int B0 = p[X1] + Y0, B1 = p[X1] + Y1;
+	Real res = Lerp(Lerp(Lerp(Grad(p[p[A0] + Z0], x, y, z), Grad(p[p[B0] + Z0], x - 1, y, z), u),
+		Lerp(Grad(p[p[A1] + Z0], x, y - 1, z), Grad(p[p[B1] + Z0], x - 1, y - 1, z), u), v),
+		Lerp(Lerp(Grad(p[p[A0] + Z1], x, y, z - 1), Grad(p[p[B0] + Z1], x - 1, y, z - 1), u),
+		Lerp(Grad(p[p[A1] + Z1], x, y - 1, z - 1), Grad(p[p[B1] + Z1], x - 1, y - 1, z - 1), u), v), w);
+	return (res + 1.0f) / 2.0f;
+}
+
+#if FB_NOISE_SSE2
+static inline __m128 Fade4(__m128 t) {
+	__m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+	__m128 k = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.f)), _mm_set1_ps(15.f));
+	k = _mm_add_ps(_mm_mul_ps(t, k), _mm_set1_ps(10.f));
+	return _mm_mul_ps(t3, k);
+}
+
+static inline __m128 Select4(__m128i mask, __m128 a, __m128 b) {
+	__m128 m = _mm_castsi128_ps(mask);
+	return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+// Same selection as Grad(hash, x, y, z); the sign is flipped with xor.
+static inline __m128 Grad4(const int* hash, __m128 x, __m128 y, __m128 z) {
+	__m128i h = _mm_and_si128(_mm_loadu_si128((const __m128i*)hash), _mm_set1_epi32(0x0F));
+	__m128 u = Select4(_mm_cmplt_epi32(h, _mm_set1_epi32(8)), x, y);
+	__m128i xMask = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)),
+		_mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+	__m128 v = Select4(_mm_cmplt_epi32(h, _mm_set1_epi32(4)), y, Select4(xMask, x, z));
+	__m128i uSign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31);
+	__m128i vSign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30);
+	u = _mm_xor_ps(u, _mm_castsi128_ps(uSign));
+	v = _mm_xor_ps(v, _mm_castsi128_ps(vSign));
+	return _mm_add_ps(u, v);
+}
+
+// Clamps like Lerp(); Fade() can go slightly over 1.
+static inline __m128 Lerp4(__m128 a, __m128 b, __m128 t) {
+	t = _mm_max_ps(_mm_setzero_ps(), _mm_min_ps(t, _mm_set1_ps(1.f)));
+	return _mm_add_ps(_mm_mul_ps(a, _mm_sub_ps(_mm_set1_ps(1.f), t)), _mm_mul_ps(b, t));
+}
+
+// floor() for |x| < 2^31; returns the integer part in 'i'.
+static inline __m128 Floor4(__m128 x, __m128i& i) {
+	i = _mm_cvttps_epi32(x);
+	__m128 f = _mm_cvtepi32_ps(i);
+	__m128 adjust = _mm_cmpgt_ps(f, x);
+	i = _mm_add_epi32(i, _mm_castps_si128(adjust));
+	return _mm_sub_ps(f, _mm_and_ps(adjust, _mm_set1_ps(1.f)));
+}
+
+static void Perlin4(const UINT8* p, const Real* xs, const Real* ys, const Real* zs,
+	unsigned period, Real* out)
+{
+	__m128 x = _mm_loadu_ps(xs);
+	__m128 y = _mm_loadu_ps(ys);
+	__m128 z = _mm_loadu_ps(zs);
+	__m128i ix, iy, iz;
+	x = _mm_sub_ps(x, Floor4(x, ix));
+	y = _mm_sub_ps(y, Floor4(y, iy));
+	z = _mm_sub_ps(z, Floor4(z, iz));
+	alignas(16) int cx[4], cy[4], cz[4];
+	_mm_store_si128((__m128i*)cx, ix);
+	_mm_store_si128((__m128i*)cy, iy);
+	_mm_store_si128((__m128i*)cz, iz);
+	// corner hashes; bit 0 is x, bit 1 is y and bit 2 is z.
+	alignas(16) int hash[8][4];
+	for (int l = 0; l < 4; ++l) {
+		int X0, X1, Y0, Y1, Z0, Z1;
+		LatticeIndices(cx[l], period, X0, X1);
+		LatticeIndices(cy[l], period, Y0, Y1);
+		LatticeIndices(cz[l], period, Z0, Z1);
+		int A0 = p[X0] + Y0, A1 = p[X0] + Y1;
+		int B0 = p[X1] + Y0, B1 = p[X1] + Y1;
+		int AA = p[A0], AB = p[A1], BA = p[B0], BB = p[B1];
+		hash[0][l] = p[AA + Z0];
+		hash[1][l] = p[BA + Z0];
+		hash[2][l] = p[AB + Z0];
+		hash[3][l] = p[BB + Z0];
+		hash[4][l] = p[AA + Z1];
+		hash[5][l] = p[BA + Z1];
+		hash[6][l] = p[AB + Z1];
+		hash[7][l] = p[BB + Z1];
+	}
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 x1 = _mm_sub_ps(x, one);
+	__m128 y1 = _mm_sub_ps(y, one);
+	__m128 z1 = _mm_sub_ps(z, one);
+	__m128 u = Fade4(x);
+	__m128 v = Fade4(y);
+	__m128 w = Fade4(z);
+	__m128 res = Lerp4(
+		Lerp4(Lerp4(Grad4(hash[0], x, y, z), Grad4(hash[1], x1, y, z), u),
+			Lerp4(Grad4(hash[2], x, y1, z), Grad4(hash[3], x1, y1, z), u), v),
+		Lerp4(Lerp4(Grad4(hash[4], x, y, z1), Grad4(hash[5], x1, y, z1), u),
+			Lerp4(Grad4(hash[6], x, y1, z1), Grad4(hash[7], x1, y1, z1), u), v), w);
+	_mm_storeu_ps(out, _mm_mul_ps(_mm_add_ps(res, one), _mm_set1_ps(.5f)));
+}
+#endif
+
+static void PerlinN(const UINT8* p, const Real* x, const Real* y, const Real* z,
+	unsigned num, unsigned period, Real* out)
+{
+	unsigned i = 0;
+#if FB_NOISE_SSE2
+	for (; i + 4 <= num; i += 4) {
+		Perlin4(p, x + i, y + i, z + i, period, out + i);
+	}
+#endif
+	for (; i < num; ++i) {
+		out[i] = PerlinScalar(p, x[i], y[i], z[i], period);
+	}
+}
+
+static const unsigned NoiseBlockSize = 64;
+
+// Octaves for up to NoiseBlockSize points.
+static void NoiseBlock(const UINT8* p, const Real* bx, const Real* by, const Real* bz,
+	unsigned num, const NoiseParams& params, Real* out)
+{
+	assert(num <= NoiseBlockSize);
+	Real x[NoiseBlockSize], y[NoiseBlockSize], z[NoiseBlockSize];
+	Real noise[NoiseBlockSize];
+	unsigned octaves = params.mType == NoiseParams::Perlin ? 1 : std::max(1u, params.mOctaves);
+	Real frequency = params.mFrequency;
+	Real amplitude = 1.f;
+	Real sumAmplitude = 0.f;
+	Real periodScale = 1.f;
+	for (unsigned o = 0; o < octaves; ++o) {
+		for (unsigned i = 0; i < num; ++i) {
+			x[i] = bx[i] * frequency + params.mOffset.x;
+			y[i] = by[i] * frequency + params.mOffset.y;
+			z[i] = bz[i] * frequency + params.mOffset.z;
+		}
+		unsigned period = params.mPeriod ? (unsigned)Round(params.mPeriod * periodScale) : 0;
+		PerlinN(p, x, y, z, num, period, o == 0 ? out : noise);
+		if (params.mType == NoiseParams::Perlin)
+			return;
+
+		Real* src = o == 0 ? out : noise;
+		for (unsigned i = 0; i < num; ++i) {
+			Real s = src[i] * 2.f - 1.f;
+			Real value;
+			switch (params.mType) {
+			case NoiseParams::Ridged:
+				value = 1.f - std::abs(s);
+				value *= value;
+				break;
+			case NoiseParams::Turbulence:
+				value = std::abs(s);
+				break;
+			default:
+				value = s;
+				break;
+			}
+			out[i] = o == 0 ? value * amplitude : out[i] + value * amplitude;
+		}
+		sumAmplitude += amplitude;
+		amplitude *= params.mGain;
+		frequency *= params.mLacunarity;
+		periodScale *= params.mLacunarity;
+	}
+	Real invSum = sumAmplitude > 0 ? 1.f / sumAmplitude : 0.f;
+	for (unsigned i = 0; i < num; ++i) {
+		out[i] *= invSum;
+		if (params.mType == NoiseParams::FBm)
+			out[i] = (out[i] + 1.f) * .5f;
+	}
+}
+
+void NoiseGen::Get(const Vec3* positions, Real* out, unsigned num, const NoiseParams& params) const {
+	Real x[NoiseBlockSize], y[NoiseBlockSize], z[NoiseBlockSize];
+	for (unsigned start = 0; start < num; start += NoiseBlockSize) {
+		unsigned count = std::min(NoiseBlockSize, num - start);
+		for (unsigned i = 0; i < count; ++i) {
+			x[i] = positions[start + i].x;
+			y[i] = positions[start + i].y;
+			z[i] = positions[start + i].z;
+		}
+		NoiseBlock(mP.data(), x, y, z, count, params, out + start);
+	}
+}
+
+void NoiseGen::GetGrid2D(Real* out, unsigned width, unsigned height,
+	const NoiseParams& params, const ParallelFor& parallelFor) const
+{
+	GetGrid3D(out, width, height, 1, params, parallelFor);
+}
+
+void NoiseGen::GetGrid3D(Real* out, unsigned width, unsigned height, unsigned depth,
+	const NoiseParams& params, const ParallelFor& parallelFor) const
+{
+	if (width == 0 || height == 0 || depth == 0)
+		return;
+	const UINT8* p = mP.data();
+	Real invWidth = 1.f / width;
+	Real invHeight = 1.f / height;
+	Real invDepth = depth > 1 ? 1.f / depth : 0.f;
+	auto rows = [&](unsigned start, unsigned end) {
+		Real x[NoiseBlockSize], y[NoiseBlockSize], z[NoiseBlockSize];
+		for (unsigned row = start; row < end; ++row) {
+			Real ry = (row % height) * invHeight;
+			Real rz = (row / height) * invDepth;
+			Real* dest = out + (size_t)row * width;
+			for (unsigned col = 0; col < width; col += NoiseBlockSize) {
+				unsigned count = std::min(NoiseBlockSize, width - col);
+				for (unsigned i = 0; i < count; ++i) {
+					x[i] = (col + i) * invWidth;
+					y[i] = ry;
+					z[i] = rz;
+				}
+				NoiseBlock(p, x, y, z, count, params, dest + col);
+			}
+		}
+	};
+	unsigned numRows = height * depth;
+	if (parallelFor)
+		parallelFor(numRows, rows);
+	else
+		rows(0, numRows);
+}
@@ -27,7 +27,34 @@
 
 #pragma once
 #include "FBCommonHeaders/Types.h"
+#include "FBCommonHeaders/ParallelFor.h"
+#include "Vec3.h"
 namespace fb {
+	struct NoiseParams {
+		enum Type {
+			Perlin, // single octave; same as NoiseGen::Get(x, y, z)
+			FBm,
+			Ridged,
+			Turbulence,
+		};
+		NoiseParams();
+
+		Type mType;
+		unsigned mOctaves;
+		Real mFrequency;
+		/// Frequency multiplier per octave.
+		Real mLacunarity;
+		/// Amplitude multiplier per octave.
+		Real mGain;
+		/// Added after the frequency is applied.
+		Vec3 mOffset;
+		/// When not 0 the noise repeats every mPeriod units of noise space.
+		/// For the grid functions mPeriod == mFrequency gives a seamless tile.
+		/// The period of each octave is scaled by mLacunarity, so use an
+		/// integer lacunarity for tiling octaves.
+		unsigned mPeriod;
+	};
+
 	class NoiseGen {
 		ByteArray mP;
 	public:
@@ -37,5 +64,17 @@ namespace fb {
 		void GetPermutation(ByteArray& outData);
 		Real Get(Real x);
 		Real Get(Real x, Real y, Real z);
+
+		/// Evaluates 4 points at a time with SSE2 when available.
+		/// Results are in [0, 1].
+		void Get(const Vec3* positions, Real* out, unsigned num, const NoiseParams& params) const;
+		/// out is width * height, row major. Texel (x, y) samples
+		/// (x / width, y / height, 0), so the frequency is the number of
+		/// cells across the grid. Rows are handed to parallelFor.
+		void GetGrid2D(Real* out, unsigned width, unsigned height,
+			const NoiseParams& params, const ParallelFor& parallelFor = ParallelFor()) const;
+		/// out is width * height * depth; x changes fastest.
+		void GetGrid3D(Real* out, unsigned width, unsigned height, unsigned depth,
+			const NoiseParams& params, const ParallelFor& parallelFor = ParallelFor()) const;
 	};
-}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "RandomGenerator.h"
+#include <atomic>
+#if !defined(FB_DOUBLE_PRECISION) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define FB_RANDOM_SSE2 1
+#include <emmintrin.h>
+#endif
+using namespace fb;
+
+static UINT64 SplitMix64(UINT64& x){
+	UINT64 z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static std::atomic<UINT64> sNextSeed(0x2545F4914F6CDD1DULL);
+
+RandomGenerator::RandomGenerator(){
+	Seed(sNextSeed.fetch_add(1));
+}
+
+RandomGenerator::RandomGenerator(UINT64 seed){
+	Seed(seed);
+}
+
+void RandomGenerator::Seed(UINT64 seed){
+	unsigned* words[] = { &mState[0], &mState[2], &mLanes[0][0], &mLanes[0][2],
+		&mLanes[1][0], &mLanes[1][2], &mLanes[2][0], &mLanes[2][2], &mLanes[3][0], &mLanes[3][2] };
+	for (auto word : words){
+		UINT64 v = SplitMix64(seed);
+		word[0] = (unsigned)v;
+		word[1] = (unsigned)(v >> 32);
+	}
+	// xoshiro must not start from all zeros.
+	if (!(mState[0] | mState[1] | mState[2] | mState[3]))
+		mState[0] = 1;
+	for (int lane = 0; lane < 4; ++lane){
+		if (!(mLanes[0][lane] | mLanes[1][lane] | mLanes[2][lane] | mLanes[3][lane]))
+			mLanes[0][lane] = 1;
+	}
+}
+
+RandomGenerator& RandomGenerator::GetThreadLocal(){
+	thread_local RandomGenerator sGenerator;
+	return sGenerator;
+}
+
+namespace{
+	/// Steps the four Fill streams. The SSE2 path does exactly the same per lane.
+	void NextLanes(unsigned lanes[4][4], unsigned out[4]){
+		for (int i = 0; i < 4; ++i){
+			unsigned& s0 = lanes[0][i];
+			unsigned& s1 = lanes[1][i];
+			unsigned& s2 = lanes[2][i];
+			unsigned& s3 = lanes[3][i];
+			out[i] = s0 + s3;
+			const unsigned t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = (s3 << 11) | (s3 >> 21);
+		}
+	}
+}
+
+void RandomGenerator::Fill(Real* out, unsigned num, Real min, Real max){
+	const Real scale = (max - min) * (1.f / 16777216.f);
+	unsigned i = 0;
+#if FB_RANDOM_SSE2
+	__m128i s0 = _mm_loadu_si128((const __m128i*)mLanes[0]);
+	__m128i s1 = _mm_loadu_si128((const __m128i*)mLanes[1]);
+	__m128i s2 = _mm_loadu_si128((const __m128i*)mLanes[2]);
+	__m128i s3 = _mm_loadu_si128((const __m128i*)mLanes[3]);
+	const __m128 vMin = _mm_set1_ps(min);
+	const __m128 vScale = _mm_set1_ps(scale);
+	for (; i + 4 <= num; i += 4){
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+		__m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+		_mm_storeu_ps(out + i, _mm_add_ps(vMin, _mm_mul_ps(f, vScale)));
+	}
+	_mm_storeu_si128((__m128i*)mLanes[0], s0);
+	_mm_storeu_si128((__m128i*)mLanes[1], s1);
+	_mm_storeu_si128((__m128i*)mLanes[2], s2);
+	_mm_storeu_si128((__m128i*)mLanes[3], s3);
+#endif
+	while (i < num){
+		unsigned values[4];
+		NextLanes(mLanes, values);
+		for (int k = 0; k < 4 && i < num; ++k, ++i){
+			out[i] = min + (Real)(values[k] >> 8) * scale;
+		}
+	}
+}
+
+void RandomGenerator::FillDirections(Vec3* out, unsigned num){
+	const unsigned ChunkSize = 256;
+	Real z[ChunkSize];
+	Real phi[ChunkSize];
+	for (unsigned start = 0; start < num; start += ChunkSize){
+		unsigned count = std::min(ChunkSize, num - start);
+		Fill(z, count, -1.f, 1.f);
+		Fill(phi, count, 0.f, TWO_PI);
+		for (unsigned i = 0; i < count; ++i){
+			Real r = std::sqrt(std::max(Real(0), 1.f - z[i] * z[i]));
+			out[start + i] = Vec3(r * std::cos(phi[i]), r * std::sin(phi[i]), z[i]);
+		}
+	}
+}
+
+void RandomGenerator::FillInSphere(Vec3* out, unsigned num, Real minRadius, Real maxRadius){
+	FillDirections(out, num);
+	const unsigned ChunkSize = 256;
+	Real radius[ChunkSize];
+	const Real min3 = minRadius * minRadius * minRadius;
+	const Real max3 = maxRadius * maxRadius * maxRadius;
+	for (unsigned start = 0; start < num; start += ChunkSize){
+		unsigned count = std::min(ChunkSize, num - start);
+		Fill(radius, count, min3, max3);
+		for (unsigned i = 0; i < count; ++i){
+			out[start + i] *= std::pow(radius[i], 1.f / 3.f);
+		}
+	}
+}
@@ -0,0 +1,136 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "Vec3.h"
+#include "Vec2.h"
+#include "MathDefines.h"
+
+namespace fb
+{
+	/// xoshiro128+ generator.
+	/// Not thread safe. Give each system its own instance or use GetThreadLocal().
+	/// The same seed produces the same sequence on every platform.
+	class RandomGenerator
+	{
+		unsigned mState[4];
+		/// Four more streams for the Fill functions. mLanes[i] is the state word i of each stream.
+		unsigned mLanes[4][4];
+
+	public:
+		/// Every instance gets a different seed.
+		RandomGenerator();
+		explicit RandomGenerator(UINT64 seed);
+		void Seed(UINT64 seed);
+
+		/// A generator owned by the calling thread.
+		static RandomGenerator& GetThreadLocal();
+
+		unsigned NextUInt()
+		{
+			const unsigned result = mState[0] + mState[3];
+			const unsigned t = mState[1] << 9;
+			mState[2] ^= mState[0];
+			mState[3] ^= mState[1];
+			mState[1] ^= mState[2];
+			mState[0] ^= mState[3];
+			mState[2] ^= t;
+			mState[3] = (mState[3] << 11) | (mState[3] >> 21);
+			return result;
+		}
+
+		/// [0, 1)
+		Real Next()
+		{
+			return (NextUInt() >> 8) * (1.f / 16777216.f);
+		}
+
+		/// [min, max)
+		Real Next(Real min, Real max)
+		{
+			return min + (max - min) * Next();
+		}
+
+		/// max is included
+		int NextInt(int min, int max)
+		{
+			if (max <= min)
+				return min;
+			UINT64 range = (UINT64)((INT64)max - min) + 1;
+			return min + (int)((NextUInt() * range) >> 32);
+		}
+
+		Vec3 Next(const Vec3& min, const Vec3& max)
+		{
+			Real x = Next(min.x, max.x);
+			Real y = Next(min.y, max.y);
+			return Vec3(x, y, Next(min.z, max.z));
+		}
+
+		Vec2 Next(const Vec2& min, const Vec2& max)
+		{
+			Real x = Next(min.x, max.x);
+			return Vec2(x, Next(min.y, max.y));
+		}
+
+		/// Uniform on the unit sphere.
+		Vec3 NextDirection()
+		{
+			Real z = Next(-1.f, 1.f);
+			Real phi = Next(0.f, TWO_PI);
+			Real r = std::sqrt(std::max(Real(0), 1.f - z * z));
+			return Vec3(r * std::cos(phi), r * std::sin(phi), z);
+		}
+
+		/// Uniform in the volume between the two radii.
+		Vec3 NextInSphere(Real minRadius, Real maxRadius)
+		{
+			Real min3 = minRadius * minRadius * minRadius;
+			Real max3 = maxRadius * maxRadius * maxRadius;
+			Real r = std::pow(Next(min3, max3), 1.f / 3.f);
+			return NextDirection() * r;
+		}
+
+		/// Uniform over the cap of half angle theta around the unit axis.
+		Vec3 NextDirectionCone(const Vec3& axis, Real theta)
+		{
+			Vec3 u = axis.Cross(std::abs(axis.x) > 0.9f ? Vec3::UNIT_Y : Vec3::UNIT_X);
+			u.Normalize();
+			Vec3 v = axis.Cross(u);
+			Real cosT = Next(std::cos(theta), 1.f);
+			Real sinT = std::sqrt(std::max(Real(0), 1.f - cosT * cosT));
+			Real phi = Next(0.f, TWO_PI);
+			return axis * cosT + (u * std::cos(phi) + v * std::sin(phi)) * sinT;
+		}
+
+		/// Batch versions; four streams at once with SSE2 on x86.
+		/// They do not advance the stream of the functions above.
+		void Fill(Real* out, unsigned num, Real min, Real max);
+		void FillDirections(Vec3* out, unsigned num);
+		void FillInSphere(Vec3* out, unsigned num, Real minRadius, Real maxRadius);
+	};
+}
@@ -28,6 +28,7 @@
 #include "stdafx.h"
 #include "Transformation.h"
 #include "Math.h"
+#include "BatchMath.h"
 #include "Frustum.h"
 #include "FBStringLib/MurmurHash.h"
 #include "FBCommonHeaders/Helpers.h"
@@ -374,26 +375,10 @@ namespace fb
 		}
 		else
 		{
-			int i;
-			if (mRSSeperated)
-			{
-				// Y = R*S*X + T
-				for (i = 0; i < iQuantity; i++)
-				{
-					outputs[i].x = mS.x*points[i].x;
-					outputs[i].y = mS.y*points[i].y;
-					outputs[i].z = mS.z*points[i].z;
-					outputs[i] = mMat*outputs[i] + mT;
-				}
-			}
-			else
-			{
-				// Y = M*X + T
-				for (i = 0; i < iQuantity; i++)
-				{
-					outputs[i] = mMat*points[i] + mT;
-				}
-			}
+			// Y = H*X
+			Mat44 homo;
+			GetHomogeneous(homo);
+			BatchMath::TransformPoints(homo, points, outputs, (unsigned)iQuantity);
 		}
 	}
 
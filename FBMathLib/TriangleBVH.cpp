@@ -0,0 +1,399 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "TriangleBVH.h"
+#include "GeomUtils.h"
+#include "Ray.h"
+using namespace fb;
+
+static const unsigned NumBins = 8;
+static const unsigned MaxLeafSize = 4;
+static const unsigned MaxDepth = 64;
+
+namespace{
+	/// 32 bytes. Children of an inner node are mFirst and mFirst + 1.
+	/// A leaf has mCount triangles from mFirst.
+	struct Node{
+		float mMin[3];
+		unsigned mFirst;
+		float mMax[3];
+		unsigned mCount;
+	};
+
+	struct Bounds{
+		Vec3 mMin, mMax;
+
+		Bounds()
+			: mMin(FLT_MAX, FLT_MAX, FLT_MAX)
+			, mMax(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+		{
+		}
+
+		void Merge(const Vec3& p){
+			mMin.KeepLesser(p);
+			mMax.KeepGreater(p);
+		}
+
+		void Merge(const Bounds& b){
+			mMin.KeepLesser(b.mMin);
+			mMax.KeepGreater(b.mMax);
+		}
+
+		Real GetHalfArea() const{
+			auto e = mMax - mMin;
+			return e.x * e.y + e.y * e.z + e.z * e.x;
+		}
+	};
+
+	/// Returns false when the ray misses the node or enters it after tMax.
+	inline bool HitNode(const Node& node, const Vec3& origin, const Vec3& dirInv, Real tMax, Real& tEnter){
+		Real t1 = (node.mMin[0] - origin.x) * dirInv.x;
+		Real t2 = (node.mMax[0] - origin.x) * dirInv.x;
+		Real tmin = std::min(t1, t2), tmax = std::max(t1, t2);
+		t1 = (node.mMin[1] - origin.y) * dirInv.y;
+		t2 = (node.mMax[1] - origin.y) * dirInv.y;
+		tmin = std::max(tmin, std::min(t1, t2));
+		tmax = std::min(tmax, std::max(t1, t2));
+		t1 = (node.mMin[2] - origin.z) * dirInv.z;
+		t2 = (node.mMax[2] - origin.z) * dirInv.z;
+		tmin = std::max(tmin, std::min(t1, t2));
+		tmax = std::min(tmax, std::max(t1, t2));
+		tEnter = tmin;
+		return tmax >= std::max(tmin, 0.f) && tmin < tMax;
+	}
+}
+
+class TriangleBVH::Impl{
+public:
+	std::vector<Node> mNodes;
+	unsigned mDepth;
+	// Build scratch. Parallel to the triangles.
+	std::vector<Bounds> mTriBounds;
+	std::vector<Vec3> mCentroids;
+
+	Impl()
+		: mDepth(0)
+	{
+	}
+
+	void Build(const Vec3* positions, ModelTriangle* triangles, unsigned numTriangles){
+		mNodes.clear();
+		mDepth = 0;
+		if (!positions || !triangles || numTriangles == 0)
+			return;
+		mTriBounds.resize(numTriangles);
+		mCentroids.resize(numTriangles);
+		for (unsigned i = 0; i < numTriangles; ++i){
+			auto& b = mTriBounds[i];
+			b = Bounds();
+			for (int v = 0; v < 3; ++v){
+				b.Merge(positions[triangles[i].v[v]]);
+			}
+			mCentroids[i] = (b.mMin + b.mMax) * .5f;
+		}
+		mNodes.reserve(numTriangles * 2 / MaxLeafSize + 1);
+		mNodes.push_back(Node());
+		mNodes[0].mFirst = 0;
+		mNodes[0].mCount = numTriangles;
+		Subdivide(0, triangles, 1);
+		std::vector<Bounds>().swap(mTriBounds);
+		std::vector<Vec3>().swap(mCentroids);
+	}
+
+	void SetBounds(Node& node, const Bounds& b){
+		for (int a = 0; a < 3; ++a){
+			node.mMin[a] = b.mMin[a];
+			node.mMax[a] = b.mMax[a];
+		}
+	}
+
+	void Subdivide(unsigned nodeIndex, ModelTriangle* triangles, unsigned depth){
+		mDepth = std::max(mDepth, depth);
+		const unsigned first = mNodes[nodeIndex].mFirst;
+		const unsigned count = mNodes[nodeIndex].mCount;
+		Bounds bounds, centroidBounds;
+		for (unsigned i = first; i < first + count; ++i){
+			bounds.Merge(mTriBounds[i]);
+			centroidBounds.Merge(mCentroids[i]);
+		}
+		SetBounds(mNodes[nodeIndex], bounds);
+		if (count <= MaxLeafSize || depth >= MaxDepth)
+			return;
+
+		// Binned surface area heuristic on the longest centroid axis.
+		auto extent = centroidBounds.mMax - centroidBounds.mMin;
+		int axis = 0;
+		if (extent.y > extent[axis])
+			axis = 1;
+		if (extent.z > extent[axis])
+			axis = 2;
+		if (extent[axis] <= 0.f)
+			return;
+		Real binScale = NumBins / extent[axis];
+		Bounds binBounds[NumBins];
+		unsigned binCounts[NumBins] = { 0 };
+		for (unsigned i = first; i < first + count; ++i){
+			unsigned b = std::min(NumBins - 1, (unsigned)((mCentroids[i][axis] - centroidBounds.mMin[axis]) * binScale));
+			binBounds[b].Merge(mTriBounds[i]);
+			++binCounts[b];
+		}
+		Real leftArea[NumBins - 1];
+		unsigned leftCount[NumBins - 1];
+		Bounds left;
+		unsigned num = 0;
+		for (unsigned b = 0; b < NumBins - 1; ++b){
+			left.Merge(binBounds[b]);
+			num += binCounts[b];
+			leftArea[b] = num ? left.GetHalfArea() : 0.f;
+			leftCount[b] = num;
+		}
+		Bounds right;
+		num = 0;
+		Real bestCost = FLT_MAX;
+		unsigned bestSplit = 0;
+		for (unsigned b = NumBins - 1; b > 0; --b){
+			right.Merge(binBounds[b]);
+			num += binCounts[b];
+			if (!num || !leftCount[b - 1])
+				continue;
+			Real cost = leftArea[b - 1] * leftCount[b - 1] + right.GetHalfArea() * num;
+			if (cost < bestCost){
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+		if (bestSplit == 0)
+			return;
+
+		// Partition the triangles and their build data together.
+		unsigned i = first, j = first + count;
+		while (i < j){
+			unsigned b = std::min(NumBins - 1, (unsigned)((mCentroids[i][axis] - centroidBounds.mMin[axis]) * binScale));
+			if (b < bestSplit){
+				++i;
+			}
+			else{
+				--j;
+				std::swap(triangles[i], triangles[j]);
+				std::swap(mTriBounds[i], mTriBounds[j]);
+				std::swap(mCentroids[i], mCentroids[j]);
+			}
+		}
+		unsigned leftNum = i - first;
+		if (leftNum == 0 || leftNum == count)
+			return;
+
+		unsigned leftIndex = mNodes.size();
+		mNodes.push_back(Node());
+		mNodes.push_back(Node());
+		mNodes[leftIndex].mFirst = first;
+		mNodes[leftIndex].mCount = leftNum;
+		mNodes[leftIndex + 1].mFirst = i;
+		mNodes[leftIndex + 1].mCount = count - leftNum;
+		mNodes[nodeIndex].mFirst = leftIndex;
+		mNodes[nodeIndex].mCount = 0;
+		Subdivide(leftIndex, triangles, depth + 1);
+		Subdivide(leftIndex + 1, triangles, depth + 1);
+	}
+
+	int RayCast(const ModelTriangle* triangles, const Ray& ray, Real maxT, Real& outT) const{
+		if (mNodes.empty())
+			return -1;
+		const auto& origin = ray.GetOrigin();
+		const auto& dir = ray.GetDir();
+		const auto& dirInv = ray.GetDirInv();
+		int hit = -1;
+		Real best = maxT;
+		Real tEnter;
+		if (!HitNode(mNodes[0], origin, dirInv, best, tEnter))
+			return -1;
+		unsigned stack[MaxDepth * 2];
+		unsigned top = 0;
+		stack[top++] = 0;
+		while (top){
+			auto& node = mNodes[stack[--top]];
+			if (node.mCount){
+				for (unsigned i = node.mFirst; i < node.mFirst + node.mCount; ++i){
+					Real t;
+					if (GeomUtils::IntersectRayTriangle(origin, dir, triangles[i], best, t)){
+						best = t;
+						hit = i;
+					}
+				}
+				continue;
+			}
+			Real tNear, tFar;
+			unsigned nearIndex = node.mFirst, farIndex = node.mFirst + 1;
+			bool hitNear = HitNode(mNodes[nearIndex], origin, dirInv, best, tNear);
+			bool hitFar = HitNode(mNodes[farIndex], origin, dirInv, best, tFar);
+			if (hitNear && hitFar){
+				if (tFar < tNear)
+					std::swap(nearIndex, farIndex);
+				// Nearer child is popped first.
+				stack[top++] = farIndex;
+				stack[top++] = nearIndex;
+			}
+			else if (hitNear){
+				stack[top++] = nearIndex;
+			}
+			else if (hitFar){
+				stack[top++] = farIndex;
+			}
+		}
+		if (hit != -1)
+			outT = best;
+		return hit;
+	}
+
+	void RayCast(const ModelTriangle* triangles, const Ray* rays, unsigned num, Real maxT,
+		int* outTriangles, Real* outT) const
+	{
+		for (unsigned start = 0; start < num; start += PacketSize){
+			unsigned n = std::min(PacketSize, num - start);
+			RayCastPacket(triangles, rays + start, n, maxT, outTriangles + start, outT + start);
+		}
+	}
+
+	/// Nodes are fetched once for every ray in the packet. Each ray keeps its
+	/// own nearest hit; a node is skipped when no active ray reaches it.
+	void RayCastPacket(const ModelTriangle* triangles, const Ray* rays, unsigned num, Real maxT,
+		int* outTriangles, Real* outT) const
+	{
+		Real best[PacketSize];
+		for (unsigned r = 0; r < num; ++r){
+			outTriangles[r] = -1;
+			best[r] = maxT;
+		}
+		if (mNodes.empty())
+			return;
+		struct Entry{
+			unsigned mNode;
+			unsigned mMask;
+		};
+		Entry stack[MaxDepth * 2];
+		unsigned top = 0;
+		stack[top].mNode = 0;
+		stack[top].mMask = (1 << num) - 1;
+		++top;
+		while (top){
+			auto entry = stack[--top];
+			auto& node = mNodes[entry.mNode];
+			unsigned mask = 0;
+			Real tEnterFirst = FLT_MAX;
+			for (unsigned r = 0; r < num; ++r){
+				Real tEnter;
+				if ((entry.mMask & (1 << r)) &&
+					HitNode(node, rays[r].GetOrigin(), rays[r].GetDirInv(), best[r], tEnter))
+				{
+					mask |= 1 << r;
+					tEnterFirst = std::min(tEnterFirst, tEnter);
+				}
+			}
+			if (!mask)
+				continue;
+			if (node.mCount){
+				for (unsigned i = node.mFirst; i < node.mFirst + node.mCount; ++i){
+					for (unsigned r = 0; r < num; ++r){
+						Real t;
+						if ((mask & (1 << r)) &&
+							GeomUtils::IntersectRayTriangle(rays[r].GetOrigin(), rays[r].GetDir(), triangles[i], best[r], t))
+						{
+							best[r] = t;
+							outTriangles[r] = i;
+						}
+					}
+				}
+				continue;
+			}
+			// Order the children by the first active ray.
+			unsigned nearIndex = node.mFirst, farIndex = node.mFirst + 1;
+			for (unsigned r = 0; r < num; ++r){
+				if (mask & (1 << r)){
+					auto& n = mNodes[nearIndex];
+					auto& f = mNodes[farIndex];
+					auto& dir = rays[r].GetDir();
+					Real dn = 0, df = 0;
+					for (int a = 0; a < 3; ++a){
+						dn += (n.mMin[a] + n.mMax[a]) * dir[a];
+						df += (f.mMin[a] + f.mMax[a]) * dir[a];
+					}
+					if (df < dn)
+						std::swap(nearIndex, farIndex);
+					break;
+				}
+			}
+			stack[top].mNode = farIndex;
+			stack[top].mMask = mask;
+			++top;
+			stack[top].mNode = nearIndex;
+			stack[top].mMask = mask;
+			++top;
+		}
+		for (unsigned r = 0; r < num; ++r){
+			if (outTriangles[r] != -1)
+				outT[r] = best[r];
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+FB_IMPLEMENT_STATIC_CREATE(TriangleBVH);
+
+TriangleBVH::TriangleBVH()
+	: mImpl(new Impl)
+{
+}
+
+TriangleBVH::~TriangleBVH(){
+}
+
+void TriangleBVH::Build(const Vec3* positions, ModelTriangle* triangles, unsigned numTriangles){
+	mImpl->Build(positions, triangles, numTriangles);
+}
+
+int TriangleBVH::RayCast(const ModelTriangle* triangles, const Ray& ray, Real maxT, Real& outT) const{
+	return mImpl->RayCast(triangles, ray, maxT, outT);
+}
+
+void TriangleBVH::RayCast(const ModelTriangle* triangles, const Ray* rays, unsigned num, Real maxT,
+	int* outTriangles, Real* outT) const
+{
+	mImpl->RayCast(triangles, rays, num, maxT, outTriangles, outT);
+}
+
+unsigned TriangleBVH::GetNumNodes() const{
+	return mImpl->mNodes.size();
+}
+
+unsigned TriangleBVH::GetDepth() const{
+	return mImpl->mDepth;
+}
+
+size_t TriangleBVH::GetMemoryUsage() const{
+	return mImpl->mNodes.capacity() * sizeof(Node);
+}
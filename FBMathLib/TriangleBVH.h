@@ -0,0 +1,62 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb{
+	class Vec3;
+	class Ray;
+	struct ModelTriangle;
+	FB_DECLARE_SMART_PTR(TriangleBVH);
+	/// Bounding volume hierarchy over the triangles of a mesh.
+	/// Build() reorders the triangles so every leaf refers to a contiguous
+	/// range of them. The queries take the same reordered array.
+	class TriangleBVH{
+		FB_DECLARE_PIMPL_NON_COPYABLE(TriangleBVH);
+		TriangleBVH();
+		~TriangleBVH();
+
+	public:
+		/// Rays traversed together by the packet query.
+		static const unsigned PacketSize = 8;
+		static TriangleBVHPtr Create();
+
+		/// positions are indexed by ModelTriangle::v.
+		void Build(const Vec3* positions, ModelTriangle* triangles, unsigned numTriangles);
+		/// Returns the index of the nearest triangle hit before maxT or -1.
+		/// outT is in units of the ray direction.
+		int RayCast(const ModelTriangle* triangles, const Ray& ray, Real maxT, Real& outT) const;
+		/// Traverses up to PacketSize rays at once. outTriangles[i] is -1 when
+		/// rays[i] misses.
+		void RayCast(const ModelTriangle* triangles, const Ray* rays, unsigned num, Real maxT,
+			int* outTriangles, Real* outT) const;
+
+		unsigned GetNumNodes() const;
+		unsigned GetDepth() const;
+		size_t GetMemoryUsage() const;
+	};
+}
@@ -0,0 +1,622 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "VoxelVolume.h"
+#include "Vec3I.h"
+using namespace fb;
+
+static const unsigned BrickBits = 3;
+static const unsigned BrickSize = 1 << BrickBits;
+static const unsigned BrickMask = BrickSize - 1;
+static const unsigned EmptyBrick = 0xffffffff;
+static const unsigned FullBrick = 0xfffffffe;
+
+namespace{
+	/// mBits[z] holds the 8 rows along y, each row is 8 bits along x.
+	struct Brick{
+		UINT64 mBits[BrickSize];
+	};
+
+	unsigned PopCount(UINT64 v){
+		v = v - ((v >> 1) & 0x5555555555555555ULL);
+		v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+		v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		return (unsigned)((v * 0x0101010101010101ULL) >> 56);
+	}
+
+	bool IsFull(const Brick& b){
+		for (unsigned i = 0; i < BrickSize; ++i){
+			if (b.mBits[i] != ~UINT64(0))
+				return false;
+		}
+		return true;
+	}
+
+	bool IsEmpty(const Brick& b){
+		for (unsigned i = 0; i < BrickSize; ++i){
+			if (b.mBits[i])
+				return false;
+		}
+		return true;
+	}
+
+	/// Triangle in voxel units.
+	struct VoxelTriangle{
+		Vec3 mV[3];
+		Vec3 mMin;
+		Vec3 mMax;
+	};
+
+	/// Separating axis test between a triangle and the voxel (x, y, z).
+	/// Touching counts as overlapping. Written on plain floats since it runs
+	/// for every candidate voxel.
+	bool OverlapsVoxel(const VoxelTriangle& t, const Vec3& normal, int x, int y, int z){
+		const Real cx = x + 0.5f;
+		const Real cy = y + 0.5f;
+		const Real cz = z + 0.5f;
+		Real v[3][3];
+		for (int i = 0; i < 3; ++i){
+			v[i][0] = t.mV[i].x - cx;
+			v[i][1] = t.mV[i].y - cy;
+			v[i][2] = t.mV[i].z - cz;
+		}
+		Real r = 0.5f * (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+		Real d = normal.x * v[0][0] + normal.y * v[0][1] + normal.z * v[0][2];
+		if (d > r || d < -r)
+			return false;
+
+		for (int e = 0; e < 3; ++e){
+			const Real* v0 = v[e];
+			const Real* v1 = v[(e + 1) % 3];
+			const Real edge[3] = { v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2] };
+			// unit axis a cross edge only involves the two other components.
+			for (int a = 0; a < 3; ++a){
+				const int i = (a + 1) % 3;
+				const int j = (a + 2) % 3;
+				// axis = (.., -edge[j] on i, edge[i] on j)
+				Real p0 = edge[i] * v[0][j] - edge[j] * v[0][i];
+				Real p1 = edge[i] * v[1][j] - edge[j] * v[1][i];
+				Real p2 = edge[i] * v[2][j] - edge[j] * v[2][i];
+				r = 0.5f * (std::abs(edge[i]) + std::abs(edge[j]));
+				if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	/// Edge function of p->q at (px, py); positive on the left.
+	/// Always evaluated from the same end point so two triangles sharing the
+	/// edge get exactly opposite values. On the edge itself only one of them
+	/// takes the point, so a scanline never counts a shared edge twice.
+	bool InsideEdge(const Vec3& p, const Vec3& q, Real px, Real py, Real& e){
+		bool flip = q.x < p.x || (q.x == p.x && q.y < p.y);
+		const Vec3& a = flip ? q : p;
+		const Vec3& b = flip ? p : q;
+		e = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+		if (flip)
+			e = -e;
+		if (e != 0)
+			return e > 0;
+		Real dx = q.x - p.x;
+		Real dy = q.y - p.y;
+		return dy > 0 || (dy == 0 && dx < 0);
+	}
+
+	/// Bricks of one 8 voxel thick layer along y.
+	struct Slab{
+		std::vector<unsigned> mIndex; // bz * numBricks + bx
+		std::vector<Brick> mBricks;
+		std::vector<unsigned> mTriangles;
+		unsigned mNumBricks;
+
+		void Set(int x, int localY, int z){
+			auto& idx = mIndex[(z >> BrickBits) * mNumBricks + (x >> BrickBits)];
+			if (idx == EmptyBrick){
+				idx = mBricks.size();
+				mBricks.push_back(Brick());
+				memset(&mBricks.back(), 0, sizeof(Brick));
+			}
+			mBricks[idx].mBits[z & BrickMask] |= UINT64(1) << ((localY << BrickBits) | (x & BrickMask));
+		}
+
+		void Compact(){
+			std::vector<Brick> bricks;
+			bricks.reserve(mBricks.size());
+			for (auto& idx : mIndex){
+				if (idx == EmptyBrick || idx == FullBrick)
+					continue;
+				auto& brick = mBricks[idx];
+				if (IsFull(brick)){
+					idx = FullBrick;
+				}
+				else if (IsEmpty(brick)){
+					idx = EmptyBrick;
+				}
+				else{
+					idx = bricks.size();
+					bricks.push_back(brick);
+				}
+			}
+			mBricks.swap(bricks);
+		}
+	};
+}
+
+//---------------------------------------------------------------------------
+class VoxelVolume::Impl{
+public:
+	unsigned mNumVoxels;
+	unsigned mNumBricks; // in one axis
+	Vec3 mMin;
+	Real mVoxelSize;
+	std::vector<unsigned> mIndex; // (bz * mNumBricks + by) * mNumBricks + bx
+	std::vector<Brick> mBricks;
+
+	//---------------------------------------------------------------------------
+	Impl(unsigned numVoxels, const Vec3& min, Real voxelSize)
+		: mNumVoxels((numVoxels + BrickMask) & ~BrickMask)
+		, mNumBricks(mNumVoxels >> BrickBits)
+		, mMin(min)
+		, mVoxelSize(voxelSize)
+	{
+		Clear();
+	}
+
+	void Clear(){
+		mIndex.assign(mNumBricks * mNumBricks * mNumBricks, EmptyBrick);
+		mBricks.clear();
+	}
+
+	unsigned GetBrickIndex(int bx, int by, int bz) const{
+		if (bx < 0 || by < 0 || bz < 0 ||
+			bx >= (int)mNumBricks || by >= (int)mNumBricks || bz >= (int)mNumBricks)
+			return EmptyBrick;
+		return mIndex[(bz * mNumBricks + by) * mNumBricks + bx];
+	}
+
+	/// 8 bits along x of the brick column bx at the voxel row (y, z).
+	unsigned GetRow(int bx, int y, int z) const{
+		auto idx = GetBrickIndex(bx, y >> BrickBits, z >> BrickBits);
+		if (idx == EmptyBrick)
+			return 0;
+		if (idx == FullBrick)
+			return 0xff;
+		return (unsigned)(mBricks[idx].mBits[z & BrickMask] >> ((y & BrickMask) << BrickBits)) & 0xff;
+	}
+
+	bool Get(int x, int y, int z) const{
+		if (x < 0 || y < 0 || z < 0)
+			return false;
+		auto idx = GetBrickIndex(x >> BrickBits, y >> BrickBits, z >> BrickBits);
+		if (idx == EmptyBrick)
+			return false;
+		if (idx == FullBrick)
+			return true;
+		return (mBricks[idx].mBits[z & BrickMask] >> (((y & BrickMask) << BrickBits) | (x & BrickMask))) & 1;
+	}
+
+	void Set(int x, int y, int z, bool solid){
+		if (x < 0 || y < 0 || z < 0 || 
+			x >= (int)mNumVoxels || y >= (int)mNumVoxels || z >= (int)mNumVoxels)
+			return;
+		auto& idx = mIndex[((z >> BrickBits) * mNumBricks + (y >> BrickBits)) * mNumBricks + (x >> BrickBits)];
+		if (idx == (solid ? FullBrick : EmptyBrick))
+			return;
+		if (idx == EmptyBrick || idx == FullBrick){
+			Brick brick;
+			memset(&brick, idx == FullBrick ? 0xff : 0, sizeof(Brick));
+			idx = mBricks.size();
+			mBricks.push_back(brick);
+		}
+		auto bit = UINT64(1) << (((y & BrickMask) << BrickBits) | (x & BrickMask));
+		if (solid)
+			mBricks[idx].mBits[z & BrickMask] |= bit;
+		else
+			mBricks[idx].mBits[z & BrickMask] &= ~bit;
+	}
+
+	//---------------------------------------------------------------------------
+	void Voxelize(const Vec3* positions, unsigned numPositions,
+		const unsigned* indices, unsigned numIndices, bool solid, const ParallelFor& parallelFor)
+	{
+		Clear();
+		unsigned numTriangles = (indices ? numIndices : numPositions) / 3;
+		std::vector<VoxelTriangle> triangles;
+		triangles.reserve(numTriangles);
+		std::vector<Slab> slabs(mNumBricks);
+		for (auto& slab : slabs){
+			slab.mIndex.assign(mNumBricks * mNumBricks, EmptyBrick);
+			slab.mNumBricks = mNumBricks;
+		}
+
+		const Real invVoxelSize = 1.f / mVoxelSize;
+		const Real size = (Real)mNumVoxels;
+		unsigned numInvalid = 0;
+		for (unsigned i = 0; i < numTriangles; ++i){
+			VoxelTriangle t;
+			bool valid = true;
+			for (int v = 0; v < 3; ++v){
+				unsigned vi = indices ? indices[i * 3 + v] : i * 3 + v;
+				if (vi >= numPositions){
+					valid = false;
+					break;
+				}
+				t.mV[v] = (positions[vi] - mMin) * invVoxelSize;
+			}
+			if (!valid){
+				++numInvalid;
+				continue;
+			}
+			t.mMin = t.mV[0];
+			t.mMin.KeepLesser(t.mV[1]);
+			t.mMin.KeepLesser(t.mV[2]);
+			t.mMax = t.mV[0];
+			t.mMax.KeepGreater(t.mV[1]);
+			t.mMax.KeepGreater(t.mV[2]);
+			// Triangles outside along z still count for the inside test.
+			if (t.mMax.x < 0 || t.mMax.y < 0 || t.mMin.x > size || t.mMin.y > size)
+				continue;
+			unsigned triangleIndex = triangles.size();
+			triangles.push_back(t);
+			int y0 = std::max(0, (int)std::floor(t.mMin.y)) >> BrickBits;
+			int y1 = std::min((int)mNumVoxels - 1, (int)std::floor(t.mMax.y)) >> BrickBits;
+			for (int s = y0; s <= y1; ++s){
+				slabs[s].mTriangles.push_back(triangleIndex);
+			}
+		}
+		if (numInvalid){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("%u triangles have invalid indices.", numInvalid).c_str());
+		}
+
+		auto func = [&](unsigned start, unsigned end){
+			for (unsigned s = start; s < end; ++s){
+				VoxelizeSlab(slabs[s], triangles, s << BrickBits, solid);
+			}
+		};
+		if (parallelFor)
+			parallelFor(mNumBricks, func);
+		else
+			func(0, mNumBricks);
+
+		size_t numBricks = 0;
+		for (auto& slab : slabs){
+			numBricks += slab.mBricks.size();
+		}
+		mBricks.reserve(numBricks);
+		for (unsigned by = 0; by < mNumBricks; ++by){
+			auto& slab = slabs[by];
+			unsigned offset = mBricks.size();
+			mBricks.insert(mBricks.end(), slab.mBricks.begin(), slab.mBricks.end());
+			for (unsigned bz = 0; bz < mNumBricks; ++bz){
+				for (unsigned bx = 0; bx < mNumBricks; ++bx){
+					auto idx = slab.mIndex[bz * mNumBricks + bx];
+					if (idx != EmptyBrick && idx != FullBrick)
+						idx += offset;
+					mIndex[(bz * mNumBricks + by) * mNumBricks + bx] = idx;
+				}
+			}
+		}
+	}
+
+	void VoxelizeSlab(Slab& slab, const std::vector<VoxelTriangle>& triangles, int y0, bool solid){
+		for (auto ti : slab.mTriangles){
+			VoxelizeSurface(slab, triangles[ti], y0);
+		}
+		if (solid){
+			FillInside(slab, triangles, y0);
+		}
+		slab.Compact();
+	}
+
+	/// Visits only the voxels around the plane of the triangle: iterates over
+	/// the two minor axes of the normal and computes the range along the major one.
+	void VoxelizeSurface(Slab& slab, const VoxelTriangle& t, int y0){
+		int lo[3], hi[3];
+		for (int a = 0; a < 3; ++a){
+			lo[a] = std::max(0, (int)std::floor(t.mMin[a]));
+			hi[a] = std::min((int)mNumVoxels - 1, (int)std::floor(t.mMax[a]));
+		}
+		lo[1] = std::max(lo[1], y0);
+		hi[1] = std::min(hi[1], y0 + (int)BrickMask);
+		if (lo[0] > hi[0] || lo[1] > hi[1] || lo[2] > hi[2])
+			return;
+
+		const Vec3 normal = (t.mV[1] - t.mV[0]).Cross(t.mV[2] - t.mV[0]);
+		int w = 0;
+		if (std::abs(normal.y) > std::abs(normal[w]))
+			w = 1;
+		if (std::abs(normal.z) > std::abs(normal[w]))
+			w = 2;
+		const int u = (w + 1) % 3;
+		const int v = (w + 2) % 3;
+		if (normal[w] == 0){
+			// degenerated
+			for (int z = lo[2]; z <= hi[2]; ++z){
+				for (int y = lo[1]; y <= hi[1]; ++y){
+					for (int x = lo[0]; x <= hi[0]; ++x){
+						if (OverlapsVoxel(t, normal, x, y, z))
+							slab.Set(x, y - y0, z);
+					}
+				}
+			}
+			return;
+		}
+
+		const Real d = normal.Dot(t.mV[0]);
+		const Real invW = 1.f / normal[w];
+		int c[3];
+		for (c[u] = lo[u]; c[u] <= hi[u]; ++c[u]){
+			for (c[v] = lo[v]; c[v] <= hi[v]; ++c[v]){
+				Real w00 = (d - normal[u] * c[u] - normal[v] * c[v]) * invW;
+				Real du = -normal[u] * invW;
+				Real dv = -normal[v] * invW;
+				Real wMin = w00 + std::min(Real(0), du) + std::min(Real(0), dv);
+				Real wMax = w00 + std::max(Real(0), du) + std::max(Real(0), dv);
+				int w0 = std::max(lo[w], (int)std::floor(wMin));
+				int w1 = std::min(hi[w], (int)std::floor(wMax));
+				for (c[w] = w0; c[w] <= w1; ++c[w]){
+					if (OverlapsVoxel(t, normal, c[0], c[1], c[2]))
+						slab.Set(c[0], c[1] - y0, c[2]);
+				}
+			}
+		}
+	}
+
+	/// Casts a ray along +z through the center of every voxel column and
+	/// fills between pairs of crossings. Open meshes leave a lone crossing
+	/// at the end of a column, which is ignored.
+	/// Runs are toggled into 8 bit row masks and resolved with a prefix xor,
+	/// so bricks inside the mesh become FullBrick without being stored.
+	void FillInside(Slab& slab, const std::vector<VoxelTriangle>& triangles, int y0){
+		const unsigned N = mNumVoxels;
+		const unsigned B = mNumBricks;
+		// (ly * N + z) * B + bx
+		std::vector<unsigned char> masks(BrickSize * N * B, 0);
+		std::vector< std::pair<int, Real> > crossings;
+		for (unsigned ly = 0; ly < BrickSize; ++ly){
+			crossings.clear();
+			const Real py = y0 + ly + 0.5f;
+			for (auto ti : slab.mTriangles){
+				auto& t = triangles[ti];
+				if (t.mMin.y > py || t.mMax.y < py)
+					continue;
+				const Vec3* a = &t.mV[0];
+				const Vec3* b = &t.mV[1];
+				const Vec3* c = &t.mV[2];
+				Real area = (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+				if (area == 0)
+					continue;
+				if (area < 0)
+					std::swap(b, c);
+				int x0 = std::max(0, (int)std::ceil(t.mMin.x - 0.5f));
+				int x1 = std::min((int)N - 1, (int)std::floor(t.mMax.x - 0.5f));
+				for (int x = x0; x <= x1; ++x){
+					const Real px = x + 0.5f;
+					Real ea, eb, ec;
+					if (!InsideEdge(*b, *c, px, py, ea) || !InsideEdge(*c, *a, px, py, eb) ||
+						!InsideEdge(*a, *b, px, py, ec))
+						continue;
+					Real sum = ea + eb + ec;
+					if (sum <= 0)
+						continue;
+					crossings.push_back(std::make_pair(x, (ea * a->z + eb * b->z + ec * c->z) / sum));
+				}
+			}
+			std::sort(crossings.begin(), crossings.end());
+			auto rowMasks = &masks[ly * N * B];
+			int lastX = -1;
+			int lastEnd = -1;
+			for (size_t i = 0; i + 1 < crossings.size(); ){
+				auto& enter = crossings[i];
+				auto& exit = crossings[i + 1];
+				if (enter.first != exit.first){
+					++i;
+					continue;
+				}
+				const int x = enter.first;
+				int z0 = std::max(0, (int)std::ceil(enter.second - 0.5f));
+				int z1 = std::min((int)N - 1, (int)std::floor(exit.second - 0.5f));
+				if (x == lastX)
+					z0 = std::max(z0, lastEnd + 1);
+				if (z0 <= z1){
+					const unsigned char bit = (unsigned char)(1 << (x & BrickMask));
+					rowMasks[z0 * B + (x >> BrickBits)] ^= bit;
+					if (z1 + 1 < (int)N)
+						rowMasks[(z1 + 1) * B + (x >> BrickBits)] ^= bit;
+					lastX = x;
+					lastEnd = z1;
+				}
+				i += 2;
+			}
+			for (unsigned z = 1; z < N; ++z){
+				for (unsigned bx = 0; bx < B; ++bx){
+					rowMasks[z * B + bx] ^= rowMasks[(z - 1) * B + bx];
+				}
+			}
+		}
+
+		for (unsigned bz = 0; bz < B; ++bz){
+			for (unsigned bx = 0; bx < B; ++bx){
+				Brick brick;
+				bool empty = true;
+				bool full = true;
+				for (unsigned lz = 0; lz < BrickSize; ++lz){
+					UINT64 word = 0;
+					for (unsigned ly = 0; ly < BrickSize; ++ly){
+						word |= UINT64(masks[(ly * N + (bz << BrickBits) + lz) * B + bx]) << (ly << BrickBits);
+					}
+					brick.mBits[lz] = word;
+					empty = empty && word == 0;
+					full = full && word == ~UINT64(0);
+				}
+				if (empty)
+					continue;
+				auto& idx = slab.mIndex[bz * B + bx];
+				if (idx == EmptyBrick){
+					if (full){
+						idx = FullBrick;
+						continue;
+					}
+					idx = slab.mBricks.size();
+					slab.mBricks.push_back(brick);
+				}
+				else if (idx != FullBrick){
+					auto& dest = slab.mBricks[idx];
+					for (unsigned lz = 0; lz < BrickSize; ++lz){
+						dest.mBits[lz] |= brick.mBits[lz];
+					}
+				}
+			}
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	void GetSurfaceVoxels(std::vector<Vec3I>& out, const ParallelFor& parallelFor) const{
+		std::vector< std::vector<Vec3I> > slabs(mNumBricks);
+		const int half = mNumVoxels / 2;
+		auto func = [&](unsigned start, unsigned end){
+			for (unsigned by = start; by < end; ++by){
+				auto& slabOut = slabs[by];
+				for (int bz = 0; bz < (int)mNumBricks; ++bz){
+					for (int bx = 0; bx < (int)mNumBricks; ++bx){
+						auto idx = GetBrickIndex(bx, by, bz);
+						if (idx == EmptyBrick)
+							continue;
+						if (idx == FullBrick &&
+							GetBrickIndex(bx - 1, by, bz) == FullBrick && GetBrickIndex(bx + 1, by, bz) == FullBrick &&
+							GetBrickIndex(bx, by - 1, bz) == FullBrick && GetBrickIndex(bx, by + 1, bz) == FullBrick &&
+							GetBrickIndex(bx, by, bz - 1) == FullBrick && GetBrickIndex(bx, by, bz + 1) == FullBrick)
+							continue;
+						for (int lz = 0; lz < (int)BrickSize; ++lz){
+							const int z = (bz << BrickBits) + lz;
+							for (int ly = 0; ly < (int)BrickSize; ++ly){
+								const int y = (by << BrickBits) + ly;
+								unsigned row = GetRow(bx, y, z);
+								if (!row)
+									continue;
+								unsigned inner = row & GetRow(bx, y - 1, z) & GetRow(bx, y + 1, z) &
+									GetRow(bx, y, z - 1) & GetRow(bx, y, z + 1) &
+									((row << 1) | (GetRow(bx - 1, y, z) >> 7)) &
+									((row >> 1) | ((GetRow(bx + 1, y, z) & 1) << 7));
+								unsigned surface = row & ~inner & 0xff;
+								for (int lx = 0; surface; ++lx, surface >>= 1){
+									if (surface & 1)
+										slabOut.push_back(Vec3I((bx << BrickBits) + lx - half, y - half, z - half));
+								}
+							}
+						}
+					}
+				}
+			}
+		};
+		if (parallelFor)
+			parallelFor(mNumBricks, func);
+		else
+			func(0, mNumBricks);
+
+		out.clear();
+		size_t num = 0;
+		for (auto& slab : slabs){
+			num += slab.size();
+		}
+		out.reserve(num);
+		for (auto& slab : slabs){
+			out.insert(out.end(), slab.begin(), slab.end());
+		}
+	}
+
+	size_t GetNumSolidVoxels() const{
+		size_t num = 0;
+		for (auto idx : mIndex){
+			if (idx == FullBrick)
+				num += BrickSize * BrickSize * BrickSize;
+		}
+		for (auto& brick : mBricks){
+			for (unsigned i = 0; i < BrickSize; ++i){
+				num += PopCount(brick.mBits[i]);
+			}
+		}
+		return num;
+	}
+};
+
+//---------------------------------------------------------------------------
+VoxelVolume::VoxelVolume(unsigned numVoxels, const Vec3& min, Real voxelSize)
+	: mImpl(new Impl(numVoxels, min, voxelSize))
+{
+}
+
+VoxelVolume::~VoxelVolume(){
+}
+
+unsigned VoxelVolume::GetNumVoxels() const{
+	return mImpl->mNumVoxels;
+}
+
+const Vec3& VoxelVolume::GetMin() const{
+	return mImpl->mMin;
+}
+
+Real VoxelVolume::GetVoxelSize() const{
+	return mImpl->mVoxelSize;
+}
+
+bool VoxelVolume::Get(int x, int y, int z) const{
+	return mImpl->Get(x, y, z);
+}
+
+void VoxelVolume::Set(int x, int y, int z, bool solid){
+	mImpl->Set(x, y, z, solid);
+}
+
+void VoxelVolume::Clear(){
+	mImpl->Clear();
+}
+
+void VoxelVolume::Voxelize(const Vec3* positions, unsigned numPositions,
+	const unsigned* indices, unsigned numIndices, bool solid, const ParallelFor& parallelFor)
+{
+	mImpl->Voxelize(positions, numPositions, indices, numIndices, solid, parallelFor);
+}
+
+void VoxelVolume::GetSurfaceVoxels(std::vector<Vec3I>& out, const ParallelFor& parallelFor) const{
+	mImpl->GetSurfaceVoxels(out, parallelFor);
+}
+
+size_t VoxelVolume::GetNumSolidVoxels() const{
+	return mImpl->GetNumSolidVoxels();
+}
+
+unsigned VoxelVolume::GetNumStoredBricks() const{
+	return mImpl->mBricks.size();
+}
+
+size_t VoxelVolume::GetMemoryUsage() const{
+	return mImpl->mIndex.size() * sizeof(unsigned) + mImpl->mBricks.size() * sizeof(Brick);
+}
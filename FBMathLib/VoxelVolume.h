@@ -0,0 +1,74 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "FBCommonHeaders/ParallelFor.h"
+#include "Vec3.h"
+namespace fb{
+	class Vec3I;
+	FB_DECLARE_SMART_PTR(VoxelVolume);
+	/// Sparse binary volume made of 8x8x8 bricks. Bricks that are entirely
+	/// empty or entirely solid take no storage.
+	/// Voxelize() does not need a renderer, so it can run in tools and on servers.
+	class VoxelVolume{
+		FB_DECLARE_PIMPL_NON_COPYABLE(VoxelVolume);
+
+	public:
+		/// numVoxels is rounded up to a multiple of 8.
+		/// min is the corner of the voxel (0, 0, 0).
+		VoxelVolume(unsigned numVoxels, const Vec3& min, Real voxelSize);
+		~VoxelVolume();
+
+		unsigned GetNumVoxels() const;
+		const Vec3& GetMin() const;
+		Real GetVoxelSize() const;
+
+		bool Get(int x, int y, int z) const;
+		/// Not thread safe.
+		void Set(int x, int y, int z, bool solid);
+		void Clear();
+
+		/// Replaces the contents with the voxels the triangles touch.
+		/// When 'solid' is true the inside of closed meshes is filled as well.
+		/// positions is a triangle list when indices is null.
+		/// Work is split into slabs of 8 voxels along y and handed to parallelFor.
+		void Voxelize(const Vec3* positions, unsigned numPositions,
+			const unsigned* indices, unsigned numIndices, bool solid,
+			const ParallelFor& parallelFor = ParallelFor());
+
+		/// Solid voxels which have an empty face neighbor. Coordinates are
+		/// relative to the center of the volume.
+		void GetSurfaceVoxels(std::vector<Vec3I>& out,
+			const ParallelFor& parallelFor = ParallelFor()) const;
+
+		size_t GetNumSolidVoxels() const;
+		/// Number of bricks which have their own storage.
+		unsigned GetNumStoredBricks() const;
+		size_t GetMemoryUsage() const;
+	};
+}
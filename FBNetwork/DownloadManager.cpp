@@ -0,0 +1,646 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "DownloadManager.h"
+#include "FBThread/threads.h"
+#include "FBThread/TaskScheduler.h"
+#include "FBThread/Invoker.h"
+#include <curl/curl.h>
+using namespace fb;
+
+// curl_multi_poll() and curl_multi_wakeup() are available from 7.68.0.
+#define FB_CURL_HAS_MULTI_POLL (LIBCURL_VERSION_NUM >= 0x074400)
+
+namespace fb {
+	class DownloadCallbackTask : public Task {
+		DownloadCallback mCallback;
+		DownloadResultPtr mResult;
+
+	public:
+		DownloadCallbackTask(const DownloadCallback& callback, DownloadResultPtr result)
+			: mCallback(callback)
+			, mResult(result)
+		{
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE {
+			mCallback(*mResult);
+		}
+	};
+
+	struct Transfer {
+		DownloadRequest mRequest;
+		DownloadResultPtr mResult;
+		CURL* mCurl;
+		FILE* mFile;
+		std::string mPartPath;
+		UINT64 mResumeFrom;
+		// Total size from the Content-Range header. 0 when not given.
+		UINT64 mRangeTotal;
+		bool mCheckedResponse;
+		char mErrorBuffer[CURL_ERROR_SIZE];
+
+		Transfer()
+			: mResult(new DownloadResult)
+			, mCurl(0)
+			, mFile(0)
+			, mResumeFrom(0)
+			, mRangeTotal(0)
+			, mCheckedResponse(false)
+		{
+			mErrorBuffer[0] = 0;
+		}
+	};
+	typedef std::shared_ptr<Transfer> TransferPtr;
+
+	class DownloadThread : public Thread {
+	public:
+		std::function<bool()> mUpdate;
+
+		// Returns 'repeat?' flag.
+		bool Run() {
+			return mUpdate();
+		}
+	};
+}
+
+static const size_t MaxPooledHandles = 16;
+static const int PollTimeoutMs = 100;
+static DownloadManager* sDownloadManagerRaw = 0;
+static DownloadManagerWeakPtr sDownloadManager;
+
+class DownloadManager::Impl {
+public:
+	unsigned mMaxConcurrent;
+	CURLM* mMulti;
+	DownloadThread mThread;
+	std::atomic<DownloadId> mNextId;
+
+	// Shared with the download thread.
+	mutable CriticalSection mLock;
+	std::deque<TransferPtr> mQueued;
+	std::unordered_set<DownloadId> mActiveIds;
+	std::vector<DownloadId> mCancelRequests;
+	Stats mStats;
+
+	// Download thread only.
+	std::unordered_map<CURL*, TransferPtr> mRunning;
+	std::vector<CURL*> mFreeHandles;
+
+	//---------------------------------------------------------------------------
+	Impl(unsigned maxConcurrent)
+		: mMaxConcurrent(std::max(1u, maxConcurrent))
+		, mNextId(1)
+	{
+		memset(&mStats, 0, sizeof(mStats));
+		mMulti = curl_multi_init();
+		if (!mMulti) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Cannot create a curl multi handle. Is Network::Initialize() called?");
+			return;
+		}
+		curl_multi_setopt(mMulti, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)mMaxConcurrent);
+		curl_multi_setopt(mMulti, CURLMOPT_MAXCONNECTS, (long)mMaxConcurrent);
+		curl_multi_setopt(mMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+	}
+
+	~Impl() {
+		for (auto& it : mRunning) {
+			curl_multi_remove_handle(mMulti, it.first);
+			curl_easy_cleanup(it.first);
+			CloseFile(*it.second);
+		}
+		mRunning.clear();
+		for (auto curl : mFreeHandles) {
+			curl_easy_cleanup(curl);
+		}
+		mFreeHandles.clear();
+		if (mMulti)
+			curl_multi_cleanup(mMulti);
+	}
+
+	void StartThread() {
+		if (!mMulti)
+			return;
+		mThread.mUpdate = [this]() { return Update(); };
+		mThread.CreateThread(1024, "DownloadThread");
+	}
+
+	void StopThread() {
+		if (!mThread.IsJoinable())
+			return;
+		mThread.ForceExit(false);
+		WakeUp();
+		mThread.Join();
+	}
+
+	void WakeUp() {
+#if FB_CURL_HAS_MULTI_POLL
+		if (mMulti)
+			curl_multi_wakeup(mMulti);
+#endif
+	}
+
+	DownloadId Download(const DownloadRequest& request) {
+		if (request.mUrl.empty()) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid url.");
+			return INVALID_DOWNLOAD_ID;
+		}
+		if (!mMulti) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Download manager is not initialized.");
+			return INVALID_DOWNLOAD_ID;
+		}
+		auto transfer = std::make_shared<Transfer>();
+		transfer->mRequest = request;
+		auto& result = *transfer->mResult;
+		result.mId = mNextId++;
+		result.mUrl = request.mUrl;
+		result.mFilePath = request.mFilePath;
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			mQueued.push_back(transfer);
+			mActiveIds.insert(result.mId);
+		}
+		WakeUp();
+		return result.mId;
+	}
+
+	void Cancel(DownloadId id) {
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			if (mActiveIds.find(id) == mActiveIds.end())
+				return;
+			mCancelRequests.push_back(id);
+		}
+		WakeUp();
+	}
+
+	void CancelAll() {
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			mCancelRequests.insert(mCancelRequests.end(), mActiveIds.begin(), mActiveIds.end());
+		}
+		WakeUp();
+	}
+
+	bool IsDownloading(DownloadId id) const {
+		ENTER_CRITICAL_SECTION l(mLock);
+		return mActiveIds.find(id) != mActiveIds.end();
+	}
+
+	size_t GetNumDownloads() const {
+		ENTER_CRITICAL_SECTION l(mLock);
+		return mActiveIds.size();
+	}
+
+	void WaitAll() {
+		while (GetNumDownloads() != 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	Stats GetStats(bool reset) {
+		ENTER_CRITICAL_SECTION l(mLock);
+		auto stats = mStats;
+		if (reset)
+			memset(&mStats, 0, sizeof(mStats));
+		return stats;
+	}
+
+	//---------------------------------------------------------------------------
+	// Download thread
+	//---------------------------------------------------------------------------
+	bool Update() {
+		ProcessCancelRequests();
+		StartQueued();
+		int stillRunning = 0;
+		curl_multi_perform(mMulti, &stillRunning);
+		ProcessFinished();
+		if (mThread.IsForceExit())
+			return false;
+#if FB_CURL_HAS_MULTI_POLL
+		curl_multi_poll(mMulti, 0, 0, PollTimeoutMs, 0);
+#else
+		if (mRunning.empty()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		else {
+			curl_multi_wait(mMulti, 0, 0, PollTimeoutMs, 0);
+		}
+#endif
+		return true;
+	}
+
+	void ProcessCancelRequests() {
+		std::vector<DownloadId> canceled;
+		std::vector<TransferPtr> canceledQueued;
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			if (mCancelRequests.empty())
+				return;
+			canceled.swap(mCancelRequests);
+			for (auto it = mQueued.begin(); it != mQueued.end(); /**/) {
+				if (ValueExistsInVector(canceled, (*it)->mResult->mId)) {
+					canceledQueued.push_back(*it);
+					it = mQueued.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+		}
+		for (auto& transfer : canceledQueued) {
+			transfer->mResult->mError = "Canceled";
+			Finish(transfer, false);
+		}
+		for (auto it = mRunning.begin(); it != mRunning.end(); /**/) {
+			auto transfer = it->second;
+			if (ValueExistsInVector(canceled, transfer->mResult->mId)) {
+				it = mRunning.erase(it);
+				curl_multi_remove_handle(mMulti, transfer->mCurl);
+				transfer->mResult->mError = "Canceled";
+				Finish(transfer, false);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	void StartQueued() {
+		while (mRunning.size() < mMaxConcurrent) {
+			TransferPtr transfer;
+			{
+				ENTER_CRITICAL_SECTION l(mLock);
+				if (mQueued.empty())
+					break;
+				transfer = mQueued.front();
+				mQueued.pop_front();
+			}
+			if (!Start(transfer)) {
+				Finish(transfer, false);
+			}
+		}
+	}
+
+	bool Start(TransferPtr transfer) {
+		auto& request = transfer->mRequest;
+		auto& result = *transfer->mResult;
+		if (!request.mFilePath.empty()) {
+			transfer->mPartPath = request.mFilePath + ".part";
+			if (request.mResume && FileSystem::Exists(transfer->mPartPath.c_str())) {
+				transfer->mResumeFrom = FileSystem::GetFileSize(transfer->mPartPath.c_str());
+			}
+			auto parent = FileSystem::GetParentPath(request.mFilePath.c_str());
+			if (!parent.empty() && !FileSystem::Exists(parent.c_str())) {
+				FileSystem::CreateDirectory(parent.c_str());
+			}
+			transfer->mFile = FileSystem::OpenFile(transfer->mPartPath.c_str(), 
+				transfer->mResumeFrom ? "ab" : "wb");
+			if (!transfer->mFile) {
+				result.mError = FormatString("Cannot open the file(%s).", transfer->mPartPath.c_str());
+				return false;
+			}
+		}
+
+		CURL* curl = 0;
+		if (!mFreeHandles.empty()) {
+			curl = mFreeHandles.back();
+			mFreeHandles.pop_back();
+			curl_easy_reset(curl);
+		}
+		else {
+			curl = curl_easy_init();
+			if (!curl) {
+				result.mError = "Cannot create a curl handle.";
+				return false;
+			}
+		}
+		transfer->mCurl = curl;
+		curl_easy_setopt(curl, CURLOPT_URL, request.mUrl.c_str());
+		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+		curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+		curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer->mErrorBuffer);
+		curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+		if (request.mLowSpeedTimeSec) {
+			curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+			curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, (long)request.mLowSpeedTimeSec);
+		}
+		if (transfer->mResumeFrom) {
+			curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)transfer->mResumeFrom);
+			curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+			curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer.get());
+		}
+		auto err = curl_multi_add_handle(mMulti, curl);
+		if (err != CURLM_OK) {
+			result.mError = FormatString("Cannot add the transfer: %s", curl_multi_strerror(err));
+			return false;
+		}
+		mRunning[curl] = transfer;
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Requesting : %s", request.mUrl.c_str()).c_str());
+		return true;
+	}
+
+	// Only set for range requests.
+	static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+		auto transfer = (Transfer*)userdata;
+		size_t bytes = size * nitems;
+		std::string line(buffer, bytes);
+		// Redirects deliver the headers of every response.
+		if (StartsWith(line, "HTTP/")) {
+			transfer->mRangeTotal = 0;
+		}
+		else if (StartsWith(line, "Content-Range:")) {
+			// bytes <first>-<last>/<total> or bytes */<total>
+			auto slash = line.find('/');
+			if (slash != std::string::npos)
+				transfer->mRangeTotal = strtoull(line.c_str() + slash + 1, 0, 10);
+		}
+		return bytes;
+	}
+
+	static size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+		auto transfer = (Transfer*)userdata;
+		auto& result = *transfer->mResult;
+		size_t bytes = size * nmemb;
+		if (!transfer->mCheckedResponse) {
+			transfer->mCheckedResponse = true;
+			long responseCode = 0;
+			curl_easy_getinfo(transfer->mCurl, CURLINFO_RESPONSE_CODE, &responseCode);
+			// Do not write error pages into the file.
+			if (responseCode >= 400)
+				return 0;
+			if (transfer->mResumeFrom && responseCode == 200 && transfer->mFile) {
+				// The server ignored the range.
+				FileSystem::CloseFile(transfer->mFile);
+				transfer->mFile = FileSystem::OpenFile(transfer->mPartPath.c_str(), "wb");
+				transfer->mResumeFrom = 0;
+				if (!transfer->mFile)
+					return 0;
+			}
+		}
+		if (transfer->mRequest.mOnData) {
+			if (!transfer->mRequest.mOnData(ptr, bytes))
+				return 0;
+		}
+		if (transfer->mFile) {
+			if (fwrite(ptr, 1, bytes, transfer->mFile) != bytes)
+				return 0;
+		}
+		else if (!transfer->mRequest.mOnData) {
+			result.mBuffer.insert(result.mBuffer.end(), ptr, ptr + bytes);
+		}
+		result.mBytesReceived += bytes;
+		return bytes;
+	}
+
+	void ProcessFinished() {
+		int numMessages = 0;
+		while (auto msg = curl_multi_info_read(mMulti, &numMessages)) {
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			auto it = mRunning.find(msg->easy_handle);
+			if (it == mRunning.end())
+				continue;
+			auto transfer = it->second;
+			mRunning.erase(it);
+			auto curl = transfer->mCurl;
+			auto& result = *transfer->mResult;
+			long responseCode = 0;
+			curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+			result.mResponseCode = (int)responseCode;
+			char* contentType = 0;
+			curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+			if (contentType)
+				result.mContentType = contentType;
+			long numConnects = 0;
+			curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &numConnects);
+			curl_multi_remove_handle(mMulti, curl);
+
+			bool success = false;
+			bool restart = false;
+			auto code = msg->data.result;
+			if (responseCode == 416 && transfer->mResumeFrom) {
+				// The .part file is complete only when it is as large as the
+				// file on the server. Otherwise it is from an other version.
+				success = transfer->mRangeTotal == transfer->mResumeFrom;
+				restart = !success;
+			}
+			else if (code == CURLE_OK) {
+				// 0 for file://
+				success = responseCode == 0 || (responseCode >= 200 && responseCode < 300);
+				if (!success)
+					result.mError = FormatString("HTTP error %d", responseCode);
+			}
+			else if (responseCode >= 400) {
+				result.mError = FormatString("HTTP error %d", responseCode);
+			}
+			else {
+				result.mError = transfer->mErrorBuffer[0] ? 
+					transfer->mErrorBuffer : curl_easy_strerror(code);
+			}
+			{
+				ENTER_CRITICAL_SECTION l(mLock);
+				if (numConnects > 0)
+					++mStats.mNumNewConnections;
+			}
+			if (restart && Restart(transfer))
+				continue;
+			Finish(transfer, success);
+		}
+	}
+
+	void CloseFile(Transfer& transfer) {
+		if (transfer.mFile) {
+			FileSystem::CloseFile(transfer.mFile);
+			transfer.mFile = 0;
+		}
+	}
+
+	void ReleaseHandle(Transfer& transfer) {
+		if (transfer.mCurl) {
+			if (mFreeHandles.size() < MaxPooledHandles)
+				mFreeHandles.push_back(transfer.mCurl);
+			else
+				curl_easy_cleanup(transfer.mCurl);
+			transfer.mCurl = 0;
+		}
+	}
+
+	// Discards the .part file and downloads the whole file again.
+	bool Restart(TransferPtr transfer) {
+		Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("The .part file(%s, %llu bytes) doesn't match the file on the server(%llu bytes). Restarting.",
+			transfer->mPartPath.c_str(), transfer->mResumeFrom, transfer->mRangeTotal).c_str());
+		CloseFile(*transfer);
+		ReleaseHandle(*transfer);
+		FileSystem::Remove(transfer->mPartPath.c_str());
+		transfer->mResumeFrom = 0;
+		transfer->mRangeTotal = 0;
+		transfer->mCheckedResponse = false;
+		transfer->mErrorBuffer[0] = 0;
+		return Start(transfer);
+	}
+
+	void Finish(TransferPtr transfer, bool success) {
+		auto& result = *transfer->mResult;
+		CloseFile(*transfer);
+		ReleaseHandle(*transfer);
+		if (success && !transfer->mPartPath.empty()) {
+			auto filepath = result.mFilePath.c_str();
+			if (FileSystem::Exists(filepath))
+				FileSystem::Remove(filepath);
+			if (FileSystem::Rename(transfer->mPartPath.c_str(), filepath) != 0) {
+				result.mError = FormatString("Cannot rename the file(%s).", transfer->mPartPath.c_str());
+				success = false;
+			}
+			else {
+				result.mTotalSize = FileSystem::GetFileSize(filepath);
+			}
+		}
+		else if (transfer->mPartPath.empty()) {
+			result.mTotalSize = transfer->mRequest.mOnData ? result.mBytesReceived : result.mBuffer.size();
+		}
+		result.mSuccess = success;
+		if (!success) {
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Download failed(%s): %s",
+				result.mUrl.c_str(), result.mError.c_str()).c_str());
+		}
+		{
+			ENTER_CRITICAL_SECTION l(mLock);
+			if (success)
+				++mStats.mNumSucceeded;
+			else
+				++mStats.mNumFailed;
+			mStats.mBytesReceived += result.mBytesReceived;
+		}
+		PostCallback(transfer);
+		// Removed after the callback is posted so WaitAll() covers the
+		// callbacks which are called on this thread.
+		ENTER_CRITICAL_SECTION l(mLock);
+		mActiveIds.erase(result.mId);
+	}
+
+	void PostCallback(TransferPtr transfer) {
+		auto& callback = transfer->mRequest.mOnFinished;
+		if (!callback)
+			return;
+		auto result = transfer->mResult;
+		switch (transfer->mRequest.mCallbackThread) {
+		case DownloadCallbackThread::Worker:
+			if (TaskScheduler::HasInstance()) {
+				TaskScheduler::GetInstance().AddTask(std::make_shared<DownloadCallbackTask>(callback, result));
+				return;
+			}
+			break;
+		case DownloadCallbackThread::Main:
+			if (Invoker::HasInstance()) {
+				Invoker::GetInstance().InvokeAtStart([callback, result]() {
+					callback(*result);
+				});
+				return;
+			}
+			break;
+		}
+		callback(*result);
+	}
+};
+
+//---------------------------------------------------------------------------
+DownloadManagerPtr DownloadManager::Create(unsigned maxConcurrent) {
+	if (sDownloadManager.expired()) {
+		DownloadManagerPtr p(new DownloadManager(maxConcurrent), [](DownloadManager* obj) { delete obj; });
+		sDownloadManager = p;
+		sDownloadManagerRaw = p.get();
+		return p;
+	}
+	return sDownloadManager.lock();
+}
+
+DownloadManager& DownloadManager::GetInstance() {
+	if (sDownloadManager.expired()) {
+		Logger::Log(FB_ERROR_LOG_ARG, "DownloadManager is deleted. Program will crash...");
+	}
+	return *sDownloadManagerRaw;
+}
+
+bool DownloadManager::HasInstance() {
+	return !sDownloadManager.expired();
+}
+
+DownloadManager::DownloadManager(unsigned maxConcurrent)
+	: mImpl(new Impl(maxConcurrent))
+{
+	mImpl->StartThread();
+}
+
+DownloadManager::~DownloadManager() {
+	mImpl->StopThread();
+	sDownloadManagerRaw = 0;
+}
+
+DownloadId DownloadManager::Download(const DownloadRequest& request) {
+	return mImpl->Download(request);
+}
+
+DownloadId DownloadManager::Download(const char* url, const char* filepath, DownloadCallback onFinished) {
+	if (!ValidCString(url)) {
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return INVALID_DOWNLOAD_ID;
+	}
+	DownloadRequest request;
+	request.mUrl = url;
+	if (ValidCString(filepath))
+		request.mFilePath = filepath;
+	request.mOnFinished = onFinished;
+	return mImpl->Download(request);
+}
+
+void DownloadManager::Cancel(DownloadId id) {
+	mImpl->Cancel(id);
+}
+
+void DownloadManager::CancelAll() {
+	mImpl->CancelAll();
+}
+
+bool DownloadManager::IsDownloading(DownloadId id) const {
+	return mImpl->IsDownloading(id);
+}
+
+size_t DownloadManager::GetNumDownloads() const {
+	return mImpl->GetNumDownloads();
+}
+
+void DownloadManager::WaitAll() {
+	mImpl->WaitAll();
+}
+
+DownloadManager::Stats DownloadManager::GetStats(bool reset) {
+	return mImpl->GetStats(reset);
+}
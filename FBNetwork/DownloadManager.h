@@ -0,0 +1,136 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb {
+	typedef unsigned DownloadId;
+	static const DownloadId INVALID_DOWNLOAD_ID = 0;
+
+	FB_DECLARE_SMART_PTR_STRUCT(DownloadResult);
+	struct DownloadResult {
+		DownloadId mId;
+		std::string mUrl;
+		/// Empty for memory downloads.
+		std::string mFilePath;
+		bool mSuccess;
+		int mResponseCode;
+		std::string mError;
+		/// Bytes received by this transfer. Less than mTotalSize when resumed.
+		UINT64 mBytesReceived;
+		/// Size of the file on disk or of mBuffer.
+		UINT64 mTotalSize;
+		/// Content of memory downloads.
+		ByteArray mBuffer;
+		std::string mContentType;
+
+		DownloadResult()
+			: mId(INVALID_DOWNLOAD_ID), mSuccess(false), mResponseCode(0)
+			, mBytesReceived(0), mTotalSize(0)
+		{
+		}
+	};
+	typedef std::function<void(const DownloadResult& result)> DownloadCallback;
+	/// Called on the download thread for each received chunk.
+	/// Returns false to abort the transfer.
+	typedef std::function<bool(const char* data, size_t size)> DownloadDataFunc;
+
+	struct DownloadCallbackThread {
+		enum Enum {
+			/// Posted to TaskScheduler. Called directly when there is no scheduler.
+			Worker,
+			/// Called at the beginning of the next frame through Invoker.
+			Main,
+			/// Called on the download thread. Keep it short.
+			Download,
+		};
+	};
+
+	struct DownloadRequest {
+		std::string mUrl;
+		/// When set, data is written to mFilePath + ".part" and renamed to
+		/// mFilePath after the transfer succeeded.
+		std::string mFilePath;
+		/// Continues an existing .part file with a range request. The .part
+		/// is discarded when it doesn't fit the size of the file on the server.
+		bool mResume;
+		/// Receives the data as it arrives. Memory downloads do not fill
+		/// DownloadResult::mBuffer when it is set.
+		DownloadDataFunc mOnData;
+		DownloadCallback mOnFinished;
+		DownloadCallbackThread::Enum mCallbackThread;
+		/// Aborts when less than 1 byte/sec is received for this long. 0 to disable.
+		unsigned mLowSpeedTimeSec;
+
+		DownloadRequest()
+			: mResume(true)
+			, mCallbackThread(DownloadCallbackThread::Worker)
+			, mLowSpeedTimeSec(30)
+		{
+		}
+	};
+
+	FB_DECLARE_SMART_PTR(DownloadManager);
+	/** Runs many transfers concurrently on one thread with curl's multi
+	interface. Transfers to the same host share connections.
+	Network::Initialize() has to be called before creating it.
+	*/
+	class FB_DLL_NETWORK DownloadManager {
+		FB_DECLARE_PIMPL_NON_COPYABLE(DownloadManager);
+		DownloadManager(unsigned maxConcurrent);
+		~DownloadManager();
+
+	public:
+		/// \param maxConcurrent the number of transfers running at the same time.
+		/// The others wait in a queue.
+		static DownloadManagerPtr Create(unsigned maxConcurrent = 8);
+		static DownloadManager& GetInstance();
+		static bool HasInstance();
+
+		/// Thread safe.
+		DownloadId Download(const DownloadRequest& request);
+		DownloadId Download(const char* url, const char* filepath, DownloadCallback onFinished);
+		/// The callback is called with mSuccess = false and mError = "Canceled".
+		/// The .part file is kept so the download can be resumed.
+		void Cancel(DownloadId id);
+		void CancelAll();
+		bool IsDownloading(DownloadId id) const;
+		/// Running and queued transfers.
+		size_t GetNumDownloads() const;
+		/// Blocks until every transfer is finished. For tools.
+		void WaitAll();
+
+		struct Stats {
+			unsigned mNumSucceeded;
+			unsigned mNumFailed;
+			/// Transfers which opened a new connection. The others reused one.
+			unsigned mNumNewConnections;
+			UINT64 mBytesReceived;
+		};
+		Stats GetStats(bool reset);
+	};
+}
@@ -32,6 +32,7 @@
 #define FB_DLL_NETWORK __declspec(dllexport)
 #define FB_DLL_TIMER __declspec(dllimport)
 #define FB_DLL_FILESYSTEM __declspec(dllimport)
+#define FB_DLL_THREAD __declspec(dllimport)
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -45,7 +46,12 @@
 #include "FBFileSystem/FileSystem.h"
 
 #include <map>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 #include <atomic>
+#include <thread>
+#include <chrono>
 
 #pragma comment(lib, "libcurl.lib")
 #pragma comment(lib, "cppnetlib-uri.lib")
\ No newline at end of file
@@ -42,6 +42,7 @@
 #include "FBSceneObjectFactory/MeshObject.h"
 #include "FBSceneObjectFactory/SceneObjectFactory.h"
 #include "FBAudioPlayer/AudioManager.h"
+#include "FBMathLib/RandomGenerator.h"
 
 using namespace fb;
 class ParticleEmitter::Impl
@@ -109,6 +110,7 @@ public:
 	SoundData mSoundData;
 	AudioId mAudioId;
 	FunctionId mSoundCallback;
+	RandomGenerator mRandom;
 
 	//---------------------------------------------------------------------------
 	Impl(ParticleEmitter* self, IScenePtr scene)
@@ -1238,8 +1240,8 @@ public:
 			const ParticleTemplate* pt = it.first;
 			if (pt->mAlign == ParticleAlign::Direction)
 			{
-				float size = Random(pt->mSizeMinMax.x, pt->mSizeMinMax.y);
-				float ratio = Random(pt->mSizeRatioMinMax.x, pt->mSizeRatioMinMax.y);
+				float size = mRandom.Next(pt->mSizeMinMax.x, pt->mSizeMinMax.y);
+				float ratio = mRandom.Next(pt->mSizeRatioMinMax.x, pt->mSizeRatioMinMax.y);
 				PARTICLES::IteratorWrapper itParticle = particles->begin(), itEndParticle = particles->end();
 				for (; itParticle != itEndParticle; ++itParticle)
 				{
@@ -1433,6 +1435,10 @@ public:
 		mTeamColor = color;
 	}
 
+	void SetRandomGenerator(const RandomGenerator& generator){
+		mRandom = generator;
+	}
+
 
 	Particle* Emit(unsigned templateIdx){
 		assert(templateIdx < mTemplates.const_get()->size());
@@ -1462,7 +1468,7 @@ public:
 		break;
 		case ParticleRangeType::Box:
 		{
-			p.mPos = Random(Vec3(-pt.mRangeRadius), Vec3(pt.mRangeRadius))*scale;
+			p.mPos = mRandom.Next(Vec3(-pt.mRangeRadius), Vec3(pt.mRangeRadius))*scale;
 			if (!pt.IsLocalSpace())
 			{
 				p.mPos += mSelf->GetPosition();
@@ -1471,9 +1477,9 @@ public:
 		break;
 		case ParticleRangeType::Sphere:
 		{
-			float r = Random(pt.mRangeRadiusMin, pt.mRangeRadius)*scale;
-			float theta = Random(0.0f, PI);
-			float phi = Random(0.0f, TWO_PI);
+			float r = mRandom.Next(pt.mRangeRadiusMin, pt.mRangeRadius)*scale;
+			float theta = mRandom.Next(0.0f, PI);
+			float phi = mRandom.Next(0.0f, TWO_PI);
 			p.mPos = SphericalToCartesian(r, theta, phi);
 			if (!pt.IsLocalSpace())
 			{
@@ -1483,9 +1489,9 @@ public:
 		break;
 		case ParticleRangeType::Hemisphere:
 		{
-			float r = Random(0.0f, pt.mRangeRadius)*scale;
-			float theta = Random(0.0f, HALF_PI);
-			float phi = Random(0.0f, TWO_PI);
+			float r = mRandom.Next(0.0f, pt.mRangeRadius)*scale;
+			float theta = mRandom.Next(0.0f, HALF_PI);
+			float phi = mRandom.Next(0.0f, TWO_PI);
 			p.mPos = SphericalToCartesian(theta, phi) * r;
 			if (!pt.IsLocalSpace())
 			{
@@ -1495,10 +1501,10 @@ public:
 		break;
 		case ParticleRangeType::Cone:
 		{
-			float tanS = Random(0.0f, PI);
-			float cosT = Random(0.0f, TWO_PI);
-			float sinT = Random(0.0f, TWO_PI);
-			float height = Random(0.0f, pt.mRangeRadius)*scale;
+			float tanS = mRandom.Next(0.0f, PI);
+			float cosT = mRandom.Next(0.0f, TWO_PI);
+			float sinT = mRandom.Next(0.0f, TWO_PI);
+			float height = mRandom.Next(0.0f, pt.mRangeRadius)*scale;
 			p.mPos = Vec3(height*tanS*cosT, height*tanS*sinT, height);
 			if (!pt.IsLocalSpace())
 			{
@@ -1531,7 +1537,7 @@ public:
 		}
 		else
 		{
-			velDir = Random(pt.mVelocityDirMin, pt.mVelocityDirMax).NormalizeCopy();
+			velDir = mRandom.Next(pt.mVelocityDirMin, pt.mVelocityDirMax).NormalizeCopy();
 		}
 
 		if (angle > 0.01f && pt.mEmitTo == ParticleEmitTo::WorldSpace)
@@ -1543,7 +1549,7 @@ public:
 		}
 
 		p.mVelDir = velDir;
-		p.mVelocity = Random(pt.mVelocityMinMax.x, pt.mVelocityMinMax.y)*scale;
+		p.mVelocity = mRandom.Next(pt.mVelocityMinMax.x, pt.mVelocityMinMax.y)*scale;
 		if (pt.mAlign == ParticleAlign::Billboard)
 		{
 			p.mUDirection = Vec3::UNIT_X;
@@ -1561,7 +1567,7 @@ public:
 		p.mUVIndex = Vec2(0, 0);
 		p.mUVStep = Vec2(1.0f / pt.mUVAnimColRow.x, 1.0f / pt.mUVAnimColRow.y);
 		p.mUVFrame = 0.f;
-		p.mLifeTime = Random(pt.mLifeMinMax.x, pt.mLifeMinMax.y);
+		p.mLifeTime = mRandom.Next(pt.mLifeMinMax.x, pt.mLifeMinMax.y);
 		p.mUV_SPF = pt.mUV_INV_FPS;
 		if (pt.mUVAnimFramesPerSec == 0.f && (pt.mUVAnimColRow.x != 1 || pt.mUVAnimColRow.y != 1))
 		{
@@ -1571,20 +1577,20 @@ public:
 
 		}
 		p.mCurLifeTime = 0.0f;
-		float size = Random(pt.mSizeMinMax.x, pt.mSizeMinMax.y)*scale;
-		float ratio = Random(pt.mSizeRatioMinMax.x, pt.mSizeRatioMinMax.y);
+		float size = mRandom.Next(pt.mSizeMinMax.x, pt.mSizeMinMax.y)*scale;
+		float ratio = mRandom.Next(pt.mSizeRatioMinMax.x, pt.mSizeRatioMinMax.y);
 		p.mSize = Vec2(size * ratio, size);
 		if (mLength != 0 && pt.mAlign == ParticleAlign::Direction)
 		{
 			p.mSize.x = p.mSize.x * (mLength / size);
 		}
 
-		float scalevel = Random(pt.mScaleVelMinMax.x, pt.mScaleVelMinMax.y)*scale;
-		float svratio = Random(pt.mScaleVelRatio.x, pt.mScaleVelRatio.y);
+		float scalevel = mRandom.Next(pt.mScaleVelMinMax.x, pt.mScaleVelMinMax.y)*scale;
+		float svratio = mRandom.Next(pt.mScaleVelRatio.x, pt.mScaleVelRatio.y);
 		p.mScaleSpeed = Vec2(scalevel * svratio, scalevel);
-		p.mRot = Random(pt.mRotMinMax.x, pt.mRotMinMax.y);
-		p.mRotSpeed = Random(pt.mRotSpeedMinMax.x, pt.mRotSpeedMinMax.y);
-		p.mIntensity = Random(pt.mIntensityMinMax.x, pt.mIntensityMinMax.y);
+		p.mRot = mRandom.Next(pt.mRotMinMax.x, pt.mRotMinMax.y);
+		p.mRotSpeed = mRandom.Next(pt.mRotSpeedMinMax.x, pt.mRotSpeedMinMax.y);
+		p.mIntensity = mRandom.Next(pt.mIntensityMinMax.x, pt.mIntensityMinMax.y);
 		if (pt.mNeedTeamColor){
 			p.mColor = (pt.mColor * mEmitterColor * mTeamColor).Get4Byte();
 		}
@@ -1795,4 +1801,8 @@ IScenePtr ParticleEmitter::GetScene(){
 
 void ParticleEmitter::SetTeamColor(const Color& color){
 	mImpl->SetTeamColor(color);
+}
+
+void ParticleEmitter::SetRandomGenerator(const RandomGenerator& generator){
+	mImpl->SetRandomGenerator(generator);
 }
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include "FBSceneManager/SpatialObject.h"
 namespace fb
 {
+	class RandomGenerator;
 	FB_DECLARE_SMART_PTR(IScene);
 	FB_DECLARE_SMART_PTR(ParticleEmitter);
 	class FB_DLL_PARTICLESYSTEM ParticleEmitter : public SpatialObject
@@ -74,5 +75,8 @@ namespace fb
 		void SetScene(IScenePtr scene);
 		IScenePtr GetScene();
 		void SetTeamColor(const Color& color);
+		/// Particles are spawned with a copy of 'generator'. Every emitter
+		/// and every clone gets its own seed unless this is called.
+		void SetRandomGenerator(const RandomGenerator& generator);
 	};
 }
\ No newline at end of file
@@ -74,7 +74,7 @@ public:
 		, mScreenspace(0)
 	{
 		mMaterial = Renderer::GetInstance().CreateMaterial("EssentialEngineData/materials/particle.material");
-		mSelf->GetBoundingVolumeWorld()->SetAlwaysPass(true);
+		mSelf->SetAlwaysPassCulling(true);
 		mSelf->ModifyObjFlag(SceneObjectFlag::Transparent, true);
 	}
 
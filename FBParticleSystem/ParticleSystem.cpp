@@ -35,6 +35,7 @@
 #include "FBRenderer/Camera.h"
 #include "FBSceneManager/SceneManager.h"
 #include "FBSceneManager/Scene.h"
+#include "FBStringLib/StringId.h"
 using namespace fb;
 namespace fb{
 	void ClearParticleRenderObjects();
@@ -54,7 +55,8 @@ public:
 	// cache
 	typedef std::map<unsigned, ParticleEmitterPtr > PARTICLE_EMITTERS_BY_ID;
 	PARTICLE_EMITTERS_BY_ID mParticleEmitters;
-	typedef std::map<std::string, ParticleEmitterPtr > PARTICLE_EMITTERS_BY_NAME;
+	// case insensitive id of the file path
+	typedef std::unordered_map<StringId, ParticleEmitterPtr > PARTICLE_EMITTERS_BY_NAME;
 	PARTICLE_EMITTERS_BY_NAME mParticleEmittersByName;
 
 	ParticleEmitterPtr mEditingParticle;
@@ -191,7 +193,7 @@ public:
 			return 0;
 		}
 
-		auto fileKey = ToLowerCase(file);
+		auto fileKey = GetStringIdNoCase(file);
 		PARTICLE_EMITTERS_BY_NAME::iterator found = mParticleEmittersByName.find(fileKey);
 		if (found != mParticleEmittersByName.end())
 		{
@@ -205,7 +207,7 @@ public:
 		if (succ)
 		{
 			mParticleEmitters[p->GetEmitterID()] = p;
-			mParticleEmittersByName[fileKey] = p;
+			mParticleEmittersByName[InternStringNoCase(file)] = p;
 			auto cloned =  p->Clone();
 			cloned->SetScene(scene);
 			return cloned;
@@ -229,14 +231,11 @@ public:
 	void ReloadParticle(const char* file){
 		if (!ValidCString(file))
 			return;
-		auto fileKey = ToLowerCase(file);		
-		for (auto& p : mParticleEmittersByName)
+		auto found = mParticleEmittersByName.find(GetStringIdNoCase(file));
+		if (found != mParticleEmittersByName.end())
 		{
-			if (p.first == fileKey)
-			{
-				bool reload = true;
-				p.second->Load(file, reload);
-			}
+			bool reload = true;
+			found->second->Load(file, reload);
 		}
 	}
 
@@ -62,7 +62,21 @@ namespace fb
 
 		virtual ~IPhysics() {}
 
+		/// Steps the world. When the simulation thread is running, delivers
+		/// collision reports and applies interpolated transforms instead.
 		virtual void Update(float dt) = 0;
+		/** Runs the world on a dedicated thread at a fixed rate.
+		Forces, impulses and velocity changes applied to rigid bodies are queued
+		and applied at the beginning of the next step. Structural changes and
+		queries wait for the current step. IPhysicsInterface::SetPosRot() and
+		OnCollision() are called from Update() on the calling thread.
+		*/
+		virtual void StartSimulationThread(float fixedTimeStep) = 0;
+		virtual void StopSimulationThread() = 0;
+		virtual bool IsSimulationThreadRunning() const = 0;
+		/// Steps the world numSteps times by fixedTimeStep on the calling thread.
+		/// Produces the same result for the same input. Used for headless replay.
+		virtual void StepSimulationFixed(unsigned numSteps, float fixedTimeStep) = 0;
 		virtual void EnablePhysics() = 0;
 		virtual void DisablePhysics() = 0;
 
@@ -100,6 +114,23 @@ namespace fb
 			RigidBody* ret[], unsigned index[],
 			unsigned limit, RigidBody* except) = 0;
 
+		/** Answers many closest ray tests at once.
+		Queries are distributed to the task system and run against the broadphase
+		while the world is not stepping. Do not call from a task.
+		\param results should have numQueries elements. mRigidBody is 0 if not hit.
+		\return number of rays which hit something.
+		*/
+		virtual unsigned RayTestClosestBatch(const RayQuery queries[], unsigned numQueries,
+			RayResultClosest results[]) = 0;
+		/** Batch version of GetAABBOverlaps().
+		\param ret, index should have numQueries * limitPerQuery elements.
+		results of the query i start at i * limitPerQuery.
+		\param outCounts should have numQueries elements.
+		\return total number of overlaps.
+		*/
+		virtual unsigned GetAABBOverlapsBatch(const AABBQuery queries[], unsigned numQueries,
+			RigidBody* ret[], unsigned index[], unsigned limitPerQuery, unsigned outCounts[]) = 0;
+
 		virtual float GetDistanceBetween(RigidBodyPtr a, RigidBodyPtr b, Vec3* outNormalOnB,
 			Vec3* outDirToB) = 0;
 
@@ -38,7 +38,10 @@
 #include "BulletDebugDraw.h"
 #include "FBFileSystem/FileSystem.h"
 #include "FBCommonHeaders/Helpers.h"
+#include "FBThread/ParallelFor.h"
+#include "FBThread/threads.h"
 #include <BulletCollision/Gimpact/btGImpactShape.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
 #include <BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h>
 #include <BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h>
@@ -102,6 +105,87 @@ struct	AABBOverlapCallback : public btBroadphaseAabbCallback
 	}
 };
 
+struct MyclosestRayResultCallBack : public btCollisionWorld::ClosestRayResultCallback
+{
+	int mIndex;
+	void** mExcepts;
+	unsigned mNumExcepts;
+	MyclosestRayResultCallBack(const btVector3&	rayFromWorld, const btVector3&	rayToWorld)
+		:btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld)
+		, mIndex(-1), mExcepts(0), mNumExcepts(0)
+	{}
+
+	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+	{
+		btCollisionObject* colObj = (btCollisionObject*)proxy0->m_clientObject;
+		if (mExcepts && colObj)
+		{
+			auto rigidBody = (RigidBody*)colObj->getUserPointer();
+			if (rigidBody){
+				if (std::find(&mExcepts[0], &mExcepts[mNumExcepts], rigidBody->GetGamePtr()) != &mExcepts[mNumExcepts])
+					return false;
+			}
+		}
+		bool collides = (proxy0->m_collisionFilterGroup & m_collisionFilterMask) != 0;
+		collides = collides && (m_collisionFilterGroup & proxy0->m_collisionFilterMask);
+		return collides;
+	}
+
+	virtual	btScalar	addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
+	{
+		//caller already does the filter on the m_closestHitFraction
+		btAssert(rayResult.m_hitFraction <= m_closestHitFraction);
+
+		m_closestHitFraction = rayResult.m_hitFraction;
+		m_collisionObject = rayResult.m_collisionObject;
+		if (normalInWorldSpace)
+		{
+			m_hitNormalWorld = rayResult.m_hitNormalLocal;
+		}
+		else
+		{
+			///need to transform normal into worldspace
+			m_hitNormalWorld = m_collisionObject->getWorldTransform().getBasis()*rayResult.m_hitNormalLocal;
+		}
+		m_hitPointWorld.setInterpolate3(m_rayFromWorld, m_rayToWorld, rayResult.m_hitFraction);
+		auto colShape = m_collisionObject->getCollisionShape();
+		if (colShape->isCompound())
+		{
+			mIndex = rayResult.m_localShapeInfo->m_triangleIndex;
+		}
+		return rayResult.m_hitFraction;
+	}
+
+};
+
+// btDbvtBroadphase::rayTest() shares one traversal stack for all callers.
+// Batch queries walk the dbvt trees directly with their own stack instead.
+struct BatchRayTester : public btDbvt::ICollide
+{
+	btCollisionWorld::RayResultCallback& mResultCallback;
+	btTransform mRayFromTrans;
+	btTransform mRayToTrans;
+
+	BatchRayTester(const btVector3& from, const btVector3& to, btCollisionWorld::RayResultCallback& cb)
+		: mResultCallback(cb)
+	{
+		mRayFromTrans.setIdentity();
+		mRayFromTrans.setOrigin(from);
+		mRayToTrans.setIdentity();
+		mRayToTrans.setOrigin(to);
+	}
+
+	void Process(const btDbvtNode* leaf)
+	{
+		btBroadphaseProxy* proxy = (btBroadphaseProxy*)leaf->data;
+		if (!mResultCallback.needsCollision(proxy))
+			return;
+		btCollisionObject* colObj = (btCollisionObject*)proxy->m_clientObject;
+		btCollisionWorld::rayTestSingle(mRayFromTrans, mRayToTrans, colObj, 
+			colObj->getCollisionShape(), colObj->getWorldTransform(), mResultCallback);
+	}
+};
+
 void TickCallback(btDynamicsWorld *world, btScalar timeStep);
 bool ConvexResultNeedCollision(btCollisionObject* a, btCollisionObject* b){
 	if (Physics::sNeedCollisionForConvexCallback){
@@ -118,6 +202,21 @@ bool ConvexResultNeedCollision(btCollisionObject* a, btCollisionObject* b){
 
 std::thread::id main_thread_id;
 
+class PhysicsThread : public Thread {
+	Physics* mPhysics;
+
+public:
+	PhysicsThread(Physics* physics)
+		: mPhysics(physics)
+	{
+	}
+
+	// Returns 'repeat?' flag.
+	bool Run() {
+		return mPhysics->_SimulationThreadFunc();
+	}
+};
+
 std::thread::id Physics::get_main_thread_id() {
 	return main_thread_id;
 }
@@ -153,12 +252,42 @@ public:
 	bool mEnabled;
 	std::string mPhysicsId;
 
+	// Simulation thread
+	std::unique_ptr<PhysicsThread> mSimulationThread;
+	std::atomic<bool> mSimulationThreadRunning;
+	float mFixedTimeStep;
+	// Locked by the simulation thread while stepping.
+	RecursiveCriticalSection mWorldLock;
+	// written by the stepping thread only.
+	unsigned mSimulatingStep;
+	std::atomic<unsigned> mLastCompletedStep;
+	std::atomic<INT64> mLastStepTick; // microseconds
+
+	struct Command {
+		RigidBody* target;
+		std::function<void()> func;
+	};
+	CriticalSection mCommandsLock;
+	std::vector<Command> mCommands;
+	// Collision reports gathered on the simulation thread.
+	// delivered in Update() on the game thread.
+	std::vector<std::pair<RigidBody*, RigidBody*>> mPendingCloseObjects;
+	std::vector<IPhysicsInterface::CollisionContactInfo> mPendingContacts;
+	bool mDeferCollisionReports;
+	std::vector<fbMotionState*> mMotionStates;
+
 	//-------------------------------------------------------------------
 	Impl(Physics* self)
 		: mSelf(self)
 		, mRayGroup(0x40) // default of the current game under development
 		, mFilterCallback(0)
 		, mEnabled(true)
+		, mSimulationThreadRunning(false)
+		, mFixedTimeStep(1.f / 60.f)
+		, mSimulatingStep(0)
+		, mLastCompletedStep(0)
+		, mLastStepTick(0)
+		, mDeferCollisionReports(false)
 	{
 		main_thread_id = std::this_thread::get_id();
 		Initilaize();
@@ -167,6 +296,7 @@ public:
 		Logger::Init(filepath);
 	}
 	~Impl(){
+		StopSimulationThread();
 		Deinitialize();
 		Logger::Release();
 	}
@@ -266,6 +396,10 @@ public:
 	}
 
 	void Update(float dt){
+		if (mSimulationThreadRunning) {
+			UpdateFromSimulationThread();
+			return;
+		}
 		if (mEnabled && mDynamicsWorld)
 		{
 			mDynamicsWorld->stepSimulation(dt, 12);
@@ -276,6 +410,212 @@ public:
 		}
 	}
 
+	//-------------------------------------------------------------------
+	// Simulation thread
+	//-------------------------------------------------------------------
+	static INT64 GetTickMicro() {
+		using namespace std::chrono;
+		return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	void StartSimulationThread(float fixedTimeStep) {
+		if (mSimulationThreadRunning) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Simulation thread is already running.");
+			return;
+		}
+		if (fixedTimeStep <= 0.f) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return;
+		}
+		mFixedTimeStep = fixedTimeStep;
+		for (auto motionState : mMotionStates) {
+			motionState->SetBuffered(&mSimulatingStep);
+		}
+		mLastStepTick = GetTickMicro();
+		mSimulationThreadRunning = true;
+		mSimulationThread.reset(new PhysicsThread(mSelf));
+		mSimulationThread->CreateThread(1024, "PhysicsThread");
+	}
+
+	void StopSimulationThread() {
+		if (!mSimulationThread)
+			return;
+		mSimulationThreadRunning = false;
+		mSimulationThread->Join();
+		mSimulationThread.reset();
+
+		ApplyCommands();
+		DeliverCollisionReports();
+		auto lastStep = mLastCompletedStep.load();
+		for (auto motionState : mMotionStates) {
+			motionState->ApplyBufferedTransform(lastStep, 1.f);
+			motionState->SetBuffered(0);
+		}
+	}
+
+	bool IsSimulationThreadRunning() const {
+		return mSimulationThreadRunning;
+	}
+
+	bool SimulationThreadFunc() {
+		if (!mSimulationThreadRunning)
+			return false;
+		auto stepMicro = (INT64)(mFixedTimeStep * std::micro::den);
+		auto now = GetTickMicro();
+		auto next = mLastStepTick + stepMicro;
+		if (now < next) {
+			std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+			return mSimulationThreadRunning;
+		}
+		if (mEnabled) {
+			StepFixed(true);
+		}
+		// Don't try to catch up more than a few steps after a hitch.
+		mLastStepTick = now - next > stepMicro * 4 ? now : next;
+		return mSimulationThreadRunning;
+	}
+
+	/// Applies queued commands and steps the world by mFixedTimeStep.
+	/// \param deferCollisionReports true when called from the simulation thread.
+	void StepFixed(bool deferCollisionReports) {
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
+		ApplyCommands();
+		++mSimulatingStep;
+		mDeferCollisionReports = deferCollisionReports;
+		mDynamicsWorld->stepSimulation(mFixedTimeStep, 1, mFixedTimeStep);
+		mDeferCollisionReports = false;
+		mLastCompletedStep = mSimulatingStep;
+	}
+
+	void StepSimulationFixed(unsigned numSteps, float fixedTimeStep) {
+		if (mSimulationThreadRunning) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Simulation thread is running.");
+			return;
+		}
+		if (fixedTimeStep <= 0.f) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return;
+		}
+		mFixedTimeStep = fixedTimeStep;
+		for (unsigned i = 0; i < numSteps; ++i) {
+			StepFixed(false);
+		}
+	}
+
+	bool EnqueueCommand(RigidBody* target, std::function<void()>&& func) {
+		if (!mSimulationThreadRunning)
+			return false;
+		ENTER_CRITICAL_SECTION lock(mCommandsLock);
+		mCommands.push_back(Command{ target, std::move(func) });
+		return true;
+	}
+
+	void ApplyCommands() {
+		std::vector<Command> commands;
+		{
+			ENTER_CRITICAL_SECTION lock(mCommandsLock);
+			commands.swap(mCommands);
+		}
+		for (auto& command : commands) {
+			command.func();
+		}
+	}
+
+	void UpdateFromSimulationThread() {
+		{
+			ENTER_CRITICAL_SECTION_R lock(mWorldLock);
+			DeliverCollisionReports();
+			if (mDebugDrawer.getDebugMode() != 0)
+			{
+				mDynamicsWorld->debugDrawWorld();
+			}
+		}
+		auto lastStep = mLastCompletedStep.load();
+		auto alpha = (GetTickMicro() - mLastStepTick) / (mFixedTimeStep * std::micro::den);
+		alpha = std::min(1.f, std::max(0.f, alpha));
+		for (auto motionState : mMotionStates) {
+			motionState->ApplyBufferedTransform(lastStep, alpha);
+		}
+	}
+
+	void ReportCloseObjects(RigidBody* a, RigidBody* b) {
+		if (mDeferCollisionReports) {
+			mPendingCloseObjects.push_back(std::make_pair(a, b));
+			return;
+		}
+		auto ia = ((RigidBodyImpl*)a)->GetPhysicsInterface();
+		auto ib = ((RigidBodyImpl*)b)->GetPhysicsInterface();
+		if (ia && ib) {
+			ia->AddCloseObjects(b);
+			ib->AddCloseObjects(a);
+		}
+	}
+
+	void ReportCollision(IPhysicsInterface::CollisionContactInfo& contactInfo) {
+		if (mDeferCollisionReports) {
+			mPendingContacts.push_back(contactInfo);
+			return;
+		}
+		auto a = ((RigidBodyImpl*)contactInfo.mA)->GetPhysicsInterface();
+		auto b = ((RigidBodyImpl*)contactInfo.mB)->GetPhysicsInterface();
+		if (!a || !b)
+			return;
+		bool processed = a->OnCollision(contactInfo);
+		if (!processed)
+		{
+			contactInfo.SwapAB();
+			b->OnCollision(contactInfo);
+		}
+	}
+
+	// mWorldLock should be locked.
+	void DeliverCollisionReports() {
+		// Rigid bodies can be deleted by the handlers.
+		// OnRigidBodyDeleted() removes them from the pending lists, so consume
+		// the lists in place.
+		std::reverse(mPendingCloseObjects.begin(), mPendingCloseObjects.end());
+		while (!mPendingCloseObjects.empty()) {
+			auto pair = mPendingCloseObjects.back();
+			mPendingCloseObjects.pop_back();
+			ReportCloseObjects(pair.first, pair.second);
+		}
+		std::reverse(mPendingContacts.begin(), mPendingContacts.end());
+		while (!mPendingContacts.empty()) {
+			auto contactInfo = mPendingContacts.back();
+			mPendingContacts.pop_back();
+			ReportCollision(contactInfo);
+		}
+	}
+
+	void RegisterMotionState(fbMotionState* motionState) {
+		if (mSimulationThreadRunning)
+			motionState->SetBuffered(&mSimulatingStep);
+		mMotionStates.push_back(motionState);
+	}
+
+	void OnRigidBodyDeleted(RigidBody* rigidBody, btMotionState* motionState) {
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
+		{
+			ENTER_CRITICAL_SECTION lockCommands(mCommandsLock);
+			mCommands.erase(std::remove_if(mCommands.begin(), mCommands.end(), [rigidBody](const Command& c) {
+				return c.target == rigidBody;
+			}), mCommands.end());
+		}
+		mPendingCloseObjects.erase(std::remove_if(mPendingCloseObjects.begin(), mPendingCloseObjects.end(), 
+			[rigidBody](const std::pair<RigidBody*, RigidBody*>& pair) {
+			return pair.first == rigidBody || pair.second == rigidBody;
+		}), mPendingCloseObjects.end());
+		mPendingContacts.erase(std::remove_if(mPendingContacts.begin(), mPendingContacts.end(),
+			[rigidBody](const IPhysicsInterface::CollisionContactInfo& info) {
+			return info.mA == rigidBody || info.mB == rigidBody;
+		}), mPendingContacts.end());
+		if (motionState) {
+			auto it = std::find(mMotionStates.begin(), mMotionStates.end(), motionState);
+			if (it != mMotionStates.end())
+				mMotionStates.erase(it);
+		}
+	}
+
 	void EnablePhysics(){
 		mEnabled = true;
 	}
@@ -457,8 +797,10 @@ public:
 		if (dynamic)
 		{
 			colShape->calculateLocalInertia(mass, localInertia);
-			if (obj && createMotionSTate)
-				motionState = FB_NEW_ALIGNED(fbMotionState, MemAlign)(obj);			
+			if (obj && createMotionSTate) {
+				motionState = FB_NEW_ALIGNED(fbMotionState, MemAlign)(obj);
+				RegisterMotionState(motionState);
+			}
 		}
 		
 		btRigidBody::btRigidBodyConstructionInfo rbInfo(
@@ -643,6 +985,7 @@ public:
 	void AddRef(btCollisionShape* colShape){
 		if (!colShape)
 			return;
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 		auto it = mColShapesRefs.find(colShape);
 		if (it == mColShapesRefs.end())
 		{
@@ -656,6 +999,7 @@ public:
 	void Release(btCollisionShape* colShape){
 		if (!colShape)
 			return;
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 
 		auto it = mColShapesRefs.find(colShape);
 		if (it == mColShapesRefs.end())
@@ -761,60 +1105,9 @@ public:
 	}
 
 	bool RayTestClosest(const Vec3& fromWorld, const Vec3& toWorld, int additionalRayGroup, int mask, RayResultClosest& result, void* excepts[] = 0, unsigned numExcepts = 0){
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 		auto from = FBToBullet(fromWorld);
 		auto to = FBToBullet(toWorld);
-		struct MyclosestRayResultCallBack : public btCollisionWorld::ClosestRayResultCallback
-		{
-			int mIndex;
-			void** mExcepts;
-			unsigned mNumExcepts;
-			MyclosestRayResultCallBack(const btVector3&	rayFromWorld, const btVector3&	rayToWorld)
-				:btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld)
-				, mIndex(-1), mExcepts(0), mNumExcepts(0)
-			{}
-
-			virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-			{
-				btCollisionObject* colObj = (btCollisionObject*)proxy0->m_clientObject;
-				if (mExcepts && colObj)
-				{
-					auto rigidBody = (RigidBody*)colObj->getUserPointer();
-					if (rigidBody){
-						if (std::find(&mExcepts[0], &mExcepts[mNumExcepts], rigidBody->GetGamePtr()) != &mExcepts[mNumExcepts])
-							return false;
-					}
-				}
-				bool collides = (proxy0->m_collisionFilterGroup & m_collisionFilterMask) != 0;
-				collides = collides && (m_collisionFilterGroup & proxy0->m_collisionFilterMask);
-				return collides;
-			}
-
-			virtual	btScalar	addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
-			{
-				//caller already does the filter on the m_closestHitFraction
-				btAssert(rayResult.m_hitFraction <= m_closestHitFraction);
-
-				m_closestHitFraction = rayResult.m_hitFraction;
-				m_collisionObject = rayResult.m_collisionObject;
-				if (normalInWorldSpace)
-				{
-					m_hitNormalWorld = rayResult.m_hitNormalLocal;
-				}
-				else
-				{
-					///need to transform normal into worldspace
-					m_hitNormalWorld = m_collisionObject->getWorldTransform().getBasis()*rayResult.m_hitNormalLocal;
-				}
-				m_hitPointWorld.setInterpolate3(m_rayFromWorld, m_rayToWorld, rayResult.m_hitFraction);
-				auto colShape = m_collisionObject->getCollisionShape();
-				if (colShape->isCompound())
-				{
-					mIndex = rayResult.m_localShapeInfo->m_triangleIndex;
-				}
-				return rayResult.m_hitFraction;
-			}
-
-		};
 		MyclosestRayResultCallBack cb(from, to);
 		cb.m_collisionFilterGroup = mRayGroup + additionalRayGroup;
 		cb.m_collisionFilterMask = mask;
@@ -886,6 +1179,7 @@ public:
 		if (!result.mTargetBody)
 			return false;
 
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 		auto from = FBToBullet(fromWorld);
 		auto to = FBToBullet(toWorld);
 
@@ -910,6 +1204,7 @@ public:
 	}
 
 	RayResultAll* RayTestAll(const Vec3& fromWorld, const Vec3& toWorld, int additionalGroupFlag, int mask){
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 		auto from = FBToBullet(fromWorld);
 		auto to = FBToBullet(toWorld);
 
@@ -980,6 +1275,7 @@ public:
 		RigidBody* ret[], unsigned index[],
 		unsigned limit, RigidBody* except)
 	{
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
 		btVector3 min = FBToBullet(aabb.GetMin());
 		btVector3 max = FBToBullet(aabb.GetMax());
 		AABBResultType result;
@@ -994,6 +1290,113 @@ public:
 		return result.size();
 	}
 
+	//-------------------------------------------------------------------
+	// Batch queries
+	//-------------------------------------------------------------------
+	static const unsigned BatchQueryChunkSize = 128;
+
+	void RayTestClosestRange(const RayQuery queries[], unsigned start, unsigned end,
+		RayResultClosest results[], btAlignedObjectArray<const btDbvtNode*>& stack,
+		unsigned& numHits)
+	{
+		auto dbvtBroadphase = (btDbvtBroadphase*)mBroadphase;
+		for (unsigned i = start; i < end; ++i) {
+			auto& query = queries[i];
+			auto& result = results[i];
+			result.mRigidBody = 0;
+			auto from = FBToBullet(query.mFromWorld);
+			auto to = FBToBullet(query.mToWorld);
+			if (from == to)
+				continue;
+			MyclosestRayResultCallBack cb(from, to);
+			cb.m_collisionFilterGroup = mRayGroup + query.mAdditionalGroupFlag;
+			cb.m_collisionFilterMask = query.mMask;
+
+			// same as btSingleRayCallback
+			btVector3 rayDir = (to - from);
+			rayDir.normalize();
+			btVector3 rayDirectionInverse;
+			rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+			rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+			rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+			unsigned int signs[3];
+			signs[0] = rayDirectionInverse[0] < 0.0;
+			signs[1] = rayDirectionInverse[1] < 0.0;
+			signs[2] = rayDirectionInverse[2] < 0.0;
+			btScalar lambdaMax = rayDir.dot(to - from);
+			const btVector3 zero(0, 0, 0);
+
+			BatchRayTester tester(from, to, cb);
+			for (int set = 0; set < 2; ++set) {
+				auto& tree = dbvtBroadphase->m_sets[set];
+				tree.rayTestInternal(tree.m_root, from, to, rayDirectionInverse, signs, lambdaMax,
+					zero, zero, stack, tester);
+			}
+			if (cb.hasHit()) {
+				result.mRigidBody = (RigidBody*)(cb.m_collisionObject->getUserPointer());
+				result.mHitPointWorld = BulletToFB(cb.m_hitPointWorld);
+				result.mHitNormalWorld = BulletToFB(cb.m_hitNormalWorld);
+				result.mIndex = cb.mIndex;
+				++numHits;
+			}
+		}
+	}
+
+	unsigned RayTestClosestBatch(const RayQuery queries[], unsigned numQueries,
+		RayResultClosest results[])
+	{
+		if (!queries || !results) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return 0;
+		}
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
+		std::atomic<unsigned> numHits(0);
+		RangeFunc func = [&](unsigned start, unsigned end) {
+			btAlignedObjectArray<const btDbvtNode*> stack;
+			stack.resize(btDbvt::DOUBLE_STACKSIZE);
+			unsigned hits = 0;
+			RayTestClosestRange(queries, start, end, results, stack, hits);
+			numHits += hits;
+		};
+		RunParallel(numQueries, BatchQueryChunkSize, func);
+		return numHits;
+	}
+
+	unsigned GetAABBOverlapsBatch(const AABBQuery queries[], unsigned numQueries,
+		RigidBody* ret[], unsigned index[], unsigned limitPerQuery, unsigned outCounts[])
+	{
+		if (!queries || !ret || !index || !outCounts) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return 0;
+		}
+		ENTER_CRITICAL_SECTION_R lock(mWorldLock);
+		std::atomic<unsigned> numTotal(0);
+		RangeFunc func = [&](unsigned start, unsigned end) {
+			AABBResultType result;
+			result.reserve(limitPerQuery);
+			unsigned total = 0;
+			for (unsigned i = start; i < end; ++i) {
+				auto& query = queries[i];
+				result.clear();
+				btVector3 min = FBToBullet(query.mAABB.GetMin());
+				btVector3 max = FBToBullet(query.mAABB.GetMax());
+				AABBOverlapCallback callback(min, max, query.mColMask, result, limitPerQuery, query.mExcept);
+				// btDbvtBroadphase::aabbTest() uses a local stack. safe to call concurrently.
+				mBroadphase->aabbTest(min, max, callback);
+				auto offset = i * limitPerQuery;
+				for (size_t r = 0; r < result.size(); ++r) {
+					ret[offset + r] = result[r].first;
+					index[offset + r] = result[r].second;
+				}
+				outCounts[i] = result.size();
+				total += result.size();
+			}
+			numTotal += total;
+		};
+		RunParallel(numQueries, BatchQueryChunkSize, func);
+		return numTotal;
+	}
+
 	float GetDistanceBetween(RigidBodyPtr a, RigidBodyPtr b, Vec3* outNormalOnB,
 		Vec3* outDirToB){
 		if (!a || !b)
@@ -1200,8 +1603,7 @@ public:
 			IPhysicsInterface* b = (IPhysicsInterface*)obB->GetPhysicsInterface();
 			if (a && b)
 			{
-				a->AddCloseObjects((RigidBody*)obB);
-				b->AddCloseObjects((RigidBody*)obA);
+				ReportCloseObjects((RigidBody*)obA, (RigidBody*)obB);
 			}
 			else
 			{
@@ -1232,12 +1634,7 @@ public:
 						pt.m_index0, 
 						pt.m_index1);
 
-					bool processed = a->OnCollision(contactInfo);
-					if (!processed)
-					{
-						contactInfo.SwapAB();						
-						b->OnCollision(contactInfo);
-					}
+					ReportCollision(contactInfo);
 					break;
 				}
 			}
@@ -1316,6 +1713,22 @@ void Physics::Update(float dt) {
 	mImpl->Update(dt);
 }
 
+void Physics::StartSimulationThread(float fixedTimeStep) {
+	mImpl->StartSimulationThread(fixedTimeStep);
+}
+
+void Physics::StopSimulationThread() {
+	mImpl->StopSimulationThread();
+}
+
+bool Physics::IsSimulationThreadRunning() const {
+	return mImpl->IsSimulationThreadRunning();
+}
+
+void Physics::StepSimulationFixed(unsigned numSteps, float fixedTimeStep) {
+	mImpl->StepSimulationFixed(numSteps, fixedTimeStep);
+}
+
 void Physics::EnablePhysics() {
 	mImpl->EnablePhysics();
 }
@@ -1421,6 +1834,16 @@ unsigned Physics::GetAABBOverlaps(const AABB& aabb, unsigned colMask,
 	return mImpl->GetAABBOverlaps(aabb, colMask, ret, index, limit, except);
 }
 
+unsigned Physics::RayTestClosestBatch(const RayQuery queries[], unsigned numQueries,
+	RayResultClosest results[]) {
+	return mImpl->RayTestClosestBatch(queries, numQueries, results);
+}
+
+unsigned Physics::GetAABBOverlapsBatch(const AABBQuery queries[], unsigned numQueries,
+	RigidBody* ret[], unsigned index[], unsigned limitPerQuery, unsigned outCounts[]) {
+	return mImpl->GetAABBOverlapsBatch(queries, numQueries, ret, index, limitPerQuery, outCounts);
+}
+
 float Physics::GetDistanceBetween(RigidBodyPtr a, RigidBodyPtr b, Vec3* outNormalOnB,
 	Vec3* outDirToB) {
 	return mImpl->GetDistanceBetween(a, b, outNormalOnB, outDirToB);
@@ -1482,6 +1905,22 @@ void Physics::_CheckCollisionShapeForDel(float timeStep) {
 	mImpl->_CheckCollisionShapeForDel(timeStep);
 }
 
+bool Physics::_SimulationThreadFunc() {
+	return mImpl->SimulationThreadFunc();
+}
+
+bool Physics::_EnqueueCommand(RigidBody* target, std::function<void()>&& func) {
+	return mImpl->EnqueueCommand(target, std::move(func));
+}
+
+RecursiveCriticalSection& Physics::_GetWorldLock() {
+	return mImpl->mWorldLock;
+}
+
+void Physics::_OnRigidBodyDeleted(RigidBody* rigidBody, btMotionState* motionState) {
+	mImpl->OnRigidBodyDeleted(rigidBody, motionState);
+}
+
 btDynamicsWorld* Physics::_GetDynamicWorld() const {
 	return mImpl->_GetDynamicWorld();
 }
@@ -28,9 +28,12 @@
 #pragma once
 #include "IPhysics.h"
 #include "FBCommonHeaders/Types.h"
+#include <functional>
 class btDynamicsWorld;
+class btMotionState;
 namespace fb
 {
+	struct RecursiveCriticalSection;
 	struct FBFilterCallback;
 	class BulletDebugDraw;
 	struct BulletFilterCallback;
@@ -48,7 +51,11 @@ namespace fb
 
 		void Initilaize();
 		void Deinitilaize();
-		void Update(float dt);
+		void Update(float dt) OVERRIDE;
+		void StartSimulationThread(float fixedTimeStep) OVERRIDE;
+		void StopSimulationThread() OVERRIDE;
+		bool IsSimulationThreadRunning() const OVERRIDE;
+		void StepSimulationFixed(unsigned numSteps, float fixedTimeStep) OVERRIDE;
 		void EnablePhysics();
 		void DisablePhysics();
 		void SetPhysicsId(const char* id) OVERRIDE;
@@ -85,6 +92,10 @@ namespace fb
 		unsigned GetAABBOverlaps(const AABB& aabb, unsigned colMask, 
 			RigidBody* ret[], unsigned index[],
 			unsigned limit, RigidBody* except);
+		unsigned RayTestClosestBatch(const RayQuery queries[], unsigned numQueries,
+			RayResultClosest results[]) OVERRIDE;
+		unsigned GetAABBOverlapsBatch(const AABBQuery queries[], unsigned numQueries,
+			RigidBody* ret[], unsigned index[], unsigned limitPerQuery, unsigned outCounts[]) OVERRIDE;
 		float GetDistanceBetween(RigidBodyPtr a, RigidBodyPtr b, Vec3* outNormalOnB, 
 			Vec3* outDirToB) OVERRIDE;
 
@@ -113,6 +124,13 @@ namespace fb
 		void _ReportCollisions();
 		void _CheckCollisionShapeForDel(float timeStep);
 		btDynamicsWorld* _GetDynamicWorld() const;
+		bool _SimulationThreadFunc();
+		/// Returns false if the simulation thread is not running. 
+		/// In that case, the caller should execute the function immediately.
+		bool _EnqueueCommand(RigidBody* target, std::function<void()>&& func);
+		/// Held by the simulation thread while stepping.
+		RecursiveCriticalSection& _GetWorldLock();
+		void _OnRigidBodyDeleted(RigidBody* rigidBody, btMotionState* motionState);
 
 		static std::thread::id get_main_thread_id();
 		static bool is_main_thread();
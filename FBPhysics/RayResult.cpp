@@ -71,4 +71,27 @@ void RayResultAll::AddResult(RigidBody* rigidBody, const Vec3& hitPoint, const V
 	mRayResults[mCurSize++] = (RayResultClosest*)malloc(sizeof(RayResultClosest));
 
 	new (mRayResults[mCurSize - 1]) RayResultClosest(rigidBody, hitPoint, hitNormal, index);
-}
\ No newline at end of file
+}
+RayQuery::RayQuery()
+	: mFromWorld(0, 0, 0), mToWorld(0, 0, 0), mAdditionalGroupFlag(0), mMask(-1)
+{
+
+}
+
+RayQuery::RayQuery(const Vec3& fromWorld, const Vec3& toWorld, int additionalGroupFlag, int mask)
+	: mFromWorld(fromWorld), mToWorld(toWorld), mAdditionalGroupFlag(additionalGroupFlag), mMask(mask)
+{
+
+}
+
+AABBQuery::AABBQuery()
+	: mColMask(-1), mExcept(0)
+{
+
+}
+
+AABBQuery::AABBQuery(const AABB& aabb, unsigned colMask, RigidBody* except)
+	: mAABB(aabb), mColMask(colMask), mExcept(except)
+{
+
+}
@@ -27,6 +27,7 @@
 
 #pragma once
 #include "FBMathLib/Vec3.h"
+#include "FBMathLib/AABB.h"
 namespace fb
 {
 	class RigidBody;
@@ -62,4 +63,27 @@ namespace fb
 		RayResultClosest* mRayResults[SIZE];
 		unsigned mCurSize;
 	};
+
+	/// An element of IPhysics::RayTestClosestBatch()
+	struct FB_DLL_PHYSICS RayQuery
+	{
+		RayQuery();
+		RayQuery(const Vec3& fromWorld, const Vec3& toWorld, int additionalGroupFlag, int mask);
+
+		Vec3 mFromWorld;
+		Vec3 mToWorld;
+		int mAdditionalGroupFlag;
+		int mMask;
+	};
+
+	/// An element of IPhysics::GetAABBOverlapsBatch()
+	struct FB_DLL_PHYSICS AABBQuery
+	{
+		AABBQuery();
+		AABBQuery(const AABB& aabb, unsigned colMask, RigidBody* except);
+
+		AABB mAABB;
+		unsigned mColMask;
+		RigidBody* mExcept;
+	};
 }
\ No newline at end of file
@@ -31,8 +31,21 @@
 #include "IPhysicsInterface.h"
 #include "RotationInfo.h"
 #include "IPhysics.h"
+#include "FBThread/AsyncObjects.h"
 using namespace fb;
 
+// Structural changes and reads of the bullet state wait for the current step
+// of the simulation thread.
+#define LOCK_WORLD ENTER_CRITICAL_SECTION_R lockWorld(mImpl->mPhysics->_GetWorldLock())
+// State changes are applied at the beginning of the next step when the
+// simulation thread is running.
+#define QUEUE_TO_SIMULATION_THREAD(call) \
+	{ \
+		auto impl = mImpl.get(); \
+		if (mImpl->mPhysics->_EnqueueCommand(this, [=]() { impl->call; })) \
+			return; \
+	}
+
 class RigidBodyImpl::Impl{
 public:
 	RigidBodyImpl* mSelf;
@@ -72,6 +85,8 @@ public:
 		mSelf->setUserPointer(self);		
 	}
 	~Impl(){
+		ENTER_CRITICAL_SECTION_R lockWorld(mPhysics->_GetWorldLock());
+		mPhysics->_OnRigidBodyDeleted(mSelf, mSelf->getMotionState());
 		UnregisterFromWorld();
 		mSelf->setUserPointer(0);
 		mGamePtr = 0;
@@ -679,82 +694,102 @@ btScalar RigidBodyImpl::addSingleResult(btManifoldPoint& cp, const btCollisionOb
 }
 
 void RigidBodyImpl::RefreshColShape(IPhysicsInterface* colProvider) {
+	LOCK_WORLD;
 	mImpl->RefreshColShape(colProvider);
 }
 
 void RigidBodyImpl::ApplyForce(const Vec3& force, const Vec3& rel_pos) {
+	QUEUE_TO_SIMULATION_THREAD(ApplyForce(force, rel_pos));
 	mImpl->ApplyForce(force, rel_pos);
 }
 
 void RigidBodyImpl::ApplyImpulse(const Vec3& impulse, const Vec3& rel_pos) {
+	QUEUE_TO_SIMULATION_THREAD(ApplyImpulse(impulse, rel_pos));
 	mImpl->ApplyImpulse(impulse, rel_pos);
 }
 
 void RigidBodyImpl::ApplyCentralImpulse(const Vec3& impulse) {
+	QUEUE_TO_SIMULATION_THREAD(ApplyCentralImpulse(impulse));
 	mImpl->ApplyCentralImpulse(impulse);
 }
 
 void RigidBodyImpl::ApplyTorqueImpulse(const Vec3& torque) {
+	QUEUE_TO_SIMULATION_THREAD(ApplyTorqueImpulse(torque));
 	mImpl->ApplyTorqueImpulse(torque);
 }
 
 void RigidBodyImpl::ApplyTorque(const Vec3& torque) {
+	QUEUE_TO_SIMULATION_THREAD(ApplyTorque(torque));
 	mImpl->ApplyTorque(torque);
 }
 
 Vec3 RigidBodyImpl::GetForce() const {
+	LOCK_WORLD;
 	return mImpl->GetForce();
 }
 
 Vec3 RigidBodyImpl::GetLinearFactor() const {
+	LOCK_WORLD;
 	return mImpl->GetLinearFactor();
 }
 
 void RigidBodyImpl::ClearForces() {
+	QUEUE_TO_SIMULATION_THREAD(ClearForces());
 	mImpl->ClearForces();
 }
 
 void RigidBodyImpl::Stop() {
+	QUEUE_TO_SIMULATION_THREAD(Stop());
 	mImpl->Stop();
 }
 
 float RigidBodyImpl::GetSpeed() const {
+	LOCK_WORLD;
 	return mImpl->GetSpeed();
 }
 
 Vec3 RigidBodyImpl::GetVelocity() const {
+	LOCK_WORLD;
 	return mImpl->GetVelocity();
 }
 
 Vec3 RigidBodyImpl::GetAngularVelocity() const {
+	LOCK_WORLD;
 	return mImpl->GetAngularVelocity();
 }
 
 void RigidBodyImpl::SetAngularVelocity(const Vec3& angVel) {
+	QUEUE_TO_SIMULATION_THREAD(SetAngularVelocity(angVel));
 	mImpl->SetAngularVelocity(angVel);
 }
 
 Vec3 RigidBodyImpl::GetTorque() const {
+	LOCK_WORLD;
 	return mImpl->GetTorque();
 }
 
 void RigidBodyImpl::SetVelocity(const Vec3& vel) {
+	QUEUE_TO_SIMULATION_THREAD(SetVelocity(vel));
 	mImpl->SetVelocity(vel);
 }
 
 void RigidBodyImpl::Activate() {
+	QUEUE_TO_SIMULATION_THREAD(Activate());
 	mImpl->Activate();
 }
 
 void RigidBodyImpl::EnableDeactivation(bool enable) {
+	LOCK_WORLD;
 	mImpl->EnableDeactivation(enable);
 }
 
 Vec3 RigidBodyImpl::GetDestDir() const {
+	LOCK_WORLD;
 	return mImpl->GetDestDir();
 }
 
 void RigidBodyImpl::SetMass(float mass) {
+	LOCK_WORLD;
 	mImpl->SetMass(mass);
 }
 
@@ -779,6 +814,7 @@ void* RigidBodyImpl::GetColShapeUserPtr(int idx) {
 }
 
 fb::Transformation RigidBodyImpl::GetChildShapeTransform(int idx) {
+	LOCK_WORLD;
 	return mImpl->GetChildShapeTransform(idx);
 }
 
@@ -787,22 +823,27 @@ void* RigidBodyImpl::GetGamePtr() const {
 }
 
 void RigidBodyImpl::SetRotationalForce(float force) {
+	QUEUE_TO_SIMULATION_THREAD(SetRotationalForce(force));
 	mImpl->SetRotationalForce(force);
 }
 
 void RigidBodyImpl::SetCollisionFilterGroup(unsigned group) {
+	LOCK_WORLD;
 	mImpl->SetCollisionFilterGroup(group);
 }
 
 void RigidBodyImpl::RemoveCollisionFilterGroup(unsigned flag) {
+	LOCK_WORLD;
 	mImpl->RemoveCollisionFilterGroup(flag);
 }
 
 void RigidBodyImpl::AddCollisionFilter(unsigned flag) {
+	LOCK_WORLD;
 	mImpl->AddCollisionFilter(flag);
 }
 
 void RigidBodyImpl::SetColMask(unsigned mask) {
+	LOCK_WORLD;
 	mImpl->SetColMask(mask);
 }
 
@@ -811,34 +852,42 @@ unsigned RigidBodyImpl::GetColMask() const {
 }
 
 void RigidBodyImpl::SetLinearDamping(float damping) {
+	QUEUE_TO_SIMULATION_THREAD(SetLinearDamping(damping));
 	mImpl->SetLinearDamping(damping);
 }
 
 void RigidBodyImpl::SetAngularDamping(float damping) {
+	QUEUE_TO_SIMULATION_THREAD(SetAngularDamping(damping));
 	mImpl->SetAngularDamping(damping);
 }
 
 void RigidBodyImpl::SetDamping(float linear, float angular) {
+	QUEUE_TO_SIMULATION_THREAD(SetDamping(linear, angular));
 	mImpl->SetDamping(linear, angular);
 }
 
 unsigned RigidBodyImpl::HasContact(void* gamePtrs[], int limit) {
+	LOCK_WORLD;
 	return mImpl->HasContact(gamePtrs, limit);
 }
 
 void RigidBodyImpl::RemoveFromWorld() {
+	LOCK_WORLD;
 	mImpl->RemoveFromWorld();
 }
 
 void RigidBodyImpl::AddToWorld() {
+	LOCK_WORLD;
 	mImpl->AddToWorld();
 }
 
 void RigidBodyImpl::ReaddToWorld() {
+	LOCK_WORLD;
 	mImpl->ReaddToWorld();
 }
 
 void RigidBodyImpl::ModifyCollisionFlag(int flag, bool enable) {
+	LOCK_WORLD;
 	mImpl->ModifyCollisionFlag(flag, enable);
 }
 
@@ -855,26 +904,32 @@ void RigidBodyImpl::SetContactProcessingThreshold(float threshold) {
 }
 
 void RigidBodyImpl::SetIgnoreCollisionCheck(RigidBodyPtr rigidBody, bool ignore) {
+	LOCK_WORLD;
 	mImpl->SetIgnoreCollisionCheck(rigidBody, ignore);
 }
 
 void RigidBodyImpl::SetTransform(const Transformation& t) {
+	LOCK_WORLD;
 	mImpl->SetTransform(t);
 }
 
 Vec3 RigidBodyImpl::GetPos() const {
+	LOCK_WORLD;
 	return mImpl->GetPos();
 }
 
 void RigidBodyImpl::RegisterToWorld() {
+	LOCK_WORLD;
 	mImpl->RegisterToWorld();
 }
 
 void RigidBodyImpl::UnregisterFromWorld() {
+	LOCK_WORLD;
 	mImpl->UnregisterFromWorld();
 }
 
 void RigidBodyImpl::SetKinematic(bool enable) {
+	LOCK_WORLD;
 	mImpl->SetKinematic(enable);
 }
 
@@ -887,14 +942,17 @@ bool RigidBodyImpl::IsGrouped() const {
 }
 
 void RigidBodyImpl::RemoveConstraints() {
+	LOCK_WORLD;
 	mImpl->RemoveConstraints();
 }
 
 void RigidBodyImpl::RemoveConstraint(void* constraintPtr) {
+	LOCK_WORLD;
 	mImpl->RemoveConstraint(constraintPtr);
 }
 
 void RigidBodyImpl::RemoveConstraintsFor(void* gamePtr){
+	LOCK_WORLD;
 	mImpl->RemoveConstraintsFor(gamePtr);
 }
 
@@ -915,10 +973,12 @@ void RigidBodyImpl::SetDebug(bool debug) {
 }
 
 bool RigidBodyImpl::CheckCollideWith(RigidBodyPtr other){
+	LOCK_WORLD;
 	return mImpl->CheckCollideWith(other);
 }
 
 float RigidBodyImpl::GetTimeToStopRotation(const Vec3& torque, float& currentAngularSpeed) const{
+	LOCK_WORLD;
 	auto btTorque = FBToBullet(torque);
 	auto& angularVelV = getAngularVelocity();
 	currentAngularSpeed = angularVelV.length();
@@ -934,6 +994,7 @@ Mat33 RigidBodyImpl::GetInertiaTensor() const{
 }
 
 void RigidBodyImpl::SetGravity(const Vec3& gravity) {
+	LOCK_WORLD;
 	auto btGravity = FBToBullet(gravity);
 	setGravity(btGravity);
 }
@@ -947,6 +1008,7 @@ void RigidBodyImpl::OnAABBOverflow() {
 }
 
 AABB RigidBodyImpl::GetAABB() const {
+	LOCK_WORLD;
 	btVector3 min, max;
 	getAabb(min, max);
 	return AABB(BulletToFB(min), BulletToFB(max));
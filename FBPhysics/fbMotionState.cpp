@@ -33,7 +33,16 @@ using namespace fb;
 
 fbMotionState::fbMotionState(IPhysicsInterface* obj)
 	: mVisualObj(obj)
+	, mMiddle(1)
+	, mBack(0)
+	, mFront(2)
+	, mFrontApplied(true)
+	, mHasLastTransform(false)
+	, mSimulatingStep(0)
 {
+	for (auto& snapshot : mSnapshots) {
+		snapshot.step = 0;
+	}
 }
 
 fbMotionState::~fbMotionState()
@@ -52,5 +61,52 @@ void	fbMotionState::getWorldTransform(btTransform& worldTrans) const
 void	fbMotionState::setWorldTransform(const btTransform& worldTrans)
 {
 	assert(mVisualObj);
+	if (mSimulatingStep) {
+		auto& snapshot = mSnapshots[mBack];
+		snapshot.prev = mHasLastTransform ? mLastTransform : worldTrans;
+		snapshot.cur = worldTrans;
+		snapshot.step = *mSimulatingStep;
+		mLastTransform = worldTrans;
+		mHasLastTransform = true;
+		mBack = mMiddle.exchange(mBack | DirtyBit) & ~DirtyBit;
+		return;
+	}
 	mVisualObj->SetPosRot(BulletToFB(worldTrans.getOrigin()), BulletToFB(worldTrans.getRotation()));
-}
\ No newline at end of file
+}
+
+void fbMotionState::SetBuffered(const unsigned* simulatingStep)
+{
+	mSimulatingStep = simulatingStep;
+	mHasLastTransform = false;
+}
+
+bool fbMotionState::IsBuffered() const
+{
+	return mSimulatingStep != 0;
+}
+
+void fbMotionState::ApplyBufferedTransform(unsigned lastCompletedStep, float alpha)
+{
+	assert(mVisualObj);
+	if (mMiddle.load() & DirtyBit) {
+		mFront = mMiddle.exchange(mFront) & ~DirtyBit;
+		mFrontApplied = false;
+	}
+	auto& snapshot = mSnapshots[mFront];
+	if (snapshot.step == 0)
+		return;
+	bool interpolate = snapshot.step == lastCompletedStep && alpha < 1.f;
+	if (mFrontApplied && !interpolate)
+		return;
+	
+	if (interpolate) {
+		auto origin = snapshot.prev.getOrigin().lerp(snapshot.cur.getOrigin(), alpha);
+		auto rot = snapshot.prev.getRotation().slerp(snapshot.cur.getRotation(), alpha);
+		mVisualObj->SetPosRot(BulletToFB(origin), BulletToFB(rot));
+		mFrontApplied = false;
+	}
+	else {
+		mVisualObj->SetPosRot(BulletToFB(snapshot.cur.getOrigin()), BulletToFB(snapshot.cur.getRotation()));
+		mFrontApplied = true;
+	}
+}
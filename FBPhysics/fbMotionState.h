@@ -27,6 +27,7 @@
 
 #pragma once
 #include <LinearMath/btMotionState.h>
+#include <atomic>
 namespace fb
 {
 	class IPhysicsInterface;
@@ -35,6 +36,25 @@ namespace fb
 	{
 		IPhysicsInterface* mVisualObj;
 
+		// Used when the simulation runs on its own thread.
+		// Triple buffered. The simulation thread writes mSnapshots[mBack] and
+		// publishes it through mMiddle; the game thread reads mSnapshots[mFront].
+		struct Snapshot {
+			btTransform prev;
+			btTransform cur;
+			unsigned step;
+		};
+		static const int DirtyBit = 4;
+		Snapshot mSnapshots[3];
+		std::atomic<int> mMiddle;
+		int mBack;
+		int mFront;
+		bool mFrontApplied;
+		btTransform mLastTransform;
+		bool mHasLastTransform;
+		// index of the step being simulated. 0 if not buffered.
+		const unsigned* mSimulatingStep;
+
 	public:
 		fbMotionState(IPhysicsInterface* obj);
 		virtual ~fbMotionState();
@@ -43,5 +63,14 @@ namespace fb
 
 		//Bullet only calls the update of worldtransform for active objects
 		virtual void	setWorldTransform(const btTransform& worldTrans);
+
+		/// When buffered, setWorldTransform() doesn't touch the visual object.
+		/// \param simulatingStep owned by the simulation thread. 0 to disable.
+		void SetBuffered(const unsigned* simulatingStep);
+		bool IsBuffered() const;
+		/// Game thread. Applies the latest simulated transform to the visual object.
+		/// interpolates between the last two steps if the latest snapshot is from 
+		/// lastCompletedStep.
+		void ApplyBufferedTransform(unsigned lastCompletedStep, float alpha);
 	};
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #if defined(_PLATFORM_WINDOWS_)
 #define FB_DLL_PHYSICS __declspec(dllexport)
 #define FB_DLL_FILESYSTEM __declspec(dllimport)
+#define FB_DLL_THREAD __declspec(dllimport)
 #else
 #endif
 
@@ -39,6 +39,32 @@
 
 using namespace fb;
 
+static std::mutex sCameraIndexMutex;
+static std::vector<unsigned> sFreeCameraIndices;
+static unsigned sNumCameraIndices = 0;
+static unsigned sLastCameraIndexSerial = 0;
+
+static unsigned AllocateCameraIndex(){
+	MutexLock lock(sCameraIndexMutex);
+	if (sFreeCameraIndices.empty())
+		return sNumCameraIndices++;
+	auto index = sFreeCameraIndices.back();
+	sFreeCameraIndices.pop_back();
+	return index;
+}
+
+static void ReleaseCameraIndex(unsigned index){
+	MutexLock lock(sCameraIndexMutex);
+	sFreeCameraIndices.push_back(index);
+}
+
+static unsigned NextCameraIndexSerial(){
+	MutexLock lock(sCameraIndexMutex);
+	if (++sLastCameraIndexSerial == 0)
+		++sLastCameraIndexSerial;
+	return sLastCameraIndexSerial;
+}
+
 class Camera::Impl{
 public:
 	struct UserParameters
@@ -820,17 +846,23 @@ CameraPtr Camera::Create() {
 }
 
 Camera::Camera()
-	: mImpl(new Impl(this)){
+	: mImpl(new Impl(this))
+	, mIndex(AllocateCameraIndex())
+	, mIndexSerial(NextCameraIndexSerial())
+{
 	
 }
 
 Camera::Camera(const Camera& other)
 	: mImpl(new Impl(this))
+	, mIndex(AllocateCameraIndex())
+	, mIndexSerial(NextCameraIndexSerial())
 {
 	*mImpl = *other.mImpl;	
 }
 
 Camera::~Camera(){	
+	ReleaseCameraIndex(mIndex);
 }
 
 Camera& Camera::operator= (const Camera& other)
@@ -1137,4 +1169,12 @@ void Camera::RenderFrustum()
 
 size_t Camera::ComputeHash() const {
 	return mImpl->ComputeHash();
+}
+
+unsigned Camera::GetIndex() const {
+	return mIndex;
+}
+
+unsigned Camera::GetIndexSerial() const {
+	return mIndexSerial;
 }
\ No newline at end of file
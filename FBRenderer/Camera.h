@@ -44,6 +44,8 @@ namespace fb
 	class FB_DLL_RENDERER Camera : public ICamera, public Observable<ICameraObserver>
 	{
 		FB_DECLARE_PIMPL(Camera);
+		unsigned mIndex;
+		unsigned mIndexSerial;
 		Camera();
 
 	public:
@@ -133,6 +135,8 @@ namespace fb
 		void RenderFrustum();		
 
 		size_t ComputeHash() const OVERRIDE;
+		unsigned GetIndex() const OVERRIDE;
+		unsigned GetIndexSerial() const OVERRIDE;
 
 		//-------------------------------------------------------------------
 		// InputConsumer From Renderer
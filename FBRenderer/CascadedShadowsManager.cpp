@@ -647,6 +647,23 @@ public:
 			Color(0.4, 0.4, 0.4),
 			Color(0.2, 0.2, 0.2)
 		};
+		// Every cascade shares the light view. Collect the casters of all
+		// cascades at once instead of culling the scene per cascade.
+		ShadowCascadeBounds cascades[MAX_CASCADES];
+		for (INT i = 0; i < options->r_ShadowCascadeLevels; ++i){
+			auto& orthogonalData = mOrthogonalData[i];
+			auto& cascade = cascades[i];
+			cascade.mL = orthogonalData.mL;
+			cascade.mR = orthogonalData.mR;
+			cascade.mB = orthogonalData.mB;
+			cascade.mT = orthogonalData.mT;
+			cascade.mNear = orthogonalData.mNear;
+			cascade.mFar = orthogonalData.mFar;
+			float texelSize = (orthogonalData.mR - orthogonalData.mL) / (float)options->r_ShadowMapSize;
+			cascade.mMinCasterRadius = texelSize * options->r_ShadowCasterMinTexels * 0.5f;
+		}
+		scene->MakeShadowCasterSets(mLightCamera->GetMatrix(ICamera::View), cascades,
+			options->r_ShadowCascadeLevels);
 		// Iterate over cascades and render shadows.
 		for (INT currentCascade = 0;
 			currentCascade < options->r_ShadowCascadeLevels;
@@ -666,8 +683,7 @@ public:
 			param.mCamera = mLightCamera.get();
 			//param.mLightCamera = param.mCamera;
 			param.mRenderPass = PASS_SHADOW;
-			scene->MakeVisibleSet(mLightCamera.get(), true);
-			scene->Render(param, 0);	
+			scene->RenderShadowCasters(currentCascade, param, 0);
 			if (mainRT && renderer.GetRendererOptions()->r_LightFrustum){
 				AABB aabb;
 				aabb.SetMax(Vec3(orthogonalData.mR, orthogonalData.mFar, orthogonalData.mT));
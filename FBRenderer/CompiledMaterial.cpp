@@ -0,0 +1,1106 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "CompiledMaterial.h"
+#include "FBStringLib/StringLib.h"
+#include "FBStringLib/StringConverter.h"
+#include "FBStringLib/MurmurHash.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBFileSystem/DirectoryIterator.h"
+#include "TinyXmlLib/tinyxml2.h"
+
+namespace fb{
+	enum : unsigned {
+		// version : 20161001 -- 2016 year / 10 month / 01st
+		fbmaterial_cache_version = 20161001
+	};
+	static const char material_cache_mark[2] = { (char)0xfb, (char)0x10 };
+
+	// format
+	// mark: (0xfb, 0x10)
+	// version
+	// modified time, size and content hash of the .material file
+	// compiled material
+	//		sub materials
+
+	//---------------------------------------------------------------------------
+	template <typename T>
+	static void WritePod(ByteArray& data, const T& value) {
+		auto pos = data.size();
+		data.resize(pos + sizeof(T));
+		memcpy(&data[pos], &value, sizeof(T));
+	}
+
+	template <typename T>
+	static void WritePodVector(ByteArray& data, const std::vector<T>& values) {
+		WritePod(data, (unsigned)values.size());
+		if (values.empty())
+			return;
+		auto pos = data.size();
+		data.resize(pos + sizeof(T) * values.size());
+		memcpy(&data[pos], &values[0], sizeof(T) * values.size());
+	}
+
+	static void WriteString(ByteArray& data, const std::string& str) {
+		WritePod(data, (unsigned)str.size());
+		data.insert(data.end(), str.begin(), str.end());
+	}
+
+	template <typename T>
+	static bool ReadPod(const ByteArray& data, size_t& pos, T& value) {
+		if (pos + sizeof(T) > data.size())
+			return false;
+		memcpy(&value, &data[pos], sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	static bool ReadPodVector(const ByteArray& data, size_t& pos, std::vector<T>& values) {
+		unsigned num;
+		if (!ReadPod(data, pos, num) || pos + sizeof(T) * num > data.size())
+			return false;
+		values.resize(num);
+		if (num) {
+			memcpy(&values[0], &data[pos], sizeof(T) * num);
+			pos += sizeof(T) * num;
+		}
+		return true;
+	}
+
+	static bool ReadString(const ByteArray& data, size_t& pos, std::string& str) {
+		unsigned length;
+		if (!ReadPod(data, pos, length) || pos + length > data.size())
+			return false;
+		str.assign((const char*)&data[0] + pos, length);
+		pos += length;
+		return true;
+	}
+
+	// The render state descriptors are written field by field. Their padding
+	// and cached hash values would make the same states differ in bytes, and
+	// the bytes are hashed to find the materials which can share data.
+	static void WriteDesc(ByteArray& data, const BLEND_DESC& desc) {
+		WritePod(data, desc.AlphaToCoverageEnable);
+		WritePod(data, desc.IndependentBlendEnable);
+		for (auto& rt : desc.RenderTarget) {
+			WritePod(data, (int)rt.SrcBlend);
+			WritePod(data, (int)rt.DestBlend);
+			WritePod(data, (int)rt.BlendOp);
+			WritePod(data, (int)rt.SrcBlendAlpha);
+			WritePod(data, (int)rt.DestBlendAlpha);
+			WritePod(data, (int)rt.BlendOpAlpha);
+			WritePod(data, rt.RenderTargetWriteMask);
+			WritePod(data, rt.BlendEnable);
+		}
+	}
+
+	static bool ReadDesc(const ByteArray& data, size_t& pos, BLEND_DESC& desc) {
+		if (!ReadPod(data, pos, desc.AlphaToCoverageEnable) || !ReadPod(data, pos, desc.IndependentBlendEnable))
+			return false;
+		for (auto& rt : desc.RenderTarget) {
+			int blends[6];
+			if (!ReadPod(data, pos, blends) || !ReadPod(data, pos, rt.RenderTargetWriteMask) ||
+				!ReadPod(data, pos, rt.BlendEnable))
+				return false;
+			rt.SrcBlend = (BLEND)blends[0];
+			rt.DestBlend = (BLEND)blends[1];
+			rt.BlendOp = (BLEND_OP)blends[2];
+			rt.SrcBlendAlpha = (BLEND)blends[3];
+			rt.DestBlendAlpha = (BLEND)blends[4];
+			rt.BlendOpAlpha = (BLEND_OP)blends[5];
+		}
+		return true;
+	}
+
+	static void WriteDesc(ByteArray& data, const DEPTH_STENCILOP_DESC& desc) {
+		WritePod(data, (int)desc.GetStencilFailOp());
+		WritePod(data, (int)desc.GetStencilDepthFailOp());
+		WritePod(data, (int)desc.GetStencilPassOp());
+		WritePod(data, (int)desc.GetStencilFunc());
+	}
+
+	static bool ReadDesc(const ByteArray& data, size_t& pos, DEPTH_STENCILOP_DESC& desc) {
+		int values[4];
+		if (!ReadPod(data, pos, values))
+			return false;
+		desc.SetStencilFailOp((STENCIL_OP)values[0]);
+		desc.SetStencilDepthFailOp((STENCIL_OP)values[1]);
+		desc.SetStencilPassOp((STENCIL_OP)values[2]);
+		desc.SetStencilFunc((COMPARISON_FUNC)values[3]);
+		return true;
+	}
+
+	static void WriteDesc(ByteArray& data, const DEPTH_STENCIL_DESC& desc) {
+		WritePod(data, (int)desc.GetDepthWriteMask());
+		WritePod(data, (int)desc.GetDepthFunc());
+		WriteDesc(data, desc.GetFrontFace());
+		WriteDesc(data, desc.GetBackFace());
+		WritePod(data, desc.GetStencilReadMask());
+		WritePod(data, desc.GetStencilWriteMask());
+		WritePod(data, desc.GetDepthEnable());
+		WritePod(data, desc.GetStencilEnable());
+	}
+
+	static bool ReadDesc(const ByteArray& data, size_t& pos, DEPTH_STENCIL_DESC& desc) {
+		int values[2];
+		DEPTH_STENCILOP_DESC front, back;
+		unsigned char masks[2];
+		bool enables[2];
+		if (!ReadPod(data, pos, values) || !ReadDesc(data, pos, front) || !ReadDesc(data, pos, back) ||
+			!ReadPod(data, pos, masks) || !ReadPod(data, pos, enables))
+			return false;
+		desc.SetFrontFace(front);
+		desc.SetBackFace(back);
+		desc.SetDepthWriteMask((DEPTH_WRITE_MASK)values[0]);
+		desc.SetDepthFunc((COMPARISON_FUNC)values[1]);
+		desc.SetStencilReadMask(masks[0]);
+		desc.SetStencilWriteMask(masks[1]);
+		desc.SetDepthEnable(enables[0]);
+		desc.SetStencilEnable(enables[1]);
+		return true;
+	}
+
+	static void WriteDesc(ByteArray& data, const RASTERIZER_DESC& desc) {
+		WritePod(data, (int)desc.GetFillMode());
+		WritePod(data, (int)desc.GetCullMode());
+		WritePod(data, desc.GetDepthBias());
+		WritePod(data, desc.GetDepthBiasClamp());
+		WritePod(data, desc.GetSlopeScaledDepthBias());
+		WritePod(data, desc.GetFrontCounterClockwise());
+		WritePod(data, desc.GetDepthClipEnable());
+		WritePod(data, desc.GetScissorEnable());
+		WritePod(data, desc.GetMultisampleEnable());
+		WritePod(data, desc.GetAntialiasedLineEnable());
+	}
+
+	static bool ReadDesc(const ByteArray& data, size_t& pos, RASTERIZER_DESC& desc) {
+		int values[3];
+		float biases[2];
+		bool flags[5];
+		if (!ReadPod(data, pos, values) || !ReadPod(data, pos, biases) || !ReadPod(data, pos, flags))
+			return false;
+		desc.SetFillMode((FILL_MODE)values[0]);
+		desc.SetCullMode((CULL_MODE)values[1]);
+		desc.SetDepthBias(values[2]);
+		desc.SetDepthBiasClamp(biases[0]);
+		desc.SetSlopeScaledDepthBias(biases[1]);
+		desc.SetFrontCounterClockwise(flags[0]);
+		desc.SetDepthClipEnable(flags[1]);
+		desc.SetScissorEnable(flags[2]);
+		desc.SetMultisampleEnable(flags[3]);
+		desc.SetAntialiasedLineEnable(flags[4]);
+		return true;
+	}
+
+	static void WriteDesc(ByteArray& data, const SAMPLER_DESC& desc) {
+		WritePod(data, (int)desc.GetFilter());
+		WritePod(data, (int)desc.GetAddressU());
+		WritePod(data, (int)desc.GetAddressV());
+		WritePod(data, (int)desc.GetAddressW());
+		WritePod(data, desc.GetMipLODBias());
+		WritePod(data, desc.GetMaxAnisotropy());
+		WritePod(data, (int)desc.GetComparisonFunc());
+		auto borderColor = desc.GetBorderColor();
+		for (int i = 0; i < 4; ++i)
+			WritePod(data, borderColor[i]);
+		WritePod(data, desc.GetMinLOD());
+		WritePod(data, desc.GetMaxLOD());
+	}
+
+	static bool ReadDesc(const ByteArray& data, size_t& pos, SAMPLER_DESC& desc) {
+		int values[4];
+		float mipLODBias;
+		unsigned maxAnisotropy;
+		int comparisonFunc;
+		float borderColor[4];
+		float lods[2];
+		if (!ReadPod(data, pos, values) || !ReadPod(data, pos, mipLODBias) ||
+			!ReadPod(data, pos, maxAnisotropy) || !ReadPod(data, pos, comparisonFunc) ||
+			!ReadPod(data, pos, borderColor) || !ReadPod(data, pos, lods))
+			return false;
+		desc.SetFilter((TEXTURE_FILTER)values[0]);
+		desc.SetAddressU((TEXTURE_ADDRESS_MODE)values[1]);
+		desc.SetAddressV((TEXTURE_ADDRESS_MODE)values[2]);
+		desc.SetAddressW((TEXTURE_ADDRESS_MODE)values[3]);
+		desc.SetMipLODBias(mipLODBias);
+		desc.SetMaxAnisotropy(maxAnisotropy);
+		desc.SetComparisonFunc((COMPARISON_FUNC)comparisonFunc);
+		desc.SetBorderColor(borderColor);
+		desc.SetMinLOD(lods[0]);
+		desc.SetMaxLOD(lods[1]);
+		return true;
+	}
+
+	static void ParseDepthStencilFace(tinyxml2::XMLElement* elem, DEPTH_STENCILOP_DESC& desc) {
+		const char* sz;
+		sz = elem->Attribute("StencilPassOp");
+		if (sz){
+			desc.SetStencilPassOp(StencilOpFromString(sz));
+		}
+		sz = elem->Attribute("StencilFailOp");
+		if (sz){
+			desc.SetStencilFailOp(StencilOpFromString(sz));
+		}
+
+		sz = elem->Attribute("StencilDepthFailOp");
+		if (sz) {
+			desc.SetStencilDepthFailOp(StencilOpFromString(sz));
+		}
+
+		sz = elem->Attribute("StencilFunc");
+		if (sz){
+			desc.SetStencilFunc(ComparisonFuncFromString(sz));
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	CompiledMaterial::TextureDesc::TextureDesc()
+		: mShader(SHADER_TYPE_PS)
+		, mSlot(0)
+		, mTextureType(TEXTURE_TYPE_DEFAULT)
+		, mFileExists(false)
+	{
+	}
+
+	CompiledMaterial::CompiledMaterial()
+		: mRenderPass(PASS_NORMAL)
+		, mPrimitiveTopology(PRIMITIVE_TOPOLOGY_UNKNOWN)
+		, mTransparent(false)
+		, mGlow(false)
+		, mNoShadowCast(false)
+		, mDoubleSided(false)
+		, mInstancing(false)
+		, mResetRasterizer(false)
+		, mResetDepthStencil(false)
+		, mResetBlend(false)
+		, mResetPrimitiveTopology(false)
+		, mDebug(0)
+		, mShaders(SHADER_TYPE_VS | SHADER_TYPE_PS)
+	{
+		memset(&mMaterialConstants, 0, sizeof(mMaterialConstants));
+	}
+
+	void CompiledMaterial::ParseXml(tinyxml2::XMLElement* pRoot, const char* materialPath) {
+		const char* sz = pRoot->Attribute("transparent");
+		if (sz)
+		{
+			mTransparent = StringConverter::ParseBool(sz);
+		}
+
+		sz = pRoot->Attribute("glow");
+		if (sz)
+		{
+			mGlow = StringConverter::ParseBool(sz);
+		}
+
+		sz = pRoot->Attribute("noShadowCast");
+		if (sz)
+		{
+			mNoShadowCast = StringConverter::ParseBool(sz);
+		}
+
+		sz = pRoot->Attribute("instancing");
+		if (sz)
+		{
+			mInstancing = StringConverter::ParseBool(sz);
+		}
+
+		sz = pRoot->Attribute("doubleSided");
+		if (sz)
+		{
+			mDoubleSided = StringConverter::ParseBool(sz);
+		}
+
+		auto ptElem = pRoot->FirstChildElement("PrimitiveTopology");
+		if (ptElem) {
+			sz = ptElem->GetText();
+			if (sz) {
+				mPrimitiveTopology = PrimitiveTopologyFromString(sz);
+			}
+			auto sz = ptElem->Attribute("ResetAtUnbind");
+			if (sz) {
+				mResetPrimitiveTopology = StringConverter::ParseBool(sz);
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		// BlendDesc
+		//-----------------------------------------------------------------------------
+		BLEND_DESC& bdesc = mBlendDesc;
+		auto blendDescElem = pRoot->FirstChildElement("BlendDesc");
+		if (blendDescElem)
+		{
+			sz = blendDescElem->Attribute("BlendEnalbe");
+			if (sz)
+				bdesc.RenderTarget[0].BlendEnable = StringConverter::ParseBool(sz);
+			if (bdesc.RenderTarget[0].BlendEnable)
+			{
+				mTransparent = true;
+			}
+
+			sz = blendDescElem->Attribute("BlendOp");
+			if (sz)
+				bdesc.RenderTarget[0].BlendOp = BlendOpFromString(sz);
+
+			sz = blendDescElem->Attribute("SrcBlend");
+			if (sz)
+				bdesc.RenderTarget[0].SrcBlend = BlendFromString(sz);
+
+			sz = blendDescElem->Attribute("DestBlend");
+			if (sz)
+				bdesc.RenderTarget[0].DestBlend = BlendFromString(sz);
+			sz = blendDescElem->Attribute("RenderTargetWriteMask");
+			if (sz)
+			{
+				auto options = Split(sz, "|");
+				for (auto& it : options)
+				{
+					it = StripBoth(it.c_str());
+				}
+				int mask = 0;
+				for (auto& it : options)
+				{
+					mask += ColorWriteMaskFromString(it.c_str());
+				}
+				bdesc.RenderTarget[0].RenderTargetWriteMask = mask;
+			}
+
+			sz = blendDescElem->Attribute("ResetAtUnbind");
+			if (sz) {
+				mResetBlend = StringConverter::ParseBool(sz);
+			}
+		}
+		else
+		{
+			if (mTransparent)
+			{
+				bdesc.RenderTarget[0].BlendEnable = true;
+				bdesc.RenderTarget[0].BlendOp = BLEND_OP_ADD;
+				bdesc.RenderTarget[0].SrcBlend = BLEND_SRC_ALPHA;
+				bdesc.RenderTarget[0].DestBlend = BLEND_INV_SRC_ALPHA;
+			}
+		}
+		//-----------------------------------------------------------------------------
+		// DepthStencilDesc
+		//-----------------------------------------------------------------------------
+		DEPTH_STENCIL_DESC& ddesc = mDepthStencilDesc;
+		auto depthDescElem = pRoot->FirstChildElement("DepthStencilDesc");
+		if (depthDescElem)
+		{
+			sz = depthDescElem->Attribute("DepthEnable");
+			if (sz)
+				ddesc.SetDepthEnable(StringConverter::ParseBool(sz));
+
+			sz = depthDescElem->Attribute("DepthWriteMask");
+			if (sz)
+				ddesc.SetDepthWriteMask(DepthWriteMaskFromString(sz));
+
+			sz = depthDescElem->Attribute("DepthFunc");
+			if (sz)
+				ddesc.SetDepthFunc(ComparisonFuncFromString(sz));
+
+			sz = depthDescElem->Attribute("ResetAtUnbind");
+			if (sz) {
+				mResetDepthStencil = StringConverter::ParseBool(sz);
+			}
+
+			sz = depthDescElem->Attribute("StencilEnable");
+			if (sz) {
+				ddesc.SetStencilEnable(StringConverter::ParseBool(sz));
+			}
+
+			sz = depthDescElem->Attribute("StencilReadMask");
+			if (sz) {
+				ddesc.SetStencilReadMask( StringConverter::ParseInt(sz));
+			}
+
+			sz = depthDescElem->Attribute("StencilWriteMask");
+			if (sz) {
+				ddesc.SetStencilWriteMask(StringConverter::ParseInt(sz));
+			}
+			auto frontFaceElem = depthDescElem->FirstChildElement("FrontFace");
+			if (frontFaceElem) {
+				ParseDepthStencilFace(frontFaceElem, ddesc.GetFrontFace());
+			}
+			auto backFaceElem = depthDescElem->FirstChildElement("BackFace");
+			if (backFaceElem) {
+				ParseDepthStencilFace(backFaceElem, ddesc.GetBackFace());
+			}			
+		}
+		else
+		{
+			ddesc.SetDepthWriteMask(mTransparent ? DEPTH_WRITE_MASK_ZERO : DEPTH_WRITE_MASK_ALL);
+		}
+
+		//-----------------------------------------------------------------------------
+		auto debugElem = pRoot->FirstChildElement("Debug");
+		if (debugElem) {
+			auto szValue = debugElem->Attribute("value");
+			if (szValue) {
+				mDebug = StringConverter::ParseInt(szValue);
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		// RasterizerDesc
+		//-----------------------------------------------------------------------------
+		RASTERIZER_DESC& rdesc = mRasterizerDesc;
+		auto rasterizerDescElem = pRoot->FirstChildElement("RasterizerDesc");
+		if (rasterizerDescElem)
+		{
+			sz = rasterizerDescElem->Attribute("FillMode");
+			if (sz)
+				rdesc.SetFillMode(FillModeFromString(sz));
+
+			sz = rasterizerDescElem->Attribute("CullMode");
+			if (sz)
+				rdesc.SetCullMode(CullModeFromString(sz));
+
+			sz = rasterizerDescElem->Attribute("ScissorEnable");
+			if (sz)
+				rdesc.SetScissorEnable(StringConverter::ParseBool(sz));
+
+			sz = rasterizerDescElem->Attribute("DepthBias");
+			if (sz)
+				rdesc.SetDepthBias(StringConverter::ParseInt(sz));
+
+			sz = rasterizerDescElem->Attribute("SlopeScaledDepthBias");
+			if (sz)
+				rdesc.SetSlopeScaledDepthBias(StringConverter::ParseReal(sz));
+
+			sz = rasterizerDescElem->Attribute("FrontCounterClockwise");
+			if (sz)
+				rdesc.SetFrontCounterClockwise(StringConverter::ParseBool(sz));
+
+			sz = rasterizerDescElem->Attribute("ResetAtUnbind");
+			if (sz) {
+				mResetRasterizer = StringConverter::ParseBool(sz);
+			}
+		}
+		else
+		{
+			rdesc.SetCullMode(mDoubleSided ? CULL_MODE_NONE : CULL_MODE_BACK);
+		}
+
+		sz = pRoot->Attribute("pass");
+		if (sz)
+			mRenderPass = (RENDER_PASS)RenderPassFromString(sz);
+
+		tinyxml2::XMLElement* pMaterialConstants = pRoot->FirstChildElement("MaterialConstants");
+		if (pMaterialConstants)
+		{
+			tinyxml2::XMLElement* pAmbientElem = pMaterialConstants->FirstChildElement("AmbientColor");
+			if (pAmbientElem)
+			{
+				const char* szAmbient = pAmbientElem->GetText();
+				Vec4 ambient(szAmbient);
+				mMaterialConstants.gAmbientColor = ambient;
+			}
+			tinyxml2::XMLElement* pDiffuseElem = pMaterialConstants->FirstChildElement("DiffuseColor_Alpha");
+			if (pDiffuseElem)
+			{
+				const char* szDiffuse = pDiffuseElem->GetText();
+				Vec4 diffuse(szDiffuse);
+				mMaterialConstants.gDiffuseColor = diffuse;
+			}
+			tinyxml2::XMLElement* pSpecularElem = pMaterialConstants->FirstChildElement("SpecularColor_Shine");
+			if (pSpecularElem)
+			{
+				const char* szSpecular = pSpecularElem->GetText();
+				Vec4 specular(szSpecular);
+				mMaterialConstants.gSpecularColor = specular;				
+			}
+			tinyxml2::XMLElement* pEmissiveElem = pMaterialConstants->FirstChildElement("EmissiveColor_Strength");
+			if (pEmissiveElem)
+			{
+				const char* szEmissive = pEmissiveElem->GetText();
+				Vec4 emissive(szEmissive);
+				mMaterialConstants.gEmissiveColor = emissive;				
+			}
+		}
+
+		tinyxml2::XMLElement* pShaderConstants = pRoot->FirstChildElement("ShaderConstants");		
+		if (pShaderConstants)
+		{
+			tinyxml2::XMLElement* pElem = pShaderConstants->FirstChildElement();
+			unsigned i = 0;
+			while (pElem)
+			{
+				const char* szVector = pElem->GetText();
+				if (szVector)
+				{
+					Vec4 v(szVector);
+					mShaderConstants.push_back(std::make_pair(i++, Vec4f(v)));
+				}
+				pElem = pElem->NextSiblingElement();
+			}
+		}
+
+		tinyxml2::XMLElement* pDefines = pRoot->FirstChildElement("ShaderDefines");		
+		if (pDefines)
+		{
+			tinyxml2::XMLElement* pElem = pDefines->FirstChildElement();
+			while (pElem)
+			{
+				std::string strName, strValue;
+				const char* pname = pElem->Attribute("name");
+				if (pname)
+					strName = pname;
+				const char* pval = pElem->Attribute("val");
+				if (pval)
+					strValue = pval;
+				
+				mShaderDefines.push_back(ShaderDefine(strName.c_str(), strValue.c_str()));
+				pElem = pElem->NextSiblingElement();
+			}
+			std::sort(mShaderDefines.begin(), mShaderDefines.end());
+		}
+
+		tinyxml2::XMLElement* pTexturesElem = pRoot->FirstChildElement("Textures");
+		if (pTexturesElem)
+		{
+			tinyxml2::XMLElement* pTexElem = pTexturesElem->FirstChildElement("Texture");
+			while (pTexElem)
+			{
+				auto sz = pTexElem->Attribute("SystemTexture");
+				if (sz) {
+					auto systemTexture = SystemTextures::ConvertToEnum(sz);
+					if (!ValueExistsInVector(mSystemTextures, systemTexture))
+						mSystemTextures.push_back(systemTexture);
+				}
+				else {
+					mTextures.push_back(TextureDesc());
+					auto& texture = mTextures.back();
+					pTexElem->QueryIntAttribute("slot", &texture.mSlot);
+					const char* szShader = pTexElem->Attribute("shader");
+					texture.mShader = BindingShaderFromString(szShader);
+					const char* szAddressU = pTexElem->Attribute("AddressU");
+					texture.mSamplerDesc.SetAddressU(AddressModeFromString(szAddressU));
+					const char* szAddressV = pTexElem->Attribute("AddressV");
+					texture.mSamplerDesc.SetAddressV(AddressModeFromString(szAddressV));
+					const char* szFilter = pTexElem->Attribute("Filter");
+					texture.mSamplerDesc.SetFilter(FilterFromString(szFilter));
+					const char* szType = pTexElem->Attribute("type");
+					if (szType)
+						texture.mTextureType = TextureTypeFromString(szType);
+					if (texture.mTextureType & TEXTURE_TYPE_COLOR_RAMP)
+					{
+						tinyxml2::XMLElement* barElem = pTexElem->FirstChildElement("Bar");
+						while (barElem)
+						{
+							float pos = barElem->FloatAttribute("pos");
+							const char* szColor = barElem->GetText();
+							Vec4 color(szColor);
+							texture.mColorRampBars.push_back(std::make_pair(pos, Vec4f(color)));
+							barElem = barElem->NextSiblingElement();
+						}
+					}
+					else
+					{
+						sz = pTexElem->GetText();
+						std::string filepath = sz ? sz : "";
+						texture.mFileExists = !filepath.empty() && FileSystem::ResourceExists(filepath.c_str());
+						if (!filepath.empty() && !texture.mFileExists) {
+							auto textureFileName = FileSystem::GetFileName(filepath.c_str());
+							std::string materialParentPath = FileSystem::GetParentPath(materialPath);
+							bool stripped = true;
+							do{
+								filepath = FileSystem::StripFirstDirectoryPath(filepath.c_str(), &stripped);
+								std::string alternativePath = materialParentPath + "/" + filepath;
+								if (FileSystem::ResourceExists(alternativePath.c_str())) {
+									filepath = alternativePath;
+									texture.mFileExists = true;
+									break;
+								}
+							} while (stripped && filepath != textureFileName);
+						}
+						texture.mFilepath = filepath;
+					}
+				}
+				pTexElem = pTexElem->NextSiblingElement("Texture");
+			}
+		}
+
+		tinyxml2::XMLElement* pShaders = pRoot->FirstChildElement("Shaders");
+		if (pShaders)
+		{
+			const char* szShaders = pShaders->GetText();
+			if (szShaders)
+			{
+				auto& shaders = mShaders;
+				shaders = 0;
+				std::string strShaders = szShaders;
+				ToLowerCase(strShaders);
+				if (strShaders.find("vs") != std::string::npos)
+				{
+					shaders |= SHADER_TYPE_VS;
+				}
+				if (strShaders.find("hs") != std::string::npos)
+				{
+					shaders |= SHADER_TYPE_HS;
+				}
+				if (strShaders.find("ds") != std::string::npos)
+				{
+					shaders |= SHADER_TYPE_DS;
+				}
+				if (strShaders.find("gs") != std::string::npos)
+				{
+					shaders |= SHADER_TYPE_GS;
+				}
+				if (strShaders.find("ps") != std::string::npos)
+				{
+					shaders |= SHADER_TYPE_PS;
+				}
+			}
+		}
+
+		tinyxml2::XMLElement* pShaderFileElem = pRoot->FirstChildElement("ShaderFile");
+		if (pShaderFileElem)
+		{
+			const char* shaderFile = pShaderFileElem->GetText();
+			if (shaderFile)
+			{
+				// INTEGRATED_SHADER,SHADER_TYPE_VS,SHADER_TYPE_HS,SHADER_TYPE_DS,SHADER_TYPE_GS,SHADER_TYPE_PS,SHADER_TYPE_CS		
+				mShaderFile = shaderFile;
+				mShaderFile += ",,,,,,";
+			}
+		}
+		else {
+			auto& shaders = mShaders;
+			shaders = 0;
+			std::string vs, hs, ds, gs, ps, cs;
+			auto shaderFilesElem = pRoot->FirstChildElement("SeperatedShaderFiles");
+			if (shaderFilesElem) {
+				auto elem = shaderFilesElem->FirstChildElement("VSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						vs = sz;
+						shaders |= SHADER_TYPE_VS;
+					}
+				}
+				elem = shaderFilesElem->FirstChildElement("HSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						hs = sz;
+						shaders |= SHADER_TYPE_HS;
+					}
+				}
+				elem = shaderFilesElem->FirstChildElement("DSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						ds = sz;
+						shaders |= SHADER_TYPE_DS;
+					}
+				}
+				elem = shaderFilesElem->FirstChildElement("GSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						gs = sz;
+						shaders |= SHADER_TYPE_GS;
+					}
+				}
+				elem = shaderFilesElem->FirstChildElement("PSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						ps = sz;
+						shaders |= SHADER_TYPE_PS;
+					}
+				}
+				elem = shaderFilesElem->FirstChildElement("CSFile");
+				if (elem) {
+					sz = elem->GetText();
+					if (sz) {
+						cs = sz;
+						shaders |= SHADER_TYPE_CS;
+					}
+				}
+				mShaderFile = FormatString("%s,%s,%s,%s,%s,%s,%s",
+					"",
+					vs.c_str(), hs.c_str(), ds.c_str(),
+					gs.c_str(), ps.c_str(), cs.c_str());
+			}
+		}		
+
+		tinyxml2::XMLElement* pInputLayoutElem = pRoot->FirstChildElement("InputLayout");
+		if (pInputLayoutElem)
+		{
+			tinyxml2::XMLElement* pElem = pInputLayoutElem->FirstChildElement();
+			while (pElem)
+			{
+				mInputElementDescs.push_back(INPUT_ELEMENT_DESC());
+				auto& desc = mInputElementDescs.back();
+				const char* pbuffer = pElem->Attribute("semantic");
+				if (pbuffer)
+					strcpy_s(desc.mSemanticName, pbuffer);
+				desc.mSemanticIndex = pElem->IntAttribute("index");
+
+				pbuffer = pElem->Attribute("format");
+				if (pbuffer)
+				{
+					desc.mFormat = InputElementFromString(pbuffer);
+				}
+
+				desc.mInputSlot = pElem->IntAttribute("slot");
+
+				desc.mAlignedByteOffset = pElem->IntAttribute("alignedByteOffset");
+
+				pbuffer = pElem->Attribute("inputSlotClass");
+				if (pbuffer)
+					desc.mInputSlotClass = InputClassificationFromString(pbuffer);
+
+				desc.mInstanceDataStepRate = pElem->IntAttribute("stepRate");
+
+				pElem = pElem->NextSiblingElement();
+			}
+		}
+
+		tinyxml2::XMLElement* subMat = pRoot->FirstChildElement("Material");
+		while (subMat)
+		{
+			mSubMaterials.push_back(CompiledMaterial());
+			mSubMaterials.back().ParseXml(subMat, "");
+			subMat = subMat->NextSiblingElement("Material");
+		}
+	}
+
+	void CompiledMaterial::Write(ByteArray& data) const {
+		WritePod(data, mRenderPass);
+		WritePod(data, mPrimitiveTopology);
+		bool flags[] = { mTransparent, mGlow, mNoShadowCast, mDoubleSided, mInstancing,
+			mResetRasterizer, mResetDepthStencil, mResetBlend, mResetPrimitiveTopology };
+		WritePod(data, flags);
+		WritePod(data, mDebug);
+		WriteDesc(data, mBlendDesc);
+		WriteDesc(data, mDepthStencilDesc);
+		WriteDesc(data, mRasterizerDesc);
+		WritePod(data, mMaterialConstants);
+		WritePodVector(data, mShaderConstants);
+		WritePod(data, (unsigned)mShaderDefines.size());
+		for (auto& define : mShaderDefines) {
+			WriteString(data, define.GetName());
+			WriteString(data, define.GetValue());
+		}
+		WritePodVector(data, mSystemTextures);
+		WritePod(data, (unsigned)mTextures.size());
+		for (auto& texture : mTextures) {
+			WriteString(data, texture.mFilepath);
+			WritePod(data, texture.mShader);
+			WritePod(data, texture.mSlot);
+			WritePod(data, texture.mTextureType);
+			WriteDesc(data, texture.mSamplerDesc);
+			WritePod(data, texture.mFileExists);
+			WritePodVector(data, texture.mColorRampBars);
+		}
+		WritePod(data, mShaders);
+		WriteString(data, mShaderFile);
+		WritePodVector(data, mInputElementDescs);
+		WritePod(data, (unsigned)mSubMaterials.size());
+		for (auto& subMaterial : mSubMaterials) {
+			subMaterial.Write(data);
+		}
+	}
+
+	bool CompiledMaterial::Read(const ByteArray& data, size_t& pos) {
+		bool flags[9];
+		if (!ReadPod(data, pos, mRenderPass) || !ReadPod(data, pos, mPrimitiveTopology) ||
+			!ReadPod(data, pos, flags) || !ReadPod(data, pos, mDebug) ||
+			!ReadDesc(data, pos, mBlendDesc) || !ReadDesc(data, pos, mDepthStencilDesc) ||
+			!ReadDesc(data, pos, mRasterizerDesc) || !ReadPod(data, pos, mMaterialConstants) ||
+			!ReadPodVector(data, pos, mShaderConstants))
+			return false;
+		mTransparent = flags[0];
+		mGlow = flags[1];
+		mNoShadowCast = flags[2];
+		mDoubleSided = flags[3];
+		mInstancing = flags[4];
+		mResetRasterizer = flags[5];
+		mResetDepthStencil = flags[6];
+		mResetBlend = flags[7];
+		mResetPrimitiveTopology = flags[8];
+
+		unsigned num;
+		if (!ReadPod(data, pos, num))
+			return false;
+		mShaderDefines.clear();
+		mShaderDefines.reserve(num);
+		for (unsigned i = 0; i < num; ++i) {
+			std::string name, value;
+			if (!ReadString(data, pos, name) || !ReadString(data, pos, value))
+				return false;
+			mShaderDefines.push_back(ShaderDefine(name.c_str(), value.c_str()));
+		}
+		if (!ReadPodVector(data, pos, mSystemTextures) || !ReadPod(data, pos, num))
+			return false;
+		mTextures.clear();
+		mTextures.resize(num);
+		for (auto& texture : mTextures) {
+			if (!ReadString(data, pos, texture.mFilepath) || !ReadPod(data, pos, texture.mShader) ||
+				!ReadPod(data, pos, texture.mSlot) || !ReadPod(data, pos, texture.mTextureType) ||
+				!ReadDesc(data, pos, texture.mSamplerDesc) || !ReadPod(data, pos, texture.mFileExists) ||
+				!ReadPodVector(data, pos, texture.mColorRampBars))
+				return false;
+		}
+		if (!ReadPod(data, pos, mShaders) || !ReadString(data, pos, mShaderFile) ||
+			!ReadPodVector(data, pos, mInputElementDescs) || !ReadPod(data, pos, num))
+			return false;
+		mSubMaterials.clear();
+		mSubMaterials.resize(num);
+		for (auto& subMaterial : mSubMaterials) {
+			if (!subMaterial.Read(data, pos))
+				return false;
+		}
+		return true;
+	}
+
+	UINT64 CompiledMaterial::Hash() const {
+		ByteArray data;
+		Write(data);
+		return hash64((const char*)&data[0], (int)data.size());
+	}
+
+	bool CompiledMaterial::DependenciesExist() const {
+		for (auto& texture : mTextures) {
+			if (texture.mFileExists && !FileSystem::ResourceExists(texture.mFilepath.c_str()))
+				return false;
+		}
+		for (auto& subMaterial : mSubMaterials) {
+			if (!subMaterial.DependenciesExist())
+				return false;
+		}
+		return true;
+	}
+
+	void CompiledMaterial::GetShaderPermutations(std::vector<ShaderPermutation>& out) const {
+		SHADER_DEFINES sortedDefines(mShaderDefines);
+		std::sort(sortedDefines.begin(), sortedDefines.end());
+		auto shaderFiles = Split(mShaderFile.c_str());
+		if (!shaderFiles.empty()) {
+			if (!shaderFiles[0].empty()) {
+				// Renderer creates these types from a single shader file.
+				static const SHADER_TYPE types[] = { SHADER_TYPE_VS, SHADER_TYPE_GS, SHADER_TYPE_PS, SHADER_TYPE_CS };
+				for (auto type : types) {
+					if (mShaders & type)
+						out.push_back(ShaderPermutation{ shaderFiles[0], type, sortedDefines });
+				}
+			}
+			else {
+				shaderFiles.erase(shaderFiles.begin());
+				for (int i = 0; i < SHADER_TYPE_COUNT && i < (int)shaderFiles.size(); ++i) {
+					if (!shaderFiles[i].empty())
+						out.push_back(ShaderPermutation{ shaderFiles[i], ShaderType(i), sortedDefines });
+				}
+			}
+		}
+		for (auto& subMaterial : mSubMaterials) {
+			subMaterial.GetShaderPermutations(out);
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	std::string CompiledMaterial::GetCachePath(const char* materialPath) {
+		std::string path(materialPath);
+		ToLowerCase(path);
+		return FileSystem::GetAppDataLocalGameFolder() + path + ".materialcache";
+	}
+
+	CompiledMaterial::SourceStamp::SourceStamp()
+		: mModifiedTime(0)
+		, mSize(0)
+		, mHash(0)
+	{
+	}
+
+	CompiledMaterial::SourceStamp CompiledMaterial::GetSourceStamp(const char* materialPath) {
+		SourceStamp stamp;
+		auto path = FileSystem::GetResourcePathIfPathNotExists(materialPath);
+		if (FileSystem::Exists(path.c_str()) && !FileSystem::ExistsInFba(path.c_str())) {
+			stamp.mModifiedTime = (INT64)FileSystem::GetLastModified(path.c_str());
+			stamp.mSize = FileSystem::GetFileSize(path.c_str());
+		}
+		return stamp;
+	}
+
+	UINT64 CompiledMaterial::HashSource(const std::string& materialText) {
+		if (materialText.empty())
+			return 0;
+		return hash64(materialText.c_str(), (int)materialText.size());
+	}
+
+	bool CompiledMaterial::LoadCache(const char* materialPath, const SourceStamp& stamp, CompiledMaterial& out) {
+		auto cachePath = GetCachePath(materialPath);
+		if (!FileSystem::Exists(cachePath.c_str()))
+			return false;
+		auto data = FileSystem::ReadBinaryFile(cachePath.c_str());
+		size_t pos = 0;
+		char mark[2];
+		unsigned version;
+		SourceStamp cached;
+		if (!ReadPod(data, pos, mark) || memcmp(mark, material_cache_mark, 2) != 0 ||
+			!ReadPod(data, pos, version) || version != fbmaterial_cache_version ||
+			!ReadPod(data, pos, cached.mModifiedTime) || !ReadPod(data, pos, cached.mSize) ||
+			!ReadPod(data, pos, cached.mHash))
+			return false;
+		bool sameFile = stamp.mModifiedTime != 0 &&
+			stamp.mModifiedTime == cached.mModifiedTime && stamp.mSize == cached.mSize;
+		bool sameContent = stamp.mHash != 0 && stamp.mHash == cached.mHash;
+		if (!sameFile && !sameContent)
+			return false;
+
+		CompiledMaterial compiled;
+		if (!compiled.Read(data, pos) || pos != data.size()) {
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Material cache(%s) is corrupted.", cachePath.c_str()).c_str());
+			return false;
+		}
+		if (!compiled.DependenciesExist())
+			return false;
+		out = std::move(compiled);
+		return true;
+	}
+
+	bool CompiledMaterial::SaveCache(const char* materialPath, const SourceStamp& stamp, const CompiledMaterial& compiled) {
+		ByteArray data;
+		data.reserve(4096);
+		WritePod(data, material_cache_mark);
+		WritePod(data, (unsigned)fbmaterial_cache_version);
+		WritePod(data, stamp.mModifiedTime);
+		WritePod(data, stamp.mSize);
+		WritePod(data, stamp.mHash);
+		compiled.Write(data);
+		auto cachePath = GetCachePath(materialPath);
+		FileSystem::CreateDirectory(cachePath.c_str());
+		return FileSystem::WriteBinaryFile(cachePath.c_str(), data);
+	}
+
+	bool CompiledMaterial::Load(const char* materialPath, bool useCache, CompiledMaterial& out) {
+		if (!ValidCString(materialPath)) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return false;
+		}
+		// An unchanged file is not read at all. A file which was only touched
+		// is read and hashed, and its cache gets the new stamp.
+		SourceStamp stamp;
+		if (useCache) {
+			stamp = GetSourceStamp(materialPath);
+			if (LoadCache(materialPath, stamp, out))
+				return true;
+		}
+		FileSystem::Open file(materialPath, "r", FileSystem::ReadAllow, FileSystem::PrintErrorMsg);
+		auto& text = file.GetTextData();
+		useCache = useCache && !text.empty();
+		if (useCache) {
+			stamp.mHash = HashSource(text);
+			if (LoadCache(materialPath, stamp, out)) {
+				SaveCache(materialPath, stamp, out);
+				return true;
+			}
+		}
+
+		auto pdoc = std::make_shared<tinyxml2::XMLDocument>();
+		pdoc->Parse(text.c_str());
+		if (pdoc->Error())
+		{
+			useCache = false;
+			if (text.empty())
+			{
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Material(%s) not found.", materialPath).c_str());
+			}
+			else{
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to load a Material(%s)", materialPath).c_str());
+				const char* errMsg = pdoc->GetErrorStr1();
+				if (errMsg)
+					Logger::Log("\t%s\n", errMsg);
+				errMsg = pdoc->GetErrorStr2();
+				if (errMsg)
+					Logger::Log("\t%s\n", errMsg);
+			}
+			pdoc = FileSystem::LoadXml("EssentialEngineData/materials/missing.material");
+			if (pdoc->Error())
+			{
+				Logger::Log(FB_ERROR_LOG_ARG, "Loading the fallback material is also failed.");
+				return false;
+			}
+		}
+
+		tinyxml2::XMLElement* pRoot = pdoc->FirstChildElement("Material");
+		if (!pRoot)
+		{
+			assert(0);
+			return false;
+		}
+		out.ParseXml(pRoot, materialPath);
+		if (useCache)
+			SaveCache(materialPath, stamp, out);
+		return true;
+	}
+
+	bool CompiledMaterial::CompileToCache(const char* materialPath) {
+		if (!ValidCString(materialPath)) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return false;
+		}
+		FileSystem::Open file(materialPath, "r", FileSystem::ReadAllow, FileSystem::PrintErrorMsg);
+		auto& text = file.GetTextData();
+		if (text.empty())
+			return false;
+		tinyxml2::XMLDocument doc;
+		doc.Parse(text.c_str());
+		auto pRoot = doc.FirstChildElement("Material");
+		if (doc.Error() || !pRoot) {
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to compile a Material(%s)", materialPath).c_str());
+			return false;
+		}
+		CompiledMaterial compiled;
+		compiled.ParseXml(pRoot, materialPath);
+		auto stamp = GetSourceStamp(materialPath);
+		stamp.mHash = HashSource(text);
+		return SaveCache(materialPath, stamp, compiled);
+	}
+
+	unsigned CompiledMaterial::CompileDirectoryToCache(const char* directory, bool recursive) {
+		auto it = FileSystem::GetDirectoryIterator(directory, recursive);
+		if (!it)
+			return 0;
+		unsigned num = 0;
+		while (it->HasNext()) {
+			bool isDirectory = false;
+			const char* filepath = it->GetNextFilePath(&isDirectory);
+			if (!isDirectory && FileSystem::HasExtension(filepath, ".material") &&
+				CompileToCache(filepath))
+			{
+				++num;
+			}
+		}
+		return num;
+	}
+}
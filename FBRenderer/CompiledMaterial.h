@@ -0,0 +1,145 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "RendererEnums.h"
+#include "RendererStructs.h"
+#include "RenderPass.h"
+#include "ShaderDefines.h"
+#include "InputElementDesc.h"
+#include "SystemTextures.h"
+#include "FBMathLib/Math.h"
+#include "EssentialEngineData/shaders/Constants.h"
+namespace tinyxml2{
+	class XMLElement;
+}
+namespace fb{
+	/** Material description resolved from a .material file.
+	Render state descriptors, constants, shader settings and texture references
+	are stored as they will be applied to the Material, so the compiled data
+	can be written to the material cache and loaded with a single read instead
+	of parsing the xml again.
+	*/
+	struct CompiledMaterial{
+		struct TextureDesc{
+			TextureDesc();
+			/// Resolved path. Empty for color ramp textures.
+			std::string mFilepath;
+			SHADER_TYPE mShader;
+			int mSlot;
+			int mTextureType;
+			SAMPLER_DESC mSamplerDesc;
+			/// position, color pairs for TEXTURE_TYPE_COLOR_RAMP
+			std::vector< std::pair<float, Vec4f> > mColorRampBars;
+			/// Whether mFilepath existed when compiled.
+			bool mFileExists;
+		};
+
+		/// A shader the material creates when applied.
+		struct ShaderPermutation{
+			std::string mFilepath;
+			SHADER_TYPE mShaderType;
+			/// sorted
+			SHADER_DEFINES mDefines;
+		};
+
+		CompiledMaterial();
+
+		RENDER_PASS mRenderPass;
+		PRIMITIVE_TOPOLOGY mPrimitiveTopology;
+		bool mTransparent;
+		bool mGlow;
+		bool mNoShadowCast;
+		bool mDoubleSided;
+		bool mInstancing;
+		bool mResetRasterizer;
+		bool mResetDepthStencil;
+		bool mResetBlend;
+		bool mResetPrimitiveTopology;
+		int mDebug;
+		BLEND_DESC mBlendDesc;
+		DEPTH_STENCIL_DESC mDepthStencilDesc;
+		RASTERIZER_DESC mRasterizerDesc;
+		MATERIAL_CONSTANTS mMaterialConstants;
+		std::vector< std::pair<unsigned, Vec4f> > mShaderConstants;
+		SHADER_DEFINES mShaderDefines;
+		std::vector<SystemTextures::Enum> mSystemTextures;
+		std::vector<TextureDesc> mTextures;
+		int mShaders; // combination of enum SHADER_TYPE;
+		std::string mShaderFile;
+		INPUT_ELEMENT_DESCS mInputElementDescs;
+		std::vector<CompiledMaterial> mSubMaterials;
+
+		/// \param materialPath used to find textures relative to the material file.
+		/// Can be empty.
+		void ParseXml(tinyxml2::XMLElement* pRoot, const char* materialPath);
+		void Write(ByteArray& data) const;
+		bool Read(const ByteArray& data, size_t& pos);
+		/// Hash of the compiled data. Materials having the same hash share
+		/// their data.
+		UINT64 Hash() const;
+		/// false if a referenced texture file is removed after compiled.
+		bool DependenciesExist() const;
+		/// Collects the shaders of this material and the sub materials in the
+		/// way Material creates them.
+		void GetShaderPermutations(std::vector<ShaderPermutation>& out) const;
+
+		//---------------------------------------------------------------------------
+		// Material Cache
+		//---------------------------------------------------------------------------
+		/// Cache files are written in the local app data folder with the stamp of
+		/// the .material file. Changing the file invalidates its cache.
+		static std::string GetCachePath(const char* materialPath);
+		/// Identifies the .material file a cache was compiled from.
+		struct SourceStamp{
+			SourceStamp();
+			/// 0 when the file is packed.
+			INT64 mModifiedTime;
+			UINT64 mSize;
+			/// Content hash. 0 when not computed.
+			UINT64 mHash;
+		};
+		/// Modified time and size. The content hash is left 0.
+		static SourceStamp GetSourceStamp(const char* materialPath);
+		static UINT64 HashSource(const std::string& materialText);
+		/// Valid when the cache has the same modified time and size, or the
+		/// same content hash as \a stamp.
+		static bool LoadCache(const char* materialPath, const SourceStamp& stamp, CompiledMaterial& out);
+		static bool SaveCache(const char* materialPath, const SourceStamp& stamp, const CompiledMaterial& compiled);
+		/// Reads the .material file and compiles it unless \a useCache is true
+		/// and the valid cache exists. Falls back to the missing material.
+		/// Doesn't create any renderer resources, so it can be called on worker
+		/// threads holding FileSystem::Lock.
+		static bool Load(const char* materialPath, bool useCache, CompiledMaterial& out);
+		/// Compiles the .material file into the cache without creating any
+		/// renderer resources. Can be used offline to prepare the cache.
+		static bool CompileToCache(const char* materialPath);
+		/// Compiles every .material file in the directory.
+		/// \return number of compiled materials.
+		static unsigned CompileDirectoryToCache(const char* directory, bool recursive);
+	};
+}
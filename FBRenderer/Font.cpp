@@ -34,6 +34,8 @@
 #include "InputLayout.h"
 #include "Material.h"
 #include "TextureAtlas.h"
+#include "GlyphAtlas.h"
+#include "IPlatformTexture.h"
 #include "RendererOptions.h"
 #include "Shader.h"
 #include "ResourceProvider.h"
@@ -120,6 +122,14 @@ const unsigned int Font::MAX_BATCH = 4 * 2000;
 
 class Font::Impl{
 public:
+	/// Pixel height a TrueType font is loaded in. Reported by GetFontSize().
+	static const int TrueTypeDefaultPixelHeight = 20;
+
+	struct StrikeInfo{
+		int mStrike;
+		GlyphFontMetrics mMetrics;
+	};
+
 	bool mInitialized;
 	std::string mFilePath;
 	FontWeakPtr mSelf;
@@ -147,6 +157,17 @@ public:
 	TextureAtlasPtr mTextureAtlas;
 	float mFixedWidth;
 	float mFixedWidthStart;
+	// TrueType fonts are rasterized by the GlyphAtlas in the exact pixel
+	// height instead of scaling. mFontSize, mFontHeight and mBase are of the
+	// current strike and mScale stays 1.
+	bool mTrueType;
+	GlyphAtlasWeakPtr mGlyphAtlas;
+	std::map<int, StrikeInfo> mStrikes;
+	int mStrike;
+	short mDefaultFontSize;
+	short mDefaultFontHeight;
+	// GetChar() result for TrueType fonts. Valid until the next call.
+	SCharDescr mGlyphChar;
 
 	//---------------------------------------------------------------------------
 	Impl()
@@ -164,6 +185,10 @@ public:
 		, mFontSize(0)
 		, mFixedWidth(0)
 		, mFixedWidthStart(0)
+		, mTrueType(false)
+		, mStrike(-1)
+		, mDefaultFontSize(0)
+		, mDefaultFontHeight(0)
 	{}
 
 	~Impl(){
@@ -182,21 +207,26 @@ public:
 			return 0;
 		mFilePath = fontFile;
 		Profiler profiler("'Font Init'");
-		// Load the font		
-		FileSystem::Open f(fontFile, "rb");
-		auto err = f.Error();
-		if (err)
-		{
-			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to open a font file(%s).", fontFile).c_str());
-			return -1;
+		int r = 0;
+		if (FileSystem::HasExtension(fontFile, ".ttf") || FileSystem::HasExtension(fontFile, ".otf")){
+			r = InitTrueType();
+			if (r)
+				return r;
 		}
+		else{
+			// Load the font		
+			FileSystem::Open f(fontFile, "rb");
+			auto err = f.Error();
+			if (err)
+			{
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to open a font file(%s).", fontFile).c_str());
+				return -1;
+			}
 
-		// Determine format by reading the first bytes of the file
-		char str[4] = { 0 };
-		fread(str, 3, 1, f);
-		fseek(f, 0, SEEK_SET);
-		int r = 0;
-		{
+			// Determine format by reading the first bytes of the file
+			char str[4] = { 0 };
+			fread(str, 3, 1, f);
+			fseek(f, 0, SEEK_SET);
 			Profiler profiler("'Font loding'");
 			FontLoader *loader = 0;
 			if (strcmp(str, "BMF") == 0)
@@ -240,6 +270,50 @@ public:
 		return r;
 	}
 
+	int InitTrueType(){
+		auto atlas = Renderer::GetInstance().GetGlyphAtlas();
+		if (!atlas)
+			return -1;
+		mTrueType = true;
+		mGlyphAtlas = atlas;
+		mScaleW = mScaleH = (short)atlas->GetPageSize();
+		mStrikes.clear();
+		if (!SetPixelHeight(TrueTypeDefaultPixelHeight)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to load a TrueType font(%s).", mFilePath.c_str()).c_str());
+			return -1;
+		}
+		mDefaultFontSize = mFontSize;
+		mDefaultFontHeight = mFontHeight;
+		mDefChar = SCharDescr();
+		mDefChar.chnl = 0;
+		return 0;
+	}
+
+	/// Switches the strike of the TrueType font.
+	bool SetPixelHeight(int pixelHeight){
+		auto atlas = mGlyphAtlas.lock();
+		if (!atlas)
+			return false;
+		pixelHeight = std::min(std::max(pixelHeight, 1), atlas->GetPageSize() / 2);
+		auto it = mStrikes.find(pixelHeight);
+		if (it == mStrikes.end()){
+			StrikeInfo info;
+			if (!Renderer::GetInstance().GetGlyphFontMetrics(mFilePath.c_str(), pixelHeight, info.mMetrics))
+				return false;
+			info.mStrike = atlas->GetStrike(mFilePath.c_str(), pixelHeight);
+			if (info.mStrike == -1)
+				return false;
+			it = mStrikes.insert(std::make_pair(pixelHeight, info)).first;
+		}
+		mStrike = it->second.mStrike;
+		mFontSize = (short)pixelHeight;
+		mFontHeight = (short)it->second.mMetrics.mLineHeight;
+		mBase = (short)it->second.mMetrics.mBase;
+		mScale = 1.0f;
+		mScaledFontHeight = mFontHeight;
+		return true;
+	}
+
 	int Reload(){
 		if (!mInitialized)
 			return -1;
@@ -568,7 +642,17 @@ public:
 			return;
 
 		auto& renderer = Renderer::GetInstance();
-		mPages[page]->Bind(SHADER_TYPE_PS, 0);
+		if (mTrueType){
+			auto atlas = mGlyphAtlas.lock();
+			auto texture = atlas ? atlas->GetPageTexture(page) : 0;
+			// no glyph is uploaded yet.
+			if (!texture)
+				return;
+			texture->Bind(SHADER_TYPE_PS, 0);
+		}
+		else{
+			mPages[page]->Bind(SHADER_TYPE_PS, 0);
+		}
 		MapData data = mVertexBuffer->Map(0, MAP_TYPE_WRITE_DISCARD, MAP_FLAG_NONE);
 		FontVertex* pDest = (FontVertex*)data.pData;
 		memcpy(pDest + mVertexLocation, pVertices + mVertexLocation,
@@ -616,6 +700,10 @@ public:
 		if (mFontSize == 0){
 			return;
 		}
+		if (mTrueType){
+			SetPixelHeight(desiredSize);
+			return;
+		}
 		mScale = desiredSize / (Real)mFontSize;
 		mScaledFontHeight = mFontHeight * mScale;
 	}
@@ -624,13 +712,22 @@ public:
 		if (mFontSize == 0){
 			return;
 		}
+		if (mTrueType){
+			if (mDefaultFontHeight > 0)
+				SetPixelHeight(Round(desiredHeight * mDefaultFontSize / mDefaultFontHeight));
+			return;
+		}
 		mScale = desiredHeight / (Real)mFontHeight;
 		mScaledFontHeight = desiredHeight;
 	}
 
 	//----------------------------------------------------------------------------
+	int GetFontSize() const{
+		return mTrueType ? mDefaultFontSize : mFontSize;
+	}
+
 	Real GetOriginalHeight() const{
-		return mFontHeight;
+		return mTrueType ? mDefaultFontHeight : mFontHeight;
 	}
 
 	Real GetHeight() const
@@ -894,6 +991,8 @@ public:
 	//----------------------------------------------------------------------------
 	int AdjustForKerningPairs(int first, int second)
 	{
+		if (mTrueType)
+			return 0;
 		SCharDescr *ch = GetChar(first);
 		if (ch == 0) return 0;
 		for (UINT n = 0; n < ch->kerningPairs.size(); n += 2)
@@ -910,12 +1009,41 @@ public:
 	//----------------------------------------------------------------------------
 	SCharDescr *GetChar(int id)
 	{
+		if (mTrueType)
+			return GetGlyphChar(id);
 		std::map<int, SCharDescr*>::iterator it = mChars.find(id);
 		if (it == mChars.end()) return 0;
 
 		return it->second;
 	}
 
+	/// Glyphs being rasterized are invisible and have an estimated advance.
+	SCharDescr* GetGlyphChar(int id)
+	{
+		auto atlas = mGlyphAtlas.lock();
+		if (!atlas)
+			return 0;
+		GlyphAtlas::Glyph glyph;
+		auto& ch = mGlyphChar;
+		if (atlas->GetGlyph(mStrike, id, glyph)){
+			ch.srcX = (short)glyph.mX;
+			ch.srcY = (short)glyph.mY;
+			ch.srcW = (short)glyph.mWidth;
+			ch.srcH = (short)glyph.mHeight;
+			ch.xOff = (short)glyph.mXOffset;
+			ch.yOff = (short)glyph.mYOffset;
+			ch.xAdv = (short)glyph.mXAdvance;
+		}
+		else{
+			ch.srcX = ch.srcY = ch.srcW = ch.srcH = 0;
+			ch.xOff = ch.yOff = 0;
+			ch.xAdv = mFontSize / 2;
+		}
+		ch.page = (short)glyph.mPage;
+		ch.chnl = 0;
+		return &ch;
+	}
+
 	//----------------------------------------------------------------------------
 	int GetTextChar(const char *text, int pos, int *nextPos=0)
 	{
@@ -1084,7 +1212,7 @@ void Font::Write(Real x, Real y, Real z, unsigned int color,
 }
 
 int Font::GetFontSize() const{
-	return mImpl->mFontSize;
+	return mImpl->GetFontSize();
 }
 
 void Font::ScaleFontSizeTo(int desiredSize){
@@ -0,0 +1,539 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "GlyphAtlas.h"
+#include "IPlatformRenderer.h"
+#include "IPlatformTexture.h"
+#include "FBThread/TaskScheduler.h"
+#include "FBThread/Task.h"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+using namespace fb;
+
+namespace{
+	struct Strike{
+		std::string mFontPath;
+		int mPixelHeight;
+		int mPage;
+	};
+
+	struct Shelf{
+		int mY;
+		int mHeight;
+		// where the next glyph goes
+		int mX;
+		unsigned mLastUsed;
+		std::vector<UINT64> mGlyphs;
+	};
+
+	struct Page{
+		// RGBA. White with the coverage in alpha as the font shader expects.
+		ByteArray mPixels;
+		std::vector<Shelf> mShelves;
+		int mNextShelfY;
+		unsigned mNumStrikes;
+		IPlatformTexturePtr mTexture;
+		bool mDirty;
+	};
+
+	struct ResidentGlyph{
+		GlyphAtlas::Glyph mGlyph;
+		// -1 for blank glyphs which take no space.
+		int mShelf;
+	};
+
+	struct GlyphRequest{
+		UINT64 mKey;
+		std::string mFontPath;
+		int mPixelHeight;
+		unsigned mCodePoint;
+	};
+
+	struct RasterizedGlyph{
+		UINT64 mKey;
+		bool mSucceeded;
+		GlyphBitmap mBitmap;
+	};
+
+	UINT64 GetGlyphKey(int strike, unsigned codePoint){
+		return ((UINT64)strike << 32) | codePoint;
+	}
+
+	int GetStrikeFromKey(UINT64 key){
+		return (int)(key >> 32);
+	}
+
+	int RoundUp(int value, int multiple){
+		return (value + multiple - 1) / multiple * multiple;
+	}
+}
+
+//---------------------------------------------------------------------------
+class GlyphAtlas::Impl{
+public:
+	class RasterizeTask : public Task{
+		Impl* mAtlas;
+		IPlatformRenderer* mPlatformRenderer;
+		std::vector<GlyphRequest> mRequests;
+
+	public:
+		RasterizeTask(Impl* atlas, IPlatformRenderer* platformRenderer,
+			std::vector<GlyphRequest>&& requests)
+			: Task(true)
+			, mAtlas(atlas)
+			, mPlatformRenderer(platformRenderer)
+			, mRequests(std::move(requests))
+		{
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE{
+			mAtlas->Rasterize(*mPlatformRenderer, mRequests);
+		}
+	};
+
+	int mPageSize;
+	unsigned mMaxPages;
+
+	// protected by mMutex
+	std::mutex mMutex;
+	std::vector<RasterizedGlyph> mRasterized;
+
+	// The atlas is used from the main thread. Only rasterizing runs on workers.
+	std::vector<Strike> mStrikes;
+	std::unordered_map<std::string, int> mStrikeIds;
+	std::vector<Page> mPages;
+	std::unordered_map<UINT64, ResidentGlyph> mGlyphs;
+	// requested glyphs not packed yet
+	std::unordered_set<UINT64> mPending;
+	std::vector<GlyphRequest> mRequests;
+	// rasterized glyphs waiting for a shelf to be evicted.
+	std::vector<RasterizedGlyph> mWaitingSpace;
+	std::vector<TaskPtr> mTasks;
+	unsigned mFrame;
+	unsigned mNumRasterized;
+	unsigned mNumEvicted;
+	unsigned mNumUploads;
+
+	//---------------------------------------------------------------------------
+	Impl(int pageSize, unsigned maxPages)
+		: mPageSize(pageSize)
+		, mMaxPages(std::max(maxPages, 1u))
+		, mFrame(0)
+		, mNumRasterized(0)
+		, mNumEvicted(0)
+		, mNumUploads(0)
+	{
+	}
+
+	~Impl(){
+		Sync();
+	}
+
+	int GetStrike(const char* fontPath, int pixelHeight){
+		if (!ValidCString(fontPath) || pixelHeight <= 0){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return -1;
+		}
+		auto name = FormatString("%s:%d", fontPath, pixelHeight);
+		auto it = mStrikeIds.find(name);
+		if (it != mStrikeIds.end())
+			return it->second;
+
+		Strike strike;
+		strike.mFontPath = fontPath;
+		strike.mPixelHeight = pixelHeight;
+		strike.mPage = GetPageForNewStrike();
+		++mPages[strike.mPage].mNumStrikes;
+		int id = (int)mStrikes.size();
+		mStrikes.push_back(strike);
+		mStrikeIds[name] = id;
+		return id;
+	}
+
+	// A new page until the limit. Then the page shared by the least strikes.
+	int GetPageForNewStrike(){
+		if (mPages.size() >= mMaxPages){
+			int best = 0;
+			for (int i = 1; i < (int)mPages.size(); ++i){
+				if (mPages[i].mNumStrikes < mPages[best].mNumStrikes ||
+					(mPages[i].mNumStrikes == mPages[best].mNumStrikes &&
+					mPages[i].mNextShelfY < mPages[best].mNextShelfY))
+				{
+					best = i;
+				}
+			}
+			return best;
+		}
+
+		mPages.push_back(Page());
+		auto& page = mPages.back();
+		page.mPixels.resize(mPageSize * mPageSize * 4);
+		ClearRows(page, 0, mPageSize);
+		page.mNextShelfY = Padding;
+		page.mNumStrikes = 0;
+		page.mDirty = false;
+		return (int)mPages.size() - 1;
+	}
+
+	int GetStrikePage(int strike) const{
+		if (strike < 0 || strike >= (int)mStrikes.size())
+			return -1;
+		return mStrikes[strike].mPage;
+	}
+
+	bool GetGlyph(int strike, unsigned codePoint, Glyph& outGlyph){
+		if (strike < 0 || strike >= (int)mStrikes.size())
+			return false;
+		auto key = GetGlyphKey(strike, codePoint);
+		auto it = mGlyphs.find(key);
+		if (it != mGlyphs.end()){
+			auto& glyph = it->second;
+			if (glyph.mShelf != -1)
+				mPages[glyph.mGlyph.mPage].mShelves[glyph.mShelf].mLastUsed = mFrame;
+			outGlyph = glyph.mGlyph;
+			return true;
+		}
+		if (mPending.insert(key).second){
+			GlyphRequest request;
+			request.mKey = key;
+			request.mFontPath = mStrikes[strike].mFontPath;
+			request.mPixelHeight = mStrikes[strike].mPixelHeight;
+			request.mCodePoint = codePoint;
+			mRequests.push_back(request);
+		}
+		outGlyph = Glyph();
+		outGlyph.mPage = mStrikes[strike].mPage;
+		return false;
+	}
+
+	IPlatformTexturePtr GetPageTexture(int page) const{
+		if (page < 0 || page >= (int)mPages.size())
+			return 0;
+		return mPages[page].mTexture;
+	}
+
+	// Called in worker threads.
+	void Rasterize(IPlatformRenderer& platformRenderer, const std::vector<GlyphRequest>& requests){
+		std::vector<RasterizedGlyph> rasterized(requests.size());
+		for (size_t i = 0; i < requests.size(); ++i){
+			auto& request = requests[i];
+			rasterized[i].mKey = request.mKey;
+			rasterized[i].mSucceeded = platformRenderer.RasterizeGlyph(request.mFontPath.c_str(),
+				request.mPixelHeight, request.mCodePoint, rasterized[i].mBitmap);
+		}
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& glyph : rasterized){
+			mRasterized.push_back(std::move(glyph));
+		}
+	}
+
+	void Update(IPlatformRenderer& platformRenderer){
+		StartRasterizing(platformRenderer);
+
+		std::vector<RasterizedGlyph> rasterized;
+		rasterized.swap(mWaitingSpace);
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (auto& glyph : mRasterized){
+				rasterized.push_back(std::move(glyph));
+			}
+			mRasterized.clear();
+		}
+		for (auto& glyph : rasterized){
+			if (AddGlyph(glyph)){
+				mPending.erase(glyph.mKey);
+				++mNumRasterized;
+			}
+			else{
+				mWaitingSpace.push_back(std::move(glyph));
+			}
+		}
+
+		for (auto& page : mPages){
+			if (page.mDirty)
+				Upload(platformRenderer, page);
+		}
+		++mFrame;
+	}
+
+	void StartRasterizing(IPlatformRenderer& platformRenderer){
+		mTasks.erase(std::remove_if(mTasks.begin(), mTasks.end(), [](const TaskPtr& task){
+			return task->IsExecuted();
+		}), mTasks.end());
+		if (mRequests.empty())
+			return;
+
+		if (!TaskScheduler::HasInstance()){
+			Rasterize(platformRenderer, mRequests);
+			mRequests.clear();
+			return;
+		}
+		for (size_t i = 0; i < mRequests.size(); i += GlyphsPerTask){
+			auto end = std::min(i + GlyphsPerTask, mRequests.size());
+			std::vector<GlyphRequest> requests(mRequests.begin() + i, mRequests.begin() + end);
+			auto task = std::make_shared<RasterizeTask>(this, &platformRenderer, std::move(requests));
+			mTasks.push_back(task);
+			TaskScheduler::GetInstance().AddTask(task);
+		}
+		mRequests.clear();
+	}
+
+	/// Returns false when no space is available in this frame.
+	bool AddGlyph(const RasterizedGlyph& rasterized){
+		auto& strike = mStrikes[GetStrikeFromKey(rasterized.mKey)];
+		auto& bitmap = rasterized.mBitmap;
+		ResidentGlyph glyph;
+		glyph.mShelf = -1;
+		glyph.mGlyph.mPage = strike.mPage;
+		glyph.mGlyph.mXOffset = bitmap.mXOffset;
+		glyph.mGlyph.mYOffset = bitmap.mYOffset;
+		glyph.mGlyph.mXAdvance = bitmap.mXAdvance;
+		bool blank = !rasterized.mSucceeded || bitmap.mWidth <= 0 || bitmap.mHeight <= 0 ||
+			bitmap.mPixels.size() < (size_t)(bitmap.mWidth * bitmap.mHeight);
+		if (!blank && (bitmap.mWidth + Padding * 2 > mPageSize || bitmap.mHeight + Padding * 2 > mPageSize)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Glyph(%s:%d) is bigger than the atlas page.",
+				strike.mFontPath.c_str(), strike.mPixelHeight).c_str());
+			blank = true;
+		}
+		if (blank){
+			mGlyphs[rasterized.mKey] = glyph;
+			return true;
+		}
+
+		auto& page = mPages[strike.mPage];
+		int width = bitmap.mWidth + Padding;
+		int height = bitmap.mHeight + Padding;
+		int shelfIndex = FindShelf(page, width, height);
+		if (shelfIndex == -1)
+			return false;
+
+		auto& shelf = page.mShelves[shelfIndex];
+		glyph.mShelf = shelfIndex;
+		glyph.mGlyph.mX = shelf.mX;
+		glyph.mGlyph.mY = shelf.mY;
+		glyph.mGlyph.mWidth = bitmap.mWidth;
+		glyph.mGlyph.mHeight = bitmap.mHeight;
+		shelf.mX += width;
+		shelf.mLastUsed = mFrame;
+		shelf.mGlyphs.push_back(rasterized.mKey);
+		for (int y = 0; y < bitmap.mHeight; ++y){
+			auto src = &bitmap.mPixels[y * bitmap.mWidth];
+			auto dest = &page.mPixels[((glyph.mGlyph.mY + y) * mPageSize + glyph.mGlyph.mX) * 4];
+			for (int x = 0; x < bitmap.mWidth; ++x){
+				dest[x * 4 + 3] = src[x];
+			}
+		}
+		page.mDirty = true;
+		mGlyphs[rasterized.mKey] = glyph;
+		return true;
+	}
+
+	/// Returns the shelf which has space for \a width x \a height.
+	int FindShelf(Page& page, int width, int height){
+		// a shelf not wasting more than the half of its height.
+		int best = -1;
+		for (int i = 0; i < (int)page.mShelves.size(); ++i){
+			auto& shelf = page.mShelves[i];
+			if (shelf.mHeight >= height && shelf.mHeight <= height * 2 + ShelfGranularity &&
+				shelf.mX + width <= mPageSize &&
+				(best == -1 || shelf.mHeight < page.mShelves[best].mHeight))
+			{
+				best = i;
+			}
+		}
+		if (best != -1)
+			return best;
+
+		// a new shelf
+		int shelfHeight = std::min(RoundUp(height, ShelfGranularity), mPageSize - Padding);
+		if (page.mNextShelfY + shelfHeight <= mPageSize){
+			Shelf shelf;
+			shelf.mY = page.mNextShelfY;
+			shelf.mHeight = shelfHeight;
+			shelf.mX = Padding;
+			shelf.mLastUsed = mFrame;
+			page.mNextShelfY += shelfHeight;
+			page.mShelves.push_back(shelf);
+			return (int)page.mShelves.size() - 1;
+		}
+
+		// any shelf having space
+		for (int i = 0; i < (int)page.mShelves.size(); ++i){
+			auto& shelf = page.mShelves[i];
+			if (shelf.mHeight >= height && shelf.mX + width <= mPageSize &&
+				(best == -1 || shelf.mHeight < page.mShelves[best].mHeight))
+			{
+				best = i;
+			}
+		}
+		if (best != -1)
+			return best;
+
+		// evicts the shelf used least recently. Shelves used in the last frame
+		// are kept not to lose glyphs on the screen.
+		for (int i = 0; i < (int)page.mShelves.size(); ++i){
+			auto& shelf = page.mShelves[i];
+			if (shelf.mHeight >= height && shelf.mLastUsed < mFrame &&
+				(best == -1 || shelf.mLastUsed < page.mShelves[best].mLastUsed ||
+				(shelf.mLastUsed == page.mShelves[best].mLastUsed && shelf.mHeight < page.mShelves[best].mHeight)))
+			{
+				best = i;
+			}
+		}
+		if (best != -1)
+			Evict(page, page.mShelves[best]);
+		return best;
+	}
+
+	void Evict(Page& page, Shelf& shelf){
+		for (auto key : shelf.mGlyphs){
+			mGlyphs.erase(key);
+			++mNumEvicted;
+		}
+		shelf.mGlyphs.clear();
+		shelf.mX = Padding;
+		ClearRows(page, shelf.mY, shelf.mHeight);
+		page.mDirty = true;
+	}
+
+	void ClearRows(Page& page, int y, int numRows){
+		auto start = (unsigned*)&page.mPixels[y * mPageSize * 4];
+		std::fill(start, start + numRows * mPageSize, 0x00ffffff);
+	}
+
+	void Upload(IPlatformRenderer& platformRenderer, Page& page){
+		if (!page.mTexture){
+			page.mTexture = platformRenderer.CreateTexture(&page.mPixels[0], mPageSize, mPageSize,
+				PIXEL_FORMAT_R8G8B8A8_UNORM, 1, BUFFER_USAGE_DYNAMIC, BUFFER_CPU_ACCESS_WRITE,
+				TEXTURE_TYPE_DEFAULT);
+			if (!page.mTexture)
+				return;
+		}
+		else{
+			auto data = page.mTexture->Map(0, MAP_TYPE_WRITE_DISCARD, MAP_FLAG_NONE);
+			if (data.pData){
+				for (int y = 0; y < mPageSize; ++y){
+					memcpy((char*)data.pData + y * data.RowPitch, &page.mPixels[y * mPageSize * 4],
+						mPageSize * 4);
+				}
+			}
+			page.mTexture->Unmap(0);
+		}
+		page.mDirty = false;
+		++mNumUploads;
+	}
+
+	void Sync(){
+		for (auto& task : mTasks){
+			task->Sync();
+		}
+		mTasks.clear();
+	}
+
+	Stats GetStats() const{
+		Stats stats;
+		stats.mNumPages = (unsigned)mPages.size();
+		stats.mNumStrikes = (unsigned)mStrikes.size();
+		stats.mNumGlyphs = (unsigned)mGlyphs.size();
+		stats.mNumPending = (unsigned)mPending.size();
+		stats.mNumRasterized = mNumRasterized;
+		stats.mNumEvicted = mNumEvicted;
+		stats.mNumUploads = mNumUploads;
+		return stats;
+	}
+};
+
+//---------------------------------------------------------------------------
+GlyphAtlas::Glyph::Glyph()
+	: mPage(-1)
+	, mX(0)
+	, mY(0)
+	, mWidth(0)
+	, mHeight(0)
+	, mXOffset(0)
+	, mYOffset(0)
+	, mXAdvance(0)
+{
+}
+
+GlyphAtlas::Stats::Stats()
+	: mNumPages(0)
+	, mNumStrikes(0)
+	, mNumGlyphs(0)
+	, mNumPending(0)
+	, mNumRasterized(0)
+	, mNumEvicted(0)
+	, mNumUploads(0)
+{
+}
+
+GlyphAtlasPtr GlyphAtlas::Create(int pageSize, unsigned maxPages){
+	return GlyphAtlasPtr(new GlyphAtlas(pageSize, maxPages),
+		[](GlyphAtlas* obj){ delete obj; });
+}
+
+GlyphAtlas::GlyphAtlas(int pageSize, unsigned maxPages)
+	: mImpl(new Impl(pageSize, maxPages))
+{
+}
+
+GlyphAtlas::~GlyphAtlas(){
+}
+
+int GlyphAtlas::GetPageSize() const{
+	return mImpl->mPageSize;
+}
+
+int GlyphAtlas::GetStrike(const char* fontPath, int pixelHeight){
+	return mImpl->GetStrike(fontPath, pixelHeight);
+}
+
+int GlyphAtlas::GetStrikePage(int strike) const{
+	return mImpl->GetStrikePage(strike);
+}
+
+bool GlyphAtlas::GetGlyph(int strike, unsigned codePoint, Glyph& outGlyph){
+	return mImpl->GetGlyph(strike, codePoint, outGlyph);
+}
+
+IPlatformTexturePtr GlyphAtlas::GetPageTexture(int page) const{
+	return mImpl->GetPageTexture(page);
+}
+
+void GlyphAtlas::Update(IPlatformRenderer& platformRenderer){
+	mImpl->Update(platformRenderer);
+}
+
+void GlyphAtlas::Sync(){
+	mImpl->Sync();
+}
+
+GlyphAtlas::Stats GlyphAtlas::GetStats() const{
+	return mImpl->GetStats();
+}
@@ -0,0 +1,105 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+namespace fb{
+	class IPlatformRenderer;
+	FB_DECLARE_SMART_PTR(IPlatformTexture);
+	FB_DECLARE_SMART_PTR(GlyphAtlas);
+	/** Glyphs of TrueType fonts rasterized on demand into a few shared textures.
+	A font file in a pixel height is a strike. All glyphs of a strike are packed
+	into the page the strike is assigned to, so a text run written with one
+	strike is drawn in a single batch. Glyphs not resident yet are rasterized
+	in the background and become available after a following Update(). Pages
+	are packed in shelves; when a page is full, the shelf used least recently
+	is evicted.
+	*/
+	class FB_DLL_RENDERER GlyphAtlas{
+		FB_DECLARE_PIMPL_NON_COPYABLE(GlyphAtlas);
+		GlyphAtlas(int pageSize, unsigned maxPages);
+		~GlyphAtlas();
+
+	public:
+		/// A glyph resident in a page. In pixels.
+		struct Glyph{
+			Glyph();
+
+			int mPage;
+			int mX;
+			int mY;
+			int mWidth;
+			int mHeight;
+			/// from the pen position on the top of the line.
+			int mXOffset;
+			int mYOffset;
+			int mXAdvance;
+		};
+
+		struct Stats{
+			Stats();
+
+			unsigned mNumPages;
+			unsigned mNumStrikes;
+			unsigned mNumGlyphs;
+			unsigned mNumPending;
+			unsigned mNumRasterized;
+			unsigned mNumEvicted;
+			unsigned mNumUploads;
+		};
+
+		static const int DefaultPageSize = 1024;
+		static const unsigned DefaultMaxPages = 4;
+		/// Empty pixels between glyphs not to bleed with the linear filtering.
+		static const int Padding = 1;
+		/// Shelf heights are rounded up to this to be reused by similar glyphs.
+		static const int ShelfGranularity = 8;
+		/// Number of glyphs rasterized by one background task.
+		static const unsigned GlyphsPerTask = 32;
+
+		static GlyphAtlasPtr Create(int pageSize, unsigned maxPages);
+
+		int GetPageSize() const;
+		/// Returns the strike of the font file in the pixel height. Created on
+		/// the first call. -1 for invalid args.
+		int GetStrike(const char* fontPath, int pixelHeight);
+		/// Page holding all glyphs of the strike.
+		int GetStrikePage(int strike) const;
+		/// Fills \a outGlyph and marks it used in this frame when resident.
+		/// Otherwise requests rasterizing and returns false with the page of
+		/// the strike in \a outGlyph.
+		bool GetGlyph(int strike, unsigned codePoint, Glyph& outGlyph);
+		/// Null until the first glyph in the page is uploaded.
+		IPlatformTexturePtr GetPageTexture(int page) const;
+		/// Call once per frame in the main thread. Starts rasterizing requested
+		/// glyphs, packs the rasterized ones and uploads the changed pages.
+		void Update(IPlatformRenderer& platformRenderer);
+		/// Waits for the background rasterizing.
+		void Sync();
+		Stats GetStats() const;
+	};
+}
@@ -79,6 +79,12 @@ namespace fb{
 		virtual void SetMinDistToTarget(Real dist) = 0;
 		virtual void SetProportionalMove(bool enable) = 0;
 		virtual size_t ComputeHash() const = 0;
+		/// Small index unique among the living cameras. Indices of the deleted
+		/// cameras are reused.
+		virtual unsigned GetIndex() const = 0;
+		/// Never 0 and different for every camera which got an index, so data
+		/// left in a slot by a deleted camera can be detected.
+		virtual unsigned GetIndexSerial() const = 0;
 		/*
 		virtual Vec2I WorldToScreen(const Vec3& pos) = 0;
 		
@@ -33,6 +33,7 @@
 #include "InputElementDesc.h"
 #include "ShaderConstants.h"
 #include "GraphicDeviceInfo.h"
+#include "IShaderCompiler.h"
 #include <memory>
 
 namespace fb{
@@ -105,10 +106,19 @@ namespace fb{
 		//-------------------------------------------------------------------
 		virtual void SetShaderCacheOption(bool useShaderCache, bool generateCache) = 0;		
 		virtual IPlatformTexturePtr CreateTexture(const char* path, const TextureCreationOption& option) = 0;
+		/// Mip layout the texture would have when created with \a option.
+		/// Returns false when the file cannot be loaded from a sub range of mips.
+		virtual bool GetTextureMipChain(const char* path, const TextureCreationOption& option,
+			TextureMipChain& outMipChain) = 0;
 		// mipLevels 0 for full generated mips.
 		virtual IPlatformTexturePtr CreateTexture(void* data, int width, int height,
 			PIXEL_FORMAT format, int mipLevels, BUFFER_USAGE usage, int  buffer_cpu_access,
 			int texture_type) = 0;		
+		/// Thread safe. Called by the GlyphAtlas from worker threads.
+		virtual bool RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+			GlyphBitmap& outGlyph) = 0;
+		virtual bool GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+			GlyphFontMetrics& outMetrics) = 0;
 		virtual IPlatformVertexBufferPtr CreateVertexBuffer(void* data, unsigned stride,
 			unsigned numVertices, BUFFER_USAGE usage, BUFFER_CPU_ACCESS_FLAG accessFlag) = 0;
 		virtual IPlatformIndexBufferPtr CreateIndexBuffer(void* data, unsigned int numIndices,
@@ -123,6 +133,12 @@ namespace fb{
 			const SHADER_DEFINES& defines, bool ignoreCache) = 0;
 		virtual IPlatformShaderPtr CompileComputeShader(const char* code, const char* entry,
 			const SHADER_DEFINES& defines) = 0;
+		/// Compiler for the ShaderCache. Returns null when not supported.
+		virtual IShaderCompilerPtr GetShaderCompiler() = 0;
+		/// Creates a shader from the bytecode of GetShaderCompiler().
+		/// \param relatedFiles the shader path followed by the included files.
+		virtual IPlatformShaderPtr CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+			const StringVector& relatedFiles) = 0;
 		virtual IPlatformInputLayoutPtr CreateInputLayout(const INPUT_ELEMENT_DESCS& descs,
 			void* shaderByteCode, unsigned size) = 0;
 		virtual IPlatformBlendStatePtr CreateBlendState(const BLEND_DESC& desc) = 0;
@@ -160,6 +176,8 @@ namespace fb{
 		//-------------------------------------------------------------------
 		virtual void Draw(unsigned int vertexCount, unsigned int startVertexLocation) = 0;
 		virtual void DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned startVertexLocation) = 0;		
+		virtual void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+			unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation) = 0;
 		virtual void Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil) = 0;
 		virtual void Clear(Real r, Real g, Real b, Real a) = 0;
 		virtual void ClearDepthStencil(Real z, UINT8 stencil) = 0;
@@ -27,12 +27,14 @@
 
 #include "stdafx.h"
 #include "Material.h"
+#include "CompiledMaterial.h"
 #include "Shader.h"
 #include "InputLayout.h"
 #include "RenderStates.h"
 #include "Renderer.h"
 #include "Texture.h"
 #include "RenderTarget.h"
+#include "RendererOptions.h"
 #include "EssentialEngineData/shaders/Constants.h"
 #include "FBCommonHeaders/CowPtr.h"
 #include "FBDebugLib/DebugLib.h"
@@ -101,6 +103,7 @@ public:
 			, mTransparent(false)
 			, mGlow(false)
 			, mNoShadowCast(false), mDoubleSided(false)
+			, mInstancing(false)
 			, mPrimitiveTopology(PRIMITIVE_TOPOLOGY_UNKNOWN)
 			, mResetRasterizer(false)
 			, mResetDepthStencil(false)
@@ -114,6 +117,7 @@ public:
 				mGlow != other.mGlow ||
 				mNoShadowCast != other.mNoShadowCast ||
 				mDoubleSided != other.mDoubleSided ||
+				mInstancing != other.mInstancing ||
 				*mRenderStates.const_get() != *other.mRenderStates.const_get() ||
 				mPrimitiveTopology != other.mPrimitiveTopology ||
 				mResetRasterizer != other.mResetRasterizer ||
@@ -128,6 +132,7 @@ public:
 		bool mGlow;
 		bool mNoShadowCast;
 		bool mDoubleSided;
+		bool mInstancing;
 		bool mResetRasterizer;
 		bool mResetDepthStencil;
 		bool mResetBlend;
@@ -179,6 +184,18 @@ public:
 	CowPtr<RenderStatesData> mRenderStatesData;
 	CowPtr<ShaderData> mShaderData;
 	std::vector<MaterialWeakPtr> mClonedMaterials;	
+
+	struct LoadedData {
+		CowPtr<MaterialData> mMaterialData;
+		CowPtr<RenderStatesData> mRenderStatesData;
+		CowPtr<ShaderData> mShaderData;
+		std::vector<MaterialPtr> mSubMaterials;
+	};
+	// Data blocks of the loaded materials by the hash of their compiled data.
+	static std::unordered_map<UINT64, LoadedData> sLoadedData;
+	static size_t sLoadedDataPruneSize;
+	// The data blocks can be in sLoadedData and used by other materials.
+	bool mSharesLoadedData;
 	
 	bool mCloned;
 	int mDebug;
@@ -190,6 +207,7 @@ public:
 		, mMaterialData(new MaterialData)
 		, mRenderStatesData(new RenderStatesData)
 		, mShaderData(new ShaderData)				
+		, mSharesLoadedData(false)
 		, mCloned(false)
 		, mDebug(0)
 		//, mMarkNoShaderDefineChanges(false)
@@ -201,6 +219,7 @@ public:
 		, mMaterialData(other.mMaterialData)
 		, mRenderStatesData(other.mRenderStatesData)
 		, mShaderData(other.mShaderData)		
+		, mSharesLoadedData(other.mSharesLoadedData)
 		, mCloned(true)
 		, mDebug(other.mDebug)
 		//, mMarkNoShaderDefineChanges(false)
@@ -214,579 +233,191 @@ public:
 			mShaderData.const_get() != other.mShaderData.const_get() );
 	}
 
-	bool LoadFromFile(const char* filepath)
+	bool LoadFromFile(const char* filepath, bool shareLoadedData)
 	{
 		if (!filepath)
 			return false;
 		mUniqueData->mName = filepath;
-		auto pdoc = FileSystem::LoadXml(filepath);		
-		if (pdoc->Error())
-		{			
-			if (pdoc->ErrorID() == tinyxml2::XML_ERROR_FILE_NOT_FOUND)
-			{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Material(%s) not found.", filepath).c_str());
-			}
-			else{
-				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to load a Material(%s)", filepath).c_str());
-				const char* errMsg = pdoc->GetErrorStr1();
-				if (errMsg)
-					Logger::Log("\t%s\n", errMsg);
-				errMsg = pdoc->GetErrorStr2();
-				if (errMsg)
-					Logger::Log("\t%s\n", errMsg);
-			}			
-			pdoc = FileSystem::LoadXml("EssentialEngineData/materials/missing.material");									
-			if (pdoc->Error())
-			{
-				Logger::Log(FB_ERROR_LOG_ARG, "Loading the fallback material is also failed.");
-				return false;
-			}
-		}
-
-		tinyxml2::XMLElement* pRoot = pdoc->FirstChildElement("Material");
-		if (!pRoot)
-		{
-			assert(0);
+		bool useCache = Renderer::GetInstance().GetRendererOptions()->r_MaterialCache != 0;
+		CompiledMaterial compiled;
+		if (!CompiledMaterial::Load(filepath, useCache, compiled))
 			return false;
-		}
-
-		return LoadFromXml(pRoot, filepath);
+		return Apply(compiled, shareLoadedData);
 	}
 
-	void ParseDepthStencilFace(tinyxml2::XMLElement* elem, DEPTH_STENCILOP_DESC& desc) {
-		const char* sz;
-		sz = elem->Attribute("StencilPassOp");
-		if (sz){
-			desc.SetStencilPassOp(StencilOpFromString(sz));
-		}
-		sz = elem->Attribute("StencilFailOp");
-		if (sz){
-			desc.SetStencilFailOp(StencilOpFromString(sz));
-		}
-
-		sz = elem->Attribute("StencilDepthFailOp");
-		if (sz) {
-			desc.SetStencilDepthFailOp(StencilOpFromString(sz));
-		}
-
-		sz = elem->Attribute("StencilFunc");
-		if (sz){
-			desc.SetStencilFunc(ComparisonFuncFromString(sz));
-		}
+	bool LoadFromCompiled(const char* filepath, const CompiledMaterial& compiled)
+	{
+		if (!filepath)
+			return false;
+		mUniqueData->mName = filepath;
+		return Apply(compiled, true);
 	}
 
-	bool LoadFromXml(tinyxml2::XMLElement* pRoot, const char* filepath)
+	bool LoadFromXml(tinyxml2::XMLElement* pRoot)
 	{
-		const char* sz = pRoot->Attribute("transparent");
-		auto renderStatesData = const_cast<RenderStatesData*>(mRenderStatesData.const_get());
-		if (sz)
-		{
-			renderStatesData->mTransparent = StringConverter::ParseBool(sz);
-		}
-
-		sz = pRoot->Attribute("glow");
-		if (sz)
-		{
-			renderStatesData->mGlow = StringConverter::ParseBool(sz);
-		}
-
-		sz = pRoot->Attribute("noShadowCast");
-		if (sz)
-		{
-			renderStatesData->mNoShadowCast = StringConverter::ParseBool(sz);
-		}
+		CompiledMaterial compiled;
+		compiled.ParseXml(pRoot, mUniqueData->mName.c_str());
+		return Apply(compiled, false);
+	}
 
-		sz = pRoot->Attribute("doubleSided");
-		if (sz)
-		{
-			renderStatesData->mDoubleSided = StringConverter::ParseBool(sz);
-		}
+	/// Materials compiled to the same data share the data blocks instead of
+	/// creating the same ones again. The shared blocks are copied on write
+	/// like the cloned materials. Sub materials are objects, so each material
+	/// gets clones of them.
+	bool ShareLoadedData(UINT64 compiledHash)
+	{
+		auto it = sLoadedData.find(compiledHash);
+		if (it == sLoadedData.end())
+			return false;
+		auto& loaded = it->second;
+		mMaterialData = loaded.mMaterialData;
+		mRenderStatesData = loaded.mRenderStatesData;
+		mShaderData = loaded.mShaderData;
+		CloneSubMaterials(loaded.mSubMaterials, mUniqueData->mSubMaterials);
+		mSharesLoadedData = true;
+		return true;
+	}
 
-		auto ptElem = pRoot->FirstChildElement("PrimitiveTopology");
-		if (ptElem) {
-			sz = ptElem->GetText();
-			if (sz) {
-				renderStatesData->mPrimitiveTopology = PrimitiveTopologyFromString(sz);
-			}
-			auto sz = ptElem->Attribute("ResetAtUnbind");
-			if (sz) {
-				renderStatesData->mResetPrimitiveTopology = StringConverter::ParseBool(sz);
-			}
+	static void CloneSubMaterials(const std::vector<MaterialPtr>& src, std::vector<MaterialPtr>& dest)
+	{
+		dest.clear();
+		dest.reserve(src.size());
+		for (auto& subMaterial : src) {
+			dest.push_back(subMaterial->Clone());
 		}
+	}
 
-		//-----------------------------------------------------------------------------
-		// BlendDesc
-		//-----------------------------------------------------------------------------
-		BLEND_DESC bdesc;
-		auto blendDescElem = pRoot->FirstChildElement("BlendDesc");
-		if (blendDescElem)
-		{
-			sz = blendDescElem->Attribute("BlendEnalbe");
-			if (sz)
-				bdesc.RenderTarget[0].BlendEnable = StringConverter::ParseBool(sz);
-			if (bdesc.RenderTarget[0].BlendEnable)
-			{
-				renderStatesData->mTransparent = true;
-			}
-
-			sz = blendDescElem->Attribute("BlendOp");
-			if (sz)
-				bdesc.RenderTarget[0].BlendOp = BlendOpFromString(sz);
-
-			sz = blendDescElem->Attribute("SrcBlend");
-			if (sz)
-				bdesc.RenderTarget[0].SrcBlend = BlendFromString(sz);
-
-			sz = blendDescElem->Attribute("DestBlend");
-			if (sz)
-				bdesc.RenderTarget[0].DestBlend = BlendFromString(sz);
-			sz = blendDescElem->Attribute("RenderTargetWriteMask");
-			if (sz)
-			{
-				auto options = Split(sz, "|");
-				for (auto& it : options)
+	void RegisterLoadedData(UINT64 compiledHash)
+	{
+		if (sLoadedData.size() >= sLoadedDataPruneSize) {
+			// Drop the data not used by any material.
+			for (auto it = sLoadedData.begin(); it != sLoadedData.end(); /**/) {
+				auto& loaded = it->second;
+				if (loaded.mMaterialData.data().use_count() == 1 &&
+					loaded.mRenderStatesData.data().use_count() == 1 &&
+					loaded.mShaderData.data().use_count() == 1)
 				{
-					it = StripBoth(it.c_str());
+					it = sLoadedData.erase(it);
 				}
-				int mask = 0;
-				for (auto& it : options)
-				{
-					mask += ColorWriteMaskFromString(it.c_str());
+				else {
+					++it;
 				}
-				bdesc.RenderTarget[0].RenderTargetWriteMask = mask;
-			}
-
-			sz = blendDescElem->Attribute("ResetAtUnbind");
-			if (sz) {
-				renderStatesData->mResetBlend= StringConverter::ParseBool(sz);
-			}
-		}
-		else
-		{
-			if (renderStatesData->mTransparent)
-			{
-				bdesc.RenderTarget[0].BlendEnable = true;
-				bdesc.RenderTarget[0].BlendOp = BLEND_OP_ADD;
-				bdesc.RenderTarget[0].SrcBlend = BLEND_SRC_ALPHA;
-				bdesc.RenderTarget[0].DestBlend = BLEND_INV_SRC_ALPHA;
-			}
-		}
-		auto renderStates = const_cast<RenderStates*>(renderStatesData->mRenderStates.const_get());
-		renderStates->CreateBlendState(bdesc);
-		//-----------------------------------------------------------------------------
-		// DepthStencilDesc
-		//-----------------------------------------------------------------------------
-		DEPTH_STENCIL_DESC ddesc;
-		auto depthDescElem = pRoot->FirstChildElement("DepthStencilDesc");
-		if (depthDescElem)
-		{
-			sz = depthDescElem->Attribute("DepthEnable");
-			if (sz)
-				ddesc.SetDepthEnable(StringConverter::ParseBool(sz));
-
-			sz = depthDescElem->Attribute("DepthWriteMask");
-			if (sz)
-				ddesc.SetDepthWriteMask(DepthWriteMaskFromString(sz));
-
-			sz = depthDescElem->Attribute("DepthFunc");
-			if (sz)
-				ddesc.SetDepthFunc(ComparisonFuncFromString(sz));
-
-			sz = depthDescElem->Attribute("ResetAtUnbind");
-			if (sz) {
-				renderStatesData->mResetDepthStencil = StringConverter::ParseBool(sz);
 			}
-
-			sz = depthDescElem->Attribute("StencilEnable");
-			if (sz) {
-				ddesc.SetStencilEnable(StringConverter::ParseBool(sz));
-			}
-
-			sz = depthDescElem->Attribute("StencilReadMask");
-			if (sz) {
-				ddesc.SetStencilReadMask( StringConverter::ParseInt(sz));
-			}
-
-			sz = depthDescElem->Attribute("StencilWriteMask");
-			if (sz) {
-				ddesc.SetStencilWriteMask(StringConverter::ParseInt(sz));
-			}
-			auto frontFaceElem = depthDescElem->FirstChildElement("FrontFace");
-			if (frontFaceElem) {
-				ParseDepthStencilFace(frontFaceElem, ddesc.GetFrontFace());
-			}
-			auto backFaceElem = depthDescElem->FirstChildElement("BackFace");
-			if (backFaceElem) {
-				ParseDepthStencilFace(backFaceElem, ddesc.GetBackFace());
-			}			
-		}
-		else
-		{
-			ddesc.SetDepthWriteMask(renderStatesData->mTransparent ? DEPTH_WRITE_MASK_ZERO : DEPTH_WRITE_MASK_ALL);
+			sLoadedDataPruneSize = std::max((size_t)64, sLoadedData.size() * 2);
 		}
-		renderStates->CreateDepthStencilState(ddesc);
-
-		//-----------------------------------------------------------------------------
-		auto debugElem = pRoot->FirstChildElement("Debug");
-		if (debugElem) {
-			auto szValue = debugElem->Attribute("value");
-			if (szValue) {
-				mDebug = StringConverter::ParseInt(szValue);
-			}
-		}
-
-		//-----------------------------------------------------------------------------
-		// RasterizerDesc
-		//-----------------------------------------------------------------------------
-		RASTERIZER_DESC rdesc;
-		auto rasterizerDescElem = pRoot->FirstChildElement("RasterizerDesc");
-		if (rasterizerDescElem)
-		{
-			sz = rasterizerDescElem->Attribute("FillMode");
-			if (sz)
-				rdesc.SetFillMode(FillModeFromString(sz));
-
-			sz = rasterizerDescElem->Attribute("CullMode");
-			if (sz)
-				rdesc.SetCullMode(CullModeFromString(sz));
-
-			sz = rasterizerDescElem->Attribute("ScissorEnable");
-			if (sz)
-				rdesc.SetScissorEnable(StringConverter::ParseBool(sz));
-
-			sz = rasterizerDescElem->Attribute("DepthBias");
-			if (sz)
-				rdesc.SetDepthBias(StringConverter::ParseInt(sz));
-
-			sz = rasterizerDescElem->Attribute("SlopeScaledDepthBias");
-			if (sz)
-				rdesc.SetSlopeScaledDepthBias(StringConverter::ParseReal(sz));
-
-			sz = rasterizerDescElem->Attribute("FrontCounterClockwise");
-			if (sz)
-				rdesc.SetFrontCounterClockwise(StringConverter::ParseBool(sz));
+		auto& loaded = sLoadedData[compiledHash];
+		// Holding the blocks here makes any modification of the materials
+		// detach them first, so the registered blocks keep the compiled data.
+		loaded.mMaterialData = mMaterialData;
+		loaded.mRenderStatesData = mRenderStatesData;
+		loaded.mShaderData = mShaderData;
+		CloneSubMaterials(mUniqueData->mSubMaterials, loaded.mSubMaterials);
+		mSharesLoadedData = true;
+	}
 
-			sz = rasterizerDescElem->Attribute("ResetAtUnbind");
-			if (sz) {
-				renderStatesData->mResetRasterizer = StringConverter::ParseBool(sz);
-			}
-		}
-		else
-		{
-			rdesc.SetCullMode(renderStatesData->mDoubleSided ? CULL_MODE_NONE : CULL_MODE_BACK);
-		}
-		renderStates->CreateRasterizerState(rdesc);
+	/// Applies the compiled data to the data blocks of this material and its
+	/// clones. The blocks shared through sLoadedData are replaced first.
+	bool Apply(const CompiledMaterial& compiled, bool shareLoadedData)
+	{
+		mDebug = compiled.mDebug;
+		mUniqueData->mRenderPass = compiled.mRenderPass;
+		UINT64 compiledHash = shareLoadedData ? compiled.Hash() : 0;
+		if (compiledHash && ShareLoadedData(compiledHash))
+			return true;
+		// Written in place below, so clones see the new data; but not the
+		// blocks other materials share.
+		if (mSharesLoadedData)
+			DetachLoadedData();
 
-		sz = pRoot->Attribute("pass");
-		if (sz)
-			mUniqueData->mRenderPass = (RENDER_PASS)RenderPassFromString(sz);
+		auto renderStatesData = const_cast<RenderStatesData*>(mRenderStatesData.const_get());
+		renderStatesData->mTransparent = compiled.mTransparent;
+		renderStatesData->mGlow = compiled.mGlow;
+		renderStatesData->mNoShadowCast = compiled.mNoShadowCast;
+		renderStatesData->mInstancing = compiled.mInstancing;
+		renderStatesData->mDoubleSided = compiled.mDoubleSided;
+		renderStatesData->mPrimitiveTopology = compiled.mPrimitiveTopology;
+		renderStatesData->mResetPrimitiveTopology = compiled.mResetPrimitiveTopology;
+		renderStatesData->mResetBlend = compiled.mResetBlend;
+		renderStatesData->mResetDepthStencil = compiled.mResetDepthStencil;
+		renderStatesData->mResetRasterizer = compiled.mResetRasterizer;
+		auto renderStates = const_cast<RenderStates*>(renderStatesData->mRenderStates.const_get());
+		renderStates->CreateBlendState(compiled.mBlendDesc);
+		renderStates->CreateDepthStencilState(compiled.mDepthStencilDesc);
+		renderStates->CreateRasterizerState(compiled.mRasterizerDesc);
 
 		auto materialData = const_cast<MaterialData*>(mMaterialData.const_get());
-		tinyxml2::XMLElement* pMaterialConstants = pRoot->FirstChildElement("MaterialConstants");
-		if (pMaterialConstants)
-		{
-			tinyxml2::XMLElement* pAmbientElem = pMaterialConstants->FirstChildElement("AmbientColor");
-			if (pAmbientElem)
-			{
-				const char* szAmbient = pAmbientElem->GetText();
-				Vec4 ambient(szAmbient);
-				materialData->mMaterialConstants.gAmbientColor = ambient;
-			}
-			tinyxml2::XMLElement* pDiffuseElem = pMaterialConstants->FirstChildElement("DiffuseColor_Alpha");
-			if (pDiffuseElem)
-			{
-				const char* szDiffuse = pDiffuseElem->GetText();
-				Vec4 diffuse(szDiffuse);
-				materialData->mMaterialConstants.gDiffuseColor = diffuse;
-			}
-			tinyxml2::XMLElement* pSpecularElem = pMaterialConstants->FirstChildElement("SpecularColor_Shine");
-			if (pSpecularElem)
-			{
-				const char* szSpecular = pSpecularElem->GetText();
-				Vec4 specular(szSpecular);
-				materialData->mMaterialConstants.gSpecularColor = specular;				
-			}
-			tinyxml2::XMLElement* pEmissiveElem = pMaterialConstants->FirstChildElement("EmissiveColor_Strength");
-			if (pEmissiveElem)
-			{
-				const char* szEmissive = pEmissiveElem->GetText();
-				Vec4 emissive(szEmissive);
-				materialData->mMaterialConstants.gEmissiveColor = emissive;				
-			}
-		}
-
-		tinyxml2::XMLElement* pShaderConstants = pRoot->FirstChildElement("ShaderConstants");		
-		if (pShaderConstants)
-		{
-			materialData->mShaderConstants.clear();
-			tinyxml2::XMLElement* pElem = pShaderConstants->FirstChildElement();
-			int i = 0;
-			while (pElem)
-			{
-				const char* szVector = pElem->GetText();
-				if (szVector)
-				{
-					Vec4 v(szVector);
-					materialData->mShaderConstants.insert(Parameters::value_type(i++, v));
-				}
-				pElem = pElem->NextSiblingElement();
-			}
-		}
-
-		tinyxml2::XMLElement* pDefines = pRoot->FirstChildElement("ShaderDefines");		
-		auto shaderData = const_cast<ShaderData*>(mShaderData.const_get());		
-		if (pDefines)
-		{
-			shaderData->mShaderDefines.clear();
-			shaderData->mShaderDefinesChanged = true;
-			tinyxml2::XMLElement* pElem = pDefines->FirstChildElement();
-			int i = 0;
-			while (pElem)
-			{
-				std::string strName, strValue;
-				const char* pname = pElem->Attribute("name");
-				if (pname)
-					strName = pname;
-				const char* pval = pElem->Attribute("val");
-				if (pval)
-					strValue = pval;
-				
-				shaderData->mShaderDefines.push_back(ShaderDefine(strName.c_str(), strValue.c_str()));
-				pElem = pElem->NextSiblingElement();
-			}
-		}
-
-		tinyxml2::XMLElement* pTexturesElem = pRoot->FirstChildElement("Textures");
-		materialData->mSystemTextures.clear();
-		if (pTexturesElem)
-		{
-			tinyxml2::XMLElement* pTexElem = pTexturesElem->FirstChildElement("Texture");
-			while (pTexElem)
-			{
-				auto sz = pTexElem->Attribute("SystemTexture");
-				if (sz) {
-					auto systemTexture = SystemTextures::ConvertToEnum(sz);
-					if (!ValueExistsInVector(materialData->mSystemTextures, systemTexture))
-						materialData->mSystemTextures.push_back(systemTexture);
-				}
-				else {
-					sz = pTexElem->GetText();
-					std::string filepath = sz ? sz : "";
-					int slot = 0;
-					SHADER_TYPE shader = SHADER_TYPE_PS;
-					SAMPLER_DESC samplerDesc;
-					pTexElem->QueryIntAttribute("slot", &slot);
-					const char* szShader = pTexElem->Attribute("shader");
-					shader = BindingShaderFromString(szShader);
-					const char* szAddressU = pTexElem->Attribute("AddressU");
-					samplerDesc.SetAddressU(AddressModeFromString(szAddressU));
-					const char* szAddressV = pTexElem->Attribute("AddressV");
-					samplerDesc.SetAddressV(AddressModeFromString(szAddressV));
-					const char* szFilter = pTexElem->Attribute("Filter");
-					samplerDesc.SetFilter(FilterFromString(szFilter));
-					TexturePtr pTextureInTheSlot;
-					const char* szType = pTexElem->Attribute("type");
-					int texture_type = TEXTURE_TYPE_DEFAULT;
-					if (szType)
-						texture_type = TextureTypeFromString(szType);
-					ColorRamp cr;
-					if (texture_type & TEXTURE_TYPE_COLOR_RAMP)
-					{
-						tinyxml2::XMLElement* barElem = pTexElem->FirstChildElement("Bar");
-						while (barElem)
-						{
-							float pos = barElem->FloatAttribute("pos");
-							const char* szColor = barElem->GetText();
-							Vec4 color(szColor);
-							cr.InsertBar(pos, color);
-							barElem = barElem->NextSiblingElement();
-						}
-						SetColorRampTexture(cr, shader, slot, samplerDesc, true);
-					}
-					else
-					{
-						if (!filepath.empty() && !FileSystem::ResourceExists(filepath.c_str())) {
-							auto textureFileName = FileSystem::GetFileName(filepath.c_str());
-							std::string materialParentPath = FileSystem::GetParentPath(mUniqueData->mName.c_str());
-							bool stripped = true;
-							do{
-								filepath = FileSystem::StripFirstDirectoryPath(filepath.c_str(), &stripped);
-								std::string alternativePath = materialParentPath + "/" + filepath;
-								if (FileSystem::ResourceExists(alternativePath.c_str())) {
-									filepath = alternativePath;
-									break;
-								}
-							} while (stripped && filepath != textureFileName);
-						}
-						SetTexture(filepath.c_str(), shader, slot, samplerDesc, texture_type, true);
-					}
-				}
-				pTexElem = pTexElem->NextSiblingElement("Texture");
-			}
-		}
-
-		shaderData->mShaders = SHADER_TYPE_VS | SHADER_TYPE_PS;
-		tinyxml2::XMLElement* pShaders = pRoot->FirstChildElement("Shaders");
-		if (pShaders)
-		{
-			const char* szShaders = pShaders->GetText();
-			if (szShaders)
-			{
-				auto& shaders = shaderData->mShaders;
-				shaders = 0;
-				std::string strShaders = szShaders;
-				ToLowerCase(strShaders);
-				if (strShaders.find("vs") != std::string::npos)
-				{
-					shaders |= SHADER_TYPE_VS;
-				}
-				if (strShaders.find("hs") != std::string::npos)
-				{
-					shaders |= SHADER_TYPE_HS;
-				}
-				if (strShaders.find("ds") != std::string::npos)
-				{
-					shaders |= SHADER_TYPE_DS;
-				}
-				if (strShaders.find("gs") != std::string::npos)
-				{
-					shaders |= SHADER_TYPE_GS;
-				}
-				if (strShaders.find("ps") != std::string::npos)
-				{
-					shaders |= SHADER_TYPE_PS;
+		materialData->mMaterialConstants = compiled.mMaterialConstants;
+		materialData->mShaderConstants.clear();
+		for (auto& it : compiled.mShaderConstants) {
+			materialData->mShaderConstants.insert(Parameters::value_type(it.first, it.second));
+		}
+		materialData->mSystemTextures = compiled.mSystemTextures;
+		for (auto& texture : compiled.mTextures) {
+			if (texture.mTextureType & TEXTURE_TYPE_COLOR_RAMP) {
+				ColorRamp cr;
+				for (auto& bar : texture.mColorRampBars) {
+					cr.InsertBar(bar.first, Vec4(bar.second));
 				}
+				SetColorRampTexture(cr, texture.mShader, texture.mSlot, texture.mSamplerDesc, true);
 			}
-		}
-
-		auto& renderer = Renderer::GetInstance();
-		tinyxml2::XMLElement* pShaderFileElem = pRoot->FirstChildElement("ShaderFile");
-		if (pShaderFileElem)
-		{
-			const char* shaderFile = pShaderFileElem->GetText();
-			if (shaderFile)
-			{
-				// INTEGRATED_SHADER,SHADER_TYPE_VS,SHADER_TYPE_HS,SHADER_TYPE_DS,SHADER_TYPE_GS,SHADER_TYPE_PS,SHADER_TYPE_CS		
-				shaderData->mShaderFile = shaderFile;
-				shaderData->mShaderFile += ",,,,,,";
+			else {
+				SetTexture(texture.mFilepath.c_str(), texture.mShader, texture.mSlot, texture.mSamplerDesc,
+					texture.mTextureType, true);
 			}
 		}
-		else {
-			auto& shaders = shaderData->mShaders;
-			shaders = 0;
-			std::string vs, hs, ds, gs, ps, cs;
-			auto shaderFilesElem = pRoot->FirstChildElement("SeperatedShaderFiles");
-			if (shaderFilesElem) {
-				auto elem = shaderFilesElem->FirstChildElement("VSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						vs = sz;
-						shaders |= SHADER_TYPE_VS;
-					}
-				}
-				elem = shaderFilesElem->FirstChildElement("HSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						hs = sz;
-						shaders |= SHADER_TYPE_HS;
-					}
-				}
-				elem = shaderFilesElem->FirstChildElement("DSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						ds = sz;
-						shaders |= SHADER_TYPE_DS;
-					}
-				}
-				elem = shaderFilesElem->FirstChildElement("GSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						gs = sz;
-						shaders |= SHADER_TYPE_GS;
-					}
-				}
-				elem = shaderFilesElem->FirstChildElement("PSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						ps = sz;
-						shaders |= SHADER_TYPE_PS;
-					}
-				}
-				elem = shaderFilesElem->FirstChildElement("CSFile");
-				if (elem) {
-					sz = elem->GetText();
-					if (sz) {
-						cs = sz;
-						shaders |= SHADER_TYPE_CS;
-					}
-				}
-				shaderData->mShaderFile = FormatString("%s,%s,%s,%s,%s,%s,%s",
-					"",
-					vs.c_str(), hs.c_str(), ds.c_str(),
-					gs.c_str(), ps.c_str(), cs.c_str());
-			}
-		}		
-
-		tinyxml2::XMLElement* pInputLayoutElem = pRoot->FirstChildElement("InputLayout");
-		auto& inputElementDesc = shaderData->mInputElementDescs;
-		inputElementDesc.clear();		
-		if (pInputLayoutElem)
-		{
-			shaderData->mInputDescChanged = true;
-			tinyxml2::XMLElement* pElem = pInputLayoutElem->FirstChildElement();
-			int i = 0;
-			while (pElem)
-			{
-				inputElementDesc.push_back(INPUT_ELEMENT_DESC());
-				const char* pbuffer = pElem->Attribute("semantic");
-				if (pbuffer)
-					strcpy_s(inputElementDesc.back().mSemanticName, pbuffer);
-				inputElementDesc.back().mSemanticIndex = pElem->IntAttribute("index");
-
-				pbuffer = pElem->Attribute("format");
-				if (pbuffer)
-				{
-					inputElementDesc.back().mFormat = InputElementFromString(pbuffer);
-				}
-
-				inputElementDesc.back().mInputSlot = pElem->IntAttribute("slot");
 
-				inputElementDesc.back().mAlignedByteOffset = pElem->IntAttribute("alignedByteOffset");
-
-				pbuffer = pElem->Attribute("inputSlotClass");
-				if (pbuffer)
-					inputElementDesc.back().mInputSlotClass = InputClassificationFromString(pbuffer);
-
-				inputElementDesc.back().mInstanceDataStepRate = pElem->IntAttribute("stepRate");
-
-				pElem = pElem->NextSiblingElement();
-			}
-		}
+		auto shaderData = const_cast<ShaderData*>(mShaderData.const_get());
+		shaderData->mShaderDefines = compiled.mShaderDefines;
+		shaderData->mShaderDefinesChanged = true;
+		shaderData->mShaders = compiled.mShaders;
+		shaderData->mShaderFile = compiled.mShaderFile;
+		shaderData->mInputElementDescs = compiled.mInputElementDescs;
+		shaderData->mInputDescChanged = true;
 		ApplyShaderDefines();
 
-		tinyxml2::XMLElement* subMat = pRoot->FirstChildElement("Material");
 		auto& subMaterials = mUniqueData->mSubMaterials;
 		subMaterials.clear();
-		while (subMat)
+		for (auto& subMaterial : compiled.mSubMaterials)
 		{
 			MaterialPtr pMat = Material::Create();
 			subMaterials.push_back(pMat);
-			pMat->LoadFromXml(subMat);
-
-			subMat = subMat->NextSiblingElement("Material");
+			pMat->mImpl->Apply(subMaterial, false);
 		}
 
+		if (compiledHash)
+			RegisterLoadedData(compiledHash);
 		return true;
 	}
 
+	/// Gives new data blocks to this material and the clones still sharing
+	/// the blocks with it. The blocks can be shared with other materials
+	/// having the same compiled data, so they are not modified in place.
+	void DetachLoadedData() {
+		auto materialData = mMaterialData;
+		auto renderStatesData = mRenderStatesData;
+		auto shaderData = mShaderData;
+		mMaterialData = new MaterialData;
+		mRenderStatesData = new RenderStatesData;
+		mShaderData = new ShaderData;
+		mSharesLoadedData = false;
+		for (auto& it : mClonedMaterials) {
+			auto cloned = it.lock();
+			if (!cloned)
+				continue;
+			auto& impl = *cloned->mImpl;
+			if (impl.mMaterialData == materialData)
+				impl.mMaterialData = mMaterialData;
+			if (impl.mRenderStatesData == renderStatesData)
+				impl.mRenderStatesData = mRenderStatesData;
+			if (impl.mShaderData == shaderData)
+				impl.mShaderData = mShaderData;
+		}
+	}
+
 	void Reload() {
-		// cloned materials same with its parent also be affected because of the CowPtr.
-		LoadFromFile(mUniqueData->mName.c_str());
+		// cloned materials same with its parent also be affected.
+		DetachLoadedData();
+		LoadFromFile(mUniqueData->mName.c_str(), false);
 	}
 
 	const char* GetName() const { 
@@ -1093,7 +724,7 @@ public:
 			shaderData->mInputDescChanged = false;
 			auto& renderer = Renderer::GetInstance();
 			if (!shaderData->mInputElementDescs.empty())
-				mShaderData->mInputLayout = renderer.CreateInputLayout(shaderData->mInputElementDescs, shaderData->mShader);
+				shaderData->mInputLayout = renderer.CreateInputLayout(shaderData->mInputElementDescs, shaderData->mShader);
 		}
 	}
 
@@ -1376,6 +1007,14 @@ public:
 		return mRenderStatesData->mDoubleSided;
 	}
 
+	bool IsInstancingSupported() const {
+		return mRenderStatesData->mInstancing;
+	}
+
+	const INPUT_ELEMENT_DESCS& GetInputElementDescs() const {
+		return mShaderData.const_get()->mInputElementDescs;
+	}
+
 	int GetBindingShaders() const { 
 		return mShaderData->mShaders; 
 	}
@@ -1514,6 +1153,9 @@ public:
 	}
 };
 
+std::unordered_map<UINT64, Material::Impl::LoadedData> Material::Impl::sLoadedData;
+size_t Material::Impl::sLoadedDataPruneSize = 64;
+
 //----------------------------------------------------------------------------
 MaterialPtr Material::Create(){
 	auto p = MaterialPtr(FB_NEW(Material), [](Material* obj){ FB_DELETE(obj); });
@@ -1545,11 +1187,15 @@ MaterialPtr Material::Clone() const{
 }
 
 bool Material::LoadFromFile(const char* filepath) {
-	return mImpl->LoadFromFile(filepath);
+	return mImpl->LoadFromFile(filepath, true);
+}
+
+bool Material::LoadFromCompiled(const char* filepath, const CompiledMaterial& compiled) {
+	return mImpl->LoadFromCompiled(filepath, compiled);
 }
 
 bool Material::LoadFromXml(tinyxml2::XMLElement* pRoot) {
-	return mImpl->LoadFromXml(pRoot, "");
+	return mImpl->LoadFromXml(pRoot);
 }
 
 const char* Material::GetName() const {
@@ -1768,6 +1414,18 @@ bool Material::IsDoubleSided() const {
 	return mImpl->IsDoubleSided();
 }
 
+bool Material::IsInstancingSupported() const {
+	return mImpl->IsInstancingSupported();
+}
+
+const INPUT_ELEMENT_DESCS& Material::GetInputElementDescs() const {
+	return mImpl->GetInputElementDescs();
+}
+
+bool Material::IsSameData(const Material& other) const {
+	return *mImpl == *other.mImpl;
+}
+
 int Material::GetBindingShaders() const {
 	return mImpl->GetBindingShaders();
 }
@@ -38,6 +38,7 @@ namespace tinyxml2{
 }
 namespace fb{
 	struct MATERIAL_CONSTANTS;
+	struct CompiledMaterial;
 	FB_DECLARE_SMART_PTR(ColorRamp);
 	FB_DECLARE_SMART_PTR(Texture);
 	FB_DECLARE_SMART_PTR(Material);
@@ -49,6 +50,8 @@ namespace fb{
 	You can clone the material using Material::Clone(). Internal data will be
 	shared among cloned materials on CopyOnWrite manner. i.e. At the time you set new data
 	to the cloned material, the internal data of the material will be copied and be unique.
+	Material files are compiled into the material cache(see CompiledMaterial) and 
+	materials compiled to the same data share the internal data in the same manner.
 	*/
 	class FB_DLL_RENDERER Material{
 		FB_DECLARE_PIMPL(Material);
@@ -70,6 +73,9 @@ namespace fb{
 		~Material();
 		MaterialPtr Clone() const;
 		bool LoadFromFile(const char* filepath);
+		/// Applies the data already compiled from \a filepath.
+		/// See CompiledMaterial::Load()
+		bool LoadFromCompiled(const char* filepath, const CompiledMaterial& compiled);
 		bool LoadFromXml(tinyxml2::XMLElement* pRoot);
 		const char* GetName() const;
 		void SetAmbientColor(float r, float g, float b, float a);
@@ -132,6 +138,13 @@ namespace fb{
 		bool IsGlow() const;
 		bool IsNoShadowCast() const;
 		bool IsDoubleSided() const;				
+		/// Set by the 'instancing' attribute. The shader handles _INSTANCED define
+		/// and reads the world matrix from WORLD0~3 per-instance elements.
+		bool IsInstancingSupported() const;
+		const INPUT_ELEMENT_DESCS& GetInputElementDescs() const;
+		/// True when the materials share every data block; i.e. clones which have
+		/// not been modified since cloned.
+		bool IsSameData(const Material& other) const;
 		int GetBindingShaders() const;
 		void CopyMaterialParamFrom(MaterialConstPtr src);
 		void CopyMaterialConstFrom(MaterialConstPtr src);
@@ -27,8 +27,46 @@
 
 #include "stdafx.h"
 #include "NullPlatformRenderer.h"
+#include "IPlatformTexture.h"
 using namespace fb;
 
+namespace fb{
+	FB_DECLARE_SMART_PTR(NullPlatformTexture);
+	/// Holds only the size of the synthetic texture.
+	class NullPlatformTexture : public IPlatformTexture{
+		Vec2ITuple mSize;
+		size_t mSizeInBytes;
+
+		NullPlatformTexture(const Vec2ITuple& size, size_t sizeInBytes)
+			: mSize(size)
+			, mSizeInBytes(sizeInBytes)
+		{
+		}
+		~NullPlatformTexture(){}
+
+	public:
+		static NullPlatformTexturePtr Create(const Vec2ITuple& size, size_t sizeInBytes){
+			return NullPlatformTexturePtr(new NullPlatformTexture(size, sizeInBytes),
+				[](NullPlatformTexture* obj){ delete obj; });
+		}
+
+		Vec2ITuple GetSize() const OVERRIDE { return mSize; }
+		PIXEL_FORMAT GetPixelFormat() const OVERRIDE { return PIXEL_FORMAT_R8G8B8A8_UNORM; }
+		bool IsReady() const OVERRIDE { return true; }
+		void Bind(SHADER_TYPE shader, int slot) const OVERRIDE {}
+		MapData Map(UINT subResource, MAP_TYPE type, MAP_FLAG flag) const OVERRIDE { return MapData(); }
+		void Unmap(UINT subResource) const OVERRIDE {}
+		void CopyToStaging(IPlatformTexture* dst, UINT dstSubresource,
+			UINT dstX, UINT dstY, UINT dstZ, UINT srcSubresource, Box3D* srcBox) const OVERRIDE {}
+		void CopyToStaging(IPlatformTexture* dst) const OVERRIDE {}
+		void SaveToFile(const char* filename) const OVERRIDE {}
+		void GenerateMips() OVERRIDE {}
+		void SetDebugName(const char* name) OVERRIDE {}
+		bool GetMipGenerated() const OVERRIDE { return false; }
+		size_t GetSizeInBytes() const OVERRIDE { return mSizeInBytes; }
+	};
+}
+
 FB_IMPLEMENT_STATIC_CREATE(NullPlatformRenderer);
 
 NullPlatformRenderer::NullPlatformRenderer(){
@@ -38,6 +76,33 @@ NullPlatformRenderer::~NullPlatformRenderer(){
 
 }
 
+NullPlatformRenderer::CallCounts::CallCounts()
+	: mDraw(0)
+	, mDrawIndexed(0)
+	, mDrawIndexedInstanced(0)
+	, mNumInstances(0)
+	, mSetVertexBuffers(0)
+	, mUpdateShaderConstants(0)
+	, mCreateTexture(0)
+{
+}
+
+const NullPlatformRenderer::CallCounts& NullPlatformRenderer::GetCallCounts() const{
+	return mCallCounts;
+}
+
+void NullPlatformRenderer::ResetCallCounts(){
+	mCallCounts = CallCounts();
+}
+
+void NullPlatformRenderer::AddTextureMipChain(const char* path, const TextureMipChain& mipChain){
+	if (!ValidCString(path) || mipChain.mMipSizes.empty()){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return;
+	}
+	mTextureMipChains[path] = mipChain;
+}
+
 void NullPlatformRenderer::RegisterThreadIdConsideredMainThread(std::thread::id threadId) {
 
 }
@@ -91,12 +156,64 @@ void NullPlatformRenderer::SetShaderCacheOption(bool useShaderCache, bool genera
 }
 
 IPlatformTexturePtr NullPlatformRenderer::CreateTexture(const char* path, const TextureCreationOption& option) {
-	return 0;
+	if (!ValidCString(path))
+		return 0;
+	auto it = mTextureMipChains.find(path);
+	if (it == mTextureMipChains.end())
+		return 0;
+	auto& mipSizes = it->second.mMipSizes;
+	auto firstMip = std::min(std::max(option.firstMip, 0), (int)mipSizes.size() - 1);
+	size_t sizeInBytes = 0;
+	for (size_t i = firstMip; i < mipSizes.size(); ++i){
+		sizeInBytes += mipSizes[i];
+	}
+	++mCallCounts.mCreateTexture;
+	return NullPlatformTexture::Create(
+		Vec2ITuple(std::max(it->second.mWidth >> firstMip, 1), std::max(it->second.mHeight >> firstMip, 1)),
+		sizeInBytes);
+}
+
+bool NullPlatformRenderer::GetTextureMipChain(const char* path, const TextureCreationOption& option,
+	TextureMipChain& outMipChain) {
+	if (!ValidCString(path))
+		return false;
+	auto it = mTextureMipChains.find(path);
+	if (it == mTextureMipChains.end())
+		return false;
+	outMipChain = it->second;
+	return true;
 }
 
 IPlatformTexturePtr NullPlatformRenderer::CreateTexture(void* data, int width, int height,PIXEL_FORMAT format, 
 	int mipLevels, BUFFER_USAGE usage, int  buffer_cpu_access,int texture_type) {
-	return 0;
+	if (width <= 0 || height <= 0)
+		return 0;
+	return NullPlatformTexture::Create(Vec2ITuple(width, height), width * height * 4);
+}
+
+bool NullPlatformRenderer::RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+	GlyphBitmap& outGlyph) {
+	GlyphFontMetrics metrics;
+	if (!GetGlyphFontMetrics(fontPath, pixelHeight, metrics))
+		return false;
+	outGlyph = GlyphBitmap();
+	outGlyph.mXAdvance = pixelHeight / 2 + 1;
+	if (codePoint == ' ')
+		return true;
+	outGlyph.mWidth = std::max(pixelHeight / 2, 1);
+	outGlyph.mHeight = std::max(metrics.mBase, 1);
+	outGlyph.mYOffset = metrics.mBase - outGlyph.mHeight;
+	outGlyph.mPixels.assign(outGlyph.mWidth * outGlyph.mHeight, 255);
+	return true;
+}
+
+bool NullPlatformRenderer::GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+	GlyphFontMetrics& outMetrics) {
+	if (!ValidCString(fontPath) || pixelHeight <= 0)
+		return false;
+	outMetrics.mLineHeight = pixelHeight;
+	outMetrics.mBase = pixelHeight * 4 / 5;
+	return true;
 }
 
 IPlatformVertexBufferPtr NullPlatformRenderer::CreateVertexBuffer(void* data, unsigned stride,unsigned numVertices, BUFFER_USAGE usage, BUFFER_CPU_ACCESS_FLAG accessFlag) {
@@ -132,6 +249,15 @@ IPlatformShaderPtr NullPlatformRenderer::CompileComputeShader(const char* code,
 	return 0;
 }
 
+IShaderCompilerPtr NullPlatformRenderer::GetShaderCompiler() {
+	return 0;
+}
+
+IPlatformShaderPtr NullPlatformRenderer::CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+	const StringVector& relatedFiles) {
+	return 0;
+}
+
 IPlatformInputLayoutPtr NullPlatformRenderer::CreateInputLayout(const INPUT_ELEMENT_DESCS& descs,void* shaderByteCode, unsigned size) {
 	return 0;
 }
@@ -173,7 +299,7 @@ void NullPlatformRenderer::SetScissorRects(const Rect rects[], int num) {
 }
 
 void NullPlatformRenderer::SetVertexBuffers(unsigned int startSlot, unsigned int numBuffers,IPlatformVertexBuffer const * pVertexBuffers[], unsigned int const strides[], unsigned int offsets[]) {
-	
+	++mCallCounts.mSetVertexBuffers;
 }
 
 void NullPlatformRenderer::SetPrimitiveTopology(PRIMITIVE_TOPOLOGY pt) {
@@ -185,7 +311,7 @@ void NullPlatformRenderer::SetTextures(IPlatformTexturePtr pTextures[], int num,
 }
 
 void NullPlatformRenderer::UpdateShaderConstants(ShaderConstants::Enum type, const void* data, int size) {
-	
+	++mCallCounts.mUpdateShaderConstants;
 }
 
 void* NullPlatformRenderer::MapShaderConstantsBuffer() const{
@@ -221,11 +347,17 @@ void NullPlatformRenderer::CopyToStaging(IPlatformTexture* dst, UINT dstSubresou
 }
 
 void NullPlatformRenderer::Draw(unsigned int vertexCount, unsigned int startVertexLocation) {
-	
+	++mCallCounts.mDraw;
 }
 
 void NullPlatformRenderer::DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned startVertexLocation) {
-	
+	++mCallCounts.mDrawIndexed;
+}
+
+void NullPlatformRenderer::DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+	unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation) {
+	++mCallCounts.mDrawIndexedInstanced;
+	mCallCounts.mNumInstances += instanceCount;
 }
 
 void NullPlatformRenderer::Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil) {
@@ -28,14 +28,44 @@
 #pragma once
 #include "FBCommonHeaders/Types.h"
 #include "IPlatformRenderer.h"
+#include <unordered_map>
 namespace fb{
 	FB_DECLARE_SMART_PTR(NullPlatformRenderer);
+	/** Renderer which does nothing but counting the calls.
+	Used when no platform renderer is loaded and by tests which want to know
+	how many draw calls a code path issues.
+	*/
 	class NullPlatformRenderer : public IPlatformRenderer {
+	public:
+		struct CallCounts{
+			CallCounts();
+
+			unsigned mDraw;
+			unsigned mDrawIndexed;
+			unsigned mDrawIndexedInstanced;
+			unsigned mNumInstances;
+			unsigned mSetVertexBuffers;
+			unsigned mUpdateShaderConstants;
+			unsigned mCreateTexture;
+		};
+
+	private:
+		CallCounts mCallCounts;
+		std::unordered_map<std::string, TextureMipChain> mTextureMipChains;
+
 		NullPlatformRenderer();
 		~NullPlatformRenderer();
 	public:
 		static NullPlatformRendererPtr Create();
 
+		const CallCounts& GetCallCounts() const;
+		void ResetCallCounts();
+		/** Registers a synthetic texture file.
+		CreateTexture() with \a path will return a texture which holds
+		the mips from TextureCreationOption::firstMip.
+		*/
+		void AddTextureMipChain(const char* path, const TextureMipChain& mipChain);
+
 		void RegisterThreadIdConsideredMainThread(std::thread::id threadId) OVERRIDE;
 		void PrepareQuit() OVERRIDE;
 		//-------------------------------------------------------------------
@@ -67,9 +97,17 @@ namespace fb{
 		//-------------------------------------------------------------------
 		void SetShaderCacheOption(bool useShaderCache, bool generateCache);
 		IPlatformTexturePtr CreateTexture(const char* path, const TextureCreationOption& option);
+		bool GetTextureMipChain(const char* path, const TextureCreationOption& option,
+			TextureMipChain& outMipChain) OVERRIDE;
 		IPlatformTexturePtr CreateTexture(void* data, int width, int height,
 			PIXEL_FORMAT format, int mipLevels, BUFFER_USAGE usage, int  buffer_cpu_access,
 			int texture_type);
+		/// Returns a filled box of the pixel height for every code point but
+		/// space which is blank.
+		bool RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+			GlyphBitmap& outGlyph) OVERRIDE;
+		bool GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+			GlyphFontMetrics& outMetrics) OVERRIDE;
 		IPlatformVertexBufferPtr CreateVertexBuffer(void* data, unsigned stride,
 			unsigned numVertices, BUFFER_USAGE usage, BUFFER_CPU_ACCESS_FLAG accessFlag);
 		IPlatformIndexBufferPtr CreateIndexBuffer(void* data, unsigned int numIndices,
@@ -84,6 +122,9 @@ namespace fb{
 			const SHADER_DEFINES& defines, bool ignoreCache) OVERRIDE;
 		IPlatformShaderPtr CompileComputeShader(const char* code, const char* entry,
 			const SHADER_DEFINES& defines) OVERRIDE;
+		IShaderCompilerPtr GetShaderCompiler() OVERRIDE;
+		IPlatformShaderPtr CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+			const StringVector& relatedFiles) OVERRIDE;
 		IPlatformInputLayoutPtr CreateInputLayout(const INPUT_ELEMENT_DESCS& descs,
 			void* shaderByteCode, unsigned size);
 		IPlatformBlendStatePtr CreateBlendState(const BLEND_DESC& desc);
@@ -121,6 +162,8 @@ namespace fb{
 		//-------------------------------------------------------------------
 		void Draw(unsigned int vertexCount, unsigned int startVertexLocation);
 		void DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned startVertexLocation);
+		void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+			unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation);
 		void Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil);
 		void Clear(Real r, Real g, Real b, Real a);
 		void ClearDepthStencil(Real z, UINT8 stencil);
@@ -0,0 +1,94 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "NullShaderCompiler.h"
+#include "FBStringLib/MurmurHash.h"
+using namespace fb;
+
+FB_IMPLEMENT_STATIC_CREATE(NullShaderCompiler);
+
+NullShaderCompiler::NullShaderCompiler()
+	: mVersion("null_1")
+	, mNumCompiled(0)
+	, mDelayMs(0)
+{
+}
+
+NullShaderCompiler::~NullShaderCompiler(){
+
+}
+
+void NullShaderCompiler::SetVersion(const char* version){
+	mVersion = version ? version : "";
+}
+
+void NullShaderCompiler::SetDelay(unsigned ms){
+	mDelayMs = ms;
+}
+
+unsigned NullShaderCompiler::GetNumCompiled() const{
+	return mNumCompiled;
+}
+
+void NullShaderCompiler::ResetNumCompiled(){
+	mNumCompiled = 0;
+}
+
+const char* NullShaderCompiler::GetVersion() const{
+	return mVersion.c_str();
+}
+
+bool NullShaderCompiler::Compile(const std::string& source, const char* sourceName,
+	const char* entryPoint, SHADER_TYPE shaderType, const SHADER_DEFINES& defines,
+	ByteArray& outByteCode)
+{
+	if (mDelayMs)
+		std::this_thread::sleep_for(std::chrono::milliseconds(mDelayMs));
+	if (!ValidCString(entryPoint) || source.find(entryPoint) == std::string::npos) {
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Entry point(%s) is not found in %s",
+			entryPoint ? entryPoint : "", sourceName ? sourceName : "").c_str());
+		return false;
+	}
+	std::string input = source;
+	input += entryPoint;
+	input += (char)shaderType;
+	for (auto& define : defines) {
+		input += define.mName;
+		input += '=';
+		input += define.mValue;
+		input += ';';
+	}
+	input += mVersion;
+	UINT64 hash = hash64(input.c_str(), (int)input.size());
+	static const char mark[4] = { 'N', 'U', 'L', 'L' };
+	outByteCode.resize(sizeof(mark) + sizeof(hash));
+	memcpy(&outByteCode[0], mark, sizeof(mark));
+	memcpy(&outByteCode[sizeof(mark)], &hash, sizeof(hash));
+	++mNumCompiled;
+	return true;
+}
@@ -0,0 +1,63 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "IShaderCompiler.h"
+#include <atomic>
+namespace fb{
+	FB_DECLARE_SMART_PTR(NullShaderCompiler);
+	/** Shader compiler which produces fake but deterministic bytecode.
+	Used when the platform renderer has no compiler and by tests which want
+	to know how many permutations a code path compiles.
+	Compiling fails when the entry point is not found in the source.
+	*/
+	class NullShaderCompiler : public IShaderCompiler {
+		std::string mVersion;
+		std::atomic<unsigned> mNumCompiled;
+		unsigned mDelayMs;
+
+		NullShaderCompiler();
+		~NullShaderCompiler();
+	public:
+		static NullShaderCompilerPtr Create();
+
+		void SetVersion(const char* version);
+		/// Simulates a slow compiler.
+		void SetDelay(unsigned ms);
+		unsigned GetNumCompiled() const;
+		void ResetNumCompiled();
+
+		//-------------------------------------------------------------------
+		// IShaderCompiler
+		//-------------------------------------------------------------------
+		const char* GetVersion() const;
+		bool Compile(const std::string& source, const char* sourceName,
+			const char* entryPoint, SHADER_TYPE shaderType, const SHADER_DEFINES& defines,
+			ByteArray& outByteCode);
+	};
+}
@@ -29,6 +29,9 @@
 #include "Renderer.h"
 #include "IPlatformRenderer.h"
 #include "NullPlatformRenderer.h"
+#include "ShaderCache.h"
+#include "TextureStreamer.h"
+#include "GlyphAtlas.h"
 #include "RendererEnums.h"
 #include "RendererStructs.h"
 #include "Texture.h"
@@ -53,6 +56,7 @@
 #include "RendererKeys.h"
 #include "FBCommonHeaders/SpinLock.h"
 #include "FBStringLib/MurmurHash.h"
+#include "FBStringLib/StringId.h"
 #include "FBMathLib/Frustum.h"
 #include "FBConsole/Console.h"
 #include "EssentialEngineData/shaders/Constants.h"
@@ -78,6 +82,7 @@
 namespace fb{
 	ShaderPtr GetShaderFromExistings(IPlatformShaderPtr platformShader);
 	TexturePtr GetTextureFromExistings(IPlatformTexturePtr platformTexture);
+	void ReplacePlatformTexture(IPlatformTexturePtr from, IPlatformTexturePtr to);
 	FB_DECLARE_SMART_PTR(UI3DObj);
 	FB_DECLARE_SMART_PTR(UIObject);
 }
@@ -116,6 +121,7 @@ public:
 	};
 	std::shared_ptr<PlatformRendererHolder> mPlatformRenderer;
 	IPlatformRendererPtr mNullRenderer;
+	IPlatformRendererPtr mPlatformRendererOverride;
 	
 
 	std::unordered_map<HWindowId, HWindow> mWindowHandles;
@@ -236,6 +242,12 @@ public:
 	unsigned mMainWindowStyle;
 	bool mWindowSizeInternallyChanging;	
 	Vec4f mIrradCoeff[9];
+	bool mInFileChangeBatch;
+	std::set<std::string> mChangedShaderFiles;
+	// holds the compiler of the platform renderer module.
+	ShaderCachePtr mShaderCache;
+	TextureStreamerPtr mTextureStreamer;
+	GlyphAtlasPtr mGlyphAtlas;
 
 	//-----------------------------------------------------------------------
 	Impl(Renderer* renderer)
@@ -251,6 +263,7 @@ public:
 		, mRendererOptions(RendererOptions::Create())		
 		, mMainWindowStyle(0)
 		, mGenerateRadianceCoef(false)
+		, mInFileChangeBatch(false)
 	{
 		auto filepath = "_FBRenderer.log";
 		FileSystem::BackupFile(filepath, 5, "Backup_Log");
@@ -285,9 +298,19 @@ public:
 			Logger::Log(FB_ERROR_LOG_ARG, "The console is not initialized!");
 		}
 		RegisterRendererLuaFunctions();
+		auto pimpl = this;
+		mTextureStreamer = TextureStreamer::Create(GetTextureStreamingBudget(),
+			[pimpl](const char* path, IPlatformTexturePtr prev, IPlatformTexturePtr cur){
+				pimpl->OnStreamedTextureReplaced(path, prev, cur);
+			});
+		mGlyphAtlas = GlyphAtlas::Create(GlyphAtlas::DefaultPageSize, GlyphAtlas::DefaultMaxPages);
 	}
 
 	~Impl(){
+		mShaderCache = 0;
+		mTextureStreamer = 0;
+		// fonts keep weak references only. Waits for the rasterizing here.
+		mGlyphAtlas = 0;
 		ClearLoadedMaterials();
 		StarDef::FinalizeStatic();
 		Logger::Release();
@@ -315,6 +338,9 @@ public:
 						new PlatformRendererHolder(platformRenderer, module), 
 						[](PlatformRendererHolder* obj){delete obj; });
 					Logger::Log(FB_DEFAULT_LOG_ARG, FormatString("Render engine %s is prepared.", type).c_str());
+					auto shaderCache = GetShaderCache();
+					if (shaderCache)
+						shaderCache->WarmUp();
 					return true;
 				}
 				else{
@@ -332,10 +358,30 @@ public:
 	}
 
 	void PrepareQuit() {
+		if (mShaderCache && mRendererOptions->r_GenerateShaderCache)
+			mShaderCache->Save(false);
 		GetPlatformRenderer().PrepareQuit();
 	}
 
+	ShaderCache* GetShaderCache() {
+		if (!mRendererOptions->r_UseShaderCache)
+			return 0;
+		if (!mShaderCache) {
+			auto compiler = GetPlatformRenderer().GetShaderCompiler();
+			if (!compiler)
+				return 0;
+			auto cacheFile = FileSystem::GetAppDataLocalGameFolder() + "shadercache/" +
+				(mPlatformRendererType.empty() ? std::string("default") : mPlatformRendererType) +
+				".shadercache";
+			mShaderCache = ShaderCache::Create(cacheFile.c_str(), compiler);
+		}
+		return mShaderCache.get();
+	}
+
 	IPlatformRenderer& GetPlatformRenderer() const {
+		if (mPlatformRendererOverride)
+			return *mPlatformRendererOverride.get();
+
 		if (!mPlatformRenderer)
 		{
 			return *mNullRenderer.get();
@@ -762,6 +808,9 @@ public:
 	}
 
 	void Render(){
+		mTextureStreamer->SetBudget(GetTextureStreamingBudget());
+		mTextureStreamer->Update(GetPlatformRenderer());
+		mGlyphAtlas->Update(GetPlatformRenderer());
 		if (mGenerateRadianceCoef && mEnvironmentTexture && mEnvironmentTexture->IsReady()){
 			GenerateRadianceCoef(mEnvironmentTexture);			
 		}
@@ -893,7 +942,8 @@ public:
 	}
 
 	SpinLockWaitSleep sPlatformTexturesLock;
-	using TextureCache = std::unordered_map<std::string, IPlatformTextureWeakPtr>;
+	// keyed by the case insensitive id of the path.
+	using TextureCache = std::unordered_map<StringId, IPlatformTextureWeakPtr>;
 	TextureCache sPlatformTextures;
 
 	TexturePtr CreateTexture(const char* file, const TextureCreationOption& options){
@@ -901,13 +951,12 @@ public:
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
 			return 0;
 		}
-		std::string loweredFilepath(file);
-		ToLowerCase(loweredFilepath);
+		auto pathId = GetStringIdNoCase(file);
 		TextureCache::iterator it;
 		IPlatformTexturePtr cachedPlatformTexture;
 		{
 			EnterSpinLock<SpinLockWaitSleep> lock(sPlatformTexturesLock);
-			it = sPlatformTextures.find(loweredFilepath);
+			it = sPlatformTextures.find(pathId);
 			if (it != sPlatformTextures.end()) {
 				cachedPlatformTexture = it->second.lock();
 			}
@@ -919,14 +968,24 @@ public:
 			}
 		}		
 
-		IPlatformTexturePtr platformTexture = GetPlatformRenderer().CreateTexture(file, options);
+		IPlatformTexturePtr platformTexture;
+		// ui textures are created without mips and not streamed.
+		if (mRendererOptions->r_TextureStreaming && options.async && options.generateMip &&
+			options.textureType == TEXTURE_TYPE_DEFAULT && options.firstMip == 0)
+		{
+			platformTexture = mTextureStreamer->CreateTexture(GetPlatformRenderer(), file, options);
+		}
+		if (!platformTexture)
+			platformTexture = GetPlatformRenderer().CreateTexture(file, options);
 		if (!platformTexture){
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Platform renderer failed to load a texture(%s)", file).c_str());
 			return 0;
 		}
+		// Interning checks the id against the other cached paths.
+		InternStringNoCase(file);
 		{
 			EnterSpinLock<SpinLockWaitSleep> lock(sPlatformTexturesLock);
-			sPlatformTextures[loweredFilepath] = platformTexture;
+			sPlatformTextures[pathId] = platformTexture;
 		}
 		auto texture = CreateTexture(platformTexture);
 		texture->SetFilePath(file);
@@ -934,6 +993,31 @@ public:
 		return texture;
 	}
 
+	size_t GetTextureStreamingBudget() const{
+		return (size_t)std::max(mRendererOptions->r_TextureStreamingBudget, 0) * 1024 * 1024;
+	}
+
+	TextureStreamerPtr GetTextureStreamer() const{
+		return mTextureStreamer;
+	}
+
+	GlyphAtlasPtr GetGlyphAtlas() const{
+		return mGlyphAtlas;
+	}
+
+	bool GetGlyphFontMetrics(const char* fontPath, int pixelHeight, GlyphFontMetrics& outMetrics){
+		return GetPlatformRenderer().GetGlyphFontMetrics(fontPath, pixelHeight, outMetrics);
+	}
+
+	void OnStreamedTextureReplaced(const char* path, IPlatformTexturePtr prev, IPlatformTexturePtr cur){
+		auto pathId = InternStringNoCase(path);
+		{
+			EnterSpinLock<SpinLockWaitSleep> lock(sPlatformTexturesLock);
+			sPlatformTextures[pathId] = cur;
+		}
+		ReplacePlatformTexture(prev, cur);
+	}
+
 	TexturePtr CreateTexture(void* data, int width, int height, PIXEL_FORMAT format,
 		int mipLevels, BUFFER_USAGE usage, int  buffer_cpu_access, int texture_type){
 		auto platformTexture = GetPlatformRenderer().CreateTexture(data, width, height, format, mipLevels, usage, buffer_cpu_access, texture_type);
@@ -962,11 +1046,10 @@ public:
 			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Platform renderer failed to load a texture(%s)", filepath).c_str());
 			return;
 		}
-		std::string loweredFilepath(filepath);
-		ToLowerCase(loweredFilepath);
+		auto pathId = InternStringNoCase(filepath);
 		{
 			EnterSpinLock<SpinLockWaitSleep> lock(sPlatformTexturesLock);
-			sPlatformTextures[loweredFilepath] = platformTexture;
+			sPlatformTextures[pathId] = platformTexture;
 		}
 		texture->SetPlatformTexture(platformTexture);
 	}
@@ -1035,21 +1118,32 @@ public:
 		const SHADER_DEFINES& defines, bool ignoreCache)
 	{
 		IPlatformShaderPtr p;
-		switch (shaderType) {
-		case SHADER_TYPE_VS:
-			p = GetPlatformRenderer().CreateVertexShader(filepath, defines, ignoreCache);
-			break;
-		case SHADER_TYPE_GS:
-			p = GetPlatformRenderer().CreateGeometryShader(filepath, defines, ignoreCache);
-			break;
-		case SHADER_TYPE_PS:
-			p = GetPlatformRenderer().CreatePixelShader(filepath, defines, ignoreCache);
-			break;
-		case SHADER_TYPE_CS:
-			p = GetPlatformRenderer().CreateComputeShader(filepath, defines, ignoreCache);
-			break;
-		default:
-			Logger::Log(FB_ERROR_LOG_ARG, "Unsupported.");
+		ShaderCache* shaderCache = ignoreCache ? 0 : GetShaderCache();
+		if (shaderCache) {
+			StringVector relatedFiles;
+			auto byteCode = shaderCache->GetByteCode(filepath, shaderType, defines, &relatedFiles);
+			if (!byteCode.empty())
+				p = GetPlatformRenderer().CreateShader(shaderType, byteCode, relatedFiles);
+		}
+		// Failed shaders go through the platform renderer as well
+		// to be reloaded when fixed.
+		if (!p) {
+			switch (shaderType) {
+			case SHADER_TYPE_VS:
+				p = GetPlatformRenderer().CreateVertexShader(filepath, defines, ignoreCache);
+				break;
+			case SHADER_TYPE_GS:
+				p = GetPlatformRenderer().CreateGeometryShader(filepath, defines, ignoreCache);
+				break;
+			case SHADER_TYPE_PS:
+				p = GetPlatformRenderer().CreatePixelShader(filepath, defines, ignoreCache);
+				break;
+			case SHADER_TYPE_CS:
+				p = GetPlatformRenderer().CreateComputeShader(filepath, defines, ignoreCache);
+				break;
+			default:
+				Logger::Log(FB_ERROR_LOG_ARG, "Unsupported.");
+			}
 		}
 		PlatformShaderKey key(filepath, shaderType, defines);
 		sPlatformShaders[key] = p;
@@ -1229,6 +1323,21 @@ public:
 		}		
 	}
 
+	/// Reloads each shader once even if several of its files changed.
+	void ReloadShaders(const std::set<std::string>& filepaths){
+		for (auto it : sPlatformShaders) {
+			auto platformShader = it.second.lock();
+			if (!platformShader)
+				continue;
+			for (auto& filepath : filepaths){
+				if (platformShader->IsRelatedFile(filepath.c_str())){
+					platformShader->Reload(it.first.GetShaderDefines());
+					break;
+				}
+			}
+		}
+	}
+
 	std::unordered_map<std::string, MaterialPtr> sLoadedMaterials;
 	std::unordered_map<std::string, MaterialWeakPtr> sLoadedMaterialsWeak;
 	void ClearLoadedMaterials() {
@@ -1250,7 +1359,7 @@ public:
 			}
 		}
 	}
-	MaterialPtr CreateMaterial(const char* file){
+	MaterialPtr CreateMaterial(const char* file, const CompiledMaterial* compiled){
 		if (!ValidCString(file)){
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
 			return 0;
@@ -1265,7 +1374,9 @@ public:
 			}
 		}
 		auto material = Material::Create();
-		if (!material->LoadFromFile(file))
+		bool loaded = compiled ? material->LoadFromCompiled(file, *compiled) :
+			material->LoadFromFile(file);
+		if (!loaded)
 			return 0;
 
 		sLoadedMaterials[loweredPath] = material;
@@ -2033,6 +2144,15 @@ public:
 		mFrameProfiler.NumIndexCount += indexCount;
 	}
 
+	void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+		unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation){
+		GetPlatformRenderer().DrawIndexedInstanced(indexCountPerInstance, instanceCount,
+			startIndexLocation, startVertexLocation, startInstanceLocation);
+		mFrameProfiler.NumInstancedDrawCall++;
+		mFrameProfiler.NumInstanceCount += instanceCount;
+		mFrameProfiler.NumIndexCount += indexCountPerInstance * instanceCount;
+	}
+
 	void Draw(unsigned int vertexCount, unsigned int startVertexLocation){
 		/*if (mSelf->mCurrentRenderTargetTextureIds.empty() ||
 			mSelf->mCurrentRenderTargetTextureIds[0] == -1){
@@ -2785,6 +2905,11 @@ public:
 		mSelf->QueueDrawText(Vec2I(x, y), msg, Vec3(1, 1, 1));
 		y += yStep;
 
+		swprintf_s(msg, 255, L"Num instanced draw calls = %u (%u instances)", 
+			profiler.NumInstancedDrawCall, profiler.NumInstanceCount);
+		mSelf->QueueDrawText(Vec2I(x, y), msg, Vec3(1, 1, 1));
+		y += yStep;
+
 		swprintf_s(msg, 255, L"Num UpdateObjectConstantsBuffer = %u", profiler.NumUpdateObjectConst);
 		mSelf->QueueDrawText(Vec2I(x, y), msg, Vec3(1, 1, 1));
 		y += yStep * 2;		
@@ -3516,7 +3641,12 @@ public:
 		bool xml = extension == ".xml";
 		bool font = extension == ".fnt";		
 		if (shader){
-			ReloadShader(file);
+			if (mShaderCache)
+				mShaderCache->InvalidateSource(file);
+			if (mInFileChangeBatch)
+				mChangedShaderFiles.insert(file);
+			else
+				ReloadShader(file);
 			return true;
 		}
 		else if (texture){
@@ -3540,6 +3670,18 @@ public:
 		}
 		return false;
 	}
+
+	void OnFileChangeBatchBegin(size_t numFiles){
+		mInFileChangeBatch = true;
+	}
+
+	void OnFileChangeBatchEnd(){
+		mInFileChangeBatch = false;
+		if (!mChangedShaderFiles.empty()){
+			ReloadShaders(mChangedShaderFiles);
+			mChangedShaderFiles.clear();
+		}
+	}
 };
 
 static RendererWeakPtr sRenderer;
@@ -3605,6 +3747,10 @@ void Renderer::PrepareQuit() {
 	mImpl->PrepareQuit();
 }
 
+void Renderer::SetPlatformRendererOverride(IPlatformRendererPtr platformRenderer) {
+	mImpl->mPlatformRendererOverride = platformRenderer;
+}
+
 //-------------------------------------------------------------------
 // Canvas & System
 //-------------------------------------------------------------------
@@ -3676,7 +3822,11 @@ ShaderPtr Renderer::CompileComputeShader(const char* code, const char* entry, co
 }
 
 MaterialPtr Renderer::CreateMaterial(const char* file) {
-	return mImpl->CreateMaterial(file);
+	return mImpl->CreateMaterial(file, 0);
+}
+
+MaterialPtr Renderer::CreateMaterial(const char* file, const CompiledMaterial& compiled) {
+	return mImpl->CreateMaterial(file, &compiled);
 }
 
 // use this if you are sure there is instance of the descs.
@@ -4029,6 +4179,24 @@ void Renderer::SetResourceProvider(ResourceProviderPtr provider){
 	mImpl->SetResourceProvider(provider);
 }
 
+TextureStreamerPtr Renderer::GetTextureStreamer() const{
+	return mImpl->GetTextureStreamer();
+}
+
+GlyphAtlasPtr Renderer::GetGlyphAtlas() const{
+	return mImpl->GetGlyphAtlas();
+}
+
+bool Renderer::GetGlyphFontMetrics(const char* fontPath, int pixelHeight, GlyphFontMetrics& outMetrics){
+	return mImpl->GetGlyphFontMetrics(fontPath, pixelHeight, outMetrics);
+}
+
+ShaderCachePtr Renderer::GetShaderCache(){
+	if (!mImpl->GetShaderCache())
+		return 0;
+	return mImpl->mShaderCache;
+}
+
 RenderTargetPtr Renderer::GetMainRenderTarget() const {
 	return mImpl->GetMainRenderTarget();
 }
@@ -4313,6 +4481,12 @@ void Renderer::DrawIndexed(unsigned indexCount, unsigned startIndexLocation, uns
 	mImpl->DrawIndexed(indexCount, startIndexLocation, startVertexLocation);
 }
 
+void Renderer::DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+	unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation) {
+	mImpl->DrawIndexedInstanced(indexCountPerInstance, instanceCount,
+		startIndexLocation, startVertexLocation, startInstanceLocation);
+}
+
 void Renderer::Draw(unsigned int vertexCount, unsigned int startVertexLocation) {
 	mImpl->Draw(vertexCount, startVertexLocation);
 }
@@ -4501,3 +4675,11 @@ void Renderer::OnChangeDetected(){
 bool Renderer::OnFileChanged(const char* watchDir, const char* file, const char* combinedPath, const char* ext){
 	return mImpl->OnFileChanged(watchDir, file, combinedPath, ext);
 }
+
+void Renderer::OnFileChangeBatchBegin(size_t numFiles){
+	mImpl->OnFileChangeBatchBegin(numFiles);
+}
+
+void Renderer::OnFileChangeBatchEnd(){
+	mImpl->OnFileChangeBatchEnd();
+}
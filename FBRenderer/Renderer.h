@@ -66,6 +66,11 @@ namespace fb{
 	FB_DECLARE_SMART_PTR(RenderTarget);
 	FB_DECLARE_SMART_PTR(RendererOptions);
 	FB_DECLARE_SMART_PTR(Renderer);
+	FB_DECLARE_SMART_PTR(IPlatformRenderer);
+	FB_DECLARE_SMART_PTR(TextureStreamer);
+	FB_DECLARE_SMART_PTR(GlyphAtlas);
+	FB_DECLARE_SMART_PTR(ShaderCache);
+	struct CompiledMaterial;
 	/** Render vertices with a specified material	
 	Rednerer handles vertex/index data, materials, textures, shaders,
 	render states, lights and render targets.
@@ -120,6 +125,11 @@ namespace fb{
 		bool PrepareRenderEngine(const char* rendererPlugInName);
 		void RegisterThreadIdConsideredMainThread(std::thread::id threadId);
 		void PrepareQuit();
+		/** Routes every platform call to \a platformRenderer until called with 0.
+		Resources must be created before the override is set. Mainly used with
+		NullPlatformRenderer to count the calls a frame issues.
+		*/
+		void SetPlatformRendererOverride(IPlatformRendererPtr platformRenderer);
 		//-------------------------------------------------------------------
 		// Canvas & System
 		//-------------------------------------------------------------------
@@ -153,6 +163,9 @@ namespace fb{
 		/// Reloading is also not supported.
 		ShaderPtr CompileComputeShader(const char* code, const char* entry, const SHADER_DEFINES& defines);
 		MaterialPtr CreateMaterial(const char* file);		
+		/// Creates the material with the data compiled by CompiledMaterial::Load().
+		/// The material is cached as if it is created by CreateMaterial(file).
+		MaterialPtr CreateMaterial(const char* file, const CompiledMaterial& compiled);
 		// use this if you are sure there is instance of the descs.
 		InputLayoutPtr CreateInputLayout(const INPUT_ELEMENT_DESCS& descs, ShaderPtr shader);
 		InputLayoutPtr GetInputLayout(DEFAULT_INPUTS::Enum e, ShaderPtr shader);
@@ -274,6 +287,14 @@ namespace fb{
 		ResourceProviderPtr GetResourceProvider() const;
 		/// \param provider cannot be null
 		void SetResourceProvider(ResourceProviderPtr provider);		
+		/// Visible objects report the screen size of their textures to it.
+		TextureStreamerPtr GetTextureStreamer() const;
+		/// Glyphs of the TrueType fonts.
+		GlyphAtlasPtr GetGlyphAtlas() const;
+		bool GetGlyphFontMetrics(const char* fontPath, int pixelHeight, GlyphFontMetrics& outMetrics);
+		/// 0 if r_UseShaderCache is off or the platform renderer doesn't
+		/// support it.
+		ShaderCachePtr GetShaderCache();
 		RenderTargetPtr GetMainRenderTarget() const;
 		unsigned GetMainRenderTargetId() const;
 		IScenePtr GetMainScene() const; // move to SceneManager
@@ -358,6 +379,8 @@ namespace fb{
 		// Drawing
 		//-------------------------------------------------------------------
 		void DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned startVertexLocation);
+		void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+			unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation);
 		void Draw(unsigned int vertexCount, unsigned int startVertexLocation);				
 		void DrawFullscreenQuad(ShaderPtr pixelShader, bool farside);
 		void DrawTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const Vec4& color, MaterialPtr mat);
@@ -427,6 +450,8 @@ namespace fb{
 		//-------------------------------------------------------------------
 		void OnChangeDetected();
 		bool OnFileChanged(const char* watchDir, const char* file, const char* combinedPath, const char* ext);
+		void OnFileChangeBatchBegin(size_t numFiles);
+		void OnFileChangeBatchEnd();
 
 		//-------------------------------------------------------------------
 		// Debug
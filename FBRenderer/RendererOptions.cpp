@@ -128,6 +128,11 @@ RendererOptions::RendererOptions(){
 	FB_REGISTER_CVAR(r_ShadowMapSize, r_ShadowMapSize, CVAR_CATEGORY_CLIENT,
 		"ShadowMap width");
 
+	r_ShadowCasterMinTexels = Console::GetInstance().GetRealVariable(
+		L, "r_ShadowCasterMinTexels", 1.0f);
+	FB_REGISTER_CVAR(r_ShadowCasterMinTexels, r_ShadowCasterMinTexels,
+		CVAR_CATEGORY_CLIENT, "Casters smaller than this in the shadow map texels are not rendered");
+
 	r_LightFrustum = Console::GetInstance().GetIntVariable(
 		L, "r_LightFrustum", 0);
 	FB_REGISTER_CVAR(r_LightFrustum, r_LightFrustum, CVAR_CATEGORY_CLIENT,
@@ -169,6 +174,15 @@ RendererOptions::RendererOptions(){
 	r_GenerateShaderCache = Console::GetInstance().GetIntVariable(L, "r_GenerateShaderCache", 1);
 	FB_REGISTER_CVAR(r_GenerateShaderCache, r_GenerateShaderCache, CVAR_CATEGORY_CLIENT, "generate shader cache");
 
+	r_MaterialCache = Console::GetInstance().GetIntVariable(L, "r_MaterialCache", 1);
+	FB_REGISTER_CVAR(r_MaterialCache, r_MaterialCache, CVAR_CATEGORY_CLIENT, "Load materials from the compiled material cache");
+
+	r_TextureStreaming = Console::GetInstance().GetIntVariable(L, "r_TextureStreaming", 1);
+	FB_REGISTER_CVAR(r_TextureStreaming, r_TextureStreaming, CVAR_CATEGORY_CLIENT, "Stream mips of textures loaded from now on");
+
+	r_TextureStreamingBudget = Console::GetInstance().GetIntVariable(L, "r_TextureStreamingBudget", 512);
+	FB_REGISTER_CVAR(r_TextureStreamingBudget, r_TextureStreamingBudget, CVAR_CATEGORY_CLIENT, "Texture streaming budget in megabytes");
+
 	r_numRenderTargets = Console::GetInstance().GetIntVariable(L, "r_numRenderTargets", 0);
 	FB_REGISTER_CVAR(r_numRenderTargets, r_numRenderTargets, CVAR_CATEGORY_CLIENT, "Log render targets");
 
@@ -65,6 +65,7 @@ namespace fb{
 		float r_ShadowCascadeBlendArea;
 		int r_ShadowMapPCFBlurSize;
 		int r_ShadowMapSize;
+		float r_ShadowCasterMinTexels;
 		int r_LightFrustum;
 		float r_ShadowCamWidth;
 		float r_ShadowCamHeight;
@@ -73,6 +74,9 @@ namespace fb{
 		float r_ShadowCamDist;
 		int r_UseShaderCache;
 		int r_GenerateShaderCache;
+		int r_MaterialCache;
+		int r_TextureStreaming;
+		int r_TextureStreamingBudget;
 		int r_numRenderTargets;
 		int r_numParticleEmitters;
 		int r_debugDraw;
@@ -618,6 +618,8 @@ namespace fb
 
 			NumIndexedDrawCall = 0;
 			NumIndexCount = 0;
+			NumInstancedDrawCall = 0;
+			NumInstanceCount = 0;
 			NumUpdateObjectConst = 0;
 		}
 
@@ -641,6 +643,9 @@ namespace fb
 		unsigned int NumIndexedDrawCall;
 		unsigned int NumIndexCount;
 
+		unsigned int NumInstancedDrawCall;
+		unsigned int NumInstanceCount;
+
 		Real FrameRate;
 		Real FrameRateDisplay;
 		TIME_PRECISION FrameRateDisplayUpdateTime;
@@ -815,12 +820,15 @@ namespace fb
 			: async(true)
 			, generateMip(true)
 			, textureType(TEXTURE_TYPE_DEFAULT)
+			, firstMip(0)
 		{
 		}
 
 		TextureCreationOption(bool async, bool generateMip)
 			: async(async)
 			, generateMip(generateMip)
+			, textureType(TEXTURE_TYPE_DEFAULT)
+			, firstMip(0)
 		{
 		}
 
@@ -828,6 +836,7 @@ namespace fb
 			: async(async)
 			, generateMip(generateMip)
 			, textureType(textureType)
+			, firstMip(0)
 		{
 		}
 
@@ -837,6 +846,58 @@ namespace fb
 		// Textures for ui doesn't need to have mipmap.
 		bool generateMip;
 		int textureType;
+		// mips finer than this level are not loaded. Used by the TextureStreamer.
+		int firstMip;
+	};
+
+	/// Mip layout of a texture file. Queried without loading the pixels.
+	struct TextureMipChain {
+		int mWidth;
+		int mHeight;
+		/// size in bytes of each mip level which can be the first mip.
+		/// Finest level first.
+		std::vector<size_t> mMipSizes;
+
+		TextureMipChain()
+			: mWidth(0)
+			, mHeight(0)
+		{
+		}
+	};
+
+	/// Vertical metrics of a TrueType font rasterized in a pixel height.
+	struct GlyphFontMetrics {
+		/// distance between two base lines
+		int mLineHeight;
+		/// distance from the top of the line to the base line
+		int mBase;
+
+		GlyphFontMetrics()
+			: mLineHeight(0)
+			, mBase(0)
+		{
+		}
+	};
+
+	/// A rasterized glyph. Offsets are from the pen position on the top of
+	/// the line, in pixels.
+	struct GlyphBitmap {
+		int mWidth;
+		int mHeight;
+		int mXOffset;
+		int mYOffset;
+		int mXAdvance;
+		/// 8 bit coverage, mWidth * mHeight. Empty for blank glyphs like space.
+		ByteArray mPixels;
+
+		GlyphBitmap()
+			: mWidth(0)
+			, mHeight(0)
+			, mXOffset(0)
+			, mYOffset(0)
+			, mXAdvance(0)
+		{
+		}
 	};
 }
 
@@ -0,0 +1,737 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "ShaderCache.h"
+#include "FBStringLib/StringLib.h"
+#include "FBStringLib/StringConverter.h"
+#include "FBStringLib/MurmurHash.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBThread/TaskScheduler.h"
+#include "FBThread/Task.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+using namespace fb;
+
+enum : unsigned {
+	// version : 20161000 -- 2016 year / 10 month / 00th
+	shader_cache_version = 20161000
+};
+static const char shader_cache_mark[2] = { (char)0xfb, (char)0x5c };
+
+// format
+// PackHeader
+// bytecodes
+// PackEntry[mNumEntries] sorted by key
+struct PackHeader{
+	char mMark[2];
+	unsigned short mPadding;
+	unsigned mVersion;
+	unsigned mNumEntries;
+	unsigned mPadding2;
+	UINT64 mIndexOffset;
+};
+
+struct PackEntry{
+	UINT64 mKey;
+	UINT64 mOffset;
+	unsigned mSize;
+	unsigned mPadding;
+};
+
+static bool operator < (const PackEntry& a, const PackEntry& b){
+	return a.mKey < b.mKey;
+}
+
+/// Source of a shader with all include files inlined.
+struct ExpandedSource{
+	std::string mSource;
+	UINT64 mHash;
+	/// The shader path followed by the included files.
+	StringVector mFiles;
+};
+typedef std::shared_ptr<const ExpandedSource> ExpandedSourcePtr;
+
+static std::string ParseIncludePath(const std::string& directive){
+	auto begin = directive.find_first_of("\"<");
+	if (begin == std::string::npos)
+		return{};
+	auto end = directive.find(directive[begin] == '"' ? '"' : '>', begin + 1);
+	if (end == std::string::npos)
+		return{};
+	return directive.substr(begin + 1, end - begin - 1);
+}
+
+/// Tries the path as it is first and then relative to the including file
+/// like the include processor of the platform renderer.
+static bool ResolveIncludePath(const std::string& includePath, const std::string& parentFolder,
+	std::string& outPath)
+{
+	if (FileSystem::ResourceExists(includePath.c_str())){
+		outPath = includePath;
+		return true;
+	}
+	if (!parentFolder.empty()){
+		auto path = FileSystem::ConcatPath(parentFolder.c_str(), includePath.c_str());
+		if (FileSystem::ResourceExists(path.c_str())){
+			outPath = path;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Inlines the include files. #line directives keep the compiler messages
+/// pointing to the original files. Unresolved includes are left as they are
+/// so they only fail when they are actually compiled.
+static bool ExpandIncludes(const std::string& filepath, std::string& out, StringVector& files,
+	std::set<std::string>& onceFiles, int depth)
+{
+	if (depth > 32){
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Too deep include(%s)", filepath.c_str()).c_str());
+		return false;
+	}
+	FileSystem::Open file(filepath.c_str(), "r", FileSystem::SkipErrorMsg);
+	if (file.Error())
+		return false;
+	const auto& text = file.GetTextData();
+	if (text.find("#pragma once") != std::string::npos){
+		if (onceFiles.find(filepath) != onceFiles.end())
+			return true;
+		onceFiles.insert(filepath);
+	}
+	if (!ValueExistsInVector(files, filepath))
+		files.push_back(filepath);
+
+	auto parentFolder = FileSystem::GetParentPath(filepath.c_str());
+	unsigned lineNo = 0;
+	size_t pos = 0;
+	while (pos < text.size()){
+		auto end = text.find('\n', pos);
+		if (end == std::string::npos)
+			end = text.size();
+		std::string line = text.substr(pos, end - pos);
+		pos = end + 1;
+		++lineNo;
+		auto directive = StripBoth(line.c_str());
+		if (StartsWith(directive, "#pragma once", false)){
+			out += '\n';
+			continue;
+		}
+		if (StartsWith(directive, "#include", false)){
+			std::string includePath;
+			if (ResolveIncludePath(ParseIncludePath(directive), parentFolder, includePath)){
+				out += FormatString("#line 1 \"%s\"\n", includePath.c_str());
+				if (!ExpandIncludes(includePath, out, files, onceFiles, depth + 1))
+					return false;
+				out += FormatString("\n#line %u \"%s\"\n", lineNo + 1, filepath.c_str());
+				continue;
+			}
+		}
+		out += line;
+		out += '\n';
+	}
+	return true;
+}
+
+static std::string PermutationString(const std::string& path, SHADER_TYPE shaderType,
+	const SHADER_DEFINES& defines)
+{
+	std::string str = path;
+	str += FormatString("|%d|", (int)shaderType);
+	for (auto& define : defines){
+		str += define.mName;
+		str += '=';
+		str += define.mValue;
+		str += ';';
+	}
+	return str;
+}
+
+static bool ParsePermutationString(const std::string& str, std::string& outPath,
+	SHADER_TYPE& outShaderType, SHADER_DEFINES& outDefines)
+{
+	auto fields = Split(str, "|");
+	if (fields.size() < 2 || fields[0].empty())
+		return false;
+	outPath = fields[0];
+	outShaderType = (SHADER_TYPE)StringConverter::ParseInt(fields[1]);
+	outDefines.clear();
+	if (fields.size() > 2){
+		for (auto& nameValue : Split(fields[2], ";")){
+			auto eq = nameValue.find('=');
+			if (eq == std::string::npos)
+				continue;
+			outDefines.push_back(ShaderDefine(nameValue.substr(0, eq).c_str(),
+				nameValue.substr(eq + 1).c_str()));
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------
+class ShaderCache::Impl{
+public:
+	struct CompileJob{
+		ExpandedSourcePtr mSource;
+		std::string mEntryPoint;
+		SHADER_TYPE mShaderType;
+		SHADER_DEFINES mDefines;
+		UINT64 mKey;
+	};
+
+	class CompileTask : public Task{
+		Impl* mCache;
+		CompileJob mJob;
+
+	public:
+		CompileTask(Impl* cache, CompileJob&& job)
+			: Task(true)
+			, mCache(cache)
+			, mJob(std::move(job))
+		{
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE{
+			if (mCache->Claim(mJob.mKey))
+				mCache->Compile(mJob);
+		}
+	};
+
+	struct Compiling{
+		Compiling()
+			: mStarted(false)
+		{
+		}
+
+		/// null when the permutation is compiled in place.
+		TaskPtr mTask;
+		/// Set by the thread which compiles the permutation.
+		bool mStarted;
+	};
+
+	std::string mCacheFile;
+	IShaderCompilerPtr mCompiler;
+	boost::interprocess::file_mapping mFileMapping;
+	boost::interprocess::mapped_region mMappedRegion;
+	const PackEntry* mPackIndex;
+	unsigned mNumPacked;
+
+	// protected by mMutex. The cache is used from the main thread and the
+	// asset loading workers.
+	mutable std::mutex mMutex;
+	/// Notified when a permutation is removed from mCompiling.
+	std::condition_variable mCompiledCondition;
+	std::unordered_map<UINT64, ByteArray> mNewEntries;
+	std::unordered_map<UINT64, Compiling> mCompiling;
+	Stats mStats;
+	std::unordered_map<std::string, ExpandedSourcePtr> mSources;
+	std::set<std::string> mManifest;
+	std::set<std::string> mUsedPermutations;
+	std::unordered_set<UINT64> mUsedKeys;
+
+	//---------------------------------------------------------------------------
+	Impl(const char* cacheFile, IShaderCompilerPtr compiler)
+		: mCacheFile(cacheFile)
+		, mCompiler(compiler)
+		, mPackIndex(0)
+		, mNumPacked(0)
+	{
+		MapPack();
+		FileSystem::Open file(GetManifestFile().c_str(), "r", FileSystem::SkipErrorMsg);
+		if (!file.Error()){
+			for (auto& line : Split(file.GetTextData(), "\r\n")){
+				mManifest.insert(line);
+			}
+		}
+	}
+
+	~Impl(){
+		WaitBackgroundCompiling();
+	}
+
+	std::string GetManifestFile() const{
+		return mCacheFile + ".manifest";
+	}
+
+	void MapPack(){
+		using namespace boost::interprocess;
+		mPackIndex = 0;
+		mNumPacked = 0;
+		if (!FileSystem::Exists(mCacheFile.c_str()) ||
+			FileSystem::GetFileSize(mCacheFile.c_str()) < sizeof(PackHeader))
+			return;
+		try{
+			file_mapping(mCacheFile.c_str(), read_only).swap(mFileMapping);
+			mapped_region(mFileMapping, read_only).swap(mMappedRegion);
+		}
+		catch (const interprocess_exception& e){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to map the shader cache(%s): %s",
+				mCacheFile.c_str(), e.what()).c_str());
+			UnmapPack();
+			return;
+		}
+		auto base = (const char*)mMappedRegion.get_address();
+		auto size = mMappedRegion.get_size();
+		auto header = (const PackHeader*)base;
+		if (memcmp(header->mMark, shader_cache_mark, 2) != 0 ||
+			header->mVersion != shader_cache_version)
+		{
+			UnmapPack();
+			return;
+		}
+		if (header->mIndexOffset > size ||
+			(size - header->mIndexOffset) / sizeof(PackEntry) < header->mNumEntries)
+		{
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Shader cache(%s) is corrupted.", mCacheFile.c_str()).c_str());
+			UnmapPack();
+			return;
+		}
+		mPackIndex = (const PackEntry*)(base + header->mIndexOffset);
+		mNumPacked = header->mNumEntries;
+	}
+
+	void UnmapPack(){
+		using namespace boost::interprocess;
+		mapped_region().swap(mMappedRegion);
+		file_mapping().swap(mFileMapping);
+		mPackIndex = 0;
+		mNumPacked = 0;
+	}
+
+	/// Call with mMutex locked. Save() remaps the pack.
+	const PackEntry* FindPacked(UINT64 key) const{
+		if (!mNumPacked)
+			return 0;
+		PackEntry entry;
+		entry.mKey = key;
+		auto end = mPackIndex + mNumPacked;
+		auto it = std::lower_bound(mPackIndex, end, entry);
+		if (it == end || it->mKey != key)
+			return 0;
+		if (it->mOffset + it->mSize > mMappedRegion.get_size())
+			return 0;
+		return it;
+	}
+
+	ExpandedSourcePtr GetSource(const std::string& path){
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mSources.find(path);
+			if (it != mSources.end())
+				return it->second;
+		}
+		auto source = std::make_shared<ExpandedSource>();
+		{
+			FileSystem::Lock fsLock;
+			std::set<std::string> onceFiles;
+			if (!ExpandIncludes(path, source->mSource, source->mFiles, onceFiles, 0)){
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to read a shader(%s)", path.c_str()).c_str());
+				return 0;
+			}
+		}
+		source->mHash = hash64(source->mSource.c_str(), (int)source->mSource.size());
+		std::lock_guard<std::mutex> lock(mMutex);
+		// Keeps the one expanded first when two threads read the same shader.
+		return mSources.insert(std::make_pair(path, source)).first->second;
+	}
+
+	UINT64 BuildKey(const ExpandedSource& source, const std::string& entryPoint,
+		SHADER_TYPE shaderType, const SHADER_DEFINES& defines) const
+	{
+		std::string keySource((const char*)&source.mHash, sizeof(source.mHash));
+		keySource += PermutationString(entryPoint, shaderType, defines);
+		keySource += mCompiler->GetVersion();
+		return hash64(keySource.c_str(), (int)keySource.size());
+	}
+
+	bool PrepareJob(const char* path, SHADER_TYPE shaderType, const SHADER_DEFINES& defines,
+		CompileJob& job)
+	{
+		if (!ValidCString(path) || !mCompiler){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return false;
+		}
+		job.mSource = GetSource(path);
+		if (!job.mSource)
+			return false;
+		job.mEntryPoint = GetEntryPoint(path, shaderType);
+		job.mShaderType = shaderType;
+		job.mDefines = defines;
+		std::sort(job.mDefines.begin(), job.mDefines.end());
+		job.mKey = BuildKey(*job.mSource, job.mEntryPoint, shaderType, job.mDefines);
+		return true;
+	}
+
+	void Compile(const CompileJob& job){
+		ByteArray byteCode;
+		bool compiled = mCompiler->Compile(job.mSource->mSource, job.mSource->mFiles[0].c_str(),
+			job.mEntryPoint.c_str(), job.mShaderType, job.mDefines, byteCode) && !byteCode.empty();
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (compiled){
+			++mStats.mCompiled;
+			mNewEntries[job.mKey] = std::move(byteCode);
+		}
+		else{
+			++mStats.mFailed;
+		}
+		mCompiling.erase(job.mKey);
+		mCompiledCondition.notify_all();
+	}
+
+	/// \return false when the permutation is already compiled in place.
+	bool Claim(UINT64 key){
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mCompiling.find(key);
+		if (it == mCompiling.end() || it->second.mStarted)
+			return false;
+		it->second.mStarted = true;
+		return true;
+	}
+
+	void Record(const char* path, SHADER_TYPE shaderType, const SHADER_DEFINES& sortedDefines,
+		UINT64 key)
+	{
+		auto permutation = PermutationString(path, shaderType, sortedDefines);
+		std::lock_guard<std::mutex> lock(mMutex);
+		mManifest.insert(permutation);
+		mUsedPermutations.insert(permutation);
+		mUsedKeys.insert(key);
+	}
+
+	ByteArray GetByteCode(const char* path, SHADER_TYPE shaderType,
+		const SHADER_DEFINES& defines, StringVector* outRelatedFiles)
+	{
+		CompileJob job;
+		if (!PrepareJob(path, shaderType, defines, job))
+			return{};
+		if (outRelatedFiles)
+			*outRelatedFiles = job.mSource->mFiles;
+		auto byteCode = FindByteCode(job);
+		if (!byteCode.empty())
+			Record(path, shaderType, job.mDefines, job.mKey);
+		return byteCode;
+	}
+
+	ByteArray FindByteCode(const CompileJob& job){
+		std::unique_lock<std::mutex> lock(mMutex);
+		auto packed = FindPacked(job.mKey);
+		if (packed){
+			auto data = (const char*)mMappedRegion.get_address() + packed->mOffset;
+			++mStats.mHits;
+			return ByteArray(data, data + packed->mSize);
+		}
+		auto it = mNewEntries.find(job.mKey);
+		if (it != mNewEntries.end()){
+			++mStats.mHits;
+			return it->second;
+		}
+		++mStats.mMisses;
+
+		// A queued task is never waited for. This can run on a worker and
+		// the task may be queued behind it, so the permutation is taken
+		// over and compiled in place. Only a compile already running on
+		// another thread is waited for.
+		auto& compiling = mCompiling[job.mKey];
+		if (compiling.mStarted){
+			mCompiledCondition.wait(lock, [&]{
+				return mCompiling.find(job.mKey) == mCompiling.end(); });
+		}
+		else{
+			compiling.mStarted = true;
+			lock.unlock();
+			Compile(job);
+			lock.lock();
+		}
+		it = mNewEntries.find(job.mKey);
+		if (it != mNewEntries.end())
+			return it->second;
+		return{};
+	}
+
+	bool CompileInBackground(const char* path, SHADER_TYPE shaderType,
+		const SHADER_DEFINES& defines)
+	{
+		CompileJob job;
+		if (!PrepareJob(path, shaderType, defines, job))
+			return false;
+		auto key = job.mKey;
+		TaskPtr task;
+		{
+			// Checked and inserted at once, so a permutation queued from two
+			// threads is compiled once.
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (FindPacked(key) ||
+				mNewEntries.find(key) != mNewEntries.end() ||
+				mCompiling.find(key) != mCompiling.end())
+				return false;
+			auto& compiling = mCompiling[key];
+			if (TaskScheduler::HasInstance()){
+				task = std::make_shared<CompileTask>(this, std::move(job));
+				compiling.mTask = task;
+			}
+			else{
+				compiling.mStarted = true;
+			}
+		}
+		if (task)
+			TaskScheduler::GetInstance().AddTask(task);
+		else
+			Compile(job);
+		return true;
+	}
+
+	unsigned WarmUp(){
+		unsigned num = 0;
+		std::string path;
+		SHADER_TYPE shaderType;
+		SHADER_DEFINES defines;
+		for (auto& permutation : mManifest){
+			if (ParsePermutationString(permutation, path, shaderType, defines) &&
+				CompileInBackground(path.c_str(), shaderType, defines))
+			{
+				++num;
+			}
+		}
+		return num;
+	}
+
+	void WaitBackgroundCompiling(){
+		std::vector<TaskPtr> tasks;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (auto& it : mCompiling){
+				if (it.second.mTask)
+					tasks.push_back(it.second.mTask);
+			}
+		}
+		// Tasks taken over by FindByteCode() still run and refer to this.
+		for (auto& task : tasks){
+			task->Sync();
+		}
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCompiledCondition.wait(lock, [&]{ return mCompiling.empty(); });
+	}
+
+	bool Save(bool pruneUnused){
+		WaitBackgroundCompiling();
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::vector<PackEntry> index;
+		ByteArray data;
+		data.resize(sizeof(PackHeader));
+		auto addEntry = [&](UINT64 key, const char* byteCode, size_t size){
+			PackEntry entry;
+			entry.mKey = key;
+			entry.mOffset = data.size();
+			entry.mSize = (unsigned)size;
+			entry.mPadding = 0;
+			index.push_back(entry);
+			data.insert(data.end(), byteCode, byteCode + size);
+		};
+		for (auto& it : mNewEntries){
+			if (!pruneUnused || mUsedKeys.find(it.first) != mUsedKeys.end())
+				addEntry(it.first, (const char*)&it.second[0], it.second.size());
+		}
+		auto base = (const char*)mMappedRegion.get_address();
+		for (unsigned i = 0; i < mNumPacked; ++i){
+			auto& packed = mPackIndex[i];
+			if (mNewEntries.find(packed.mKey) != mNewEntries.end())
+				continue;
+			if (pruneUnused && mUsedKeys.find(packed.mKey) == mUsedKeys.end())
+				continue;
+			if (packed.mOffset + packed.mSize <= mMappedRegion.get_size())
+				addEntry(packed.mKey, base + packed.mOffset, packed.mSize);
+		}
+		std::sort(index.begin(), index.end());
+
+		PackHeader header;
+		memcpy(header.mMark, shader_cache_mark, 2);
+		header.mPadding = 0;
+		header.mVersion = shader_cache_version;
+		header.mNumEntries = (unsigned)index.size();
+		header.mPadding2 = 0;
+		header.mIndexOffset = data.size();
+		memcpy(&data[0], &header, sizeof(header));
+		if (!index.empty()){
+			auto pos = data.size();
+			data.resize(pos + sizeof(PackEntry) * index.size());
+			memcpy(&data[pos], &index[0], sizeof(PackEntry) * index.size());
+		}
+
+		FileSystem::CreateDirectory(mCacheFile.c_str());
+		auto tempFile = mCacheFile + ".tmp";
+		if (!FileSystem::WriteBinaryFile(tempFile.c_str(), data)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to write the shader cache(%s)", tempFile.c_str()).c_str());
+			return false;
+		}
+		// the mapped file cannot be replaced.
+		UnmapPack();
+		FileSystem::Remove(mCacheFile.c_str());
+		bool renamed = FileSystem::Rename(tempFile.c_str(), mCacheFile.c_str()) == 0;
+		MapPack();
+		if (!renamed){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to replace the shader cache(%s)", mCacheFile.c_str()).c_str());
+			return false;
+		}
+		mNewEntries.clear();
+		return SaveManifest(pruneUnused);
+	}
+
+	bool SaveManifest(bool pruneUnused){
+		std::string text;
+		for (auto& permutation : pruneUnused ? mUsedPermutations : mManifest){
+			text += permutation;
+			text += '\n';
+		}
+		auto manifestFile = GetManifestFile();
+		if (text.empty()){
+			FileSystem::Remove(manifestFile.c_str());
+			return true;
+		}
+		return FileSystem::WriteTextFile(manifestFile.c_str(), text.c_str(), text.size());
+	}
+
+	void InvalidateSource(const char* path){
+		if (!ValidCString(path))
+			return;
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto it = mSources.begin(); it != mSources.end();){
+			bool related = false;
+			for (auto& file : it->second->mFiles){
+				if (_stricmp(file.c_str(), path) == 0){
+					related = true;
+					break;
+				}
+			}
+			if (related)
+				it = mSources.erase(it);
+			else
+				++it;
+		}
+	}
+
+	Stats GetStats() const{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Stats stats = mStats;
+		stats.mNumPacked = mNumPacked;
+		stats.mNumNew = (unsigned)mNewEntries.size();
+		return stats;
+	}
+};
+
+//---------------------------------------------------------------------------
+ShaderCache::Stats::Stats()
+	: mHits(0)
+	, mMisses(0)
+	, mCompiled(0)
+	, mFailed(0)
+	, mNumPacked(0)
+	, mNumNew(0)
+{
+}
+
+ShaderCachePtr ShaderCache::Create(const char* cacheFile, IShaderCompilerPtr compiler){
+	if (!ValidCString(cacheFile) || !compiler){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return 0;
+	}
+	return ShaderCachePtr(new ShaderCache(cacheFile, compiler), [](ShaderCache* obj){ delete obj; });
+}
+
+std::string ShaderCache::GetEntryPoint(const char* path, SHADER_TYPE shaderType){
+	std::string entryPoint = FileSystem::GetName(path);
+	switch (shaderType){
+	case SHADER_TYPE_VS:
+		entryPoint += "_VertexShader";
+		break;
+	case SHADER_TYPE_HS:
+		entryPoint += "_HullShader";
+		break;
+	case SHADER_TYPE_DS:
+		entryPoint += "_DomainShader";
+		break;
+	case SHADER_TYPE_GS:
+		entryPoint += "_GeometryShader";
+		break;
+	case SHADER_TYPE_PS:
+		entryPoint += "_PixelShader";
+		break;
+	case SHADER_TYPE_CS:
+		entryPoint += "_ComputeShader";
+		break;
+	default:
+		Logger::Log(FB_ERROR_LOG_ARG, "Unknown shader type.");
+	}
+	return entryPoint;
+}
+
+ShaderCache::ShaderCache(const char* cacheFile, IShaderCompilerPtr compiler)
+	: mImpl(new Impl(cacheFile, compiler)){
+}
+
+ShaderCache::~ShaderCache(){}
+
+const char* ShaderCache::GetCacheFile() const{
+	return mImpl->mCacheFile.c_str();
+}
+
+ByteArray ShaderCache::GetByteCode(const char* path, SHADER_TYPE shaderType,
+	const SHADER_DEFINES& defines, StringVector* outRelatedFiles)
+{
+	return mImpl->GetByteCode(path, shaderType, defines, outRelatedFiles);
+}
+
+void ShaderCache::CompileInBackground(const char* path, SHADER_TYPE shaderType,
+	const SHADER_DEFINES& defines)
+{
+	mImpl->CompileInBackground(path, shaderType, defines);
+}
+
+unsigned ShaderCache::WarmUp(){
+	return mImpl->WarmUp();
+}
+
+void ShaderCache::WaitBackgroundCompiling(){
+	mImpl->WaitBackgroundCompiling();
+}
+
+bool ShaderCache::Save(bool pruneUnused){
+	return mImpl->Save(pruneUnused);
+}
+
+void ShaderCache::InvalidateSource(const char* path){
+	mImpl->InvalidateSource(path);
+}
+
+ShaderCache::Stats ShaderCache::GetStats() const{
+	return mImpl->GetStats();
+}
@@ -0,0 +1,90 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "ShaderDefines.h"
+#include "RendererEnums.h"
+#include "IShaderCompiler.h"
+namespace fb{
+	FB_DECLARE_SMART_PTR(ShaderCache);
+	/** Platform neutral cache of compiled shader permutations.
+	A permutation is keyed by the hash of its include-expanded source, the
+	defines, the entry point and the compiler version, so the cache stays valid
+	across machines and packs and never depends on file modification times.
+	All permutations are stored in a single pack file which is memory mapped
+	on creation. Permutations used in a run are recorded to a manifest next to
+	the pack and compiled on the task scheduler by WarmUp() in the next run.
+	GetByteCode() and CompileInBackground() can be called from any thread.
+	Save() and InvalidateSource() are for the main thread while nothing is
+	loading.
+	*/
+	class FB_DLL_RENDERER ShaderCache{
+		FB_DECLARE_PIMPL_NON_COPYABLE(ShaderCache);
+		ShaderCache(const char* cacheFile, IShaderCompilerPtr compiler);
+		~ShaderCache();
+
+	public:
+		struct Stats{
+			Stats();
+
+			unsigned mHits;
+			unsigned mMisses;
+			unsigned mCompiled;
+			unsigned mFailed;
+			unsigned mNumPacked;
+			unsigned mNumNew;
+		};
+
+		/// \param cacheFile pack file path. The manifest is written to
+		/// \a cacheFile + ".manifest"
+		static ShaderCachePtr Create(const char* cacheFile, IShaderCompilerPtr compiler);
+		/// 'path name'_VertexShader, 'path name'_PixelShader, ...
+		static std::string GetEntryPoint(const char* path, SHADER_TYPE shaderType);
+
+		const char* GetCacheFile() const;
+		/// Returns the bytecode of the permutation. Compiles it in place when
+		/// it is neither cached nor being compiled in the background.
+		/// \param outRelatedFiles receives \a path followed by the included files.
+		/// \return empty when compiling failed.
+		ByteArray GetByteCode(const char* path, SHADER_TYPE shaderType,
+			const SHADER_DEFINES& defines, StringVector* outRelatedFiles);
+		/// Queues compiling of the permutation if it is not cached.
+		void CompileInBackground(const char* path, SHADER_TYPE shaderType,
+			const SHADER_DEFINES& defines);
+		/// Queues all permutations recorded in the manifest.
+		/// \return number of permutations queued.
+		unsigned WarmUp();
+		void WaitBackgroundCompiling();
+		/// Writes the pack file and the manifest.
+		/// \param pruneUnused drops packed permutations not used in this run.
+		bool Save(bool pruneUnused);
+		/// Call when a shader source or an include file has changed.
+		void InvalidateSource(const char* path);
+		Stats GetStats() const;
+	};
+}
@@ -47,6 +47,16 @@ TexturePtr GetTextureFromExistings(IPlatformTexturePtr platformShader) {
 	return 0;
 }
 
+void ReplacePlatformTexture(IPlatformTexturePtr from, IPlatformTexturePtr to) {
+	WriteLock lock(sAllTexturesLock);
+	for (auto it = sAllTextures.begin(); it != sAllTextures.end(); /**/){
+		IteratingWeakContainer(sAllTextures, it, texture);
+		if (texture->GetPlatformTexture() == from){
+			texture->SetPlatformTexture(to);
+		}
+	}
+}
+
 size_t Texture::sNextTextureID = 0;
 static std::unordered_map< SHADER_TYPE, VectorMap<int, TextureWeakPtr> > sBindedTextures;
 void SetBindedTexture(SHADER_TYPE shader, int startSlot, TexturePtr pTextures[], int num){
@@ -0,0 +1,373 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "TextureStreamer.h"
+#include "IPlatformRenderer.h"
+#include "IPlatformTexture.h"
+#include "FBStringLib/StringId.h"
+#include <mutex>
+#include <unordered_map>
+using namespace fb;
+
+namespace{
+	struct StreamedTexture{
+		std::string mPath;
+		TextureCreationOption mOptions;
+		TextureMipChain mMipChain;
+		// the coarse mips from this level are always resident.
+		int mMinResidentMip;
+		IPlatformTextureWeakPtr mResident;
+		int mResidentMip;
+		IPlatformTexturePtr mLoading;
+		int mLoadingMip;
+		// decided by the last update.
+		int mTargetMip;
+		Real mScreenSize;
+		unsigned mLastReported;
+		bool mReported;
+		bool mFailed;
+
+		StreamedTexture()
+			: mMinResidentMip(0)
+			, mResidentMip(0)
+			, mLoadingMip(0)
+			, mTargetMip(0)
+			, mScreenSize(0)
+			, mLastReported(0)
+			, mReported(false)
+			, mFailed(false)
+		{
+		}
+
+		size_t GetSizeInBytes(int firstMip) const{
+			size_t size = 0;
+			for (size_t i = firstMip; i < mMipChain.mMipSizes.size(); ++i){
+				size += mMipChain.mMipSizes[i];
+			}
+			return size;
+		}
+
+		bool IsReportedRecently(unsigned frame) const{
+			return mReported && frame - mLastReported <= TextureStreamer::ReportTimeout;
+		}
+
+		// textures reported recently come first, then the ones never reported.
+		Real GetPriority(unsigned frame) const{
+			if (!mReported)
+				return 0;
+			return IsReportedRecently(frame) ? mScreenSize + 1 : -1;
+		}
+
+		int GetDesiredMip(unsigned frame) const{
+			if (mFailed)
+				return mResidentMip;
+			if (!mReported)
+				return 0;
+			if (!IsReportedRecently(frame))
+				return mMinResidentMip;
+			// the coarsest mip which still covers the screen size.
+			int mip = 0;
+			while (mip < mMinResidentMip &&
+				std::max(mMipChain.mWidth >> (mip + 1), mMipChain.mHeight >> (mip + 1)) >= mScreenSize)
+			{
+				++mip;
+			}
+			return mip;
+		}
+	};
+
+	struct Replacement{
+		std::string mPath;
+		IPlatformTexturePtr mPrev;
+		IPlatformTexturePtr mCur;
+	};
+}
+
+//---------------------------------------------------------------------------
+class TextureStreamer::Impl{
+public:
+	mutable std::mutex mMutex;
+	size_t mBudget;
+	ReplaceCallback mCallback;
+	std::unordered_map<StringId, StreamedTexture> mTextures;
+	unsigned mFrame;
+	unsigned mNumLoaded;
+	unsigned mNumEvicted;
+
+	//---------------------------------------------------------------------------
+	Impl(size_t budgetInBytes, const ReplaceCallback& callback)
+		: mBudget(budgetInBytes)
+		, mCallback(callback)
+		, mFrame(0)
+		, mNumLoaded(0)
+		, mNumEvicted(0)
+	{
+	}
+
+	IPlatformTexturePtr CreateTexture(IPlatformRenderer& platformRenderer, const char* path,
+		const TextureCreationOption& options)
+	{
+		if (!ValidCString(path)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return 0;
+		}
+		TextureMipChain mipChain;
+		if (!platformRenderer.GetTextureMipChain(path, options, mipChain) || mipChain.mMipSizes.size() < 2)
+			return 0;
+		int lastMip = (int)mipChain.mMipSizes.size() - 1;
+		int minResidentMip = 0;
+		while (minResidentMip < lastMip &&
+			std::max(mipChain.mWidth >> minResidentMip, mipChain.mHeight >> minResidentMip) > MinResidentSize)
+		{
+			++minResidentMip;
+		}
+		// small enough to be loaded as a whole.
+		if (minResidentMip == 0)
+			return 0;
+
+		auto coarseOptions = options;
+		coarseOptions.firstMip = minResidentMip;
+		auto platformTexture = platformRenderer.CreateTexture(path, coarseOptions);
+		if (!platformTexture)
+			return 0;
+
+		StreamedTexture texture;
+		texture.mPath = path;
+		texture.mOptions = options;
+		texture.mMipChain = mipChain;
+		texture.mMinResidentMip = minResidentMip;
+		texture.mResident = platformTexture;
+		texture.mResidentMip = minResidentMip;
+		texture.mTargetMip = minResidentMip;
+		auto pathId = InternStringNoCase(path);
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTextures[pathId] = texture;
+		return platformTexture;
+	}
+
+	void ReportScreenSize(const char* path, Real pixels){
+		if (!ValidCString(path))
+			return;
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mTextures.find(GetStringIdNoCase(path));
+		if (it == mTextures.end())
+			return;
+		auto& texture = it->second;
+		if (texture.mReported && texture.mLastReported == mFrame)
+			texture.mScreenSize = std::max(texture.mScreenSize, pixels);
+		else
+			texture.mScreenSize = pixels;
+		texture.mLastReported = mFrame;
+		texture.mReported = true;
+	}
+
+	void Update(IPlatformRenderer& platformRenderer){
+		std::vector<Replacement> replacements;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			CollectLoaded(replacements);
+			auto sorted = DecideTargetMips();
+			RequestMips(platformRenderer, sorted);
+			++mFrame;
+		}
+		// out of the lock. The callback can create textures.
+		if (mCallback){
+			for (auto& it : replacements){
+				mCallback(it.mPath.c_str(), it.mPrev, it.mCur);
+			}
+		}
+	}
+
+	void CollectLoaded(std::vector<Replacement>& replacements){
+		for (auto it = mTextures.begin(); it != mTextures.end(); /**/){
+			auto& texture = it->second;
+			auto resident = texture.mResident.lock();
+			if (!resident){
+				// released by the users.
+				it = mTextures.erase(it);
+				continue;
+			}
+			if (texture.mLoading && texture.mLoading->IsReady()){
+				if (texture.mLoadingMip < texture.mResidentMip)
+					++mNumLoaded;
+				else
+					++mNumEvicted;
+				replacements.push_back(Replacement{ texture.mPath, resident, texture.mLoading });
+				texture.mResident = texture.mLoading;
+				texture.mResidentMip = texture.mLoadingMip;
+				texture.mLoading = 0;
+			}
+			++it;
+		}
+	}
+
+	// Spends the budget left by the coarse mips in the order of priority.
+	// Returns the textures sorted by the priority.
+	std::vector<StreamedTexture*> DecideTargetMips(){
+		std::vector<StreamedTexture*> sorted;
+		sorted.reserve(mTextures.size());
+		size_t required = 0;
+		for (auto& it : mTextures){
+			sorted.push_back(&it.second);
+			required += it.second.GetSizeInBytes(it.second.mMinResidentMip);
+		}
+		auto frame = mFrame;
+		std::stable_sort(sorted.begin(), sorted.end(), [frame](StreamedTexture* a, StreamedTexture* b){
+			return a->GetPriority(frame) > b->GetPriority(frame);
+		});
+		size_t available = mBudget > required ? mBudget - required : 0;
+		for (auto texture : sorted){
+			auto coarseSize = texture->GetSizeInBytes(texture->mMinResidentMip);
+			auto mip = texture->GetDesiredMip(frame);
+			while (mip < texture->mMinResidentMip && texture->GetSizeInBytes(mip) - coarseSize > available){
+				++mip;
+			}
+			available -= texture->GetSizeInBytes(mip) - coarseSize;
+			texture->mTargetMip = mip;
+		}
+		return sorted;
+	}
+
+	void RequestMips(IPlatformRenderer& platformRenderer, const std::vector<StreamedTexture*>& sorted){
+		unsigned numLoading = 0;
+		for (auto texture : sorted){
+			if (texture->mLoading)
+				++numLoading;
+		}
+		// evictions first. They are not limited since they give the memory back.
+		for (auto texture : sorted){
+			if (!texture->mLoading && texture->mTargetMip > texture->mResidentMip){
+				if (RequestMip(platformRenderer, *texture))
+					++numLoading;
+			}
+		}
+		for (auto texture : sorted){
+			if (numLoading >= MaxLoadings)
+				break;
+			if (!texture->mLoading && texture->mTargetMip < texture->mResidentMip){
+				if (RequestMip(platformRenderer, *texture))
+					++numLoading;
+			}
+		}
+	}
+
+	bool RequestMip(IPlatformRenderer& platformRenderer, StreamedTexture& texture){
+		auto options = texture.mOptions;
+		options.firstMip = texture.mTargetMip;
+		texture.mLoading = platformRenderer.CreateTexture(texture.mPath.c_str(), options);
+		if (!texture.mLoading){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString(
+				"Failed to stream the mip %d of the texture(%s)", texture.mTargetMip, texture.mPath.c_str()).c_str());
+			texture.mFailed = true;
+			return false;
+		}
+		texture.mLoadingMip = texture.mTargetMip;
+		return true;
+	}
+
+	int GetResidentMip(const char* path) const{
+		if (!ValidCString(path))
+			return -1;
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mTextures.find(GetStringIdNoCase(path));
+		if (it == mTextures.end())
+			return -1;
+		return it->second.mResidentMip;
+	}
+
+	Stats GetStats() const{
+		Stats stats;
+		std::lock_guard<std::mutex> lock(mMutex);
+		stats.mNumTextures = (unsigned)mTextures.size();
+		for (auto& it : mTextures){
+			if (it.second.mLoading)
+				++stats.mNumLoading;
+			stats.mResidentBytes += it.second.GetSizeInBytes(it.second.mResidentMip);
+		}
+		stats.mNumLoaded = mNumLoaded;
+		stats.mNumEvicted = mNumEvicted;
+		stats.mBudget = mBudget;
+		return stats;
+	}
+};
+
+//---------------------------------------------------------------------------
+TextureStreamer::Stats::Stats()
+	: mNumTextures(0)
+	, mNumLoading(0)
+	, mNumLoaded(0)
+	, mNumEvicted(0)
+	, mResidentBytes(0)
+	, mBudget(0)
+{
+}
+
+TextureStreamerPtr TextureStreamer::Create(size_t budgetInBytes, const ReplaceCallback& callback){
+	return TextureStreamerPtr(new TextureStreamer(budgetInBytes, callback),
+		[](TextureStreamer* obj){ delete obj; });
+}
+
+TextureStreamer::TextureStreamer(size_t budgetInBytes, const ReplaceCallback& callback)
+	: mImpl(new Impl(budgetInBytes, callback))
+{
+}
+
+TextureStreamer::~TextureStreamer(){
+}
+
+void TextureStreamer::SetBudget(size_t budgetInBytes){
+	std::lock_guard<std::mutex> lock(mImpl->mMutex);
+	mImpl->mBudget = budgetInBytes;
+}
+
+size_t TextureStreamer::GetBudget() const{
+	std::lock_guard<std::mutex> lock(mImpl->mMutex);
+	return mImpl->mBudget;
+}
+
+IPlatformTexturePtr TextureStreamer::CreateTexture(IPlatformRenderer& platformRenderer, const char* path,
+	const TextureCreationOption& options)
+{
+	return mImpl->CreateTexture(platformRenderer, path, options);
+}
+
+void TextureStreamer::ReportScreenSize(const char* path, Real pixels){
+	mImpl->ReportScreenSize(path, pixels);
+}
+
+void TextureStreamer::Update(IPlatformRenderer& platformRenderer){
+	mImpl->Update(platformRenderer);
+}
+
+int TextureStreamer::GetResidentMip(const char* path) const{
+	return mImpl->GetResidentMip(path);
+}
+
+TextureStreamer::Stats TextureStreamer::GetStats() const{
+	return mImpl->GetStats();
+}
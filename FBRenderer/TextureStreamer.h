@@ -0,0 +1,93 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "RendererStructs.h"
+#include <functional>
+namespace fb{
+	class IPlatformRenderer;
+	FB_DECLARE_SMART_PTR(IPlatformTexture);
+	FB_DECLARE_SMART_PTR(TextureStreamer);
+	/** Keeps the mips of file textures resident within a memory budget.
+	A streamed texture is created with its coarse mips only. Visible objects
+	report the size in pixels their textures cover on screen, and Update()
+	spends the budget on the largest ones by loading finer mips in the
+	background. When over budget, the finest mips of the smallest textures are
+	dropped first. Textures never reported, like the ones used by
+	post processing or the sky, get the budget left over by reported ones.
+	*/
+	class FB_DLL_RENDERER TextureStreamer{
+	public:
+		/// Called by Update() when a streamed texture got a new mip range.
+		/// Users of \a prev have to switch to \a cur.
+		typedef std::function<void(const char* path, IPlatformTexturePtr prev, IPlatformTexturePtr cur)>
+			ReplaceCallback;
+
+	private:
+		FB_DECLARE_PIMPL_NON_COPYABLE(TextureStreamer);
+		TextureStreamer(size_t budgetInBytes, const ReplaceCallback& callback);
+		~TextureStreamer();
+
+	public:
+		struct Stats{
+			Stats();
+
+			unsigned mNumTextures;
+			unsigned mNumLoading;
+			unsigned mNumLoaded;
+			unsigned mNumEvicted;
+			size_t mResidentBytes;
+			size_t mBudget;
+		};
+
+		/// Coarse mips smaller than or equal to this size are always resident.
+		static const int MinResidentSize = 64;
+		/// Number of mip loads in flight.
+		static const unsigned MaxLoadings = 4;
+		/// Textures not reported for this number of updates fall back to the
+		/// coarse mips.
+		static const unsigned ReportTimeout = 60;
+
+		static TextureStreamerPtr Create(size_t budgetInBytes, const ReplaceCallback& callback);
+
+		void SetBudget(size_t budgetInBytes);
+		size_t GetBudget() const;
+		/// Creates the coarse mips of the texture.
+		/// \return null when the texture cannot be streamed. Load it as usual.
+		IPlatformTexturePtr CreateTexture(IPlatformRenderer& platformRenderer, const char* path,
+			const TextureCreationOption& options);
+		/// \param pixels size of the texture on the screen. The largest report
+		/// between updates is used.
+		void ReportScreenSize(const char* path, Real pixels);
+		/// Call once per frame.
+		void Update(IPlatformRenderer& platformRenderer);
+		/// Finest mip level resident. -1 when \a path is not streamed.
+		int GetResidentMip(const char* path) const;
+		Stats GetStats() const;
+	};
+}
@@ -59,3 +59,6 @@ FB_DECLARE_SMART_PTR_STRUCT(ID3D11RasterizerState);
 FB_DECLARE_SMART_PTR_STRUCT(ID3D11BlendState);
 FB_DECLARE_SMART_PTR_STRUCT(ID3D11DepthStencilState);
 FB_DECLARE_SMART_PTR_STRUCT(ID3D11SamplerState);
+
+FB_DECLARE_SMART_PTR_STRUCT(IDWriteFactory);
+FB_DECLARE_SMART_PTR_STRUCT(IDWriteFontFace);
@@ -0,0 +1,184 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "GlyphRasterizerD3D11.h"
+#include "IUnknownDeleter.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBStringLib/StringLib.h"
+#include <dwrite.h>
+using namespace fb;
+
+static float GetEmSize(int pixelHeight){
+	return (float)pixelHeight;
+}
+
+FB_IMPLEMENT_STATIC_CREATE(GlyphRasterizerD3D11);
+
+GlyphRasterizerD3D11::GlyphRasterizerD3D11(){
+	IDWriteFactory* factory = 0;
+	HRESULT hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory),
+		(IUnknown**)&factory);
+	if (FAILED(hr)){
+		Logger::Log(FB_ERROR_LOG_ARG, "DWriteCreateFactory() failed!");
+		return;
+	}
+	mFactory = IDWriteFactoryPtr(factory, IUnknownDeleter());
+}
+
+GlyphRasterizerD3D11::~GlyphRasterizerD3D11(){
+
+}
+
+IDWriteFontFacePtr GlyphRasterizerD3D11::GetFontFace(const char* fontPath){
+	if (!mFactory || !ValidCString(fontPath))
+		return 0;
+	EnterSpinLock<SpinLockWaitSleep> lock(mFontFacesLock);
+	auto it = mFontFaces.find(fontPath);
+	if (it != mFontFaces.end())
+		return it->second;
+	// Failures are cached too not to open the file for every glyph.
+	auto& fontFace = mFontFaces[fontPath];
+	std::string absolutePath;
+	{
+		FileSystem::Lock fsLock;
+		std::string resourcePath;
+		if (!FileSystem::ResourceExists(fontPath, &resourcePath)){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Font file(%s) is not found.", fontPath).c_str());
+			return 0;
+		}
+		absolutePath = FileSystem::Absolute(resourcePath.c_str());
+	}
+	IDWriteFontFile* fontFile = 0;
+	HRESULT hr = mFactory->CreateFontFileReference(AnsiToWideMT(absolutePath.c_str()).c_str(),
+		0, &fontFile);
+	if (FAILED(hr)){
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to open font file(%s).", fontPath).c_str());
+		return 0;
+	}
+	BOOL isSupported = FALSE;
+	DWRITE_FONT_FILE_TYPE fileType;
+	DWRITE_FONT_FACE_TYPE faceType;
+	UINT32 numFaces = 0;
+	hr = fontFile->Analyze(&isSupported, &fileType, &faceType, &numFaces);
+	if (FAILED(hr) || !isSupported){
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Font file(%s) is not supported.", fontPath).c_str());
+		fontFile->Release();
+		return 0;
+	}
+	IDWriteFontFace* face = 0;
+	hr = mFactory->CreateFontFace(faceType, 1, &fontFile, 0, DWRITE_FONT_SIMULATIONS_NONE, &face);
+	fontFile->Release();
+	if (FAILED(hr)){
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Failed to create font face(%s).", fontPath).c_str());
+		return 0;
+	}
+	fontFace = IDWriteFontFacePtr(face, IUnknownDeleter());
+	return fontFace;
+}
+
+bool GlyphRasterizerD3D11::RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+	GlyphBitmap& outGlyph)
+{
+	if (pixelHeight <= 0)
+		return false;
+	auto face = GetFontFace(fontPath);
+	if (!face)
+		return false;
+
+	UINT32 cp = codePoint;
+	UINT16 glyphIndex = 0;
+	if (FAILED(face->GetGlyphIndices(&cp, 1, &glyphIndex)))
+		return false;
+	DWRITE_FONT_METRICS fontMetrics;
+	face->GetMetrics(&fontMetrics);
+	DWRITE_GLYPH_METRICS glyphMetrics;
+	if (FAILED(face->GetDesignGlyphMetrics(&glyphIndex, 1, &glyphMetrics, FALSE)))
+		return false;
+	float emSize = GetEmSize(pixelHeight);
+	float scale = emSize / fontMetrics.designUnitsPerEm;
+	outGlyph = GlyphBitmap();
+	outGlyph.mXAdvance = Round(glyphMetrics.advanceWidth * scale);
+
+	FLOAT advance = 0;
+	DWRITE_GLYPH_OFFSET offset = {};
+	DWRITE_GLYPH_RUN run = {};
+	run.fontFace = face.get();
+	run.fontEmSize = emSize;
+	run.glyphCount = 1;
+	run.glyphIndices = &glyphIndex;
+	run.glyphAdvances = &advance;
+	run.glyphOffsets = &offset;
+	IDWriteGlyphRunAnalysis* analysis = 0;
+	HRESULT hr = mFactory->CreateGlyphRunAnalysis(&run, 1.0f, 0,
+		DWRITE_RENDERING_MODE_NATURAL, DWRITE_MEASURING_MODE_NATURAL, 0.f, 0.f, &analysis);
+	if (FAILED(hr))
+		return false;
+	std::shared_ptr<IDWriteGlyphRunAnalysis> analysisHolder(analysis, IUnknownDeleter());
+	// Natural rendering mode gives ClearType textures only. The sub pixel
+	// coverages are averaged.
+	RECT bounds;
+	if (FAILED(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, &bounds)))
+		return false;
+	if (bounds.right <= bounds.left || bounds.bottom <= bounds.top)
+		return true; // blank glyph
+
+	int width = bounds.right - bounds.left;
+	int height = bounds.bottom - bounds.top;
+	ByteArray clearType(width * height * 3);
+	hr = analysis->CreateAlphaTexture(DWRITE_TEXTURE_CLEARTYPE_3x1, &bounds,
+		&clearType[0], (UINT32)clearType.size());
+	if (FAILED(hr))
+		return false;
+	outGlyph.mWidth = width;
+	outGlyph.mHeight = height;
+	// The run origin is on the base line.
+	outGlyph.mXOffset = bounds.left;
+	outGlyph.mYOffset = Round(fontMetrics.ascent * scale) + bounds.top;
+	outGlyph.mPixels.resize(width * height);
+	for (size_t i = 0; i < outGlyph.mPixels.size(); ++i){
+		auto sub = &clearType[i * 3];
+		outGlyph.mPixels[i] = (unsigned char)((sub[0] + sub[1] + sub[2]) / 3);
+	}
+	return true;
+}
+
+bool GlyphRasterizerD3D11::GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+	GlyphFontMetrics& outMetrics)
+{
+	if (pixelHeight <= 0)
+		return false;
+	auto face = GetFontFace(fontPath);
+	if (!face)
+		return false;
+	DWRITE_FONT_METRICS fontMetrics;
+	face->GetMetrics(&fontMetrics);
+	float scale = GetEmSize(pixelHeight) / fontMetrics.designUnitsPerEm;
+	outMetrics.mBase = Round(fontMetrics.ascent * scale);
+	outMetrics.mLineHeight = Round((fontMetrics.ascent + fontMetrics.descent + fontMetrics.lineGap) * scale);
+	return true;
+}
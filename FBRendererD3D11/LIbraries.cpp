@@ -32,6 +32,7 @@
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "D3DCompiler.lib")
 #pragma comment(lib, "d3d9.lib")
+#pragma comment(lib, "dwrite.lib")
 #pragma comment(lib, "zdll.lib")
 #pragma comment(lib, "DirectXTex.lib")
 #pragma comment(lib, "ScreenGrab.lib")
\ No newline at end of file
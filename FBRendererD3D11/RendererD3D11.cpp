@@ -30,6 +30,8 @@
 #include "VertexBufferD3D11.h"
 #include "IndexBufferD3D11.h"
 #include "ShaderD3D11.h"
+#include "ShaderCompilerD3D11.h"
+#include "GlyphRasterizerD3D11.h"
 #include "TextureD3D11.h"
 #include "RenderStatesD3D11.h"
 #include "InputLayoutD3D11.h"
@@ -94,6 +96,7 @@ using ScratchImagePtr = std::shared_ptr<DirectX::ScratchImage>;
 static DirectX::TexMetadata GetMetadata(const char* path);
 static ScratchImagePtr LoadScratchImage(const char* path, bool generateMip, DirectX::TexMetadata& metadata);
 static ScratchImagePtr ConvertScratchImage(const ScratchImagePtr& srcImage);
+static ScratchImagePtr DropFinerMips(const ScratchImagePtr& srcImage, int firstMip);
 //----------------------------------------------------------------------------
 class RendererD3D11::Impl
 {
@@ -134,6 +137,10 @@ public:
 	bool mStandBy;
 	bool mUseShaderCache;
 	bool mGenerateShaderCache;
+	ShaderCompilerD3D11Ptr mShaderCompiler;
+	// created by the first glyph request which can be in a worker thread.
+	GlyphRasterizerD3D11Ptr mGlyphRasterizer;
+	SpinLockWaitSleep mGlyphRasterizerLock;
 	std::string mTakeScreenshot;
 	/// The main thread is the thread in which the device is created.
 	/// Currently we are assuming the device is always created in the game update thread.
@@ -702,7 +709,11 @@ public:
 		texture->SetPath(path);
 		if (options.async) {			
 			auto metadata = GetMetadata(path);
-			texture->SetSize(Vec2I((int)metadata.width, (int)metadata.height));
+			// corrected after loading when the mips are generated.
+			auto firstMip = metadata.mipLevels > 1 ?
+				std::min((size_t)std::max(options.firstMip, 0), metadata.mipLevels - 1) : 0;
+			texture->SetSize(Vec2I(std::max((int)metadata.width >> firstMip, 1),
+				std::max((int)metadata.height >> firstMip, 1)));
 			FB_DECLARE_SMART_PTR(TextureLoadTask);
 			// Create load task - when finish 'with loaded data, create hardware texture and set to the texture'			
 			class TextureLoadTask : public Task
@@ -733,6 +744,8 @@ public:
 							--mImpl->mNumLoadingTexture;
 							return;
 						}				
+						scratchTexture = DropFinerMips(scratchTexture, mOptions.firstMip);
+						metadata = scratchTexture->GetMetadata();
 					
 						// set size
 						texture->SetSize(Vec2I(metadata.width, metadata.height));
@@ -779,6 +792,8 @@ public:
 					"Cannot create ScratchImage for %s", path).c_str());
 				return nullptr;
 			}			
+			scratchTexture = DropFinerMips(scratchTexture, options.firstMip);
+			metadata = scratchTexture->GetMetadata();
 			texture->SetSize(Vec2I(metadata.width, metadata.height));
 			texture->SetSizeInBytes(scratchTexture->GetPixelsSize());
 			// 'with loaded data create hardware texture and set to the texture.'			
@@ -790,6 +805,44 @@ public:
 		return texture;
 	}
 
+	bool GetTextureMipChain(const char* path, const TextureCreationOption& options,
+		TextureMipChain& outMipChain) {
+		if (!ValidCString(path)) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return false;
+		}
+		if (!FileSystem::ResourceExists(path))
+			return false;
+		auto metadata = GetMetadata(path);
+		if (metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 ||
+			metadata.width == 0 || metadata.height == 0)
+			return false;
+		auto mipLevels = metadata.mipLevels;
+		if (mipLevels == 1 && options.generateMip && !DirectX::IsCompressed(metadata.format)) {
+			// LoadScratchImage() will generate the full chain.
+			auto size = std::max(metadata.width, metadata.height);
+			while (size > 1) {
+				size >>= 1;
+				++mipLevels;
+			}
+		}
+		outMipChain.mWidth = (int)metadata.width;
+		outMipChain.mHeight = (int)metadata.height;
+		outMipChain.mMipSizes.clear();
+		bool compressed = DirectX::IsCompressed(metadata.format);
+		for (size_t i = 0; i < mipLevels; ++i) {
+			auto width = std::max(metadata.width >> i, (size_t)1);
+			auto height = std::max(metadata.height >> i, (size_t)1);
+			// CreateHardwareTextureFor() rejects them as the first mip.
+			if (compressed && (!MultipliesOfFour(width) || !MultipliesOfFour(height)))
+				break;
+			size_t rowPitch, slicePitch;
+			DirectX::ComputePitch(metadata.format, width, height, rowPitch, slicePitch);
+			outMipChain.mMipSizes.push_back(slicePitch);
+		}
+		return true;
+	}
+
 	struct TextureD3D11Hasher {
 		size_t operator()(const TextureD3D11WeakPtr& obj) const {
 			auto texture = obj.lock();
@@ -1423,6 +1476,10 @@ public:
 	{
 		includeProcessor->SetCurrentFolder(FileSystem::GetParentPath(filepath));
 		auto data = CompileShaderFunc(filepath, VSName, "vs_5_0", includeProcessor, shaderMacros, vs_cachekey, ignoreCache);
+		return CreateVS(pShader, std::move(data));
+	}
+
+	bool CreateVS(VertexShaderD3D11* pShader, ByteArray&& data) {
 		if (data.empty()) {
 			pShader->SetCompileFailed(true);
 			return false;
@@ -1452,6 +1509,10 @@ public:
 	{
 		includeProcessor->SetCurrentFolder(FileSystem::GetParentPath(filepath));
 		auto data = CompileShaderFunc(filepath, GSName, "gs_5_0", includeProcessor, shaderMacros, gs_cachekey, ignoreCache);
+		return CreateGS(pShader, data);
+	}
+
+	bool CreateGS(GeometryShaderD3D11* pShader, const ByteArray& data) {
 		if (data.empty()) {
 			pShader->SetCompileFailed(true);
 			return false;
@@ -1480,6 +1541,10 @@ public:
 	{
 		includeProcessor->SetCurrentFolder(FileSystem::GetParentPath(filepath));
 		auto data = CompileShaderFunc(filepath, PSName, "ps_5_0", includeProcessor, shaderMacros, ps_cachekey, ignoreCache);
+		return CreatePS(pShader, data);
+	}
+
+	bool CreatePS(PixelShaderD3D11* pShader, const ByteArray& data) {
 		if (data.empty()) {
 			pShader->SetCompileFailed(true);
 			return false;
@@ -1508,6 +1573,10 @@ public:
 	{
 		includeProcessor->SetCurrentFolder(FileSystem::GetParentPath(filepath));
 		auto data = CompileShaderFunc(filepath, CSName, "cs_5_0", includeProcessor, shaderMacros, cs_cachekey, ignoreCache);
+		return CreateCS(pShader, data);
+	}
+
+	bool CreateCS(ComputeShaderD3D11* pShader, const ByteArray& data) {
 		if (data.empty()) {
 			pShader->SetCompileFailed(true);
 			return false;
@@ -1757,6 +1826,57 @@ public:
 		return pShader;
 	}
 
+	IShaderCompilerPtr GetShaderCompiler() {
+		if (!mShaderCompiler)
+			mShaderCompiler = ShaderCompilerD3D11::Create();
+		return mShaderCompiler;
+	}
+
+	GlyphRasterizerD3D11Ptr GetGlyphRasterizer() {
+		EnterSpinLock<SpinLockWaitSleep> lock(mGlyphRasterizerLock);
+		if (!mGlyphRasterizer)
+			mGlyphRasterizer = GlyphRasterizerD3D11::Create();
+		return mGlyphRasterizer;
+	}
+
+	IPlatformShaderPtr CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+		const StringVector& relatedFiles)
+	{
+		ShaderD3D11Ptr pShader;
+		switch (shaderType) {
+		case SHADER_TYPE_VS: {
+			auto vs = VertexShaderD3D11::Create();
+			CreateVS(vs.get(), ByteArray(byteCode));
+			pShader = vs;
+			break;
+		}
+		case SHADER_TYPE_GS: {
+			auto gs = GeometryShaderD3D11::Create();
+			CreateGS(gs.get(), byteCode);
+			pShader = gs;
+			break;
+		}
+		case SHADER_TYPE_PS: {
+			auto ps = PixelShaderD3D11::Create();
+			CreatePS(ps.get(), byteCode);
+			pShader = ps;
+			break;
+		}
+		case SHADER_TYPE_CS: {
+			auto cs = ComputeShaderD3D11::Create();
+			CreateCS(cs.get(), byteCode);
+			pShader = cs;
+			break;
+		}
+		default:
+			Logger::Log(FB_ERROR_LOG_ARG, "Unsupported shader type.");
+			return 0;
+		}
+		// needed by ReloadShader()
+		pShader->SetRelatedFiles(relatedFiles);
+		return pShader;
+	}
+
 	bool ReloadShader(ShaderD3D11* shader, const SHADER_DEFINES& defines) {
 		if (!shader) {
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
@@ -2188,6 +2308,13 @@ public:
 		mImmediateContext->DrawIndexed(indexCount, startIndexLocation, startVertexLocation);
 	}
 
+	void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+		unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation) {
+		MAIN_THREAD_CHECK
+		mImmediateContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount,
+			startIndexLocation, startVertexLocation, startInstanceLocation);
+	}
+
 	void Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil) {
 		MAIN_THREAD_CHECK
 		Clear(r, g, b, a);
@@ -3069,10 +3196,25 @@ IPlatformTexturePtr RendererD3D11::CreateTexture(const char* path, const Texture
 	return mImpl->CreateTexture(path, options);
 }
 
+bool RendererD3D11::GetTextureMipChain(const char* path, const TextureCreationOption& options,
+	TextureMipChain& outMipChain) {
+	return mImpl->GetTextureMipChain(path, options, outMipChain);
+}
+
 IPlatformTexturePtr RendererD3D11::CreateTexture(void* data, int width, int height, PIXEL_FORMAT format, int numMips, BUFFER_USAGE usage, int  buffer_cpu_access,	int texture_type) {
 	return mImpl->CreateTexture(data, width, height, format, numMips, usage, buffer_cpu_access, texture_type);
 }
 
+bool RendererD3D11::RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+	GlyphBitmap& outGlyph) {
+	return mImpl->GetGlyphRasterizer()->RasterizeGlyph(fontPath, pixelHeight, codePoint, outGlyph);
+}
+
+bool RendererD3D11::GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+	GlyphFontMetrics& outMetrics) {
+	return mImpl->GetGlyphRasterizer()->GetGlyphFontMetrics(fontPath, pixelHeight, outMetrics);
+}
+
 IPlatformVertexBufferPtr RendererD3D11::CreateVertexBuffer(void* data, unsigned stride,	unsigned numVertices, BUFFER_USAGE usage, BUFFER_CPU_ACCESS_FLAG accessFlag) {
 	return mImpl->CreateVertexBuffer(data, stride, numVertices, usage, accessFlag);
 }
@@ -3110,6 +3252,15 @@ IPlatformShaderPtr RendererD3D11::CompileComputeShader(const char* code, const c
 	return mImpl->CompileComputeShader(code, entry, defines);
 }
 
+IShaderCompilerPtr RendererD3D11::GetShaderCompiler() {
+	return mImpl->GetShaderCompiler();
+}
+
+IPlatformShaderPtr RendererD3D11::CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+	const StringVector& relatedFiles) {
+	return mImpl->CreateShader(shaderType, byteCode, relatedFiles);
+}
+
 bool RendererD3D11::ReloadShader(ShaderD3D11* shader, const SHADER_DEFINES& defines) {
 	return mImpl->ReloadShader(shader, defines);
 }
@@ -3217,6 +3368,12 @@ void RendererD3D11::DrawIndexed(unsigned indexCount, unsigned startIndexLocation
 	mImpl->DrawIndexed(indexCount, startIndexLocation, startVertexLocation);
 }
 
+void RendererD3D11::DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+	unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation) {
+	mImpl->DrawIndexedInstanced(indexCountPerInstance, instanceCount,
+		startIndexLocation, startVertexLocation, startInstanceLocation);
+}
+
 void RendererD3D11::Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil) {
 	mImpl->Clear(r, g, b, a, z, stencil);
 }
@@ -3411,6 +3568,31 @@ static ScratchImagePtr LoadScratchImage(const char* path, bool generateMip, Dire
 	return scratchImg;
 }
 
+// Returns an image which starts from the mip level 'firstMip'.
+static ScratchImagePtr DropFinerMips(const ScratchImagePtr& srcImage, int firstMip) {
+	auto& metadata = srcImage->GetMetadata();
+	if (firstMip <= 0 || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1)
+		return srcImage;
+	size_t mip = std::min((size_t)firstMip, metadata.mipLevels - 1);
+	if (mip == 0)
+		return srcImage;
+	auto newScratchImage = std::make_shared<DirectX::ScratchImage>();
+	auto ret = newScratchImage->Initialize2D(metadata.format, std::max(metadata.width >> mip, (size_t)1),
+		std::max(metadata.height >> mip, (size_t)1), 1, metadata.mipLevels - mip);
+	if (FAILED(ret)) {
+		Logger::Log(FB_ERROR_LOG_ARG, "Failed to initialize the mip sub range.");
+		return srcImage;
+	}
+	for (size_t i = mip; i < metadata.mipLevels; ++i) {
+		auto src = srcImage->GetImage(i, 0, 0);
+		auto dest = newScratchImage->GetImage(i - mip, 0, 0);
+		if (!src || !dest)
+			return srcImage;
+		memcpy(dest->pixels, src->pixels, std::min(src->slicePitch, dest->slicePitch));
+	}
+	return newScratchImage;
+}
+
 static ScratchImagePtr ConvertScratchImage(const ScratchImagePtr& srcImage) {
 	auto& metadata = srcImage->GetMetadata();
 	if (metadata.format == DXGI_FORMAT_B8G8R8A8_UNORM) {
@@ -86,9 +86,15 @@ namespace fb
 		// Resource creation
 		void SetShaderCacheOption(bool useShaderCache, bool generateCache);
 		IPlatformTexturePtr CreateTexture(const char* path, const TextureCreationOption& options);
+		bool GetTextureMipChain(const char* path, const TextureCreationOption& options,
+			TextureMipChain& outMipChain) OVERRIDE;
 		IPlatformTexturePtr CreateTexture(void* data, int width, int height,
 			PIXEL_FORMAT format, int numMips, BUFFER_USAGE usage, int  buffer_cpu_access,
 			int texture_type);
+		bool RasterizeGlyph(const char* fontPath, int pixelHeight, unsigned codePoint,
+			GlyphBitmap& outGlyph) OVERRIDE;
+		bool GetGlyphFontMetrics(const char* fontPath, int pixelHeight,
+			GlyphFontMetrics& outMetrics) OVERRIDE;
 		IPlatformVertexBufferPtr CreateVertexBuffer(void* data, unsigned stride,
 			unsigned numVertices, BUFFER_USAGE usage, BUFFER_CPU_ACCESS_FLAG accessFlag);
 		IPlatformIndexBufferPtr CreateIndexBuffer(void* data, unsigned int numIndices,
@@ -104,6 +110,9 @@ namespace fb
 			const SHADER_DEFINES& defines, bool ignoreCache) OVERRIDE;
 		IPlatformShaderPtr CompileComputeShader(const char* code, const char* entry, 
 			const SHADER_DEFINES& defines) OVERRIDE;
+		IShaderCompilerPtr GetShaderCompiler() OVERRIDE;
+		IPlatformShaderPtr CreateShader(SHADER_TYPE shaderType, const ByteArray& byteCode,
+			const StringVector& relatedFiles) OVERRIDE;
 		bool ReloadShader(ShaderD3D11* shader, const SHADER_DEFINES& defines);
 
 		IPlatformInputLayoutPtr CreateInputLayout(const INPUT_ELEMENT_DESCS& descs,
@@ -139,6 +148,8 @@ namespace fb
 		// Drawing
 		void Draw(unsigned int vertexCount, unsigned int startVertexLocation);
 		void DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned startVertexLocation);				
+		void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount,
+			unsigned startIndexLocation, unsigned startVertexLocation, unsigned startInstanceLocation);
 		void Clear(Real r, Real g, Real b, Real a, Real z, unsigned char stencil);
 		void Clear(Real r, Real g, Real b, Real a);
 		void ClearDepthStencil(Real z, UINT8 stencil);
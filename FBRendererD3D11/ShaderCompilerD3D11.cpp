@@ -0,0 +1,112 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "ShaderCompilerD3D11.h"
+#include "IUnknownDeleter.h"
+#include "D3D11Types.h"
+using namespace fb;
+
+static DWORD GetShaderFlags(){
+	DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+	dwShaderFlags |= D3DCOMPILE_DEBUG;
+	dwShaderFlags |= D3DCOMPILE_PREFER_FLOW_CONTROL;
+	dwShaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+	return dwShaderFlags;
+}
+
+static const char* GetShaderModel(SHADER_TYPE shaderType){
+	switch (shaderType){
+	case SHADER_TYPE_VS:
+		return "vs_5_0";
+	case SHADER_TYPE_HS:
+		return "hs_5_0";
+	case SHADER_TYPE_DS:
+		return "ds_5_0";
+	case SHADER_TYPE_GS:
+		return "gs_5_0";
+	case SHADER_TYPE_PS:
+		return "ps_5_0";
+	case SHADER_TYPE_CS:
+		return "cs_5_0";
+	}
+	return 0;
+}
+
+FB_IMPLEMENT_STATIC_CREATE(ShaderCompilerD3D11);
+
+ShaderCompilerD3D11::ShaderCompilerD3D11()
+	: mVersion(FormatString("d3dcompiler_%d_%x_sm5_0", D3D_COMPILER_VERSION, GetShaderFlags()))
+{
+}
+
+ShaderCompilerD3D11::~ShaderCompilerD3D11(){
+
+}
+
+const char* ShaderCompilerD3D11::GetVersion() const{
+	return mVersion.c_str();
+}
+
+bool ShaderCompilerD3D11::Compile(const std::string& source, const char* sourceName,
+	const char* entryPoint, SHADER_TYPE shaderType, const SHADER_DEFINES& defines,
+	ByteArray& outByteCode)
+{
+	auto shaderModel = GetShaderModel(shaderType);
+	if (source.empty() || !ValidCString(entryPoint) || !shaderModel){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return false;
+	}
+	std::vector<D3D_SHADER_MACRO> shaderMacros;
+	for (auto& define : defines){
+		shaderMacros.push_back(D3D_SHADER_MACRO());
+		shaderMacros.back().Name = define.mName.c_str();
+		shaderMacros.back().Definition = define.mValue.c_str();
+	}
+	shaderMacros.push_back(D3D_SHADER_MACRO());
+	shaderMacros.back().Name = 0;
+	shaderMacros.back().Definition = 0;
+
+	// includes are already expanded.
+	ID3DBlob* bytecodeBlob = 0;
+	ID3DBlob* errorBlob = 0;
+	auto hr = D3DCompile(&source[0], source.size(), sourceName, &shaderMacros[0], 0,
+		entryPoint, shaderModel, GetShaderFlags(), 0, &bytecodeBlob, &errorBlob);
+	ID3DBlobPtr bytecodeBlobP = ID3DBlobPtr(bytecodeBlob, IUnknownDeleter());
+	ID3DBlobPtr errBlobP = ID3DBlobPtr(errorBlob, IUnknownDeleter());
+	if (FAILED(hr)){
+		Logger::Log(FB_ERROR_LOG_ARG, FormatString("Compiling %s(%s) failed!", sourceName, entryPoint).c_str());
+		if (errorBlob)
+			Logger::Log(FB_DEFAULT_LOG_ARG, (const char*)errorBlob->GetBufferPointer());
+		return false;
+	}
+	auto data = (const char*)bytecodeBlob->GetBufferPointer();
+	outByteCode.assign(data, data + bytecodeBlob->GetBufferSize());
+	return true;
+}
@@ -29,6 +29,7 @@
 #include "FBCommonHeaders/Types.h"
 #include "FBMathLib/Vec4.h"
 #include "DirectionalLightIndex.h"
+#include "ShadowCascadeBounds.h"
 
 namespace fb{
 	struct DirectionalLightInfo{
@@ -43,6 +44,7 @@ namespace fb{
 	struct POINT_LIGHT_CONSTANTS;
 	class Transformation;
 	class AABB;
+	class Mat44;
 	FB_DECLARE_SMART_PTR(PointLight);
 	FB_DECLARE_SMART_PTR(SpatialSceneObject);
 	FB_DECLARE_SMART_PTR(SceneObject);
@@ -60,6 +62,10 @@ namespace fb{
 		virtual void MakeVisibleSet(ICamera* cam) = 0;
 		virtual void PreRender(const RenderParam& prarm, RenderParamOut* paramOut) = 0;
 		virtual void Render(const RenderParam& prarm, RenderParamOut* paramOut) = 0;
+		/// Collects the opaque shadow casters of every cascade in one pass.
+		virtual void MakeShadowCasterSets(const Mat44& lightView, const ShadowCascadeBounds* cascades, unsigned numCascades) = 0;
+		/// Renders the casters of the cascade collected by MakeShadowCasterSets().
+		virtual void RenderShadowCasters(unsigned cascade, const RenderParam& param, RenderParamOut* paramOut) = 0;
 		virtual void PreRenderCloudVolumes(const RenderParam& prarm, RenderParamOut* paramOut) = 0;
 		virtual void RenderCloudVolumes(const RenderParam& prarm, RenderParamOut* paramOut) = 0;			
 		virtual const Color& GetFogColor() const = 0;
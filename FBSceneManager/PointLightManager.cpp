@@ -34,21 +34,54 @@
 #include "FBRenderer/Renderer.h"
 #include "FBRenderer/RendererOptions.h"
 #include "EssentialEngineData/shaders/Constants.h"
+#include "FBTimer/Timer.h"
+#include "FBCommonHeaders/SpinLock.h"
+#include "FBMathLib/BoundingVolume.h"
 using namespace fb;
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define FB_POINT_LIGHT_SSE 1
+#endif
+
+static const unsigned MaxPointLights = PointLightManager::MaxPointLights;
+static const unsigned LightMaskWords = MaxPointLights / 64;
+static const int MaxGridDim = 16;
+
 class PointLightManager::Impl{
 public:
 	typedef std::vector< PointLightWeakPtr > PointLights;
 	SceneWeakPtr mScene;
 	PointLights mPointLights;
 
+	// Snapshot of the enabled lights taken once per frame.
+	// SoA and padded to 4 so four lights are tested at once.
+	std::vector<PointLightPtr> mBinnedLights;
+	std::vector<float> mPosX, mPosY, mPosZ, mRange;
+	std::vector<Vec3> mColorPowered;
+	// Uniform grid over the light spheres. Light indices of the cell i are
+	// mCellLights[mCellStart[i] .. mCellStart[i+1]).
+	Vec3 mGridMin;
+	Vec3 mInvCellSize;
+	int mGridDim[3];
+	std::vector<unsigned> mCellStart;
+	std::vector<unsigned short> mCellLights;
+	std::atomic<unsigned> mBinnedFrame;
+	SpinLockWaitSleep mBinLock;
+
+	Impl()
+		: mBinnedFrame((unsigned)-1)
+	{
+		mGridDim[0] = mGridDim[1] = mGridDim[2] = 0;
+	}
+
 	void SetScene(ScenePtr scene){
 		mScene = scene;
 	}
 
 	PointLightPtr CreatePointLight(const Vec3& pos, Real range, const Vec3& color, Real intensity, Real lifeTime, bool manualDeletion)
 	{
-		if (mPointLights.size() > 20)
+		if (mPointLights.size() >= MaxPointLights)
 			return nullptr;
 
 		auto scene = mScene.lock();
@@ -63,8 +96,6 @@ public:
 
 	void Update(Real dt)
 	{
-		static std::vector<unsigned> deleted;
-
 		for (auto it = mPointLights.begin(); it != mPointLights.end();){
 			auto p = it->lock();
 			if (!p){
@@ -85,64 +116,218 @@ public:
 		}		
 	}
 
-	void GatherPointLightData(const BoundingVolume* boundingVolume, const Transformation& transform, POINT_LIGHT_CONSTANTS* plConst)
-	{	
-		if (SceneManager::GetInstance().GetOptions()->r_noPointLight) {
-			plConst->gPointLightColor[0].w = 0;
+	void BinPointLightsIfNeeded(){
+		auto curFrame = gpTimer ? gpTimer->GetFrame() : 0;
+		if (mBinnedFrame == curFrame)
 			return;
+		EnterSpinLock<SpinLockWaitSleep> lock(mBinLock);
+		if (mBinnedFrame == curFrame)
+			return;
+		BinPointLights();
+		mBinnedFrame = curFrame;
+	}
+
+	void BinPointLights()
+	{
+		mBinnedLights.clear();
+		mPosX.clear(); mPosY.clear(); mPosZ.clear(); mRange.clear();
+		mColorPowered.clear();
+		mCellStart.clear();
+		mCellLights.clear();
+		mGridDim[0] = mGridDim[1] = mGridDim[2] = 0;
+
+		Vec3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		Vec3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		Real maxRange = 0;
+		for (auto& it : mPointLights){
+			auto p = it.lock();
+			if (!p || !p->GetEnabled())
+				continue;
+			auto range = p->GetRange();
+			if (range <= 0)
+				continue;
+			auto& pos = p->GetPosition();
+			mBinnedLights.push_back(p);
+			mPosX.push_back(pos.x);
+			mPosY.push_back(pos.y);
+			mPosZ.push_back(pos.z);
+			mRange.push_back(range);
+			mColorPowered.push_back(p->GetColorPowered());
+			boundsMin.KeepLesser(pos - range);
+			boundsMax.KeepGreater(pos + range);
+			maxRange = std::max(maxRange, range);
+		}
+		auto numLights = mBinnedLights.size();
+		if (numLights == 0)
+			return;
+		// Padding lanes never pass the range test.
+		while (mPosX.size() % 4){
+			mPosX.push_back(FLT_MAX);
+			mPosY.push_back(FLT_MAX);
+			mPosZ.push_back(FLT_MAX);
+			mRange.push_back(-1.f);
 		}
 
-		struct GatheredData
-		{
-			GatheredData(Real intensity, unsigned idx)
-				:mIntensity(intensity), mIndex(idx)
-			{
+		// Cells about the size of the largest light.
+		auto extent = boundsMax - boundsMin;
+		unsigned numCells = 1;
+		for (int i = 0; i < 3; ++i){
+			mGridDim[i] = std::max(1, std::min(MaxGridDim, (int)ceil(extent[i] / maxRange)));
+			mInvCellSize[i] = mGridDim[i] / std::max(extent[i], 0.001f);
+			numCells *= mGridDim[i];
+		}
+		mGridMin = boundsMin;
 
+		int cellMin[3], cellMax[3];
+		mCellStart.assign(numCells + 1, 0);
+		for (unsigned l = 0; l < numLights; ++l){
+			GetCellRange(Vec3(mPosX[l], mPosY[l], mPosZ[l]), mRange[l], cellMin, cellMax);
+			ForEachCell(cellMin, cellMax, [this](unsigned cell){
+				++mCellStart[cell + 1];
+			});
+		}
+		for (unsigned c = 0; c < numCells; ++c){
+			mCellStart[c + 1] += mCellStart[c];
+		}
+		mCellLights.resize(mCellStart[numCells]);
+		std::vector<unsigned> fill(mCellStart.begin(), mCellStart.end() - 1);
+		for (unsigned l = 0; l < numLights; ++l){
+			GetCellRange(Vec3(mPosX[l], mPosY[l], mPosZ[l]), mRange[l], cellMin, cellMax);
+			ForEachCell(cellMin, cellMax, [this, &fill, l](unsigned cell){
+				mCellLights[fill[cell]++] = (unsigned short)l;
+			});
+		}
+	}
+
+	// Returns false when the sphere is outside of the grid.
+	bool GetCellRange(const Vec3& center, Real radius, int cellMin[3], int cellMax[3]) const{
+		for (int i = 0; i < 3; ++i){
+			cellMin[i] = (int)floor((center[i] - radius - mGridMin[i]) * mInvCellSize[i]);
+			cellMax[i] = (int)floor((center[i] + radius - mGridMin[i]) * mInvCellSize[i]);
+			if (cellMax[i] < 0 || cellMin[i] >= mGridDim[i])
+				return false;
+			cellMin[i] = std::max(cellMin[i], 0);
+			cellMax[i] = std::min(cellMax[i], mGridDim[i] - 1);
+		}
+		return true;
+	}
+
+	template <typename Func>
+	void ForEachCell(const int cellMin[3], const int cellMax[3], Func func) const{
+		for (int z = cellMin[2]; z <= cellMax[2]; ++z){
+			for (int y = cellMin[1]; y <= cellMax[1]; ++y){
+				unsigned row = (z * mGridDim[1] + y) * mGridDim[0];
+				for (int x = cellMin[0]; x <= cellMax[0]; ++x){
+					func(row + x);
+				}
 			}
-			Real mIntensity;
-			unsigned mIndex;
-		};
-		static std::vector<GatheredData> gathered;
-		gathered.reserve(50);
-
-		unsigned i = 0;
-		for (auto it = mPointLights.begin(); it != mPointLights.end(); /**/)
-		{		
-			IteratingWeakContainer(mPointLights, it, p);
-			if (!p->GetEnabled())
-				continue;
-			Ray ray(p->GetPosition(), transform.GetTranslation() - p->GetPosition());
-			Ray localRay = transform.ApplyInverse(ray, false);
-			auto iresult = localRay.Intersects(boundingVolume);
-			Real dist = iresult.second;
-			Real range = p->GetRange();
-			if (dist < range)
-			{
-				auto intensity = p->GetIntensityScoreAtRange(dist);
-				gathered.push_back(GatheredData(intensity, i));
+		}
+	}
+
+	struct GatheredData
+	{
+		Real mIntensity;
+		unsigned mIndex;
+	};
+
+	// Keeps the MAX_POINT_LIGHT strongest lights.
+	struct StrongestLights
+	{
+		GatheredData mData[MAX_POINT_LIGHT];
+		unsigned mNumGathered;
+		unsigned mNumInRange;
+
+		StrongestLights() : mNumGathered(0), mNumInRange(0) {}
+
+		void Add(Real intensity, unsigned index){
+			++mNumInRange;
+			unsigned pos = mNumGathered;
+			while (pos > 0 && mData[pos - 1].mIntensity < intensity){
+				if (pos < MAX_POINT_LIGHT)
+					mData[pos] = mData[pos - 1];
+				--pos;
+			}
+			if (pos < MAX_POINT_LIGHT){
+				mData[pos].mIntensity = intensity;
+				mData[pos].mIndex = index;
+				mNumGathered = std::min(mNumGathered + 1, (unsigned)MAX_POINT_LIGHT);
 			}
-			++i;
 		}
+	};
 
-		std::sort(gathered.begin(), gathered.end(), [](const GatheredData& a, const GatheredData& b){
-			return a.mIntensity > b.mIntensity;
+	/// Tests four lights from 'first' against the sphere and adds the ones in range.
+	void TestLights(unsigned first, unsigned laneMask, const Vec3& center, Real radius, 
+		StrongestLights& strongest) const
+	{
+		float dist[4];
+		int inRange;
+#if FB_POINT_LIGHT_SSE
+		auto dx = _mm_sub_ps(_mm_loadu_ps(&mPosX[first]), _mm_set1_ps(center.x));
+		auto dy = _mm_sub_ps(_mm_loadu_ps(&mPosY[first]), _mm_set1_ps(center.y));
+		auto dz = _mm_sub_ps(_mm_loadu_ps(&mPosZ[first]), _mm_set1_ps(center.z));
+		auto distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		auto d = _mm_max_ps(_mm_sub_ps(_mm_sqrt_ps(distSq), _mm_set1_ps(radius)), _mm_setzero_ps());
+		inRange = _mm_movemask_ps(_mm_cmplt_ps(d, _mm_loadu_ps(&mRange[first])));
+		_mm_storeu_ps(dist, d);
+#else
+		inRange = 0;
+		for (int i = 0; i < 4; ++i){
+			auto l = first + i;
+			Vec3 delta(mPosX[l] - center.x, mPosY[l] - center.y, mPosZ[l] - center.z);
+			dist[i] = std::max(delta.Length() - radius, 0.f);
+			if (dist[i] < mRange[l])
+				inRange |= 1 << i;
 		}
-		);
+#endif
+		inRange &= laneMask;
+		for (int i = 0; inRange; ++i, inRange >>= 1){
+			if (inRange & 1){
+				auto l = first + i;
+				strongest.Add(mBinnedLights[l]->GetIntensityScoreAtRange(dist[i]), l);
+			}
+		}
+	}
 
+	void GatherPointLightData(const BoundingVolume* boundingVolume, const Transformation& transform, POINT_LIGHT_CONSTANTS* plConst)
+	{	
 		plConst->gPointLightColor[0].w = 0;
-		int count = std::min(3, (int)gathered.size());
-		unsigned validNumber = 0;
-		for (int i = 0; i < count; i++)
-		{
-			PointLightPtr p = mPointLights[gathered[i].mIndex].lock();
-			if (p){
-				plConst->gPointLightPos[validNumber] = Vec4(p->GetPosition(), p->GetRange());
-				plConst->gPointLightColor[validNumber] = Vec4(p->GetColorPowered(), (Real)count);
-				++validNumber;
+		if (SceneManager::GetInstance().GetOptions()->r_noPointLight) {
+			return;
+		}
+		BinPointLightsIfNeeded();
+		if (mBinnedLights.empty())
+			return;
+
+		// Distances are measured to the world bounding sphere of the object.
+		auto center = transform.ApplyForward(boundingVolume->GetCenter());
+		auto radius = boundingVolume->GetRadius() * transform.GetNorm();
+		int cellMin[3], cellMax[3];
+		if (!GetCellRange(center, radius, cellMin, cellMax))
+			return;
+		UINT64 candidates[LightMaskWords] = {};
+		ForEachCell(cellMin, cellMax, [this, &candidates](unsigned cell){
+			for (auto i = mCellStart[cell]; i < mCellStart[cell + 1]; ++i){
+				auto l = mCellLights[i];
+				candidates[l / 64] |= (UINT64)1 << (l % 64);
+			}
+		});
+
+		StrongestLights strongest;
+		for (unsigned w = 0; w < LightMaskWords; ++w){
+			auto bits = candidates[w];
+			for (unsigned block = 0; bits; ++block, bits >>= 4){
+				if (bits & 0xf)
+					TestLights(w * 64 + block * 4, (unsigned)(bits & 0xf), center, radius, strongest);
 			}
 		}
 
-		gathered.clear();
+		auto count = std::min((unsigned)MAX_POINT_LIGHT, strongest.mNumInRange);
+		for (unsigned i = 0; i < strongest.mNumGathered; i++)
+		{
+			auto l = strongest.mData[i].mIndex;
+			plConst->gPointLightPos[i] = Vec4(mPosX[l], mPosY[l], mPosZ[l], mRange[l]);
+			plConst->gPointLightColor[i] = Vec4(mColorPowered[l], (Real)count);
+		}
 	}
 
 	unsigned GetNumPointLights() const
@@ -171,6 +356,12 @@ void PointLightManager::Update(Real dt) {
 	mImpl->Update(dt);
 }
 
+void PointLightManager::BinPointLights() {
+	EnterSpinLock<SpinLockWaitSleep> lock(mImpl->mBinLock);
+	mImpl->BinPointLights();
+	mImpl->mBinnedFrame = gpTimer ? gpTimer->GetFrame() : 0;
+}
+
 void PointLightManager::GatherPointLightData(const BoundingVolume* aabb, const Transformation& transform, POINT_LIGHT_CONSTANTS* plConst) {
 	mImpl->GatherPointLightData(aabb, transform, plConst);
 }
@@ -34,17 +34,23 @@ namespace fb
 	FB_DECLARE_SMART_PTR(Scene);
 	FB_DECLARE_SMART_PTR(PointLight);
 	FB_DECLARE_SMART_PTR(PointLightManager);
-	class PointLightManager
+	class FB_DLL_SCENEMANAGER PointLightManager
 	{
 		FB_DECLARE_PIMPL_NON_COPYABLE(PointLightManager);
 		PointLightManager();
 
 	public:
+		static const unsigned MaxPointLights = 256;
 		static PointLightManagerPtr Create();
 
 		void SetScene(ScenePtr scene);
 		PointLightPtr CreatePointLight(const Vec3& pos, Real range, const Vec3& color, Real intensity, Real lifeTime, bool manualDeletion);		
 		void Update(Real dt);
+		/// Assigns the enabled lights to a uniform grid. The first
+		/// GatherPointLightData() of a frame calls it when it is not called
+		/// explicitly in the frame.
+		void BinPointLights();
+		/// Finds the strongest lights reaching the object. Thread safe.
 		void GatherPointLightData(const BoundingVolume* aabb, const Transformation& transform, POINT_LIGHT_CONSTANTS* plConst);
 		unsigned GetNumPointLights() const;
 	};
@@ -29,11 +29,14 @@
 #include "Scene.h"
 #include "DirectionalLight.h"
 #include "SpatialSceneObject.h"
+#include "SpatialObjectStorage.h"
 #include "PointLightManager.h"
 #include "FBRenderer/ICamera.h"
 #include "FBRenderer/RenderPass.h"
+#include "FBMathLib/Mat44.h"
 #include "FBMathLib/Color.h"
 #include "FBCommonHeaders/VectorMap.h"
+#include "FBCommonHeaders/RadixSort.h"
 #include "FBTimer/Timer.h"
 #include "FBStringLib/StringLib.h"
 #include "FBSceneObjectFactory/SkySphere.h"// this doesn't make denpendency
@@ -55,12 +58,27 @@ public:
 	typedef std::vector<SceneObject*> OBJECTS_RAW;
 	OBJECTS_WEAK mObjects;
 	SPATIAL_OBJECTS_WEAK mSpatialObjects;
-	VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mVisibleObjectsMain;
-	//VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mVisibleObjectsLight;
-	VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mPreRenderList;
-	VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mVisibleTransparentObjects;
-	VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mVisibleAfterObjects;
-	VectorMap<ICamera*, SPATIAL_OBJECTS_RAW> mVisibleAfterUI;
+	struct CameraData{
+		SPATIAL_OBJECTS_RAW mVisibleObjectsMain;
+		SPATIAL_OBJECTS_RAW mPreRenderList;
+		SPATIAL_OBJECTS_RAW mVisibleTransparentObjects;
+		SPATIAL_OBJECTS_RAW mVisibleAfterObjects;
+		SPATIAL_OBJECTS_RAW mVisibleAfterUI;
+		unsigned mLastPreRenderFrame;
+		unsigned mLastMakeVisibleSetFrame;
+		// ICamera::GetIndexSerial() of the owner. 0 for an unused slot.
+		unsigned mCameraSerial;
+
+		CameraData()
+			: mLastPreRenderFrame((unsigned)-1)
+			, mLastMakeVisibleSetFrame((unsigned)-1)
+			, mCameraSerial(0)
+		{
+		}
+	};
+	// Indexed by ICamera::GetIndex(). A deque keeps the references valid
+	// when a camera is added while rendering.
+	std::deque<CameraData> mCameraData;
 	
 	/*std::vector<SceneObjectWeakPtr> mMarkObjects;
 	std::vector<SceneObjectWeakPtr> mHPBarObjects;*/
@@ -70,13 +88,26 @@ public:
 	bool mSkipSpatialObjects;
 	bool mSkyRendering;
 	std::mutex mSpatialObjectsMutex;
+	// Culling scratch buffers.
+	SPATIAL_OBJECTS_RAW mCullObjects;
+	std::vector<unsigned> mCullHandles;
+	std::vector<unsigned char> mCullVisible;
+	std::vector<SortKeyIndex> mSortKeys;
+	std::vector<SortKeyIndex> mSortTemp;
+	SPATIAL_OBJECTS_RAW mSortedObjects;
+	// Shadow casters per cascade. Sorted front to back from the light.
+	SPATIAL_OBJECTS_RAW mShadowCasters[MaxShadowCascades];
+	std::vector<unsigned char> mShadowCasterMasks;
+	std::vector<Real> mShadowCasterDepths;
+	Mat44 mShadowLightView;
+	ShadowCascadeBounds mShadowCascades[MaxShadowCascades];
+	unsigned mNumShadowCascades;
+	unsigned mShadowCasterVersion;
 	std::vector< SpatialSceneObjectPtr > mCloudVolumes;
 	Vec3 mWindDir;
 	float mWindVelocity;
 	Vec3 mWindVector;
 	Color mFogColor;
-	VectorMap<ICamera*, unsigned> mLastPreRenderFramePerCam;
-	VectorMap<ICamera*, unsigned> mLastMakeVisibleSetPerCam;
 	bool mDrawClouds;
 	bool mRttScene;
 	bool mRefreshPointLight;
@@ -98,6 +129,8 @@ public:
 		, mRefreshPointLight(false)
 		, mPointLightMan(PointLightManager::Create())
 		, mSceneAABBLastFrame(-1)
+		, mNumShadowCascades(0)
+		, mShadowCasterVersion(0)
 	{
 		mWindVector = mWindDir * mWindVelocity;
 
@@ -175,79 +208,61 @@ public:
 		if (mSkipSpatialObjects)
 			return;
 
-		if (!force){
-			auto it = mLastMakeVisibleSetPerCam.find(cam);
-			if (it != mLastMakeVisibleSetPerCam.end() && it->second == gpTimer->GetFrame())
-				return;
-		}
-		mLastMakeVisibleSetPerCam[cam] = gpTimer->GetFrame();
-		//auto lightCam = renderParam.mLightCamera;
-		mVisibleObjectsMain[cam].clear();
-		//mVisibleObjectsLight[lightCam].clear();
-		mVisibleTransparentObjects[cam].clear();
-		mVisibleAfterObjects[cam].clear();
-		mVisibleAfterUI[cam].clear();
-		mPreRenderList[cam].clear();
-
 		if (!cam)
 		{
 			Logger::Log(FB_FRAME_TIME, FB_ERROR_LOG_ARG, "Invalid main camera");
 			return;
 		}
+		auto& data = GetCameraData(cam);
+		if (!force && data.mLastMakeVisibleSetFrame == gpTimer->GetFrame())
+			return;
+		data.mLastMakeVisibleSetFrame = gpTimer->GetFrame();
+		//auto lightCam = renderParam.mLightCamera;
+		data.mVisibleObjectsMain.clear();
+		data.mVisibleTransparentObjects.clear();
+		data.mVisibleAfterObjects.clear();
+		data.mVisibleAfterUI.clear();
+		data.mPreRenderList.clear();
 		/*if (!lightCam){
 			Logger::Log(FB_FRAME_TIME, FB_ERROR_LOG_ARG, "Invalid light camera");
 			return;
 		}*/
 
 		{
-			MutexLock lock(mSpatialObjectsMutex);			
-			for (auto it = mSpatialObjects.begin(); it != mSpatialObjects.end(); /**/)
+			MutexLock lock(mSpatialObjectsMutex);
+			CollectCullObjects();
+			auto& storage = SpatialObjectStorage::GetInstance();
+			mCullVisible.resize(mCullHandles.size());
+			if (!mCullHandles.empty())
+				storage.Cull(&mCullHandles[0], mCullHandles.size(), cam->GetFrustum(), &mCullVisible[0]);
+
+			for (size_t i = 0; i < mCullObjects.size(); ++i)
 			{
-				auto obj = it->lock();
-				if (!obj){
-					it = mSpatialObjects.erase(it);
-					continue;
-				}
-
-				if (obj->HasObjFlag(SceneObjectFlag::Ignore)){
-					++it;
+				if (!mCullVisible[i])
 					continue;
-				}
-				++it;
-
-				bool inserted = false;							
-				if (!cam->IsCulled(obj->GetBoundingVolumeWorld().get())){				
-					if (obj->HasObjFlag(SceneObjectFlag::Transparent))
-					{
-						if (obj->HasObjFlag(SceneObjectFlag::AfterRenderObjects)) {
-							mVisibleAfterObjects[cam].push_back(obj.get());
-						}
-						else if (obj->HasObjFlag(SceneObjectFlag::AfterUI)) {
-							mVisibleAfterUI[cam].push_back(obj.get());
-						}
-						else {
-							mVisibleTransparentObjects[cam].push_back(obj.get());
-						}
+				auto obj = mCullObjects[i];
+				if (obj->HasObjFlag(SceneObjectFlag::Transparent))
+				{
+					if (obj->HasObjFlag(SceneObjectFlag::AfterRenderObjects)) {
+						data.mVisibleAfterObjects.push_back(obj);
 					}
-					else
-					{
-						mVisibleObjectsMain[cam].push_back(obj.get());
+					else if (obj->HasObjFlag(SceneObjectFlag::AfterUI)) {
+						data.mVisibleAfterUI.push_back(obj);
+					}
+					else {
+						data.mVisibleTransparentObjects.push_back(obj);
 					}
-					inserted = true;
 				}
-
-				/*if (lightCam && !lightCam->IsCulled(obj->GetBoundingVolumeWorld().get()) && !obj->HasObjFlag(SceneObjectFlag::Transparent))
+				else
 				{
-					mVisibleObjectsLight[lightCam].push_back((obj.get()));
-					inserted = true;
-				}*/
-				if (inserted)
-					mPreRenderList[cam].push_back((obj.get()));
+					data.mVisibleObjectsMain.push_back(obj);
+				}
+				data.mPreRenderList.push_back(obj);
 			}
 		}
 
 		const fb::Vec3& camPos = cam->GetPosition();
-		for (const auto obj : mPreRenderList[cam])
+		for (const auto obj : data.mPreRenderList)
 		{
 			assert(obj);
 			const Vec3& objPos = obj->GetPosition();
@@ -255,26 +270,8 @@ public:
 			obj->SetDistToCam(cam, dist);
 		}
 
-		std::sort(mVisibleObjectsMain[cam].begin(), mVisibleObjectsMain[cam].end(),
-			[&cam](SpatialObject* a, SpatialObject* b) -> bool
-		{
-			return a->GetDistToCam(cam) < b->GetDistToCam(cam);
-		}
-		);
-
-		/*std::sort(mVisibleObjectsLight[lightCam].begin(), mVisibleObjectsLight[lightCam].end(),
-			[](SpatialObject* a, SpatialObject* b) -> bool
-		{
-			return a->GetDistToCam() < b->GetDistToCam();
-		}
-		);*/
-
-		std::sort(mVisibleTransparentObjects[cam].begin(), mVisibleTransparentObjects[cam].end(),
-			[&cam](SpatialObject* a, SpatialObject* b) -> bool
-		{
-			return a->GetDistToCam(cam) > b->GetDistToCam(cam);
-		}
-		);
+		SortByDistance(data.mVisibleObjectsMain, cam, false);
+		SortByDistance(data.mVisibleTransparentObjects, cam, true);
 
 		auto& observers = mSelf->mObservers_[ISceneObserver::Timing];
 		for (auto it = observers.begin(); it != observers.end(); /**/){
@@ -289,6 +286,117 @@ public:
 		}		
 	}
 
+	/// Fills mCullObjects and mCullHandles and updates their bounds.
+	/// Call with mSpatialObjectsMutex locked.
+	void CollectCullObjects(){
+		mCullObjects.clear();
+		mCullHandles.clear();
+		for (auto it = mSpatialObjects.begin(); it != mSpatialObjects.end(); /**/)
+		{
+			auto obj = it->lock();
+			if (!obj){
+				it = mSpatialObjects.erase(it);
+				continue;
+			}
+			++it;
+			if (obj->HasObjFlag(SceneObjectFlag::Ignore)){
+				continue;
+			}
+			mCullObjects.push_back(obj.get());
+			mCullHandles.push_back(obj->GetSpatialHandle());
+		}
+		SpatialObjectStorage::GetInstance().UpdateDirtyBounds();
+	}
+
+	void MakeShadowCasterSets(const Mat44& lightView, const ShadowCascadeBounds* cascades, unsigned numCascades){
+		for (auto& casters : mShadowCasters){
+			casters.clear();
+		}
+		if (mSkipSpatialObjects)
+			return;
+		if (numCascades > MaxShadowCascades){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Too many cascades(%u).", numCascades).c_str());
+			numCascades = MaxShadowCascades;
+		}
+		auto& storage = SpatialObjectStorage::GetInstance();
+		// The cached masks are valid while the light and the cascades stay.
+		if (mShadowCasterVersion == 0 || numCascades != mNumShadowCascades || !(lightView == mShadowLightView) ||
+			memcmp(cascades, mShadowCascades, sizeof(ShadowCascadeBounds) * numCascades) != 0)
+		{
+			mShadowCasterVersion = storage.NewShadowCasterVersion();
+			mShadowLightView = lightView;
+			memcpy(mShadowCascades, cascades, sizeof(ShadowCascadeBounds) * numCascades);
+			mNumShadowCascades = numCascades;
+		}
+
+		MutexLock lock(mSpatialObjectsMutex);
+		CollectCullObjects();
+		auto num = mCullHandles.size();
+		if (num == 0)
+			return;
+		mShadowCasterMasks.resize(num);
+		mShadowCasterDepths.resize(num);
+		storage.CullShadowCasters(&mCullHandles[0], num, lightView, cascades, numCascades,
+			mShadowCasterVersion, &mShadowCasterMasks[0], &mShadowCasterDepths[0]);
+
+		mSortKeys.clear();
+		for (size_t i = 0; i < num; ++i){
+			if (!mShadowCasterMasks[i] || mCullObjects[i]->HasObjFlag(SceneObjectFlag::Transparent))
+				continue;
+			SortKeyIndex key;
+			key.mKey = FloatToSortKey(mShadowCasterDepths[i]);
+			key.mIndex = i;
+			mSortKeys.push_back(key);
+		}
+		RadixSort(mSortKeys, mSortTemp);
+		for (auto& key : mSortKeys){
+			auto mask = mShadowCasterMasks[key.mIndex];
+			for (unsigned c = 0; c < numCascades; ++c){
+				if (mask & (1 << c))
+					mShadowCasters[c].push_back(mCullObjects[key.mIndex]);
+			}
+		}
+	}
+
+	void RenderShadowCasters(unsigned cascade, const RenderParam& param, RenderParamOut* paramOut){
+		mRenderPass = (RENDER_PASS)param.mRenderPass;
+		param.mScene = mSelf;
+		if (mSkipSpatialObjects || cascade >= MaxShadowCascades)
+			return;
+		for (auto obj : mShadowCasters[cascade]){
+			obj->Render(param, paramOut);
+		}
+	}
+
+	CameraData& GetCameraData(ICamera* cam){
+		auto index = cam->GetIndex();
+		if (index >= mCameraData.size())
+			mCameraData.resize(index + 1);
+		auto& data = mCameraData[index];
+		auto serial = cam->GetIndexSerial();
+		if (data.mCameraSerial != serial){
+			// The slot was used by a deleted camera.
+			data = CameraData();
+			data.mCameraSerial = serial;
+		}
+		return data;
+	}
+
+	void SortByDistance(SPATIAL_OBJECTS_RAW& objects, ICamera* cam, bool farFirst){
+		mSortKeys.resize(objects.size());
+		for (size_t i = 0; i < objects.size(); ++i){
+			auto key = FloatToSortKey(objects[i]->GetDistToCam(cam));
+			mSortKeys[i].mKey = farFirst ? ~key : key;
+			mSortKeys[i].mIndex = i;
+		}
+		RadixSort(mSortKeys, mSortTemp);
+		mSortedObjects.resize(objects.size());
+		for (size_t i = 0; i < objects.size(); ++i){
+			mSortedObjects[i] = objects[mSortKeys[i].mIndex];
+		}
+		objects.swap(mSortedObjects);
+	}
+
 	void PreRender(const RenderParam& renderParam, RenderParamOut* renderParamOut){
 		mRenderPass = (RENDER_PASS)renderParam.mRenderPass;
 		renderParam.mScene = mSelf;
@@ -297,12 +405,12 @@ public:
 			auto cam = renderParam.mCamera;
 			assert(cam);
 
-			auto it = mLastPreRenderFramePerCam.find(cam);
-			if (it != mLastPreRenderFramePerCam.end() && it->second == gpTimer->GetFrame())
+			auto& data = GetCameraData(cam);
+			if (data.mLastPreRenderFrame == gpTimer->GetFrame())
 				return;
-			mLastPreRenderFramePerCam[cam] = gpTimer->GetFrame();
+			data.mLastPreRenderFrame = gpTimer->GetFrame();
 
-			auto objIt = mPreRenderList[cam].begin(), objItEnd = mPreRenderList[cam].end();
+			auto objIt = data.mPreRenderList.begin(), objItEnd = data.mPreRenderList.end();
 			for (; objIt != objItEnd; objIt++)
 			{
 				// Only objects that have a valid renderable is in the render lists.
@@ -334,11 +442,12 @@ public:
 		param.mScene = mSelf;
 		//auto lightCamera = param.mLightCamera;
 		auto cam = param.mCamera;
+		auto& data = GetCameraData(cam);
 		if (!mSkipSpatialObjects)
 		{
 			if (param.mRenderPass == PASS_SHADOW)
 			{
-				for (auto& obj : mVisibleObjectsMain[cam])
+				for (auto& obj : data.mVisibleObjectsMain)
 				{
 					obj->Render(param, paramOut);
 				}
@@ -368,7 +477,7 @@ public:
 				//---------------------------------------------------------------------------
 				// Opaque Rendering
 				//---------------------------------------------------------------------------
-				for (auto& obj : mVisibleObjectsMain[cam])
+				for (auto& obj : data.mVisibleObjectsMain)
 				{
 					obj->Render(param, paramOut);
 				}
@@ -405,7 +514,7 @@ public:
 
 			if (!mSkipSpatialObjects)
 			{
-				auto it = mVisibleTransparentObjects[cam].begin(), itEnd = mVisibleTransparentObjects[cam].end();
+				auto it = data.mVisibleTransparentObjects.begin(), itEnd = data.mVisibleTransparentObjects.end();
 				for (; it != itEnd; it++)
 				{
 					(*it)->Render(param, paramOut);					
@@ -421,7 +530,7 @@ public:
 			}
 			if (!mSkipSpatialObjects)
 			{
-				auto it = mVisibleAfterObjects[cam].begin(), itEnd = mVisibleAfterObjects[cam].end();
+				auto it = data.mVisibleAfterObjects.begin(), itEnd = data.mVisibleAfterObjects.end();
 				for (; it != itEnd; it++)
 				{
 					(*it)->Render(param, paramOut);
@@ -525,7 +634,7 @@ public:
 	}
 
 	const SPATIAL_OBJECTS_RAW* GetVisibleSpatialList(ICameraPtr cam){
-		return &mVisibleObjectsMain[cam.get()];
+		return &GetCameraData(cam.get()).mVisibleObjectsMain;
 	}
 
 	void PrintSpatialObject(){
@@ -839,6 +948,14 @@ void Scene::ClearClouds() {
 	mImpl->ClearClouds();
 }
 
+void Scene::MakeShadowCasterSets(const Mat44& lightView, const ShadowCascadeBounds* cascades, unsigned numCascades){
+	mImpl->MakeShadowCasterSets(lightView, cascades, numCascades);
+}
+
+void Scene::RenderShadowCasters(unsigned cascade, const RenderParam& param, RenderParamOut* paramOut){
+	mImpl->RenderShadowCasters(cascade, param, paramOut);
+}
+
 void Scene::PreRenderCloudVolumes(const RenderParam& prarm, RenderParamOut* paramOut) {
 	mImpl->PreRenderCloudVolumes(prarm, paramOut);
 }
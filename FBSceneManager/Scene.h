@@ -66,6 +66,8 @@ namespace fb{
 		void SetLightIntensity(DirectionalLightIndex::Enum idx, float intensity);
 		void PreRender(const RenderParam& prarm, RenderParamOut* paramOut);
 		void Render(const RenderParam& prarm, RenderParamOut* paramOut);		
+		void MakeShadowCasterSets(const Mat44& lightView, const ShadowCascadeBounds* cascades, unsigned numCascades);
+		void RenderShadowCasters(unsigned cascade, const RenderParam& param, RenderParamOut* paramOut);
 		void PreRenderCloudVolumes(const RenderParam& prarm, RenderParamOut* paramOut);
 		void RenderCloudVolumes(const RenderParam& prarm, RenderParamOut* paramOut);
 		const Color& GetFogColor() const;	
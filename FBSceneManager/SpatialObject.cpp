@@ -27,8 +27,11 @@
 
 #include "stdafx.h"
 #include "SpatialObject.h"
+#include "SpatialObjectStorage.h"
 #include "Scene.h"
+#include "FBRenderer/ICamera.h"
 #include "FBMathLib/BoundingVolume.h"
+#include "FBMathLib/BVaabb.h"
 #include "FBAnimation/Animation.h"
 #include "FBAnimation/AnimationData.h"
 #include "FBMathLib/Math.h"
@@ -36,28 +39,31 @@
 using namespace fb;
 
 //---------------------------------------------------------------------------
+static SpatialObjectStorage& Storage(){
+	return SpatialObjectStorage::GetInstance();
+}
+
 SpatialObject::SpatialObject()
-	: mBoundingVolume(BoundingVolume::Create())
-	, mBoundingVolumeWorld(BoundingVolume::Create())
+	: mHandle(Storage().Allocate())
+	, mBoundingVolume(BoundingVolume::Create())
 	, mPreviousPosition(0, 0, 0)
 	, mTransformChanged(true)
 {
+	UpdateLocalBounds();
 }
 
 SpatialObject::SpatialObject(const SpatialObject& other)
 	: SpatialObject()
 {
-	mLocation = other.mLocation;
+	Storage().Copy(mHandle, other.mHandle);
 	if (other.mAnimatedLocation){
 		mAnimatedLocation = Transformation::Create();
 		*mAnimatedLocation = *other.mAnimatedLocation;
 	}
 	if (mBoundingVolume->GetBVType() !=  other.mBoundingVolume->GetBVType()){
 		mBoundingVolume = BoundingVolume::Create(other.mBoundingVolume->GetBVType());
-		mBoundingVolumeWorld = BoundingVolume::Create(other.mBoundingVolumeWorld->GetBVType());
 	}
 	*mBoundingVolume = *other.mBoundingVolume;
-	*mBoundingVolumeWorld = *other.mBoundingVolumeWorld;
 	mDistToCam = other.mDistToCam;
 	if (other.mAnim){
 		mAnim = other.mAnim->Clone();
@@ -66,32 +72,39 @@ SpatialObject::SpatialObject(const SpatialObject& other)
 }
 
 SpatialObject::~SpatialObject(){
-
+	Storage().Release(mHandle);
 }
 
 void SpatialObject::SetRadius(Real r){
 	mBoundingVolume->SetRadius(r);
-	mBoundingVolumeWorld->SetRadius(r);
+	UpdateLocalBounds();
 }
 
 Real SpatialObject::GetRadius() const{
-	return mBoundingVolumeWorld->GetRadius();
+	return Storage().GetWorldRadius(mHandle);
 }
 
 void SpatialObject::SetDistToCam(ICamera* cam, Real dist){
-	mDistToCam[cam] = dist;
+	auto index = cam->GetIndex();
+	if (index >= mDistToCam.size()){
+		DistToCam unset = { 0, FLT_MAX };
+		mDistToCam.resize(index + 1, unset);
+	}
+	mDistToCam[index].mCameraSerial = cam->GetIndexSerial();
+	mDistToCam[index].mDist = dist;
 }
 
 Real SpatialObject::GetDistToCam(ICamera* cam) const{
-	auto it = mDistToCam.find(cam);
-	if (it != mDistToCam.end()){
-		return it->second;
+	auto index = cam->GetIndex();
+	// Ignore the distance to a deleted camera which had the same index.
+	if (index < mDistToCam.size() && mDistToCam[index].mCameraSerial == cam->GetIndexSerial()){
+		return mDistToCam[index].mDist;
 	}
 	return FLT_MAX;
 }
 
 const Vec3& SpatialObject::GetPosition() const{
-	return mLocation.GetTranslation();
+	return GetLocation().GetTranslation();
 }
 
 const Vec3& SpatialObject::GetPreviousPosition() const{
@@ -99,42 +112,41 @@ const Vec3& SpatialObject::GetPreviousPosition() const{
 }
 
 const Vec3& SpatialObject::GetScale() const{
-	return mLocation.GetScale();
+	return GetLocation().GetScale();
 }
 
 Vec3 SpatialObject::GetDirection() const{
-	return mLocation.GetForward();
+	return GetLocation().GetForward();
 }
 
 const Quat& SpatialObject::GetRotation() const{
-	return mLocation.GetRotation();
+	return GetLocation().GetRotation();
 }
 
 void SpatialObject::SetPosition(const Vec3& pos){
-	mPreviousPosition = mLocation.GetTranslation();
-	mLocation.SetTranslation(pos);
-	mBoundingVolumeWorld->SetCenter(mBoundingVolume->GetCenter() + pos);
+	auto& location = Storage().GetLocationForWrite(mHandle);
+	mPreviousPosition = location.GetTranslation();
+	location.SetTranslation(pos);
 	mTransformChanged = true;
 }
 
 void SpatialObject::SetRotation(const Quat& rot){
-	mLocation.SetRotation(rot);
+	Storage().GetLocationForWrite(mHandle).SetRotation(rot);
 	mTransformChanged = true;
 }
 
 void SpatialObject::SetScale(const Vec3& scale){
-	mBoundingVolumeWorld->SetRadius(mBoundingVolume->GetRadius() * std::max(scale.x, std::max(scale.y, scale.z)));
-	mLocation.SetScale(scale);
+	Storage().GetLocationForWrite(mHandle).SetScale(scale);
 	mTransformChanged = true;
 }
 
 void SpatialObject::SetDirection(const Vec3& dir){
-	mLocation.SetDirection(dir);
+	Storage().GetLocationForWrite(mHandle).SetDirection(dir);
 	mTransformChanged = true;
 }
 
 void SpatialObject::SetDirectionAndRight(const Vec3& dir, const Vec3& right){
-	mLocation.SetDirectionAndRight(dir, right);
+	Storage().GetLocationForWrite(mHandle).SetDirectionAndRight(dir, right);
 	mTransformChanged = true;
 }
 
@@ -143,30 +155,60 @@ void SpatialObject::UseAABBBoundingVolume(){
 	auto radius = mBoundingVolume->GetRadius();
 	auto alwaysPass = mBoundingVolume->GetAlwaysPass();
 	mBoundingVolume = BoundingVolume::Create(BoundingVolume::BV_AABB);
-	mBoundingVolumeWorld = BoundingVolume::Create(BoundingVolume::BV_AABB);
 	mBoundingVolume->SetCenter(center);
 	mBoundingVolume->SetRadius(radius);
 	mBoundingVolume->SetAlwaysPass(alwaysPass);
-	mBoundingVolumeWorld->SetCenter(center + mLocation.GetTranslation());
-	const auto& s = mLocation.GetScale();	
-	mBoundingVolumeWorld->SetRadius(radius * std::max(std::max(s.x, s.y), s.z));
-	mBoundingVolumeWorld->SetAlwaysPass(alwaysPass);
+	UpdateLocalBounds();
 }
 
-BoundingVolumePtr SpatialObject::GetBoundingVolume(){
-	return mBoundingVolume;
+const BoundingVolume& SpatialObject::GetBoundingVolume() const{
+	return *mBoundingVolume;
+}
+
+void SpatialObject::SetBoundingVolume(const BoundingVolume& src){
+	*mBoundingVolume = src;
+	UpdateLocalBounds();
+	Storage().SetAlwaysPass(mHandle, mBoundingVolume->GetAlwaysPass());
 }
 
 BoundingVolumePtr SpatialObject::GetBoundingVolumeWorld(){
-	return mBoundingVolumeWorld;
+	auto bv = BoundingVolume::Create();
+	bv->SetCenter(Storage().GetWorldCenter(mHandle));
+	bv->SetRadius(Storage().GetWorldRadius(mHandle));
+	bv->SetAlwaysPass(GetAlwaysPassCulling());
+	return bv;
+}
+
+void SpatialObject::UpdateLocalBounds(){
+	if (mBoundingVolume->GetBVType() == BoundingVolume::BV_AABB){
+		auto& aabb = static_cast<const BVaabb*>(mBoundingVolume.get())->GetAABB();
+		if (aabb.IsValid()){
+			Storage().SetLocalBox(mHandle, aabb.GetCenter(), aabb.GetExtents());
+			return;
+		}
+	}
+	Storage().SetLocalBounds(mHandle, mBoundingVolume->GetCenter(), mBoundingVolume->GetRadius());
+}
+
+void SpatialObject::SetAlwaysPassCulling(bool alwaysPass){
+	mBoundingVolume->SetAlwaysPass(alwaysPass);
+	Storage().SetAlwaysPass(mHandle, alwaysPass);
+}
+
+bool SpatialObject::GetAlwaysPassCulling() const{
+	return Storage().GetAlwaysPass(mHandle);
+}
+
+unsigned SpatialObject::GetSpatialHandle() const{
+	return mHandle;
 }
 
 const Transformation& SpatialObject::GetLocation() const{
-	return mLocation;
+	return Storage().GetLocation(mHandle);
 }
 
 const Transformation& SpatialObject::GetAnimatedLocation() const{
-	return mAnim ? *mAnimatedLocation : mLocation;
+	return mAnim ? *mAnimatedLocation : GetLocation();
 }
 
 AnimationPtr SpatialObject::GetAnimation() const{
@@ -174,11 +216,9 @@ AnimationPtr SpatialObject::GetAnimation() const{
 }
 
 void SpatialObject::SetLocation(const Transformation& t){
-	mBoundingVolumeWorld->SetCenter(mBoundingVolume->GetCenter() + t.GetTranslation());
-	mBoundingVolumeWorld->SetRadius(mBoundingVolume->GetRadius() * t.GetScale().GetMax());
-	mLocation = t;
+	Storage().GetLocationForWrite(mHandle) = t;
 	if (mAnimatedLocation){
-		*mAnimatedLocation = mLocation * mAnim->GetResult();
+		*mAnimatedLocation = t * mAnim->GetResult();
 	}
 	mTransformChanged = true;
 }
@@ -214,7 +254,7 @@ void SpatialObject::UpdateAnimation(TIME_PRECISION dt){
 	if (mAnim){
 		mAnim->Update(dt);
 		if (mAnim->Changed())
-			*mAnimatedLocation = mLocation * mAnim->GetResult();
+			*mAnimatedLocation = GetLocation() * mAnim->GetResult();
 	}
 }
 
@@ -243,18 +283,7 @@ void SpatialObject::NotifyTransformChanged(){
 	mTransformChanged = true;
 }
 
-void SpatialObject::SetBoundingVolume(const BoundingVolume& src){
-	*mBoundingVolume = src;
-	*mBoundingVolumeWorld = *mBoundingVolume;
-	mBoundingVolumeWorld->SetCenter(mBoundingVolume->GetCenter() + mLocation.GetTranslation());
-	auto scale = mLocation.GetScale();
-	mBoundingVolumeWorld->SetRadius(mBoundingVolume->GetRadius() * std::max(scale.x, std::max(scale.y, scale.z)));
-}
-
-void SpatialObject::MergeBoundingVolume(const BoundingVolumePtr src){
-	mBoundingVolume->Merge(src.get());
-	*mBoundingVolumeWorld = *mBoundingVolume;
-	mBoundingVolumeWorld->SetCenter(mBoundingVolume->GetCenter() + mLocation.GetTranslation());
-	auto scale = mLocation.GetScale();
-	mBoundingVolumeWorld->SetRadius(mBoundingVolume->GetRadius() * std::max(scale.x, std::max(scale.y, scale.z)));
+void SpatialObject::MergeBoundingVolume(const BoundingVolume& src){
+	mBoundingVolume->Merge(&src);
+	UpdateLocalBounds();
 }
\ No newline at end of file
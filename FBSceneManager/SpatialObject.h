@@ -38,11 +38,17 @@ namespace fb{
 	FB_DECLARE_SMART_PTR(BoundingVolume);
 	FB_DECLARE_SMART_PTR(SpatialObject);	
 	class FB_DLL_SCENEMANAGER SpatialObject : public ISpatialObject {
-		Transformation mLocation;
+		// Location and world bounds live in SpatialObjectStorage.
+		unsigned mHandle;
 		TransformationPtr mAnimatedLocation;
 		BoundingVolumePtr mBoundingVolume;
-		BoundingVolumePtr mBoundingVolumeWorld;
-		VectorMap<ICamera*, Real> mDistToCam;
+		struct DistToCam{
+			// ICamera::GetIndexSerial() of the camera which set it.
+			unsigned mCameraSerial;
+			Real mDist;
+		};
+		// Indexed by ICamera::GetIndex().
+		std::vector<DistToCam> mDistToCam;
 		AnimationPtr mAnim;
 		Vec3 mPreviousPosition;
 		bool mTransformChanged;
@@ -68,8 +74,14 @@ namespace fb{
 		void SetDirection(const Vec3& dir);
 		void SetDirectionAndRight(const Vec3& dir, const Vec3& right);
 		void UseAABBBoundingVolume();
-		BoundingVolumePtr GetBoundingVolume();
+		/// Local bounds. Change them with SetBoundingVolume() or SetRadius().
+		const BoundingVolume& GetBoundingVolume() const;
+		void SetBoundingVolume(const BoundingVolume& src);
+		/// Returns a new sphere built from the world bounds. Not for the per frame code.
 		BoundingVolumePtr GetBoundingVolumeWorld();
+		void SetAlwaysPassCulling(bool alwaysPass);
+		bool GetAlwaysPassCulling() const;
+		unsigned GetSpatialHandle() const;
 		const Transformation& GetLocation() const;
 		const Transformation& GetAnimatedLocation() const;
 		AnimationPtr GetAnimation() const;
@@ -86,8 +98,11 @@ namespace fb{
 		void NotifyTransformChanged();		
 
 	protected:
-		void SetBoundingVolume(const BoundingVolume& src);
-		void MergeBoundingVolume(const BoundingVolumePtr src);
+		void MergeBoundingVolume(const BoundingVolume& src);
 		void UpdateAnimation(TIME_PRECISION dt);
+
+	private:
+		/// Copies mBoundingVolume to the storage. AABBs are kept as boxes.
+		void UpdateLocalBounds();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,422 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "SpatialObjectStorage.h"
+#include "FBMathLib/Frustum.h"
+#include "FBMathLib/Mat44.h"
+#include "FBMathLib/BatchMath.h"
+#include "FBCommonHeaders/SpinLock.h"
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define FB_SPATIAL_STORAGE_SSE 1
+#include <xmmintrin.h>
+#endif
+using namespace fb;
+
+static const unsigned PageBits = 8;
+static const unsigned PageSize = 1 << PageBits;
+static const unsigned PageMask = PageSize - 1;
+
+class SpatialObjectStorage::Impl{
+public:
+	struct Page{
+		Transformation mLocation[PageSize];
+		float mLocalX[PageSize], mLocalY[PageSize], mLocalZ[PageSize], mLocalRadius[PageSize];
+		float mWorldX[PageSize], mWorldY[PageSize], mWorldZ[PageSize], mWorldRadius[PageSize];
+		// Box slots only. Half extents of the local box and of its world
+		// bounds along the world axes.
+		unsigned char mBox[PageSize];
+		float mLocalExtentX[PageSize], mLocalExtentY[PageSize], mLocalExtentZ[PageSize];
+		float mWorldExtentX[PageSize], mWorldExtentY[PageSize], mWorldExtentZ[PageSize];
+		unsigned char mAlwaysPass[PageSize];
+		unsigned char mDirty[PageSize];
+		// Cached CullShadowCasters() result. 0 version is invalid.
+		unsigned mShadowVersion[PageSize];
+		unsigned char mShadowMask[PageSize];
+		float mShadowDepth[PageSize];
+	};
+	std::vector< std::unique_ptr<Page> > mPages;
+	std::vector<Handle> mFreeHandles;
+	std::vector<Handle> mDirtyHandles;
+	std::vector<Handle> mUpdating;
+	SpinLockWaitSleep mLock;
+	// Gathered world spheres for BatchMath::CullSpheres.
+	mutable std::vector<Real> mCullX, mCullY, mCullZ, mCullRadius;
+	mutable SpinLockWaitSleep mCullLock;
+	unsigned mLastShadowVersion;
+
+	Impl()
+		: mLastShadowVersion(0)
+	{
+		// Pages are looked up without the lock.
+		mPages.reserve(4096);
+	}
+
+	Page& GetPage(Handle h) const{
+		return *mPages[h >> PageBits];
+	}
+
+	Handle Allocate(){
+		EnterSpinLock<SpinLockWaitSleep> lock(mLock);
+		if (mFreeHandles.empty()){
+			Handle first = mPages.size() << PageBits;
+			mPages.push_back(std::unique_ptr<Page>(new Page));
+			for (unsigned i = PageSize; i > 0; --i){
+				mFreeHandles.push_back(first + i - 1);
+			}
+		}
+		auto h = mFreeHandles.back();
+		mFreeHandles.pop_back();
+		auto& page = GetPage(h);
+		auto i = h & PageMask;
+		page.mLocation[i].MakeIdentity();
+		page.mLocalX[i] = page.mLocalY[i] = page.mLocalZ[i] = 0.f;
+		page.mLocalRadius[i] = 1.f;
+		page.mWorldX[i] = page.mWorldY[i] = page.mWorldZ[i] = 0.f;
+		page.mWorldRadius[i] = 1.f;
+		page.mBox[i] = 0;
+		page.mAlwaysPass[i] = 0;
+		page.mDirty[i] = 0;
+		page.mShadowVersion[i] = 0;
+		return h;
+	}
+
+	void Release(Handle h){
+		EnterSpinLock<SpinLockWaitSleep> lock(mLock);
+		GetPage(h).mDirty[h & PageMask] = 0;
+		mFreeHandles.push_back(h);
+	}
+
+	void Copy(Handle dest, Handle src){
+		auto& d = GetPage(dest);
+		auto& s = GetPage(src);
+		auto di = dest & PageMask;
+		auto si = src & PageMask;
+		d.mLocation[di] = s.mLocation[si];
+		d.mLocalX[di] = s.mLocalX[si];
+		d.mLocalY[di] = s.mLocalY[si];
+		d.mLocalZ[di] = s.mLocalZ[si];
+		d.mLocalRadius[di] = s.mLocalRadius[si];
+		d.mBox[di] = s.mBox[si];
+		d.mLocalExtentX[di] = s.mLocalExtentX[si];
+		d.mLocalExtentY[di] = s.mLocalExtentY[si];
+		d.mLocalExtentZ[di] = s.mLocalExtentZ[si];
+		d.mAlwaysPass[di] = s.mAlwaysPass[si];
+		MarkDirty(dest);
+	}
+
+	void MarkDirty(Handle h){
+		auto& page = GetPage(h);
+		page.mShadowVersion[h & PageMask] = 0;
+		auto& dirty = page.mDirty[h & PageMask];
+		if (dirty)
+			return;
+		EnterSpinLock<SpinLockWaitSleep> lock(mLock);
+		dirty = 1;
+		mDirtyHandles.push_back(h);
+	}
+
+	void UpdateSlot(Handle h){
+		auto& page = GetPage(h);
+		auto i = h & PageMask;
+		auto& location = page.mLocation[i];
+		auto& t = location.GetTranslation();
+		auto scale = location.GetScale().GetMax();
+		page.mWorldX[i] = page.mLocalX[i] + t.x;
+		page.mWorldY[i] = page.mLocalY[i] + t.y;
+		page.mWorldZ[i] = page.mLocalZ[i] + t.z;
+		page.mWorldRadius[i] = page.mLocalRadius[i] * scale;
+		page.mDirty[i] = 0;
+		if (page.mBox[i])
+			UpdateBox(h);
+	}
+
+	// The center follows the rotation too, and the extents become the
+	// bounds of the rotated box.
+	void UpdateBox(Handle h){
+		auto& page = GetPage(h);
+		auto i = h & PageMask;
+		auto& location = page.mLocation[i];
+		Vec3 localCenter(page.mLocalX[i], page.mLocalY[i], page.mLocalZ[i]);
+		auto center = location.ApplyForward(localCenter);
+		auto ax = location.ApplyForward(localCenter + Vec3(page.mLocalExtentX[i], 0, 0)) - center;
+		auto ay = location.ApplyForward(localCenter + Vec3(0, page.mLocalExtentY[i], 0)) - center;
+		auto az = location.ApplyForward(localCenter + Vec3(0, 0, page.mLocalExtentZ[i])) - center;
+		page.mWorldX[i] = center.x;
+		page.mWorldY[i] = center.y;
+		page.mWorldZ[i] = center.z;
+		page.mWorldExtentX[i] = std::abs(ax.x) + std::abs(ay.x) + std::abs(az.x);
+		page.mWorldExtentY[i] = std::abs(ax.y) + std::abs(ay.y) + std::abs(az.y);
+		page.mWorldExtentZ[i] = std::abs(ax.z) + std::abs(ay.z) + std::abs(az.z);
+	}
+
+	static bool IsBoxCulled(const Plane* planes, const Page& page, unsigned i){
+		for (int p = 0; p < Frustum::NumPlanes; ++p){
+			auto& n = planes[p].mNormal;
+			auto r = page.mWorldExtentX[i] * std::abs(n.x) + page.mWorldExtentY[i] * std::abs(n.y) +
+				page.mWorldExtentZ[i] * std::abs(n.z);
+			if (n.x * page.mWorldX[i] + n.y * page.mWorldY[i] + n.z * page.mWorldZ[i] - planes[p].mConstant <= -r)
+				return true;
+		}
+		return false;
+	}
+
+	void UpdateDirtyBounds(){
+		{
+			EnterSpinLock<SpinLockWaitSleep> lock(mLock);
+			mUpdating.clear();
+			for (auto h : mDirtyHandles){
+				auto& dirty = GetPage(h).mDirty[h & PageMask];
+				if (dirty){
+					dirty = 0;
+					mUpdating.push_back(h);
+				}
+			}
+			mDirtyHandles.clear();
+		}
+		unsigned num = mUpdating.size();
+		unsigned i = 0;
+#if FB_SPATIAL_STORAGE_SSE
+		for (; i + 4 <= num; i += 4){
+			float lx[4], ly[4], lz[4], lr[4], tx[4], ty[4], tz[4], s[4];
+			for (unsigned k = 0; k < 4; ++k){
+				auto h = mUpdating[i + k];
+				auto& page = GetPage(h);
+				auto j = h & PageMask;
+				auto& location = page.mLocation[j];
+				auto& t = location.GetTranslation();
+				lx[k] = page.mLocalX[j]; ly[k] = page.mLocalY[j]; lz[k] = page.mLocalZ[j]; 
+				lr[k] = page.mLocalRadius[j];
+				tx[k] = t.x; ty[k] = t.y; tz[k] = t.z;
+				s[k] = location.GetScale().GetMax();
+			}
+			float wx[4], wy[4], wz[4], wr[4];
+			_mm_storeu_ps(wx, _mm_add_ps(_mm_loadu_ps(lx), _mm_loadu_ps(tx)));
+			_mm_storeu_ps(wy, _mm_add_ps(_mm_loadu_ps(ly), _mm_loadu_ps(ty)));
+			_mm_storeu_ps(wz, _mm_add_ps(_mm_loadu_ps(lz), _mm_loadu_ps(tz)));
+			_mm_storeu_ps(wr, _mm_mul_ps(_mm_loadu_ps(lr), _mm_loadu_ps(s)));
+			for (unsigned k = 0; k < 4; ++k){
+				auto h = mUpdating[i + k];
+				auto& page = GetPage(h);
+				auto j = h & PageMask;
+				page.mWorldX[j] = wx[k]; page.mWorldY[j] = wy[k]; page.mWorldZ[j] = wz[k];
+				page.mWorldRadius[j] = wr[k];
+				if (page.mBox[j])
+					UpdateBox(h);
+			}
+		}
+#endif
+		for (; i < num; ++i){
+			UpdateSlot(mUpdating[i]);
+		}
+	}
+
+	void Cull(const Handle* handles, unsigned num, const Frustum& frustum, unsigned char* visible) const{
+		Plane planes[Frustum::NumPlanes];
+		for (int p = 0; p < Frustum::NumPlanes; ++p){
+			planes[p] = frustum.GetPlane((Frustum::FRUSTUM_PLANE)p);
+		}
+		EnterSpinLock<SpinLockWaitSleep> lock(mCullLock);
+		mCullX.resize(num); mCullY.resize(num); mCullZ.resize(num); mCullRadius.resize(num);
+		for (unsigned i = 0; i < num; ++i){
+			auto h = handles[i];
+			auto& page = GetPage(h);
+			auto j = h & PageMask;
+			mCullX[i] = page.mWorldX[j];
+			mCullY[i] = page.mWorldY[j];
+			mCullZ[i] = page.mWorldZ[j];
+			mCullRadius[i] = page.mWorldRadius[j];
+		}
+		BatchMath::CullSpheres(planes, Frustum::NumPlanes, mCullX.data(), mCullY.data(), mCullZ.data(),
+			mCullRadius.data(), num, visible);
+		// CullSpheres() wrote the culled flags. The box of a slot is inside its
+		// sphere, so only the boxes which passed need their own test.
+		for (unsigned i = 0; i < num; ++i){
+			auto h = handles[i];
+			auto& page = GetPage(h);
+			auto j = h & PageMask;
+			if (page.mAlwaysPass[j])
+				visible[i] = 1;
+			else if (visible[i])
+				visible[i] = 0;
+			else
+				visible[i] = page.mBox[j] && IsBoxCulled(planes, page, j) ? 0 : 1;
+		}
+	}
+
+	unsigned NewShadowCasterVersion(){
+		EnterSpinLock<SpinLockWaitSleep> lock(mLock);
+		if (++mLastShadowVersion == 0)
+			++mLastShadowVersion;
+		return mLastShadowVersion;
+	}
+
+	void CullShadowCasters(const Handle* handles, unsigned num, const Mat44& lightView,
+		const ShadowCascadeBounds* cascades, unsigned numCascades, unsigned version,
+		unsigned char* masks, Real* depths)
+	{
+		assert(numCascades <= MaxShadowCascades);
+		const unsigned char allCascades = (unsigned char)((1 << numCascades) - 1);
+		for (unsigned i = 0; i < num; ++i){
+			auto h = handles[i];
+			auto& page = GetPage(h);
+			auto j = h & PageMask;
+			if (page.mShadowVersion[j] == version){
+				masks[i] = page.mShadowMask[j];
+				depths[i] = page.mShadowDepth[j];
+				continue;
+			}
+			auto center = lightView * Vec3(page.mWorldX[j], page.mWorldY[j], page.mWorldZ[j]);
+			auto radius = page.mWorldRadius[j];
+			unsigned char mask = 0;
+			if (page.mAlwaysPass[j]){
+				mask = allCascades;
+			}
+			else{
+				for (unsigned c = 0; c < numCascades; ++c){
+					auto& cascade = cascades[c];
+					if (radius < cascade.mMinCasterRadius ||
+						center.x + radius < cascade.mL || center.x - radius > cascade.mR ||
+						center.z + radius < cascade.mB || center.z - radius > cascade.mT ||
+						center.y + radius < cascade.mNear || center.y - radius > cascade.mFar)
+						continue;
+					mask |= 1 << c;
+				}
+			}
+			page.mShadowVersion[j] = version;
+			page.mShadowMask[j] = mask;
+			page.mShadowDepth[j] = center.y;
+			masks[i] = mask;
+			depths[i] = center.y;
+		}
+	}
+};
+
+//---------------------------------------------------------------------------
+SpatialObjectStorage& SpatialObjectStorage::GetInstance(){
+	static SpatialObjectStorage sStorage;
+	return sStorage;
+}
+
+SpatialObjectStorage::SpatialObjectStorage()
+	: mImpl(new Impl)
+{
+}
+
+SpatialObjectStorage::~SpatialObjectStorage(){
+}
+
+SpatialObjectStorage::Handle SpatialObjectStorage::Allocate(){
+	return mImpl->Allocate();
+}
+
+void SpatialObjectStorage::Release(Handle h){
+	mImpl->Release(h);
+}
+
+void SpatialObjectStorage::Copy(Handle dest, Handle src){
+	mImpl->Copy(dest, src);
+}
+
+const Transformation& SpatialObjectStorage::GetLocation(Handle h) const{
+	return mImpl->GetPage(h).mLocation[h & PageMask];
+}
+
+Transformation& SpatialObjectStorage::GetLocationForWrite(Handle h){
+	mImpl->MarkDirty(h);
+	return mImpl->GetPage(h).mLocation[h & PageMask];
+}
+
+void SpatialObjectStorage::SetLocalBounds(Handle h, const Vec3& center, Real radius){
+	auto& page = mImpl->GetPage(h);
+	auto i = h & PageMask;
+	page.mLocalX[i] = center.x;
+	page.mLocalY[i] = center.y;
+	page.mLocalZ[i] = center.z;
+	page.mLocalRadius[i] = radius;
+	page.mBox[i] = 0;
+	mImpl->MarkDirty(h);
+}
+
+void SpatialObjectStorage::SetLocalBox(Handle h, const Vec3& center, const Vec3& halfExtents){
+	auto& page = mImpl->GetPage(h);
+	auto i = h & PageMask;
+	page.mLocalX[i] = center.x;
+	page.mLocalY[i] = center.y;
+	page.mLocalZ[i] = center.z;
+	page.mLocalRadius[i] = halfExtents.Length();
+	page.mLocalExtentX[i] = halfExtents.x;
+	page.mLocalExtentY[i] = halfExtents.y;
+	page.mLocalExtentZ[i] = halfExtents.z;
+	page.mBox[i] = 1;
+	mImpl->MarkDirty(h);
+}
+
+void SpatialObjectStorage::SetAlwaysPass(Handle h, bool alwaysPass){
+	auto& page = mImpl->GetPage(h);
+	page.mAlwaysPass[h & PageMask] = alwaysPass ? 1 : 0;
+	page.mShadowVersion[h & PageMask] = 0;
+}
+
+bool SpatialObjectStorage::GetAlwaysPass(Handle h) const{
+	return mImpl->GetPage(h).mAlwaysPass[h & PageMask] != 0;
+}
+
+Vec3 SpatialObjectStorage::GetWorldCenter(Handle h){
+	auto& page = mImpl->GetPage(h);
+	auto i = h & PageMask;
+	if (page.mDirty[i])
+		mImpl->UpdateSlot(h);
+	return Vec3(page.mWorldX[i], page.mWorldY[i], page.mWorldZ[i]);
+}
+
+Real SpatialObjectStorage::GetWorldRadius(Handle h){
+	auto& page = mImpl->GetPage(h);
+	auto i = h & PageMask;
+	if (page.mDirty[i])
+		mImpl->UpdateSlot(h);
+	return page.mWorldRadius[i];
+}
+
+void SpatialObjectStorage::UpdateDirtyBounds(){
+	mImpl->UpdateDirtyBounds();
+}
+
+void SpatialObjectStorage::Cull(const Handle* handles, unsigned num, const Frustum& frustum, unsigned char* visible) const{
+	mImpl->Cull(handles, num, frustum, visible);
+}
+
+unsigned SpatialObjectStorage::NewShadowCasterVersion(){
+	return mImpl->NewShadowCasterVersion();
+}
+
+void SpatialObjectStorage::CullShadowCasters(const Handle* handles, unsigned num, const Mat44& lightView,
+	const ShadowCascadeBounds* cascades, unsigned numCascades, unsigned version,
+	unsigned char* masks, Real* depths)
+{
+	mImpl->CullShadowCasters(handles, num, lightView, cascades, numCascades, version, masks, depths);
+}
@@ -0,0 +1,81 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "FBMathLib/Transformation.h"
+#include "ShadowCascadeBounds.h"
+namespace fb{
+	class Frustum;
+	class Mat44;
+	/// Dense storage of the spatial object locations and world bounding spheres.
+	/// Slots with a local box also keep its oriented world extents, which
+	/// refine the sphere test in Cull().
+	/// Slots are grouped in fixed size pages so a location reference stays valid
+	/// while other objects are created.
+	class SpatialObjectStorage{
+		FB_DECLARE_PIMPL_NON_COPYABLE(SpatialObjectStorage);
+		SpatialObjectStorage();
+		~SpatialObjectStorage();
+
+	public:
+		typedef unsigned Handle;
+		static SpatialObjectStorage& GetInstance();
+
+		Handle Allocate();
+		void Release(Handle h);
+		/// Copies the location and the bounds of 'src'.
+		void Copy(Handle dest, Handle src);
+
+		const Transformation& GetLocation(Handle h) const;
+		/// Marks the world bounds dirty.
+		Transformation& GetLocationForWrite(Handle h);
+		void SetLocalBounds(Handle h, const Vec3& center, Real radius);
+		/// The bounding sphere of the box is used where a sphere is needed.
+		void SetLocalBox(Handle h, const Vec3& center, const Vec3& halfExtents);
+		void SetAlwaysPass(Handle h, bool alwaysPass);
+		bool GetAlwaysPass(Handle h) const;
+		Vec3 GetWorldCenter(Handle h);
+		Real GetWorldRadius(Handle h);
+
+		/// Updates the world bounds of every dirty slot at once.
+		void UpdateDirtyBounds();
+		/// visible[i] becomes 1 when the bounds of handles[i] intersects the frustum.
+		/// Call UpdateDirtyBounds() first.
+		void Cull(const Handle* handles, unsigned num, const Frustum& frustum, unsigned char* visible) const;
+		/// Returns a new id for CullShadowCasters(). Use a new one whenever the
+		/// light view or the cascades change.
+		unsigned NewShadowCasterVersion();
+		/// masks[i] gets the bit c when the bounds of handles[i] can cast a shadow
+		/// into cascades[c]. depths[i] is the light view space depth of its center.
+		/// Slots which have not moved since the last call with the same 'version'
+		/// reuse the previous result. Call UpdateDirtyBounds() first.
+		void CullShadowCasters(const Handle* handles, unsigned num, const Mat44& lightView,
+			const ShadowCascadeBounds* cascades, unsigned numCascades, unsigned version,
+			unsigned char* masks, Real* depths);
+	};
+}
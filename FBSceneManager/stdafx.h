@@ -60,6 +60,7 @@ Plugin:
 #include <map>
 #include <string>
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <assert.h>
 
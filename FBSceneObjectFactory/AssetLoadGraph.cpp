@@ -0,0 +1,570 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "AssetLoadGraph.h"
+#include "SceneObjectFactory.h"
+#include "MeshObject.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/RendererOptions.h"
+#include "FBRenderer/CompiledMaterial.h"
+#include "FBRenderer/ShaderCache.h"
+#include "FBFileSystem/FileSystem.h"
+#include "FBThread/TaskScheduler.h"
+#include "FBThread/Task.h"
+#include "FBCommonHeaders/ProfilerSimple.h"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+using namespace fb;
+
+enum AssetType{
+	AssetMesh,
+	AssetMaterial,
+	AssetTexture,
+	AssetShader,
+};
+
+class AssetLoadGraph::Impl{
+public:
+	struct Node;
+	typedef std::shared_ptr<Node> NodePtr;
+	struct Node{
+		AssetType mType;
+		std::string mPath;
+		MeshImportDesc mDesc;
+		int mTextureType;
+		SHADER_TYPE mShaderType;
+		SHADER_DEFINES mDefines;
+
+		// written by the worker stage
+		bool mLoaded;
+		collada::MeshPtr mMeshData;
+		CompiledMaterial mCompiled;
+
+		// protected by mMutex
+		bool mWorkDone;
+		bool mCreated;
+		unsigned mNumWaiting;
+		std::vector<NodePtr> mDependents;
+
+		// main thread
+		MeshObjectPtr mMeshObject;
+		MaterialPtr mMaterial;
+		TexturePtr mTexture;
+
+		Node(AssetType type, const char* path)
+			: mType(type)
+			, mPath(path)
+			, mTextureType(TEXTURE_TYPE_DEFAULT)
+			, mShaderType(SHADER_TYPE_VS)
+			, mLoaded(false)
+			, mWorkDone(false)
+			, mCreated(false)
+			, mNumWaiting(0)
+		{
+		}
+	};
+
+	class LoadTask : public Task{
+		Impl* mGraph;
+		NodePtr mNode;
+
+	public:
+		LoadTask(Impl* graph, const NodePtr& node)
+			: Task(true)
+			, mGraph(graph)
+			, mNode(node)
+		{
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE{
+			mGraph->Load(mNode);
+		}
+	};
+
+	// protected by mMutex
+	mutable std::mutex mMutex;
+	std::condition_variable mReadyCondition;
+	std::unordered_map<std::string, NodePtr> mNodes;
+	std::vector<NodePtr> mPending;
+	std::deque<NodePtr> mReady;
+	std::vector<TaskPtr> mTasks;
+	bool mStarted;
+	unsigned mNumCreated;
+	unsigned mNumFailed;
+	INT64 mElapsedTime;
+
+	// valid after Start()
+	ShaderCachePtr mShaderCache;
+	bool mUseMaterialCache;
+	ProfilerSimple mProfiler;
+
+	std::atomic<INT64> mWorkerTime;
+	INT64 mMainThreadTime;
+
+	//---------------------------------------------------------------------------
+	Impl()
+		: mStarted(false)
+		, mNumCreated(0)
+		, mNumFailed(0)
+		, mElapsedTime(0)
+		, mUseMaterialCache(true)
+		, mProfiler("AssetLoadGraph")
+		, mWorkerTime(0)
+		, mMainThreadTime(0)
+	{
+	}
+
+	~Impl(){
+		// Tasks add the tasks of the dependencies while executing.
+		for (;;){
+			std::vector<TaskPtr> tasks;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				tasks.swap(mTasks);
+			}
+			if (tasks.empty())
+				break;
+			for (auto& task : tasks){
+				task->Sync();
+			}
+		}
+	}
+
+	static std::string MakeKey(const Node& node){
+		std::string path(node.mPath);
+		ToLowerCase(path);
+		auto key = FormatString("%d:", node.mType) + path;
+		if (node.mType == AssetShader){
+			key += FormatString(":%d", node.mShaderType);
+			for (auto& define : node.mDefines){
+				key += ":" + define.GetName() + "=" + define.GetValue();
+			}
+		}
+		return key;
+	}
+
+	/// Call with mMutex locked.
+	/// \param dependent waits until \a candidate or the same one is created.
+	/// \return the node to schedule. 0 if it is already added or the graph is not started.
+	NodePtr AddLocked(const NodePtr& candidate, const NodePtr& dependent){
+		auto key = MakeKey(*candidate);
+		auto it = mNodes.find(key);
+		NodePtr node;
+		NodePtr added;
+		if (it == mNodes.end()){
+			node = candidate;
+			mNodes[key] = node;
+			if (mStarted)
+				added = node;
+			else
+				mPending.push_back(node);
+		}
+		else{
+			node = it->second;
+		}
+		if (dependent && !node->mCreated){
+			++dependent->mNumWaiting;
+			node->mDependents.push_back(dependent);
+		}
+		return added;
+	}
+
+	void Add(const NodePtr& candidate){
+		NodePtr added;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			added = AddLocked(candidate, 0);
+		}
+		if (added)
+			Schedule(added);
+	}
+
+	void AddMesh(const char* daeFilePath, const MeshImportDesc& desc){
+		if (!ValidCString(daeFilePath)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return;
+		}
+		auto node = std::make_shared<Node>(AssetMesh, daeFilePath);
+		node->mDesc = desc;
+		Add(node);
+	}
+
+	void AddMaterial(const char* materialPath){
+		if (!ValidCString(materialPath)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return;
+		}
+		Add(std::make_shared<Node>(AssetMaterial, materialPath));
+	}
+
+	void AddTexture(const char* texturePath){
+		if (!ValidCString(texturePath)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return;
+		}
+		Add(std::make_shared<Node>(AssetTexture, texturePath));
+	}
+
+	void Start(){
+		std::vector<NodePtr> pending;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mStarted)
+				return;
+			auto& renderer = Renderer::GetInstance();
+			mShaderCache = renderer.GetShaderCache();
+			mUseMaterialCache = renderer.GetRendererOptions()->r_MaterialCache != 0;
+			mProfiler.Reset();
+			mStarted = true;
+			pending.swap(mPending);
+		}
+		for (auto& node : pending){
+			Schedule(node);
+		}
+	}
+
+	void Schedule(const NodePtr& node){
+		// Textures are decoded by the platform renderer.
+		if (node->mType == AssetTexture || !TaskScheduler::HasInstance()){
+			Load(node);
+			return;
+		}
+		auto task = std::make_shared<LoadTask>(this, node);
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTasks.push_back(task);
+		}
+		TaskScheduler::GetInstance().AddTask(task);
+	}
+
+	//---------------------------------------------------------------------------
+	// Worker threads
+	//---------------------------------------------------------------------------
+	void Load(const NodePtr& node){
+		ProfilerSimple profiler("AssetLoad");
+		std::vector<NodePtr> dependencies;
+		auto path = node->mPath.c_str();
+		switch (node->mType){
+		case AssetMesh:{
+			StringVector materials;
+			node->mMeshData = SceneObjectFactory::GetInstance().LoadCompiledMeshData(
+				path, node->mDesc, &materials);
+			node->mLoaded = node->mMeshData != 0;
+			for (auto& material : materials){
+				dependencies.push_back(std::make_shared<Node>(AssetMaterial, material.c_str()));
+			}
+			break;
+		}
+		case AssetMaterial:{
+			{
+				FileSystem::Lock lock;
+				node->mLoaded = CompiledMaterial::Load(path, mUseMaterialCache, node->mCompiled);
+			}
+			if (node->mLoaded){
+				AddTextureDependencies(node->mCompiled, dependencies);
+				AddShaderDependencies(node->mCompiled, dependencies);
+			}
+			break;
+		}
+		case AssetTexture:
+			node->mLoaded = true;
+			break;
+		case AssetShader:
+			node->mLoaded = mShaderCache &&
+				!mShaderCache->GetByteCode(path, node->mShaderType, node->mDefines, 0).empty();
+			break;
+		}
+		mWorkerTime += profiler.GetDTMicro();
+		OnLoaded(node, dependencies);
+	}
+
+	void AddTextureDependencies(const CompiledMaterial& compiled, std::vector<NodePtr>& out){
+		for (auto& texture : compiled.mTextures){
+			// Missing textures are reported when the material is created.
+			if ((texture.mTextureType & TEXTURE_TYPE_COLOR_RAMP) || !texture.mFileExists)
+				continue;
+			auto node = std::make_shared<Node>(AssetTexture, texture.mFilepath.c_str());
+			node->mTextureType = texture.mTextureType;
+			out.push_back(node);
+		}
+		for (auto& subMaterial : compiled.mSubMaterials){
+			AddTextureDependencies(subMaterial, out);
+		}
+	}
+
+	void AddShaderDependencies(const CompiledMaterial& compiled, std::vector<NodePtr>& out){
+		if (!mShaderCache)
+			return;
+		std::vector<CompiledMaterial::ShaderPermutation> permutations;
+		compiled.GetShaderPermutations(permutations);
+		for (auto& permutation : permutations){
+			auto node = std::make_shared<Node>(AssetShader, permutation.mFilepath.c_str());
+			node->mShaderType = permutation.mShaderType;
+			node->mDefines = permutation.mDefines;
+			out.push_back(node);
+		}
+	}
+
+	void OnLoaded(const NodePtr& node, const std::vector<NodePtr>& dependencies){
+		std::vector<NodePtr> toSchedule;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (auto& dependency : dependencies){
+				auto added = AddLocked(dependency, node);
+				if (added)
+					toSchedule.push_back(added);
+			}
+			node->mWorkDone = true;
+			if (node->mType == AssetShader){
+				// Nothing to create on the main thread. Materials create
+				// the shaders from the cache.
+				OnCreatedLocked(*node);
+			}
+			else if (node->mNumWaiting == 0){
+				mReady.push_back(node);
+			}
+		}
+		mReadyCondition.notify_all();
+		for (auto& it : toSchedule){
+			Schedule(it);
+		}
+	}
+
+	void OnCreatedLocked(Node& node){
+		node.mCreated = true;
+		++mNumCreated;
+		for (auto& dependent : node.mDependents){
+			assert(dependent->mNumWaiting > 0);
+			if (--dependent->mNumWaiting == 0 && dependent->mWorkDone)
+				mReady.push_back(dependent);
+		}
+		node.mDependents.clear();
+		if (mNumCreated == mNodes.size())
+			mElapsedTime = mProfiler.GetDTMicro();
+	}
+
+	//---------------------------------------------------------------------------
+	// Main thread
+	//---------------------------------------------------------------------------
+	void CreateAsset(Node& node){
+		auto& renderer = Renderer::GetInstance();
+		auto path = node.mPath.c_str();
+		switch (node.mType){
+		case AssetMesh:
+			if (!node.mLoaded)
+				++mNumFailed;
+			// Loads the mesh in place if the data is not loaded.
+			node.mMeshObject = SceneObjectFactory::GetInstance().CreateMeshObject(
+				path, node.mMeshData, node.mDesc);
+			node.mMeshData = 0;
+			break;
+		case AssetMaterial:
+			if (node.mLoaded){
+				node.mMaterial = renderer.CreateMaterial(path, node.mCompiled);
+				node.mCompiled = CompiledMaterial();
+			}
+			else{
+				++mNumFailed;
+				node.mMaterial = renderer.CreateMaterial(path);
+			}
+			break;
+		case AssetTexture:{
+			TextureCreationOption option;
+			option.textureType = node.mTextureType;
+			node.mTexture = renderer.CreateTexture(path, option);
+			break;
+		}
+		case AssetShader:
+			assert(0);
+			break;
+		}
+	}
+
+	/// \param budget in microseconds. Negative for no limit.
+	void CreateReadyAssets(INT64 budget){
+		ProfilerSimple profiler("AssetLoadGraph");
+		for (;;){
+			NodePtr node;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mReady.empty())
+					break;
+				node = mReady.front();
+				mReady.pop_front();
+			}
+			CreateAsset(*node);
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				OnCreatedLocked(*node);
+			}
+			if (budget >= 0 && profiler.GetDTMicro() >= budget)
+				break;
+		}
+		mMainThreadTime += profiler.GetDTMicro();
+	}
+
+	bool Update(TIME_PRECISION timeBudget){
+		CreateReadyAssets((INT64)(std::max(timeBudget, (TIME_PRECISION)0) * std::micro::den));
+		return IsFinished();
+	}
+
+	void Finish(){
+		Start();
+		for (;;){
+			CreateReadyAssets(-1);
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (mNumCreated == mNodes.size())
+				break;
+			mReadyCondition.wait(lock, [this](){
+				return !mReady.empty() || mNumCreated == mNodes.size();
+			});
+		}
+	}
+
+	bool IsFinished() const{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mStarted && mNumCreated == mNodes.size();
+	}
+
+	float GetProgress() const{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mNodes.empty())
+			return mStarted ? 1.f : 0.f;
+		return mNumCreated / (float)mNodes.size();
+	}
+
+	MeshObjectPtr GetMeshObject(const char* daeFilePath) const{
+		if (!ValidCString(daeFilePath)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return 0;
+		}
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mNodes.find(MakeKey(Node(AssetMesh, daeFilePath)));
+		if (it == mNodes.end() || !it->second->mCreated || !it->second->mMeshObject)
+			return 0;
+		return it->second->mMeshObject->Clone();
+	}
+
+	Stats GetStats() const{
+		Stats stats;
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& it : mNodes){
+			switch (it.second->mType){
+			case AssetMesh:
+				++stats.mNumMeshes;
+				break;
+			case AssetMaterial:
+				++stats.mNumMaterials;
+				break;
+			case AssetTexture:
+				++stats.mNumTextures;
+				break;
+			case AssetShader:
+				++stats.mNumShaders;
+				break;
+			}
+		}
+		stats.mNumFailed = mNumFailed;
+		stats.mWorkerTime = mWorkerTime;
+		stats.mMainThreadTime = mMainThreadTime;
+		stats.mElapsedTime = mElapsedTime;
+		return stats;
+	}
+};
+
+//---------------------------------------------------------------------------
+AssetLoadGraph::Stats::Stats()
+	: mNumMeshes(0)
+	, mNumMaterials(0)
+	, mNumTextures(0)
+	, mNumShaders(0)
+	, mNumFailed(0)
+	, mWorkerTime(0)
+	, mMainThreadTime(0)
+	, mElapsedTime(0)
+{
+}
+
+AssetLoadGraphPtr AssetLoadGraph::Create(){
+	return AssetLoadGraphPtr(new AssetLoadGraph, [](AssetLoadGraph* obj){ delete obj; });
+}
+
+AssetLoadGraph::AssetLoadGraph()
+	: mImpl(new Impl)
+{
+}
+
+AssetLoadGraph::~AssetLoadGraph(){
+}
+
+void AssetLoadGraph::AddMesh(const char* daeFilePath){
+	mImpl->AddMesh(daeFilePath, MeshImportDesc());
+}
+
+void AssetLoadGraph::AddMesh(const char* daeFilePath, const MeshImportDesc& desc){
+	mImpl->AddMesh(daeFilePath, desc);
+}
+
+void AssetLoadGraph::AddMaterial(const char* materialPath){
+	mImpl->AddMaterial(materialPath);
+}
+
+void AssetLoadGraph::AddTexture(const char* texturePath){
+	mImpl->AddTexture(texturePath);
+}
+
+void AssetLoadGraph::Start(){
+	mImpl->Start();
+}
+
+bool AssetLoadGraph::Update(TIME_PRECISION timeBudget){
+	return mImpl->Update(timeBudget);
+}
+
+void AssetLoadGraph::Finish(){
+	mImpl->Finish();
+}
+
+bool AssetLoadGraph::IsFinished() const{
+	return mImpl->IsFinished();
+}
+
+float AssetLoadGraph::GetProgress() const{
+	return mImpl->GetProgress();
+}
+
+MeshObjectPtr AssetLoadGraph::GetMeshObject(const char* daeFilePath) const{
+	return mImpl->GetMeshObject(daeFilePath);
+}
+
+AssetLoadGraph::Stats AssetLoadGraph::GetStats() const{
+	return mImpl->GetStats();
+}
@@ -0,0 +1,92 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "MeshImportDesc.h"
+namespace fb{
+	FB_DECLARE_SMART_PTR(MeshObject);
+	FB_DECLARE_SMART_PTR(AssetLoadGraph);
+	/** Loads meshes with their materials, textures and shaders in parallel.
+	Reading and parsing the compiled .fbmesh and .material files and compiling
+	the shaders into the ShaderCache run on the task scheduler. The dependencies
+	are discovered from the loaded data: a mesh adds its materials and a
+	material adds its textures and shaders. Only creating the renderer
+	resources runs on the main thread in Update(), after the dependencies of
+	the asset are created. Decoding the textures is done by the asynchronous
+	texture loading of the platform renderer.
+	Assets failed to load on the worker threads are created in the usual way.
+	The created assets are cached in SceneObjectFactory and Renderer, so the
+	following CreateMeshObject() and CreateMaterial() calls get them.
+	*/
+	class FB_DLL_SCENEOBJECTFACTORY AssetLoadGraph{
+		FB_DECLARE_PIMPL_NON_COPYABLE(AssetLoadGraph);
+		AssetLoadGraph();
+		~AssetLoadGraph();
+
+	public:
+		struct Stats{
+			Stats();
+
+			unsigned mNumMeshes;
+			unsigned mNumMaterials;
+			unsigned mNumTextures;
+			unsigned mNumShaders;
+			/// Assets created without the data loaded on the worker threads.
+			unsigned mNumFailed;
+			/// Microseconds spent on the worker threads.
+			INT64 mWorkerTime;
+			/// Microseconds spent on the main thread in Update().
+			INT64 mMainThreadTime;
+			/// Microseconds from Start() to the last asset created.
+			INT64 mElapsedTime;
+		};
+
+		static AssetLoadGraphPtr Create();
+
+		/// Assets added after Start() are loaded immediately.
+		void AddMesh(const char* daeFilePath);
+		void AddMesh(const char* daeFilePath, const MeshImportDesc& desc);
+		void AddMaterial(const char* materialPath);
+		void AddTexture(const char* texturePath);
+
+		void Start();
+		/// Creates the loaded assets on the main thread.
+		/// \param timeBudget in seconds. At least one asset is created if
+		/// there is a loaded one.
+		/// \return true if every asset is created.
+		bool Update(TIME_PRECISION timeBudget);
+		/// Blocks until every asset is created.
+		void Finish();
+		bool IsFinished() const;
+		/// 0 ~ 1
+		float GetProgress() const;
+		/// Clone of the created mesh. 0 if not created yet.
+		MeshObjectPtr GetMeshObject(const char* daeFilePath) const;
+		Stats GetStats() const;
+	};
+}
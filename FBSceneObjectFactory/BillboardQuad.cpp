@@ -51,7 +51,7 @@ public:
 		mWorldPos = Vec3(0, 0, 0);
 		mSize = Vec2(1, 1);
 		mOffset = Vec2(0.5f, 0.5f);
-		mSelf->GetBoundingVolumeWorld()->SetAlwaysPass(true);
+		mSelf->SetAlwaysPassCulling(true);
 		mRenderStates = RenderStates::Create();
 	}
 
@@ -84,9 +84,9 @@ public:
 
 	void SetBillobardData(const Vec3& pos, const Vec2& size, const Vec2& offset, const Color& color){
 		mWorldPos = pos;
-		mSelf->GetBoundingVolumeWorld()->SetCenter(pos);
+		mSelf->SetPosition(pos);
 		mSize = size;
-		mSelf->GetBoundingVolumeWorld()->SetRadius(size.Length());
+		mSelf->SetRadius(size.Length());
 		mColor = color.Get4Byte();
 
 		mOffset = offset;
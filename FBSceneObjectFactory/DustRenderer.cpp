@@ -113,9 +113,11 @@ public:
 			sizeof(DWORD), count, BUFFER_USAGE_IMMUTABLE, BUFFER_CPU_ACCESS_NONE);
 
 		Vec3 len = max - min;
-		mSelf->GetBoundingVolume()->SetCenter(min + len / 2.f);
-		mSelf->GetBoundingVolume()->SetRadius(len.Length());
-		*mSelf->GetBoundingVolumeWorld() = *mSelf->GetBoundingVolume();
+		auto bv = BoundingVolume::Create();
+		bv->SetCenter(min + len / 2.f);
+		bv->SetRadius(len.Length());
+		bv->SetAlwaysPass(mSelf->GetAlwaysPassCulling());
+		mSelf->SetBoundingVolume(*bv);
 	}
 
 	void SetMaterial(const char* filepath, int pass){
@@ -211,7 +211,7 @@ public:
 		size_t idx = mMeshObjects.size() - 1;
 		if (idx == 0)
 		{
-			mSelf->SetBoundingVolume(*mesh->GetBoundingVolume());
+			mSelf->SetBoundingVolume(mesh->GetBoundingVolume());
 		}
 		else
 		{
@@ -0,0 +1,263 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "MeshInstancer.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/Material.h"
+#include "FBRenderer/VertexBuffer.h"
+#include "FBRenderer/ICamera.h"
+using namespace fb;
+
+namespace fb{
+	static const unsigned INVALID_GROUP = (unsigned)-1;
+	struct InstanceGroup{
+		enum State{
+			Pending,
+			Drawn,
+			Failed,
+		};
+		const void* mGeometry;
+		Material* mMaterial;
+		std::vector<Mat44f> mWorlds;
+		unsigned mNextWithSameGeometry;
+		State mState;
+	};
+
+	struct CameraInstances{
+		CameraInstances()
+			: mFrame(-1)
+			, mNumGroups(0)
+		{
+		}
+		FRAME_PRECISION mFrame;
+		// reused between frames; only the first mNumGroups are valid.
+		std::vector<InstanceGroup> mGroups;
+		unsigned mNumGroups;
+		std::unordered_map<const void*, unsigned> mFirstGroupByGeometry;
+		std::unordered_map<const void*, unsigned> mGroupByOwner;
+	};
+
+	// indexed by ICamera::GetIndex()
+	static std::vector<CameraInstances> sCameras;
+	static bool sEnabled = true;
+	static VertexBufferPtr sInstanceBuffer;
+	static unsigned sCapacity = 0;
+	static unsigned sUsed = 0;
+	static FRAME_PRECISION sBufferFrame = -1;
+	static const unsigned MIN_INSTANCES = 1024;
+
+	static CameraInstances* GetCameraInstances(ICamera* camera, bool create){
+		auto index = camera->GetIndex();
+		if (index >= sCameras.size()){
+			if (!create)
+				return 0;
+			sCameras.resize(index + 1);
+		}
+		auto& data = sCameras[index];
+		auto frame = gpTimer->GetFrame();
+		if (data.mFrame != frame){
+			if (!create)
+				return 0;
+			data.mFrame = frame;
+			data.mNumGroups = 0;
+			data.mFirstGroupByGeometry.clear();
+			data.mGroupByOwner.clear();
+		}
+		return &data;
+	}
+
+	static bool GrowInstanceBuffer(unsigned numInstances){
+		auto capacity = std::max(sCapacity * 2, MIN_INSTANCES);
+		while (capacity < numInstances)
+			capacity *= 2;
+		sInstanceBuffer = Renderer::GetInstance().CreateVertexBuffer(0, sizeof(Mat44f), capacity,
+			BUFFER_USAGE_DYNAMIC, BUFFER_CPU_ACCESS_WRITE);
+		if (!sInstanceBuffer){
+			Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot create the instance buffer(%u).", capacity).c_str());
+			sCapacity = 0;
+			return false;
+		}
+		sCapacity = capacity;
+		// the next write discards.
+		sUsed = sCapacity;
+		return true;
+	}
+
+	static bool UploadAndBind(const std::vector<Mat44f>& worlds){
+		unsigned num = worlds.size();
+		if (num > sCapacity && !GrowInstanceBuffer(num))
+			return false;
+
+		auto frame = gpTimer->GetFrame();
+		if (sBufferFrame != frame){
+			sBufferFrame = frame;
+			sUsed = sCapacity;
+		}
+		// Appends while it fits, and the GPU keeps reading what the earlier
+		// groups wrote.
+		auto mapType = MAP_TYPE_WRITE_NO_OVERWRITE;
+		if (sUsed + num > sCapacity){
+			sUsed = 0;
+			mapType = MAP_TYPE_WRITE_DISCARD;
+		}
+		auto mapData = sInstanceBuffer->Map(0, mapType, MAP_FLAG_NONE);
+		if (!mapData.pData)
+			return false;
+		memcpy((Mat44f*)mapData.pData + sUsed, &worlds[0], sizeof(Mat44f) * num);
+		sInstanceBuffer->Unmap(0);
+
+		VertexBufferPtr buffers[] = { sInstanceBuffer };
+		unsigned strides[] = { sizeof(Mat44f) };
+		unsigned offsets[] = { sUsed * sizeof(Mat44f) };
+		Renderer::GetInstance().SetVertexBuffers(MeshInstancer::INSTANCE_SLOT, 1, buffers, strides, offsets);
+		sUsed += num;
+		return true;
+	}
+}
+
+//---------------------------------------------------------------------------
+void MeshInstancer::SetEnabled(bool enable){
+	sEnabled = enable;
+	if (!enable)
+		sCameras.clear();
+}
+
+bool MeshInstancer::IsEnabled(){
+	return sEnabled;
+}
+
+void MeshInstancer::Queue(ICamera* camera, const void* geometry, Material* material,
+	const Mat44& world, const void* owner)
+{
+	if (!sEnabled)
+		return;
+	if (!camera || !geometry || !material || !owner){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return;
+	}
+	auto& data = *GetCameraInstances(camera, true);
+	auto groupIndex = INVALID_GROUP;
+	auto firstIndex = INVALID_GROUP;
+	auto it = data.mFirstGroupByGeometry.find(geometry);
+	if (it != data.mFirstGroupByGeometry.end()){
+		firstIndex = it->second;
+		for (auto i = firstIndex; i != INVALID_GROUP; i = data.mGroups[i].mNextWithSameGeometry){
+			auto groupMaterial = data.mGroups[i].mMaterial;
+			if (groupMaterial == material || groupMaterial->IsSameData(*material)){
+				groupIndex = i;
+				break;
+			}
+		}
+	}
+
+	if (groupIndex == INVALID_GROUP){
+		groupIndex = data.mNumGroups++;
+		if (groupIndex >= data.mGroups.size())
+			data.mGroups.push_back(InstanceGroup());
+		auto& group = data.mGroups[groupIndex];
+		group.mGeometry = geometry;
+		group.mMaterial = material;
+		group.mWorlds.clear();
+		group.mNextWithSameGeometry = firstIndex;
+		group.mState = InstanceGroup::Pending;
+		data.mFirstGroupByGeometry[geometry] = groupIndex;
+	}
+	data.mGroups[groupIndex].mWorlds.push_back(world);
+	data.mGroupByOwner[owner] = groupIndex;
+}
+
+MeshInstancer::Role MeshInstancer::Prepare(ICamera* camera, const void* owner, unsigned& outNumInstances){
+	outNumInstances = 0;
+	if (!sEnabled || !camera)
+		return NotInstanced;
+	auto data = GetCameraInstances(camera, false);
+	if (!data)
+		return NotInstanced;
+	auto it = data->mGroupByOwner.find(owner);
+	if (it == data->mGroupByOwner.end())
+		return NotInstanced;
+	auto& group = data->mGroups[it->second];
+	if (group.mWorlds.size() < 2 || group.mState == InstanceGroup::Failed)
+		return NotInstanced;
+	if (group.mState == InstanceGroup::Drawn)
+		return Skip;
+
+	if (!UploadAndBind(group.mWorlds)){
+		group.mState = InstanceGroup::Failed;
+		return NotInstanced;
+	}
+	group.mState = InstanceGroup::Drawn;
+	outNumInstances = group.mWorlds.size();
+	return DrawGroup;
+}
+
+MaterialPtr MeshInstancer::CreateInstancedMaterial(MaterialPtr material){
+	if (!material){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return 0;
+	}
+	auto instanced = material->Clone();
+	instanced->AddShaderDefine("_INSTANCED", "1");
+	auto descs = material->GetInputElementDescs();
+	for (unsigned i = 0; i < 4; ++i){
+		descs.push_back(INPUT_ELEMENT_DESC("WORLD", i, INPUT_ELEMENT_FORMAT_FLOAT4, INSTANCE_SLOT,
+			i * sizeof(Mat44f) / 4, INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1));
+	}
+	instanced->SetInputLayout(descs);
+	return instanced;
+}
+
+void MeshInstancer::Reserve(unsigned numInstances){
+	if (numInstances > sCapacity)
+		GrowInstanceBuffer(numInstances);
+}
+
+unsigned MeshInstancer::GetNumInstancedGroups(ICamera* camera){
+	if (!camera)
+		return 0;
+	auto data = GetCameraInstances(camera, false);
+	if (!data)
+		return 0;
+	unsigned num = 0;
+	for (unsigned i = 0; i < data->mNumGroups; ++i){
+		if (data->mGroups[i].mWorlds.size() > 1)
+			++num;
+	}
+	return num;
+}
+
+void MeshInstancer::Clear(){
+	sCameras.clear();
+}
+
+void MeshInstancer::FinalizeInstancer(){
+	sCameras.clear();
+	sInstanceBuffer = 0;
+	sCapacity = 0;
+	sUsed = 0;
+}
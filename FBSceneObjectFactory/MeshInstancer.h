@@ -0,0 +1,69 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "FBMathLib/Mat44.h"
+namespace fb{
+	class ICamera;
+	FB_DECLARE_SMART_PTR(Material);
+	/// Draws the visible MeshObject clones that share geometry and material
+	/// with one instanced draw call in the normal pass.
+	/// Submeshes are queued in PreRender(). The first member of a group which
+	/// gets Render() uploads the world matrices of the whole group and draws
+	/// them; the other members skip.
+	class FB_DLL_SCENEOBJECTFACTORY MeshInstancer{
+	public:
+		enum Role{
+			NotInstanced, ///< draw as usual
+			DrawGroup, ///< instance buffer is bound; draw all instances
+			Skip, ///< already drawn by the group
+		};
+		/// Vertex buffer slot for the per-instance world matrices.
+		static const unsigned INSTANCE_SLOT = 5;
+
+		static void SetEnabled(bool enable);
+		static bool IsEnabled();
+		/// \param geometry identifies the shared vertex and index buffers.
+		/// \param owner identifies the submesh; passed to Prepare() later.
+		static void Queue(ICamera* camera, const void* geometry, Material* material,
+			const Mat44& world, const void* owner);
+		/// Returns DrawGroup only once for a group. \a outNumInstances is
+		/// valid for DrawGroup.
+		static Role Prepare(ICamera* camera, const void* owner, unsigned& outNumInstances);
+		/// Clone of \a material which reads the world matrix per instance.
+		static MaterialPtr CreateInstancedMaterial(MaterialPtr material);
+		/// Allocates the instance buffer in advance.
+		static void Reserve(unsigned numInstances);
+		/// Number of groups queued for \a camera in this frame which have more
+		/// than one member.
+		static unsigned GetNumInstancedGroups(ICamera* camera);
+		/// Drops every queued instance of this frame.
+		static void Clear();
+		static void FinalizeInstancer();
+	};
+}
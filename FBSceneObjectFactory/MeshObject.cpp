@@ -28,6 +28,7 @@
 #include "stdafx.h"
 #include "MeshObject.h"
 #include "SceneObjectFactory.h"
+#include "MeshInstancer.h"
 #include "FBCommonHeaders/CowPtr.h"
 #include "FBStringMathLib/StringMathConverter.h"
 #include "FBAnimation/Animation.h"
@@ -44,28 +45,62 @@
 #include "FBRenderer/Material.h"
 #include "FBRenderer/RenderTarget.h"
 #include "FBRenderer/ResourceProvider.h"
+#include "FBRenderer/Texture.h"
+#include "FBRenderer/TextureStreamer.h"
 #include "FBStringLib/StringLib.h"
 #include "FBMathLib/GeomUtils.h"
+#include "FBMathLib/TriangleBVH.h"
 #include "EssentialEngineData/shaders/Constants.h"
 #include "FBSerializationLib/Serialization.h"
 using namespace fb;
 namespace fb {
+	/// CPU side copy of a sub mesh. Clones share it until one of them modifies it.
+	struct MaterialGroupGeometry
+	{
+		std::vector<Vec3> mPositions;
+		std::vector<Vec3> mNormals;
+		std::vector<Vec2> mUVs;
+		std::vector<ModelTriangle> mTriangles;
+		std::vector<DWORD> mColors;
+		std::vector<Vec3> mTangents;
+		// Built over mTriangles at EndModification(). mTriangles is in the
+		// BVH leaf order.
+		TriangleBVHPtr mBVH;
+	};
+
 	struct MaterialGroup
 	{
+		MaterialGroup()
+			: mSharedMaterial(false)
+		{
+		}
+
+		const MaterialGroupGeometry& GetGeometry() const{
+			static const MaterialGroupGeometry sEmpty;
+			auto geometry = mGeometry.const_get();
+			return geometry ? *geometry : sEmpty;
+		}
+
+		/// Detaches the geometry when it is shared.
+		MaterialGroupGeometry& GetGeometryForWrite(){
+			if (!mGeometry.const_get())
+				mGeometry = new MaterialGroupGeometry;
+			return *mGeometry;
+		}
+
 		MaterialPtr mMaterial;
+		// mMaterial is also used by the source or the clones of this mesh.
+		mutable bool mSharedMaterial;
 		MaterialPtr mForceAlphaMaterial;
+		MaterialPtr mInstancedMaterial;
+		MaterialPtr mInstancedSource; // mMaterial when mInstancedMaterial is created.
 		VertexBufferPtr mVBPos;
 		VertexBufferPtr mVBNormal;
 		VertexBufferPtr mVBUV;
 		VertexBufferPtr mVBColor;
 		VertexBufferPtr mVBTangent;
 		IndexBufferPtr mIndexBuffer;
-		std::vector<Vec3> mPositions;
-		std::vector<Vec3> mNormals;
-		std::vector<Vec2> mUVs;
-		std::vector<ModelTriangle> mTriangles;
-		std::vector<DWORD> mColors;
-		std::vector<Vec3> mTangents;
+		CowPtr<MaterialGroupGeometry> mGeometry;
 	};
 
 	void write_template(std::ostream& stream, const MeshObject& data, int version = serialization_version) {
@@ -76,18 +111,10 @@ namespace fb {
 	}
 }
 
+static const Real MaxRayDistance = 100000;
+
 class MeshObject::Impl{
 public:
-	
-
-	struct ModelIntersection {
-		const ModelTriangle        *pTri;      // Pointer to mesh triangle that was intersected by ray
-		Vec3     position;   // Intersection point on the triangle
-		Real           alpha;      // Alpha and beta are two of the barycentric coordinates of the intersection 
-		Real           beta;       // ... the third barycentric coordinate can be calculated by: 1- (alpha + beta).
-		bool            valid;      // "valid" is set to true if an intersection was found
-	};
-
 	MeshObject* mSelf;
 	InputLayoutPtr mInputLayoutOverride;
 	PRIMITIVE_TOPOLOGY mTopology;
@@ -149,19 +176,16 @@ public:
 		unsigned idx = 0;
 		for (auto& it : other.mMaterialGroups){
 			auto& group = GetMaterialGroupFor(idx);
-			group.mMaterial = it.mMaterial->Clone();
+			// Cloned when this mesh modifies it.
+			group.mMaterial = it.mMaterial;
+			group.mSharedMaterial = it.mSharedMaterial = true;
 			group.mVBPos = it.mVBPos;
 			group.mVBNormal = it.mVBNormal;
 			group.mVBUV = it.mVBUV;
 			group.mVBColor = it.mVBColor;
 			group.mVBTangent = it.mVBTangent;
 			group.mIndexBuffer = it.mIndexBuffer;
-			group.mPositions = it.mPositions;
-			group.mNormals = it.mNormals;
-			group.mUVs = it.mUVs;
-			group.mTriangles = it.mTriangles;
-			group.mColors = it.mColors;
-			group.mTangents = it.mTangents;
+			group.mGeometry = it.mGeometry;
 			++idx;
 		}
 	}
@@ -175,8 +199,10 @@ public:
 		unsigned idx = 0;
 		for (auto& it : other.mMaterialGroups) {
 			auto& group = GetMaterialGroupFor(idx);
-			if (!group.mMaterial)
-				group.mMaterial = it.mMaterial->Clone();
+			if (!group.mMaterial){
+				group.mMaterial = it.mMaterial;
+				group.mSharedMaterial = it.mSharedMaterial = true;
+			}
 
 			group.mVBPos = it.mVBPos;
 			group.mVBNormal = it.mVBNormal;
@@ -184,12 +210,7 @@ public:
 			group.mVBColor = it.mVBColor;
 			group.mVBTangent = it.mVBTangent;
 			group.mIndexBuffer = it.mIndexBuffer;
-			group.mPositions = it.mPositions;
-			group.mNormals = it.mNormals;
-			group.mUVs = it.mUVs;
-			group.mTriangles = it.mTriangles;
-			group.mColors = it.mColors;
-			group.mTangents = it.mTangents;
+			group.mGeometry = it.mGeometry;
 			++idx;
 		}
 	}
@@ -216,8 +237,63 @@ public:
 			auto& animatedLocation = mSelf->GetAnimatedLocation();
 			animatedLocation.GetHomogeneous(mObjectConstants.gWorld);
 			assert(renderParam.mScene);
-			renderParam.mScene->GatherPointLightData(mSelf->GetAABB().get(), animatedLocation, &mPointLightConstants);
+			renderParam.mScene->GatherPointLightData(&mSelf->GetBoundingVolume(), animatedLocation, &mPointLightConstants);
 		}
+		if (renderParam.mRenderPass == PASS_NORMAL && renderParam.mCamera)
+			ReportTextureScreenSize(renderParam.mCamera);
+
+		if (MeshInstancer::IsEnabled() && CanBeInstanced(renderParam.mCamera)){
+			for (auto& it : mMaterialGroups){
+				if (it.mMaterial && it.mVBPos && it.mIndexBuffer && it.mMaterial->IsInstancingSupported()){
+					MeshInstancer::Queue(renderParam.mCamera, it.mVBPos.get(), it.mMaterial.get(),
+						mObjectConstants.gWorld, &it);
+				}
+			}
+		}
+	}
+
+	void ReportTextureScreenSize(ICamera* camera){
+		auto textureStreamer = Renderer::GetInstance().GetTextureStreamer();
+		if (!textureStreamer)
+			return;
+		auto pixelSize = camera->ComputePixelSizeAtDistance(mSelf->GetDistToCam(camera));
+		auto pixels = pixelSize > 0 ? mSelf->GetRadius() * 2.f / pixelSize : std::numeric_limits<Real>::max();
+		for (auto& it : mMaterialGroups){
+			if (!it.mMaterial)
+				continue;
+			for (auto& texture : it.mMaterial->GetTextures()){
+				if (texture)
+					textureStreamer->ReportScreenSize(texture->GetFilePath(), pixels);
+			}
+		}
+	}
+
+	bool IsTooFar(ICamera* camera){
+		if (!mCheckDistance)
+			return false;
+		auto radius = mSelf->GetRadius();
+		auto distToCam = mSelf->GetDistToCam(camera);
+		if (distToCam > 140 && radius < 0.5f)
+			return true;
+
+		if (distToCam > 200 && radius < 2.0f)
+			return true;
+
+		if (distToCam > 500 && radius < 5.0f)
+			return true;
+
+		return false;
+	}
+
+	/// Only the objects the scene renders in the normal pass with the plain
+	/// material path. Objects lit by point lights need their own constants.
+	bool CanBeInstanced(ICamera* camera){
+		return camera && mTopology == PRIMITIVE_TOPOLOGY_TRIANGLELIST &&
+			!mForceAlphaBlending && !mInputLayoutOverride &&
+			mPointLightConstants.gPointLightColor[0].w == 0 &&
+			!mSelf->HasObjFlag(SceneObjectFlag::HighlightDedi) &&
+			!mSelf->HasObjFlag(SceneObjectFlag::Transparent) &&
+			mSelf->IsAttached() && !IsTooFar(camera);
 	}
 	
 	void Render(const RenderParam& renderParam, RenderParamOut* renderParamOut){
@@ -228,18 +304,8 @@ public:
 		if (mSelf->HasObjFlag(SceneObjectFlag::Hide))
 			return;
 
-		if (mCheckDistance && renderParam.mRenderPass == PASS_NORMAL){
-			auto radius = mSelf->GetRadius();
-			auto distToCam = mSelf->GetDistToCam(renderParam.mCamera);
-			if (distToCam > 140 && radius < 0.5f)
-				return;
-
-			if (distToCam > 200 && radius < 2.0f)
-				return;
-
-			if (distToCam > 500 && radius < 5.0f)
-				return;
-		}
+		if (renderParam.mRenderPass == PASS_NORMAL && IsTooFar(renderParam.mCamera))
+			return;
 
 		RenderEventMarker marker("MeshObject");
 
@@ -365,6 +431,13 @@ public:
 					if (!material || !it.mVBPos)
 						continue;
 
+					unsigned numInstances;
+					auto role = MeshInstancer::Prepare(renderParam.mCamera, &it, numInstances);
+					if (role == MeshInstancer::Skip)
+						continue;
+					if (role == MeshInstancer::DrawGroup && RenderInstances(&it, numInstances))
+						continue;
+
 					material->Bind(includeInputLayout);
 					RenderMaterialGroup(&it, false);
 					material->Unbind();
@@ -458,23 +531,37 @@ public:
 		auto& group = GetMaterialGroupFor(0);
 		auto& renderer = Renderer::GetInstance();
 		group.mMaterial = renderer.CreateMaterial(filepath);
+		group.mSharedMaterial = false;
 		CheckMaterialOptions(group.mMaterial);
 	}
 
 	void SetMaterial(MaterialPtr pMat, int pass){
 		auto& group = GetMaterialGroupFor(0);
 		group.mMaterial = pMat;
+		group.mSharedMaterial = false;
 		CheckMaterialOptions(group.mMaterial);
 	}
 
-	MaterialPtr GetMaterial(int pass) const{
+	/// The caller can modify the returned material.
+	MaterialPtr GetMaterial(int pass){
 		if (!mMaterialGroups.empty())
 		{
-			return mForceAlphaBlending ? mMaterialGroups[0].mForceAlphaMaterial : mMaterialGroups[0].mMaterial;
+			return mForceAlphaBlending ? mMaterialGroups[0].mForceAlphaMaterial :
+				GetMaterialForWrite(mMaterialGroups[0]);
 		}
 		return 0;
 	}
 
+	/// Clones the material shared with the source or the clones of this mesh.
+	const MaterialPtr& GetMaterialForWrite(MaterialGroup& group){
+		if (group.mSharedMaterial){
+			if (group.mMaterial)
+				group.mMaterial = group.mMaterial->Clone();
+			group.mSharedMaterial = false;
+		}
+		return group.mMaterial;
+	}
+
 	void SetEnableHighlight(bool enable){
 		mRenderHighlight = enable;
 	}
@@ -491,15 +578,17 @@ public:
 	void ClearMeshData(){
 		for(auto& it: mMaterialGroups)
 		{
-			it.mPositions.clear();
-			it.mNormals.clear();
-			it.mUVs.clear();
-			it.mColors.clear();
-
-			it.mPositions.resize(0);
-			it.mNormals.resize(0);
-			it.mUVs.resize(0);
-			it.mColors.resize(0);
+			// Triangles and tangents are kept.
+			auto& geometry = it.GetGeometry();
+			if (geometry.mTriangles.empty() && geometry.mTangents.empty()){
+				it.mGeometry.reset();
+				continue;
+			}
+			auto kept = new MaterialGroupGeometry;
+			kept->mTriangles = geometry.mTriangles;
+			kept->mTangents = geometry.mTangents;
+			kept->mBVH = geometry.mBVH;
+			it.mGeometry = kept;
 		}
 	}
 
@@ -508,14 +597,14 @@ public:
 	}
 
 	void AddTriangle(int matGroupIdx, const Vec3& pos0, const Vec3& pos1, const Vec3& pos2){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mPositions.push_back(pos0);
 		group.mPositions.push_back(pos1);
 		group.mPositions.push_back(pos2);
 	}
 
 	void AddQuad(int matGroupIdx, const Vec3 pos[4], const Vec3 normal[4]){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mPositions.push_back(pos[0]);
 		group.mPositions.push_back(pos[1]);
 		group.mPositions.push_back(pos[2]);
@@ -535,7 +624,7 @@ public:
 	}
 
 	void AddQuad(int matGroupIdx, const Vec3 pos[4], const Vec3 normal[4], const Vec2 uv[4]){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		AddQuad(matGroupIdx, pos, normal);
 		group.mUVs.push_back(uv[0]);
 		group.mUVs.push_back(uv[1]);
@@ -547,32 +636,32 @@ public:
 	}
 
 	void SetPositions(int matGroupIdx, const Vec3* p, size_t numVertices){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mPositions.assign(p, p + numVertices);
 	}
 
 	void SetNormals(int matGroupIdx, const Vec3* n, size_t numNormals){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mNormals.assign(n, n + numNormals);
 	}
 
 	void SetUVs(int matGroupIdx, const Vec2* uvs, size_t numUVs){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mUVs.assign(uvs, uvs + numUVs);
 	}
 
 	void SetTriangles(int matGroupIdx, const ModelTriangle* tris, size_t numTri){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mTriangles.assign(tris, tris + numTri);
 	}
 
 	void SetColors(int matGroupIdx, const DWORD* colors, size_t numColors){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mColors.assign(colors, colors + numColors);
 	}
 
 	void SetTangents(int matGroupIdx, const Vec3* t, size_t numTangents){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		group.mTangents.assign(t, t + numTangents);
 	}
 
@@ -615,7 +704,7 @@ public:
 	}
 
 	Vec3* GetPositions(int matGroupIdx, size_t& outNumPositions){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		outNumPositions = group.mPositions.size();
 		if (outNumPositions)
 			return &(group.mPositions[0]);
@@ -624,7 +713,7 @@ public:
 	}
 
 	Vec3* GetNormals(int matGroupIdx, size_t& outNumNormals){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		outNumNormals = group.mNormals.size();
 		if (outNumNormals)
 			return &(group.mNormals[0]);
@@ -633,7 +722,7 @@ public:
 	}
 
 	Vec2* GetUVs(int matGroupIdx, size_t& outNumUVs){
-		auto& group = GetMaterialGroupFor(matGroupIdx);
+		auto& group = GetMaterialGroupFor(matGroupIdx).GetGeometryForWrite();
 		outNumUVs = group.mUVs.size();
 		if (outNumUVs)
 			return &(group.mUVs[0]);
@@ -641,10 +730,41 @@ public:
 			return 0;
 	}
 
+	unsigned GetNumMaterialGroups() const{
+		return mMaterialGroups.size();
+	}
+
+	const Vec3* GetPositions(int matGroupIdx, size_t& outNumPositions) const{
+		outNumPositions = 0;
+		if (matGroupIdx < 0 || matGroupIdx >= (int)mMaterialGroups.size())
+			return 0;
+		auto& positions = mMaterialGroups[matGroupIdx].GetGeometry().mPositions;
+		outNumPositions = positions.size();
+		return outNumPositions ? &positions[0] : 0;
+	}
+
+	const Vec3* GetNormals(int matGroupIdx, size_t& outNumNormals) const{
+		outNumNormals = 0;
+		if (matGroupIdx < 0 || matGroupIdx >= (int)mMaterialGroups.size())
+			return 0;
+		auto& normals = mMaterialGroups[matGroupIdx].GetGeometry().mNormals;
+		outNumNormals = normals.size();
+		return outNumNormals ? &normals[0] : 0;
+	}
+
+	const Vec2* GetUVs(int matGroupIdx, size_t& outNumUVs) const{
+		outNumUVs = 0;
+		if (matGroupIdx < 0 || matGroupIdx >= (int)mMaterialGroups.size())
+			return 0;
+		auto& uvs = mMaterialGroups[matGroupIdx].GetGeometry().mUVs;
+		outNumUVs = uvs.size();
+		return outNumUVs ? &uvs[0] : 0;
+	}
+
 	void GenerateTangent(int matGroupIdx, UINT* indices, size_t num){
 		assert(mModifying);
 		assert(matGroupIdx < (int)mMaterialGroups.size());
-		MaterialGroup& group = mMaterialGroups[matGroupIdx];
+		auto& group = mMaterialGroups[matGroupIdx].GetGeometryForWrite();
 		if (group.mUVs.empty())
 			return;
 		group.mTangents.assign(group.mPositions.size(), Vec3(1, 0, 0));
@@ -687,27 +807,30 @@ public:
 
 	void EndModification(bool keepMeshData){
 		mModifying = false;
-		auto bv = mSelf->GetBoundingVolume();
+		auto bv = BoundingVolume::Create(mSelf->GetBoundingVolume().GetBVType());
+		bv->SetAlwaysPass(mSelf->GetAlwaysPassCulling());
 		bv->StartComputeFromData();
 		for(auto& it: mMaterialGroups)
 		{
 			auto& renderer = Renderer::GetInstance();
-			if (!it.mPositions.empty())
+			BuildTriangleBVH(it);
+			auto& geometry = it.GetGeometry();
+			if (!geometry.mPositions.empty())
 			{
 				it.mVBPos = renderer.CreateVertexBuffer(
-					&it.mPositions[0], sizeof(Vec3f), it.mPositions.size(),
+					&geometry.mPositions[0], sizeof(Vec3f), geometry.mPositions.size(),
 					mUseDynamicVB[MeshVertexBufferType::Position] ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_IMMUTABLE,
 					mUseDynamicVB[MeshVertexBufferType::Position] ? BUFFER_CPU_ACCESS_WRITE : BUFFER_CPU_ACCESS_NONE);
-				bv->AddComputeData(&it.mPositions[0], it.mPositions.size());
+				bv->AddComputeData(&geometry.mPositions[0], geometry.mPositions.size());
 			}
 			else
 			{
 				it.mVBPos = 0;
 			}
-			if (!it.mNormals.empty())
+			if (!geometry.mNormals.empty())
 			{				
 				it.mVBNormal = renderer.CreateVertexBuffer(
-					&it.mNormals[0], sizeof(Vec3f), it.mNormals.size(),
+					&geometry.mNormals[0], sizeof(Vec3f), geometry.mNormals.size(),
 					mUseDynamicVB[MeshVertexBufferType::Normal] ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_IMMUTABLE,
 					mUseDynamicVB[MeshVertexBufferType::Normal] ? BUFFER_CPU_ACCESS_WRITE : BUFFER_CPU_ACCESS_NONE);
 			}
@@ -715,10 +838,10 @@ public:
 			{
 				it.mVBNormal = 0;
 			}
-			if (!it.mUVs.empty())
+			if (!geometry.mUVs.empty())
 			{
 				it.mVBUV = renderer.CreateVertexBuffer(
-					&it.mUVs[0], sizeof(Vec2f), it.mUVs.size(),
+					&geometry.mUVs[0], sizeof(Vec2f), geometry.mUVs.size(),
 					mUseDynamicVB[MeshVertexBufferType::UV] ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_IMMUTABLE,
 					mUseDynamicVB[MeshVertexBufferType::UV] ? BUFFER_CPU_ACCESS_WRITE : BUFFER_CPU_ACCESS_NONE);				
 			}
@@ -727,10 +850,10 @@ public:
 				it.mVBUV = 0;
 			}
 
-			if (!it.mColors.empty())
+			if (!geometry.mColors.empty())
 			{
 				it.mVBColor = renderer.CreateVertexBuffer(
-					&it.mColors[0], sizeof(DWORD), it.mColors.size(),
+					&geometry.mColors[0], sizeof(DWORD), geometry.mColors.size(),
 					mUseDynamicVB[MeshVertexBufferType::Color] ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_IMMUTABLE,
 					mUseDynamicVB[MeshVertexBufferType::Color] ? BUFFER_CPU_ACCESS_WRITE : BUFFER_CPU_ACCESS_NONE);				
 			}
@@ -739,10 +862,10 @@ public:
 				it.mVBColor = 0;
 			}
 
-			if (!it.mTangents.empty())
+			if (!geometry.mTangents.empty())
 			{
 				it.mVBTangent = renderer.CreateVertexBuffer(
-					&it.mTangents[0], sizeof(Vec3f), it.mTangents.size(),
+					&geometry.mTangents[0], sizeof(Vec3f), geometry.mTangents.size(),
 					mUseDynamicVB[MeshVertexBufferType::Tangent] ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_IMMUTABLE,
 					mUseDynamicVB[MeshVertexBufferType::Tangent] ? BUFFER_CPU_ACCESS_WRITE : BUFFER_CPU_ACCESS_NONE);
 				
@@ -755,18 +878,35 @@ public:
 
 		}
 		bv->EndComputeFromData();		
-		auto boundingVolumeWorld = mSelf->GetBoundingVolumeWorld();
-		boundingVolumeWorld->SetCenter(bv->GetCenter() + mSelf->GetPosition());
-		const auto& s = mSelf->GetScale();
-		boundingVolumeWorld->SetRadius(bv->GetRadius() * std::max(std::max(s.x, s.y), s.z));;
+		mSelf->SetBoundingVolume(*bv);
 
 		if (!keepMeshData)
 			ClearMeshData();
 	}
 
+	void BuildTriangleBVH(MaterialGroup& group){
+		auto& readOnly = group.GetGeometry();
+		if (readOnly.mTriangles.empty() || readOnly.mPositions.empty()){
+			if (readOnly.mBVH)
+				group.GetGeometryForWrite().mBVH = 0;
+			return;
+		}
+		auto numPositions = readOnly.mPositions.size();
+		for (auto& tri : readOnly.mTriangles){
+			if (tri.v[0] >= numPositions || tri.v[1] >= numPositions || tri.v[2] >= numPositions){
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Invalid triangle index in %s.", mSelf->GetName()).c_str());
+				return;
+			}
+		}
+		auto& geometry = group.GetGeometryForWrite();
+		geometry.mBVH = TriangleBVH::Create();
+		geometry.mBVH->Build(&geometry.mPositions[0], &geometry.mTriangles[0], geometry.mTriangles.size());
+	}
+
 	void SetMaterialFor(int matGroupIdx, MaterialPtr material){
 		auto& group = GetMaterialGroupFor(matGroupIdx);
 		group.mMaterial = material;
+		group.mSharedMaterial = false;
 		if (material && matGroupIdx == 0){
 			CheckMaterialOptions(material);			
 		}
@@ -987,126 +1127,88 @@ public:
 		auto& factory = SceneObjectFactory::GetInstance();		
 		auto mesh = factory.GetMeshArcheType(mSelf->GetName());
 		assert(mesh);
-		const Real maxRayDistance = 100000;
-		Real tMin = maxRayDistance;
-		const Real epsilon = 0.001f;
-		ModelIntersection rayTriIntersection;
-		rayTriIntersection.valid = false;
-
-		for (const auto& mg : mesh->mImpl->mMaterialGroups)
+		Real tMin = MaxRayDistance;
+		const ModelTriangle* hitTri = 0;
+		for (const auto& group : mesh->mImpl->mMaterialGroups)
 		{
-			for (const auto& tri : mg.mTriangles)
-			{
-				Real NdotD = tri.faceNormal.Dot(ray.GetDir());
-				if (abs(NdotD) < epsilon)
-				{
-					// ray is parallel or nearly parallel to polygon plane
-					continue;
-				}
-
-				Real t = (tri.d - tri.faceNormal.Dot(ray.GetOrigin())) / NdotD;
-				if (t <= 0)
-				{
-					// ray origin is behind the triangle;
-					continue;
-				}
-				if (t >= tMin)
-				{
-					continue;
-				}
-				Vec3 intersectionPoint = ray.GetOrigin() + ray.GetDir() * t;
-				// find the interpolation parameters alpha and beta using 2D projections
-				Real alpha;
-				Real beta;
-				Vec2 P;    // projection of the intersection onto an axis aligned plane
-				switch (tri.dominantAxis)
-				{
-				case 0:
-					P.x = intersectionPoint.y;
-					P.y = intersectionPoint.z;
-					break;
-				case 1:
-					P.x = intersectionPoint.x;
-					P.y = intersectionPoint.z;
-					break;
-				case 2:
-				default:
-					P.x = intersectionPoint.x;
-					P.y = intersectionPoint.y;
+			auto& mg = group.GetGeometry();
+			if (mg.mTriangles.empty())
+				continue;
+			if (mg.mBVH){
+				Real t;
+				int index = mg.mBVH->RayCast(&mg.mTriangles[0], ray, tMin, t);
+				if (index != -1){
+					tMin = t;
+					hitTri = &mg.mTriangles[index];
 				}
-				Real u0, u1, u2, v0, v1, v2;
-				u0 = P.x - tri.v0Proj.x;
-				v0 = P.y - tri.v0Proj.y;
-				u1 = tri.v1Proj.x - tri.v0Proj.x;
-				u2 = tri.v2Proj.x - tri.v0Proj.x;
-				v1 = tri.v1Proj.y - tri.v0Proj.y;
-				v2 = tri.v2Proj.y - tri.v0Proj.y;
-				if (abs(u1) < epsilon)
-				{
-					beta = u0 / u2;
-					if ((beta >= 0) && (beta <= 1))
-					{
-						alpha = (v0 - beta * v2) / v1;
-						if ((alpha >= 0) && ((alpha + beta) <= 1))
-						{
-							rayTriIntersection.valid = true;
-							rayTriIntersection.alpha = alpha;
-							rayTriIntersection.beta = beta;
-							rayTriIntersection.pTri = &tri;
-							tMin = t;
-						}
+			}
+			else{
+				for (const auto& tri : mg.mTriangles){
+					Real t;
+					if (GeomUtils::IntersectRayTriangle(ray.GetOrigin(), ray.GetDir(), tri, tMin, t)){
+						tMin = t;
+						hitTri = &tri;
 					}
 				}
-				else
-				{
-					beta = (v0*u1 - u0*v1) / (v2*u1 - u2*v1);
-					if ((beta >= 0) && (beta <= 1))
-					{
-						alpha = (u0 - beta * u2) / u1;
-						if ((alpha >= 0) && ((alpha + beta) <= 1))
-						{
-							rayTriIntersection.valid = true;
-							rayTriIntersection.alpha = alpha;
-							rayTriIntersection.beta = beta;
-							rayTriIntersection.pTri = &tri;
-							tMin = t;
+			}
+		}
+		if (outTri)
+			*outTri = hitTri;
+		if (!hitTri)
+			return false;
+		location = ray.GetPoint(tMin);
+		return true;
+	}
+
+	unsigned RayCast(const Ray* rays, unsigned num, Vec3* locations, const ModelTriangle** outTris) const{
+		auto& factory = SceneObjectFactory::GetInstance();
+		auto mesh = factory.GetMeshArcheType(mSelf->GetName());
+		assert(mesh);
+		std::vector<Real> tMin(num, MaxRayDistance);
+		std::vector<Real> t(num);
+		std::vector<int> hits(num);
+		for (unsigned i = 0; i < num; ++i){
+			outTris[i] = 0;
+		}
+		for (const auto& group : mesh->mImpl->mMaterialGroups)
+		{
+			auto& mg = group.GetGeometry();
+			if (mg.mTriangles.empty())
+				continue;
+			if (!mg.mBVH){
+				for (unsigned i = 0; i < num; ++i){
+					for (const auto& tri : mg.mTriangles){
+						if (GeomUtils::IntersectRayTriangle(rays[i].GetOrigin(), rays[i].GetDir(), tri, tMin[i], t[i])){
+							tMin[i] = t[i];
+							outTris[i] = &tri;
 						}
 					}
 				}
+				continue;
 			}
-			if (!rayTriIntersection.valid)
-			{
-				if (outTri)
-					*outTri = NULL;
-				return false;
-			}
-			else
-			{
-				// compute the location using barycentric coordinates
-				const ModelTriangle* pTri = rayTriIntersection.pTri;
-				Real alpha = rayTriIntersection.alpha;
-				Real beta = rayTriIntersection.beta;
-				location.x = ((1 - (alpha + beta)) * mg.mPositions[pTri->v[0]].x) +
-					alpha * mg.mPositions[pTri->v[2]].x +
-					beta * mg.mPositions[pTri->v[2]].x;
-				location.y = ((1 - (alpha + beta)) * mg.mPositions[pTri->v[0]].y) +
-					alpha * mg.mPositions[pTri->v[1]].y +
-					beta * mg.mPositions[pTri->v[2]].y;
-				location.z = ((1 - (alpha + beta)) * mg.mPositions[pTri->v[0]].z) +
-					alpha * mg.mPositions[pTri->v[1]].z +
-					beta * mg.mPositions[pTri->v[2]].z;
-				if (outTri)
-				{
-					*outTri = pTri;
+			mg.mBVH->RayCast(&mg.mTriangles[0], rays, num, MaxRayDistance, &hits[0], &t[0]);
+			for (unsigned i = 0; i < num; ++i){
+				if (hits[i] != -1 && t[i] < tMin[i]){
+					tMin[i] = t[i];
+					outTris[i] = &mg.mTriangles[hits[i]];
 				}
-				return true;
 			}
 		}
-		return false;
+		unsigned numHits = 0;
+		for (unsigned i = 0; i < num; ++i){
+			if (outTris[i]){
+				locations[i] = rays[i].GetPoint(tMin[i]);
+				++numHits;
+			}
+		}
+		return numHits;
 	}
 
 	BoundingVolumeConstPtr GetAABB() const { 
-		return mSelf->GetBoundingVolume(); 
+		auto& src = mSelf->GetBoundingVolume();
+		auto bv = BoundingVolume::Create(src.GetBVType());
+		*bv = src;
+		return bv;
 	}
 
 	void ClearVertexBuffers(){
@@ -1126,10 +1228,11 @@ public:
 				bdesc.RenderTarget[0].BlendOp = BLEND_OP_ADD;
 				bdesc.RenderTarget[0].SrcBlend = BLEND_SRC_ALPHA;
 				bdesc.RenderTarget[0].DestBlend = BLEND_INV_SRC_ALPHA;
-				it.mMaterial->SetBlendState(bdesc);
-				auto diffuse = it.mMaterial->GetDiffuseColor();
+				auto& material = GetMaterialForWrite(it);
+				material->SetBlendState(bdesc);
+				auto diffuse = material->GetDiffuseColor();
 				diffuse.w = alpha;
-				it.mMaterial->SetDiffuseColor(diffuse);
+				material->SetDiffuseColor(diffuse);
 			}
 		}
 	}
@@ -1190,7 +1293,7 @@ public:
 		{
 			if (it.mMaterial)
 			{
-				it.mMaterial->SetAmbientColor(color.GetVec4());
+				GetMaterialForWrite(it)->SetAmbientColor(color.GetVec4());
 			}
 			if (it.mForceAlphaMaterial){
 				it.mForceAlphaMaterial->SetAmbientColor(color.GetVec4());
@@ -1207,6 +1310,36 @@ public:
 		}
 		return mMaterialGroups[matGroupIdx];		
 	}
+	bool RenderInstances(MaterialGroup* it, unsigned numInstances){
+		if (it->mInstancedSource != it->mMaterial){
+			it->mInstancedMaterial = MeshInstancer::CreateInstancedMaterial(it->mMaterial);
+			it->mInstancedSource = it->mMaterial;
+		}
+		if (!it->mInstancedMaterial || !it->mInstancedMaterial->Bind(true)){
+			Logger::Log(FB_ERROR_LOG_ARG, "Cannot bind the instanced material. Instancing is disabled.");
+			MeshInstancer::SetEnabled(false);
+			return false;
+		}
+		BindVertexBuffers(it);
+		it->mIndexBuffer->Bind(0);
+		Renderer::GetInstance().DrawIndexedInstanced(it->mIndexBuffer->GetNumIndices(), numInstances, 0, 0, 0);
+		it->mInstancedMaterial->Unbind();
+		return true;
+	}
+
+	void BindVertexBuffers(MaterialGroup* it){
+		const unsigned int numBuffers = 5;
+
+		VertexBufferPtr buffers[numBuffers] = { it->mVBPos, it->mVBNormal, it->mVBUV, it->mVBColor, it->mVBTangent };
+		unsigned int strides[numBuffers] = { it->mVBPos->GetStride(),
+			it->mVBNormal ? it->mVBNormal->GetStride() : 0,
+			it->mVBUV ? it->mVBUV->GetStride() : 0,
+			it->mVBColor ? it->mVBColor->GetStride() : 0,
+			it->mVBTangent ? it->mVBTangent->GetStride() : 0 };
+		unsigned int offsets[numBuffers] = { 0, 0, 0, 0, 0 };
+		Renderer::GetInstance().SetVertexBuffers(0, numBuffers, buffers, strides, offsets);
+	}
+
 	void RenderMaterialGroup(MaterialGroup* it, bool onlyPos){
 		assert(it);
 		if (!it || !it->mMaterial || !it->mVBPos)
@@ -1232,16 +1365,7 @@ public:
 		}
 		else
 		{
-			const unsigned int numBuffers = 5;
-
-			VertexBufferPtr buffers[numBuffers] = { it->mVBPos, it->mVBNormal, it->mVBUV, it->mVBColor, it->mVBTangent };
-			unsigned int strides[numBuffers] = { it->mVBPos->GetStride(),
-				it->mVBNormal ? it->mVBNormal->GetStride() : 0,
-				it->mVBUV ? it->mVBUV->GetStride() : 0,
-				it->mVBColor ? it->mVBColor->GetStride() : 0,
-				it->mVBTangent ? it->mVBTangent->GetStride() : 0 };
-			unsigned int offsets[numBuffers] = { 0, 0, 0, 0, 0 };
-			renderer.SetVertexBuffers(0, numBuffers, buffers, strides, offsets);
+			BindVertexBuffers(it);
 			if (it->mIndexBuffer)
 			{
 				it->mIndexBuffer->Bind(0);				
@@ -1393,6 +1517,22 @@ Vec2* MeshObject::GetUVs(int matGroupIdx, size_t& outNumUVs) {
 	return mImpl->GetUVs(matGroupIdx, outNumUVs);
 }
 
+unsigned MeshObject::GetNumMaterialGroups() const {
+	return mImpl->GetNumMaterialGroups();
+}
+
+const Vec3* MeshObject::GetPositions(int matGroupIdx, size_t& outNumPositions) const {
+	return const_cast<const Impl&>(*mImpl).GetPositions(matGroupIdx, outNumPositions);
+}
+
+const Vec3* MeshObject::GetNormals(int matGroupIdx, size_t& outNumNormals) const {
+	return const_cast<const Impl&>(*mImpl).GetNormals(matGroupIdx, outNumNormals);
+}
+
+const Vec2* MeshObject::GetUVs(int matGroupIdx, size_t& outNumUVs) const {
+	return const_cast<const Impl&>(*mImpl).GetUVs(matGroupIdx, outNumUVs);
+}
+
 void MeshObject::GenerateTangent(int matGroupIdx, UINT* indices, size_t num) {
 	mImpl->GenerateTangent(matGroupIdx, indices, num);
 }
@@ -1489,6 +1629,14 @@ bool MeshObject::RayCast(const Ray& ray, Vec3& location, const ModelTriangle** o
 	return mImpl->RayCast(ray, location, outTri);
 }
 
+unsigned MeshObject::RayCast(const Ray* rays, unsigned num, Vec3* locations, const ModelTriangle** outTris) const {
+	if (num == 0 || !rays || !locations || !outTris){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return 0;
+	}
+	return mImpl->RayCast(rays, num, locations, outTris);
+}
+
 BoundingVolumeConstPtr MeshObject::GetAABB() const {
 	return mImpl->GetAABB();
 }
@@ -92,6 +92,11 @@ namespace fb{
 		Vec3* GetPositions(int matGroupIdx, size_t& outNumPositions);
 		Vec3* GetNormals(int matGroupIdx, size_t& outNumNormals);
 		Vec2* GetUVs(int matGroupIdx, size_t& outNumUVs);
+		unsigned GetNumMaterialGroups() const;
+		/// Read only access. Does not detach the data shared with the clones.
+		const Vec3* GetPositions(int matGroupIdx, size_t& outNumPositions) const;
+		const Vec3* GetNormals(int matGroupIdx, size_t& outNumNormals) const;
+		const Vec2* GetUVs(int matGroupIdx, size_t& outNumUVs) const;
 		void GenerateTangent(int matGroupIdx, UINT* indices, size_t num);
 		void EndModification(bool keepMeshData);
 		void SetMaterialFor(int matGroupIdx, MaterialPtr material);
@@ -119,6 +124,9 @@ namespace fb{
 		MapData MapVB(MeshVertexBufferType::Enum type, size_t materialGroupIdx);
 		void UnmapVB(MeshVertexBufferType::Enum type, size_t materialGroupIdx);
 		bool RayCast(const Ray& ray, Vec3& location, const ModelTriangle** outTri = 0) const;
+		/// Traverses the triangle BVH with packets of rays. outTris[i] is null
+		/// when rays[i] misses. Returns the number of hits.
+		unsigned RayCast(const Ray* rays, unsigned num, Vec3* locations, const ModelTriangle** outTris) const;
 		BoundingVolumeConstPtr GetAABB() const;
 		void ClearVertexBuffers();
 		void SetAlpha(Real alpha);
@@ -45,6 +45,8 @@
 #include "BillboardQuad.h"
 #include "DustRenderer.h"
 #include "TrailObject.h"
+#include "TrailRenderer.h"
+#include "MeshInstancer.h"
 #include "binary_mesh.h"
 #include "SceneObjectFactoryOptions.h"
 
@@ -78,6 +80,8 @@ public:
 		mOptions = SceneObjectFactoryOptions::Create();
 	}
 	~Impl(){
+		TrailRenderer::FinalizeRenderers();
+		MeshInstancer::FinalizeInstancer();
 	}
 
 	void SetEnableMeshLoad(bool enable){
@@ -138,11 +142,15 @@ public:
 		return ret;
 	}
 
-	MaterialPtr GetFallbackMaterial(const char* originalPath, const char* daePath){
+	static std::string GetFallbackMaterialPath(const char* originalPath, const char* daePath){
 		auto materialFileName = FileSystem::GetFileName(originalPath);
 		auto path = FileSystem::GetParentPath(daePath);
 		path += "/";
-		auto ret = FileSystem::ConcatPath(path.c_str(), materialFileName.c_str());
+		return FileSystem::ConcatPath(path.c_str(), materialFileName.c_str());
+	}
+
+	MaterialPtr GetFallbackMaterial(const char* originalPath, const char* daePath){
+		auto ret = GetFallbackMaterialPath(originalPath, daePath);
 		return Renderer::GetInstance().CreateMaterial(ret.c_str());
 	}
 
@@ -228,6 +236,10 @@ public:
 	}
 
 	MeshObjectPtr CreateMeshObject(const char* daeFilePath, const MeshImportDesc& desc){
+		return CreateMeshObject(daeFilePath, 0, desc);
+	}
+
+	MeshObjectPtr CreateMeshObject(const char* daeFilePath, collada::MeshPtr meshData, const MeshImportDesc& desc){
 		if (!ValidCString(daeFilePath)) {
 			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
 			return 0;
@@ -245,22 +257,11 @@ public:
 			it->second.mNumCloned++;
 			return it->second.mObject->Clone();
 		}
-		collada::MeshPtr compiled_mesh;
-		std::string fbmesh_path = FileSystem::ReplaceExtension(daeFilePath, "fbmesh");
-		if (!mOptions->o_rawCollada) {			
-			FileSystem::Open file(fbmesh_path.c_str(), "rb");
-			if (file.IsOpen()) {
-				auto& data = *file.GetBinaryData();
-				typedef boost::iostreams::basic_array_source<char> Device;
-				boost::iostreams::stream_buffer<Device> buffer((char*)&data[0], data.size());
-				std::istream stream(&buffer);
-				compiled_mesh = load_mesh(stream, fbmesh_path.c_str(), desc);
-			}
-		}
-
+		collada::MeshPtr compiled_mesh = meshData ? meshData : LoadCompiledMeshData(daeFilePath, desc, 0);
 		if (!compiled_mesh) {
 			Logger::Log(FB_DEFAULT_LOG_ARG, FormatString(
-				"(info) %s not found. Trying to load .dae file.", fbmesh_path.c_str()).c_str());
+				"(info) %s not found. Trying to load .dae file.",
+				FileSystem::ReplaceExtension(daeFilePath, "fbmesh").c_str()).c_str());
 
 			auto pColladaImporter = ColladaImporter::Create();
 			ColladaImporter::ImportOptions option;
@@ -291,6 +292,45 @@ public:
 		}
 	}
 
+	collada::MeshPtr LoadCompiledMeshData(const char* daeFilePath, const MeshImportDesc& desc, StringVector* outMaterials){
+		if (!ValidCString(daeFilePath)) {
+			Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+			return 0;
+		}
+		if (mOptions->o_rawCollada)
+			return 0;
+		std::string fbmesh_path = FileSystem::ReplaceExtension(daeFilePath, "fbmesh");
+		ByteArrayPtr pData;
+		{
+			FileSystem::Lock lock;
+			FileSystem::Open file(fbmesh_path.c_str(), "rb");
+			if (file.IsOpen())
+				pData = file.GetBinaryData();
+		}
+		if (!pData || pData->empty())
+			return 0;
+
+		auto& data = *pData;
+		typedef boost::iostreams::basic_array_source<char> Device;
+		boost::iostreams::stream_buffer<Device> buffer((char*)&data[0], data.size());
+		std::istream stream(&buffer);
+		auto compiled_mesh = load_mesh(stream, fbmesh_path.c_str(), desc);
+		if (compiled_mesh && outMaterials) {
+			// Resolves the paths as ConvertMeshData() does.
+			FileSystem::Lock lock;
+			for (auto& group : compiled_mesh->mMaterialGroups){
+				auto& materialPath = group.second.mMaterialPath;
+				if (materialPath.empty())
+					continue;
+				if (FileSystem::ResourceExists(materialPath.c_str()))
+					outMaterials->push_back(materialPath);
+				else
+					outMaterials->push_back(GetFallbackMaterialPath(materialPath.c_str(), daeFilePath));
+			}
+		}
+		return compiled_mesh;
+	}
+
 	std::vector<MeshObjectPtr> CreateMeshObjects(const char* daeFilePath, const MeshImportDesc& desc){
 		std::vector<MeshObjectPtr> ret;
 		if (!ValidCString(daeFilePath)) {
@@ -547,6 +587,14 @@ MeshObjectPtr SceneObjectFactory::CreateMeshObject(const char* daeFilePath, cons
 	return mImpl->CreateMeshObject(daeFilePath, desc);
 }
 
+MeshObjectPtr SceneObjectFactory::CreateMeshObject(const char* daeFilePath, collada::MeshPtr meshData, const MeshImportDesc& desc) {
+	return mImpl->CreateMeshObject(daeFilePath, meshData, desc);
+}
+
+collada::MeshPtr SceneObjectFactory::LoadCompiledMeshData(const char* daeFilePath, const MeshImportDesc& desc, StringVector* outMaterials) {
+	return mImpl->LoadCompiledMeshData(daeFilePath, desc, outMaterials);
+}
+
 std::vector<MeshObjectPtr> SceneObjectFactory::CreateMeshObjects(const char* daeFilePath, const MeshImportDesc& desc){
 	return mImpl->CreateMeshObjects(daeFilePath, desc);
 }
@@ -29,6 +29,10 @@
 #include "FBCommonHeaders/Types.h"
 #include "MeshImportDesc.h"
 namespace fb{
+	namespace collada {
+		struct Mesh;
+		typedef std::shared_ptr<Mesh> MeshPtr;
+	}
 	FB_DECLARE_SMART_PTR(TrailObject);
 	FB_DECLARE_SMART_PTR(DustRenderer);
 	FB_DECLARE_SMART_PTR(BillboardQuad);
@@ -55,6 +59,15 @@ namespace fb{
 		.dae file for another mesh object, the new mesh will be cloned from the archetype. */
 		MeshObjectPtr CreateMeshObject(const char* daeFilePath);
 		MeshObjectPtr CreateMeshObject(const char* daeFilePath, const MeshImportDesc& desc);
+		/** Creates a MeshObject with the data loaded by LoadCompiledMeshData().
+		The created one becomes the archetype of \a daeFilePath as if it is created by
+		CreateMeshObject(daeFilePath, desc). */
+		MeshObjectPtr CreateMeshObject(const char* daeFilePath, collada::MeshPtr meshData, const MeshImportDesc& desc);
+		/** Loads the mesh data from the compiled .fbmesh file without creating any
+		renderer resources. Can be called on worker threads.
+		\param outMaterials receives the material files the mesh will use. Can be null.
+		\return 0 if the compiled file is not found or o_rawCollada is on. */
+		collada::MeshPtr LoadCompiledMeshData(const char* daeFilePath, const MeshImportDesc& desc, StringVector* outMaterials);
 		/// Create mesh objects.
 		/// Use this function for loading seperated meshes in a .dae file.
 		/// Currently using for fracture meshes.
@@ -27,71 +27,79 @@
 
 #include "stdafx.h"
 #include "TrailObject.h"
+#include "TrailRenderer.h"
 #include "FBRenderer/Renderer.h"
 #include "FBRenderer/Material.h"
-#include "FBRenderer/VertexBuffer.h"
 #include "FBRenderer/Camera.h"
+#include "FBMathLib/Color.h"
 using namespace fb;
+static const char* DefaultTrailMaterial = "EssentialEngineData/materials/Trail.material";
+
 class TrailObject::Impl
 {
 public:
-	struct TrailVertex{
-		TrailVertex(const Vec4f& pos)
-			: mPos(pos)
-		{
-		}
-		Vec4f mPos;
-	};
-
-	typedef std::vector<TrailVertex> Points;
-	typedef std::vector<float> Times;
+	typedef TrailRenderer::Vertex TrailVertex;
 
 	TrailObject* mSelf;
-	Points mPoints;
-	Times mTimes;
+	// Ring buffer. The newest point is at mHead and the older ones follow it,
+	// so adding and expiring a point do not move the others.
+	std::vector<TrailVertex> mPoints;
+	unsigned mHead;
+	unsigned mNumPoints;
 	std::queue<std::pair<Vec3, Vec3>> mPairedPoints;
 
-	bool mDirty;
 	float mWidth;
+	Color mColor;
 	unsigned mMaxPoints;
 	float mDeleteTime;
+	FRAME_PRECISION mQueuedFrame;
 
 	MaterialPtr mMaterial;
-	VertexBufferPtr mVB;
 	Vec3 mLastPoint;
 
 	//---------------------------------------------------------------------------
 	Impl(TrailObject* self)
 		: mSelf(self)
+		, mHead(0)
+		, mNumPoints(0)
 		, mMaxPoints(100)
-		, mDirty(false)
 		, mWidth(0.025f)
+		, mColor(0, 1, 1, 1)
 		, mDeleteTime(2.f)
+		, mQueuedFrame(-1)
 		, mLastPoint(0, 0, 0)
 	{
-		mMaterial = Renderer::GetInstance().CreateMaterial("EssentialEngineData/materials/Trail.material");
+		mMaterial = TrailRenderer::GetMaterial(DefaultTrailMaterial);
+		mPoints.resize(mMaxPoints);
 	}
 
 	// IRenderable
 	void PreRender(const RenderParam& param, RenderParamOut* paramOut){
-		if (mDirty){
-			mDirty = false;
-			RefreshVertexBuffer();
-		}
+		if (mSelf->HasObjFlag(SceneObjectFlag::Hide) || mNumPoints < 3 || !mMaterial || !param.mScene)
+			return;
+		auto frame = gpTimer->GetFrame();
+		if (mQueuedFrame == frame)
+			return;
+		mQueuedFrame = frame;
+		auto renderer = TrailRenderer::GetRenderer(param.mScene, mMaterial);
+		if (!renderer)
+			return;
+		auto dest = renderer->Queue(mNumPoints);
+		unsigned first = std::min(mNumPoints, (unsigned)mPoints.size() - mHead);
+		memcpy(dest, &mPoints[mHead], sizeof(TrailVertex) * first);
+		if (first < mNumPoints)
+			memcpy(dest + first, &mPoints[0], sizeof(TrailVertex) * (mNumPoints - first));
+		// the end points only give the direction; this also keeps trails apart.
+		dest[0].mWidth_InvLife_Inner.z = 0.f;
+		dest[mNumPoints - 1].mWidth_InvLife_Inner.z = 0.f;
 	}
 
 	void Render(const RenderParam& param, RenderParamOut* paramOut){
-		if (mSelf->HasObjFlag(SceneObjectFlag::Hide) || !mVB)
+		if (param.mRenderPass != RENDER_PASS::PASS_NORMAL || mQueuedFrame != gpTimer->GetFrame() || !param.mScene)
 			return;
-		if (param.mRenderPass != RENDER_PASS::PASS_NORMAL || mPoints.empty())
-			return;
-		RenderEventMarker mark("Trail Object");
-		auto& renderer = Renderer::GetInstance();
-		renderer.SetPrimitiveTopology(PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ);
-		mMaterial->Bind(true);
-		mVB->Bind();
-		renderer.Draw(mPoints.size(), 0);
-		mMaterial->Unbind();
+		auto renderer = TrailRenderer::GetRenderer(param.mScene, mMaterial);
+		if (renderer)
+			renderer->Render(param);
 	}
 
 	void PostRender(const RenderParam& param, RenderParamOut* paramOut){
@@ -102,7 +110,7 @@ public:
 	// Own
 	//------------------------------------------------------------------------
 	void SetMaterial(const char* filepath){
-		mMaterial = Renderer::GetInstance().CreateMaterial(filepath);
+		mMaterial = TrailRenderer::GetMaterial(filepath);
 	}
 
 	void SetMaterial(MaterialPtr pMat){
@@ -112,6 +120,27 @@ public:
 	MaterialPtr GetMaterial() const{
 		return mMaterial;
 	}
+
+	TrailVertex& GetPoint(unsigned i){
+		assert(i < mNumPoints);
+		return mPoints[(mHead + i) % mPoints.size()];
+	}
+
+	TrailVertex MakeVertex(const Vec3& pos, float time) const{
+		TrailVertex v;
+		v.mPos_Birth = Vec4f(pos, time);
+		v.mWidth_InvLife_Inner = Vec3f(mWidth, 1.f / mDeleteTime, 1.f);
+		v.mColor = mColor.Get4Byte();
+		return v;
+	}
+
+	void PushFront(const TrailVertex& v){
+		mHead = mHead == 0 ? mPoints.size() - 1 : mHead - 1;
+		mPoints[mHead] = v;
+		if (mNumPoints < mPoints.size())
+			++mNumPoints;
+	}
+
 	//for billboard trail - automatically face to the camera
 	void AddPoint(const Vec3& worldPos){
 		mLastPoint = worldPos;
@@ -121,40 +150,40 @@ public:
 		if (GetDistToCam() > 300.0f)
 			return;
 
-		if (!mPoints.empty()){
-			if (mPoints.size() >= 2)
+		if (mNumPoints){
+			if (mNumPoints >= 2)
 			{
-				if (IsEqual(mPoints[1].mPos.ToVec3(), worldPos, 0.001f))
+				if (IsEqual(GetPoint(1).mPos_Birth.ToVec3(), worldPos, 0.001f))
 					return;
 			}
-			else if (IsEqual(mPoints[0].mPos.ToVec3(), worldPos, 0.001f))
+			else if (IsEqual(GetPoint(0).mPos_Birth.ToVec3(), worldPos, 0.001f))
 				return;
 
 
 		}
-		if (mPoints.size() >= 3){
-			mPoints[0] = TrailVertex(Vec4(worldPos, 1.f));
-			mTimes[0] = gpTimer->GetTime();
-			Vec3 dir = mPoints[0].mPos.ToVec3() - mPoints[1].mPos.ToVec3();
-			mPoints.insert(mPoints.begin(), TrailVertex(Vec4(mPoints[0].mPos.ToVec3() + dir, 1.0)));
-			mTimes.insert(mTimes.begin(), gpTimer->GetTime());
+		float time = (float)gpTimer->GetTime();
+		if (mNumPoints >= 3){
+			// the front point is only for the direction.
+			GetPoint(0) = MakeVertex(worldPos, time);
+			Vec3 dir = worldPos - GetPoint(1).mPos_Birth.ToVec3();
+			PushFront(MakeVertex(worldPos + dir, time));
 		}
 		else{
-			mPoints.insert(mPoints.begin(), TrailVertex(Vec4(worldPos, 1.f)));
-			mTimes.insert(mTimes.begin(), gpTimer->GetTime());
+			PushFront(MakeVertex(worldPos, time));
 		}
-		mDirty = true;
-		while (mPoints.size() > mMaxPoints){
-			mPoints.pop_back();
-			mTimes.pop_back();
+	}
+
+	void RefreshPoints(){
+		auto color = mColor.Get4Byte();
+		for (auto& p : mPoints){
+			p.mWidth_InvLife_Inner.x = mWidth;
+			p.mColor = color;
 		}
 	}
 
 	void SetWidth(float width){
 		mWidth = width;
-		if (mMaterial){
-			mMaterial->SetShaderParameter(0, Vec4(mWidth, 0, 0, 0));
-		}
+		RefreshPoints();
 	}
 
 	void SetWidthMultiply(float mul) {
@@ -162,7 +191,12 @@ public:
 	}
 
 	void SetLengthMultiply(float mul) {
-		mMaxPoints = unsigned(mMaxPoints * mul);
+		SetMaxPoints(unsigned(mMaxPoints * mul));
+	}
+
+	void SetColor(const Color& color){
+		mColor = color;
+		RefreshPoints();
 	}
 
 	// for manual trail
@@ -171,59 +205,31 @@ public:
 		if (GetDistToCam() > 100.0f)
 			return;
 		mPairedPoints.push(std::make_pair(worldPosA, worldPosB));
-		mDirty = true;
 	}
 
 	void SetMaxPoints(unsigned num){
+		// keeps the newest points.
+		std::vector<TrailVertex> points(std::max(num, 1u));
+		unsigned numPoints = std::min(mNumPoints, num);
+		for (unsigned i = 0; i < numPoints; ++i){
+			points[i] = GetPoint(i);
+		}
+		mPoints.swap(points);
+		mHead = 0;
+		mNumPoints = numPoints;
 		mMaxPoints = num;
-		mVB = 0;
 	}
 
 	void Clear(){
-		mPoints.clear();
-		mTimes.clear();
+		mHead = 0;
+		mNumPoints = 0;
 		ClearWithSwap(mPairedPoints);
-
-		mDirty = true;
-	}
-
-	void RefreshVertexBuffer(){
-		unsigned size = mPoints.size();
-		if (size < 3 && mPairedPoints.size() < 3)
-			return;
-		if (!mVB){
-			mVB = Renderer::GetInstance().CreateVertexBuffer(0, sizeof(TrailVertex), mMaxPoints + 1, BUFFER_USAGE::BUFFER_USAGE_DYNAMIC, BUFFER_CPU_ACCESS_WRITE);
-			assert(mVB);
-		}
-
-		size = mPoints.size();
-		auto mapData = mVB->Map(0, MAP_TYPE_WRITE_DISCARD, MAP_FLAG_NONE);
-		if (mapData.pData){
-			for (unsigned i = 0; i < size; ++i){
-				float alpha = (size - i) / (float)size;
-				mPoints[i].mPos.w = alpha;
-			}
-
-			memcpy(mapData.pData, &mPoints[0], sizeof(TrailVertex)*size);
-			mVB->Unmap(0);
-		}
 	}
 
 	void Update(float dt){
-		if (mPoints.empty())
-			return;
-
-		int size = (int)mTimes.size();
 		auto curTime = gpTimer->GetTime();
-		for (int i = size - 1; i >= 0; --i){
-			if (curTime - mTimes[i] >= mDeleteTime){
-				mTimes.erase(mTimes.begin() + i);
-				mPoints.erase(mPoints.begin() + i);
-				mDirty = true;
-			}
-			else{
-				break;
-			}
+		while (mNumPoints && curTime - GetPoint(mNumPoints - 1).mPos_Birth.w >= mDeleteTime){
+			--mNumPoints;
 		}
 	}
 
@@ -289,6 +295,10 @@ void TrailObject::AddPoint(const Vec3& worldPosA, const Vec3& worldPosB) {
 	mImpl->AddPoint(worldPosA, worldPosB);
 }
 
+void TrailObject::SetColor(const Color& color) {
+	mImpl->SetColor(color);
+}
+
 void TrailObject::SetMaxPoints(unsigned num) {
 	mImpl->SetMaxPoints(num);
 }
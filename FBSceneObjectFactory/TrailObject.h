@@ -29,6 +29,7 @@
 #include "FBCommonHeaders/platform.h"
 #include "FBSceneManager/SceneObject.h"
 namespace fb{
+	class Color;
 	FB_DECLARE_SMART_PTR(Material);
 	FB_DECLARE_SMART_PTR(TrailObject);
 	class FB_DLL_SCENEOBJECTFACTORY TrailObject : public SceneObject
@@ -52,12 +53,16 @@ namespace fb{
 		//------------------------------------------------------------------------
 		void SetMaterial(const char* filepath);
 		void SetMaterial(MaterialPtr pMat);
+		/// Trails using the same material are drawn together by TrailRenderer,
+		/// so changes to the returned material affect all of them.
 		MaterialPtr GetMaterial() const;
 		//for billboard trail - automatically face to the camera
 		void AddPoint(const Vec3& worldPos);
 		void SetWidth(float width);
 		void SetWidthMultiply(float mul);
 		void SetLengthMultiply(float mul);
+		/// Multiplied with the diffuse color of the material.
+		void SetColor(const Color& color);
 		// for manual trail
 		void AddPoint(const Vec3& worldPosA, const Vec3& worldPosB);		
 		void SetMaxPoints(unsigned num);
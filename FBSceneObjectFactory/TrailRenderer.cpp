@@ -0,0 +1,210 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "TrailRenderer.h"
+#include "FBRenderer/Renderer.h"
+#include "FBRenderer/Material.h"
+#include "FBRenderer/VertexBuffer.h"
+#include "FBRenderer/RenderParam.h"
+#include "FBRenderer/ICamera.h"
+#include "FBCommonHeaders/Helpers.h"
+#include <map>
+using namespace fb;
+
+namespace fb{
+	typedef std::map< std::pair<IScene*, Material*>, TrailRendererPtr > TRAIL_RENDERERS;
+	static TRAIL_RENDERERS sRenderers;
+	static std::unordered_map<std::string, MaterialPtr> sMaterials;
+	static size_t sNumDrawCalls;
+	static FRAME_PRECISION sLastDrawFrame = -1;
+	static const unsigned MIN_SHARED_VERTICES = 4096;
+}
+
+class TrailRenderer::Impl{
+public:
+	MaterialPtr mMaterial;
+	std::vector<Vertex> mVertices;
+	VertexBufferPtr mVertexBuffer;
+	unsigned mMaxVertices;
+	FRAME_PRECISION mQueuedFrame;
+	FRAME_PRECISION mUploadedFrame;
+	unsigned mNumUploaded;
+	// The trails of the batch call Render() one after another; the first
+	// call for each camera in a frame draws.
+	FRAME_PRECISION mRenderedFrame;
+	std::vector<unsigned> mRenderedCameras;
+
+	//---------------------------------------------------------------------------
+	Impl(MaterialPtr material)
+		: mMaterial(material)
+		, mMaxVertices(0)
+		, mQueuedFrame(-1)
+		, mUploadedFrame(-1)
+		, mNumUploaded(0)
+		, mRenderedFrame(-1)
+	{
+	}
+
+	Vertex* Queue(unsigned numVertices){
+		auto frame = gpTimer->GetFrame();
+		if (mQueuedFrame != frame){
+			mQueuedFrame = frame;
+			mVertices.clear();
+		}
+		auto start = mVertices.size();
+		mVertices.resize(start + numVertices);
+		return &mVertices[start];
+	}
+
+	void Render(const RenderParam& param){
+		auto frame = gpTimer->GetFrame();
+		if (mQueuedFrame != frame || mVertices.empty())
+			return;
+		if (mRenderedFrame != frame){
+			mRenderedFrame = frame;
+			mRenderedCameras.clear();
+		}
+		unsigned camera = param.mCamera ? param.mCamera->GetIndexSerial() : 0;
+		if (ValueExistsInVector(mRenderedCameras, camera))
+			return;
+		mRenderedCameras.push_back(camera);
+
+		auto& renderer = Renderer::GetInstance();
+		unsigned num = mVertices.size();
+		if (!Upload(frame))
+			return;
+
+		RenderEventMarker mark("Trails");
+		renderer.SetPrimitiveTopology(PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ);
+		mMaterial->Bind(true);
+		mVertexBuffer->Bind();
+		renderer.Draw(num, 0);
+		mMaterial->Unbind();
+		if (sLastDrawFrame != frame){
+			sLastDrawFrame = frame;
+			sNumDrawCalls = 0;
+		}
+		++sNumDrawCalls;
+	}
+
+	// Trails queued for a later camera of the frame are appended, so the
+	// buffer is written again when the batch has grown.
+	bool Upload(FRAME_PRECISION frame){
+		unsigned num = mVertices.size();
+		if (mUploadedFrame == frame && mNumUploaded == num)
+			return true;
+		auto& renderer = Renderer::GetInstance();
+		if (num > mMaxVertices){
+			mMaxVertices = std::max(mMaxVertices * 2, MIN_SHARED_VERTICES);
+			while (mMaxVertices < num)
+				mMaxVertices *= 2;
+			mVertexBuffer = renderer.CreateVertexBuffer(0, sizeof(Vertex), mMaxVertices,
+				BUFFER_USAGE_DYNAMIC, BUFFER_CPU_ACCESS_WRITE);
+			if (!mVertexBuffer){
+				Logger::Log(FB_ERROR_LOG_ARG, FormatString("Cannot create the trail vertex buffer(%u).", mMaxVertices).c_str());
+				mMaxVertices = 0;
+				return false;
+			}
+		}
+		auto mapData = mVertexBuffer->Map(0, MAP_TYPE_WRITE_DISCARD, MAP_FLAG_NONE);
+		if (!mapData.pData)
+			return false;
+		memcpy(mapData.pData, &mVertices[0], sizeof(Vertex) * num);
+		mVertexBuffer->Unmap(0);
+		mUploadedFrame = frame;
+		mNumUploaded = num;
+		return true;
+	}
+};
+
+//---------------------------------------------------------------------------
+TrailRendererPtr TrailRenderer::GetRenderer(IScene* scene, MaterialPtr material){
+	if (!scene || !material){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return 0;
+	}
+	auto key = std::make_pair(scene, material.get());
+	auto it = sRenderers.find(key);
+	if (it != sRenderers.end())
+		return it->second;
+
+	// Drops the batches nobody queued into lately; their scene can be gone.
+	auto frame = gpTimer->GetFrame();
+	for (auto it = sRenderers.begin(); it != sRenderers.end(); /**/){
+		auto queuedFrame = it->second->mImpl->mQueuedFrame;
+		if (queuedFrame == (FRAME_PRECISION)-1 || frame - queuedFrame > 1)
+			it = sRenderers.erase(it);
+		else
+			++it;
+	}
+
+	TrailRendererPtr p(new TrailRenderer(material), [](TrailRenderer* obj){ delete obj; });
+	sRenderers[key] = p;
+	return p;
+}
+
+MaterialPtr TrailRenderer::GetMaterial(const char* filepath){
+	if (!ValidCString(filepath)){
+		Logger::Log(FB_ERROR_LOG_ARG, "Invalid arg.");
+		return 0;
+	}
+	std::string loweredPath(filepath);
+	ToLowerCase(loweredPath);
+	auto it = sMaterials.find(loweredPath);
+	if (it != sMaterials.end())
+		return it->second;
+	auto material = Renderer::GetInstance().CreateMaterial(filepath);
+	if (material)
+		sMaterials[loweredPath] = material;
+	return material;
+}
+
+void TrailRenderer::FinalizeRenderers(){
+	sRenderers.clear();
+	sMaterials.clear();
+}
+
+size_t TrailRenderer::GetNumDrawCalls(){
+	return sLastDrawFrame == gpTimer->GetFrame() ? sNumDrawCalls : 0;
+}
+
+TrailRenderer::TrailRenderer(MaterialPtr material)
+	: mImpl(new Impl(material))
+{
+}
+
+TrailRenderer::~TrailRenderer(){
+}
+
+TrailRenderer::Vertex* TrailRenderer::Queue(unsigned numVertices){
+	return mImpl->Queue(numVertices);
+}
+
+void TrailRenderer::Render(const RenderParam& param){
+	mImpl->Render(param);
+}
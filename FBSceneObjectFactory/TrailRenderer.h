@@ -0,0 +1,64 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "FBCommonHeaders/Types.h"
+#include "FBMathLib/Vec3.h"
+#include "FBMathLib/Vec4.h"
+namespace fb{
+	struct RenderParam;
+	class IScene;
+	FB_DECLARE_SMART_PTR(Material);
+	FB_DECLARE_SMART_PTR(TrailRenderer);
+	/// Draws every TrailObject of a scene that shares a material with one
+	/// draw call per camera. Trails copy their points in PreRender() and the
+	/// first TrailObject::Render() for a camera draws all of them.
+	class FB_DLL_SCENEOBJECTFACTORY TrailRenderer{
+		FB_DECLARE_PIMPL_NON_COPYABLE(TrailRenderer);
+		TrailRenderer(MaterialPtr material);
+		~TrailRenderer();
+
+	public:
+		struct Vertex{
+			Vec4f mPos_Birth; // w: time when the point was added
+			Vec3f mWidth_InvLife_Inner; // z: 0 for the first and the last point of a trail
+			DWORD mColor;
+		};
+
+		static TrailRendererPtr GetRenderer(IScene* scene, MaterialPtr material);
+		/// Trails with the same material file share the returned material.
+		static MaterialPtr GetMaterial(const char* filepath);
+		static void FinalizeRenderers();
+		static size_t GetNumDrawCalls();
+
+		/// Returns space for numVertices in this frame's batch.
+		/// The pointer is valid until the next Queue().
+		Vertex* Queue(unsigned numVertices);
+		/// Draws once per camera in a frame. Later calls for the camera do nothing.
+		void Render(const RenderParam& param);
+	};
+}
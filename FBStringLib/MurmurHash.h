@@ -26,7 +26,8 @@
 */
 
 #pragma once
-typedef unsigned __int64    UINT64, *PUINT64;
+#include "FBCommonHeaders/Types.h"
+typedef UINT64 *PUINT64;
 namespace fb
 {
 const unsigned int murmurSeed = 0xaabbccdd;
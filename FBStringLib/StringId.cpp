@@ -0,0 +1,139 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "StringId.h"
+#include "FBCommonHeaders/SpinLock.h"
+#include <unordered_map>
+#include <cstring>
+#include <iostream>
+
+namespace fb{
+	using namespace StringIdDetail;
+
+	// Same as StringIdDetail::Hash() and hash64() without the recursion.
+	template<bool NoCase>
+	static StringId HashString(const char* s, size_t length){
+		auto byte = [s](size_t i) -> UINT64{
+			return (UINT64)(unsigned char)(NoCase ? Lower(s[i]) : s[i]);
+		};
+		UINT64 h = Seed ^ ((UINT64)length * M);
+		size_t numBlocks = length / 8;
+		for (size_t i = 0; i < numBlocks; ++i){
+			size_t i8 = i * 8;
+			UINT64 k = byte(i8) | byte(i8 + 1) << 8 | byte(i8 + 2) << 16 | byte(i8 + 3) << 24 |
+				byte(i8 + 4) << 32 | byte(i8 + 5) << 40 | byte(i8 + 6) << 48 | byte(i8 + 7) << 56;
+			k *= M;
+			k ^= k >> R;
+			k *= M;
+			h ^= k;
+			h *= M;
+		}
+		size_t tail = length & ~(size_t)7;
+		switch (length % 8) {
+		case 7: h ^= byte(tail + 6) << 48;
+		case 6: h ^= byte(tail + 5) << 40;
+		case 5: h ^= byte(tail + 4) << 32;
+		case 4: h ^= byte(tail + 3) << 24;
+		case 3: h ^= byte(tail + 2) << 16;
+		case 2: h ^= byte(tail + 1) << 8;
+		case 1: h ^= byte(tail);
+			h *= M;
+		};
+		h ^= h >> R;
+		h *= M;
+		h ^= h >> R;
+		return h;
+	}
+
+	StringId GetStringId(const char* str, size_t length){
+		return HashString<false>(str, length);
+	}
+
+	StringId GetStringId(const char* str){
+		return HashString<false>(str, strlen(str));
+	}
+
+	StringId GetStringId(const std::string& str){
+		return HashString<false>(str.c_str(), str.size());
+	}
+
+	StringId GetStringIdNoCase(const char* str, size_t length){
+		return HashString<true>(str, length);
+	}
+
+	StringId GetStringIdNoCase(const char* str){
+		return HashString<true>(str, strlen(str));
+	}
+
+	StringId GetStringIdNoCase(const std::string& str){
+		return HashString<true>(str.c_str(), str.size());
+	}
+
+	//---------------------------------------------------------------------------
+	// Sharded so interning from loader threads rarely contends.
+	static const unsigned NumStringTableShards = 16;
+	struct StringTableShard{
+		SpinLockWaitSleep mLock;
+		std::unordered_map<StringId, std::string> mStrings;
+	};
+	static StringTableShard& GetStringTableShard(StringId id){
+		static StringTableShard shards[NumStringTableShards];
+		return shards[id % NumStringTableShards];
+	}
+
+	static StringId Intern(StringId id, const char* str){
+		auto& shard = GetStringTableShard(id);
+		EnterSpinLock<SpinLockWaitSleep> lock(shard.mLock);
+		auto it = shard.mStrings.find(id);
+		if (it == shard.mStrings.end()){
+			shard.mStrings[id] = str;
+		}
+		else if (_stricmp(it->second.c_str(), str) != 0){
+			// a different string with the same id is a hash collision.
+			std::cerr << "(error) StringId collision: " << it->second << ", " << str << std::endl;
+			assert(0 && "StringId collision.");
+		}
+		return id;
+	}
+
+	StringId InternString(const char* str){
+		return Intern(GetStringId(str), str);
+	}
+
+	StringId InternStringNoCase(const char* str){
+		return Intern(GetStringIdNoCase(str), str);
+	}
+
+	const char* GetInternedString(StringId id){
+		auto& shard = GetStringTableShard(id);
+		EnterSpinLock<SpinLockWaitSleep> lock(shard.mLock);
+		auto it = shard.mStrings.find(id);
+		// node based, so the pointer stays valid after the lock.
+		return it == shard.mStrings.end() ? "" : it->second.c_str();
+	}
+}
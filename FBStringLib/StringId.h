@@ -0,0 +1,111 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#pragma once
+#include "MurmurHash.h"
+#include <string>
+namespace fb{
+	/** Hashed name of a resource or a property.
+	The id is the hash64() of the string, so the same string gets the same
+	id in every module and string literals are hashed at compile time.
+	The *NoCase variants hash the ASCII-lowered string without allocating.
+	*/
+	typedef UINT64 StringId;
+	const StringId INVALID_STRING_ID = 0;
+
+	namespace StringIdDetail{
+		const UINT64 M = 0xc6a4a7935bd1e995ULL;
+		const int R = 47;
+		// hash64(data, length) seed.
+		const UINT64 Seed = 0xe17a1465;
+
+		constexpr int Length(const char* s, int i){
+			return s[i] ? Length(s, i + 1) : i;
+		}
+		constexpr char Lower(char c){
+			return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+		}
+		constexpr UINT64 Byte(const char* s, int i, bool noCase){
+			return (UINT64)(unsigned char)(noCase ? Lower(s[i]) : s[i]);
+		}
+		constexpr UINT64 Word(const char* s, int i, bool noCase){
+			return Byte(s, i, noCase) | Byte(s, i + 1, noCase) << 8 |
+				Byte(s, i + 2, noCase) << 16 | Byte(s, i + 3, noCase) << 24 |
+				Byte(s, i + 4, noCase) << 32 | Byte(s, i + 5, noCase) << 40 |
+				Byte(s, i + 6, noCase) << 48 | Byte(s, i + 7, noCase) << 56;
+		}
+		constexpr UINT64 Scramble(UINT64 k){
+			return ((k * M) ^ ((k * M) >> R)) * M;
+		}
+		constexpr UINT64 Blocks(const char* s, int i, int numBlocks, UINT64 h, bool noCase){
+			return i == numBlocks ? h :
+				Blocks(s, i + 1, numBlocks, (h ^ Scramble(Word(s, i * 8, noCase))) * M, noCase);
+		}
+		constexpr UINT64 TailBits(const char* s, int from, int remain, bool noCase){
+			return remain == 0 ? 0 :
+				(Byte(s, from + remain - 1, noCase) << (8 * (remain - 1))) ^ TailBits(s, from, remain - 1, noCase);
+		}
+		constexpr UINT64 Tail(const char* s, int length, UINT64 h, bool noCase){
+			return length % 8 == 0 ? h : (h ^ TailBits(s, length & ~7, length % 8, noCase)) * M;
+		}
+		constexpr UINT64 Finalize(UINT64 h){
+			return ((h ^ (h >> R)) * M) ^ (((h ^ (h >> R)) * M) >> R);
+		}
+		constexpr StringId Hash(const char* s, int length, bool noCase){
+			return Finalize(Tail(s, length, Blocks(s, 0, length / 8,
+				Seed ^ ((UINT64)length * M), noCase), noCase));
+		}
+	}
+
+	/// Compile time id of a string literal or an element of a constexpr
+	/// string table. Same as GetStringId().
+	constexpr StringId MakeStringId(const char* literal){
+		return StringIdDetail::Hash(literal, StringIdDetail::Length(literal, 0), false);
+	}
+	/// Compile time id of a string literal or an element of a constexpr
+	/// string table. Same as GetStringIdNoCase().
+	constexpr StringId MakeStringIdNoCase(const char* literal){
+		return StringIdDetail::Hash(literal, StringIdDetail::Length(literal, 0), true);
+	}
+
+	StringId GetStringId(const char* str, size_t length);
+	StringId GetStringId(const char* str);
+	StringId GetStringId(const std::string& str);
+	StringId GetStringIdNoCase(const char* str, size_t length);
+	StringId GetStringIdNoCase(const char* str);
+	StringId GetStringIdNoCase(const std::string& str);
+
+	/// Hashes and remembers the string so GetInternedString() can return
+	/// it. Use it where an id is stored as a key; a different string with
+	/// the same id is reported as a collision. Thread safe. The table is per
+	/// module since FBStringLib is linked statically; the ids are not.
+	StringId InternString(const char* str);
+	/// Remembers the string as given; the id is of the lowered string.
+	StringId InternStringNoCase(const char* str);
+	/// Returns an empty string for ids which are not interned in this module.
+	const char* GetInternedString(StringId id);
+}
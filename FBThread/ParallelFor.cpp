@@ -0,0 +1,104 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of fastbird engine
+For the latest info, see http://www.jungwan.net/
+
+Copyright (c) 2013-2015 Jungwan Byun
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "stdafx.h"
+#include "ParallelFor.h"
+#include "TaskScheduler.h"
+#include "Task.h"
+using namespace fb;
+
+namespace{
+	class RangeTask : public Task
+	{
+		const RangeFunc& mFunc;
+		unsigned mStart;
+		unsigned mEnd;
+
+	public:
+		RangeTask(const RangeFunc& func, unsigned start, unsigned end, ThreadSafeCounter* execCounter)
+			: Task(false, execCounter)
+			, mFunc(func)
+			, mStart(start)
+			, mEnd(end)
+		{
+			mExecCounter->operator++();
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE {
+			mFunc(mStart, mEnd);
+		}
+	};
+
+	class RangeRootTask : public Task
+	{
+		const RangeFunc& mFunc;
+		unsigned mNum;
+		unsigned mChunkSize;
+
+	public:
+		RangeRootTask(const RangeFunc& func, unsigned num, unsigned chunkSize)
+			: Task(true)
+			, mFunc(func)
+			, mNum(num)
+			, mChunkSize(chunkSize)
+		{
+		}
+
+		void Execute(TaskScheduler* Scheduler) OVERRIDE {
+			for (unsigned i = mChunkSize; i < mNum; i += mChunkSize) {
+				Scheduler->AddTask(std::make_shared<RangeTask>(mFunc, i,
+					std::min(mNum, i + mChunkSize), &mSyncCounter));
+			}
+			mFunc(0, std::min(mNum, mChunkSize));
+		}
+	};
+}
+
+namespace fb
+{
+	void RunParallel(unsigned num, unsigned chunkSize, const RangeFunc& func)
+	{
+		if (num == 0)
+			return;
+		if (chunkSize == 0)
+			chunkSize = 1;
+		if (num <= chunkSize || !TaskScheduler::HasInstance()) {
+			func(0, num);
+			return;
+		}
+		auto task = std::make_shared<RangeRootTask>(func, num, chunkSize);
+		TaskScheduler::GetInstance().AddTask(task);
+		task->Sync();
+	}
+
+	ParallelFor GetTaskParallelFor(unsigned chunkSize)
+	{
+		return [chunkSize](unsigned num, const RangeFunc& func) {
+			RunParallel(num, chunkSize, func);
+		};
+	}
+}
@@ -35,6 +35,7 @@
 #include <Windows.h>
 #include <objbase.h>
 #else
+#define FB_DLL_THREAD
 #endif
 
 #include <mutex>
@@ -33,7 +33,7 @@
 
 namespace fb
 {
-__declspec(thread) ThreadInfo* GThreadDesc = 0;
+thread_local ThreadInfo* GThreadDesc = 0;
 
 void SwitchThread()
 {
@@ -84,7 +84,7 @@ static ThreadHandlePtr CreateThreadHandle(Thread* ThreadInstance, int StackSize,
 }
 
 //---------------------------------------------------------------------------
-static DWORD __stdcall ThreadProc(LPVOID ThreadPtr)
+static DWORD ThreadProc(void* ThreadPtr)
 {
 	assert(ThreadPtr);
 	Thread* ThreadInstance = (Thread*)ThreadPtr;
@@ -117,13 +117,20 @@ public:
 	//---------------------------------------------------------------------------
 	Impl(Thread* Thread, int StackSize, char* ThreadName){
 		mThread = std::thread(ThreadProc, Thread);
+#if defined(_PLATFORM_WINDOWS_)
 		DWORD ThreadID = GetThreadId(mThread.native_handle());
 		SetThreadName(ThreadID, ThreadName);
+#elif defined(_PLATFORM_LINUX_)
+		// Linux limits thread names to 15 characters.
+		char name[16] = {};
+		strncpy(name, ThreadName, sizeof(name) - 1);
+		pthread_setname_np(mThread.native_handle(), name);
+#endif
 	}
 
 	HANDLE GetNativeHandle()
 	{
-		return mThread.native_handle();
+		return (HANDLE)mThread.native_handle();
 	}
 
 	bool IsValid()
@@ -138,7 +145,7 @@ public:
 	}
 
 	void SetPriority(int priority) {
-		FBSetThreadPriority(mThread.native_handle(), priority);
+		FBSetThreadPriority((HANDLE)mThread.native_handle(), priority);
 	}
 };
 
@@ -44,7 +44,7 @@ namespace fb
 		}
 	};
 
-	extern __declspec(thread) ThreadInfo* GThreadDesc;
+	extern thread_local ThreadInfo* GThreadDesc;
 	void SwitchThread();
 	void SetThreadName(DWORD ThreadID, const char* ThreadName);
 	
@@ -29,6 +29,9 @@
 #include "Align.h"
 #include "FBCommonHeaders/Helpers.h"
 #include "UIPropTypes.h"
+#include "FBStringLib/StringId.h"
+#include <unordered_map>
+#include <utility>
 namespace fb
 {
 	namespace UIProperty
@@ -205,7 +208,7 @@ namespace fb
 			COUNT
 		};
 
-		static const char* strings[] = {
+		static constexpr const char* strings[] = {
 			"POS",
 			"POSX",
 			"POSY",
@@ -387,33 +390,35 @@ namespace fb
 			return ConvertToString(Enum(e));
 		}
 
-		inline Enum ConvertToEnum(const char* sz)
+		/// Case insensitive ids of \a strings hashed at compile time.
+		template<size_t... I>
+		inline const StringId* GetStringIds(std::index_sequence<I...>)
 		{
-			int i = 0;
-			for (auto& strEnum : strings)
-			{
-				if (_stricmp(strEnum, sz) == 0)
-					return Enum(i);
-
-				++i;
-			}
-			
-			assert(0);
-			return COUNT;
+			static constexpr StringId ids[] = { MakeStringIdNoCase(strings[I])... };
+			return ids;
 		}
 
+		/// Returns COUNT when \a sz is not a property. Case insensitive.
 		inline Enum IsUIProperty(const char* sz)
 		{
-			int i = 0;
-			for (auto& strEnum : strings)
-			{
-				if (_stricmp(strEnum, sz) == 0)
-					return Enum(i);
-
-				++i;
-			}
+			static const std::unordered_map<StringId, Enum> ids = [](){
+				auto stringIds = GetStringIds(std::make_index_sequence<COUNT + 1>());
+				std::unordered_map<StringId, Enum> ids;
+				for (int i = 0; i <= COUNT; ++i){
+					bool inserted = ids.insert(std::make_pair(stringIds[i], Enum(i))).second;
+					assert(inserted && "Property names collide.");
+				}
+				return ids;
+			}();
+			auto it = ids.find(GetStringIdNoCase(sz));
+			return it == ids.end() ? COUNT : it->second;
+		}
 
-			return COUNT;
+		inline Enum ConvertToEnum(const char* sz)
+		{
+			auto e = IsUIProperty(sz);
+			assert(e != COUNT);
+			return e;
 		}
 
 